@@ -0,0 +1,486 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ *******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *******************************************************************************
+ * File Name    : cmd_ethernet.c
+ * Version      : 1.0
+ * Device(s)    : Renesas
+ * Tool-Chain   : N/A
+ * OS           : FreeRTOS
+ * H/W Platform : RZ/A1LU
+ * Description  : The Ethernet specific commands
+ *******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 30.06.2018 1.00 First Release
+ ******************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ ******************************************************************************/
+
+/******************************************************************************
+ System Includes
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+
+#include "application_cfg.h"
+
+#if (R_SELF_LOAD_MIDDLEWARE_ETHERNET_MODULES)
+
+#include "r_typedefs.h"
+#include "command.h"
+#include "console.h"
+#include "r_os_abstraction_api.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "socket.h"
+#include "lwIP_Interface.h"
+#include "dev_drv.h"
+#include <renesas/application/soundbar_app/inc/r_soundbar.h>
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+
+/* The iperf (version 2) default port */
+#define IPERF_PORT                  (5001)
+
+/* Bytes passed to each send / recv */
+#define IPERF_BUFFER_BYTES          (8192)
+
+/* Client run time when none is given */
+#define IPERF_DEFAULT_SECONDS       (10)
+
+/* Milliseconds since the scheduler started */
+#define CMD_ETHER_TIME_MS()         ((uint32_t) (xTaskGetTickCount() * portTICK_PERIOD_MS))
+
+/******************************************************************************
+ Private Functions
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: iperf_report
+ Description:   Prints the transfer size, time and rate
+ Arguments:     IN  pCom - Pointer to the command object
+                IN  pszDirection - "received" or "sent"
+                IN  bytes - bytes transferred
+                IN  ms - transfer time
+ Return value:  none
+ ******************************************************************************/
+static void iperf_report (pst_comset_t pCom, const char_t *pszDirection, uint64_t bytes, uint32_t ms)
+{
+    if (0 == ms)
+    {
+        ms = 1;
+    }
+
+    /* bits per millisecond is kbit/s */
+    fprintf(pCom->p_out, "%lu KBytes %s in %lu ms, %lu kbit/s\r\n",
+            (unsigned long) (bytes / 1024u), pszDirection, (unsigned long) ms,
+            (unsigned long) ((bytes * 8u) / ms));
+}
+/******************************************************************************
+ End of function iperf_report
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: iperf_server
+ Description:   Accepts one connection and counts the bytes until the peer
+                closes it, the same as an "iperf -s" server
+ Arguments:     IN  pCom - Pointer to the command object
+                IN  pbyBuffer - receive buffer, IPERF_BUFFER_BYTES long
+ Return value:  none
+ ******************************************************************************/
+static void iperf_server (pst_comset_t pCom, uint8_t *pbyBuffer)
+{
+    struct sockaddr_in  address;
+    socklen_t           length = sizeof(address);
+    uint64_t            bytes = 0;
+    uint32_t            start;
+    int                 iListen;
+    int                 iSocket;
+    int                 iResult;
+
+    iListen = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (iListen < 0)
+    {
+        fprintf(pCom->p_out, "Failed to create socket\r\n");
+        return;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(IPERF_PORT);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if ((bind(iListen, (struct sockaddr *) &address, sizeof(address)) < 0) || (listen(iListen, 1) < 0))
+    {
+        fprintf(pCom->p_out, "Failed to listen on port %d\r\n", IPERF_PORT);
+        close(iListen);
+        return;
+    }
+
+    fprintf(pCom->p_out, "Waiting for \"iperf -c <this address>\" on port %d\r\n", IPERF_PORT);
+    fflush(pCom->p_out);
+
+    iSocket = accept(iListen, (struct sockaddr *) &address, &length);
+    close(iListen);
+
+    if (iSocket < 0)
+    {
+        fprintf(pCom->p_out, "Accept failed\r\n");
+        return;
+    }
+
+    start = CMD_ETHER_TIME_MS();
+
+    do
+    {
+        iResult = recv(iSocket, pbyBuffer, IPERF_BUFFER_BYTES, 0);
+
+        if (iResult > 0)
+        {
+            bytes += (uint64_t) iResult;
+        }
+    } while (iResult > 0);
+
+    iperf_report(pCom, "received", bytes, CMD_ETHER_TIME_MS() - start);
+    close(iSocket);
+}
+/******************************************************************************
+ End of function iperf_server
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: iperf_client
+ Description:   Connects to an "iperf -s" server and sends for a fixed time
+ Arguments:     IN  pCom - Pointer to the command object
+                IN  pszAddress - dotted decimal server address
+                IN  seconds - time to send for
+                IN  pbyBuffer - transmit buffer, IPERF_BUFFER_BYTES long
+ Return value:  none
+ ******************************************************************************/
+static void iperf_client (pst_comset_t pCom, const char_t *pszAddress, uint32_t seconds, uint8_t *pbyBuffer)
+{
+    struct sockaddr_in  address;
+    uint64_t            bytes = 0;
+    uint32_t            start;
+    uint32_t            elapsed;
+    int                 iSocket;
+    int                 iResult;
+    uint32_t            i;
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(IPERF_PORT);
+    address.sin_addr.s_addr = inet_addr(pszAddress);
+
+    if (INADDR_NONE == address.sin_addr.s_addr)
+    {
+        fprintf(pCom->p_out, "Invalid address %s\r\n", pszAddress);
+        return;
+    }
+
+    iSocket = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (iSocket < 0)
+    {
+        fprintf(pCom->p_out, "Failed to create socket\r\n");
+        return;
+    }
+
+    if (connect(iSocket, (struct sockaddr *) &address, sizeof(address)) < 0)
+    {
+        fprintf(pCom->p_out, "Could not connect to %s:%d\r\n", pszAddress, IPERF_PORT);
+        close(iSocket);
+        return;
+    }
+
+    /* The iperf pattern, a zeroed first word also tells the server that
+       there are no extra test options */
+    for (i = 0; i < IPERF_BUFFER_BYTES; i++)
+    {
+        pbyBuffer[i] = (uint8_t) ('0' + (i % 10u));
+    }
+    memset(pbyBuffer, 0, 24);
+
+    start = CMD_ETHER_TIME_MS();
+
+    do
+    {
+        iResult = send(iSocket, pbyBuffer, IPERF_BUFFER_BYTES, 0);
+
+        if (iResult > 0)
+        {
+            bytes += (uint64_t) iResult;
+        }
+
+        elapsed = CMD_ETHER_TIME_MS() - start;
+    } while ((iResult > 0) && (elapsed < (seconds * 1000u)));
+
+    close(iSocket);
+    iperf_report(pCom, "sent", bytes, elapsed);
+}
+/******************************************************************************
+ End of function iperf_client
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_iperf
+ Description:   Command to measure TCP throughput through the Ethernet driver
+                against a PC running iperf version 2
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_iperf (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    uint8_t *pbyBuffer;
+
+    if ((iArgCount < 2) || ((0 != strcmp(ppszArgument[1], "-s")) && (0 != strcmp(ppszArgument[1], "-c")))
+            || ((0 == strcmp(ppszArgument[1], "-c")) && (iArgCount < 3)))
+    {
+        fprintf(pCom->p_out, "Usage: iperf -s | iperf -c <address> [seconds]\r\n");
+        return CMD_OK;
+    }
+
+    pbyBuffer = R_OS_AllocMem(IPERF_BUFFER_BYTES, R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL == pbyBuffer)
+    {
+        fprintf(pCom->p_out, "Failed to allocate memory\r\n");
+        return CMD_OK;
+    }
+
+    if (0 == strcmp(ppszArgument[1], "-s"))
+    {
+        iperf_server(pCom, pbyBuffer);
+    }
+    else
+    {
+        uint32_t seconds = IPERF_DEFAULT_SECONDS;
+
+        if (iArgCount > 3)
+        {
+            seconds = (uint32_t) strtoul(ppszArgument[3], NULL, 10);
+
+            if (0 == seconds)
+            {
+                seconds = IPERF_DEFAULT_SECONDS;
+            }
+        }
+
+        iperf_client(pCom, ppszArgument[2], seconds, pbyBuffer);
+    }
+
+    R_OS_FreeMem(pbyBuffer);
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_iperf
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_etherstat
+ Description:   Command to show the receive batching statistics, used to
+                size the receive descriptor ring
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_etherstat (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    IPRXSTATS   stats;
+    uint32_t    i;
+
+    if (ipGetRxStats(NULL, &stats) != 0)
+    {
+        fprintf(pCom->p_out, "The network is not started\r\n");
+        return CMD_OK;
+    }
+
+    fprintf(pCom->p_out, "Interrupts %lu, batches %lu, frames %lu, largest batch %lu\r\n",
+            (unsigned long) stats.uiWakeups, (unsigned long) stats.uiBatches,
+            (unsigned long) stats.uiFrames, (unsigned long) stats.uiMaxBatch);
+
+    fprintf(pCom->p_out, "Batch size:");
+    for (i = 1; i < IP_RX_BATCH_SIZES; i++)
+    {
+        fprintf(pCom->p_out, " %lu%s:%lu", (unsigned long) i,
+                ((IP_RX_BATCH_SIZES - 1U) == i) ? "+" : "", (unsigned long) stats.pBatchSize[i]);
+    }
+    fprintf(pCom->p_out, "\r\n");
+
+    /* Occupancy in hundredths, there is no floating point printf */
+    fprintf(pCom->p_out, "Ring occupancy mean %lu.%02lu, max %lu\r\n",
+            (unsigned long) ((0 != stats.uiWakeups) ? (stats.uiRingOccupancySum / stats.uiWakeups) : 0),
+            (unsigned long) ((0 != stats.uiWakeups) ? (((stats.uiRingOccupancySum * 100u) / stats.uiWakeups) % 100u) : 0),
+            (unsigned long) stats.uiMaxRingOccupancy);
+
+    fprintf(pCom->p_out, "Copied %lu, back pressure %lu, errors %lu, missed %lu, dropped %lu\r\n",
+            (unsigned long) stats.uiCopied, (unsigned long) stats.uiBackPressure,
+            (unsigned long) stats.uiErrors, (unsigned long) stats.uiMissed,
+            (unsigned long) stats.uiDropped);
+
+    if ((iArgCount > 1) && (0 == strcmp(ppszArgument[1], "reset")))
+    {
+        ipResetRxStats(NULL);
+        fprintf(pCom->p_out, "Statistics cleared\r\n");
+    }
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_etherstat
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_rtp
+ Description:   Command to start and stop the RTP network audio receiver and
+                show its jitter buffer, latency and underrun statistics
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_rtp (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    st_audio_rtp_stats_t stats;
+    uint16_t port = 0;
+
+    if ((iArgCount > 1) && (0 == strcmp(ppszArgument[1], "start")))
+    {
+        if (iArgCount > 2)
+        {
+            port = (uint16_t) strtoul(ppszArgument[2], NULL, 10);
+        }
+
+        if (DEVDRV_SUCCESS == r_soundtst_StartNetwork(port))
+        {
+            fprintf(pCom->p_out, "Receiving RTP L16 44.1kHz stereo on port %u\r\n",
+                    (unsigned) ((0 != port) ? port : AUDIO_RTP_DEFAULT_PORT));
+        }
+        else
+        {
+            fprintf(pCom->p_out, "Failed to start, playback must be idle and the network up\r\n");
+        }
+    }
+    else if ((iArgCount > 1) && (0 == strcmp(ppszArgument[1], "stop")))
+    {
+        r_soundtst_StopNetwork();
+        fprintf(pCom->p_out, "Stopped\r\n");
+    }
+    else if ((iArgCount > 1) && (0 == strcmp(ppszArgument[1], "stats")))
+    {
+        if (DEVDRV_SUCCESS != r_soundtst_GetNetworkStats(&stats))
+        {
+            fprintf(pCom->p_out, "The receiver is not running\r\n");
+            return CMD_OK;
+        }
+
+        fprintf(pCom->p_out, "Datagrams %lu, invalid %lu, wrong type %lu\r\n",
+                (unsigned long) stats.datagrams, (unsigned long) stats.invalid,
+                (unsigned long) stats.wrong_type);
+
+        fprintf(pCom->p_out, "Packets %lu, late %lu, duplicate %lu, overflow %lu, lost %lu, resync %lu\r\n",
+                (unsigned long) stats.jitter.packets, (unsigned long) stats.jitter.late,
+                (unsigned long) stats.jitter.duplicates, (unsigned long) stats.jitter.overflows,
+                (unsigned long) stats.jitter.lost, (unsigned long) stats.jitter.resyncs);
+
+        fprintf(pCom->p_out, "Underruns %lu, jitter %luus, depth %luus, target %luus, trim %ldppm\r\n",
+                (unsigned long) stats.jitter.underruns, (unsigned long) stats.jitter.jitter_us,
+                (unsigned long) stats.jitter.depth_us, (unsigned long) stats.jitter.target_us,
+                (long) stats.jitter.trim_ppm);
+
+        fprintf(pCom->p_out, "Latency arrival to DAC min %luus, mean %luus, max %luus\r\n",
+                (unsigned long) stats.jitter.min_latency_us,
+                (unsigned long) ((0 != stats.jitter.latency_samples)
+                        ? (stats.jitter.total_latency_us / stats.jitter.latency_samples) : 0),
+                (unsigned long) stats.jitter.max_latency_us);
+
+        if ((iArgCount > 2) && (0 == strcmp(ppszArgument[2], "reset")))
+        {
+            r_soundtst_ResetNetworkStats();
+            fprintf(pCom->p_out, "Statistics cleared\r\n");
+        }
+    }
+    else
+    {
+        fprintf(pCom->p_out, "Usage: rtp start [port] | rtp stop | rtp stats [reset]\r\n");
+    }
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_rtp
+ ******************************************************************************/
+
+/* Table that associates command letters, function pointer and a little
+ description of what the command does */
+static const st_cmdfnass_t gs_cmd_ethernet[] =
+{
+    {
+        "iperf",
+        (const CMDFUNC) cmd_iperf,
+        "-s | -c <address> [seconds] <CR> - TCP throughput test against a PC running iperf version 2"
+    },
+    {
+        "etherstat",
+        (const CMDFUNC) cmd_etherstat,
+        "[reset] <CR> - Show the Ethernet receive batch statistics, reset clears them after showing"
+    },
+    {
+        "rtp",
+        (const CMDFUNC) cmd_rtp,
+        "start [port] | stop | stats [reset] <CR> - RTP L16 network audio receiver into the playback engine"
+    },
+};
+
+/* Table that points to the above table and contains the number of entries */
+const st_command_table_t g_cmd_tbl_ethernet =
+{
+    "Ethernet Commands",
+    (pst_cmdfnass_t) gs_cmd_ethernet,
+    (sizeof(gs_cmd_ethernet) / sizeof(st_cmdfnass_t)),
+};
+
+#endif /* R_SELF_LOAD_MIDDLEWARE_ETHERNET_MODULES */
+
+/******************************************************************************
+End  Of File
+******************************************************************************/
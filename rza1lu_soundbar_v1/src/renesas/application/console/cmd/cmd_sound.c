@@ -0,0 +1,1646 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ *******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *******************************************************************************
+ * File Name    : cmd_sound.c
+ * Version      : 1.0
+ * Device(s)    : Renesas
+ * Tool-Chain   : N/A
+ * OS           : FreeRTOS
+ * H/W Platform : RZ/A1LU
+ * Description  : The sound application specific commands
+ *******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 30.06.2018 1.00 First Release
+ ******************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ ******************************************************************************/
+
+/******************************************************************************
+ System Includes
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+
+#include "r_typedefs.h"
+#include "command.h"
+#include "console.h"
+#include "r_os_abstraction_api.h"
+#include "r_task_priority.h"
+#include "dev_drv.h"
+#include "iodefine_cfg.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <renesas/application/soundbar_app/inc/r_soundbar.h>
+#include "r_audio_convert.h"
+#include "r_audio_decoder.h"
+#include "r_audio_resample.h"
+#include "r_audio_dsp.h"
+#include "r_media_library.h"
+#include "r_fatfs_abstraction.h"
+#include "ff.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+/* Free running OSTM1 counter, counts at the P0 clock */
+#define CMD_SOUND_TIME_STAMP()              (OSTM1.OSTMnCNT)
+#define CMD_SOUND_COUNTS_PER_US             (configPERIPHERAL_CLOCK0_HZ / 1000000UL)
+
+/* Conversion benchmark, one SSIF period converted CONV_BENCH_LOOPS times */
+#define CONV_BENCH_PERIOD_BYTES             (4096u)
+#define CONV_BENCH_LOOPS                    (64u)
+#define CONV_BENCH_ALIGN_BYTES              (32u)
+
+/* Decoder benchmark, decodes a whole file one SSIF period at a time */
+#define DEC_BENCH_PERIOD_FRAMES             (CONV_BENCH_PERIOD_BYTES / AUDIO_CONVERT_DST_FRAME_BYTES)
+
+/* Resampler benchmark, a -1 dBFS 1 kHz tone converted to the codec rate */
+#define SRC_BENCH_PERIOD_FRAMES             (DEC_BENCH_PERIOD_FRAMES)
+#define SRC_BENCH_PERIODS                   (200u)
+#define SRC_BENCH_SETTLE_PERIODS            (8u)
+#define SRC_BENCH_TONE_HZ                   (1000.0)
+#define SRC_BENCH_TONE_AMPLITUDE            (0.891250938 * 2147483647.0)
+#define SRC_BENCH_DEFAULT_RATE              (48000u)
+#define SRC_BENCH_PI                        (3.14159265358979323846)
+
+/* Playback test, a -6 dBFS 24 bit stereo tone at each rate written once and played as a playlist */
+#define PLAY_TEST_TONE_HZ                   (997.0)
+#define PLAY_TEST_TONE_AMPLITUDE            (0.501187234 * 8388607.0)
+#define PLAY_TEST_DEFAULT_SECONDS           (20u)
+#define PLAY_TEST_FRAME_BYTES               (6u)
+#define PLAY_TEST_BLOCK_FRAMES              (512u)
+#define PLAY_TEST_RATES                     (3u)
+
+/* DSP benchmark, a -6 dBFS noise period through each stage of the chain */
+#define DSP_BENCH_PERIOD_FRAMES             (DEC_BENCH_PERIOD_FRAMES)
+#define DSP_BENCH_LOOPS                     (CONV_BENCH_LOOPS)
+
+/******************************************************************************
+ Private global variables and functions
+ ******************************************************************************/
+static void conv_reference (uint8_t *p_dst, const uint8_t *p_src, uint16_t bits, uint16_t channels,
+        uint32_t frames);
+static double src_bench_thdn (const double *p_sums, double sum_yy);
+static void dsp_print_tenths (FILE *p_out, float value);
+static void dsp_show_config (FILE *p_out, const st_audio_dsp_config_t *p_config);
+static void media_lib_show_track (FILE *p_out, uint32_t index, const st_media_track_t *p_track);
+static bool_t play_test_write_tone (char_t *p_path, uint32_t rate, uint32_t seconds);
+static void play_stat_show (FILE *p_out);
+
+static const uint32_t gs_play_test_rates[PLAY_TEST_RATES] =
+{
+    44100u, 48000u, 96000u
+};
+
+/******************************************************************************
+ Private Functions
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_audio_stat
+ Description:   Command to show the wake-up latency of the audio task for
+                each SSIF DMA period and the CPU load per task
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_audio_stat (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    st_sound_period_stats_t stats;
+    char_t *p_buffer;
+
+    if ((iArgCount >= 2) && (0 == strcmp(ppszArgument[1], "reset")))
+    {
+        r_soundtst_ResetPeriodStats();
+        fprintf(pCom->p_out, "Audio period statistics cleared\r\n");
+        return CMD_OK;
+    }
+
+    r_soundtst_GetPeriodStats( &stats);
+
+    fprintf(pCom->p_out, "Audio task wake-ups %lu, periods %lu, late %lu\r\n",
+            (unsigned long) stats.wakeups, (unsigned long) stats.periods, (unsigned long) stats.late_wakeups);
+
+    if (0u != stats.wakeups)
+    {
+        fprintf(pCom->p_out, "DMA end to task latency min %luus avg %luus max %luus\r\n",
+                (unsigned long) stats.min_latency_us,
+                (unsigned long) (stats.total_latency_us / stats.wakeups),
+                (unsigned long) stats.max_latency_us);
+    }
+
+    /* vTaskGetRunTimeStats needs about 40 bytes per task */
+    p_buffer = R_OS_AllocMem(1024, R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL != p_buffer)
+    {
+        vTaskGetRunTimeStats(p_buffer);
+        fprintf(pCom->p_out, "Task\t\tTime\t\t%%\r\n%s\r\n", p_buffer);
+        R_OS_FreeMem(p_buffer);
+    }
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_audio_stat
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_stream_stat
+ Description:   Command to show the fill level and underrun counters of the
+                wave file prefetch
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_stream_stat (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    st_audio_stream_stats_t stats;
+
+    AVOID_UNUSED_WARNING;
+
+    r_soundtst_GetStreamStats( &stats);
+
+    fprintf(pCom->p_out, "Prefetch fill %lu of %lu bytes\r\n",
+            (unsigned long) stats.fill_bytes, (unsigned long) stats.capacity_bytes);
+    fprintf(pCom->p_out, "Underruns %lu, chunks read %lu, read errors %lu, longest read %luus\r\n",
+            (unsigned long) stats.underruns, (unsigned long) stats.chunks_read,
+            (unsigned long) stats.read_errors, (unsigned long) stats.max_read_us);
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_stream_stat
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: conv_reference
+ Description:   Byte at a time conversion the kernels are checked against.
+                Packed 24 bit stereo uses the padding state machine the wave
+                player used before r_audio_convert.
+ Arguments:     OUT p_dst - destination, frames * 8 bytes
+                IN  p_src - source
+                IN  bits - bits per sample
+                IN  channels - channel count
+                IN  frames - frame count
+ Return value:  none
+ ******************************************************************************/
+static void conv_reference (uint8_t *p_dst, const uint8_t *p_src, uint16_t bits, uint16_t channels,
+        uint32_t frames)
+{
+    uint32_t bytes = bits / 8u;
+    uint32_t dst_len = frames * AUDIO_CONVERT_DST_FRAME_BYTES;
+    uint32_t write_index = 0;
+    uint32_t read_index = 0;
+    uint32_t pading_index = 0;
+    uint32_t slot;
+    uint32_t byte;
+
+    if ((24u == bits) && (2u == channels))
+    {
+        while (write_index < dst_len)
+        {
+            if (pading_index == 0)
+            {
+                p_dst[write_index] = 0;
+            }
+            else
+            {
+                p_dst[write_index] = p_src[read_index];
+                read_index++;
+            }
+            if (pading_index < 3)
+            {
+                pading_index++;
+            }
+            else
+            {
+                pading_index = 0;
+            }
+            write_index++;
+        }
+        return;
+    }
+
+    while (write_index < dst_len)
+    {
+        /* mono repeats the same source sample in both slots */
+        if ((1u == channels) && (0u != ((write_index / 4u) & 1u)))
+        {
+            read_index -= bytes;
+        }
+
+        for (slot = 0; slot < 4u; slot++)
+        {
+            byte = slot + bytes;
+            p_dst[write_index + slot] = (byte >= 4u) ? p_src[(read_index + byte) - 4u] : 0u;
+        }
+
+        read_index += bytes;
+        write_index += 4u;
+    }
+}
+/******************************************************************************
+ End of function conv_reference
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_conv_bench
+ Description:   Command to time the sample format conversion kernels against
+                the byte at a time reference and check they are bit exact
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_conv_bench (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    static const uint16_t formats[][2] =
+    {
+        {16, 2}, {16, 1}, {24, 2}, {24, 1}, {32, 1}
+    };
+    uint32_t frames = CONV_BENCH_PERIOD_BYTES / AUDIO_CONVERT_DST_FRAME_BYTES;
+    uint8_t *p_block;
+    uint8_t *p_src;
+    uint8_t *p_ref;
+    uint32_t *p_dst;
+    uint32_t format;
+    uint32_t loop;
+    uint32_t start;
+    uint32_t ref_counts;
+    uint32_t new_counts;
+    uint32_t seed = 0x12345678u;
+
+    AVOID_UNUSED_WARNING;
+
+    /* source, reference and kernel output, each one period long */
+    p_block = R_OS_AllocMem((CONV_BENCH_PERIOD_BYTES * 3u) + CONV_BENCH_ALIGN_BYTES, R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL == p_block)
+    {
+        fprintf(pCom->p_out, "Failed to allocate memory\r\n");
+        return CMD_OK;
+    }
+
+    p_src = (uint8_t *) ((((uint32_t) p_block) & (uint32_t) ( ~(CONV_BENCH_ALIGN_BYTES - 1u))) + CONV_BENCH_ALIGN_BYTES);
+    p_ref = p_src + CONV_BENCH_PERIOD_BYTES;
+    p_dst = (uint32_t *) (p_ref + CONV_BENCH_PERIOD_BYTES);
+
+    for (loop = 0; loop < CONV_BENCH_PERIOD_BYTES; loop++)
+    {
+        seed = (seed * 1103515245u) + 12345u;
+        p_src[loop] = (uint8_t) (seed >> 16);
+    }
+
+    fprintf(pCom->p_out, "Format      reference   kernel  (us per %u byte period)\r\n", CONV_BENCH_PERIOD_BYTES);
+
+    for (format = 0; format < (sizeof(formats) / sizeof(formats[0])); format++)
+    {
+        start = CMD_SOUND_TIME_STAMP();
+        for (loop = 0; loop < CONV_BENCH_LOOPS; loop++)
+        {
+            conv_reference(p_ref, p_src, formats[format][0], formats[format][1], frames);
+        }
+        ref_counts = CMD_SOUND_TIME_STAMP() - start;
+
+        start = CMD_SOUND_TIME_STAMP();
+        for (loop = 0; loop < CONV_BENCH_LOOPS; loop++)
+        {
+            r_audio_convert_to_s32_stereo(p_dst, p_src, formats[format][0], formats[format][1], frames);
+        }
+        new_counts = CMD_SOUND_TIME_STAMP() - start;
+
+        fprintf(pCom->p_out, "s%u %-6s %9lu %8lu  %s\r\n", formats[format][0],
+                (2u == formats[format][1]) ? "stereo" : "mono",
+                (unsigned long) (ref_counts / (CONV_BENCH_LOOPS * CMD_SOUND_COUNTS_PER_US)),
+                (unsigned long) (new_counts / (CONV_BENCH_LOOPS * CMD_SOUND_COUNTS_PER_US)),
+                (0 == memcmp(p_ref, p_dst, CONV_BENCH_PERIOD_BYTES)) ? "bit exact" : "MISMATCH");
+    }
+
+    R_OS_FreeMem(p_block);
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_conv_bench
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: dec_bench_read
+ Description:   Decoder source read directly from FatFs, no prefetch
+ Arguments:     IN  p_context - The file
+                OUT p_buf - Destination
+                IN  len - Bytes wanted
+ Return value:  Bytes read
+ ******************************************************************************/
+static size_t dec_bench_read (void *p_context, void *p_buf, size_t len)
+{
+    int bytes = R_FAT_ReadFile((FIL *) p_context, p_buf, (unsigned int) len);
+
+    return ((bytes > 0) ? (size_t) bytes : 0u);
+}
+/******************************************************************************
+ End of function dec_bench_read
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: dec_bench_seek
+ Description:   Decoder source seek directly on FatFs
+ Arguments:     IN  p_context - The file
+                IN  offset - Byte offset
+ Return value:  true for success
+ ******************************************************************************/
+static bool_t dec_bench_seek (void *p_context, uint32_t offset)
+{
+    return (FR_OK == f_lseek((FIL *) p_context, offset));
+}
+/******************************************************************************
+ End of function dec_bench_seek
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_dec_bench
+ Description:   Command to decode a whole file and report the decode rate and
+                the peak memory held by the decoder. Time spent in FatFs is
+                included, so run it on the drive the player reads from.
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_dec_bench (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    st_audio_decoder_t decoder;
+    st_audio_source_t source;
+    FIL *p_file;
+    uint8_t *p_block;
+    uint32_t *p_period;
+    uint32_t frames;
+    uint32_t total_frames = 0u;
+    uint32_t start;
+    uint64_t counts = 0u;
+    uint32_t decode_ms;
+    uint32_t audio_ms;
+    uint32_t realtime;
+
+    if (iArgCount < 2)
+    {
+        fprintf(pCom->p_out, "Usage: decbench <file>\r\n");
+        return CMD_OK;
+    }
+
+    p_file = R_FAT_OpenFile(ppszArgument[1], FA_READ);
+
+    if (NULL == p_file)
+    {
+        fprintf(pCom->p_out, "Could not open %s\r\n", ppszArgument[1]);
+        return CMD_OK;
+    }
+
+    p_block = R_OS_AllocMem(CONV_BENCH_PERIOD_BYTES + CONV_BENCH_ALIGN_BYTES, R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL == p_block)
+    {
+        fprintf(pCom->p_out, "Failed to allocate memory\r\n");
+        R_FAT_CloseFile(p_file);
+        return CMD_OK;
+    }
+
+    p_period = (uint32_t *) ((((uint32_t) p_block) & (uint32_t) ( ~(CONV_BENCH_ALIGN_BYTES - 1u)))
+            + CONV_BENCH_ALIGN_BYTES);
+
+    source.read = &dec_bench_read;
+    source.seek = &dec_bench_seek;
+    source.size = (uint32_t) f_size(p_file);
+    source.p_context = p_file;
+
+    start = CMD_SOUND_TIME_STAMP();
+
+    if (DEVDRV_SUCCESS != r_audio_decoder_open( &decoder, &source))
+    {
+        fprintf(pCom->p_out, "Not a supported WAV, AIFF or FLAC file\r\n");
+    }
+    else
+    {
+        counts = CMD_SOUND_TIME_STAMP() - start;
+
+        /* time each period separately so the 32 bit counter cannot wrap within a measurement */
+        do
+        {
+            start = CMD_SOUND_TIME_STAMP();
+            frames = r_audio_decoder_decode( &decoder, p_period, DEC_BENCH_PERIOD_FRAMES);
+            counts += CMD_SOUND_TIME_STAMP() - start;
+            total_frames += frames;
+        } while (DEC_BENCH_PERIOD_FRAMES == frames);
+
+        decode_ms = (uint32_t) (counts / (CMD_SOUND_COUNTS_PER_US * 1000u));
+        audio_ms = (uint32_t) (((uint64_t) total_frames * 1000u) / decoder.format.sample_rate);
+
+        fprintf(pCom->p_out, "%s %lu Hz %u bit %u ch\r\n", decoder.p_ops->p_name,
+                (unsigned long) decoder.format.sample_rate, decoder.format.bits_per_sample,
+                decoder.format.channels);
+        fprintf(pCom->p_out, "Decoded %lu frames (%lu ms of audio) in %lu ms\r\n", (unsigned long) total_frames,
+                (unsigned long) audio_ms, (unsigned long) decode_ms);
+
+        if (0u != counts)
+        {
+            /* real time factor in hundredths */
+            realtime = (audio_ms * 100u) / ((0u != decode_ms) ? decode_ms : 1u);
+
+            fprintf(pCom->p_out, "%lu samples/s, %lu.%02lu x real time\r\n",
+                    (unsigned long) (((uint64_t) total_frames * decoder.format.channels
+                            * (CMD_SOUND_COUNTS_PER_US * 1000000u)) / counts),
+                    (unsigned long) (realtime / 100u), (unsigned long) (realtime % 100u));
+        }
+
+        fprintf(pCom->p_out, "Peak decoder RAM %lu bytes\r\n", (unsigned long) decoder.peak_ram_bytes);
+
+        r_audio_decoder_close( &decoder);
+    }
+
+    R_OS_FreeMem(p_block);
+    R_FAT_CloseFile(p_file);
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_dec_bench
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_src_mode
+ Description:   Command to show or select the sample rate converter quality
+                used for files that are not at the codec rate
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_src_mode (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    e_audio_resample_quality_t quality;
+
+    if (iArgCount >= 2)
+    {
+        for (quality = AUDIO_RESAMPLE_QUALITY_LOW; quality < AUDIO_RESAMPLE_QUALITY_COUNT; quality++)
+        {
+            if (0 == strcmp(ppszArgument[1], r_audio_resample_quality_name(quality)))
+            {
+                break;
+            }
+        }
+
+        if (AUDIO_RESAMPLE_QUALITY_COUNT == quality)
+        {
+            fprintf(pCom->p_out, "Usage: srcmode [low|medium|high]\r\n");
+            return CMD_OK;
+        }
+
+        r_soundtst_SetResampleQuality(quality);
+    }
+
+    fprintf(pCom->p_out, "Resampler quality %s, output %lu Hz, applies from the next track\r\n",
+            r_audio_resample_quality_name(r_soundtst_GetResampleQuality()),
+            (unsigned long) r_soundtst_GetOutputRate());
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_src_mode
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: src_bench_thdn
+ Description:   Fits y = a.sin + b.cos + c by least squares from the
+                accumulated sums and returns the residual relative to the fit
+ Arguments:     IN  p_sums - ss, sc, s, cc, c, n, ys, yc, y
+                IN  sum_yy - sum of the squared samples
+ Return value:  THD+N in dB
+ ******************************************************************************/
+static double src_bench_thdn (const double *p_sums, double sum_yy)
+{
+    double m[3][4] =
+    {
+        { p_sums[0], p_sums[1], p_sums[2], p_sums[6] },
+        { p_sums[1], p_sums[3], p_sums[4], p_sums[7] },
+        { p_sums[2], p_sums[4], p_sums[5], p_sums[8] },
+    };
+    double tone;
+    double residual;
+    double factor;
+    int_t row;
+    int_t col;
+    int_t k;
+
+    /* the normal equations are symmetric and well conditioned over whole cycles, no pivoting needed */
+    for (k = 0; k < 3; k++)
+    {
+        for (row = k + 1; row < 3; row++)
+        {
+            factor = m[row][k] / m[k][k];
+
+            for (col = k; col < 4; col++)
+            {
+                m[row][col] -= factor * m[k][col];
+            }
+        }
+    }
+
+    for (k = 2; k >= 0; k--)
+    {
+        for (col = k + 1; col < 3; col++)
+        {
+            m[k][3] -= m[k][col] * m[col][3];
+        }
+
+        m[k][3] /= m[k][k];
+    }
+
+    /* what the fit does not explain is distortion and noise */
+    residual = sum_yy - ((m[0][3] * p_sums[6]) + (m[1][3] * p_sums[7]) + (m[2][3] * p_sums[8]));
+    tone = ((m[0][3] * m[0][3]) + (m[1][3] * m[1][3])) * 0.5 * p_sums[5];
+
+    if ((residual <= 0.0) || (tone <= 0.0))
+    {
+        return (-200.0);
+    }
+
+    return (10.0 * log10(residual / tone));
+}
+/******************************************************************************
+ End of function src_bench_thdn
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_src_bench
+ Description:   Command to convert a -1 dBFS 1 kHz tone to the codec rate
+                with each resampler quality and report the CPU time per
+                output period, THD+N, latency and memory
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_src_bench (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    p_audio_resampler_t p_rs;
+    e_audio_resample_quality_t quality;
+    uint32_t in_rate = SRC_BENCH_DEFAULT_RATE;
+    uint32_t out_rate = r_soundtst_GetOutputRate();
+    uint32_t *p_in;
+    uint32_t *p_out;
+    uint32_t in_phase;
+    uint32_t in_len;
+    uint32_t in_pos;
+    uint32_t used;
+    uint32_t written;
+    uint32_t period;
+    uint32_t out_index;
+    uint32_t i;
+    uint32_t start;
+    uint64_t counts;
+    uint32_t period_us;
+    uint32_t cost_us;
+    int32_t thdn;
+    double sums[9];
+    double sum_yy;
+    double w;
+    double y;
+    double s;
+    double c;
+
+    if (iArgCount >= 2)
+    {
+        in_rate = (uint32_t) strtoul(ppszArgument[1], NULL, 10);
+    }
+
+    if ((in_rate < 8000u) || (in_rate > 192000u))
+    {
+        fprintf(pCom->p_out, "Usage: srcbench [input rate 8000 - 192000]\r\n");
+        return CMD_OK;
+    }
+
+    p_in = R_OS_AllocMem(CONV_BENCH_PERIOD_BYTES, R_REGION_LARGE_CAPACITY_RAM);
+    p_out = R_OS_AllocMem(CONV_BENCH_PERIOD_BYTES, R_REGION_LARGE_CAPACITY_RAM);
+
+    if ((NULL == p_in) || (NULL == p_out))
+    {
+        fprintf(pCom->p_out, "Failed to allocate memory\r\n");
+
+        if (NULL != p_in)
+        {
+            R_OS_FreeMem(p_in);
+        }
+
+        if (NULL != p_out)
+        {
+            R_OS_FreeMem(p_out);
+        }
+
+        return CMD_OK;
+    }
+
+    period_us = (SRC_BENCH_PERIOD_FRAMES * 1000000u) / out_rate;
+
+    fprintf(pCom->p_out, "%lu Hz to %lu Hz, %u frame output period (%luus)\r\n", (unsigned long) in_rate,
+            (unsigned long) out_rate, SRC_BENCH_PERIOD_FRAMES, (unsigned long) period_us);
+    fprintf(pCom->p_out, "Mode\tus/period\tCPU %%\tTHD+N dB\tLatency us\tRAM\r\n");
+
+    for (quality = AUDIO_RESAMPLE_QUALITY_LOW; quality < AUDIO_RESAMPLE_QUALITY_COUNT; quality++)
+    {
+        p_rs = r_audio_resample_create(in_rate, out_rate, quality);
+
+        if (NULL == p_rs)
+        {
+            fprintf(pCom->p_out, "%s\tfailed to allocate\r\n", r_audio_resample_quality_name(quality));
+            continue;
+        }
+
+        memset(sums, 0, sizeof(sums));
+        sum_yy = 0.0;
+        counts = 0u;
+        in_phase = 0u;
+        in_len = 0u;
+        in_pos = 0u;
+        out_index = 0u;
+
+        for (period = 0u; period < SRC_BENCH_PERIODS; period++)
+        {
+            written = 0u;
+
+            while (written < SRC_BENCH_PERIOD_FRAMES)
+            {
+                /* the tone is generated outside the timed section */
+                if (in_pos == in_len)
+                {
+                    for (i = 0u; i < SRC_BENCH_PERIOD_FRAMES; i++)
+                    {
+                        w = (2.0 * SRC_BENCH_PI * SRC_BENCH_TONE_HZ * (double) in_phase) / (double) in_rate;
+                        p_in[i * 2u] = (uint32_t) (int32_t) lrint(SRC_BENCH_TONE_AMPLITUDE * sin(w));
+                        p_in[(i * 2u) + 1u] = p_in[i * 2u];
+                        in_phase = (in_phase + 1u) % in_rate;
+                    }
+
+                    in_pos = 0u;
+                    in_len = SRC_BENCH_PERIOD_FRAMES;
+                }
+
+                start = CMD_SOUND_TIME_STAMP();
+                written += r_audio_resample_process(p_rs, p_in + (in_pos * 2u), in_len - in_pos, &used,
+                        p_out + (written * 2u), SRC_BENCH_PERIOD_FRAMES - written);
+                counts += CMD_SOUND_TIME_STAMP() - start;
+                in_pos += used;
+            }
+
+            /* skip the filter start up, then fit the left channel */
+            for (i = 0u; i < SRC_BENCH_PERIOD_FRAMES; i++)
+            {
+                if (period >= SRC_BENCH_SETTLE_PERIODS)
+                {
+                    w = (2.0 * SRC_BENCH_PI * SRC_BENCH_TONE_HZ * (double) out_index) / (double) out_rate;
+                    s = sin(w);
+                    c = cos(w);
+                    y = (double) (int32_t) p_out[i * 2u];
+
+                    sums[0] += s * s;
+                    sums[1] += s * c;
+                    sums[2] += s;
+                    sums[3] += c * c;
+                    sums[4] += c;
+                    sums[5] += 1.0;
+                    sums[6] += y * s;
+                    sums[7] += y * c;
+                    sums[8] += y;
+                    sum_yy += y * y;
+                }
+
+                out_index = (out_index + 1u) % out_rate;
+            }
+        }
+
+        cost_us = (uint32_t) (counts / ((uint64_t) CMD_SOUND_COUNTS_PER_US * SRC_BENCH_PERIODS));
+
+        /* tenths of a dB, the console printf has no floating point support */
+        thdn = (int32_t) lrint(src_bench_thdn(sums, sum_yy) * 10.0);
+
+        fprintf(pCom->p_out, "%s\t%lu\t\t%lu.%lu\t-%ld.%ld\t\t%lu\t\t%lu\r\n",
+                r_audio_resample_quality_name(quality), (unsigned long) cost_us,
+                (unsigned long) ((cost_us * 100u) / period_us),
+                (unsigned long) (((cost_us * 1000u) / period_us) % 10u), (long) (( -thdn) / 10), (long) (( -thdn) % 10),
+                (unsigned long) ((r_audio_resample_get_delay(p_rs) * 1000000u) / in_rate),
+                (unsigned long) r_audio_resample_get_ram(p_rs));
+
+        r_audio_resample_destroy(p_rs);
+    }
+
+    R_OS_FreeMem(p_in);
+    R_OS_FreeMem(p_out);
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_src_bench
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: dsp_print_tenths
+ Description:   Prints a value to one decimal place, the console printf has
+                no floating point support
+ Arguments:     IN  p_out - console output
+                IN  value - value to print
+ Return value:  none
+ ******************************************************************************/
+static void dsp_print_tenths (FILE *p_out, float value)
+{
+    long tenths = lrintf(value * 10.0f);
+
+    fprintf(p_out, "%s%ld.%ld", (tenths < 0) ? "-" : "", labs(tenths) / 10, labs(tenths) % 10);
+}
+/******************************************************************************
+ End of function dsp_print_tenths
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: dsp_show_config
+ Description:   Prints the DSP chain settings
+ Arguments:     IN  p_out - console output
+                IN  p_config - settings
+ Return value:  none
+ ******************************************************************************/
+static void dsp_show_config (FILE *p_out, const st_audio_dsp_config_t *p_config)
+{
+    uint32_t band;
+
+    fprintf(p_out, "DSP %s\r\n", (false != p_config->enable) ? "on" : "off (bypassed)");
+
+    for (band = 0u; band < AUDIO_DSP_EQ_BANDS; band++)
+    {
+        fprintf(p_out, "eq %lu %s %ld Hz ", (unsigned long) (band + 1u),
+                r_audio_dsp_filter_name(p_config->eq[band].type), lrintf(p_config->eq[band].freq_hz));
+        dsp_print_tenths(p_out, p_config->eq[band].gain_db);
+        fprintf(p_out, " dB Q ");
+        dsp_print_tenths(p_out, p_config->eq[band].q);
+        fprintf(p_out, "\r\n");
+    }
+
+    fprintf(p_out, "xover %s %ld Hz\r\n", (false != p_config->crossover_enable) ? "on" : "off",
+            lrintf(p_config->crossover_hz));
+    fprintf(p_out, "limit %s ", (false != p_config->limiter_enable) ? "on" : "off");
+    dsp_print_tenths(p_out, p_config->limiter_threshold_db);
+    fprintf(p_out, " dB release %ld ms\r\n", lrintf(p_config->limiter_release_ms));
+}
+/******************************************************************************
+ End of function dsp_show_config
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_dsp
+ Description:   Command to show or change the equaliser, crossover and
+                limiter applied to file playback
+                  dsp on|off|reset
+                  dsp eq <band> <type> [freq] [gain dB] [Q]
+                  dsp xover off|<freq>
+                  dsp limit off|<threshold dB> [release ms]
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_dsp (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    st_audio_dsp_config_t config;
+    st_audio_dsp_band_t *p_band;
+    e_audio_dsp_filter_t type;
+    bool_t usage = false;
+    uint32_t band;
+
+    r_soundtst_GetDspConfig( &config);
+
+    if (iArgCount < 2)
+    {
+        dsp_show_config(pCom->p_out, &config);
+        return CMD_OK;
+    }
+
+    if (0 == strcmp(ppszArgument[1], "on"))
+    {
+        config.enable = true;
+    }
+    else if (0 == strcmp(ppszArgument[1], "off"))
+    {
+        config.enable = false;
+    }
+    else if (0 == strcmp(ppszArgument[1], "reset"))
+    {
+        r_audio_dsp_default_config( &config);
+    }
+    else if ((0 == strcmp(ppszArgument[1], "eq")) && (iArgCount >= 4))
+    {
+        band = (uint32_t) strtoul(ppszArgument[2], NULL, 10);
+
+        for (type = AUDIO_DSP_FILTER_OFF; type < AUDIO_DSP_FILTER_COUNT; type++)
+        {
+            if (0 == strcmp(ppszArgument[3], r_audio_dsp_filter_name(type)))
+            {
+                break;
+            }
+        }
+
+        if ((band < 1u) || (band > AUDIO_DSP_EQ_BANDS) || (AUDIO_DSP_FILTER_COUNT == type))
+        {
+            usage = true;
+        }
+        else
+        {
+            p_band = &config.eq[band - 1u];
+            p_band->type = type;
+
+            if (iArgCount >= 5)
+            {
+                p_band->freq_hz = strtof(ppszArgument[4], NULL);
+            }
+
+            if (iArgCount >= 6)
+            {
+                p_band->gain_db = strtof(ppszArgument[5], NULL);
+            }
+
+            if (iArgCount >= 7)
+            {
+                p_band->q = strtof(ppszArgument[6], NULL);
+            }
+        }
+    }
+    else if ((0 == strcmp(ppszArgument[1], "xover")) && (iArgCount >= 3))
+    {
+        config.crossover_enable = (0 != strcmp(ppszArgument[2], "off"));
+
+        if (false != config.crossover_enable)
+        {
+            config.crossover_hz = strtof(ppszArgument[2], NULL);
+        }
+    }
+    else if ((0 == strcmp(ppszArgument[1], "limit")) && (iArgCount >= 3))
+    {
+        config.limiter_enable = (0 != strcmp(ppszArgument[2], "off"));
+
+        if (false != config.limiter_enable)
+        {
+            config.limiter_threshold_db = strtof(ppszArgument[2], NULL);
+
+            if (iArgCount >= 4)
+            {
+                config.limiter_release_ms = strtof(ppszArgument[3], NULL);
+            }
+        }
+    }
+    else
+    {
+        usage = true;
+    }
+
+    if (false != usage)
+    {
+        fprintf(pCom->p_out, "Usage: dsp [on|off|reset]\r\n"
+                "       dsp eq <1-%u> <off|peak|lowshelf|highshelf|lowpass|highpass> [Hz] [dB] [Q]\r\n"
+                "       dsp xover <off|Hz>\r\n"
+                "       dsp limit <off|dB> [release ms]\r\n", AUDIO_DSP_EQ_BANDS);
+        return CMD_OK;
+    }
+
+    if (DEVDRV_SUCCESS != r_soundtst_SetDspConfig( &config))
+    {
+        fprintf(pCom->p_out, "Setting out of range or playback not started\r\n");
+        return CMD_OK;
+    }
+
+    dsp_show_config(pCom->p_out, &config);
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_dsp
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_dsp_bench
+ Description:   Command to time each stage of the DSP chain on a period of
+                noise and report CPU cycles per sample and the share of the
+                period it takes at the codec rate
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_dsp_bench (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    static const char_t * const names[] =
+    {
+        "1 band eq", "5 band eq", "crossover", "limiter", "full chain"
+    };
+    p_audio_dsp_t p_dsp;
+    st_audio_dsp_config_t config;
+    uint32_t *p_noise;
+    uint32_t *p_period;
+    uint32_t seed = 1u;
+    uint32_t test;
+    uint32_t band;
+    uint32_t loop;
+    uint32_t i;
+    uint32_t start;
+    uint64_t counts;
+    uint32_t hundredths;
+    uint32_t period_us;
+    uint32_t cost_us;
+
+    AVOID_UNUSED_WARNING;
+
+    p_dsp = r_audio_dsp_create(r_soundtst_GetOutputRate());
+    p_noise = R_OS_AllocMem(CONV_BENCH_PERIOD_BYTES, R_REGION_LARGE_CAPACITY_RAM);
+    p_period = R_OS_AllocMem(CONV_BENCH_PERIOD_BYTES, R_REGION_LARGE_CAPACITY_RAM);
+
+    if ((NULL == p_dsp) || (NULL == p_noise) || (NULL == p_period))
+    {
+        fprintf(pCom->p_out, "Failed to allocate memory\r\n");
+    }
+    else
+    {
+        /* -6 dBFS white noise */
+        for (i = 0u; i < (DSP_BENCH_PERIOD_FRAMES * 2u); i++)
+        {
+            seed = (seed * 1664525u) + 1013904223u;
+            p_noise[i] = (uint32_t) ((int32_t) seed >> 1);
+        }
+
+        period_us = (DSP_BENCH_PERIOD_FRAMES * 1000000u) / r_soundtst_GetOutputRate();
+
+        fprintf(pCom->p_out, "%u frame period (%luus), cycles at %lu MHz\r\n", DSP_BENCH_PERIOD_FRAMES,
+                (unsigned long) period_us, (unsigned long) (configCPU_CLOCK_HZ / 1000000UL));
+        fprintf(pCom->p_out, "Stage\t\tcycles/sample\tus/period\tCPU %%\r\n");
+
+        for (test = 0u; test < (sizeof(names) / sizeof(names[0])); test++)
+        {
+            r_audio_dsp_default_config( &config);
+            config.enable = true;
+
+            for (band = 0u; band < AUDIO_DSP_EQ_BANDS; band++)
+            {
+                if ((1u == test) || (4u == test) || ((0u == test) && (0u == band)))
+                {
+                    config.eq[band].type = AUDIO_DSP_FILTER_PEAK;
+                    config.eq[band].gain_db = 3.0f;
+                }
+            }
+
+            config.crossover_enable = ((2u == test) || (4u == test));
+            config.limiter_enable = ((3u == test) || (4u == test));
+
+            /* a low threshold keeps the limiter busy */
+            config.limiter_threshold_db = -12.0f;
+
+            r_audio_dsp_configure(p_dsp, &config);
+
+            /* the first period picks up the configuration */
+            memcpy(p_period, p_noise, CONV_BENCH_PERIOD_BYTES);
+            r_audio_dsp_process(p_dsp, p_period, DSP_BENCH_PERIOD_FRAMES);
+
+            counts = 0u;
+
+            for (loop = 0u; loop < DSP_BENCH_LOOPS; loop++)
+            {
+                memcpy(p_period, p_noise, CONV_BENCH_PERIOD_BYTES);
+
+                start = CMD_SOUND_TIME_STAMP();
+                r_audio_dsp_process(p_dsp, p_period, DSP_BENCH_PERIOD_FRAMES);
+                counts += CMD_SOUND_TIME_STAMP() - start;
+            }
+
+            hundredths = (uint32_t) ((counts * configCPU_CLOCK_HZ * 100u)
+                    / ((uint64_t) configPERIPHERAL_CLOCK0_HZ * DSP_BENCH_LOOPS * DSP_BENCH_PERIOD_FRAMES * 2u));
+            cost_us = (uint32_t) (counts / (CMD_SOUND_COUNTS_PER_US * DSP_BENCH_LOOPS));
+
+            fprintf(pCom->p_out, "%s\t%lu.%02lu\t\t%lu\t\t%lu.%lu\r\n", names[test],
+                    (unsigned long) (hundredths / 100u), (unsigned long) (hundredths % 100u),
+                    (unsigned long) cost_us, (unsigned long) ((cost_us * 100u) / period_us),
+                    (unsigned long) (((cost_us * 1000u) / period_us) % 10u));
+        }
+    }
+
+    r_audio_dsp_destroy(p_dsp);
+
+    if (NULL != p_noise)
+    {
+        R_OS_FreeMem(p_noise);
+    }
+
+    if (NULL != p_period)
+    {
+        R_OS_FreeMem(p_period);
+    }
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_dsp_bench
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: media_lib_show_track
+ Description:   Prints one line for a track of the media library
+ Arguments:     IN  p_out - The stream to print to
+                IN  index - The index of the track
+                IN  p_track - The track
+ Return value:  none
+ ******************************************************************************/
+static void media_lib_show_track (FILE *p_out, uint32_t index, const st_media_track_t *p_track)
+{
+    static const char_t * const format_names[] = { "WAV", "AIFF", "FLAC" };
+    const char_t *p_format = "?";
+    uint32_t seconds = p_track->duration_ms / 1000u;
+    uint32_t i;
+
+    for (i = 0u; i < (sizeof(format_names) / sizeof(format_names[0])); i++)
+    {
+        if (p_track->format == (1u << i))
+        {
+            p_format = format_names[i];
+        }
+    }
+
+    fprintf(p_out, "%5lu %s %s %lu/%u/%u %lu:%02lu", (unsigned long) index, p_track->path, p_format,
+            (unsigned long) p_track->sample_rate, p_track->bits_per_sample, p_track->channels,
+            (unsigned long) (seconds / 60u), (unsigned long) (seconds % 60u));
+
+    if ('\0' != p_track->title[0])
+    {
+        fprintf(p_out, " \"%s\" %s / %s", p_track->title, p_track->artist, p_track->album);
+    }
+
+    fprintf(p_out, "\r\n");
+}
+/******************************************************************************
+ End of function media_lib_show_track
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_media_lib
+ Description:   Command to show the media library of a drive, ask for a
+                rescan or list the tracks that contain a text
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_media_lib (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    st_media_library_status_t status;
+    st_media_track_t track;
+    const char_t *p_action = NULL;
+    const char_t *p_text = NULL;
+    char_t drive = 'A';
+    uint32_t matches = 0u;
+    int32_t index;
+    int_t arg;
+
+    for (arg = 1; arg < iArgCount; arg++)
+    {
+        if ((2u == strlen(ppszArgument[arg])) && (':' == ppszArgument[arg][1]))
+        {
+            drive = ppszArgument[arg][0];
+        }
+        else if (NULL == p_action)
+        {
+            p_action = ppszArgument[arg];
+        }
+        else
+        {
+            p_text = ppszArgument[arg];
+        }
+    }
+
+    if ((NULL != p_action) && (0 == strcmp(p_action, "rescan")))
+    {
+        r_media_library_rescan(drive);
+        fprintf(pCom->p_out, "Rescan of %c: requested\r\n", drive);
+        return CMD_OK;
+    }
+
+    if ((NULL != p_action) && (0 != strcmp(p_action, "list")))
+    {
+        fprintf(pCom->p_out, "Usage: medialib [rescan|list [text]] [X:]\r\n");
+        return CMD_OK;
+    }
+
+    if (NULL != p_action)
+    {
+        index = r_media_library_find(drive, p_text, MEDIA_LIBRARY_FORMAT_ALL, 0u);
+
+        while ((index >= 0) && (DEVDRV_SUCCESS == r_media_library_get_track(drive, (uint32_t) index, &track)))
+        {
+            media_lib_show_track(pCom->p_out, (uint32_t) index, &track);
+            matches++;
+            index = r_media_library_find(drive, p_text, MEDIA_LIBRARY_FORMAT_ALL, (uint32_t) index + 1u);
+        }
+
+        fprintf(pCom->p_out, "%lu matching tracks\r\n", (unsigned long) matches);
+    }
+
+    r_media_library_get_status(drive, &status);
+
+    if (!status.ready)
+    {
+        fprintf(pCom->p_out, "%c: has no index%s\r\n", drive, status.scanning ? ", scanning" : "");
+        return CMD_OK;
+    }
+
+    fprintf(pCom->p_out, "%c: %lu tracks in %lu directories, %lu bytes of RAM, generation %lu%s\r\n", drive,
+            (unsigned long) status.tracks, (unsigned long) status.dirs, (unsigned long) status.bytes,
+            (unsigned long) status.generation, status.scanning ? ", scanning" : "");
+    fprintf(pCom->p_out, "Last scan %lums, %lu files parsed, %lu directories reused%s%s\r\n",
+            (unsigned long) status.scan_ms, (unsigned long) status.files_parsed,
+            (unsigned long) status.dirs_reused, status.loaded ? ", started from " MEDIA_LIBRARY_FILE_NAME : "",
+            status.saved ? ", index saved" : "");
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_media_lib
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_playlist
+ Description:   Command to build the playlist, play, jump or seek in it and
+                show the playhead
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_playlist (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    st_sound_position_t position;
+    char_t path[MEDIA_LIBRARY_MAX_PATH];
+    const char_t *p_action = (iArgCount > 1) ? ppszArgument[1] : "";
+    uint32_t count;
+    uint32_t index;
+    int32_t res = DEVDRV_SUCCESS;
+    int_t arg;
+
+    r_soundtst_GetPosition( &position);
+
+    if (0 == strcmp(p_action, "add"))
+    {
+        for (arg = 2; (arg < iArgCount) && (DEVDRV_SUCCESS == res); arg++)
+        {
+            res = (r_soundtst_PlaylistAdd(ppszArgument[arg]) < 0) ? DEVDRV_ERROR : DEVDRV_SUCCESS;
+        }
+    }
+    else if (0 == strcmp(p_action, "clear"))
+    {
+        r_soundtst_PlaylistClear();
+    }
+    else if (0 == strcmp(p_action, "play"))
+    {
+        index = (iArgCount > 2) ? (uint32_t) strtoul(ppszArgument[2], NULL, 10) : 0u;
+        res = r_soundtst_PlaylistPlay(index,
+                (iArgCount > 3) ? ((uint32_t) strtoul(ppszArgument[3], NULL, 10) * 1000u) : 0u);
+    }
+    else if ((0 == strcmp(p_action, "next")) || (0 == strcmp(p_action, "prev")))
+    {
+        index = ('n' == p_action[0]) ? (position.track + 1u) : ((0u != position.track) ? (position.track - 1u) : 0u);
+        res = (false != position.playing) ? r_soundtst_PlaylistPlay(index, 0u) : DEVDRV_ERROR;
+    }
+    else if ((0 == strcmp(p_action, "seek")) && (iArgCount > 2))
+    {
+        res = r_soundtst_Seek((uint32_t) strtoul(ppszArgument[2], NULL, 10) * 1000u);
+    }
+    else if (0 == strcmp(p_action, "stop"))
+    {
+        r_soundtst_PlaylistStop();
+    }
+    else if ('\0' != p_action[0])
+    {
+        fprintf(pCom->p_out, "Usage: playlist [add <file>..|clear|play [n] [s]|next|prev|seek <s>|stop]\r\n");
+        return CMD_OK;
+    }
+    else
+    {
+        count = r_soundtst_PlaylistGetCount();
+
+        for (index = 0u; (index < count) && (DEVDRV_SUCCESS == r_soundtst_PlaylistGetPath(index, path, sizeof(path)));
+                index++)
+        {
+            fprintf(pCom->p_out, "%c%4lu %s\r\n",
+                    ((false != position.playing) && (position.track == index)) ? '>' : ' ', (unsigned long) index, path);
+        }
+
+        fprintf(pCom->p_out, "%lu tracks\r\n", (unsigned long) count);
+    }
+
+    if (DEVDRV_SUCCESS != res)
+    {
+        fprintf(pCom->p_out, "playlist %s failed\r\n", p_action);
+        return CMD_OK;
+    }
+
+    if (false != position.playing)
+    {
+        fprintf(pCom->p_out, "Playing %lu at %lu:%02lu of %lu:%02lu, %lu Hz, %lu gapless transitions\r\n",
+                (unsigned long) position.track, (unsigned long) (position.position_ms / 60000u),
+                (unsigned long) ((position.position_ms / 1000u) % 60u), (unsigned long) (position.duration_ms / 60000u),
+                (unsigned long) ((position.duration_ms / 1000u) % 60u), (unsigned long) position.sample_rate,
+                (unsigned long) position.transitions);
+    }
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_playlist
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: play_stat_show
+ Description:   Function to print the file playback counters of each format
+ Arguments:     IN  p_out - The stream to print to
+ Return value:  none
+ ******************************************************************************/
+static void play_stat_show (FILE *p_out)
+{
+    st_sound_play_stats_t stats;
+    uint32_t entry;
+
+    r_soundtst_GetPlayStats( &stats);
+
+    fprintf(p_out, "SSIF queue depth %lu of %lu periods\r\n", (unsigned long) stats.queue_depth,
+            (unsigned long) SOUND_SSIF_QUEUE_DEPTH_MAX);
+    fprintf(p_out, "     Rate Bits   Periods Underruns Min queued\r\n");
+
+    for (entry = 0u; entry < stats.formats; entry++)
+    {
+        fprintf(p_out, "%9lu %4lu %9lu %9lu %10lu\r\n", (unsigned long) stats.format[entry].sample_rate,
+                (unsigned long) stats.format[entry].bits_per_sample, (unsigned long) stats.format[entry].periods,
+                (unsigned long) stats.format[entry].underruns, (unsigned long) stats.format[entry].min_queued);
+    }
+}
+/******************************************************************************
+ End of function play_stat_show
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_play_stat
+ Description:   Command to show the file playback underruns and SSIF queue
+                headroom for each source format, or set the queue depth
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_play_stat (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    if ((iArgCount >= 2) && (0 == strcmp(ppszArgument[1], "reset")))
+    {
+        r_soundtst_ResetPlayStats();
+        fprintf(pCom->p_out, "Playback statistics cleared\r\n");
+        return CMD_OK;
+    }
+
+    if ((iArgCount >= 3) && (0 == strcmp(ppszArgument[1], "depth")))
+    {
+        if (DEVDRV_SUCCESS != r_soundtst_SetQueueDepth((uint32_t) strtoul(ppszArgument[2], NULL, 10)))
+        {
+            fprintf(pCom->p_out, "Depth must be 1 to %lu\r\n", (unsigned long) SOUND_SSIF_QUEUE_DEPTH_MAX);
+            return CMD_OK;
+        }
+    }
+    else if (iArgCount >= 2)
+    {
+        fprintf(pCom->p_out, "Usage: playstat [reset|depth <n>]\r\n");
+        return CMD_OK;
+    }
+
+    play_stat_show(pCom->p_out);
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_play_stat
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: play_test_write_tone
+ Description:   Function to write a 24 bit stereo WAV file of the test tone,
+                unless the file is already there
+ Arguments:     IN  p_path - The file to write
+                IN  rate - The sample rate
+                IN  seconds - The length of the tone
+ Return value:  true if the file is there
+ ******************************************************************************/
+static bool_t play_test_write_tone (char_t *p_path, uint32_t rate, uint32_t seconds)
+{
+    static const uint8_t header[44] =
+    {
+        'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, PLAY_TEST_FRAME_BYTES, 0, 24, 0,
+        'd', 'a', 't', 'a', 0, 0, 0, 0
+    };
+    FIL *p_file;
+    uint8_t *p_block;
+    uint32_t frames = rate * seconds;
+    uint32_t data_bytes = frames * PLAY_TEST_FRAME_BYTES;
+    uint32_t frame = 0u;
+    uint32_t count;
+    uint32_t i;
+    int32_t sample;
+    bool_t ok;
+
+    p_file = R_FAT_OpenFile(p_path, FA_READ);
+
+    if (NULL != p_file)
+    {
+        R_FAT_CloseFile(p_file);
+        return (true);
+    }
+
+    p_block = R_OS_AllocMem(PLAY_TEST_BLOCK_FRAMES * PLAY_TEST_FRAME_BYTES, R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL == p_block)
+    {
+        return (false);
+    }
+
+    p_file = R_FAT_OpenFile(p_path, FA_WRITE | FA_CREATE_ALWAYS);
+
+    if (NULL == p_file)
+    {
+        R_OS_FreeMem(p_block);
+        return (false);
+    }
+
+    /* little endian RIFF size, rate, byte rate and data size */
+    memcpy(p_block, header, sizeof(header));
+    for (i = 0u; i < 4u; i++)
+    {
+        p_block[4u + i] = (uint8_t) ((data_bytes + 36u) >> (i * 8u));
+        p_block[24u + i] = (uint8_t) (rate >> (i * 8u));
+        p_block[28u + i] = (uint8_t) ((rate * PLAY_TEST_FRAME_BYTES) >> (i * 8u));
+        p_block[40u + i] = (uint8_t) (data_bytes >> (i * 8u));
+    }
+
+    ok = ((int) sizeof(header) == R_FAT_WriteFile(p_file, p_block, sizeof(header)));
+
+    while ((false != ok) && (frame < frames))
+    {
+        count = ((frames - frame) < PLAY_TEST_BLOCK_FRAMES) ? (frames - frame) : PLAY_TEST_BLOCK_FRAMES;
+
+        for (i = 0u; i < count; i++)
+        {
+            sample = (int32_t) lrint(PLAY_TEST_TONE_AMPLITUDE
+                    * sin((2.0 * SRC_BENCH_PI * PLAY_TEST_TONE_HZ * (double) (frame + i)) / (double) rate));
+
+            /* same sample on both channels */
+            p_block[i * PLAY_TEST_FRAME_BYTES] = (uint8_t) sample;
+            p_block[(i * PLAY_TEST_FRAME_BYTES) + 1u] = (uint8_t) (sample >> 8);
+            p_block[(i * PLAY_TEST_FRAME_BYTES) + 2u] = (uint8_t) (sample >> 16);
+            memcpy( &p_block[(i * PLAY_TEST_FRAME_BYTES) + 3u], &p_block[i * PLAY_TEST_FRAME_BYTES], 3u);
+        }
+
+        ok = ((int) (count * PLAY_TEST_FRAME_BYTES)
+                == R_FAT_WriteFile(p_file, p_block, (unsigned int) (count * PLAY_TEST_FRAME_BYTES)));
+        frame += count;
+    }
+
+    R_FAT_CloseFile(p_file);
+    R_OS_FreeMem(p_block);
+
+    if (false == ok)
+    {
+        /* do not leave a short file to be played next time */
+        R_FAT_RemoveFile(p_path);
+    }
+
+    return (ok);
+}
+/******************************************************************************
+ End of function play_test_write_tone
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmd_play_test
+ Description:   Command to play a 24 bit tone at 44.1, 48 and 96 kHz back to
+                back from a drive and show the underruns of each
+ Arguments:     IN  iArgCount - The number of arguments in the argument list
+                IN  ppszArgument - The argument list
+                IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int16_t cmd_play_test (int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    st_sound_position_t position;
+    char_t path[16];
+    char_t drive = 'A';
+    uint32_t seconds = PLAY_TEST_DEFAULT_SECONDS;
+    uint32_t waited_ms = 0u;
+    uint32_t rate;
+    bool_t started = false;
+    int_t arg;
+
+    for (arg = 1; arg < iArgCount; arg++)
+    {
+        if ((2u == strlen(ppszArgument[arg])) && (':' == ppszArgument[arg][1]))
+        {
+            drive = ppszArgument[arg][0];
+        }
+        else
+        {
+            seconds = (uint32_t) strtoul(ppszArgument[arg], NULL, 10);
+        }
+    }
+
+    if ((0u == seconds) || (seconds > 600u))
+    {
+        fprintf(pCom->p_out, "Usage: playtest [seconds] [X:]\r\n");
+        return CMD_OK;
+    }
+
+    r_soundtst_PlaylistStop();
+    r_soundtst_PlaylistClear();
+
+    for (rate = 0u; rate < PLAY_TEST_RATES; rate++)
+    {
+        sprintf(path, "%c:\\PT%02luK24.WAV", drive, (unsigned long) (gs_play_test_rates[rate] / 1000u));
+        fprintf(pCom->p_out, "%s %lu Hz 24 bit\r\n", path, (unsigned long) gs_play_test_rates[rate]);
+
+        if ((false == play_test_write_tone(path, gs_play_test_rates[rate], seconds))
+                || (r_soundtst_PlaylistAdd(path) < 0))
+        {
+            fprintf(pCom->p_out, "Could not write %s\r\n", path);
+            return CMD_OK;
+        }
+    }
+
+    r_soundtst_ResetPlayStats();
+
+    if (DEVDRV_SUCCESS != r_soundtst_PlaylistPlay(0u, 0u))
+    {
+        fprintf(pCom->p_out, "playback not running\r\n");
+        return CMD_OK;
+    }
+
+    /* the files are longer than asked for if they were left by an earlier run, allow twice as long */
+    while (waited_ms < (seconds * PLAY_TEST_RATES * 2000u))
+    {
+        /* the event is set every 250ms while playing */
+        if (false == r_soundtst_WaitPosition( &position, 1000u))
+        {
+            r_soundtst_GetPosition( &position);
+            waited_ms += 750u;
+        }
+
+        if (false != position.playing)
+        {
+            started = true;
+        }
+        else if (false != started)
+        {
+            break;
+        }
+        else
+        {
+            /* playback has not started yet */
+        }
+
+        waited_ms += 250u;
+    }
+
+    r_soundtst_PlaylistStop();
+    play_stat_show(pCom->p_out);
+
+    return CMD_OK;
+}
+/******************************************************************************
+ End of function cmd_play_test
+ ******************************************************************************/
+
+/* Table that associates command letters, function pointer and a little
+ description of what the command does */
+static const st_cmdfnass_t gs_cmd_sound[] =
+{
+    {
+        "audiostat",
+        (const CMDFUNC) cmd_audio_stat,
+        "<CR> - Show audio period latency and CPU load, \"audiostat reset\" clears"
+    },
+
+    {
+        "streamstat",
+        (const CMDFUNC) cmd_stream_stat,
+        "<CR> - Show the wave file prefetch fill level and underruns"
+    },
+
+    {
+        "convbench",
+        (const CMDFUNC) cmd_conv_bench,
+        "<CR> - Time the sample format conversion kernels and check them against the reference"
+    },
+
+    {
+        "decbench",
+        (const CMDFUNC) cmd_dec_bench,
+        "<file> <CR> - Decode a WAV, AIFF or FLAC file and show the decode rate and peak decoder RAM"
+    },
+
+    {
+        "srcmode",
+        (const CMDFUNC) cmd_src_mode,
+        "[low|medium|high] <CR> - Show or select the sample rate converter quality"
+    },
+
+    {
+        "srcbench",
+        (const CMDFUNC) cmd_src_bench,
+        "[rate] <CR> - Time the sample rate converter from rate (default 48000) and measure THD+N"
+    },
+
+    {
+        "dsp",
+        (const CMDFUNC) cmd_dsp,
+        "[on|off|reset|eq|xover|limit ...] <CR> - Show or set the playback equaliser, crossover and limiter"
+    },
+
+    {
+        "dspbench",
+        (const CMDFUNC) cmd_dsp_bench,
+        "<CR> - Show the cycles per sample of each DSP stage"
+    },
+
+    {
+        "medialib",
+        (const CMDFUNC) cmd_media_lib,
+        "[rescan|list [text]] [X:] <CR> - Show the media library of a drive, rescan it or list matching tracks"
+    },
+
+    {
+        "playlist",
+        (const CMDFUNC) cmd_playlist,
+        "[add <file>..|clear|play [n] [s]|next|prev|seek <s>|stop] <CR> - Show or control the gapless playlist"
+    },
+
+    {
+        "playstat",
+        (const CMDFUNC) cmd_play_stat,
+        "[reset|depth <n>] <CR> - Show the playback underruns per format or set the SSIF queue depth"
+    },
+
+    {
+        "playtest",
+        (const CMDFUNC) cmd_play_test,
+        "[seconds] [X:] <CR> - Play a 24 bit tone at 44.1, 48 and 96 kHz from a drive and show the underruns"
+    },
+};
+
+/* Table that points to the above table and contains the number of entries */
+const st_command_table_t g_cmd_tbl_sound_app =
+{
+    "Sound Commands",
+    (pst_cmdfnass_t) gs_cmd_sound,
+    (sizeof(gs_cmd_sound) / sizeof(st_cmdfnass_t)),
+};
+
+/******************************************************************************
+End  Of File
+******************************************************************************/
@@ -49,6 +49,8 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <math.h>
 
 /******************************************************************************
 User Includes
@@ -61,8 +63,16 @@ User Includes
 #include "r_devlink_wrapper.h"
 #include "r_os_abstraction_api.h"
 #include "r_task_priority.h"
+#include "r_fatfs_abstraction.h"
 
 
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+
+/* The number of frames moved by each read or write of the audio test */
+#define USBA_TEST_FRAMES    (96)
+
 /******************************************************************************
 Typedef definitions
 ******************************************************************************/
@@ -317,6 +327,200 @@ static int cmdMonitorMouse(int iArgCount, int8_t **ppszArgument, pst_comset_t p_
 End of function  cmdMonitorMouse
 ******************************************************************************/
 
+/******************************************************************************
+ Function Name: cmdBlockCacheStats
+ Description:   Command to show the hit rate of the mass storage block cache
+ Arguments:     IN  iArgCount The number of arguments in the argument list
+ IN  ppszArgument - The argument list
+ IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int cmdBlockCacheStats(int iArgCount, int8_t **ppszArgument, pst_comset_t p_com)
+{
+    BCSTATS stats;
+    unsigned long ulLookups;
+
+    if ((NULL == p_drive_0) || (NULL == p_drive_0->pBlockCache))
+    {
+        fprintf(p_com->p_out, "No drive mounted\r\n");
+        return CMD_OK;
+    }
+
+    bcGetStats(p_drive_0->pBlockCache, &stats);
+    ulLookups = stats.ulHits + stats.ulMisses;
+
+    fprintf(p_com->p_out, "Block cache %d lines of %d sectors, %d way\r\n",
+            BC_DEFAULT_NUM_ENTRIES, BC_DEFAULT_LINE_SIZE, BC_WAYS);
+    fprintf(p_com->p_out, "Hits          %lu (%lu%%)\r\n", stats.ulHits,
+            (0UL != ulLookups) ? ((stats.ulHits * 100UL) / ulLookups) : 0UL);
+    fprintf(p_com->p_out, "Misses        %lu\r\n", stats.ulMisses);
+    fprintf(p_com->p_out, "Evictions     %lu\r\n", stats.ulEvictions);
+    fprintf(p_com->p_out, "Invalidations %lu\r\n", stats.ulInvalidations);
+    fprintf(p_com->p_out, "Uncached      %lu\r\n", stats.ulBypassed);
+    fprintf(p_com->p_out, "Read-ahead %d sectors, %lu fills\r\n", BC_READ_AHEAD_SECTORS, stats.ulReadAheadFills);
+    fprintf(p_com->p_out, "  Used        %lu sectors\r\n", stats.ulReadAheadHits);
+    fprintf(p_com->p_out, "  Wasted      %lu sectors\r\n", stats.ulReadAheadWasted);
+    fprintf(p_com->p_out, "Write-back %d sectors, %lu writes\r\n", BC_WRITE_BACK_SECTORS, stats.ulWritesBuffered);
+    fprintf(p_com->p_out, "  Transfers   %lu (%lu sectors each)\r\n", stats.ulWriteBackTransfers,
+            (0UL != stats.ulWriteBackTransfers) ? (stats.ulWriteBackSectors / stats.ulWriteBackTransfers) : 0UL);
+
+    if ((iArgCount > 1) && (0 == strcmp((char *) ppszArgument[1], "reset")))
+    {
+        bcResetStats(p_drive_0->pBlockCache);
+        fprintf(p_com->p_out, "Counters reset\r\n");
+    }
+
+    return CMD_OK;
+}
+/******************************************************************************
+End of function  cmdBlockCacheStats
+******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmdUsbAudioFill
+ Description:   Function to make a 1kHz tone in the format of the device,
+                little endian samples left justified in the subslot
+ Arguments:     OUT pbyDest - Pointer to the destination
+                IN  pStat - Pointer to the device status
+                IN  pulPhase - Pointer to the phase in frames
+ Return value:  The number of bytes made
+ ******************************************************************************/
+static uint32_t cmdUsbAudioFill(uint8_t *pbyDest, PACSTAT pStat, unsigned long *pulPhase)
+{
+    uint32_t uiFrame;
+    uint8_t *pbyStart = pbyDest;
+
+    for (uiFrame = 0; uiFrame < USBA_TEST_FRAMES; uiFrame++)
+    {
+        /* -12dBFS */
+        float fSample = 0.25f * sinf((6.2831853f * 1000.0f * (float) *pulPhase) / (float) pStat->dwSampleRate);
+        int32_t iSample = (int32_t) (fSample * 2147483647.0f);
+        uint8_t byChannel;
+
+        for (byChannel = 0; byChannel < pStat->byOutChannels; byChannel++)
+        {
+            uint8_t byByte;
+
+            for (byByte = 0; byByte < pStat->byOutSubslotSize; byByte++)
+            {
+                *pbyDest++ = (uint8_t) (iSample >> (8 * (4 - pStat->byOutSubslotSize + byByte)));
+            }
+        }
+        *pulPhase = (*pulPhase + 1UL) % pStat->dwSampleRate;
+    }
+    return (uint32_t) (pbyDest - pbyStart);
+}
+/******************************************************************************
+End of function  cmdUsbAudioFill
+******************************************************************************/
+
+/******************************************************************************
+ Function Name: cmdUsbAudio
+ Description:   Command to show the state of a USB audio device, play a test
+                tone or loop the capture back to playback
+ Arguments:     IN  iArgCount The number of arguments in the argument list
+ IN  ppszArgument - The argument list
+ IN  pCom - Pointer to the command object
+ Return value:  CMD_OK for success
+ ******************************************************************************/
+static int cmdUsbAudio(int iArgCount, int8_t **ppszArgument, pst_comset_t p_com)
+{
+    ACSTAT stat;
+    SPKDAT volume;
+    int iAudio = open(DEVICE_INDENTIFIER "USB Audio", O_RDWR, _IONBF);
+
+    if ((-1) == iAudio)
+    {
+        fprintf(p_com->p_out, "No USB audio device found\r\n");
+        return CMD_OK;
+    }
+
+    if ((iArgCount > 1) && ((0 == strcmp((char *) ppszArgument[1], "tone"))
+            || (0 == strcmp((char *) ppszArgument[1], "loop"))))
+    {
+        _Bool bfLoop = (0 == strcmp((char *) ppszArgument[1], "loop"));
+        unsigned long ulSeconds = (iArgCount > 2) ? strtoul((char *) ppszArgument[2], NULL, 10) : 5UL;
+        unsigned long ulFrames;
+        unsigned long ulPhase = 0UL;
+        uint8_t *pbyBuffer;
+
+        control(iAudio, CTL_GET_SPEAKER_STATUS, &stat);
+        ulFrames = ulSeconds * stat.dwSampleRate;
+        pbyBuffer = R_OS_AllocMem(USBA_TEST_FRAMES * 4 * 8, R_REGION_LARGE_CAPACITY_RAM);
+        if ((NULL == pbyBuffer) || (0 == stat.byOutChannels)
+                || ((bfLoop) && ((stat.byInChannels != stat.byOutChannels)
+                        || (stat.byInSubslotSize != stat.byOutSubslotSize))))
+        {
+            fprintf(p_com->p_out, "The device does not support this test\r\n");
+        }
+        else
+        {
+            fprintf(p_com->p_out, "%s for %lu seconds at %luHz\r\n", (bfLoop) ? "Loop back" : "1kHz tone", ulSeconds,
+                    (unsigned long) stat.dwSampleRate);
+            while (ulFrames >= USBA_TEST_FRAMES)
+            {
+                int iLength;
+
+                if (bfLoop)
+                {
+                    iLength = read(iAudio, pbyBuffer, USBA_TEST_FRAMES * stat.byInChannels * stat.byInSubslotSize);
+                }
+                else
+                {
+                    iLength = (int) cmdUsbAudioFill(pbyBuffer, &stat, &ulPhase);
+                }
+                if ((iLength <= 0) || (write(iAudio, pbyBuffer, (uint32_t) iLength) != iLength))
+                {
+                    fprintf(p_com->p_out, "Stream error\r\n");
+                    break;
+                }
+                ulFrames -= (unsigned long) iLength / (stat.byOutChannels * stat.byOutSubslotSize);
+            }
+        }
+        if (pbyBuffer)
+        {
+            R_OS_FreeMem(pbyBuffer);
+        }
+    }
+
+    control(iAudio, CTL_GET_SPEAKER_STATUS, &stat);
+    fprintf(p_com->p_out, "Audio Class %s, %luHz\r\n", (stat.wADC >= 0x0200) ? "2.0" : "1.0",
+            (unsigned long) stat.dwSampleRate);
+    if (stat.byOutChannels)
+    {
+        static const char * const ppszSync[] = {"none", "asynchronous", "adaptive", "synchronous"};
+
+        fprintf(p_com->p_out, "Playback  %u channels %u bits in %u bytes, %s%s\r\n", stat.byOutChannels,
+                stat.byOutBitResolution, stat.byOutSubslotSize, ppszSync[stat.byOutSyncType & 3],
+                (stat.bfExplicitFeedback) ? " with feedback" : "");
+        fprintf(p_com->p_out, "  Rate    %lu.%.4lu samples per packet, nominal %lu.%.4lu\r\n",
+                (unsigned long) (stat.dwCurrentRate >> 16), (unsigned long) (((stat.dwCurrentRate & 0xFFFF) * 10000UL) >> 16),
+                (unsigned long) (stat.dwNominalRate >> 16), (unsigned long) (((stat.dwNominalRate & 0xFFFF) * 10000UL) >> 16));
+        fprintf(p_com->p_out, "  Packets %lu, underruns %lu\r\n", (unsigned long) stat.dwPacketsOut,
+                (unsigned long) stat.dwUnderruns);
+        fprintf(p_com->p_out, "  Feedback %lu used, %lu rejected\r\n", (unsigned long) stat.dwFeedbackReads,
+                (unsigned long) stat.dwFeedbackRejected);
+    }
+    if (stat.byInChannels)
+    {
+        fprintf(p_com->p_out, "Capture   %u channels %u bits in %u bytes\r\n", stat.byInChannels,
+                stat.byInBitResolution, stat.byInSubslotSize);
+        fprintf(p_com->p_out, "  Packets %lu, overruns %lu\r\n", (unsigned long) stat.dwPacketsIn,
+                (unsigned long) stat.dwOverruns);
+    }
+    fprintf(p_com->p_out, "Transfer errors %lu\r\n", (unsigned long) stat.dwTransferErrors);
+    if (0 == control(iAudio, CTL_GET_SPEAKER_VOLUME, &volume))
+    {
+        fprintf(p_com->p_out, "Volume %d/256dB (%d to %d)%s\r\n", volume.siCurVol, volume.siMinVol,
+                volume.siMaxVol, (volume.bfMute) ? " muted" : "");
+    }
+
+    close(iAudio);
+    return CMD_OK;
+}
+/******************************************************************************
+End of function  cmdUsbAudio
+******************************************************************************/
 
 #if 0
 
@@ -415,6 +619,18 @@ const st_cmdfnass_t gpcmdUSB[] =
         (const CMDFUNC) cmdConsoleUSB,
         "<CR> - Invokes USB console reading data from a USB keyboard"
     },
+
+    {
+        "usba",
+        (const CMDFUNC) cmdUsbAudio,
+        "[tone|loop [s]]<CR> - Shows a USB audio device, plays a 1kHz tone or loops capture to playback"
+    },
+
+    {
+        "bcstat",
+        (const CMDFUNC) cmdBlockCacheStats,
+        "[reset]<CR> - Shows the mass storage block cache counters"
+    },
 /*
     "batch",
     cmdBatch,
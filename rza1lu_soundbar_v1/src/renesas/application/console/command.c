@@ -64,6 +64,7 @@ Includes   <System Includes> , "Project Includes"
 #include "queue.h"
 #include "task.h"
 #include "nonVolatileData.h"
+#include "r_os_abstraction_api.h"
 
 
 
@@ -77,6 +78,9 @@ Macro definitions
 
 /* Define the number of characters printed on a line for the "mem" command */
 #define CMD_PRV_MEM_COMMAND_CHAR_COUNT      (16)
+
+/* Define the number of allocation events read at a time by the "memtrace" command */
+#define CMD_PRV_MEM_TRACE_CHUNK             (16)
 #define CMD_LOGIN_AND_PASSWORD_STRING_PRV_   (32)
 
 /******************************************************************************
@@ -152,6 +156,7 @@ static int16_t cmd_read_memory (int iArgCount, char **ppszArgument, pst_comset_t
 int16_t cmd_list_devlink_tbl_content(int iArgCount, char **ppszArgument, pst_comset_t pCom);
 int16_t cmd_list_device_open_handles(int iArgCount, char **ppszArgument, pst_comset_t pCom);
 static int16_t cmd_version(int iArgCount, char **ppszArgument, pst_comset_t pCom);
+static int16_t cmd_mem_trace(int iArgCount, char **ppszArgument, pst_comset_t pCom);
 static void cmdLoadLogin(void);
 _Bool cmdCheckUserNameAndPassword(char *pszUserName, char *pszPassword);
 int cmdUserName (int iArgCount, char **ppszArgument, pst_comset_t pCom);
@@ -202,6 +207,12 @@ static st_cmdfnass_t gs_cmd_command[] =
         "<CR> - List opened driver information",
      },
 
+     {
+        "memtrace",
+        cmd_mem_trace,
+        "on|off|dump [s]<CR> - Record allocations, dump events from sequence s",
+     },
+
      {
         "ver",
         cmd_version,
@@ -778,6 +789,99 @@ static int16_t cmd_version(int_t iArgCount, char_t **ppszArgument, pst_comset_t
 End of function cmd_version
 ******************************************************************************/
 
+/******************************************************************************
+Function Name: cmd_mem_trace
+Description:   Command to control and dump the allocation trace. The dump
+               lists the running tasks then one line per event, which
+               util/memtrace/memtrace.py reads back:
+               task <number> <name>
+               <seq> <tick> <task> t <name>
+               <seq> <tick> <task> a|f|x <region> <size> <address> <caller>
+               end <next seq>
+Arguments:     IN  iArgCount - The number of arguments in the argument list
+               IN  ppszArgument - The argument list
+               IN  pCom - Pointer to the command object
+Return value:  CMD_OK for success
+******************************************************************************/
+static int16_t cmd_mem_trace(int_t iArgCount, char_t **ppszArgument, pst_comset_t pCom)
+{
+    static const char_t s_type[] = "afxt";
+    st_os_mem_event_t events[CMD_PRV_MEM_TRACE_CHUNK];
+    st_os_mem_trace_task_t *p_tasks;
+    uint32_t sequence = 0;
+    uint32_t count;
+    uint32_t total;
+    uint32_t i;
+
+    if ((iArgCount > 1) && (0 == strcmp(ppszArgument[1], "on")))
+    {
+        R_OS_SetMemTrace(true);
+    }
+    else if ((iArgCount > 1) && (0 == strcmp(ppszArgument[1], "off")))
+    {
+        R_OS_SetMemTrace(false);
+    }
+    else if ((iArgCount > 1) && (0 == strcmp(ppszArgument[1], "dump")))
+    {
+        if (iArgCount > 2)
+        {
+            sequence = strtoul(ppszArgument[2], NULL, 10);
+        }
+
+        count = uxTaskGetNumberOfTasks() + 4;
+        p_tasks = R_OS_AllocMem(count * sizeof(st_os_mem_trace_task_t), R_REGION_LARGE_CAPACITY_RAM);
+        if (NULL != p_tasks)
+        {
+            count = R_OS_GetMemTraceTasks(p_tasks, count);
+            for (i = 0; i < count; i++)
+            {
+                fprintf(pCom->p_out, "task %u %s\r\n", (unsigned) p_tasks[i].task, p_tasks[i].name);
+            }
+            R_OS_FreeMem(p_tasks);
+        }
+
+        /* The events are printed a chunk at a time, any overwritten while printing show as a gap. Printing can
+           allocate, so stop after one ring's worth rather than chase the events it makes */
+        total = 0;
+        while ((total < R_OS_ABSTRACTION_MEM_TRACE_EVENTS)
+                && (0 != (count = R_OS_GetMemTrace(&sequence, events, CMD_PRV_MEM_TRACE_CHUNK))))
+        {
+            for (i = 0; i < count; i++)
+            {
+                st_os_mem_event_t *p_event = &events[i];
+
+                if (R_OS_MEM_EVENT_TASK == p_event->type)
+                {
+                    fprintf(pCom->p_out, "%lu %lu %u t %.*s\r\n", (unsigned long) (sequence + i),
+                            (unsigned long) p_event->timestamp, (unsigned) p_event->task,
+                            R_OS_ABSTRACTION_MEM_TRACE_NAME_SIZE, p_event->data.name);
+                }
+                else
+                {
+                    fprintf(pCom->p_out, "%lu %lu %u %c %02X %lu %08lX %08lX\r\n", (unsigned long) (sequence + i),
+                            (unsigned long) p_event->timestamp, (unsigned) p_event->task,
+                            s_type[p_event->type], (unsigned) p_event->region,
+                            (unsigned long) p_event->data.block.size,
+                            (unsigned long) p_event->data.block.address,
+                            (unsigned long) p_event->data.block.caller);
+                }
+            }
+            sequence += count;
+            total += count;
+        }
+        fprintf(pCom->p_out, "end %lu\r\n", (unsigned long) sequence);
+    }
+    else
+    {
+        fprintf(pCom->p_out, "memtrace on|off|dump [sequence]\r\n");
+    }
+
+    return CMD_OK;
+}
+/******************************************************************************
+End of function cmd_mem_trace
+******************************************************************************/
+
 /*****************************************************************************
 Function Name: cmdLoadLogin
 Description:   Function to load the login information from EEROM
@@ -67,6 +67,8 @@
 #include "r_fatfs_abstraction.h"
 #include "ff.h"
 
+#include "r_audio_convert.h"
+
 /******************************************************************************
  Macro definitions
  ******************************************************************************/
@@ -161,7 +163,8 @@ static uint32_t m_music_data_index;
 static uint16_t m_channel;
 static uint16_t m_block_size;
 static uint32_t m_sampling_rate;
-static uint8_t m_wk_wavfile_buff[FILE_READ_BUFF_SIZE];
+/* period buffer, words so that GetNextData can convert in place */
+static uint32_t m_wk_wavfile_buff[FILE_READ_BUFF_SIZE / sizeof(uint32_t)];
 
 /******************************************************************************
  Exported global variables and functions (to be accessed by other files)
@@ -932,8 +935,9 @@ static bool_t AnalyzeHeader(uint8_t * p_title, uint8_t * p_artist, uint8_t * p_a
 
 /*******************************************************************************
  * Function Name: GetNextData
- * Description  : Index through wave file
- * @param void*     buf     : data buffer address
+ * Description  : Index through wave file. The samples are read into the tail
+ *                of buf and expanded in place to left justified 32 bit stereo
+ * @param void*     buf     : data buffer address, word aligned
  * @param size_t    len     : data buffer length
  * @return get data size
 
@@ -941,57 +945,28 @@ static bool_t AnalyzeHeader(uint8_t * p_title, uint8_t * p_artist, uint8_t * p_a
 
 static size_t GetNextData(void *buf, size_t len) {
     size_t ret;
+    uint32_t frame_bytes;
+    uint32_t src_offset;
+    uint32_t read_len;
+
+    frame_bytes = r_audio_convert_src_frame_bytes(m_block_size, m_channel);
+    if (0 == frame_bytes) {
+        // format the SSIF can not play
+        return 0;
+    }
 
-    if (m_block_size == 24) {
-        // 24 Bit word contains 16 bit data + 8 bit padding
-        // Add padding
-        int write_index = 0;
-        int wavfile_index;
-        int read_len;
-        int pading_index = 0;
-        uint8_t * p_buf = (uint8_t *)buf;
+    read_len = (len / AUDIO_CONVERT_DST_FRAME_BYTES) * frame_bytes;
+    if ((m_music_data_index + read_len) > m_music_data_size) {
+        read_len = m_music_data_size - m_music_data_index;
+    }
 
+    // source sits at the end of buf so the conversion only writes over data already consumed
+    src_offset = r_audio_convert_src_offset(m_block_size, m_channel, len);
+    f_read( m_wav_fp, (uint8_t *)buf + src_offset, read_len, &ret );
+    m_music_data_index += ret;
 
-        if ((m_music_data_index + len) > m_music_data_size) {
-            len = m_music_data_size - m_music_data_index;
-        }
-        while (write_index < len) {
-            read_len = (len - write_index) * 3 / 4;
-            if (read_len > sizeof(m_wk_wavfile_buff)) {
-                read_len = sizeof(m_wk_wavfile_buff);
-            }
-            m_music_data_index += read_len;
-            f_read( m_wav_fp, m_wk_wavfile_buff, read_len, &ret );
-            if (ret < read_len) {
-                break;
-            }
-            wavfile_index = 0;
-            while ((write_index < len) && (wavfile_index < read_len)) {
-                if (pading_index == 0) {
-                    p_buf[write_index] = 0;
-                } else {
-                    p_buf[write_index] = m_wk_wavfile_buff[wavfile_index];
-                    wavfile_index++;
-                }
-                if (pading_index < 3) {
-                    pading_index++;
-                } else {
-                    pading_index = 0;
-                }
-                write_index++;
-            }
-        }
-
-        return write_index;
-    } else {
-        // 16 bit word no padding
-        if ((m_music_data_index + len) > m_music_data_size) {
-            len = m_music_data_size - m_music_data_index;
-        }
-        m_music_data_index += len;
-        f_read( m_wav_fp, buf, (int)len, &ret );
-        return ret;
-    }
+    return r_audio_convert_to_s32_stereo((uint32_t *)buf, (uint8_t *)buf + src_offset, m_block_size, m_channel,
+            ret / frame_bytes);
 };
 
 /**************************************************************************//**
@@ -0,0 +1,142 @@
+/*******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this
+ * software, you agree to the additional terms and conditions found by
+ * accessing the following link:
+ * http://www.renesas.com/disclaimer
+*******************************************************************************
+* Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *****************************************************************************/
+/******************************************************************************
+ * @headerfile     r_audio_convert.h
+ * @brief          PCM sample format conversion into the SSIF 32 bit slot format
+ * @version        1.00
+ * @date           27.06.2018
+ * H/W Platform    RZ/A1LU
+ *****************************************************************************/
+ /*****************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 30.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/* Multiple inclusion prevention macro */
+#ifndef RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_CONVERT_H_
+#define RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_CONVERT_H_
+
+/**************************************************************************//**
+ * @ingroup R_SW_PKG_93_SOUND_APP
+ * @defgroup R_SW_PKG_93_SOUND_CONVERT Audio Format Conversion
+ * @brief Converts little endian PCM into left justified 32 bit stereo words.
+ *
+ * The SSIF runs 24 bit data in a 32 bit system word, so every sample is
+ * written MSB aligned with the unused low bits cleared. The kernels work a
+ * word at a time and only ever write forward of what they read, which lets
+ * the source be read into the tail of the destination period buffer and
+ * expanded in place (see r_audio_convert_src_offset).
+ * @{
+ *****************************************************************************/
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+#include <stddef.h>
+#include "r_typedefs.h"
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+/** Bytes of one output frame, left and right 32 bit slots */
+#define AUDIO_CONVERT_DST_FRAME_BYTES   (8u)
+
+/******************************************************************************
+Public Functions
+******************************************************************************/
+/**
+ * @brief Bytes of one source frame
+ * @param bits : source bits per sample, 16, 24 or 32
+ * @param channels : source channels, 1 or 2
+ * @return frame size in bytes, 0 for an unsupported format
+ */
+uint32_t r_audio_convert_src_frame_bytes (uint16_t bits, uint16_t channels);
+
+/**
+ * @brief Offset into a destination buffer of dst_len bytes at which the
+ *        source for the same number of frames can be placed for in place
+ *        conversion
+ * @param bits : source bits per sample
+ * @param channels : source channels
+ * @param dst_len : destination buffer size in bytes, multiple of AUDIO_CONVERT_DST_FRAME_BYTES
+ * @return byte offset, word aligned for every supported format
+ */
+uint32_t r_audio_convert_src_offset (uint16_t bits, uint16_t channels, uint32_t dst_len);
+
+/**
+ * @brief Convert frames to left justified 32 bit stereo
+ * @param p_dst : word aligned destination, frames * AUDIO_CONVERT_DST_FRAME_BYTES bytes
+ * @param p_src : word aligned source, may lie inside p_dst at r_audio_convert_src_offset or later
+ * @param bits : source bits per sample, 16, 24 or 32
+ * @param channels : source channels, mono is duplicated to both slots
+ * @param frames : frames to convert
+ * @return bytes written to p_dst, 0 for an unsupported format
+ */
+uint32_t r_audio_convert_to_s32_stereo (uint32_t *p_dst, const void *p_src, uint16_t bits, uint16_t channels,
+        uint32_t frames);
+
+/**
+ * @brief 16 bit to left justified 32 bit
+ * @param p_dst : destination, samples words
+ * @param p_src : word aligned source
+ * @param samples : sample count
+ */
+void r_audio_convert_s16_to_s32 (uint32_t *p_dst, const uint32_t *p_src, uint32_t samples);
+
+/**
+ * @brief Packed 24 bit to left justified 32 bit
+ * @param p_dst : destination, samples words
+ * @param p_src : word aligned source
+ * @param samples : sample count
+ */
+void r_audio_convert_s24_to_s32 (uint32_t *p_dst, const uint32_t *p_src, uint32_t samples);
+
+/**
+ * @brief Mono 16 bit to left justified 32 bit stereo
+ * @param p_dst : destination, frames * 2 words
+ * @param p_src : word aligned source
+ * @param frames : frame count
+ */
+void r_audio_convert_s16_mono_to_s32_stereo (uint32_t *p_dst, const uint32_t *p_src, uint32_t frames);
+
+/**
+ * @brief Mono packed 24 bit to left justified 32 bit stereo
+ * @param p_dst : destination, frames * 2 words
+ * @param p_src : word aligned source
+ * @param frames : frame count
+ */
+void r_audio_convert_s24_mono_to_s32_stereo (uint32_t *p_dst, const uint32_t *p_src, uint32_t frames);
+
+/**
+ * @brief Mono 32 bit to 32 bit stereo
+ * @param p_dst : destination, frames * 2 words
+ * @param p_src : word aligned source
+ * @param frames : frame count
+ */
+void r_audio_convert_s32_mono_to_s32_stereo (uint32_t *p_dst, const uint32_t *p_src, uint32_t frames);
+
+#endif /* RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_CONVERT_H_ */
+/**************************************************************************//**
+ * @} (end addtogroup)
+ *****************************************************************************/
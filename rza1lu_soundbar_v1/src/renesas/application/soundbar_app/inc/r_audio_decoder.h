@@ -0,0 +1,188 @@
+/*******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this
+ * software, you agree to the additional terms and conditions found by
+ * accessing the following link:
+ * http://www.renesas.com/disclaimer
+*******************************************************************************
+* Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *****************************************************************************/
+/******************************************************************************
+ * @headerfile     r_audio_decoder.h
+ * @brief          Audio decoder interface and byte source abstraction
+ * @version        1.00
+ * @date           27.06.2018
+ * H/W Platform    RZ/A1LU
+ *****************************************************************************/
+ /*****************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 30.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/* Multiple inclusion prevention macro */
+#ifndef RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_DECODER_H_
+#define RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_DECODER_H_
+
+/**************************************************************************//**
+ * @ingroup R_SW_PKG_93_SOUND_APP
+ * @defgroup R_SW_PKG_93_SOUND_DECODER Audio Decoder
+ * @brief Decodes WAV, AIFF and FLAC into SSIF periods.
+ *
+ * Decoders read through an st_audio_source_t, so the same decoder runs on
+ * the prefetching file stream during playback and on a plain FatFs file
+ * for benchmarking. Every decoder writes left justified 32 bit stereo
+ * frames, the format r_audio_convert produces for the SSIF.
+ * @{
+ *****************************************************************************/
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+#include <stddef.h>
+#include "r_typedefs.h"
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+/** Bytes read from the source to select a decoder */
+#define AUDIO_DECODER_PROBE_BYTES   (12u)
+
+/******************************************************************************
+Typedefs
+******************************************************************************/
+/** Byte source a decoder reads from */
+typedef struct
+{
+    size_t   (*read)(void *p_context, void *p_buf, size_t len); /*!< returns bytes read, 0 at the end */
+    bool_t   (*seek)(void *p_context, uint32_t offset);         /*!< absolute byte offset */
+    uint32_t size;                                              /*!< total bytes in the source */
+    void     *p_context;
+} st_audio_source_t;
+
+/** Stream format as stored in the file */
+typedef struct
+{
+    uint32_t sample_rate;
+    uint16_t bits_per_sample;
+    uint16_t channels;
+    uint32_t total_frames;      /*!< 0 if unknown */
+} st_audio_format_t;
+
+struct st_audio_decoder;
+typedef struct st_audio_decoder *p_audio_decoder_t;
+
+/** Decoder implementation */
+typedef struct
+{
+    const char_t *p_name;
+
+    /** true if the first AUDIO_DECODER_PROBE_BYTES bytes belong to this format */
+    bool_t   (*probe)(const uint8_t *p_header);
+
+    /** parse the header, the probe bytes have already been consumed from the source */
+    int32_t  (*open)(p_audio_decoder_t p_dec, const uint8_t *p_header);
+
+    /** decode up to frames frames of 32 bit stereo into p_period, returns frames written */
+    uint32_t (*decode)(p_audio_decoder_t p_dec, uint32_t *p_period, uint32_t frames);
+
+    /** continue decoding from frame */
+    int32_t  (*seek)(p_audio_decoder_t p_dec, uint32_t frame);
+
+    /** release everything allocated by open */
+    void     (*close)(p_audio_decoder_t p_dec);
+} st_audio_decoder_ops_t;
+
+/** Decoder instance */
+typedef struct st_audio_decoder
+{
+    const st_audio_decoder_ops_t *p_ops;
+    st_audio_source_t source;
+    st_audio_format_t format;
+    void     *p_private;        /*!< decoder state */
+    uint32_t offset;            /*!< source bytes consumed */
+    uint32_t position;          /*!< frames decoded since open or the last seek */
+    uint32_t ram_bytes;         /*!< memory held through r_audio_decoder_alloc */
+    uint32_t peak_ram_bytes;    /*!< high water mark of ram_bytes */
+} st_audio_decoder_t;
+
+/******************************************************************************
+Public Functions
+******************************************************************************/
+/**
+ * @brief Probe the source and open the matching decoder
+ * @param p_dec : decoder instance to initialise
+ * @param p_source : source positioned at the start of the file
+ * @return DEVDRV_SUCCESS or DEVDRV_ERROR if no decoder accepts the stream
+ */
+int32_t r_audio_decoder_open (p_audio_decoder_t p_dec, const st_audio_source_t *p_source);
+
+/**
+ * @brief Format of the open stream
+ * @param p_dec : decoder
+ * @param p_format : destination
+ */
+void r_audio_decoder_get_format (p_audio_decoder_t p_dec, st_audio_format_t *p_format);
+
+/**
+ * @brief Decode into a period buffer
+ * @param p_dec : decoder
+ * @param p_period : word aligned period, frames * 8 bytes
+ * @param frames : frames wanted
+ * @return frames written, fewer than wanted only at the end of the stream
+ */
+uint32_t r_audio_decoder_decode (p_audio_decoder_t p_dec, uint32_t *p_period, uint32_t frames);
+
+/**
+ * @brief Continue decoding from a frame
+ * @param p_dec : decoder
+ * @param frame : frame index from the start of the stream
+ * @return DEVDRV_SUCCESS or DEVDRV_ERROR
+ */
+int32_t r_audio_decoder_seek (p_audio_decoder_t p_dec, uint32_t frame);
+
+/**
+ * @brief Close the decoder and release its memory
+ * @param p_dec : decoder
+ */
+void r_audio_decoder_close (p_audio_decoder_t p_dec);
+
+/* Helpers for decoder implementations */
+
+/** Allocate decoder memory and account for it in ram_bytes / peak_ram_bytes */
+void *r_audio_decoder_alloc (p_audio_decoder_t p_dec, uint32_t size);
+
+/** Free memory from r_audio_decoder_alloc */
+void r_audio_decoder_free (p_audio_decoder_t p_dec, void *p_mem, uint32_t size);
+
+/** Read from the source, tracking the offset */
+size_t r_audio_decoder_read (p_audio_decoder_t p_dec, void *p_buf, size_t len);
+
+/** Skip forward, short gaps are read through so the prefetch is not restarted */
+bool_t r_audio_decoder_skip (p_audio_decoder_t p_dec, uint32_t len);
+
+/** Reposition the source */
+bool_t r_audio_decoder_seek_source (p_audio_decoder_t p_dec, uint32_t offset);
+
+/* Decoders available to r_audio_decoder_open */
+extern const st_audio_decoder_ops_t g_audio_decoder_wav;
+extern const st_audio_decoder_ops_t g_audio_decoder_aiff;
+extern const st_audio_decoder_ops_t g_audio_decoder_flac;
+
+#endif /* RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_DECODER_H_ */
+/**************************************************************************//**
+ * @} (end addtogroup)
+ *****************************************************************************/
@@ -0,0 +1,174 @@
+/*******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this
+ * software, you agree to the additional terms and conditions found by
+ * accessing the following link:
+ * http://www.renesas.com/disclaimer
+*******************************************************************************
+* Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *****************************************************************************/
+/******************************************************************************
+ * @headerfile     r_audio_dsp.h
+ * @brief          Fixed point equaliser, crossover and limiter for SSIF periods
+ * @version        1.00
+ * @date           27.06.2018
+ * H/W Platform    RZ/A1LU
+ *****************************************************************************/
+ /*****************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 30.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/* Multiple inclusion prevention macro */
+#ifndef RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_DSP_H_
+#define RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_DSP_H_
+
+/**************************************************************************//**
+ * @ingroup R_SW_PKG_93_SOUND_APP
+ * @defgroup R_SW_PKG_93_SOUND_DSP Audio DSP Chain
+ * @brief Optional processing applied to each period before it reaches the
+ *        SSIF.
+ *
+ * The chain is a cascade of parametric biquads, a 4th order Linkwitz-Riley
+ * 2-way crossover and a stereo linked look-ahead peak limiter. Samples stay
+ * Q31 throughout, coefficients are Q28 and every multiply accumulates in 64
+ * bits. Each stage runs over the whole period before the next starts.
+ *
+ * The chain is reconfigured from any task: coefficients are calculated by
+ * the caller and handed over at the start of the next period, so the audio
+ * path never waits for a configuration change.
+ * @{
+ *****************************************************************************/
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+#include "r_typedefs.h"
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+/** Parametric equaliser bands */
+#define AUDIO_DSP_EQ_BANDS              (5u)
+
+/** Limiter look-ahead, also the latency the limiter adds (1.45 ms at 44.1 kHz) */
+#define AUDIO_DSP_LOOKAHEAD_FRAMES      (64u)
+
+/** Largest boost or cut of an equaliser band */
+#define AUDIO_DSP_EQ_GAIN_MAX_DB        (15.0f)
+
+/******************************************************************************
+Typedefs
+******************************************************************************/
+/** Equaliser band response */
+typedef enum
+{
+    AUDIO_DSP_FILTER_OFF = 0,
+    AUDIO_DSP_FILTER_PEAK,
+    AUDIO_DSP_FILTER_LOW_SHELF,
+    AUDIO_DSP_FILTER_HIGH_SHELF,
+    AUDIO_DSP_FILTER_LOW_PASS,
+    AUDIO_DSP_FILTER_HIGH_PASS,
+    AUDIO_DSP_FILTER_COUNT
+} e_audio_dsp_filter_t;
+
+/** One equaliser band */
+typedef struct
+{
+    e_audio_dsp_filter_t type;
+    float    freq_hz;           /*!< centre or corner frequency */
+    float    gain_db;           /*!< peak and shelf only */
+    float    q;                 /*!< bandwidth, 0.707 for a Butterworth pass filter */
+} st_audio_dsp_band_t;
+
+/** Chain settings */
+typedef struct
+{
+    bool_t   enable;                            /*!< false bypasses the whole chain */
+    st_audio_dsp_band_t eq[AUDIO_DSP_EQ_BANDS];
+    bool_t   crossover_enable;                  /*!< low band to the left slot, high band to the right slot */
+    float    crossover_hz;
+    bool_t   limiter_enable;
+    float    limiter_threshold_db;              /*!< ceiling relative to full scale, 0 or below */
+    float    limiter_release_ms;                /*!< time constant of the gain recovery */
+} st_audio_dsp_config_t;
+
+struct st_audio_dsp;
+typedef struct st_audio_dsp *p_audio_dsp_t;
+
+/******************************************************************************
+Public Functions
+******************************************************************************/
+/**
+ * @brief Create a chain, bypassed until configured
+ * @param sample_rate : rate of the periods that will be processed
+ * @return the chain, NULL if memory ran out
+ */
+p_audio_dsp_t r_audio_dsp_create (uint32_t sample_rate);
+
+/**
+ * @brief Free the chain
+ * @param p_dsp : chain, may be NULL
+ */
+void r_audio_dsp_destroy (p_audio_dsp_t p_dsp);
+
+/**
+ * @brief Clear the filter and look-ahead history, for the start of a new stream
+ * @param p_dsp : chain
+ */
+void r_audio_dsp_reset (p_audio_dsp_t p_dsp);
+
+/**
+ * @brief Fill a configuration with the bypassed defaults
+ * @param p_config : destination
+ */
+void r_audio_dsp_default_config (st_audio_dsp_config_t *p_config);
+
+/**
+ * @brief Validate a configuration and queue it for the next period
+ * @param p_dsp : chain
+ * @param p_config : new settings
+ * @return DEVDRV_SUCCESS or DEVDRV_ERROR if a setting is out of range
+ */
+int32_t r_audio_dsp_configure (p_audio_dsp_t p_dsp, const st_audio_dsp_config_t *p_config);
+
+/**
+ * @brief Read the last configuration accepted by r_audio_dsp_configure
+ * @param p_dsp : chain
+ * @param p_config : destination
+ */
+void r_audio_dsp_get_config (p_audio_dsp_t p_dsp, st_audio_dsp_config_t *p_config);
+
+/**
+ * @brief Process one period in place
+ * @param p_dsp : chain
+ * @param p_period : left justified 32 bit stereo frames
+ * @param frames : frames in the period
+ */
+void r_audio_dsp_process (p_audio_dsp_t p_dsp, uint32_t *p_period, uint32_t frames);
+
+/**
+ * @brief Name of an equaliser band type for console output
+ * @param type : band type
+ * @return "off", "peak", "lowshelf", "highshelf", "lowpass" or "highpass"
+ */
+const char_t *r_audio_dsp_filter_name (e_audio_dsp_filter_t type);
+
+#endif /* RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_DSP_H_ */
+/**************************************************************************//**
+ * @} (end addtogroup)
+ *****************************************************************************/
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this
+ * software, you agree to the additional terms and conditions found by
+ * accessing the following link:
+ * http://www.renesas.com/disclaimer
+*******************************************************************************
+* Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *****************************************************************************/
+/******************************************************************************
+ * @headerfile     r_audio_gain.h
+ * @brief          dB to Q23 gain conversion without floating point
+ * @version        1.00
+ * @date           27.06.2018
+ * H/W Platform    RZ/A1LU
+ *****************************************************************************/
+ /*****************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 30.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/* Multiple inclusion prevention macro */
+#ifndef RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_GAIN_H_
+#define RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_GAIN_H_
+
+/**************************************************************************//**
+ * @ingroup R_SW_PKG_93_SOUND_APP
+ * @defgroup R_SW_PKG_93_SOUND_GAIN Gain Table
+ * @brief Linear Q23 gains for attenuations of 0 to -100 dB in quarter dB
+ *        steps, the format of the DAE volume registers.
+ *
+ * The table is constant data, so a volume change is a lookup rather than
+ * a call to pow().
+ * @{
+ *****************************************************************************/
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+#include "r_typedefs.h"
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+/** Table resolution */
+#define AUDIO_GAIN_STEPS_PER_DB     (4)
+
+/** Quietest gain in the table, anything lower is clamped to it */
+#define AUDIO_GAIN_MIN_DB           (-100)
+
+/** Unity gain in Q23 */
+#define AUDIO_GAIN_Q23_ONE          (0x00800000L)
+
+/** Convert whole dB to table steps */
+#define AUDIO_GAIN_DB_TO_STEPS(db)  ((db) * AUDIO_GAIN_STEPS_PER_DB)
+
+/******************************************************************************
+Public Functions
+******************************************************************************/
+/**
+ * @brief Look up a gain
+ * @param steps : attenuation in quarter dB, 0 to AUDIO_GAIN_DB_TO_STEPS(AUDIO_GAIN_MIN_DB)
+ * @return 10^(dB/20) in Q23, clamped to the table
+ */
+int32_t r_audio_gain_q23 (int32_t steps);
+
+#endif /* RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_GAIN_H_ */
+/**************************************************************************//**
+ * @} (end addtogroup)
+ *****************************************************************************/
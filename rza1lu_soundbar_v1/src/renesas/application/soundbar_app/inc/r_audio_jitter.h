@@ -0,0 +1,177 @@
+/*******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this
+ * software, you agree to the additional terms and conditions found by
+ * accessing the following link:
+ * http://www.renesas.com/disclaimer
+*******************************************************************************
+* Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *****************************************************************************/
+/******************************************************************************
+ * @headerfile     r_audio_jitter.h
+ * @brief          Adaptive jitter buffer for packetised PCM
+ * @version        1.00
+ * @date           27.06.2018
+ * H/W Platform    RZ/A1LU
+ *****************************************************************************/
+ /*****************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 30.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/* Multiple inclusion prevention macro */
+#ifndef RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_JITTER_H_
+#define RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_JITTER_H_
+
+/**************************************************************************//**
+ * @ingroup R_SW_PKG_93_SOUND_APP
+ * @defgroup R_SW_PKG_93_SOUND_JITTER Jitter Buffer
+ * @brief Reorders sequence numbered PCM packets and plays them out at a
+ *        steady rate.
+ *
+ * Packets are stored by sequence number and held back until the buffered
+ * audio reaches a target delay derived from the measured interarrival
+ * jitter (RFC 3550). A missing packet is concealed by repeating the last
+ * one at falling gain; running dry fades out, rebuffers and raises the
+ * target so the next burst is absorbed. The buffered depth is averaged
+ * against the target to give a rate trim in ppm, which the consumer feeds
+ * to a variable rate resampler to follow the sender's clock.
+ *
+ * Payloads are big endian 16 or 24 bit PCM, mono or stereo, and are
+ * played out as left justified 32 bit stereo frames. Arrival times are in
+ * counts of a free running timer, the caller gives its rate.
+ * @{
+ *****************************************************************************/
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+#include "r_typedefs.h"
+#include "r_audio_decoder.h"
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+/** Packets held, a power of two. Bounds the delay to this many packet times */
+#define AUDIO_JITTER_SLOTS          (128u)
+
+/** Largest payload stored, an Ethernet MTU less the IP, UDP and RTP headers */
+#define AUDIO_JITTER_MAX_PAYLOAD    (1460u)
+
+/******************************************************************************
+Typedefs
+******************************************************************************/
+/** Jitter buffer settings */
+typedef struct
+{
+    st_audio_format_t format;   /*!< payload format, total_frames is ignored */
+    uint32_t min_delay_ms;      /*!< lower bound of the playout delay */
+    uint32_t max_delay_ms;      /*!< upper bound, packets beyond it are dropped */
+    uint32_t counts_per_us;     /*!< rate of the timer the arrival and playout times are taken from */
+} st_audio_jitter_config_t;
+
+/** Jitter buffer statistics, counters run from creation or the last reset */
+typedef struct
+{
+    uint32_t packets;           /*!< packets stored */
+    uint32_t late;              /*!< packets that arrived after their playout time */
+    uint32_t duplicates;        /*!< packets received twice */
+    uint32_t overflows;         /*!< packets dropped because the buffer was over its maximum delay */
+    uint32_t lost;              /*!< packets concealed */
+    uint32_t underruns;         /*!< times the buffer ran dry and rebuffered */
+    uint32_t resyncs;           /*!< stream restarts, a new SSRC or a jump in the sequence */
+    uint32_t jitter_us;         /*!< interarrival jitter */
+    uint32_t target_us;         /*!< playout delay being aimed for */
+    uint32_t depth_us;          /*!< audio buffered */
+    int32_t  trim_ppm;          /*!< rate correction handed to the resampler */
+    uint32_t latency_samples;   /*!< packets the latency was measured on */
+    uint32_t min_latency_us;    /*!< shortest arrival to playout time */
+    uint32_t max_latency_us;    /*!< longest arrival to playout time */
+    uint64_t total_latency_us;  /*!< sum of arrival to playout times, divide by latency_samples for the mean */
+} st_audio_jitter_stats_t;
+
+struct st_audio_jitter;
+typedef struct st_audio_jitter *p_audio_jitter_t;
+
+/******************************************************************************
+Public Functions
+******************************************************************************/
+/**
+ * @brief Allocate a jitter buffer
+ * @param p_config : settings
+ * @return the buffer, NULL if memory ran out or the format is not 16 or 24 bit mono or stereo
+ */
+p_audio_jitter_t r_audio_jitter_create (const st_audio_jitter_config_t *p_config);
+
+/**
+ * @brief Free the buffer
+ * @param p_jb : buffer, may be NULL
+ */
+void r_audio_jitter_destroy (p_audio_jitter_t p_jb);
+
+/**
+ * @brief Drop every packet and wait for a new stream
+ * @param p_jb : buffer
+ */
+void r_audio_jitter_reset (p_audio_jitter_t p_jb);
+
+/**
+ * @brief Store a received packet
+ * @param p_jb : buffer
+ * @param seq : RTP sequence number
+ * @param timestamp : RTP timestamp of the first frame
+ * @param ssrc : RTP synchronisation source, a change restarts the stream
+ * @param p_payload : PCM payload
+ * @param bytes : payload length, trailing partial frames are ignored
+ * @param arrival : timer count when the packet was received
+ */
+void r_audio_jitter_put (p_audio_jitter_t p_jb, uint16_t seq, uint32_t timestamp, uint32_t ssrc,
+        const uint8_t *p_payload, uint32_t bytes, uint32_t arrival);
+
+/**
+ * @brief Play out frames, always fills the request with audio, concealment or silence
+ * @param p_jb : buffer
+ * @param p_frames : destination, left justified 32 bit stereo
+ * @param frames : frames wanted
+ * @param playout : timer count at which the first frame will be heard, used for the latency statistics
+ */
+void r_audio_jitter_get (p_audio_jitter_t p_jb, uint32_t *p_frames, uint32_t frames, uint32_t playout);
+
+/**
+ * @brief Rate correction that keeps the buffer at its target delay
+ * @param p_jb : buffer
+ * @return ppm, positive when the sender runs fast and input has to be consumed faster
+ */
+int32_t r_audio_jitter_get_trim (p_audio_jitter_t p_jb);
+
+/**
+ * @brief Read the statistics
+ * @param p_jb : buffer
+ * @param p_stats : destination
+ */
+void r_audio_jitter_get_stats (p_audio_jitter_t p_jb, st_audio_jitter_stats_t *p_stats);
+
+/**
+ * @brief Clear the counters and latency figures, the jitter estimate and target are kept
+ * @param p_jb : buffer
+ */
+void r_audio_jitter_reset_stats (p_audio_jitter_t p_jb);
+
+#endif /* RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_JITTER_H_ */
+/**************************************************************************//**
+ * @} (end addtogroup)
+ *****************************************************************************/
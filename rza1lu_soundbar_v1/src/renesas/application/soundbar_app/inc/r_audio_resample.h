@@ -0,0 +1,155 @@
+/*******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this
+ * software, you agree to the additional terms and conditions found by
+ * accessing the following link:
+ * http://www.renesas.com/disclaimer
+*******************************************************************************
+* Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *****************************************************************************/
+/******************************************************************************
+ * @headerfile     r_audio_resample.h
+ * @brief          Fixed point polyphase sample rate converter
+ * @version        1.00
+ * @date           27.06.2018
+ * H/W Platform    RZ/A1LU
+ *****************************************************************************/
+ /*****************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 30.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/* Multiple inclusion prevention macro */
+#ifndef RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_RESAMPLE_H_
+#define RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_RESAMPLE_H_
+
+/**************************************************************************//**
+ * @ingroup R_SW_PKG_93_SOUND_APP
+ * @defgroup R_SW_PKG_93_SOUND_RESAMPLE Sample Rate Converter
+ * @brief Converts 32 bit stereo periods from any input rate to the fixed
+ *        rate the SSIF and codec run at.
+ *
+ * A Kaiser windowed sinc is tabulated in 2^phase_bits phases and the output
+ * is interpolated linearly between the two nearest phases, so any rate
+ * ratio works without reconfiguring the codec. The input position advances
+ * in 32.32 fixed point, the filter runs on 32 bit samples with 64 bit
+ * accumulators. Equal rates are passed through untouched unless the ratio
+ * is to be trimmed to follow a drifting source clock.
+ * @{
+ *****************************************************************************/
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+#include "r_typedefs.h"
+
+/******************************************************************************
+Typedefs
+******************************************************************************/
+/** Filter length / stop band trade off, cost grows with the tap count */
+typedef enum
+{
+    AUDIO_RESAMPLE_QUALITY_LOW = 0,     /*!< 8 taps, 64 phases */
+    AUDIO_RESAMPLE_QUALITY_MEDIUM,      /*!< 16 taps, 128 phases */
+    AUDIO_RESAMPLE_QUALITY_HIGH,        /*!< 32 taps, 256 phases */
+    AUDIO_RESAMPLE_QUALITY_COUNT
+} e_audio_resample_quality_t;
+
+struct st_audio_resampler;
+typedef struct st_audio_resampler *p_audio_resampler_t;
+
+/******************************************************************************
+Public Functions
+******************************************************************************/
+/**
+ * @brief Build the filter table for a rate pair
+ * @param in_rate : input sample rate
+ * @param out_rate : output sample rate
+ * @param quality : filter quality
+ * @return the resampler, NULL if memory ran out or a rate is 0
+ */
+p_audio_resampler_t r_audio_resample_create (uint32_t in_rate, uint32_t out_rate, e_audio_resample_quality_t quality);
+
+/**
+ * @brief Build the filter table for a rate pair whose ratio is trimmed while
+ *        running, equal rates are filtered rather than passed through
+ * @param in_rate : nominal input sample rate
+ * @param out_rate : output sample rate
+ * @param quality : filter quality
+ * @return the resampler, NULL if memory ran out or a rate is 0
+ */
+p_audio_resampler_t r_audio_resample_create_variable (uint32_t in_rate, uint32_t out_rate,
+        e_audio_resample_quality_t quality);
+
+/**
+ * @brief Adjust the conversion ratio to follow a source clock that drifts
+ * @param p_rs : resampler from r_audio_resample_create_variable
+ * @param ppm : correction in parts per million, positive consumes input faster
+ */
+void r_audio_resample_set_trim (p_audio_resampler_t p_rs, int32_t ppm);
+
+/**
+ * @brief Free the resampler
+ * @param p_rs : resampler, may be NULL
+ */
+void r_audio_resample_destroy (p_audio_resampler_t p_rs);
+
+/**
+ * @brief Clear the filter history, the next input frame starts a new stream
+ * @param p_rs : resampler
+ */
+void r_audio_resample_reset (p_audio_resampler_t p_rs);
+
+/**
+ * @brief Resample interleaved left justified 32 bit stereo
+ * @param p_rs : resampler
+ * @param p_in : input frames
+ * @param in_frames : input frames available
+ * @param p_in_used : returns the input frames consumed
+ * @param p_out : output frames
+ * @param out_frames : output space in frames
+ * @return output frames written, stops when either the input or the output runs out
+ */
+uint32_t r_audio_resample_process (p_audio_resampler_t p_rs, const uint32_t *p_in, uint32_t in_frames,
+        uint32_t *p_in_used, uint32_t *p_out, uint32_t out_frames);
+
+/**
+ * @brief Input frames held in the filter before the first output, this many
+ *        frames of silence flush the end of a stream out
+ * @param p_rs : resampler
+ * @return delay in input frames, 0 when passing through
+ */
+uint32_t r_audio_resample_get_delay (p_audio_resampler_t p_rs);
+
+/**
+ * @brief Bytes allocated for the filter table and history
+ * @param p_rs : resampler
+ * @return bytes
+ */
+uint32_t r_audio_resample_get_ram (p_audio_resampler_t p_rs);
+
+/**
+ * @brief Name of a quality mode for console output
+ * @param quality : quality mode
+ * @return "low", "medium" or "high"
+ */
+const char_t *r_audio_resample_quality_name (e_audio_resample_quality_t quality);
+
+#endif /* RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_RESAMPLE_H_ */
+/**************************************************************************//**
+ * @} (end addtogroup)
+ *****************************************************************************/
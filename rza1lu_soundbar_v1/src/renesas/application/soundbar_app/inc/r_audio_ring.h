@@ -0,0 +1,188 @@
+/*******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this
+ * software, you agree to the additional terms and conditions found by
+ * accessing the following link:
+ * http://www.renesas.com/disclaimer
+*******************************************************************************
+* Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *****************************************************************************/
+/******************************************************************************
+ * @headerfile     r_audio_ring.h
+ * @brief          Single producer / single consumer ring of DMA periods
+ * @version        1.00
+ * @date           27.06.2018
+ * H/W Platform    RZ/A1LU
+ *****************************************************************************/
+ /*****************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 30.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/* Multiple inclusion prevention macro */
+#ifndef RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_RING_H_
+#define RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_RING_H_
+
+/**************************************************************************//**
+ * @ingroup R_SW_PKG_93_SOUND_APP
+ * @defgroup R_SW_PKG_93_SOUND_RING Audio Period Ring
+ * @brief Lock free ring of DMA aligned audio periods.
+ *
+ * A period moves through three states, each owned by one side only:
+ * free -> filled (producer, r_audio_ring_commit_write) -> queued to the
+ * DMA (consumer, r_audio_ring_commit_read) -> free again (consumer,
+ * r_audio_ring_release, normally called from the SSIF DMA end callback).
+ * Every index is written by exactly one context so no locks are needed.
+ * @{
+ *****************************************************************************/
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+#include "r_typedefs.h"
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+/** Alignment of every period, required by the DMA controller */
+#define AUDIO_RING_ALIGN_BYTES      (32u)
+
+/******************************************************************************
+Typedefs
+******************************************************************************/
+struct st_audio_ring;
+
+/** Watermark callback, the low watermark callback runs in interrupt context */
+typedef void (*audio_ring_watermark_cb_t)(struct st_audio_ring *p_ring, void *p_context);
+
+/** Ring configuration */
+typedef struct
+{
+    uint32_t period_count;              /*!< number of periods in the ring */
+    uint32_t period_size;               /*!< bytes per period, rounded up to AUDIO_RING_ALIGN_BYTES */
+    uint32_t high_watermark;            /*!< filled periods at which high_callback runs */
+    uint32_t low_watermark;             /*!< filled periods at which low_callback runs */
+    audio_ring_watermark_cb_t high_callback;    /*!< called by the producer, may be NULL */
+    audio_ring_watermark_cb_t low_callback;     /*!< called by the consumer, may be NULL */
+    void     *p_context;                /*!< passed to both callbacks */
+} st_audio_ring_config_t;
+
+/** Ring instance, treat as opaque */
+typedef struct st_audio_ring
+{
+    st_audio_ring_config_t config;
+    void     *p_allocation;             /* block returned by R_OS_AllocMem */
+    uint8_t  *p_periods;                /* aligned period storage */
+    uint32_t *p_lengths;                /* valid bytes in each period */
+
+    volatile uint32_t write_index;      /* written by the producer only */
+    volatile uint32_t read_index;       /* written by the consumer only, periods handed to the DMA */
+    volatile uint32_t release_index;    /* written by the consumer only, periods the DMA has finished */
+
+    volatile uint32_t underruns;        /* consumer found the ring empty */
+    volatile uint32_t overruns;         /* producer found the ring full */
+} st_audio_ring_t;
+
+typedef st_audio_ring_t *p_audio_ring_t;
+
+/******************************************************************************
+Public Functions
+******************************************************************************/
+/**
+ * @brief Allocate a ring and its DMA aligned period storage
+ * @param p_config : ring geometry and watermark callbacks
+ * @return the ring, NULL if the configuration is invalid or memory ran out
+ */
+p_audio_ring_t r_audio_ring_create (const st_audio_ring_config_t *p_config);
+
+/**
+ * @brief Free a ring created with r_audio_ring_create
+ * @param p_ring : ring to free
+ */
+void r_audio_ring_destroy (p_audio_ring_t p_ring);
+
+/**
+ * @brief Empty the ring, only valid while no period is queued to the DMA
+ * @param p_ring : ring to empty
+ */
+void r_audio_ring_reset (p_audio_ring_t p_ring);
+
+/**
+ * @brief Producer: get the next free period
+ * @param p_ring : ring
+ * @return period buffer of config.period_size bytes, NULL when the ring is full
+ */
+uint8_t *r_audio_ring_get_write_period (p_audio_ring_t p_ring);
+
+/**
+ * @brief Producer: publish the period returned by r_audio_ring_get_write_period
+ * @param p_ring : ring
+ * @param length : valid bytes in the period
+ */
+void r_audio_ring_commit_write (p_audio_ring_t p_ring, uint32_t length);
+
+/**
+ * @brief Consumer: get the oldest filled period not yet handed to the DMA
+ * @param p_ring : ring
+ * @param p_length : receives the valid bytes in the period
+ * @return period buffer, NULL when no filled period is available
+ */
+uint8_t *r_audio_ring_get_read_period (p_audio_ring_t p_ring, uint32_t *p_length);
+
+/**
+ * @brief Consumer: mark the period returned by r_audio_ring_get_read_period as queued
+ * @param p_ring : ring
+ */
+void r_audio_ring_commit_read (p_audio_ring_t p_ring);
+
+/**
+ * @brief Consumer: return the oldest queued period to the producer, ISR safe
+ * @param p_ring : ring
+ */
+void r_audio_ring_release (p_audio_ring_t p_ring);
+
+/**
+ * @brief Number of periods holding data (filled or queued to the DMA)
+ * @param p_ring : ring
+ * @return filled period count
+ */
+uint32_t r_audio_ring_filled (p_audio_ring_t p_ring);
+
+/**
+ * @brief Number of periods the producer can fill
+ * @param p_ring : ring
+ * @return free period count
+ */
+uint32_t r_audio_ring_free (p_audio_ring_t p_ring);
+
+/**
+ * @brief Number of filled periods waiting to be handed to the DMA
+ * @param p_ring : ring
+ * @return readable period count
+ */
+uint32_t r_audio_ring_readable (p_audio_ring_t p_ring);
+
+/**
+ * @brief Consumer: record that the DMA had to be fed while the ring was empty
+ * @param p_ring : ring
+ */
+void r_audio_ring_note_underrun (p_audio_ring_t p_ring);
+
+#endif /* RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_RING_H_ */
+/**************************************************************************//**
+ * @} (end addtogroup)
+ *****************************************************************************/
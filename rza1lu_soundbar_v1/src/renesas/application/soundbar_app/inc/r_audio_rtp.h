@@ -0,0 +1,159 @@
+/*******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this
+ * software, you agree to the additional terms and conditions found by
+ * accessing the following link:
+ * http://www.renesas.com/disclaimer
+*******************************************************************************
+* Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *****************************************************************************/
+/******************************************************************************
+ * @headerfile     r_audio_rtp.h
+ * @brief          RTP/UDP linear PCM receiver
+ * @version        1.00
+ * @date           27.06.2018
+ * H/W Platform    RZ/A1LU
+ *****************************************************************************/
+ /*****************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 30.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/* Multiple inclusion prevention macro */
+#ifndef RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_RTP_H_
+#define RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_RTP_H_
+
+/**************************************************************************//**
+ * @ingroup R_SW_PKG_93_SOUND_APP
+ * @defgroup R_SW_PKG_93_SOUND_RTP Network Audio Receiver
+ * @brief Receives an RTP L16 or L24 stream (RFC 3551, RFC 3190) on a UDP
+ *        port and plays it out through a jitter buffer.
+ *
+ * A receive task owns the socket, time stamps each datagram on arrival
+ * and passes the payload to the jitter buffer. The audio side pulls
+ * periods with r_audio_rtp_read and follows the sender's clock by feeding
+ * r_audio_rtp_get_trim to a variable rate resampler. Only built when the
+ * Ethernet middleware is, see R_SELF_LOAD_MIDDLEWARE_ETHERNET_MODULES.
+ * @{
+ *****************************************************************************/
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+#include "r_typedefs.h"
+#include "r_audio_decoder.h"
+#include "r_audio_jitter.h"
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+/** Default UDP port, the RTP/AVP convention */
+#define AUDIO_RTP_DEFAULT_PORT      (5004u)
+
+/** Static payload type for L16 44.1 kHz stereo */
+#define AUDIO_RTP_PT_L16_STEREO     (10u)
+
+/** Static payload type for L16 44.1 kHz mono */
+#define AUDIO_RTP_PT_L16_MONO       (11u)
+
+/******************************************************************************
+Typedefs
+******************************************************************************/
+/** Receiver settings */
+typedef struct
+{
+    uint16_t port;              /*!< UDP port to listen on */
+    uint8_t  payload_type;      /*!< payload type accepted, packets of any other type are dropped */
+    st_audio_format_t format;   /*!< format of a dynamic payload type, set from the static types 10 and 11 */
+    uint32_t min_delay_ms;      /*!< lower bound of the jitter buffer delay */
+    uint32_t max_delay_ms;      /*!< upper bound of the jitter buffer delay */
+} st_audio_rtp_config_t;
+
+/** Receiver statistics */
+typedef struct
+{
+    uint32_t datagrams;         /*!< datagrams received on the port */
+    uint32_t invalid;           /*!< too short, not version 2 or with a bad padding length */
+    uint32_t wrong_type;        /*!< payload type other than the one configured */
+    st_audio_jitter_stats_t jitter;     /*!< jitter buffer, including latency and underruns */
+} st_audio_rtp_stats_t;
+
+struct st_audio_rtp;
+typedef struct st_audio_rtp *p_audio_rtp_t;
+
+/******************************************************************************
+Public Functions
+******************************************************************************/
+/**
+ * @brief Settings for L16 44.1 kHz stereo on AUDIO_RTP_DEFAULT_PORT
+ * @param p_config : destination
+ */
+void r_audio_rtp_default_config (st_audio_rtp_config_t *p_config);
+
+/**
+ * @brief Bind the port and start the receive task
+ * @param p_config : settings
+ * @return the receiver, NULL if the port could not be bound, memory ran out or the format is not supported
+ */
+p_audio_rtp_t r_audio_rtp_create (const st_audio_rtp_config_t *p_config);
+
+/**
+ * @brief Stop the receive task, close the port and free the receiver
+ * @param p_rtp : receiver, may be NULL
+ */
+void r_audio_rtp_destroy (p_audio_rtp_t p_rtp);
+
+/**
+ * @brief Format the stream is played out at before conversion to 32 bit stereo
+ * @param p_rtp : receiver
+ * @param p_format : destination
+ */
+void r_audio_rtp_get_format (p_audio_rtp_t p_rtp, st_audio_format_t *p_format);
+
+/**
+ * @brief Play out frames from the jitter buffer, always fills the request
+ * @param p_rtp : receiver
+ * @param p_frames : destination, left justified 32 bit stereo at the stream rate
+ * @param frames : frames wanted
+ * @param playout : OSTM1 count at which the first frame will be heard
+ */
+void r_audio_rtp_read (p_audio_rtp_t p_rtp, uint32_t *p_frames, uint32_t frames, uint32_t playout);
+
+/**
+ * @brief Rate correction that follows the sender's clock
+ * @param p_rtp : receiver
+ * @return ppm for r_audio_resample_set_trim
+ */
+int32_t r_audio_rtp_get_trim (p_audio_rtp_t p_rtp);
+
+/**
+ * @brief Read the receiver and jitter buffer statistics
+ * @param p_rtp : receiver
+ * @param p_stats : destination
+ */
+void r_audio_rtp_get_stats (p_audio_rtp_t p_rtp, st_audio_rtp_stats_t *p_stats);
+
+/**
+ * @brief Clear the receiver and jitter buffer counters
+ * @param p_rtp : receiver
+ */
+void r_audio_rtp_reset_stats (p_audio_rtp_t p_rtp);
+
+#endif /* RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_RTP_H_ */
+/**************************************************************************//**
+ * @} (end addtogroup)
+ *****************************************************************************/
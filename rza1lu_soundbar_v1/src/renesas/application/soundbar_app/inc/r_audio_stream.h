@@ -0,0 +1,140 @@
+/*******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this
+ * software, you agree to the additional terms and conditions found by
+ * accessing the following link:
+ * http://www.renesas.com/disclaimer
+*******************************************************************************
+* Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *****************************************************************************/
+/******************************************************************************
+ * @headerfile     r_audio_stream.h
+ * @brief          Streaming file source with a read-ahead prefetch task
+ * @version        1.00
+ * @date           27.06.2018
+ * H/W Platform    RZ/A1LU
+ *****************************************************************************/
+ /*****************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 30.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/* Multiple inclusion prevention macro */
+#ifndef RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_STREAM_H_
+#define RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_STREAM_H_
+
+/**************************************************************************//**
+ * @ingroup R_SW_PKG_93_SOUND_APP
+ * @defgroup R_SW_PKG_93_SOUND_STREAM Audio File Stream
+ * @brief Reads a file region ahead of the playhead in large chunks.
+ *
+ * A prefetch task owns the FIL while the stream is running and keeps a
+ * queue of AUDIO_STREAM_CHUNK_BYTES buffers filled, reading on chunk
+ * aligned file offsets so no read straddles a cluster boundary it does not
+ * have to. The audio side copies out of the queue with
+ * r_audio_stream_read and never touches FatFs itself.
+ * @{
+ *****************************************************************************/
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+#include <stddef.h>
+#include "r_typedefs.h"
+#include "ff.h"
+#include "r_audio_decoder.h"
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+/** Size of each prefetch read, a power of two at least as large as a cluster
+ *  on the drives in use so that aligned chunks never split a cluster */
+#define AUDIO_STREAM_CHUNK_BYTES    (32u * 1024u)
+
+/** Number of chunk buffers queued ahead of the playhead */
+#define AUDIO_STREAM_CHUNK_COUNT    (4u)
+
+/******************************************************************************
+Typedefs
+******************************************************************************/
+/** Stream statistics, counters run from r_audio_stream_create */
+typedef struct
+{
+    uint32_t fill_bytes;        /*!< bytes read ahead of the playhead */
+    uint32_t capacity_bytes;    /*!< size of the prefetch queue */
+    uint32_t underruns;         /*!< reads that had to wait for the prefetch task */
+    uint32_t chunks_read;       /*!< f_read calls issued by the prefetch task */
+    uint32_t max_read_us;       /*!< longest single f_read */
+    uint32_t read_errors;       /*!< f_read calls that failed */
+} st_audio_stream_stats_t;
+
+struct st_audio_stream;
+typedef struct st_audio_stream *p_audio_stream_t;
+
+/******************************************************************************
+Public Functions
+******************************************************************************/
+/**
+ * @brief Allocate the prefetch queue and create the prefetch task
+ * @param p_task_name : name of the prefetch task
+ * @return the stream, NULL if memory ran out
+ */
+p_audio_stream_t r_audio_stream_create (const char_t *p_task_name);
+
+/**
+ * @brief Start streaming a region of a file, the prefetch task owns fp until r_audio_stream_stop
+ * @param p_stream : stream
+ * @param fp : open file
+ * @param offset : file offset of the first byte
+ * @param length : bytes to stream
+ */
+void r_audio_stream_start (p_audio_stream_t p_stream, FIL *fp, uint32_t offset, uint32_t length);
+
+/**
+ * @brief Stop the prefetch task and discard buffered data, fp may be used again on return
+ * @param p_stream : stream
+ */
+void r_audio_stream_stop (p_audio_stream_t p_stream);
+
+/**
+ * @brief Copy the next bytes of the region, waits for the prefetch task if the queue is empty
+ * @param p_stream : stream
+ * @param p_buf : destination
+ * @param len : bytes wanted
+ * @return bytes copied, less than len only at the end of the region or on a read error
+ */
+size_t r_audio_stream_read (p_audio_stream_t p_stream, void *p_buf, size_t len);
+
+/**
+ * @brief Stream a whole file and expose it as a decoder source, seeking restarts the prefetch at the new offset
+ * @param p_stream : stream
+ * @param fp : open file, owned by the stream until r_audio_stream_stop
+ * @param p_source : filled in with the stream source
+ */
+void r_audio_stream_init_source (p_audio_stream_t p_stream, FIL *fp, st_audio_source_t *p_source);
+
+/**
+ * @brief Read the stream statistics
+ * @param p_stream : stream
+ * @param p_stats : destination
+ */
+void r_audio_stream_get_stats (p_audio_stream_t p_stream, st_audio_stream_stats_t *p_stats);
+
+#endif /* RENESAS_APPLICATION_APP_SOUND_INC_R_AUDIO_STREAM_H_ */
+/**************************************************************************//**
+ * @} (end addtogroup)
+ *****************************************************************************/
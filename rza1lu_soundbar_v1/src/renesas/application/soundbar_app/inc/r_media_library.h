@@ -0,0 +1,167 @@
+/*******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this
+ * software, you agree to the additional terms and conditions found by
+ * accessing the following link:
+ * http://www.renesas.com/disclaimer
+*******************************************************************************
+* Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *****************************************************************************/
+/******************************************************************************
+ * @headerfile     r_media_library.h
+ * @brief          Index of the audio files on the mounted drives
+ * @version        1.00
+ * @date           02.07.2018
+ * H/W Platform    RZ/A1LU
+ *****************************************************************************/
+ /*****************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 02.07.2018 1.00 First Release
+ *****************************************************************************/
+
+/* Multiple inclusion prevention macro */
+#ifndef RENESAS_APPLICATION_APP_SOUND_INC_R_MEDIA_LIBRARY_H_
+#define RENESAS_APPLICATION_APP_SOUND_INC_R_MEDIA_LIBRARY_H_
+
+/**************************************************************************//**
+ * @ingroup R_SW_PKG_93_SOUND_APP
+ * @defgroup R_SW_PKG_93_SOUND_LIBRARY Media Library
+ * @brief Keeps the format and tags of every playable file on each drive.
+ *
+ * The disk manager reports each drive as it is mounted and a low priority
+ * task scans it. The index is saved on the drive in MEDIA_LIBRARY_FILE_NAME
+ * and loaded first the next time the drive is inserted, so it can be
+ * queried straight away while the drive is checked for changes.
+ *
+ * A rescan lists every directory but only opens files in directories whose
+ * audio files have changed name, size or date since the index was written.
+ * Queries copy out of the published index under a mutex and never touch
+ * the drive.
+ * @{
+ *****************************************************************************/
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+#include "r_typedefs.h"
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+/** Index file in the root directory of each drive */
+#define MEDIA_LIBRARY_FILE_NAME         "MEDIALIB.IDX"
+
+/** Longest path returned, including the drive */
+#define MEDIA_LIBRARY_MAX_PATH          (260u)
+
+/** Longest tag kept, including the terminator */
+#define MEDIA_LIBRARY_MAX_TAG           (64u)
+
+/** Formats, combined as a mask for r_media_library_find */
+#define MEDIA_LIBRARY_FORMAT_WAV        (1u << 0)
+#define MEDIA_LIBRARY_FORMAT_AIFF       (1u << 1)
+#define MEDIA_LIBRARY_FORMAT_FLAC       (1u << 2)
+#define MEDIA_LIBRARY_FORMAT_ALL        (MEDIA_LIBRARY_FORMAT_WAV | MEDIA_LIBRARY_FORMAT_AIFF \
+                                        | MEDIA_LIBRARY_FORMAT_FLAC)
+
+/******************************************************************************
+Typedefs
+******************************************************************************/
+/** One track, tags are empty strings when the file has none */
+typedef struct
+{
+    char_t   path[MEDIA_LIBRARY_MAX_PATH];  /*!< "A:/dir/file.wav" */
+    char_t   title[MEDIA_LIBRARY_MAX_TAG];
+    char_t   artist[MEDIA_LIBRARY_MAX_TAG];
+    char_t   album[MEDIA_LIBRARY_MAX_TAG];
+    uint32_t size;                          /*!< file size in bytes */
+    uint32_t date;                          /*!< FAT date and time of the file */
+    uint32_t sample_rate;
+    uint32_t duration_ms;                   /*!< 0 if unknown */
+    uint16_t bits_per_sample;
+    uint8_t  channels;
+    uint8_t  format;                        /*!< one of MEDIA_LIBRARY_FORMAT_x */
+} st_media_track_t;
+
+/** State of the index of one drive */
+typedef struct
+{
+    bool_t   ready;             /*!< an index can be queried */
+    bool_t   scanning;          /*!< the drive is being checked for changes */
+    uint32_t generation;        /*!< advanced each time a new index is published */
+    uint32_t dirs;              /*!< directories in the index */
+    uint32_t tracks;            /*!< tracks in the index */
+    uint32_t bytes;             /*!< RAM held by the index */
+    uint32_t files_parsed;      /*!< files opened by the last scan */
+    uint32_t dirs_reused;       /*!< directories the last scan took from the previous index */
+    uint32_t scan_ms;           /*!< duration of the last scan */
+    bool_t   loaded;            /*!< the last scan started from MEDIA_LIBRARY_FILE_NAME */
+    bool_t   saved;             /*!< the last scan wrote MEDIA_LIBRARY_FILE_NAME */
+} st_media_library_status_t;
+
+/******************************************************************************
+Public Functions
+******************************************************************************/
+/**
+ * @brief Create the scan task and register with the disk manager, call before
+ *        the first dskMountAllDevices. Calling again has no effect.
+ */
+void r_media_library_init (void);
+
+/**
+ * @brief Ask the scan task to check a drive for changes
+ * @param drive : drive letter
+ */
+void r_media_library_rescan (char_t drive);
+
+/**
+ * @brief Read the state of the index of a drive
+ * @param drive : drive letter
+ * @param p_status : destination
+ */
+void r_media_library_get_status (char_t drive, st_media_library_status_t *p_status);
+
+/**
+ * @brief Number of tracks in the index of a drive
+ * @param drive : drive letter
+ * @return tracks, 0 if the drive has no index yet
+ */
+uint32_t r_media_library_get_count (char_t drive);
+
+/**
+ * @brief Copy a track out of the index, tracks are in directory order
+ * @param drive : drive letter
+ * @param index : 0 to r_media_library_get_count - 1
+ * @param p_track : destination
+ * @return DEVDRV_SUCCESS or DEVDRV_ERROR if there is no such track
+ */
+int32_t r_media_library_get_track (char_t drive, uint32_t index, st_media_track_t *p_track);
+
+/**
+ * @brief Find the next track that matches
+ * @param drive : drive letter
+ * @param p_text : case insensitive text looked for in the file name and tags, NULL or "" matches all
+ * @param formats : mask of MEDIA_LIBRARY_FORMAT_x
+ * @param start : first index to look at
+ * @return index of the track, -1 if there are no more
+ */
+int32_t r_media_library_find (char_t drive, const char_t *p_text, uint32_t formats, uint32_t start);
+
+#endif /* RENESAS_APPLICATION_APP_SOUND_INC_R_MEDIA_LIBRARY_H_ */
+/**************************************************************************//**
+ * @} (end addtogroup)
+ *****************************************************************************/
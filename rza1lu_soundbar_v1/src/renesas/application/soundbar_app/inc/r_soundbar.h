@@ -56,10 +56,68 @@ User Includes
 #include "r_task_priority.h"
 
 #include "ff.h"
+#include "r_audio_stream.h"
+#include "r_audio_resample.h"
+#include "r_audio_dsp.h"
+#include "r_audio_rtp.h"
+#include "application_cfg.h"
+#if (R_SELF_INSERT_APP_USB_AUDIO)
+#include "r_usb_audio.h"
+#endif
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+/** Most periods that can be kept queued to the SSIF, see r_soundtst_SetQueueDepth */
+#define SOUND_SSIF_QUEUE_DEPTH_MAX  (6u)
+
+/** Source formats counted separately by r_soundtst_GetPlayStats */
+#define SOUND_PLAY_STATS_FORMATS    (8u)
 
 /******************************************************************************
 Typedefs
 ******************************************************************************/
+/** Wake-up latency of the record/playback task, measured from the SSIF DMA
+ *  completion interrupt to the task servicing the period */
+typedef struct
+{
+    uint32_t wakeups;           /*!< number of times the task was woken */
+    uint32_t periods;           /*!< DMA periods (rx + tx) serviced */
+    uint32_t late_wakeups;      /*!< wake-ups that found more than one period per direction pending */
+    uint32_t min_latency_us;    /*!< shortest completion to wake-up time */
+    uint32_t max_latency_us;    /*!< longest completion to wake-up time */
+    uint64_t total_latency_us;  /*!< sum of completion to wake-up times, divide by wakeups for the mean */
+} st_sound_period_stats_t;
+
+/** Playhead of the playlist, follows the frames the SSIF has played */
+typedef struct
+{
+    bool_t   playing;           /*!< a track from the playlist or r_soundtst_LoadSample is playing */
+    uint32_t track;             /*!< playlist entry being heard */
+    uint32_t position_ms;       /*!< position in that entry */
+    uint32_t duration_ms;       /*!< length of that entry, 0 if the decoder does not know */
+    uint32_t sample_rate;       /*!< rate of the file, converted to r_soundtst_GetOutputRate */
+    uint32_t bits_per_sample;   /*!< sample size of the file */
+    uint32_t transitions;       /*!< tracks started without stopping the SSIF since playback started */
+} st_sound_position_t;
+
+/** File playback counters for one source format */
+typedef struct
+{
+    uint32_t sample_rate;       /*!< rate of the file */
+    uint32_t bits_per_sample;   /*!< sample size of the file */
+    uint32_t periods;           /*!< SSIF periods played */
+    uint32_t underruns;         /*!< times the SSIF drained before the play task queued more */
+    uint32_t min_queued;        /*!< fewest periods left queued to the SSIF when the play task woke */
+} st_sound_format_stats_t;
+
+/** File playback counters, by source format in the order they were first played */
+typedef struct
+{
+    uint32_t queue_depth;       /*!< periods kept queued to the SSIF */
+    uint32_t formats;           /*!< entries used in format */
+    st_sound_format_stats_t format[SOUND_PLAY_STATS_FORMATS];
+} st_sound_play_stats_t;
 
 /******************************************************************************
 Constant Data
@@ -88,6 +146,76 @@ void r_soundtst_StopSample(void);
 void r_soundtst_IsDone(void);
 int r_soundtst_LoadSample (FIL* fp );
 
+/**
+ * @brief Add a file to the end of the playlist, the next entry is opened and
+ *        buffered while the one before it plays so tracks follow without a gap
+ * @param p_path : file, copied
+ * @return index of the entry, DEVDRV_ERROR if the playlist is full or not initialised
+ */
+int32_t r_soundtst_PlaylistAdd (const char_t *p_path);
+
+/**
+ * @brief Empty the playlist, the tracks already opened play to their end
+ */
+void r_soundtst_PlaylistClear (void);
+
+/**
+ * @brief Number of entries in the playlist
+ * @return entries
+ */
+uint32_t r_soundtst_PlaylistGetCount (void);
+
+/**
+ * @brief Copy the path of a playlist entry
+ * @param index : entry
+ * @param p_path : destination
+ * @param size : bytes at p_path
+ * @return DEVDRV_SUCCESS, DEVDRV_ERROR if there is no such entry
+ */
+int32_t r_soundtst_PlaylistGetPath (uint32_t index, char_t *p_path, uint32_t size);
+
+/**
+ * @brief Play the playlist from an entry, jumps there if it is already playing
+ * @param index : entry, 0 plays the r_soundtst_LoadSample file when the playlist is empty
+ * @param position_ms : position in the entry
+ * @return DEVDRV_SUCCESS, DEVDRV_ERROR if there is no such entry or another source is playing
+ */
+int32_t r_soundtst_PlaylistPlay (uint32_t index, uint32_t position_ms);
+
+/**
+ * @brief Stop the playlist
+ */
+void r_soundtst_PlaylistStop (void);
+
+/**
+ * @brief Move the playhead within the track being heard
+ * @param position_ms : position in the track
+ * @return DEVDRV_SUCCESS, DEVDRV_ERROR if nothing is playing
+ */
+int32_t r_soundtst_Seek (uint32_t position_ms);
+
+/**
+ * @brief Read the playhead
+ * @param p_position : destination
+ */
+void r_soundtst_GetPosition (st_sound_position_t *p_position);
+
+/**
+ * @brief Poll the position event, set every 250ms of playback and when the
+ *        track changes, playback starts or it stops
+ * @param p_position : destination for the playhead, may be NULL
+ * @return true if the event was set since the last call
+ */
+bool_t r_soundtst_PositionChanged (st_sound_position_t *p_position);
+
+/**
+ * @brief Wait for the position event
+ * @param p_position : destination for the playhead, may be NULL
+ * @param timeout_ms : longest wait
+ * @return true if the event was set, false on time out
+ */
+bool_t r_soundtst_WaitPosition (st_sound_position_t *p_position, uint32_t timeout_ms);
+
 /**
  * @brief Run the record/playback Sound application
  * @param p_in : Standard input from console.
@@ -95,8 +223,125 @@ int r_soundtst_LoadSample (FIL* fp );
  */
 void r_soundtst_PlayBack_init( void );
 
+/**
+ * @brief Read the per period wake-up latency of the record/playback task
+ * @param p_stats : destination for a copy of the statistics
+ */
+void r_soundtst_GetPeriodStats (st_sound_period_stats_t *p_stats);
+
+/**
+ * @brief Clear the per period wake-up latency statistics
+ */
+void r_soundtst_ResetPeriodStats (void);
+
+/**
+ * @brief Read the fill level and underrun counters of the wave file prefetch
+ * @param p_stats : destination, zeroed if playback has not been initialised
+ */
+void r_soundtst_GetStreamStats (st_audio_stream_stats_t *p_stats);
+
+/**
+ * @brief Set how many periods are kept queued to the SSIF during file playback
+ * @param depth : 1 to SOUND_SSIF_QUEUE_DEPTH_MAX
+ * @return DEVDRV_SUCCESS, DEVDRV_ERROR if out of range
+ */
+int32_t r_soundtst_SetQueueDepth (uint32_t depth);
+
+/**
+ * @brief Read how many periods are kept queued to the SSIF
+ * @return periods
+ */
+uint32_t r_soundtst_GetQueueDepth (void);
+
+/**
+ * @brief Read the file playback underruns and SSIF queue headroom by source format
+ * @param p_stats : destination
+ */
+void r_soundtst_GetPlayStats (st_sound_play_stats_t *p_stats);
+
+/**
+ * @brief Clear the file playback counters
+ */
+void r_soundtst_ResetPlayStats (void);
+
+/**
+ * @brief Select the sample rate converter quality, used from the next track
+ * @param quality : quality mode
+ */
+void r_soundtst_SetResampleQuality (e_audio_resample_quality_t quality);
+
+/**
+ * @brief Read the sample rate converter quality
+ * @return quality mode
+ */
+e_audio_resample_quality_t r_soundtst_GetResampleQuality (void);
+
+/**
+ * @brief Rate the SSIF and codec run at, every source is converted to it
+ * @return sample rate in Hz
+ */
+uint32_t r_soundtst_GetOutputRate (void);
+
+/**
+ * @brief Reconfigure the equaliser, crossover and limiter applied to file playback
+ * @param p_config : settings, applied from the next period
+ * @return DEVDRV_SUCCESS, DEVDRV_ERROR if out of range or playback has not been initialised
+ */
+int32_t r_soundtst_SetDspConfig (const st_audio_dsp_config_t *p_config);
+
+/**
+ * @brief Read the playback DSP settings
+ * @param p_config : destination
+ */
+void r_soundtst_GetDspConfig (st_audio_dsp_config_t *p_config);
+
+/**
+ * @brief Play an RTP L16 stream received on a UDP port instead of the loaded file
+ * @param port : UDP port, 0 for AUDIO_RTP_DEFAULT_PORT
+ * @return DEVDRV_SUCCESS, DEVDRV_ERROR if playback is not initialised or busy, or the network is not available
+ */
+int32_t r_soundtst_StartNetwork (uint16_t port);
+
+/**
+ * @brief Stop the network stream and close the port
+ */
+void r_soundtst_StopNetwork (void);
+
+/**
+ * @brief Read the network receiver statistics, end to end latency and underruns
+ * @param p_stats : destination
+ * @return DEVDRV_SUCCESS, DEVDRV_ERROR if the receiver is not running
+ */
+int32_t r_soundtst_GetNetworkStats (st_audio_rtp_stats_t *p_stats);
+
+/**
+ * @brief Clear the network receiver statistics
+ */
+void r_soundtst_ResetNetworkStats (void);
+
+/**
+ * @brief Play the stream from a USB host on the USB audio function instead of the loaded file
+ * @return DEVDRV_SUCCESS, DEVDRV_ERROR if playback is not initialised or busy, or USB audio is not available
+ */
+int32_t r_soundtst_StartUsb (void);
+
+/**
+ * @brief Stop the USB stream and detach from the bus
+ */
+void r_soundtst_StopUsb (void);
+
+#if (R_SELF_INSERT_APP_USB_AUDIO)
+/**
+ * @brief Read the USB stream counters and the latency of the audio buffered in the play ring
+ * @param p_stats : destination
+ * @param p_latency_us : buffered audio in microseconds, may be NULL
+ * @return DEVDRV_SUCCESS, DEVDRV_ERROR if USB audio is not running
+ */
+int32_t r_soundtst_GetUsbStats (st_usbf_audio_stats_t *p_stats, uint32_t *p_latency_us);
+#endif
+
 // Switch Controls
-void r_sound_init_controls ( void );
+void r_sound_init_controls ( bool_t enble_interrupts );
 void r_sound_control_select_audio_input ( void );
 
 #endif /* RENESAS_APPLICATION_APP_SOUND_INC_r_soundtst_H_ */
@@ -0,0 +1,353 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ ******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.  */
+/******************************************************************************
+ * File Name    : r_audio_convert.c
+ * Device(s)    : RZ/A1L
+ * Tool-Chain   : GNUARM-NONE-EABI-v16.01
+ * H/W Platform : Stream it! v2 board
+ * Description  : PCM sample format conversion into the SSIF 32 bit slot format
+ ******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 13.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ *****************************************************************************/
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+#include <string.h>
+
+#include "r_typedefs.h"
+#include "r_audio_convert.h"
+
+/*
+ * All kernels assume a little endian core, as the RZ/A1 runs. Each one loads a whole source block into registers
+ * before storing, and never stores past the next unread source byte when the source sits at
+ * r_audio_convert_src_offset inside the destination.
+ */
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_convert_src_frame_bytes
+ * Description  : Bytes of one source frame
+ * Arguments    : uint16_t bits - bits per sample
+ *                uint16_t channels - channel count
+ * Return Value : frame size, 0 if the format is not supported
+ **********************************************************************************************************************/
+uint32_t r_audio_convert_src_frame_bytes (uint16_t bits, uint16_t channels)
+{
+    if (((16u != bits) && (24u != bits) && (32u != bits)) || (0u == channels) || (channels > 2u))
+    {
+        return (0u);
+    }
+
+    return ((uint32_t) (bits / 8u) * channels);
+}
+/***********************************************************************************************************************
+ End of function r_audio_convert_src_frame_bytes
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_convert_src_offset
+ * Description  : Offset at which to read the source so it ends with the destination buffer
+ * Arguments    : uint16_t bits - bits per sample
+ *                uint16_t channels - channel count
+ *                uint32_t dst_len - destination size in bytes
+ * Return Value : byte offset into the destination
+ **********************************************************************************************************************/
+uint32_t r_audio_convert_src_offset (uint16_t bits, uint16_t channels, uint32_t dst_len)
+{
+    uint32_t frames = dst_len / AUDIO_CONVERT_DST_FRAME_BYTES;
+
+    return (dst_len - (frames * r_audio_convert_src_frame_bytes(bits, channels)));
+}
+/***********************************************************************************************************************
+ End of function r_audio_convert_src_offset
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_convert_to_s32_stereo
+ * Description  : Selects the kernel for the source format
+ * Arguments    : uint32_t *p_dst - destination
+ *                const void *p_src - source
+ *                uint16_t bits - bits per sample
+ *                uint16_t channels - channel count
+ *                uint32_t frames - frames to convert
+ * Return Value : bytes written, 0 if the format is not supported
+ **********************************************************************************************************************/
+uint32_t r_audio_convert_to_s32_stereo (uint32_t *p_dst, const void *p_src, uint16_t bits, uint16_t channels,
+        uint32_t frames)
+{
+    const uint32_t *p_words = (const uint32_t *) p_src;
+
+    if (0u == r_audio_convert_src_frame_bytes(bits, channels))
+    {
+        return (0u);
+    }
+
+    if (2u == channels)
+    {
+        switch (bits)
+        {
+            case 16:
+            {
+                r_audio_convert_s16_to_s32(p_dst, p_words, frames * 2u);
+                break;
+            }
+            case 24:
+            {
+                r_audio_convert_s24_to_s32(p_dst, p_words, frames * 2u);
+                break;
+            }
+            default:
+            {
+                /* already in slot format */
+                if ((const void *) p_dst != p_src)
+                {
+                    memmove(p_dst, p_src, frames * AUDIO_CONVERT_DST_FRAME_BYTES);
+                }
+                break;
+            }
+        }
+    }
+    else
+    {
+        switch (bits)
+        {
+            case 16:
+            {
+                r_audio_convert_s16_mono_to_s32_stereo(p_dst, p_words, frames);
+                break;
+            }
+            case 24:
+            {
+                r_audio_convert_s24_mono_to_s32_stereo(p_dst, p_words, frames);
+                break;
+            }
+            default:
+            {
+                r_audio_convert_s32_mono_to_s32_stereo(p_dst, p_words, frames);
+                break;
+            }
+        }
+    }
+
+    return (frames * AUDIO_CONVERT_DST_FRAME_BYTES);
+}
+/***********************************************************************************************************************
+ End of function r_audio_convert_to_s32_stereo
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_convert_s16_to_s32
+ * Description  : Two samples per source word, each shifted into the top half of a slot
+ * Arguments    : uint32_t *p_dst - destination
+ *                const uint32_t *p_src - source
+ *                uint32_t samples - sample count
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_convert_s16_to_s32 (uint32_t *p_dst, const uint32_t *p_src, uint32_t samples)
+{
+    uint32_t word;
+    uint32_t pairs = samples >> 1;
+
+    while (pairs--)
+    {
+        word = *p_src++;
+        p_dst[0] = word << 16;
+        p_dst[1] = word & 0xFFFF0000u;
+        p_dst += 2;
+    }
+
+    if (0u != (samples & 1u))
+    {
+        *p_dst = ((uint32_t) *(const uint16_t *) p_src) << 16;
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_convert_s16_to_s32
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_convert_s24_to_s32
+ * Description  : Four packed samples are held in three source words, each is shifted up by one byte
+ * Arguments    : uint32_t *p_dst - destination
+ *                const uint32_t *p_src - source
+ *                uint32_t samples - sample count
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_convert_s24_to_s32 (uint32_t *p_dst, const uint32_t *p_src, uint32_t samples)
+{
+    uint32_t w0;
+    uint32_t w1;
+    uint32_t w2;
+    uint32_t quads = samples >> 2;
+    const uint8_t *p_tail;
+
+    while (quads--)
+    {
+        w0 = p_src[0];
+        w1 = p_src[1];
+        w2 = p_src[2];
+        p_src += 3;
+
+        p_dst[0] = w0 << 8;
+        p_dst[1] = ((w0 >> 16) & 0x0000FF00u) | (w1 << 16);
+        p_dst[2] = ((w1 >> 8) & 0x00FFFF00u) | (w2 << 24);
+        p_dst[3] = w2 & 0xFFFFFF00u;
+        p_dst += 4;
+    }
+
+    /* up to three samples left over */
+    p_tail = (const uint8_t *) p_src;
+    samples &= 3u;
+
+    while (samples--)
+    {
+        *p_dst++ = ((uint32_t) p_tail[0] << 8) | ((uint32_t) p_tail[1] << 16) | ((uint32_t) p_tail[2] << 24);
+        p_tail += 3;
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_convert_s24_to_s32
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_convert_s16_mono_to_s32_stereo
+ * Description  : Two mono samples per source word, each written to both slots of its frame
+ * Arguments    : uint32_t *p_dst - destination
+ *                const uint32_t *p_src - source
+ *                uint32_t frames - frame count
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_convert_s16_mono_to_s32_stereo (uint32_t *p_dst, const uint32_t *p_src, uint32_t frames)
+{
+    uint32_t word;
+    uint32_t lo;
+    uint32_t hi;
+    uint32_t pairs = frames >> 1;
+
+    while (pairs--)
+    {
+        word = *p_src++;
+        lo = word << 16;
+        hi = word & 0xFFFF0000u;
+        p_dst[0] = lo;
+        p_dst[1] = lo;
+        p_dst[2] = hi;
+        p_dst[3] = hi;
+        p_dst += 4;
+    }
+
+    if (0u != (frames & 1u))
+    {
+        lo = ((uint32_t) *(const uint16_t *) p_src) << 16;
+        p_dst[0] = lo;
+        p_dst[1] = lo;
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_convert_s16_mono_to_s32_stereo
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_convert_s24_mono_to_s32_stereo
+ * Description  : Four packed mono samples from three source words, each written to both slots of its frame
+ * Arguments    : uint32_t *p_dst - destination
+ *                const uint32_t *p_src - source
+ *                uint32_t frames - frame count
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_convert_s24_mono_to_s32_stereo (uint32_t *p_dst, const uint32_t *p_src, uint32_t frames)
+{
+    uint32_t w0;
+    uint32_t w1;
+    uint32_t w2;
+    uint32_t sample;
+    uint32_t quads = frames >> 2;
+    const uint8_t *p_tail;
+
+    while (quads--)
+    {
+        w0 = p_src[0];
+        w1 = p_src[1];
+        w2 = p_src[2];
+        p_src += 3;
+
+        sample = w0 << 8;
+        p_dst[0] = sample;
+        p_dst[1] = sample;
+        sample = ((w0 >> 16) & 0x0000FF00u) | (w1 << 16);
+        p_dst[2] = sample;
+        p_dst[3] = sample;
+        sample = ((w1 >> 8) & 0x00FFFF00u) | (w2 << 24);
+        p_dst[4] = sample;
+        p_dst[5] = sample;
+        sample = w2 & 0xFFFFFF00u;
+        p_dst[6] = sample;
+        p_dst[7] = sample;
+        p_dst += 8;
+    }
+
+    p_tail = (const uint8_t *) p_src;
+    frames &= 3u;
+
+    while (frames--)
+    {
+        sample = ((uint32_t) p_tail[0] << 8) | ((uint32_t) p_tail[1] << 16) | ((uint32_t) p_tail[2] << 24);
+        p_dst[0] = sample;
+        p_dst[1] = sample;
+        p_dst += 2;
+        p_tail += 3;
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_convert_s24_mono_to_s32_stereo
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_convert_s32_mono_to_s32_stereo
+ * Description  : Each mono word is written to both slots of its frame
+ * Arguments    : uint32_t *p_dst - destination
+ *                const uint32_t *p_src - source
+ *                uint32_t frames - frame count
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_convert_s32_mono_to_s32_stereo (uint32_t *p_dst, const uint32_t *p_src, uint32_t frames)
+{
+    uint32_t sample;
+
+    while (frames--)
+    {
+        sample = *p_src++;
+        p_dst[0] = sample;
+        p_dst[1] = sample;
+        p_dst += 2;
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_convert_s32_mono_to_s32_stereo
+ **********************************************************************************************************************/
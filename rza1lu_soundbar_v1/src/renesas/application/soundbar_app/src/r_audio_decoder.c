@@ -0,0 +1,321 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ ******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.  */
+/******************************************************************************
+ * File Name    : r_audio_decoder.c
+ * Device(s)    : RZ/A1L
+ * Tool-Chain   : GNUARM-NONE-EABI-v16.01
+ * H/W Platform : Stream it! v2 board
+ * Description  : Audio decoder selection and the helpers shared by decoders
+ ******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 13.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ *****************************************************************************/
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+#include <string.h>
+
+#include "r_typedefs.h"
+#include "r_os_abstraction_api.h"
+#include "r_task_priority.h"
+#include "dev_drv.h"
+
+#include "r_audio_decoder.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+/* Gaps up to this size are read through rather than seeking the source */
+#define AUDIO_DECODER_PRV_SKIP_READ_MAX     (4096u)
+
+/******************************************************************************
+ Private global variables and functions
+ ******************************************************************************/
+/* Probed in order, the first decoder that accepts the header is used */
+static const st_audio_decoder_ops_t * const gs_decoders[] =
+{
+    &g_audio_decoder_wav,
+    &g_audio_decoder_aiff,
+    &g_audio_decoder_flac,
+};
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_decoder_open
+ * Description  : Reads the probe bytes and opens the first decoder that recognises them
+ * Arguments    : p_audio_decoder_t p_dec - decoder instance
+ *                const st_audio_source_t *p_source - source at the start of the file
+ * Return Value : DEVDRV_SUCCESS or DEVDRV_ERROR
+ **********************************************************************************************************************/
+int32_t r_audio_decoder_open (p_audio_decoder_t p_dec, const st_audio_source_t *p_source)
+{
+    uint8_t header[AUDIO_DECODER_PROBE_BYTES];
+    uint32_t i;
+
+    memset(p_dec, 0, sizeof(st_audio_decoder_t));
+    p_dec->source = *p_source;
+
+    if (AUDIO_DECODER_PROBE_BYTES != r_audio_decoder_read(p_dec, header, AUDIO_DECODER_PROBE_BYTES))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    for (i = 0u; i < (sizeof(gs_decoders) / sizeof(gs_decoders[0])); i++)
+    {
+        if (false != gs_decoders[i]->probe(header))
+        {
+            p_dec->p_ops = gs_decoders[i];
+
+            if (DEVDRV_SUCCESS == p_dec->p_ops->open(p_dec, header))
+            {
+                return (DEVDRV_SUCCESS);
+            }
+
+            /* recognised but not playable, free whatever open left behind */
+            p_dec->p_ops->close(p_dec);
+            p_dec->p_ops = NULL;
+            break;
+        }
+    }
+
+    return (DEVDRV_ERROR);
+}
+/***********************************************************************************************************************
+ End of function r_audio_decoder_open
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_decoder_get_format
+ * Description  : Copies the stream format
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                st_audio_format_t *p_format - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_decoder_get_format (p_audio_decoder_t p_dec, st_audio_format_t *p_format)
+{
+    *p_format = p_dec->format;
+}
+/***********************************************************************************************************************
+ End of function r_audio_decoder_get_format
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_decoder_decode
+ * Description  : Decodes up to frames frames of 32 bit stereo
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                uint32_t *p_period - destination
+ *                uint32_t frames - frames wanted
+ * Return Value : frames written
+ **********************************************************************************************************************/
+uint32_t r_audio_decoder_decode (p_audio_decoder_t p_dec, uint32_t *p_period, uint32_t frames)
+{
+    uint32_t written;
+
+    if (NULL == p_dec->p_ops)
+    {
+        return (0u);
+    }
+
+    written = p_dec->p_ops->decode(p_dec, p_period, frames);
+    p_dec->position += written;
+
+    return (written);
+}
+/***********************************************************************************************************************
+ End of function r_audio_decoder_decode
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_decoder_seek
+ * Description  : Continues decoding from a frame
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                uint32_t frame - frame index
+ * Return Value : DEVDRV_SUCCESS or DEVDRV_ERROR
+ **********************************************************************************************************************/
+int32_t r_audio_decoder_seek (p_audio_decoder_t p_dec, uint32_t frame)
+{
+    if ((NULL == p_dec->p_ops) || ((0u != p_dec->format.total_frames) && (frame > p_dec->format.total_frames)))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    if (DEVDRV_SUCCESS != p_dec->p_ops->seek(p_dec, frame))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    p_dec->position = frame;
+
+    return (DEVDRV_SUCCESS);
+}
+/***********************************************************************************************************************
+ End of function r_audio_decoder_seek
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_decoder_close
+ * Description  : Closes the decoder, the source is left to the caller
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_decoder_close (p_audio_decoder_t p_dec)
+{
+    if (NULL != p_dec->p_ops)
+    {
+        p_dec->p_ops->close(p_dec);
+        p_dec->p_ops = NULL;
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_decoder_close
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_decoder_alloc
+ * Description  : Allocates decoder memory and records the peak held by the decoder
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                uint32_t size - bytes
+ * Return Value : the memory, NULL if none is left
+ **********************************************************************************************************************/
+void *r_audio_decoder_alloc (p_audio_decoder_t p_dec, uint32_t size)
+{
+    void *p_mem = R_OS_AllocMem(size, R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL != p_mem)
+    {
+        p_dec->ram_bytes += size;
+
+        if (p_dec->ram_bytes > p_dec->peak_ram_bytes)
+        {
+            p_dec->peak_ram_bytes = p_dec->ram_bytes;
+        }
+    }
+
+    return (p_mem);
+}
+/***********************************************************************************************************************
+ End of function r_audio_decoder_alloc
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_decoder_free
+ * Description  : Frees memory from r_audio_decoder_alloc
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                void *p_mem - memory, may be NULL
+ *                uint32_t size - bytes passed to r_audio_decoder_alloc
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_decoder_free (p_audio_decoder_t p_dec, void *p_mem, uint32_t size)
+{
+    if (NULL != p_mem)
+    {
+        R_OS_FreeMem(p_mem);
+        p_dec->ram_bytes -= size;
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_decoder_free
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_decoder_read
+ * Description  : Reads from the source and advances the decoder's offset
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                void *p_buf - destination
+ *                size_t len - bytes wanted
+ * Return Value : bytes read
+ **********************************************************************************************************************/
+size_t r_audio_decoder_read (p_audio_decoder_t p_dec, void *p_buf, size_t len)
+{
+    size_t bytes = p_dec->source.read(p_dec->source.p_context, p_buf, len);
+
+    p_dec->offset += bytes;
+
+    return (bytes);
+}
+/***********************************************************************************************************************
+ End of function r_audio_decoder_read
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_decoder_skip
+ * Description  : Moves the source forward. Short gaps such as LIST chunks are read and dropped, which keeps a
+ *                prefetching source running; longer ones are seeked over.
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                uint32_t len - bytes to skip
+ * Return Value : false if the source ended first
+ **********************************************************************************************************************/
+bool_t r_audio_decoder_skip (p_audio_decoder_t p_dec, uint32_t len)
+{
+    uint8_t scratch[64];
+    size_t count;
+
+    if (len > AUDIO_DECODER_PRV_SKIP_READ_MAX)
+    {
+        return (r_audio_decoder_seek_source(p_dec, p_dec->offset + len));
+    }
+
+    while (0u != len)
+    {
+        count = (len > sizeof(scratch)) ? sizeof(scratch) : len;
+
+        if (count != r_audio_decoder_read(p_dec, scratch, count))
+        {
+            return (false);
+        }
+
+        len -= count;
+    }
+
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function r_audio_decoder_skip
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_decoder_seek_source
+ * Description  : Repositions the source
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                uint32_t offset - byte offset in the source
+ * Return Value : false if the source cannot seek there
+ **********************************************************************************************************************/
+bool_t r_audio_decoder_seek_source (p_audio_decoder_t p_dec, uint32_t offset)
+{
+    if ((offset > p_dec->source.size) || (false == p_dec->source.seek(p_dec->source.p_context, offset)))
+    {
+        return (false);
+    }
+
+    p_dec->offset = offset;
+
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function r_audio_decoder_seek_source
+ **********************************************************************************************************************/
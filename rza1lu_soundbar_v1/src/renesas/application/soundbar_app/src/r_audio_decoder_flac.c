@@ -0,0 +1,1092 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ ******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.  */
+/******************************************************************************
+ * File Name    : r_audio_decoder_flac.c
+ * Device(s)    : RZ/A1L
+ * Tool-Chain   : GNUARM-NONE-EABI-v16.01
+ * H/W Platform : Stream it! v2 board
+ * Description  : FLAC decoder, fixed point, up to 24 bit stereo
+ ******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 13.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ *****************************************************************************/
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+#include <string.h>
+
+#include "r_typedefs.h"
+#include "dev_drv.h"
+
+#include "r_audio_decoder.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+/* Compressed bytes read from the source at a time */
+#define FLAC_PRV_INPUT_BYTES            (4096u)
+
+#define FLAC_PRV_MAX_CHANNELS           (2u)
+#define FLAC_PRV_MAX_BITS_PER_SAMPLE    (24u)
+#define FLAC_PRV_MAX_LPC_ORDER          (32u)
+
+#define FLAC_PRV_BLOCK_STREAMINFO       (0u)
+#define FLAC_PRV_BLOCK_SEEKTABLE        (3u)
+#define FLAC_PRV_STREAMINFO_BYTES       (34u)
+#define FLAC_PRV_SEEKPOINT_BYTES        (18u)
+
+#define FLAC_PRV_CHANNELS_LEFT_SIDE     (8u)
+#define FLAC_PRV_CHANNELS_RIGHT_SIDE    (9u)
+#define FLAC_PRV_CHANNELS_MID_SIDE      (10u)
+
+/******************************************************************************
+ Typedef definitions
+ ******************************************************************************/
+typedef struct
+{
+    uint32_t sample;            /* first sample of the target frame */
+    uint32_t offset;            /* byte offset of the frame from the first frame */
+} st_flac_seekpoint_t;
+
+typedef struct
+{
+    /* bit reader, cache holds cache_bits unread bits in its low end */
+    uint8_t  *p_input;
+    uint32_t input_len;
+    uint32_t input_pos;
+    uint64_t cache;
+    uint32_t cache_bits;
+    bool_t   error;             /* ran out of input or hit a malformed field */
+
+    uint32_t max_block;
+    uint32_t first_frame;       /* source offset of the first frame */
+
+    st_flac_seekpoint_t *p_seek;
+    uint32_t seek_count;
+    uint32_t seek_alloc;
+
+    /* the last decoded block */
+    int32_t  *p_block[FLAC_PRV_MAX_CHANNELS];
+    uint32_t block_size;
+    uint32_t block_pos;
+    uint32_t block_shift;       /* left justifies block samples in a 32 bit slot */
+} st_flac_state_t;
+
+/******************************************************************************
+ Private global variables and functions
+ ******************************************************************************/
+static bool_t flac_probe (const uint8_t *p_header);
+static int32_t flac_open (p_audio_decoder_t p_dec, const uint8_t *p_header);
+static uint32_t flac_decode (p_audio_decoder_t p_dec, uint32_t *p_period, uint32_t frames);
+static int32_t flac_seek (p_audio_decoder_t p_dec, uint32_t frame);
+static void flac_close (p_audio_decoder_t p_dec);
+
+const st_audio_decoder_ops_t g_audio_decoder_flac =
+{
+    "FLAC", &flac_probe, &flac_open, &flac_decode, &flac_seek, &flac_close
+};
+
+/***********************************************************************************************************************
+ * Function Name: br_fill
+ * Description  : Tops the bit cache up from the input buffer, refilling the buffer from the source when it is empty
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                st_flac_state_t *p_st - decoder state
+ * Return Value : false if the source has ended and the cache is empty
+ **********************************************************************************************************************/
+static bool_t br_fill (p_audio_decoder_t p_dec, st_flac_state_t *p_st)
+{
+    if (p_st->input_pos == p_st->input_len)
+    {
+        p_st->input_pos = 0u;
+        p_st->input_len = r_audio_decoder_read(p_dec, p_st->p_input, FLAC_PRV_INPUT_BYTES);
+
+        if (0u == p_st->input_len)
+        {
+            p_st->error = true;
+            return (0u != p_st->cache_bits);
+        }
+    }
+
+    while ((p_st->cache_bits <= 56u) && (p_st->input_pos < p_st->input_len))
+    {
+        p_st->cache = (p_st->cache << 8) | p_st->p_input[p_st->input_pos++];
+        p_st->cache_bits += 8u;
+    }
+
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function br_fill
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: br_get
+ * Description  : Reads an unsigned field
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                st_flac_state_t *p_st - decoder state
+ *                uint32_t bits - field width, 0 to 32
+ * Return Value : field value, 0 once the input has run out
+ **********************************************************************************************************************/
+static uint32_t br_get (p_audio_decoder_t p_dec, st_flac_state_t *p_st, uint32_t bits)
+{
+    while (p_st->cache_bits < bits)
+    {
+        if ((false == br_fill(p_dec, p_st)) || (false != p_st->error))
+        {
+            p_st->error = true;
+            return (0u);
+        }
+    }
+
+    p_st->cache_bits -= bits;
+
+    return ((uint32_t) ((p_st->cache >> p_st->cache_bits) & ((1ull << bits) - 1u)));
+}
+/***********************************************************************************************************************
+ End of function br_get
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: br_get_signed
+ * Description  : Reads a two's complement field
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                st_flac_state_t *p_st - decoder state
+ *                uint32_t bits - field width, 0 to 32
+ * Return Value : sign extended value
+ **********************************************************************************************************************/
+static int32_t br_get_signed (p_audio_decoder_t p_dec, st_flac_state_t *p_st, uint32_t bits)
+{
+    if (0u == bits)
+    {
+        return (0);
+    }
+
+    return (((int32_t) (br_get(p_dec, p_st, bits) << (32u - bits))) >> (32u - bits));
+}
+/***********************************************************************************************************************
+ End of function br_get_signed
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: br_unary
+ * Description  : Counts zero bits up to and including the next one bit, a whole cache word at a time
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                st_flac_state_t *p_st - decoder state
+ * Return Value : number of zero bits
+ **********************************************************************************************************************/
+static uint32_t br_unary (p_audio_decoder_t p_dec, st_flac_state_t *p_st)
+{
+    uint32_t count = 0u;
+    uint64_t bits;
+    uint32_t zeros;
+
+    while (1)
+    {
+        if (0u == p_st->cache_bits)
+        {
+            if ((false == br_fill(p_dec, p_st)) || (false != p_st->error))
+            {
+                p_st->error = true;
+                return (count);
+            }
+        }
+
+        /* unread bits at the top of the word, the cache may be completely full */
+        bits = p_st->cache << (64u - p_st->cache_bits);
+
+        if (0u != bits)
+        {
+            zeros = (uint32_t) __builtin_clzll(bits);
+            count += zeros;
+            p_st->cache_bits -= zeros + 1u;
+            return (count);
+        }
+
+        count += p_st->cache_bits;
+        p_st->cache_bits = 0u;
+    }
+}
+/***********************************************************************************************************************
+ End of function br_unary
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: br_align
+ * Description  : Drops bits up to the next byte boundary
+ * Arguments    : st_flac_state_t *p_st - decoder state
+ * Return Value : none
+ **********************************************************************************************************************/
+static void br_align (st_flac_state_t *p_st)
+{
+    p_st->cache_bits &= ~7u;
+}
+/***********************************************************************************************************************
+ End of function br_align
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: br_tell
+ * Description  : Source offset of the next unread byte, the reader must be byte aligned
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                st_flac_state_t *p_st - decoder state
+ * Return Value : byte offset
+ **********************************************************************************************************************/
+static uint32_t br_tell (p_audio_decoder_t p_dec, st_flac_state_t *p_st)
+{
+    return (p_dec->offset - (p_st->input_len - p_st->input_pos) - (p_st->cache_bits >> 3));
+}
+/***********************************************************************************************************************
+ End of function br_tell
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: br_reset
+ * Description  : Discards everything buffered, used after the source has been moved
+ * Arguments    : st_flac_state_t *p_st - decoder state
+ * Return Value : none
+ **********************************************************************************************************************/
+static void br_reset (st_flac_state_t *p_st)
+{
+    p_st->input_len = 0u;
+    p_st->input_pos = 0u;
+    p_st->cache_bits = 0u;
+    p_st->error = false;
+}
+/***********************************************************************************************************************
+ End of function br_reset
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: br_skip_bytes
+ * Description  : Skips whole bytes, large skips such as embedded pictures bypass the bit reader
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                st_flac_state_t *p_st - decoder state, byte aligned
+ *                uint32_t bytes - bytes to skip
+ * Return Value : none
+ **********************************************************************************************************************/
+static void br_skip_bytes (p_audio_decoder_t p_dec, st_flac_state_t *p_st, uint32_t bytes)
+{
+    uint32_t buffered;
+
+    while ((0u != bytes) && (0u != p_st->cache_bits))
+    {
+        br_get(p_dec, p_st, 8u);
+        bytes--;
+    }
+
+    buffered = p_st->input_len - p_st->input_pos;
+
+    if (bytes <= buffered)
+    {
+        p_st->input_pos += bytes;
+        return;
+    }
+
+    bytes -= buffered;
+    p_st->input_pos = p_st->input_len;
+
+    if (false == r_audio_decoder_skip(p_dec, bytes))
+    {
+        p_st->error = true;
+    }
+}
+/***********************************************************************************************************************
+ End of function br_skip_bytes
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: flac_probe
+ * Description  : "fLaC" stream marker
+ * Arguments    : const uint8_t *p_header - probe bytes
+ * Return Value : true if this is a FLAC file
+ **********************************************************************************************************************/
+static bool_t flac_probe (const uint8_t *p_header)
+{
+    return (0 == memcmp(p_header, "fLaC", 4));
+}
+/***********************************************************************************************************************
+ End of function flac_probe
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: flac_read_seektable
+ * Description  : Keeps the seek points that fit in 32 bits, placeholders and the rest are dropped
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                st_flac_state_t *p_st - decoder state
+ *                uint32_t length - metadata block length
+ * Return Value : none
+ **********************************************************************************************************************/
+static void flac_read_seektable (p_audio_decoder_t p_dec, st_flac_state_t *p_st, uint32_t length)
+{
+    uint32_t count = length / FLAC_PRV_SEEKPOINT_BYTES;
+    uint32_t sample_hi;
+    uint32_t sample;
+    uint32_t offset_hi;
+    uint32_t offset;
+    uint32_t i;
+
+    if ((NULL != p_st->p_seek) || (0u == count))
+    {
+        br_skip_bytes(p_dec, p_st, length);
+        return;
+    }
+
+    p_st->p_seek = r_audio_decoder_alloc(p_dec, count * sizeof(st_flac_seekpoint_t));
+
+    if (NULL == p_st->p_seek)
+    {
+        /* seeking falls back to decoding from the start */
+        br_skip_bytes(p_dec, p_st, length);
+        return;
+    }
+
+    p_st->seek_alloc = count;
+
+    for (i = 0u; i < count; i++)
+    {
+        sample_hi = br_get(p_dec, p_st, 32u);
+        sample = br_get(p_dec, p_st, 32u);
+        offset_hi = br_get(p_dec, p_st, 32u);
+        offset = br_get(p_dec, p_st, 32u);
+        br_get(p_dec, p_st, 16u);
+
+        if ((0u == sample_hi) && (0u == offset_hi)
+                && ((0u == p_st->seek_count) || (sample > p_st->p_seek[p_st->seek_count - 1u].sample)))
+        {
+            p_st->p_seek[p_st->seek_count].sample = sample;
+            p_st->p_seek[p_st->seek_count].offset = offset;
+            p_st->seek_count++;
+        }
+    }
+
+    br_skip_bytes(p_dec, p_st, length - (count * FLAC_PRV_SEEKPOINT_BYTES));
+}
+/***********************************************************************************************************************
+ End of function flac_read_seektable
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: flac_open
+ * Description  : Reads the metadata blocks and sizes the block buffers from STREAMINFO
+ * Arguments    : p_audio_decoder_t p_dec - decoder, the source is past the probe bytes
+ *                const uint8_t *p_header - probe bytes, the first metadata block header follows "fLaC"
+ * Return Value : DEVDRV_SUCCESS or DEVDRV_ERROR
+ **********************************************************************************************************************/
+static int32_t flac_open (p_audio_decoder_t p_dec, const uint8_t *p_header)
+{
+    st_flac_state_t *p_st;
+    uint32_t last = 0u;
+    uint32_t type;
+    uint32_t length;
+    uint32_t total_hi;
+    bool_t got_info = false;
+    uint32_t ch;
+
+    p_st = r_audio_decoder_alloc(p_dec, sizeof(st_flac_state_t));
+
+    if (NULL == p_st)
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    memset(p_st, 0, sizeof(st_flac_state_t));
+    p_dec->p_private = p_st;
+
+    p_st->p_input = r_audio_decoder_alloc(p_dec, FLAC_PRV_INPUT_BYTES);
+
+    if (NULL == p_st->p_input)
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    /* the probe consumed the marker and the start of the first metadata block */
+    memcpy(p_st->p_input, p_header + 4, AUDIO_DECODER_PROBE_BYTES - 4u);
+    p_st->input_len = AUDIO_DECODER_PROBE_BYTES - 4u;
+
+    while ((0u == last) && (false == p_st->error))
+    {
+        last = br_get(p_dec, p_st, 1u);
+        type = br_get(p_dec, p_st, 7u);
+        length = br_get(p_dec, p_st, 24u);
+
+        if ((FLAC_PRV_BLOCK_STREAMINFO == type) && (FLAC_PRV_STREAMINFO_BYTES == length))
+        {
+            br_get(p_dec, p_st, 16u);
+            p_st->max_block = br_get(p_dec, p_st, 16u);
+            br_get(p_dec, p_st, 24u);
+            br_get(p_dec, p_st, 24u);
+            p_dec->format.sample_rate = br_get(p_dec, p_st, 20u);
+            p_dec->format.channels = (uint16_t) (br_get(p_dec, p_st, 3u) + 1u);
+            p_dec->format.bits_per_sample = (uint16_t) (br_get(p_dec, p_st, 5u) + 1u);
+            total_hi = br_get(p_dec, p_st, 4u);
+            p_dec->format.total_frames = br_get(p_dec, p_st, 32u);
+
+            if (0u != total_hi)
+            {
+                p_dec->format.total_frames = 0u;
+            }
+
+            /* MD5 signature */
+            br_skip_bytes(p_dec, p_st, 16u);
+            got_info = true;
+        }
+        else if (FLAC_PRV_BLOCK_SEEKTABLE == type)
+        {
+            flac_read_seektable(p_dec, p_st, length);
+        }
+        else
+        {
+            br_skip_bytes(p_dec, p_st, length);
+        }
+    }
+
+    if ((false == got_info) || (false != p_st->error) || (0u == p_st->max_block)
+            || (0u == p_dec->format.sample_rate) || (p_dec->format.channels > FLAC_PRV_MAX_CHANNELS)
+            || (p_dec->format.bits_per_sample > FLAC_PRV_MAX_BITS_PER_SAMPLE))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    p_st->first_frame = br_tell(p_dec, p_st);
+
+    for (ch = 0u; ch < p_dec->format.channels; ch++)
+    {
+        p_st->p_block[ch] = r_audio_decoder_alloc(p_dec, p_st->max_block * sizeof(int32_t));
+
+        if (NULL == p_st->p_block[ch])
+        {
+            return (DEVDRV_ERROR);
+        }
+    }
+
+    return (DEVDRV_SUCCESS);
+}
+/***********************************************************************************************************************
+ End of function flac_open
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: flac_residual
+ * Description  : Decodes the Rice coded residual of a predicted subframe into p_out[order..block_size)
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                st_flac_state_t *p_st - decoder state
+ *                int32_t *p_out - subframe samples
+ *                uint32_t block_size - samples in the subframe
+ *                uint32_t order - predictor order, the warm up samples are already in p_out
+ * Return Value : none, errors are left in p_st->error
+ **********************************************************************************************************************/
+static void flac_residual (p_audio_decoder_t p_dec, st_flac_state_t *p_st, int32_t *p_out, uint32_t block_size,
+        uint32_t order)
+{
+    uint32_t method = br_get(p_dec, p_st, 2u);
+    uint32_t param_bits = (0u == method) ? 4u : 5u;
+    uint32_t escape = (1u << param_bits) - 1u;
+    uint32_t partition_order = br_get(p_dec, p_st, 4u);
+    uint32_t partitions = 1u << partition_order;
+    uint32_t partition_size = block_size >> partition_order;
+    uint32_t partition;
+    uint32_t count;
+    uint32_t k;
+    uint32_t raw;
+    uint32_t value;
+    int32_t *p_end;
+
+    if ((method > 1u) || ((partition_size << partition_order) != block_size) || (partition_size < order))
+    {
+        p_st->error = true;
+        return;
+    }
+
+    p_out += order;
+
+    for (partition = 0u; (partition < partitions) && (false == p_st->error); partition++)
+    {
+        count = (0u == partition) ? (partition_size - order) : partition_size;
+        p_end = p_out + count;
+        k = br_get(p_dec, p_st, param_bits);
+
+        if (k == escape)
+        {
+            raw = br_get(p_dec, p_st, 5u);
+
+            while (p_out < p_end)
+            {
+                *p_out++ = br_get_signed(p_dec, p_st, raw);
+            }
+        }
+        else
+        {
+            while (p_out < p_end)
+            {
+                value = (br_unary(p_dec, p_st) << k) | br_get(p_dec, p_st, k);
+                *p_out++ = (int32_t) (value >> 1) ^ -(int32_t) (value & 1u);
+            }
+        }
+    }
+}
+/***********************************************************************************************************************
+ End of function flac_residual
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: flac_fixed
+ * Description  : Restores a fixed polynomial predictor of order 0 to 4
+ * Arguments    : int32_t *p - samples, residual after the warm up samples
+ *                uint32_t n - samples
+ *                uint32_t order - predictor order
+ * Return Value : none
+ **********************************************************************************************************************/
+static void flac_fixed (int32_t *p, uint32_t n, uint32_t order)
+{
+    uint32_t i;
+
+    switch (order)
+    {
+        case 1:
+        {
+            for (i = 1u; i < n; i++)
+            {
+                p[i] += p[i - 1u];
+            }
+            break;
+        }
+        case 2:
+        {
+            for (i = 2u; i < n; i++)
+            {
+                p[i] += (2 * p[i - 1u]) - p[i - 2u];
+            }
+            break;
+        }
+        case 3:
+        {
+            for (i = 3u; i < n; i++)
+            {
+                p[i] += (3 * (p[i - 1u] - p[i - 2u])) + p[i - 3u];
+            }
+            break;
+        }
+        case 4:
+        {
+            for (i = 4u; i < n; i++)
+            {
+                p[i] += (4 * (p[i - 1u] + p[i - 3u])) - (6 * p[i - 2u]) - p[i - 4u];
+            }
+            break;
+        }
+        default:
+        {
+            /* order 0, the residual is the signal */
+            break;
+        }
+    }
+}
+/***********************************************************************************************************************
+ End of function flac_fixed
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: flac_lpc
+ * Description  : Restores a quantised linear predictor, accumulating in 64 bits so 24 bit audio cannot overflow
+ * Arguments    : int32_t *p - samples, residual after the warm up samples
+ *                uint32_t n - samples
+ *                const int32_t *p_coef - coefficients
+ *                uint32_t order - predictor order
+ *                uint32_t shift - quantisation shift
+ * Return Value : none
+ **********************************************************************************************************************/
+static void flac_lpc (int32_t *p, uint32_t n, const int32_t *p_coef, uint32_t order, uint32_t shift)
+{
+    int64_t sum;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = order; i < n; i++)
+    {
+        sum = 0;
+
+        for (j = 0u; j < order; j++)
+        {
+            sum += (int64_t) p_coef[j] * p[i - j - 1u];
+        }
+
+        p[i] += (int32_t) (sum >> shift);
+    }
+}
+/***********************************************************************************************************************
+ End of function flac_lpc
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: flac_subframe
+ * Description  : Decodes one channel of a frame
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                st_flac_state_t *p_st - decoder state
+ *                int32_t *p_out - channel samples
+ *                uint32_t n - block size
+ *                uint32_t bps - sample size, one more than the stream for a side channel
+ * Return Value : none, errors are left in p_st->error
+ **********************************************************************************************************************/
+static void flac_subframe (p_audio_decoder_t p_dec, st_flac_state_t *p_st, int32_t *p_out, uint32_t n, uint32_t bps)
+{
+    int32_t coef[FLAC_PRV_MAX_LPC_ORDER];
+    uint32_t type;
+    uint32_t wasted = 0u;
+    uint32_t order;
+    uint32_t precision;
+    int32_t shift;
+    uint32_t i;
+    int32_t value;
+
+    br_get(p_dec, p_st, 1u);
+    type = br_get(p_dec, p_st, 6u);
+
+    if (0u != br_get(p_dec, p_st, 1u))
+    {
+        wasted = br_unary(p_dec, p_st) + 1u;
+
+        if (wasted >= bps)
+        {
+            p_st->error = true;
+            return;
+        }
+
+        bps -= wasted;
+    }
+
+    if (0u == type)
+    {
+        value = br_get_signed(p_dec, p_st, bps);
+
+        for (i = 0u; i < n; i++)
+        {
+            p_out[i] = value;
+        }
+    }
+    else if (1u == type)
+    {
+        for (i = 0u; i < n; i++)
+        {
+            p_out[i] = br_get_signed(p_dec, p_st, bps);
+        }
+    }
+    else if ((type >= 8u) && (type <= 12u))
+    {
+        order = type - 8u;
+
+        for (i = 0u; (i < order) && (i < n); i++)
+        {
+            p_out[i] = br_get_signed(p_dec, p_st, bps);
+        }
+
+        flac_residual(p_dec, p_st, p_out, n, order);
+        flac_fixed(p_out, n, order);
+    }
+    else if (type >= 32u)
+    {
+        order = (type & 31u) + 1u;
+
+        for (i = 0u; (i < order) && (i < n); i++)
+        {
+            p_out[i] = br_get_signed(p_dec, p_st, bps);
+        }
+
+        precision = br_get(p_dec, p_st, 4u) + 1u;
+        shift = br_get_signed(p_dec, p_st, 5u);
+
+        if ((16u == precision) || (shift < 0))
+        {
+            p_st->error = true;
+            return;
+        }
+
+        for (i = 0u; i < order; i++)
+        {
+            coef[i] = br_get_signed(p_dec, p_st, precision);
+        }
+
+        flac_residual(p_dec, p_st, p_out, n, order);
+        flac_lpc(p_out, n, coef, order, (uint32_t) shift);
+    }
+    else
+    {
+        /* reserved subframe type */
+        p_st->error = true;
+        return;
+    }
+
+    if (0u != wasted)
+    {
+        for (i = 0u; i < n; i++)
+        {
+            p_out[i] = (int32_t) ((uint32_t) p_out[i] << wasted);
+        }
+    }
+}
+/***********************************************************************************************************************
+ End of function flac_subframe
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: flac_frame
+ * Description  : Finds the next frame sync and decodes the frame into the block buffers. The header and footer CRCs
+ *                are not checked; a damaged frame shows up as a malformed field and resynchronises on the next one.
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                st_flac_state_t *p_st - decoder state
+ * Return Value : DEVDRV_SUCCESS, or DEVDRV_ERROR at the end of the stream
+ **********************************************************************************************************************/
+static int32_t flac_frame (p_audio_decoder_t p_dec, st_flac_state_t *p_st)
+{
+    static const uint8_t s_sample_bits[8] =
+    {
+        0u, 8u, 12u, 0u, 16u, 20u, 24u, 0u
+    };
+    uint32_t byte;
+    uint32_t code;
+    uint32_t block_size = 0u;
+    uint32_t bps;
+    uint32_t assignment;
+    uint32_t channels;
+    uint32_t ch;
+    uint32_t i;
+    int32_t *p_a = p_st->p_block[0];
+    int32_t *p_b = p_st->p_block[1];
+    int32_t mid;
+    int32_t side;
+
+    while (1)
+    {
+        /* sync code 0xFFF8 or 0xFFF9 on a byte boundary */
+        br_align(p_st);
+        p_st->error = false;
+        byte = br_get(p_dec, p_st, 8u);
+
+        while (false == p_st->error)
+        {
+            if (0xFFu == byte)
+            {
+                byte = br_get(p_dec, p_st, 8u);
+
+                if (0xF8u == (byte & 0xFEu))
+                {
+                    break;
+                }
+            }
+            else
+            {
+                byte = br_get(p_dec, p_st, 8u);
+            }
+        }
+
+        if (false != p_st->error)
+        {
+            return (DEVDRV_ERROR);
+        }
+
+        code = br_get(p_dec, p_st, 4u);
+        i = br_get(p_dec, p_st, 4u);
+        assignment = br_get(p_dec, p_st, 4u);
+        bps = s_sample_bits[br_get(p_dec, p_st, 3u)];
+        br_get(p_dec, p_st, 1u);
+
+        /* frame or sample number, UTF-8 style, only its length matters */
+        byte = br_get(p_dec, p_st, 8u);
+
+        if (0x80u == (byte & 0xC0u))
+        {
+            /* continuation byte, not a valid first byte */
+            p_st->error = true;
+        }
+
+        for (byte <<= 1; 0u != (byte & 0x80u); byte <<= 1)
+        {
+            br_get(p_dec, p_st, 8u);
+        }
+
+        if (0u == code)
+        {
+            p_st->error = true;
+        }
+        else if (1u == code)
+        {
+            block_size = 192u;
+        }
+        else if (code <= 5u)
+        {
+            block_size = 576u << (code - 2u);
+        }
+        else if (6u == code)
+        {
+            block_size = br_get(p_dec, p_st, 8u) + 1u;
+        }
+        else if (7u == code)
+        {
+            block_size = br_get(p_dec, p_st, 16u) + 1u;
+        }
+        else
+        {
+            block_size = 256u << (code - 8u);
+        }
+
+        /* explicit sample rates, the STREAMINFO rate is used */
+        if (12u == i)
+        {
+            br_get(p_dec, p_st, 8u);
+        }
+        else if ((13u == i) || (14u == i))
+        {
+            br_get(p_dec, p_st, 16u);
+        }
+        else if (15u == i)
+        {
+            p_st->error = true;
+        }
+        else
+        {
+            /* coded in the header byte */
+        }
+
+        /* CRC-8 */
+        br_get(p_dec, p_st, 8u);
+
+        if (0u == bps)
+        {
+            bps = p_dec->format.bits_per_sample;
+        }
+
+        channels = (assignment < 8u) ? (assignment + 1u) : 2u;
+
+        if ((false != p_st->error) || (assignment > FLAC_PRV_CHANNELS_MID_SIDE) || (block_size > p_st->max_block)
+                || (channels != p_dec->format.channels) || (bps > FLAC_PRV_MAX_BITS_PER_SAMPLE))
+        {
+            /* false sync or a frame we cannot play, look for the next one */
+            continue;
+        }
+
+        for (ch = 0u; (ch < channels) && (false == p_st->error); ch++)
+        {
+            i = bps;
+
+            if (((FLAC_PRV_CHANNELS_LEFT_SIDE == assignment) && (1u == ch))
+                    || ((FLAC_PRV_CHANNELS_RIGHT_SIDE == assignment) && (0u == ch))
+                    || ((FLAC_PRV_CHANNELS_MID_SIDE == assignment) && (1u == ch)))
+            {
+                i++;
+            }
+
+            flac_subframe(p_dec, p_st, p_st->p_block[ch], block_size, i);
+        }
+
+        if (false != p_st->error)
+        {
+            continue;
+        }
+
+        switch (assignment)
+        {
+            case FLAC_PRV_CHANNELS_LEFT_SIDE:
+            {
+                for (i = 0u; i < block_size; i++)
+                {
+                    p_b[i] = p_a[i] - p_b[i];
+                }
+                break;
+            }
+            case FLAC_PRV_CHANNELS_RIGHT_SIDE:
+            {
+                for (i = 0u; i < block_size; i++)
+                {
+                    p_a[i] += p_b[i];
+                }
+                break;
+            }
+            case FLAC_PRV_CHANNELS_MID_SIDE:
+            {
+                for (i = 0u; i < block_size; i++)
+                {
+                    side = p_b[i];
+                    mid = (int32_t) (((uint32_t) p_a[i] << 1) | ((uint32_t) side & 1u));
+                    p_a[i] = (mid + side) >> 1;
+                    p_b[i] = (mid - side) >> 1;
+                }
+                break;
+            }
+            default:
+            {
+                /* independent channels */
+                break;
+            }
+        }
+
+        /* padding to the byte boundary, then CRC-16 */
+        br_align(p_st);
+        br_get(p_dec, p_st, 16u);
+
+        p_st->block_size = block_size;
+        p_st->block_pos = 0u;
+        p_st->block_shift = 32u - bps;
+
+        return (DEVDRV_SUCCESS);
+    }
+}
+/***********************************************************************************************************************
+ End of function flac_frame
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: flac_decode
+ * Description  : Copies decoded blocks into the period, decoding a new frame whenever the block runs out
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                uint32_t *p_period - destination
+ *                uint32_t frames - frames wanted
+ * Return Value : frames written
+ **********************************************************************************************************************/
+static uint32_t flac_decode (p_audio_decoder_t p_dec, uint32_t *p_period, uint32_t frames)
+{
+    st_flac_state_t *p_st = (st_flac_state_t *) p_dec->p_private;
+    const int32_t *p_left;
+    const int32_t *p_right;
+    uint32_t shift;
+    uint32_t count;
+    uint32_t written = 0u;
+
+    while (written < frames)
+    {
+        if (p_st->block_pos == p_st->block_size)
+        {
+            if (DEVDRV_SUCCESS != flac_frame(p_dec, p_st))
+            {
+                break;
+            }
+        }
+
+        count = p_st->block_size - p_st->block_pos;
+
+        if (count > (frames - written))
+        {
+            count = frames - written;
+        }
+
+        shift = p_st->block_shift;
+        p_left = p_st->p_block[0] + p_st->block_pos;
+        p_right = (2u == p_dec->format.channels) ? (p_st->p_block[1] + p_st->block_pos) : p_left;
+        p_st->block_pos += count;
+        written += count;
+
+        while (count--)
+        {
+            *p_period++ = (uint32_t) *p_left++ << shift;
+            *p_period++ = (uint32_t) *p_right++ << shift;
+        }
+    }
+
+    return (written);
+}
+/***********************************************************************************************************************
+ End of function flac_decode
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: flac_seek
+ * Description  : Jumps to the closest seek point before the frame, then decodes forward to it
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                uint32_t frame - frame index
+ * Return Value : DEVDRV_SUCCESS or DEVDRV_ERROR
+ **********************************************************************************************************************/
+static int32_t flac_seek (p_audio_decoder_t p_dec, uint32_t frame)
+{
+    st_flac_state_t *p_st = (st_flac_state_t *) p_dec->p_private;
+    uint32_t sample = 0u;
+    uint32_t offset = 0u;
+    uint32_t i;
+
+    for (i = 0u; (i < p_st->seek_count) && (p_st->p_seek[i].sample <= frame); i++)
+    {
+        sample = p_st->p_seek[i].sample;
+        offset = p_st->p_seek[i].offset;
+    }
+
+    if (false == r_audio_decoder_seek_source(p_dec, p_st->first_frame + offset))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    br_reset(p_st);
+    p_st->block_size = 0u;
+    p_st->block_pos = 0u;
+
+    while (1)
+    {
+        if (DEVDRV_SUCCESS != flac_frame(p_dec, p_st))
+        {
+            return (DEVDRV_ERROR);
+        }
+
+        if ((sample + p_st->block_size) > frame)
+        {
+            p_st->block_pos = frame - sample;
+            return (DEVDRV_SUCCESS);
+        }
+
+        sample += p_st->block_size;
+    }
+}
+/***********************************************************************************************************************
+ End of function flac_seek
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: flac_close
+ * Description  : Frees the block buffers, seek table and input buffer
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ * Return Value : none
+ **********************************************************************************************************************/
+static void flac_close (p_audio_decoder_t p_dec)
+{
+    st_flac_state_t *p_st = (st_flac_state_t *) p_dec->p_private;
+    uint32_t ch;
+
+    if (NULL == p_st)
+    {
+        return;
+    }
+
+    for (ch = 0u; ch < FLAC_PRV_MAX_CHANNELS; ch++)
+    {
+        r_audio_decoder_free(p_dec, p_st->p_block[ch], p_st->max_block * sizeof(int32_t));
+    }
+
+    r_audio_decoder_free(p_dec, p_st->p_seek, p_st->seek_alloc * sizeof(st_flac_seekpoint_t));
+    r_audio_decoder_free(p_dec, p_st->p_input, FLAC_PRV_INPUT_BYTES);
+    r_audio_decoder_free(p_dec, p_st, sizeof(st_flac_state_t));
+    p_dec->p_private = NULL;
+}
+/***********************************************************************************************************************
+ End of function flac_close
+ **********************************************************************************************************************/
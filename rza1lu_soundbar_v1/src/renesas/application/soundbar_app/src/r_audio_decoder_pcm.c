@@ -0,0 +1,584 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ ******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.  */
+/******************************************************************************
+ * File Name    : r_audio_decoder_pcm.c
+ * Device(s)    : RZ/A1L
+ * Tool-Chain   : GNUARM-NONE-EABI-v16.01
+ * H/W Platform : Stream it! v2 board
+ * Description  : WAV and AIFF linear PCM decoders
+ ******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 13.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ *****************************************************************************/
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+#include <string.h>
+
+#include "r_typedefs.h"
+#include "dev_drv.h"
+
+#include "r_audio_convert.h"
+#include "r_audio_decoder.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+#define PCM_PRV_WAVE_FORMAT_PCM         (0x0001u)
+#define PCM_PRV_WAVE_FORMAT_EXTENSIBLE  (0xFFFEu)
+
+/* Largest part of a fmt / COMM chunk that is parsed */
+#define PCM_PRV_WAV_FMT_BYTES           (40u)
+#define PCM_PRV_AIFF_COMM_BYTES         (22u)
+
+/* Frames converted per block, keeps the in place source word aligned for every format */
+#define PCM_PRV_BLOCK_FRAMES            (4u)
+
+/******************************************************************************
+ Typedef definitions
+ ******************************************************************************/
+typedef struct
+{
+    uint32_t data_offset;       /* source offset of the first sample */
+    uint32_t data_bytes;        /* whole frames in the data chunk */
+    uint32_t remaining;         /* bytes left to decode */
+    uint32_t frame_bytes;
+    bool_t   big_endian;        /* AIFF samples are byte swapped before conversion */
+} st_pcm_state_t;
+
+/******************************************************************************
+ Private global variables and functions
+ ******************************************************************************/
+static bool_t wav_probe (const uint8_t *p_header);
+static int32_t wav_open (p_audio_decoder_t p_dec, const uint8_t *p_header);
+static bool_t aiff_probe (const uint8_t *p_header);
+static int32_t aiff_open (p_audio_decoder_t p_dec, const uint8_t *p_header);
+static uint32_t pcm_decode (p_audio_decoder_t p_dec, uint32_t *p_period, uint32_t frames);
+static int32_t pcm_seek (p_audio_decoder_t p_dec, uint32_t frame);
+static void pcm_close (p_audio_decoder_t p_dec);
+
+const st_audio_decoder_ops_t g_audio_decoder_wav =
+{
+    "WAV", &wav_probe, &wav_open, &pcm_decode, &pcm_seek, &pcm_close
+};
+
+const st_audio_decoder_ops_t g_audio_decoder_aiff =
+{
+    "AIFF", &aiff_probe, &aiff_open, &pcm_decode, &pcm_seek, &pcm_close
+};
+
+/***********************************************************************************************************************
+ * Function Name: get_le16
+ * Description  : Little endian 16 bit field
+ * Arguments    : const uint8_t *p - field
+ * Return Value : value
+ **********************************************************************************************************************/
+static uint16_t get_le16 (const uint8_t *p)
+{
+    return ((uint16_t) (p[0] | (p[1] << 8)));
+}
+/***********************************************************************************************************************
+ End of function get_le16
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: get_le32
+ * Description  : Little endian 32 bit field
+ * Arguments    : const uint8_t *p - field
+ * Return Value : value
+ **********************************************************************************************************************/
+static uint32_t get_le32 (const uint8_t *p)
+{
+    return ((uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24));
+}
+/***********************************************************************************************************************
+ End of function get_le32
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: get_be16
+ * Description  : Big endian 16 bit field
+ * Arguments    : const uint8_t *p - field
+ * Return Value : value
+ **********************************************************************************************************************/
+static uint16_t get_be16 (const uint8_t *p)
+{
+    return ((uint16_t) ((p[0] << 8) | p[1]));
+}
+/***********************************************************************************************************************
+ End of function get_be16
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: get_be32
+ * Description  : Big endian 32 bit field
+ * Arguments    : const uint8_t *p - field
+ * Return Value : value
+ **********************************************************************************************************************/
+static uint32_t get_be32 (const uint8_t *p)
+{
+    return (((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | (uint32_t) p[3]);
+}
+/***********************************************************************************************************************
+ End of function get_be32
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: pcm_start
+ * Description  : Allocates the decoder state once the header has been parsed
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                uint32_t data_bytes - size of the sample data, the source is at its first byte
+ *                bool_t big_endian - sample byte order
+ * Return Value : DEVDRV_SUCCESS or DEVDRV_ERROR
+ **********************************************************************************************************************/
+static int32_t pcm_start (p_audio_decoder_t p_dec, uint32_t data_bytes, bool_t big_endian)
+{
+    st_pcm_state_t *p_state;
+    uint32_t frame_bytes;
+
+    frame_bytes = r_audio_convert_src_frame_bytes(p_dec->format.bits_per_sample, p_dec->format.channels);
+
+    if ((0u == frame_bytes) || (0u == p_dec->format.sample_rate))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    /* trust the file size over a truncated header */
+    if (data_bytes > (p_dec->source.size - p_dec->offset))
+    {
+        data_bytes = p_dec->source.size - p_dec->offset;
+    }
+
+    p_state = r_audio_decoder_alloc(p_dec, sizeof(st_pcm_state_t));
+
+    if (NULL == p_state)
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    p_state->data_offset = p_dec->offset;
+    p_state->frame_bytes = frame_bytes;
+    p_state->data_bytes = data_bytes - (data_bytes % frame_bytes);
+    p_state->remaining = p_state->data_bytes;
+    p_state->big_endian = big_endian;
+
+    p_dec->format.total_frames = p_state->data_bytes / frame_bytes;
+    p_dec->p_private = p_state;
+
+    return (DEVDRV_SUCCESS);
+}
+/***********************************************************************************************************************
+ End of function pcm_start
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: wav_probe
+ * Description  : RIFF / WAVE header
+ * Arguments    : const uint8_t *p_header - probe bytes
+ * Return Value : true if this is a WAV file
+ **********************************************************************************************************************/
+static bool_t wav_probe (const uint8_t *p_header)
+{
+    return ((0 == memcmp(p_header, "RIFF", 4)) && (0 == memcmp(p_header + 8, "WAVE", 4)));
+}
+/***********************************************************************************************************************
+ End of function wav_probe
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: wav_open
+ * Description  : Walks the RIFF chunks up to the data chunk, reading the fmt chunk on the way
+ * Arguments    : p_audio_decoder_t p_dec - decoder, the source is just past the RIFF header
+ *                const uint8_t *p_header - probe bytes
+ * Return Value : DEVDRV_SUCCESS or DEVDRV_ERROR
+ **********************************************************************************************************************/
+static int32_t wav_open (p_audio_decoder_t p_dec, const uint8_t *p_header)
+{
+    uint8_t chunk[8];
+    uint8_t fmt[PCM_PRV_WAV_FMT_BYTES];
+    uint32_t size;
+    uint32_t count;
+    uint16_t tag = 0u;
+    bool_t got_fmt = false;
+
+    UNUSED_PARAM(p_header);
+
+    while (1)
+    {
+        if (sizeof(chunk) != r_audio_decoder_read(p_dec, chunk, sizeof(chunk)))
+        {
+            return (DEVDRV_ERROR);
+        }
+
+        size = get_le32(chunk + 4);
+
+        if (0 == memcmp(chunk, "data", 4))
+        {
+            break;
+        }
+
+        if ((0 == memcmp(chunk, "fmt ", 4)) && (size >= 16u))
+        {
+            count = (size > sizeof(fmt)) ? sizeof(fmt) : size;
+
+            if (count != r_audio_decoder_read(p_dec, fmt, count))
+            {
+                return (DEVDRV_ERROR);
+            }
+
+            tag = get_le16(fmt);
+            p_dec->format.channels = get_le16(fmt + 2);
+            p_dec->format.sample_rate = get_le32(fmt + 4);
+            p_dec->format.bits_per_sample = get_le16(fmt + 14);
+
+            /* WAVE_FORMAT_EXTENSIBLE carries the real format in the first bytes of the sub format GUID */
+            if ((PCM_PRV_WAVE_FORMAT_EXTENSIBLE == tag) && (count >= 26u))
+            {
+                tag = get_le16(fmt + 24);
+            }
+
+            got_fmt = true;
+            size -= count;
+        }
+
+        /* chunks are padded to an even length */
+        if (false == r_audio_decoder_skip(p_dec, size + (size & 1u)))
+        {
+            return (DEVDRV_ERROR);
+        }
+    }
+
+    if ((false == got_fmt) || (PCM_PRV_WAVE_FORMAT_PCM != tag))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    return (pcm_start(p_dec, size, false));
+}
+/***********************************************************************************************************************
+ End of function wav_open
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: aiff_probe
+ * Description  : FORM / AIFF or AIFC header
+ * Arguments    : const uint8_t *p_header - probe bytes
+ * Return Value : true if this is an AIFF file
+ **********************************************************************************************************************/
+static bool_t aiff_probe (const uint8_t *p_header)
+{
+    return ((0 == memcmp(p_header, "FORM", 4))
+            && ((0 == memcmp(p_header + 8, "AIFF", 4)) || (0 == memcmp(p_header + 8, "AIFC", 4))));
+}
+/***********************************************************************************************************************
+ End of function aiff_probe
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: aiff_sample_rate
+ * Description  : Integer part of the 80 bit extended float sample rate in a COMM chunk
+ * Arguments    : const uint8_t *p - 10 byte field
+ * Return Value : sample rate, 0 if out of range
+ **********************************************************************************************************************/
+static uint32_t aiff_sample_rate (const uint8_t *p)
+{
+    int32_t exponent = (int32_t) (((p[0] & 0x7Fu) << 8) | p[1]) - 16383;
+    uint32_t mantissa = get_be32(p + 2);
+
+    if ((0u != (p[0] & 0x80u)) || (exponent < 0) || (exponent > 31))
+    {
+        return (0u);
+    }
+
+    return (mantissa >> (31 - exponent));
+}
+/***********************************************************************************************************************
+ End of function aiff_sample_rate
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: aiff_open
+ * Description  : Walks the IFF chunks up to the sound data, reading the COMM chunk on the way. AIFC is accepted when
+ *                it is uncompressed ("NONE") or byte swapped PCM ("sowt").
+ * Arguments    : p_audio_decoder_t p_dec - decoder, the source is just past the FORM header
+ *                const uint8_t *p_header - probe bytes
+ * Return Value : DEVDRV_SUCCESS or DEVDRV_ERROR
+ **********************************************************************************************************************/
+static int32_t aiff_open (p_audio_decoder_t p_dec, const uint8_t *p_header)
+{
+    uint8_t chunk[8];
+    uint8_t comm[PCM_PRV_AIFF_COMM_BYTES];
+    uint32_t size;
+    uint32_t count;
+    uint32_t data_offset;
+    bool_t aifc = (0 == memcmp(p_header + 8, "AIFC", 4));
+    bool_t big_endian = true;
+    bool_t got_comm = false;
+
+    while (1)
+    {
+        if (sizeof(chunk) != r_audio_decoder_read(p_dec, chunk, sizeof(chunk)))
+        {
+            return (DEVDRV_ERROR);
+        }
+
+        size = get_be32(chunk + 4);
+
+        if ((0 == memcmp(chunk, "SSND", 4)) && (size >= 8u))
+        {
+            /* offset to the first sample frame, then a block size nobody uses */
+            if (sizeof(chunk) != r_audio_decoder_read(p_dec, chunk, sizeof(chunk)))
+            {
+                return (DEVDRV_ERROR);
+            }
+
+            data_offset = get_be32(chunk);
+
+            if (((data_offset + 8u) > size) || (false == r_audio_decoder_skip(p_dec, data_offset)))
+            {
+                return (DEVDRV_ERROR);
+            }
+
+            size -= data_offset + 8u;
+            break;
+        }
+
+        if ((0 == memcmp(chunk, "COMM", 4)) && (size >= 18u))
+        {
+            count = (size > sizeof(comm)) ? sizeof(comm) : size;
+
+            if (count != r_audio_decoder_read(p_dec, comm, count))
+            {
+                return (DEVDRV_ERROR);
+            }
+
+            p_dec->format.channels = get_be16(comm);
+            p_dec->format.bits_per_sample = get_be16(comm + 6);
+            p_dec->format.sample_rate = aiff_sample_rate(comm + 8);
+
+            if (false != aifc)
+            {
+                if ((count >= 22u) && (0 == memcmp(comm + 18, "sowt", 4)))
+                {
+                    big_endian = false;
+                }
+                else if ((count < 22u) || (0 != memcmp(comm + 18, "NONE", 4)))
+                {
+                    return (DEVDRV_ERROR);
+                }
+                else
+                {
+                    /* uncompressed big endian */
+                }
+            }
+
+            got_comm = true;
+            size -= count;
+        }
+
+        if (false == r_audio_decoder_skip(p_dec, size + (size & 1u)))
+        {
+            return (DEVDRV_ERROR);
+        }
+    }
+
+    if (false == got_comm)
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    return (pcm_start(p_dec, size, big_endian));
+}
+/***********************************************************************************************************************
+ End of function aiff_open
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: pcm_swap
+ * Description  : Reverses the bytes of each big endian sample in place
+ * Arguments    : uint8_t *p - samples
+ *                uint32_t bytes - byte count, a whole number of samples
+ *                uint32_t sample_bytes - 2, 3 or 4
+ * Return Value : none
+ **********************************************************************************************************************/
+static void pcm_swap (uint8_t *p, uint32_t bytes, uint32_t sample_bytes)
+{
+    uint8_t *p_end = p + bytes;
+    uint8_t t;
+
+    while (p < p_end)
+    {
+        t = p[0];
+        p[0] = p[sample_bytes - 1u];
+        p[sample_bytes - 1u] = t;
+
+        if (4u == sample_bytes)
+        {
+            t = p[1];
+            p[1] = p[2];
+            p[2] = t;
+        }
+
+        p += sample_bytes;
+    }
+}
+/***********************************************************************************************************************
+ End of function pcm_swap
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: pcm_read_convert
+ * Description  : Reads frames into p_src and converts them into p_dst
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                uint32_t *p_dst - destination
+ *                uint8_t *p_src - word aligned source, may be the tail of p_dst
+ *                uint32_t frames - frames wanted
+ * Return Value : frames converted
+ **********************************************************************************************************************/
+static uint32_t pcm_read_convert (p_audio_decoder_t p_dec, uint32_t *p_dst, uint8_t *p_src, uint32_t frames)
+{
+    st_pcm_state_t *p_state = (st_pcm_state_t *) p_dec->p_private;
+    uint32_t bytes = frames * p_state->frame_bytes;
+    uint32_t got;
+
+    got = r_audio_decoder_read(p_dec, p_src, bytes);
+
+    if (got < bytes)
+    {
+        /* file ended early, drop the partial frame with the rest */
+        p_state->remaining = 0u;
+        frames = got / p_state->frame_bytes;
+        got = frames * p_state->frame_bytes;
+    }
+    else
+    {
+        p_state->remaining -= got;
+    }
+
+    if (false != p_state->big_endian)
+    {
+        pcm_swap(p_src, got, (uint32_t) p_dec->format.bits_per_sample >> 3);
+    }
+
+    r_audio_convert_to_s32_stereo(p_dst, p_src, p_dec->format.bits_per_sample, p_dec->format.channels, frames);
+
+    return (frames);
+}
+/***********************************************************************************************************************
+ End of function pcm_read_convert
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: pcm_decode
+ * Description  : Reads the samples into the tail of the period and converts them in place. A few frames that would
+ *                leave the in place source misaligned go through a small bounce buffer instead.
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                uint32_t *p_period - destination
+ *                uint32_t frames - frames wanted
+ * Return Value : frames written
+ **********************************************************************************************************************/
+static uint32_t pcm_decode (p_audio_decoder_t p_dec, uint32_t *p_period, uint32_t frames)
+{
+    st_pcm_state_t *p_state = (st_pcm_state_t *) p_dec->p_private;
+    uint32_t bounce[(PCM_PRV_BLOCK_FRAMES * AUDIO_CONVERT_DST_FRAME_BYTES) / sizeof(uint32_t)];
+    uint32_t block;
+    uint32_t offset;
+    uint32_t written = 0u;
+
+    if (frames > (p_state->remaining / p_state->frame_bytes))
+    {
+        frames = p_state->remaining / p_state->frame_bytes;
+    }
+
+    block = frames & ~(PCM_PRV_BLOCK_FRAMES - 1u);
+
+    if (0u != block)
+    {
+        offset = r_audio_convert_src_offset(p_dec->format.bits_per_sample, p_dec->format.channels,
+                block * AUDIO_CONVERT_DST_FRAME_BYTES);
+
+        written = pcm_read_convert(p_dec, p_period, ((uint8_t *) p_period) + offset, block);
+
+        if (written < block)
+        {
+            return (written);
+        }
+    }
+
+    if (written < frames)
+    {
+        written += pcm_read_convert(p_dec, p_period + (written * 2u), (uint8_t *) bounce, frames - written);
+    }
+
+    return (written);
+}
+/***********************************************************************************************************************
+ End of function pcm_decode
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: pcm_seek
+ * Description  : Moves the source to a frame within the sample data
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ *                uint32_t frame - frame index
+ * Return Value : DEVDRV_SUCCESS or DEVDRV_ERROR
+ **********************************************************************************************************************/
+static int32_t pcm_seek (p_audio_decoder_t p_dec, uint32_t frame)
+{
+    st_pcm_state_t *p_state = (st_pcm_state_t *) p_dec->p_private;
+    uint32_t bytes = frame * p_state->frame_bytes;
+
+    if ((bytes > p_state->data_bytes)
+            || (false == r_audio_decoder_seek_source(p_dec, p_state->data_offset + bytes)))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    p_state->remaining = p_state->data_bytes - bytes;
+
+    return (DEVDRV_SUCCESS);
+}
+/***********************************************************************************************************************
+ End of function pcm_seek
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: pcm_close
+ * Description  : Frees the decoder state
+ * Arguments    : p_audio_decoder_t p_dec - decoder
+ * Return Value : none
+ **********************************************************************************************************************/
+static void pcm_close (p_audio_decoder_t p_dec)
+{
+    r_audio_decoder_free(p_dec, p_dec->p_private, sizeof(st_pcm_state_t));
+    p_dec->p_private = NULL;
+}
+/***********************************************************************************************************************
+ End of function pcm_close
+ **********************************************************************************************************************/
@@ -0,0 +1,813 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ ******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.  */
+/******************************************************************************
+ * File Name    : r_audio_dsp.c
+ * Device(s)    : RZ/A1L
+ * Tool-Chain   : GNUARM-NONE-EABI-v16.01
+ * H/W Platform : Stream it! v2 board
+ * Description  : Q31 parametric equaliser, 2-way crossover and look-ahead limiter
+ ******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 13.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ *****************************************************************************/
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "r_typedefs.h"
+#include "r_os_abstraction_api.h"
+#include "r_task_priority.h"
+#include "dev_drv.h"
+
+#include "r_audio_dsp.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+/* Biquad coefficients are Q28, enough range for a shelf at full boost */
+#define DSP_PRV_COEF_SHIFT              (28u)
+#define DSP_PRV_COEF_ONE                ((double) (1ul << DSP_PRV_COEF_SHIFT))
+#define DSP_PRV_COEF_FRAC_MASK          ((1ul << DSP_PRV_COEF_SHIFT) - 1u)
+
+/* Samples are scaled down on the way in so equaliser boosts do not clip before the limiter sees them */
+#define DSP_PRV_HEADROOM_BITS           (2u)
+
+/* Limiter gain is Q31 */
+#define DSP_PRV_GAIN_ONE                (0x7FFFFFFFL)
+#define DSP_PRV_Q31                     (2147483648.0)
+
+#define DSP_PRV_PI                      (3.14159265358979323846)
+
+/* Butterworth Q, two in cascade give the Linkwitz-Riley crossover */
+#define DSP_PRV_BUTTERWORTH_Q           (0.70710678)
+
+/* Accepted parameter ranges */
+#define DSP_PRV_FREQ_MIN_HZ             (10.0f)
+#define DSP_PRV_FREQ_MAX_RATIO          (0.45f)
+#define DSP_PRV_Q_MIN                   (0.1f)
+#define DSP_PRV_Q_MAX                   (20.0f)
+#define DSP_PRV_CROSSOVER_MIN_HZ        (40.0f)
+#define DSP_PRV_THRESHOLD_MIN_DB        (-40.0f)
+#define DSP_PRV_RELEASE_MIN_MS          (1.0f)
+#define DSP_PRV_RELEASE_MAX_MS          (5000.0f)
+
+/******************************************************************************
+ Typedef definitions
+ ******************************************************************************/
+typedef struct
+{
+    int32_t b0;
+    int32_t b1;
+    int32_t b2;
+    int32_t a1;
+    int32_t a2;
+} st_dsp_biquad_t;
+
+typedef struct
+{
+    int32_t  x1;
+    int32_t  x2;
+    int32_t  y1;
+    int32_t  y2;
+    uint32_t err;               /* fraction dropped from the last output, fed back into the next */
+} st_dsp_biquad_state_t;
+
+/* Everything the audio path needs, calculated by r_audio_dsp_configure */
+typedef struct
+{
+    bool_t   enable;
+    bool_t   eq_on[AUDIO_DSP_EQ_BANDS];
+    st_dsp_biquad_t eq[AUDIO_DSP_EQ_BANDS];
+    bool_t   crossover_on;
+    st_dsp_biquad_t crossover_low;
+    st_dsp_biquad_t crossover_high;
+    bool_t   limiter_on;
+    int32_t  threshold;         /* linear, after the headroom shift */
+    float    threshold_q31;     /* threshold * 2^31, the numerator of the gain a peak needs */
+    int32_t  release;           /* Q31 one pole coefficient */
+} st_dsp_coefs_t;
+
+typedef struct st_audio_dsp
+{
+    uint32_t sample_rate;
+    st_audio_dsp_config_t config;
+
+    st_dsp_coefs_t active;              /* owned by r_audio_dsp_process */
+    st_dsp_coefs_t pending;             /* handed over under a critical section */
+    volatile bool_t pending_valid;
+
+    st_dsp_biquad_state_t eq_state[AUDIO_DSP_EQ_BANDS][2];
+    st_dsp_biquad_state_t crossover_state[4];   /* low, low, high, high */
+
+    int32_t  delay[AUDIO_DSP_LOOKAHEAD_FRAMES * 2u];
+    uint32_t delay_pos;
+    int32_t  gain;              /* Q31 gain applied to the frame leaving the delay */
+    int32_t  gain_target;       /* ceiling while a peak is in the delay */
+    int32_t  gain_step;         /* per frame reduction that reaches gain_target in time */
+    uint32_t peak_held;         /* peak that set gain_target */
+    uint32_t hold;              /* frames until that peak has left the delay */
+} st_audio_dsp_t;
+
+/******************************************************************************
+ Private global variables and functions
+ ******************************************************************************/
+static const char_t * const gs_filter_names[AUDIO_DSP_FILTER_COUNT] =
+{
+    "off", "peak", "lowshelf", "highshelf", "lowpass", "highpass"
+};
+
+/* Default band centres, spread over the audio range */
+static const float gs_default_freq[AUDIO_DSP_EQ_BANDS] =
+{
+    60.0f, 250.0f, 1000.0f, 4000.0f, 12000.0f
+};
+
+/***********************************************************************************************************************
+ * Function Name: quantise
+ * Description  : Converts a biquad coefficient to Q28
+ * Arguments    : double value - coefficient normalised to a0
+ * Return Value : Q28 coefficient
+ **********************************************************************************************************************/
+static int32_t quantise (double value)
+{
+    return ((int32_t) lrint(value * DSP_PRV_COEF_ONE));
+}
+/***********************************************************************************************************************
+ End of function quantise
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: design_biquad
+ * Description  : Audio EQ cookbook responses (R. Bristow-Johnson)
+ * Arguments    : st_dsp_biquad_t *p_coef - destination
+ *                e_audio_dsp_filter_t type - response
+ *                double freq - centre or corner frequency in Hz
+ *                double gain_db - peak and shelf gain
+ *                double q - bandwidth
+ *                double rate - sample rate
+ * Return Value : none
+ **********************************************************************************************************************/
+static void design_biquad (st_dsp_biquad_t *p_coef, e_audio_dsp_filter_t type, double freq, double gain_db, double q,
+        double rate)
+{
+    double w0 = (2.0 * DSP_PRV_PI * freq) / rate;
+    double cw = cos(w0);
+    double alpha = sin(w0) / (2.0 * q);
+    double a = pow(10.0, gain_db / 40.0);
+    double beta = 2.0 * sqrt(a) * alpha;
+    double b0;
+    double b1;
+    double b2;
+    double a0;
+    double a1;
+    double a2;
+
+    switch (type)
+    {
+        case AUDIO_DSP_FILTER_PEAK:
+        {
+            b0 = 1.0 + (alpha * a);
+            b1 = -2.0 * cw;
+            b2 = 1.0 - (alpha * a);
+            a0 = 1.0 + (alpha / a);
+            a1 = -2.0 * cw;
+            a2 = 1.0 - (alpha / a);
+            break;
+        }
+        case AUDIO_DSP_FILTER_LOW_SHELF:
+        {
+            b0 = a * (((a + 1.0) - ((a - 1.0) * cw)) + beta);
+            b1 = 2.0 * a * ((a - 1.0) - ((a + 1.0) * cw));
+            b2 = a * (((a + 1.0) - ((a - 1.0) * cw)) - beta);
+            a0 = ((a + 1.0) + ((a - 1.0) * cw)) + beta;
+            a1 = -2.0 * ((a - 1.0) + ((a + 1.0) * cw));
+            a2 = ((a + 1.0) + ((a - 1.0) * cw)) - beta;
+            break;
+        }
+        case AUDIO_DSP_FILTER_HIGH_SHELF:
+        {
+            b0 = a * (((a + 1.0) + ((a - 1.0) * cw)) + beta);
+            b1 = -2.0 * a * ((a - 1.0) + ((a + 1.0) * cw));
+            b2 = a * (((a + 1.0) + ((a - 1.0) * cw)) - beta);
+            a0 = ((a + 1.0) - ((a - 1.0) * cw)) + beta;
+            a1 = 2.0 * ((a - 1.0) - ((a + 1.0) * cw));
+            a2 = ((a + 1.0) - ((a - 1.0) * cw)) - beta;
+            break;
+        }
+        case AUDIO_DSP_FILTER_LOW_PASS:
+        {
+            b0 = (1.0 - cw) * 0.5;
+            b1 = 1.0 - cw;
+            b2 = (1.0 - cw) * 0.5;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cw;
+            a2 = 1.0 - alpha;
+            break;
+        }
+        case AUDIO_DSP_FILTER_HIGH_PASS:
+        {
+            b0 = (1.0 + cw) * 0.5;
+            b1 = -(1.0 + cw);
+            b2 = (1.0 + cw) * 0.5;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cw;
+            a2 = 1.0 - alpha;
+            break;
+        }
+        default:
+        {
+            /* unity */
+            b0 = 1.0;
+            b1 = 0.0;
+            b2 = 0.0;
+            a0 = 1.0;
+            a1 = 0.0;
+            a2 = 0.0;
+            break;
+        }
+    }
+
+    p_coef->b0 = quantise(b0 / a0);
+    p_coef->b1 = quantise(b1 / a0);
+    p_coef->b2 = quantise(b2 / a0);
+    p_coef->a1 = quantise(a1 / a0);
+    p_coef->a2 = quantise(a2 / a0);
+}
+/***********************************************************************************************************************
+ End of function design_biquad
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: biquad_block
+ * Description  : Direct form I biquad over one channel of a period. The fraction dropped when rounding each output is
+ *                carried into the next, which keeps low frequency bands quiet at Q28.
+ * Arguments    : const st_dsp_biquad_t *p_coef - coefficients
+ *                st_dsp_biquad_state_t *p_state - channel history
+ *                int32_t *p_samples - first sample of the channel, stereo interleaved
+ *                uint32_t frames - frames in the period
+ * Return Value : none
+ **********************************************************************************************************************/
+static void biquad_block (const st_dsp_biquad_t *p_coef, st_dsp_biquad_state_t *p_state, int32_t *p_samples,
+        uint32_t frames)
+{
+    const int64_t b0 = p_coef->b0;
+    const int64_t b1 = p_coef->b1;
+    const int64_t b2 = p_coef->b2;
+    const int64_t a1 = p_coef->a1;
+    const int64_t a2 = p_coef->a2;
+    int32_t x1 = p_state->x1;
+    int32_t x2 = p_state->x2;
+    int32_t y1 = p_state->y1;
+    int32_t y2 = p_state->y2;
+    uint32_t err = p_state->err;
+    int64_t acc;
+    int32_t x;
+    int32_t y;
+
+    while (0u != frames)
+    {
+        x = *p_samples;
+
+        acc = (int64_t) err + (b0 * x) + (b1 * x1) + (b2 * x2) - (a1 * y1) - (a2 * y2);
+        err = ((uint32_t) acc) & DSP_PRV_COEF_FRAC_MASK;
+        acc >>= DSP_PRV_COEF_SHIFT;
+
+        if (acc > INT32_MAX)
+        {
+            y = INT32_MAX;
+        }
+        else if (acc < INT32_MIN)
+        {
+            y = INT32_MIN;
+        }
+        else
+        {
+            y = (int32_t) acc;
+        }
+
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+
+        *p_samples = y;
+        p_samples += 2;
+        frames--;
+    }
+
+    p_state->x1 = x1;
+    p_state->x2 = x2;
+    p_state->y1 = y1;
+    p_state->y2 = y2;
+    p_state->err = err;
+}
+/***********************************************************************************************************************
+ End of function biquad_block
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: scale_out
+ * Description  : Restores the headroom shift with saturation
+ * Arguments    : int32_t sample - sample inside the chain
+ * Return Value : output sample
+ **********************************************************************************************************************/
+static int32_t scale_out (int32_t sample)
+{
+    if (sample > (INT32_MAX >> DSP_PRV_HEADROOM_BITS))
+    {
+        return (INT32_MAX);
+    }
+
+    if (sample < (INT32_MIN >> DSP_PRV_HEADROOM_BITS))
+    {
+        return (INT32_MIN);
+    }
+
+    return ((int32_t) ((uint32_t) sample << DSP_PRV_HEADROOM_BITS));
+}
+/***********************************************************************************************************************
+ End of function scale_out
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: limiter_block
+ * Description  : Stereo linked look-ahead limiter. A peak over the threshold starts a gain ramp that reaches the gain
+ *                it needs before the peak leaves the delay line, and the gain is held there until it has. The gain
+ *                then recovers with a one pole release. Only a new, larger peak costs a division.
+ * Arguments    : p_audio_dsp_t p_dsp - chain
+ *                int32_t *p_samples - stereo frames, replaced by the delayed, limited and rescaled output
+ *                uint32_t frames - frames in the period
+ * Return Value : none
+ **********************************************************************************************************************/
+static void limiter_block (p_audio_dsp_t p_dsp, int32_t *p_samples, uint32_t frames)
+{
+    const st_dsp_coefs_t *p_coefs = &p_dsp->active;
+    int32_t *p_delay;
+    int32_t gain = p_dsp->gain;
+    int32_t left;
+    int32_t right;
+    int32_t needed;
+    int32_t step;
+    uint32_t peak;
+    uint32_t mag;
+    float ratio;
+
+    while (0u != frames)
+    {
+        left = p_samples[0];
+        right = p_samples[1];
+
+        peak = (left < 0) ? (0u - (uint32_t) left) : (uint32_t) left;
+        mag = (right < 0) ? (0u - (uint32_t) right) : (uint32_t) right;
+        peak = (mag > peak) ? mag : peak;
+
+        if (peak > (uint32_t) p_coefs->threshold)
+        {
+            if ((0u == p_dsp->hold) || (peak > p_dsp->peak_held))
+            {
+                ratio = p_coefs->threshold_q31 / (float) peak;
+                needed = (ratio >= (float) DSP_PRV_GAIN_ONE) ? DSP_PRV_GAIN_ONE : (int32_t) ratio;
+
+                if ((0u == p_dsp->hold) || (needed < p_dsp->gain_target))
+                {
+                    step = (gain > needed) ?
+                            (int32_t) ((((uint32_t) (gain - needed)) + (AUDIO_DSP_LOOKAHEAD_FRAMES - 1u))
+                                    / AUDIO_DSP_LOOKAHEAD_FRAMES) : 0;
+
+                    /* never slow a ramp that is still needed for an earlier peak already in the delay */
+                    if ((0u != p_dsp->hold) && (gain > p_dsp->gain_target) && (p_dsp->gain_step > step))
+                    {
+                        step = p_dsp->gain_step;
+                    }
+
+                    p_dsp->gain_target = needed;
+                    p_dsp->peak_held = peak;
+                    p_dsp->gain_step = step;
+                }
+            }
+
+            /* one more than the delay so the gain cannot start to recover as the peak goes out */
+            p_dsp->hold = AUDIO_DSP_LOOKAHEAD_FRAMES + 1u;
+        }
+
+        if (0u != p_dsp->hold)
+        {
+            p_dsp->hold--;
+
+            if (gain > p_dsp->gain_target)
+            {
+                gain = ((gain - p_dsp->gain_target) > p_dsp->gain_step) ? (gain - p_dsp->gain_step) :
+                        p_dsp->gain_target;
+            }
+            else
+            {
+                gain += (int32_t) (((int64_t) (DSP_PRV_GAIN_ONE - gain) * p_coefs->release) >> 31);
+                gain = (gain > p_dsp->gain_target) ? p_dsp->gain_target : gain;
+            }
+        }
+        else
+        {
+            gain += (int32_t) (((int64_t) (DSP_PRV_GAIN_ONE - gain) * p_coefs->release) >> 31);
+        }
+
+        p_delay = &p_dsp->delay[p_dsp->delay_pos * 2u];
+
+        p_samples[0] = scale_out((int32_t) (((int64_t) p_delay[0] * gain) >> 31));
+        p_samples[1] = scale_out((int32_t) (((int64_t) p_delay[1] * gain) >> 31));
+        p_delay[0] = left;
+        p_delay[1] = right;
+
+        p_dsp->delay_pos = (p_dsp->delay_pos + 1u) & (AUDIO_DSP_LOOKAHEAD_FRAMES - 1u);
+        p_samples += 2;
+        frames--;
+    }
+
+    p_dsp->gain = gain;
+}
+/***********************************************************************************************************************
+ End of function limiter_block
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: reset_limiter
+ * Description  : Empties the look-ahead and restores unity gain
+ * Arguments    : p_audio_dsp_t p_dsp - chain
+ * Return Value : none
+ **********************************************************************************************************************/
+static void reset_limiter (p_audio_dsp_t p_dsp)
+{
+    memset(p_dsp->delay, 0, sizeof(p_dsp->delay));
+    p_dsp->delay_pos = 0u;
+    p_dsp->gain = DSP_PRV_GAIN_ONE;
+    p_dsp->gain_target = DSP_PRV_GAIN_ONE;
+    p_dsp->gain_step = 0;
+    p_dsp->peak_held = 0u;
+    p_dsp->hold = 0u;
+}
+/***********************************************************************************************************************
+ End of function reset_limiter
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: take_pending
+ * Description  : Switches to the coefficients queued by r_audio_dsp_configure. History of stages that were off is
+ *                cleared so they do not start from stale samples.
+ * Arguments    : p_audio_dsp_t p_dsp - chain
+ * Return Value : none
+ **********************************************************************************************************************/
+static void take_pending (p_audio_dsp_t p_dsp)
+{
+    st_dsp_coefs_t previous = p_dsp->active;
+    uint32_t band;
+
+    R_OS_EnterCritical();
+    p_dsp->active = p_dsp->pending;
+    p_dsp->pending_valid = false;
+    R_OS_ExitCritical();
+
+    if (false == previous.enable)
+    {
+        r_audio_dsp_reset(p_dsp);
+        return;
+    }
+
+    for (band = 0u; band < AUDIO_DSP_EQ_BANDS; band++)
+    {
+        if ((false == previous.eq_on[band]) && (false != p_dsp->active.eq_on[band]))
+        {
+            memset(p_dsp->eq_state[band], 0, sizeof(p_dsp->eq_state[band]));
+        }
+    }
+
+    if ((false == previous.crossover_on) && (false != p_dsp->active.crossover_on))
+    {
+        memset(p_dsp->crossover_state, 0, sizeof(p_dsp->crossover_state));
+    }
+
+    if ((false == previous.limiter_on) && (false != p_dsp->active.limiter_on))
+    {
+        reset_limiter(p_dsp);
+    }
+}
+/***********************************************************************************************************************
+ End of function take_pending
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_dsp_create
+ * Description  : Allocates a bypassed chain
+ * Arguments    : uint32_t sample_rate - rate of the periods that will be processed
+ * Return Value : the chain, NULL if memory ran out
+ **********************************************************************************************************************/
+p_audio_dsp_t r_audio_dsp_create (uint32_t sample_rate)
+{
+    p_audio_dsp_t p_dsp;
+
+    if (0u == sample_rate)
+    {
+        return (NULL);
+    }
+
+    p_dsp = R_OS_AllocMem(sizeof(st_audio_dsp_t), R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL != p_dsp)
+    {
+        memset(p_dsp, 0, sizeof(st_audio_dsp_t));
+        p_dsp->sample_rate = sample_rate;
+        r_audio_dsp_default_config( &p_dsp->config);
+        r_audio_dsp_reset(p_dsp);
+    }
+
+    return (p_dsp);
+}
+/***********************************************************************************************************************
+ End of function r_audio_dsp_create
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_dsp_destroy
+ * Description  : Frees the chain
+ * Arguments    : p_audio_dsp_t p_dsp - chain, may be NULL
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_dsp_destroy (p_audio_dsp_t p_dsp)
+{
+    if (NULL != p_dsp)
+    {
+        R_OS_FreeMem(p_dsp);
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_dsp_destroy
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_dsp_reset
+ * Description  : Clears all filter and limiter history
+ * Arguments    : p_audio_dsp_t p_dsp - chain
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_dsp_reset (p_audio_dsp_t p_dsp)
+{
+    memset(p_dsp->eq_state, 0, sizeof(p_dsp->eq_state));
+    memset(p_dsp->crossover_state, 0, sizeof(p_dsp->crossover_state));
+    reset_limiter(p_dsp);
+}
+/***********************************************************************************************************************
+ End of function r_audio_dsp_reset
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_dsp_default_config
+ * Description  : Bypassed chain with flat bands, crossover at 2 kHz and the limiter 1 dB below full scale
+ * Arguments    : st_audio_dsp_config_t *p_config - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_dsp_default_config (st_audio_dsp_config_t *p_config)
+{
+    uint32_t band;
+
+    memset(p_config, 0, sizeof(st_audio_dsp_config_t));
+
+    for (band = 0u; band < AUDIO_DSP_EQ_BANDS; band++)
+    {
+        p_config->eq[band].type = AUDIO_DSP_FILTER_OFF;
+        p_config->eq[band].freq_hz = gs_default_freq[band];
+        p_config->eq[band].gain_db = 0.0f;
+        p_config->eq[band].q = (float) DSP_PRV_BUTTERWORTH_Q;
+    }
+
+    p_config->enable = false;
+    p_config->crossover_enable = false;
+    p_config->crossover_hz = 2000.0f;
+    p_config->limiter_enable = false;
+    p_config->limiter_threshold_db = -1.0f;
+    p_config->limiter_release_ms = 100.0f;
+}
+/***********************************************************************************************************************
+ End of function r_audio_dsp_default_config
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_dsp_configure
+ * Description  : Checks the settings, calculates the coefficients in the caller's task and queues them for the start
+ *                of the next period
+ * Arguments    : p_audio_dsp_t p_dsp - chain
+ *                const st_audio_dsp_config_t *p_config - settings
+ * Return Value : DEVDRV_SUCCESS or DEVDRV_ERROR if a setting is out of range
+ **********************************************************************************************************************/
+int32_t r_audio_dsp_configure (p_audio_dsp_t p_dsp, const st_audio_dsp_config_t *p_config)
+{
+    st_dsp_coefs_t coefs;
+    const st_audio_dsp_band_t *p_band;
+    float max_freq = (float) p_dsp->sample_rate * DSP_PRV_FREQ_MAX_RATIO;
+    double threshold;
+    uint32_t band;
+
+    memset( &coefs, 0, sizeof(coefs));
+
+    for (band = 0u; band < AUDIO_DSP_EQ_BANDS; band++)
+    {
+        p_band = &p_config->eq[band];
+
+        if (p_band->type >= AUDIO_DSP_FILTER_COUNT)
+        {
+            return (DEVDRV_ERROR);
+        }
+
+        if (AUDIO_DSP_FILTER_OFF != p_band->type)
+        {
+            if ((p_band->freq_hz < DSP_PRV_FREQ_MIN_HZ) || (p_band->freq_hz > max_freq)
+                    || (p_band->q < DSP_PRV_Q_MIN) || (p_band->q > DSP_PRV_Q_MAX)
+                    || (fabsf(p_band->gain_db) > AUDIO_DSP_EQ_GAIN_MAX_DB))
+            {
+                return (DEVDRV_ERROR);
+            }
+
+            coefs.eq_on[band] = true;
+            design_biquad( &coefs.eq[band], p_band->type, (double) p_band->freq_hz, (double) p_band->gain_db,
+                    (double) p_band->q, (double) p_dsp->sample_rate);
+        }
+    }
+
+    if (false != p_config->crossover_enable)
+    {
+        if ((p_config->crossover_hz < DSP_PRV_CROSSOVER_MIN_HZ) || (p_config->crossover_hz > max_freq))
+        {
+            return (DEVDRV_ERROR);
+        }
+
+        coefs.crossover_on = true;
+        design_biquad( &coefs.crossover_low, AUDIO_DSP_FILTER_LOW_PASS, (double) p_config->crossover_hz, 0.0,
+                DSP_PRV_BUTTERWORTH_Q, (double) p_dsp->sample_rate);
+        design_biquad( &coefs.crossover_high, AUDIO_DSP_FILTER_HIGH_PASS, (double) p_config->crossover_hz, 0.0,
+                DSP_PRV_BUTTERWORTH_Q, (double) p_dsp->sample_rate);
+    }
+
+    if (false != p_config->limiter_enable)
+    {
+        if ((p_config->limiter_threshold_db < DSP_PRV_THRESHOLD_MIN_DB) || (p_config->limiter_threshold_db > 0.0f)
+                || (p_config->limiter_release_ms < DSP_PRV_RELEASE_MIN_MS)
+                || (p_config->limiter_release_ms > DSP_PRV_RELEASE_MAX_MS))
+        {
+            return (DEVDRV_ERROR);
+        }
+
+        threshold = pow(10.0, (double) p_config->limiter_threshold_db / 20.0)
+                * (double) (INT32_MAX >> DSP_PRV_HEADROOM_BITS);
+
+        coefs.limiter_on = true;
+        coefs.threshold = (int32_t) threshold;
+        coefs.threshold_q31 = (float) (threshold * DSP_PRV_Q31);
+        coefs.release = (int32_t) ((1.0 - exp( -1000.0 / ((double) p_config->limiter_release_ms
+                * (double) p_dsp->sample_rate))) * DSP_PRV_Q31);
+    }
+
+    coefs.enable = p_config->enable;
+
+    R_OS_EnterCritical();
+    p_dsp->pending = coefs;
+    p_dsp->pending_valid = true;
+    p_dsp->config = *p_config;
+    R_OS_ExitCritical();
+
+    return (DEVDRV_SUCCESS);
+}
+/***********************************************************************************************************************
+ End of function r_audio_dsp_configure
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_dsp_get_config
+ * Description  : Copies the last accepted settings
+ * Arguments    : p_audio_dsp_t p_dsp - chain
+ *                st_audio_dsp_config_t *p_config - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_dsp_get_config (p_audio_dsp_t p_dsp, st_audio_dsp_config_t *p_config)
+{
+    R_OS_EnterCritical();
+    *p_config = p_dsp->config;
+    R_OS_ExitCritical();
+}
+/***********************************************************************************************************************
+ End of function r_audio_dsp_get_config
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_dsp_process
+ * Description  : Runs each enabled stage over the whole period in turn
+ * Arguments    : p_audio_dsp_t p_dsp - chain
+ *                uint32_t *p_period - left justified 32 bit stereo frames, processed in place
+ *                uint32_t frames - frames in the period
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_dsp_process (p_audio_dsp_t p_dsp, uint32_t *p_period, uint32_t frames)
+{
+    const st_dsp_coefs_t *p_coefs = &p_dsp->active;
+    int32_t *p_samples = (int32_t *) p_period;
+    uint32_t band;
+    uint32_t i;
+
+    if (false != p_dsp->pending_valid)
+    {
+        take_pending(p_dsp);
+    }
+
+    if (false == p_coefs->enable)
+    {
+        return;
+    }
+
+    for (i = 0u; i < (frames * 2u); i++)
+    {
+        p_samples[i] >>= DSP_PRV_HEADROOM_BITS;
+    }
+
+    for (band = 0u; band < AUDIO_DSP_EQ_BANDS; band++)
+    {
+        if (false != p_coefs->eq_on[band])
+        {
+            biquad_block( &p_coefs->eq[band], &p_dsp->eq_state[band][0], p_samples, frames);
+            biquad_block( &p_coefs->eq[band], &p_dsp->eq_state[band][1], p_samples + 1, frames);
+        }
+    }
+
+    if (false != p_coefs->crossover_on)
+    {
+        /* both slots carry the mono sum, then each is filtered to its band */
+        for (i = 0u; i < (frames * 2u); i += 2u)
+        {
+            p_samples[i] = (p_samples[i] >> 1) + (p_samples[i + 1u] >> 1);
+            p_samples[i + 1u] = p_samples[i];
+        }
+
+        biquad_block( &p_coefs->crossover_low, &p_dsp->crossover_state[0], p_samples, frames);
+        biquad_block( &p_coefs->crossover_low, &p_dsp->crossover_state[1], p_samples, frames);
+        biquad_block( &p_coefs->crossover_high, &p_dsp->crossover_state[2], p_samples + 1, frames);
+        biquad_block( &p_coefs->crossover_high, &p_dsp->crossover_state[3], p_samples + 1, frames);
+    }
+
+    if (false != p_coefs->limiter_on)
+    {
+        limiter_block(p_dsp, p_samples, frames);
+    }
+    else
+    {
+        for (i = 0u; i < (frames * 2u); i++)
+        {
+            p_samples[i] = scale_out(p_samples[i]);
+        }
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_dsp_process
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_dsp_filter_name
+ * Description  : Name of a band type
+ * Arguments    : e_audio_dsp_filter_t type - band type
+ * Return Value : name, "?" if out of range
+ **********************************************************************************************************************/
+const char_t *r_audio_dsp_filter_name (e_audio_dsp_filter_t type)
+{
+    if (type >= AUDIO_DSP_FILTER_COUNT)
+    {
+        return ("?");
+    }
+
+    return (gs_filter_names[type]);
+}
+/***********************************************************************************************************************
+ End of function r_audio_dsp_filter_name
+ **********************************************************************************************************************/
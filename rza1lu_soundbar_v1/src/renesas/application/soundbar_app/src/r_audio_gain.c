@@ -0,0 +1,132 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ ******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.  */
+/******************************************************************************
+ * File Name    : r_audio_gain.c
+ * Device(s)    : RZ/A1L
+ * Tool-Chain   : GNUARM-NONE-EABI-v16.01
+ * H/W Platform : Stream it! v2 board
+ * Description  : dB to Q23 gain table
+ ******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 13.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ *****************************************************************************/
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+#include "r_typedefs.h"
+
+#include "r_audio_gain.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+#define AUDIO_GAIN_PRV_ENTRIES      (1 - AUDIO_GAIN_DB_TO_STEPS(AUDIO_GAIN_MIN_DB))
+
+/******************************************************************************
+ Private global variables and functions
+ ******************************************************************************/
+/* round(10^(-n / (20 * AUDIO_GAIN_STEPS_PER_DB)) * 2^23) for n = 0 .. 400 */
+static const int32_t gs_gain_q23[AUDIO_GAIN_PRV_ENTRIES] =
+{
+    8388608, 8150606, 7919357, 7694668, 7476355, 7264235, 7058134, 6857880,
+    6663308, 6474256, 6290569, 6112092, 5938680, 5770187, 5606475, 5447408,
+    5292854, 5142685, 4996776, 4855007, 4717261, 4583423, 4453381, 4327030,
+    4204263, 4084980, 3969080, 3856469, 3747054, 3640742, 3537447, 3437082,
+    3339565, 3244815, 3152753, 3063303, 2976390, 2891944, 2809894, 2730171,
+    2652711, 2577448, 2504320, 2433268, 2364231, 2297153, 2231978, 2168652,
+    2107123, 2047340, 1989252, 1932813, 1877975, 1824693, 1772923, 1722622,
+    1673747, 1626260, 1580119, 1535288, 1491729, 1449405, 1408283, 1368327,
+    1329505, 1291784, 1255133, 1219523, 1184922, 1151304, 1118639, 1086901,
+    1056063, 1026101,  996988,  968701,  941217,  914513,  888566,  863356,
+     838861,  815061,  791936,  769467,  747635,  726424,  705813,  685788,
+     666331,  647426,  629057,  611209,  593868,  577019,  560648,  544741,
+     529285,  514268,  499678,  485501,  471726,  458342,  445338,  432703,
+     420426,  408498,  396908,  385647,  374705,  364074,  353745,  343708,
+     333956,  324481,  315275,  306330,  297639,  289194,  280989,  273017,
+     265271,  257745,  250432,  243327,  236423,  229715,  223198,  216865,
+     210712,  204734,  198925,  193281,  187798,  182469,  177292,  172262,
+     167375,  162626,  158012,  153529,  149173,  144941,  140828,  136833,
+     132950,  129178,  125513,  121952,  118492,  115130,  111864,  108690,
+     105606,  102610,   99699,   96870,   94122,   91451,   88857,   86336,
+      83886,   81506,   79194,   76947,   74764,   72642,   70581,   68579,
+      66633,   64743,   62906,   61121,   59387,   57702,   56065,   54474,
+      52929,   51427,   49968,   48550,   47173,   45834,   44534,   43270,
+      42043,   40850,   39691,   38565,   37471,   36407,   35374,   34371,
+      33396,   32448,   31528,   30633,   29764,   28919,   28099,   27302,
+      26527,   25774,   25043,   24333,   23642,   22972,   22320,   21687,
+      21071,   20473,   19893,   19328,   18780,   18247,   17729,   17226,
+      16737,   16263,   15801,   15353,   14917,   14494,   14083,   13683,
+      13295,   12918,   12551,   12195,   11849,   11513,   11186,   10869,
+      10561,   10261,    9970,    9687,    9412,    9145,    8886,    8634,
+       8389,    8151,    7919,    7695,    7476,    7264,    7058,    6858,
+       6663,    6474,    6291,    6112,    5939,    5770,    5606,    5447,
+       5293,    5143,    4997,    4855,    4717,    4583,    4453,    4327,
+       4204,    4085,    3969,    3856,    3747,    3641,    3537,    3437,
+       3340,    3245,    3153,    3063,    2976,    2892,    2810,    2730,
+       2653,    2577,    2504,    2433,    2364,    2297,    2232,    2169,
+       2107,    2047,    1989,    1933,    1878,    1825,    1773,    1723,
+       1674,    1626,    1580,    1535,    1492,    1449,    1408,    1368,
+       1330,    1292,    1255,    1220,    1185,    1151,    1119,    1087,
+       1056,    1026,     997,     969,     941,     915,     889,     863,
+        839,     815,     792,     769,     748,     726,     706,     686,
+        666,     647,     629,     611,     594,     577,     561,     545,
+        529,     514,     500,     486,     472,     458,     445,     433,
+        420,     408,     397,     386,     375,     364,     354,     344,
+        334,     324,     315,     306,     298,     289,     281,     273,
+        265,     258,     250,     243,     236,     230,     223,     217,
+        211,     205,     199,     193,     188,     182,     177,     172,
+        167,     163,     158,     154,     149,     145,     141,     137,
+        133,     129,     126,     122,     118,     115,     112,     109,
+        106,     103,     100,      97,      94,      91,      89,      86,
+         84
+};
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_gain_q23
+ * Description  : Looks up the linear gain of an attenuation
+ * Arguments    : int32_t steps - attenuation in quarter dB, 0 or below
+ * Return Value : Q23 gain
+ **********************************************************************************************************************/
+int32_t r_audio_gain_q23 (int32_t steps)
+{
+    if (steps > 0)
+    {
+        steps = 0;
+    }
+
+    if (steps < AUDIO_GAIN_DB_TO_STEPS(AUDIO_GAIN_MIN_DB))
+    {
+        steps = AUDIO_GAIN_DB_TO_STEPS(AUDIO_GAIN_MIN_DB);
+    }
+
+    return (gs_gain_q23[ -steps]);
+}
+/***********************************************************************************************************************
+ End of function r_audio_gain_q23
+ **********************************************************************************************************************/
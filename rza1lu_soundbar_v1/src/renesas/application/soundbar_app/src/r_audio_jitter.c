@@ -0,0 +1,899 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ ******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.  */
+/******************************************************************************
+ * File Name    : r_audio_jitter.c
+ * Device(s)    : RZ/A1L
+ * Tool-Chain   : GNUARM-NONE-EABI-v16.01
+ * H/W Platform : Stream it! v2 board
+ * Description  : Adaptive jitter buffer with packet loss concealment and
+ *                clock drift estimation for packetised PCM
+ ******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 13.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ *****************************************************************************/
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+#include <string.h>
+
+#include "r_typedefs.h"
+#include "r_os_abstraction_api.h"
+#include "r_task_priority.h"
+
+#include "r_audio_jitter.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+#define JITTER_PRV_SLOT_MASK            (AUDIO_JITTER_SLOTS - 1u)
+
+/* A sequence jump further than this either way is taken as a new stream */
+#define JITTER_PRV_RESYNC_DISTANCE      (4 * (int32_t) AUDIO_JITTER_SLOTS)
+
+/* Gains are Q15 */
+#define JITTER_PRV_GAIN_ONE             (32768)
+
+/* Consecutive packets concealed before the output is muted */
+#define JITTER_PRV_CONCEAL_MAX          (3u)
+
+/* Interarrival differences are clipped to this before entering the jitter estimate */
+#define JITTER_PRV_MAX_TRANSIT_US       (1000000)
+
+/* Delay target is one packet plus this many times the jitter */
+#define JITTER_PRV_JITTER_MULTIPLE      (4u)
+
+/* Drift loop: depth error averaged over 2^AVG_SHIFT calls, proportional and integral gains as shifts from us to ppm */
+#define JITTER_PRV_AVG_SHIFT            (5)
+#define JITTER_PRV_TRIM_P_SHIFT         (3)
+#define JITTER_PRV_TRIM_I_SHIFT         (13)
+#define JITTER_PRV_TRIM_I_MAX_PPM       (500)
+#define JITTER_PRV_TRIM_MAX_PPM         (1000)
+
+/******************************************************************************
+ Typedef definitions
+ ******************************************************************************/
+typedef enum
+{
+    JITTER_PRV_MODE_NONE = 0,       /* nothing in progress, start the next packet */
+    JITTER_PRV_MODE_PACKET,         /* playing a received packet */
+    JITTER_PRV_MODE_CONCEAL,        /* repeating the last packet in place of a lost one */
+    JITTER_PRV_MODE_FADE_OUT        /* ran dry, repeating the last packet down to silence */
+} e_jitter_mode_t;
+
+typedef struct
+{
+    bool_t   valid;
+    uint16_t seq;
+    uint32_t timestamp;
+    uint32_t frames;
+    uint32_t arrival;
+    uint8_t  data[AUDIO_JITTER_MAX_PAYLOAD];
+} st_jitter_slot_t;
+
+typedef struct st_audio_jitter
+{
+    st_audio_jitter_config_t config;
+    uint32_t frame_bytes;           /* payload bytes per frame */
+    void     *p_mutex;              /* between the receive task and the player */
+    st_jitter_slot_t *p_slots;      /* indexed by sequence number */
+
+    /* stream position */
+    bool_t   synced;                /* ssrc and the sequence numbers below are valid */
+    uint32_t ssrc;
+    uint16_t play_seq;              /* next packet to play */
+    uint32_t play_ts;               /* timestamp of the next frame to play */
+    uint16_t highest_seq;           /* newest packet received */
+    uint32_t highest_ts_end;        /* timestamp just past the newest packet */
+    bool_t   playing;               /* false while (re)buffering */
+
+    /* packet being played, copied out of its slot so it can be repeated */
+    st_jitter_slot_t current;
+    e_jitter_mode_t mode;
+    uint32_t offset;                /* frames of current already played */
+    bool_t   have_last;             /* current holds audio that can be repeated */
+    uint32_t concealed;             /* consecutive packets concealed */
+    int32_t  gain;                  /* Q15, ramps to gain_target over the packet */
+    int32_t  gain_target;
+    int32_t  gain_step;
+
+    /* delay estimation */
+    bool_t   have_transit;
+    uint32_t last_arrival;
+    uint32_t last_ts;
+    uint32_t jitter16;              /* interarrival jitter in us, times 16 */
+    uint32_t packet_frames;         /* frames in the most recent packet */
+    uint32_t boost_us;              /* added to the target after an underrun, decays per packet */
+    int32_t  error_avg_us;          /* averaged depth minus target */
+    int32_t  integral;              /* sum of error_avg_us */
+    int32_t  trim_ppm;
+
+    st_audio_jitter_stats_t stats;
+} st_audio_jitter_t;
+
+/******************************************************************************
+ Private global variables and functions
+ ******************************************************************************/
+static void restart_stream (p_audio_jitter_t p_jb, uint16_t seq, uint32_t timestamp, uint32_t ssrc);
+static void update_jitter (p_audio_jitter_t p_jb, uint32_t timestamp, uint32_t arrival);
+static uint32_t frames_to_us (p_audio_jitter_t p_jb, uint32_t frames);
+static uint32_t depth_us (p_audio_jitter_t p_jb);
+static uint32_t target_us (p_audio_jitter_t p_jb);
+static bool_t start_packet (p_audio_jitter_t p_jb, uint32_t playout, uint32_t produced);
+static void start_conceal (p_audio_jitter_t p_jb, e_jitter_mode_t mode);
+static void play_frames (p_audio_jitter_t p_jb, uint32_t *p_dst, uint32_t frames);
+static void update_trim (p_audio_jitter_t p_jb);
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_jitter_create
+ * Description  : Allocates the packet slots and the lock
+ * Arguments    : const st_audio_jitter_config_t *p_config - settings
+ * Return Value : the buffer, NULL on failure
+ **********************************************************************************************************************/
+p_audio_jitter_t r_audio_jitter_create (const st_audio_jitter_config_t *p_config)
+{
+    p_audio_jitter_t p_jb;
+
+    if ((0u == p_config->format.sample_rate) || (0u == p_config->counts_per_us)
+            || ((16u != p_config->format.bits_per_sample) && (24u != p_config->format.bits_per_sample))
+            || ((1u != p_config->format.channels) && (2u != p_config->format.channels))
+            || (p_config->min_delay_ms > p_config->max_delay_ms))
+    {
+        return (NULL);
+    }
+
+    p_jb = R_OS_AllocMem(sizeof(st_audio_jitter_t), R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL == p_jb)
+    {
+        return (NULL);
+    }
+
+    memset(p_jb, 0, sizeof(st_audio_jitter_t));
+    p_jb->config = *p_config;
+    p_jb->frame_bytes = (p_config->format.bits_per_sample / 8u) * p_config->format.channels;
+    p_jb->p_slots = R_OS_AllocMem(AUDIO_JITTER_SLOTS * sizeof(st_jitter_slot_t), R_REGION_LARGE_CAPACITY_RAM);
+    p_jb->p_mutex = R_OS_CreateMutex();
+
+    if ((NULL == p_jb->p_slots) || (NULL == p_jb->p_mutex))
+    {
+        r_audio_jitter_destroy(p_jb);
+        return (NULL);
+    }
+
+    memset(p_jb->p_slots, 0, AUDIO_JITTER_SLOTS * sizeof(st_jitter_slot_t));
+    r_audio_jitter_reset_stats(p_jb);
+
+    return (p_jb);
+}
+/***********************************************************************************************************************
+ End of function r_audio_jitter_create
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_jitter_destroy
+ * Description  : Frees the buffer
+ * Arguments    : p_audio_jitter_t p_jb - buffer, may be NULL
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_jitter_destroy (p_audio_jitter_t p_jb)
+{
+    if (NULL != p_jb)
+    {
+        if (NULL != p_jb->p_mutex)
+        {
+            R_OS_DeleteMutex(p_jb->p_mutex);
+        }
+
+        if (NULL != p_jb->p_slots)
+        {
+            R_OS_FreeMem(p_jb->p_slots);
+        }
+
+        R_OS_FreeMem(p_jb);
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_jitter_destroy
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_jitter_reset
+ * Description  : Drops every packet, the next packet received starts a new stream
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_jitter_reset (p_audio_jitter_t p_jb)
+{
+    R_OS_AcquireMutex(p_jb->p_mutex);
+
+    memset(p_jb->p_slots, 0, AUDIO_JITTER_SLOTS * sizeof(st_jitter_slot_t));
+    p_jb->synced = false;
+    p_jb->playing = false;
+    p_jb->mode = JITTER_PRV_MODE_NONE;
+    p_jb->have_last = false;
+    p_jb->trim_ppm = 0;
+
+    R_OS_ReleaseMutex(p_jb->p_mutex);
+}
+/***********************************************************************************************************************
+ End of function r_audio_jitter_reset
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_jitter_put
+ * Description  : Stores a packet in the slot for its sequence number. Packets behind the playout point are late,
+ *                packets too far ahead push the playout point forward, and a new SSRC or a large jump restarts
+ *                the stream.
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ *                uint16_t seq - sequence number
+ *                uint32_t timestamp - timestamp of the first frame
+ *                uint32_t ssrc - synchronisation source
+ *                const uint8_t *p_payload - PCM payload
+ *                uint32_t bytes - payload length
+ *                uint32_t arrival - timer count on receipt
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_jitter_put (p_audio_jitter_t p_jb, uint16_t seq, uint32_t timestamp, uint32_t ssrc,
+        const uint8_t *p_payload, uint32_t bytes, uint32_t arrival)
+{
+    st_jitter_slot_t *p_slot;
+    uint32_t frames;
+    int32_t ahead;
+
+    if (bytes > AUDIO_JITTER_MAX_PAYLOAD)
+    {
+        bytes = AUDIO_JITTER_MAX_PAYLOAD;
+    }
+
+    frames = bytes / p_jb->frame_bytes;
+
+    if (0u == frames)
+    {
+        return;
+    }
+
+    R_OS_AcquireMutex(p_jb->p_mutex);
+
+    if ((false == p_jb->synced) || (ssrc != p_jb->ssrc))
+    {
+        restart_stream(p_jb, seq, timestamp, ssrc);
+    }
+
+    ahead = (int32_t) (int16_t) (uint16_t) (seq - p_jb->play_seq);
+
+    if ((ahead >= JITTER_PRV_RESYNC_DISTANCE) || (ahead <= (-JITTER_PRV_RESYNC_DISTANCE)))
+    {
+        restart_stream(p_jb, seq, timestamp, ssrc);
+        ahead = 0;
+    }
+
+    if (ahead < 0)
+    {
+        if ((false != p_jb->have_last)
+                || ((int32_t) (int16_t) (uint16_t) (p_jb->highest_seq - seq) >= (int32_t) JITTER_PRV_SLOT_MASK))
+        {
+            p_jb->stats.late++;
+            R_OS_ReleaseMutex(p_jb->p_mutex);
+            return;
+        }
+
+        /* nothing played yet, an earlier packet moves the start back */
+        p_jb->play_seq = seq;
+        p_jb->play_ts = timestamp;
+        ahead = 0;
+    }
+
+    /* keep the slot window ahead of the playout point, dropping what it passes */
+    while (ahead >= (int32_t) AUDIO_JITTER_SLOTS)
+    {
+        p_slot = &p_jb->p_slots[p_jb->play_seq & JITTER_PRV_SLOT_MASK];
+
+        if ((false != p_slot->valid) && (p_slot->seq == p_jb->play_seq))
+        {
+            p_slot->valid = false;
+            p_jb->stats.overflows++;
+        }
+
+        p_jb->play_seq++;
+        ahead--;
+    }
+
+    p_slot = &p_jb->p_slots[seq & JITTER_PRV_SLOT_MASK];
+
+    if ((false != p_slot->valid) && (p_slot->seq == seq))
+    {
+        p_jb->stats.duplicates++;
+        R_OS_ReleaseMutex(p_jb->p_mutex);
+        return;
+    }
+
+    p_slot->valid = true;
+    p_slot->seq = seq;
+    p_slot->timestamp = timestamp;
+    p_slot->frames = frames;
+    p_slot->arrival = arrival;
+    memcpy(p_slot->data, p_payload, frames * p_jb->frame_bytes);
+
+    p_jb->stats.packets++;
+    p_jb->packet_frames = frames;
+
+    /* only packets in order feed the jitter estimate and move the newest point */
+    if ((int16_t) (uint16_t) (seq - p_jb->highest_seq) > 0)
+    {
+        update_jitter(p_jb, timestamp, arrival);
+        p_jb->highest_seq = seq;
+        p_jb->highest_ts_end = timestamp + frames;
+    }
+    else if (seq == p_jb->highest_seq)
+    {
+        /* first packet of the stream */
+        update_jitter(p_jb, timestamp, arrival);
+        p_jb->highest_ts_end = timestamp + frames;
+    }
+    else
+    {
+        /* reordered, already accounted for by a newer packet */
+    }
+
+    R_OS_ReleaseMutex(p_jb->p_mutex);
+}
+/***********************************************************************************************************************
+ End of function r_audio_jitter_put
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_jitter_get
+ * Description  : Plays out whole packets in sequence order. Output is silence until the buffer reaches its target
+ *                delay. A missing packet with newer ones behind it is concealed; with nothing behind it the buffer
+ *                has run dry, the output fades out and the buffer refills to a raised target.
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ *                uint32_t *p_frames - destination, 32 bit stereo
+ *                uint32_t frames - frames wanted
+ *                uint32_t playout - timer count at which the first frame will be heard
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_jitter_get (p_audio_jitter_t p_jb, uint32_t *p_frames, uint32_t frames, uint32_t playout)
+{
+    st_jitter_slot_t *p_slot;
+    uint32_t produced = 0u;
+    uint32_t count;
+
+    R_OS_AcquireMutex(p_jb->p_mutex);
+
+    while (produced < frames)
+    {
+        if (JITTER_PRV_MODE_NONE == p_jb->mode)
+        {
+            if (false == p_jb->playing)
+            {
+                if ((false == p_jb->synced) || (depth_us(p_jb) < target_us(p_jb)))
+                {
+                    break;
+                }
+
+                /* enough is buffered, play from the first packet that arrived */
+                while ((int16_t) (uint16_t) (p_jb->highest_seq - p_jb->play_seq) > 0)
+                {
+                    p_slot = &p_jb->p_slots[p_jb->play_seq & JITTER_PRV_SLOT_MASK];
+
+                    if ((false != p_slot->valid) && (p_slot->seq == p_jb->play_seq))
+                    {
+                        break;
+                    }
+
+                    p_jb->play_seq++;
+                }
+
+                p_jb->playing = true;
+            }
+
+            /* over the maximum delay, drop rather than play late */
+            while ((depth_us(p_jb) > (p_jb->config.max_delay_ms * 1000u))
+                    && ((int16_t) (uint16_t) (p_jb->highest_seq - p_jb->play_seq) > 0))
+            {
+                p_slot = &p_jb->p_slots[p_jb->play_seq & JITTER_PRV_SLOT_MASK];
+
+                if ((false != p_slot->valid) && (p_slot->seq == p_jb->play_seq))
+                {
+                    p_slot->valid = false;
+                    p_jb->stats.overflows++;
+                    p_jb->play_ts = p_slot->timestamp + p_slot->frames;
+                }
+
+                p_jb->play_seq++;
+            }
+
+            if (false == start_packet(p_jb, playout, produced))
+            {
+                if ((int16_t) (uint16_t) (p_jb->highest_seq - p_jb->play_seq) >= 0)
+                {
+                    start_conceal(p_jb, JITTER_PRV_MODE_CONCEAL);
+                }
+                else
+                {
+                    /* ran dry, allow one more packet of delay before playing again */
+                    p_jb->stats.underruns++;
+                    p_jb->boost_us += frames_to_us(p_jb, p_jb->packet_frames);
+
+                    if (p_jb->boost_us > (p_jb->config.max_delay_ms * 1000u))
+                    {
+                        p_jb->boost_us = p_jb->config.max_delay_ms * 1000u;
+                    }
+
+                    start_conceal(p_jb, JITTER_PRV_MODE_FADE_OUT);
+                }
+            }
+        }
+
+        count = p_jb->current.frames - p_jb->offset;
+
+        if (count > (frames - produced))
+        {
+            count = frames - produced;
+        }
+
+        play_frames(p_jb, p_frames + (produced * 2u), count);
+        produced += count;
+
+        if (p_jb->offset == p_jb->current.frames)
+        {
+            p_jb->gain = p_jb->gain_target;
+
+            if (JITTER_PRV_MODE_CONCEAL == p_jb->mode)
+            {
+                p_jb->stats.lost++;
+                p_jb->play_seq++;
+            }
+            else if (JITTER_PRV_MODE_FADE_OUT == p_jb->mode)
+            {
+                p_jb->playing = false;
+            }
+            else
+            {
+                /* packet played */
+            }
+
+            p_jb->mode = JITTER_PRV_MODE_NONE;
+        }
+    }
+
+    if (produced < frames)
+    {
+        memset(p_frames + (produced * 2u), 0, (frames - produced) * 2u * sizeof(uint32_t));
+    }
+
+    update_trim(p_jb);
+
+    R_OS_ReleaseMutex(p_jb->p_mutex);
+}
+/***********************************************************************************************************************
+ End of function r_audio_jitter_get
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_jitter_get_trim
+ * Description  : Reads the rate correction worked out by the last r_audio_jitter_get
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ * Return Value : ppm
+ **********************************************************************************************************************/
+int32_t r_audio_jitter_get_trim (p_audio_jitter_t p_jb)
+{
+    return (p_jb->trim_ppm);
+}
+/***********************************************************************************************************************
+ End of function r_audio_jitter_get_trim
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_jitter_get_stats
+ * Description  : Copies the counters along with the current delay figures
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ *                st_audio_jitter_stats_t *p_stats - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_jitter_get_stats (p_audio_jitter_t p_jb, st_audio_jitter_stats_t *p_stats)
+{
+    R_OS_AcquireMutex(p_jb->p_mutex);
+
+    *p_stats = p_jb->stats;
+    p_stats->jitter_us = p_jb->jitter16 >> 4;
+    p_stats->target_us = target_us(p_jb);
+    p_stats->depth_us = (false != p_jb->synced) ? depth_us(p_jb) : 0u;
+    p_stats->trim_ppm = p_jb->trim_ppm;
+
+    if (0u == p_stats->latency_samples)
+    {
+        p_stats->min_latency_us = 0u;
+    }
+
+    R_OS_ReleaseMutex(p_jb->p_mutex);
+}
+/***********************************************************************************************************************
+ End of function r_audio_jitter_get_stats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_jitter_reset_stats
+ * Description  : Clears the counters and latency figures
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_jitter_reset_stats (p_audio_jitter_t p_jb)
+{
+    R_OS_AcquireMutex(p_jb->p_mutex);
+
+    memset(&p_jb->stats, 0, sizeof(st_audio_jitter_stats_t));
+    p_jb->stats.min_latency_us = 0xFFFFFFFFu;
+
+    R_OS_ReleaseMutex(p_jb->p_mutex);
+}
+/***********************************************************************************************************************
+ End of function r_audio_jitter_reset_stats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: restart_stream
+ * Description  : Drops everything buffered and starts again from a packet. The delay estimate is kept, the network
+ *                has not changed just because the sender restarted.
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ *                uint16_t seq - sequence number of the packet
+ *                uint32_t timestamp - its timestamp
+ *                uint32_t ssrc - its synchronisation source
+ * Return Value : none
+ **********************************************************************************************************************/
+static void restart_stream (p_audio_jitter_t p_jb, uint16_t seq, uint32_t timestamp, uint32_t ssrc)
+{
+    if (false != p_jb->synced)
+    {
+        p_jb->stats.resyncs++;
+        memset(p_jb->p_slots, 0, AUDIO_JITTER_SLOTS * sizeof(st_jitter_slot_t));
+    }
+
+    p_jb->synced = true;
+    p_jb->ssrc = ssrc;
+    p_jb->play_seq = seq;
+    p_jb->play_ts = timestamp;
+    p_jb->highest_seq = seq;
+    p_jb->highest_ts_end = timestamp;
+    p_jb->playing = false;
+    p_jb->mode = JITTER_PRV_MODE_NONE;
+    p_jb->have_last = false;
+    p_jb->concealed = 0u;
+    p_jb->gain = 0;
+    p_jb->have_transit = false;
+    p_jb->error_avg_us = 0;
+    p_jb->integral = 0;
+    p_jb->trim_ppm = 0;
+}
+/***********************************************************************************************************************
+ End of function restart_stream
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: update_jitter
+ * Description  : RFC 3550 interarrival jitter, the change in transit time between consecutive packets averaged with a
+ *                gain of 1/16
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ *                uint32_t timestamp - timestamp of the packet
+ *                uint32_t arrival - timer count on receipt
+ * Return Value : none
+ **********************************************************************************************************************/
+static void update_jitter (p_audio_jitter_t p_jb, uint32_t timestamp, uint32_t arrival)
+{
+    int64_t diff;
+
+    if (false != p_jb->have_transit)
+    {
+        diff = (int64_t) ((arrival - p_jb->last_arrival) / p_jb->config.counts_per_us)
+                - (((int64_t) (int32_t) (timestamp - p_jb->last_ts) * 1000000) / p_jb->config.format.sample_rate);
+
+        if (diff < 0)
+        {
+            diff = -diff;
+        }
+
+        if (diff > JITTER_PRV_MAX_TRANSIT_US)
+        {
+            diff = JITTER_PRV_MAX_TRANSIT_US;
+        }
+
+        p_jb->jitter16 = (p_jb->jitter16 + (uint32_t) diff) - ((p_jb->jitter16 + 8u) >> 4);
+    }
+
+    p_jb->have_transit = true;
+    p_jb->last_arrival = arrival;
+    p_jb->last_ts = timestamp;
+}
+/***********************************************************************************************************************
+ End of function update_jitter
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: frames_to_us
+ * Description  : Duration of a number of frames at the stream rate
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ *                uint32_t frames - frames
+ * Return Value : microseconds
+ **********************************************************************************************************************/
+static uint32_t frames_to_us (p_audio_jitter_t p_jb, uint32_t frames)
+{
+    return ((uint32_t) (((uint64_t) frames * 1000000u) / p_jb->config.format.sample_rate));
+}
+/***********************************************************************************************************************
+ End of function frames_to_us
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: depth_us
+ * Description  : Audio between the playout point and the end of the newest packet
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ * Return Value : microseconds
+ **********************************************************************************************************************/
+static uint32_t depth_us (p_audio_jitter_t p_jb)
+{
+    int32_t frames = (int32_t) (p_jb->highest_ts_end - p_jb->play_ts);
+
+    return ((frames > 0) ? frames_to_us(p_jb, (uint32_t) frames) : 0u);
+}
+/***********************************************************************************************************************
+ End of function depth_us
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: target_us
+ * Description  : Playout delay to aim for: a packet, a multiple of the jitter and any underrun boost, within the
+ *                configured limits
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ * Return Value : microseconds
+ **********************************************************************************************************************/
+static uint32_t target_us (p_audio_jitter_t p_jb)
+{
+    uint32_t target = frames_to_us(p_jb, p_jb->packet_frames)
+            + (JITTER_PRV_JITTER_MULTIPLE * (p_jb->jitter16 >> 4)) + p_jb->boost_us;
+
+    if (target < (p_jb->config.min_delay_ms * 1000u))
+    {
+        target = p_jb->config.min_delay_ms * 1000u;
+    }
+
+    if (target > (p_jb->config.max_delay_ms * 1000u))
+    {
+        target = p_jb->config.max_delay_ms * 1000u;
+    }
+
+    return (target);
+}
+/***********************************************************************************************************************
+ End of function target_us
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: start_packet
+ * Description  : Moves the packet at the playout point into current and records its arrival to playout latency. The
+ *                gain ramps back to unity over the packet if the one before was concealed.
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ *                uint32_t playout - timer count at which the first frame of the request will be heard
+ *                uint32_t produced - frames of the request already written
+ * Return Value : false if the packet has not arrived
+ **********************************************************************************************************************/
+static bool_t start_packet (p_audio_jitter_t p_jb, uint32_t playout, uint32_t produced)
+{
+    st_jitter_slot_t *p_slot = &p_jb->p_slots[p_jb->play_seq & JITTER_PRV_SLOT_MASK];
+    uint32_t latency;
+
+    if ((false == p_slot->valid) || (p_slot->seq != p_jb->play_seq))
+    {
+        return (false);
+    }
+
+    if ((int32_t) (playout - p_slot->arrival) >= 0)
+    {
+        latency = ((playout - p_slot->arrival) / p_jb->config.counts_per_us) + frames_to_us(p_jb, produced);
+
+        p_jb->stats.latency_samples++;
+        p_jb->stats.total_latency_us += latency;
+
+        if (latency < p_jb->stats.min_latency_us)
+        {
+            p_jb->stats.min_latency_us = latency;
+        }
+
+        if (latency > p_jb->stats.max_latency_us)
+        {
+            p_jb->stats.max_latency_us = latency;
+        }
+    }
+
+    p_jb->current = *p_slot;
+    p_slot->valid = false;
+
+    p_jb->mode = JITTER_PRV_MODE_PACKET;
+    p_jb->offset = 0u;
+    p_jb->have_last = true;
+    p_jb->concealed = 0u;
+    p_jb->play_ts = p_jb->current.timestamp;
+    p_jb->play_seq++;
+
+    p_jb->gain_target = JITTER_PRV_GAIN_ONE;
+    p_jb->gain_step = (JITTER_PRV_GAIN_ONE - p_jb->gain) / (int32_t) p_jb->current.frames;
+
+    /* the extra delay allowed after an underrun wears off over a few seconds of packets */
+    p_jb->boost_us -= (p_jb->boost_us + 4095u) >> 12;
+
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function start_packet
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: start_conceal
+ * Description  : Repeats the last packet played, halving the gain each time and muting after JITTER_PRV_CONCEAL_MAX
+ *                packets. A fade out ramps straight to silence.
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ *                e_jitter_mode_t mode - JITTER_PRV_MODE_CONCEAL or JITTER_PRV_MODE_FADE_OUT
+ * Return Value : none
+ **********************************************************************************************************************/
+static void start_conceal (p_audio_jitter_t p_jb, e_jitter_mode_t mode)
+{
+    if (false == p_jb->have_last)
+    {
+        /* nothing to repeat, a packet of silence */
+        p_jb->current.frames = p_jb->packet_frames;
+        memset(p_jb->current.data, 0, sizeof(p_jb->current.data));
+        p_jb->gain = 0;
+    }
+
+    p_jb->concealed++;
+
+    if ((JITTER_PRV_MODE_FADE_OUT == mode) || (p_jb->concealed >= JITTER_PRV_CONCEAL_MAX))
+    {
+        p_jb->gain_target = 0;
+    }
+    else
+    {
+        p_jb->gain_target = p_jb->gain / 2;
+    }
+
+    p_jb->mode = mode;
+    p_jb->offset = 0u;
+    p_jb->gain_step = (p_jb->gain_target - p_jb->gain) / (int32_t) p_jb->current.frames;
+}
+/***********************************************************************************************************************
+ End of function start_conceal
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: play_frames
+ * Description  : Converts frames of current from big endian PCM to left justified 32 bit stereo, applying the gain ramp
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ *                uint32_t *p_dst - destination
+ *                uint32_t frames - frames to convert
+ * Return Value : none
+ **********************************************************************************************************************/
+static void play_frames (p_audio_jitter_t p_jb, uint32_t *p_dst, uint32_t frames)
+{
+    const uint8_t *p_src = p_jb->current.data + (p_jb->offset * p_jb->frame_bytes);
+    uint32_t sample_bytes = p_jb->config.format.bits_per_sample / 8u;
+    uint32_t sample[2];
+    uint32_t channel;
+    uint32_t i;
+
+    for (i = 0u; i < frames; i++)
+    {
+        for (channel = 0u; channel < p_jb->config.format.channels; channel++)
+        {
+            sample[channel] = ((uint32_t) p_src[0] << 24) | ((uint32_t) p_src[1] << 16);
+
+            if (3u == sample_bytes)
+            {
+                sample[channel] |= (uint32_t) p_src[2] << 8;
+            }
+
+            p_src += sample_bytes;
+        }
+
+        if (1u == p_jb->config.format.channels)
+        {
+            sample[1] = sample[0];
+        }
+
+        if (JITTER_PRV_GAIN_ONE != p_jb->gain)
+        {
+            sample[0] = (uint32_t) (int32_t) (((int64_t) (int32_t) sample[0] * p_jb->gain) >> 15);
+            sample[1] = (uint32_t) (int32_t) (((int64_t) (int32_t) sample[1] * p_jb->gain) >> 15);
+            p_jb->gain += p_jb->gain_step;
+        }
+
+        p_dst[0] = sample[0];
+        p_dst[1] = sample[1];
+        p_dst += 2;
+    }
+
+    p_jb->offset += frames;
+
+    if (JITTER_PRV_MODE_FADE_OUT != p_jb->mode)
+    {
+        p_jb->play_ts += frames;
+    }
+}
+/***********************************************************************************************************************
+ End of function play_frames
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: update_trim
+ * Description  : Drift loop. A sender clock faster than the SSIF clock fills the buffer past its target, the trim asks
+ *                the resampler to consume input faster until the depth settles back. Proportional plus integral on
+ *                the averaged depth error, the integral holds the steady clock offset.
+ * Arguments    : p_audio_jitter_t p_jb - buffer
+ * Return Value : none
+ **********************************************************************************************************************/
+static void update_trim (p_audio_jitter_t p_jb)
+{
+    int32_t error;
+    int32_t trim;
+
+    if (false == p_jb->playing)
+    {
+        p_jb->trim_ppm = 0;
+        return;
+    }
+
+    error = (int32_t) depth_us(p_jb) - (int32_t) target_us(p_jb);
+    p_jb->error_avg_us += (error - p_jb->error_avg_us) >> JITTER_PRV_AVG_SHIFT;
+    p_jb->integral += p_jb->error_avg_us;
+
+    if (p_jb->integral > (JITTER_PRV_TRIM_I_MAX_PPM << JITTER_PRV_TRIM_I_SHIFT))
+    {
+        p_jb->integral = JITTER_PRV_TRIM_I_MAX_PPM << JITTER_PRV_TRIM_I_SHIFT;
+    }
+
+    if (p_jb->integral < (-(JITTER_PRV_TRIM_I_MAX_PPM << JITTER_PRV_TRIM_I_SHIFT)))
+    {
+        p_jb->integral = -(JITTER_PRV_TRIM_I_MAX_PPM << JITTER_PRV_TRIM_I_SHIFT);
+    }
+
+    trim = (p_jb->error_avg_us >> JITTER_PRV_TRIM_P_SHIFT) + (p_jb->integral >> JITTER_PRV_TRIM_I_SHIFT);
+
+    if (trim > JITTER_PRV_TRIM_MAX_PPM)
+    {
+        trim = JITTER_PRV_TRIM_MAX_PPM;
+    }
+
+    if (trim < (-JITTER_PRV_TRIM_MAX_PPM))
+    {
+        trim = -JITTER_PRV_TRIM_MAX_PPM;
+    }
+
+    p_jb->trim_ppm = trim;
+}
+/***********************************************************************************************************************
+ End of function update_trim
+ **********************************************************************************************************************/
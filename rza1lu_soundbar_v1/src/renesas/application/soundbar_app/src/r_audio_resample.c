@@ -0,0 +1,547 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ ******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.  */
+/******************************************************************************
+ * File Name    : r_audio_resample.c
+ * Device(s)    : RZ/A1L
+ * Tool-Chain   : GNUARM-NONE-EABI-v16.01
+ * H/W Platform : Stream it! v2 board
+ * Description  : Fixed point polyphase windowed sinc sample rate converter
+ ******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 13.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ *****************************************************************************/
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "r_typedefs.h"
+#include "r_os_abstraction_api.h"
+#include "r_task_priority.h"
+
+#include "r_audio_resample.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+/* Coefficients are Q30, each phase sums to exactly one */
+#define RESAMPLE_PRV_COEF_SHIFT         (30u)
+#define RESAMPLE_PRV_COEF_ONE           ((double) (1ul << RESAMPLE_PRV_COEF_SHIFT))
+
+/* Bits of the position used to interpolate between two phases */
+#define RESAMPLE_PRV_INTERP_BITS        (16u)
+
+#define RESAMPLE_PRV_PI                 (3.14159265358979323846)
+
+/******************************************************************************
+ Typedef definitions
+ ******************************************************************************/
+typedef struct
+{
+    uint32_t taps;              /* filter length in input frames, even */
+    uint32_t phase_bits;        /* log2 of the phases per input frame */
+    double   rolloff;           /* cut off as a fraction of the lower Nyquist rate */
+    double   beta;              /* Kaiser window shape */
+    const char_t *p_name;
+} st_resample_quality_t;
+
+typedef struct st_audio_resampler
+{
+    uint32_t in_rate;
+    uint32_t out_rate;
+    uint32_t taps;
+    uint32_t phase_bits;
+
+    int32_t  *p_coef;           /* (phases + 1) rows of taps, the extra row is phase 0 one frame later */
+    int32_t  *p_history;        /* 2 * taps interleaved stereo frames, each frame is written twice */
+    uint32_t write;             /* history slot of the oldest frame */
+
+    uint32_t step_int;          /* input frames per output frame, 32.32 */
+    uint32_t step_frac;
+    uint32_t frac;              /* output position between two input frames */
+    uint32_t advance;           /* input frames to take before the next output */
+
+    uint32_t ram_bytes;
+} st_audio_resampler_t;
+
+/******************************************************************************
+ Private global variables and functions
+ ******************************************************************************/
+static const st_resample_quality_t gs_quality[AUDIO_RESAMPLE_QUALITY_COUNT] =
+{
+    { 8u,  6u, 0.80, 5.0, "low" },
+    { 16u, 7u, 0.90, 7.0, "medium" },
+    { 32u, 8u, 0.94, 9.0, "high" },
+};
+
+/***********************************************************************************************************************
+ * Function Name: bessel_i0
+ * Description  : Zeroth order modified Bessel function, for the Kaiser window
+ * Arguments    : double x - argument
+ * Return Value : I0(x)
+ **********************************************************************************************************************/
+static double bessel_i0 (double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    double k = 1.0;
+
+    do
+    {
+        term *= (x * 0.5) / k;
+        sum += term * term;
+        k += 1.0;
+    } while ((term * term) > (sum * 1e-12));
+
+    return (sum);
+}
+/***********************************************************************************************************************
+ End of function bessel_i0
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: build_table
+ * Description  : Tabulates the windowed sinc for every phase and normalises each phase to unity gain at DC
+ * Arguments    : p_audio_resampler_t p_rs - resampler, taps and phase_bits set
+ *                const st_resample_quality_t *p_quality - filter parameters
+ * Return Value : none
+ **********************************************************************************************************************/
+static void build_table (p_audio_resampler_t p_rs, const st_resample_quality_t *p_quality)
+{
+    uint32_t phases = 1ul << p_rs->phase_bits;
+    double half = (double) (p_rs->taps / 2u);
+    double cutoff = p_quality->rolloff;
+    double i0_beta = bessel_i0(p_quality->beta);
+    double row[32];
+    double sum;
+    double t;
+    double x;
+    int32_t *p_row;
+    int32_t total;
+    uint32_t peak;
+    uint32_t phase;
+    uint32_t k;
+
+    /* when decimating the cut off follows the output Nyquist rate */
+    if (p_rs->out_rate < p_rs->in_rate)
+    {
+        cutoff *= (double) p_rs->out_rate / (double) p_rs->in_rate;
+    }
+
+    for (phase = 0u; phase <= phases; phase++)
+    {
+        sum = 0.0;
+
+        for (k = 0u; k < p_rs->taps; k++)
+        {
+            /* distance from the output instant, which lies between frames half - 1 and half of the window */
+            t = ((half - 1.0) + ((double) phase / (double) phases)) - (double) k;
+            x = t / half;
+
+            if ((x <= -1.0) || (x >= 1.0))
+            {
+                row[k] = 0.0;
+            }
+            else
+            {
+                row[k] = (bessel_i0(p_quality->beta * sqrt(1.0 - (x * x))) / i0_beta)
+                        * ((0.0 == t) ? cutoff : (sin(RESAMPLE_PRV_PI * cutoff * t) / (RESAMPLE_PRV_PI * t)));
+            }
+
+            sum += row[k];
+        }
+
+        /* quantise, then put the rounding error on the largest tap so the phase sums to exactly one */
+        p_row = p_rs->p_coef + (phase * p_rs->taps);
+        total = 0;
+        peak = 0u;
+
+        for (k = 0u; k < p_rs->taps; k++)
+        {
+            p_row[k] = (int32_t) lround((row[k] / sum) * RESAMPLE_PRV_COEF_ONE);
+            total += p_row[k];
+
+            if (p_row[k] > p_row[peak])
+            {
+                peak = k;
+            }
+        }
+
+        p_row[peak] += (int32_t) (1l << RESAMPLE_PRV_COEF_SHIFT) - total;
+    }
+}
+/***********************************************************************************************************************
+ End of function build_table
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: create_resampler
+ * Description  : Allocates the resampler and builds the filter table. Equal rates need neither unless the ratio is
+ *                going to be trimmed later.
+ * Arguments    : uint32_t in_rate - input sample rate
+ *                uint32_t out_rate - output sample rate
+ *                e_audio_resample_quality_t quality - filter quality
+ *                bool_t variable - build the filter even for equal rates
+ * Return Value : the resampler, NULL on failure
+ **********************************************************************************************************************/
+static p_audio_resampler_t create_resampler (uint32_t in_rate, uint32_t out_rate, e_audio_resample_quality_t quality,
+        bool_t variable)
+{
+    const st_resample_quality_t *p_quality;
+    p_audio_resampler_t p_rs;
+    uint32_t coef_bytes;
+    uint32_t history_bytes;
+    uint64_t step;
+
+    if ((0u == in_rate) || (0u == out_rate) || (quality >= AUDIO_RESAMPLE_QUALITY_COUNT))
+    {
+        return (NULL);
+    }
+
+    p_rs = R_OS_AllocMem(sizeof(st_audio_resampler_t), R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL == p_rs)
+    {
+        return (NULL);
+    }
+
+    memset(p_rs, 0, sizeof(st_audio_resampler_t));
+    p_rs->in_rate = in_rate;
+    p_rs->out_rate = out_rate;
+    p_rs->ram_bytes = sizeof(st_audio_resampler_t);
+
+    if ((in_rate == out_rate) && (false == variable))
+    {
+        return (p_rs);
+    }
+
+    p_quality = &gs_quality[quality];
+    p_rs->taps = p_quality->taps;
+    p_rs->phase_bits = p_quality->phase_bits;
+
+    coef_bytes = ((1ul << p_rs->phase_bits) + 1u) * p_rs->taps * sizeof(int32_t);
+    history_bytes = 2u * p_rs->taps * 2u * sizeof(int32_t);
+
+    p_rs->p_coef = R_OS_AllocMem(coef_bytes, R_REGION_LARGE_CAPACITY_RAM);
+    p_rs->p_history = R_OS_AllocMem(history_bytes, R_REGION_LARGE_CAPACITY_RAM);
+
+    if ((NULL == p_rs->p_coef) || (NULL == p_rs->p_history))
+    {
+        r_audio_resample_destroy(p_rs);
+        return (NULL);
+    }
+
+    p_rs->ram_bytes += coef_bytes + history_bytes;
+
+    step = ((uint64_t) in_rate << 32) / out_rate;
+    p_rs->step_int = (uint32_t) (step >> 32);
+    p_rs->step_frac = (uint32_t) step;
+
+    build_table(p_rs, p_quality);
+    r_audio_resample_reset(p_rs);
+
+    return (p_rs);
+}
+/***********************************************************************************************************************
+ End of function create_resampler
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_resample_create
+ * Description  : Allocates the resampler and builds the filter table, equal rates need neither
+ * Arguments    : uint32_t in_rate - input sample rate
+ *                uint32_t out_rate - output sample rate
+ *                e_audio_resample_quality_t quality - filter quality
+ * Return Value : the resampler, NULL on failure
+ **********************************************************************************************************************/
+p_audio_resampler_t r_audio_resample_create (uint32_t in_rate, uint32_t out_rate, e_audio_resample_quality_t quality)
+{
+    return (create_resampler(in_rate, out_rate, quality, false));
+}
+/***********************************************************************************************************************
+ End of function r_audio_resample_create
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_resample_create_variable
+ * Description  : As r_audio_resample_create, but always filters so the ratio can be trimmed while running
+ * Arguments    : uint32_t in_rate - nominal input sample rate
+ *                uint32_t out_rate - output sample rate
+ *                e_audio_resample_quality_t quality - filter quality
+ * Return Value : the resampler, NULL on failure
+ **********************************************************************************************************************/
+p_audio_resampler_t r_audio_resample_create_variable (uint32_t in_rate, uint32_t out_rate,
+        e_audio_resample_quality_t quality)
+{
+    return (create_resampler(in_rate, out_rate, quality, true));
+}
+/***********************************************************************************************************************
+ End of function r_audio_resample_create_variable
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_resample_set_trim
+ * Description  : Scales the input step by 1 + ppm / 10^6. The output position carries on from where it is, so the
+ *                ratio can be moved every period without a click.
+ * Arguments    : p_audio_resampler_t p_rs - resampler from r_audio_resample_create_variable
+ *                int32_t ppm - correction, positive consumes input faster
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_resample_set_trim (p_audio_resampler_t p_rs, int32_t ppm)
+{
+    uint64_t step;
+
+    if (NULL == p_rs->p_coef)
+    {
+        /* passing through, there is no ratio to trim */
+        return;
+    }
+
+    step = (((uint64_t) p_rs->in_rate << 32) / p_rs->out_rate);
+    step = (uint64_t) ((int64_t) step + (((int64_t) step / 1000000) * ppm));
+    p_rs->step_int = (uint32_t) (step >> 32);
+    p_rs->step_frac = (uint32_t) step;
+}
+/***********************************************************************************************************************
+ End of function r_audio_resample_set_trim
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_resample_destroy
+ * Description  : Frees the resampler
+ * Arguments    : p_audio_resampler_t p_rs - resampler, may be NULL
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_resample_destroy (p_audio_resampler_t p_rs)
+{
+    if (NULL != p_rs)
+    {
+        if (NULL != p_rs->p_coef)
+        {
+            R_OS_FreeMem(p_rs->p_coef);
+        }
+
+        if (NULL != p_rs->p_history)
+        {
+            R_OS_FreeMem(p_rs->p_history);
+        }
+
+        R_OS_FreeMem(p_rs);
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_resample_destroy
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_resample_reset
+ * Description  : Clears the history. Half a filter of input plus the first frame is taken before the first output,
+ *                which puts the first output frame on the first input frame.
+ * Arguments    : p_audio_resampler_t p_rs - resampler
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_resample_reset (p_audio_resampler_t p_rs)
+{
+    if (NULL != p_rs->p_history)
+    {
+        memset(p_rs->p_history, 0, 2u * p_rs->taps * 2u * sizeof(int32_t));
+    }
+
+    p_rs->write = 0u;
+    p_rs->frac = 0u;
+    p_rs->advance = (0u != p_rs->taps) ? ((p_rs->taps / 2u) + 1u) : 0u;
+}
+/***********************************************************************************************************************
+ End of function r_audio_resample_reset
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: resample_frame
+ * Description  : Runs the two phases either side of the output position over the window and interpolates between them
+ * Arguments    : p_audio_resampler_t p_rs - resampler
+ *                int32_t *p_out - one output frame
+ * Return Value : none
+ **********************************************************************************************************************/
+static void resample_frame (p_audio_resampler_t p_rs, int32_t *p_out)
+{
+    const int32_t *p_x = p_rs->p_history + (2u * p_rs->write);
+    const int32_t *p_c0 = p_rs->p_coef + ((p_rs->frac >> (32u - p_rs->phase_bits)) * p_rs->taps);
+    const int32_t *p_c1 = p_c0 + p_rs->taps;
+    int32_t interp = (int32_t) ((p_rs->frac >> (32u - p_rs->phase_bits - RESAMPLE_PRV_INTERP_BITS))
+            & ((1ul << RESAMPLE_PRV_INTERP_BITS) - 1u));
+    int64_t left0 = 0;
+    int64_t right0 = 0;
+    int64_t left1 = 0;
+    int64_t right1 = 0;
+    int64_t value;
+    uint32_t k;
+
+    for (k = 0u; k < p_rs->taps; k++)
+    {
+        left0 += (int64_t) p_c0[k] * p_x[0];
+        right0 += (int64_t) p_c0[k] * p_x[1];
+        left1 += (int64_t) p_c1[k] * p_x[0];
+        right1 += (int64_t) p_c1[k] * p_x[1];
+        p_x += 2;
+    }
+
+    left0 >>= RESAMPLE_PRV_COEF_SHIFT;
+    right0 >>= RESAMPLE_PRV_COEF_SHIFT;
+    left1 >>= RESAMPLE_PRV_COEF_SHIFT;
+    right1 >>= RESAMPLE_PRV_COEF_SHIFT;
+
+    value = left0 + (((left1 - left0) * interp) >> RESAMPLE_PRV_INTERP_BITS);
+    p_out[0] = (value > INT32_MAX) ? INT32_MAX : ((value < INT32_MIN) ? INT32_MIN : (int32_t) value);
+
+    value = right0 + (((right1 - right0) * interp) >> RESAMPLE_PRV_INTERP_BITS);
+    p_out[1] = (value > INT32_MAX) ? INT32_MAX : ((value < INT32_MIN) ? INT32_MIN : (int32_t) value);
+}
+/***********************************************************************************************************************
+ End of function resample_frame
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_resample_process
+ * Description  : Takes input frames into the history as the output position passes them and filters one output frame
+ *                at a time. State carries over between calls so blocks of any size can be fed.
+ * Arguments    : p_audio_resampler_t p_rs - resampler
+ *                const uint32_t *p_in - input frames
+ *                uint32_t in_frames - input frames available
+ *                uint32_t *p_in_used - returns input frames consumed
+ *                uint32_t *p_out - output frames
+ *                uint32_t out_frames - output space
+ * Return Value : output frames written
+ **********************************************************************************************************************/
+uint32_t r_audio_resample_process (p_audio_resampler_t p_rs, const uint32_t *p_in, uint32_t in_frames,
+        uint32_t *p_in_used, uint32_t *p_out, uint32_t out_frames)
+{
+    const int32_t *p_src = (const int32_t *) p_in;
+    int32_t *p_dst = (int32_t *) p_out;
+    int32_t *p_slot;
+    uint32_t used = 0u;
+    uint32_t written = 0u;
+    uint32_t frac;
+
+    if (NULL == p_rs->p_coef)
+    {
+        /* same rate */
+        written = (in_frames < out_frames) ? in_frames : out_frames;
+
+        if (p_in != p_out)
+        {
+            memmove(p_out, p_in, written * 2u * sizeof(uint32_t));
+        }
+
+        *p_in_used = written;
+        return (written);
+    }
+
+    while (written < out_frames)
+    {
+        while (0u != p_rs->advance)
+        {
+            if (used == in_frames)
+            {
+                *p_in_used = used;
+                return (written);
+            }
+
+            /* each frame goes in twice so the window is always contiguous */
+            p_slot = p_rs->p_history + (2u * p_rs->write);
+            p_slot[0] = p_src[0];
+            p_slot[1] = p_src[1];
+            p_slot[2u * p_rs->taps] = p_src[0];
+            p_slot[(2u * p_rs->taps) + 1u] = p_src[1];
+            p_src += 2;
+            used++;
+
+            p_rs->write = (p_rs->write + 1u == p_rs->taps) ? 0u : (p_rs->write + 1u);
+            p_rs->advance--;
+        }
+
+        resample_frame(p_rs, p_dst);
+        p_dst += 2;
+        written++;
+
+        frac = p_rs->frac;
+        p_rs->frac += p_rs->step_frac;
+        p_rs->advance = p_rs->step_int + ((p_rs->frac < frac) ? 1u : 0u);
+    }
+
+    *p_in_used = used;
+
+    return (written);
+}
+/***********************************************************************************************************************
+ End of function r_audio_resample_process
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_resample_get_delay
+ * Description  : Input frames taken before the first output frame
+ * Arguments    : p_audio_resampler_t p_rs - resampler
+ * Return Value : delay in input frames
+ **********************************************************************************************************************/
+uint32_t r_audio_resample_get_delay (p_audio_resampler_t p_rs)
+{
+    return (p_rs->taps / 2u);
+}
+/***********************************************************************************************************************
+ End of function r_audio_resample_get_delay
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_resample_get_ram
+ * Description  : Memory held by the resampler
+ * Arguments    : p_audio_resampler_t p_rs - resampler
+ * Return Value : bytes
+ **********************************************************************************************************************/
+uint32_t r_audio_resample_get_ram (p_audio_resampler_t p_rs)
+{
+    return (p_rs->ram_bytes);
+}
+/***********************************************************************************************************************
+ End of function r_audio_resample_get_ram
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_resample_quality_name
+ * Description  : Name of a quality mode
+ * Arguments    : e_audio_resample_quality_t quality - quality mode
+ * Return Value : name
+ **********************************************************************************************************************/
+const char_t *r_audio_resample_quality_name (e_audio_resample_quality_t quality)
+{
+    return ((quality < AUDIO_RESAMPLE_QUALITY_COUNT) ? gs_quality[quality].p_name : "?");
+}
+/***********************************************************************************************************************
+ End of function r_audio_resample_quality_name
+ **********************************************************************************************************************/
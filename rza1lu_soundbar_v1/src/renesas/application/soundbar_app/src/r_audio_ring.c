@@ -0,0 +1,387 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ ******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.  */
+/******************************************************************************
+ * File Name    : r_audio_ring.c
+ * Device(s)    : RZ/A1L
+ * Tool-Chain   : GNUARM-NONE-EABI-v16.01
+ * H/W Platform : Stream it! v2 board
+ * Description  : Single producer / single consumer ring of DMA aligned audio
+ *                periods
+ ******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 13.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ *****************************************************************************/
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+#include <string.h>
+
+#include "r_typedefs.h"
+#include "r_os_abstraction_api.h"
+#include "r_task_priority.h"
+
+#include "r_audio_ring.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+/* Make the period data visible before the index that publishes it */
+#define AUDIO_RING_PRV_BARRIER()    __asm__ __volatile__ ("dmb" ::: "memory")
+
+/******************************************************************************
+ Private global variables and functions
+ ******************************************************************************/
+static uint32_t ring_advance (p_audio_ring_t p_ring, uint32_t index);
+static uint32_t ring_distance (p_audio_ring_t p_ring, uint32_t from, uint32_t to);
+static uint8_t *ring_period (p_audio_ring_t p_ring, uint32_t index);
+
+/***********************************************************************************************************************
+ * Function Name: ring_advance
+ * Description  : Indices run over twice the period count so that a full ring can be told apart from an empty one
+ * Arguments    : p_audio_ring_t p_ring - ring
+ *                uint32_t index - index to advance
+ * Return Value : next index
+ **********************************************************************************************************************/
+static uint32_t ring_advance (p_audio_ring_t p_ring, uint32_t index)
+{
+    index++;
+
+    if (index >= (p_ring->config.period_count * 2u))
+    {
+        index = 0u;
+    }
+
+    return (index);
+}
+/***********************************************************************************************************************
+ End of function ring_advance
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: ring_distance
+ * Description  : Number of periods between two indices
+ * Arguments    : p_audio_ring_t p_ring - ring
+ *                uint32_t from - trailing index
+ *                uint32_t to - leading index
+ * Return Value : periods from 'from' up to 'to'
+ **********************************************************************************************************************/
+static uint32_t ring_distance (p_audio_ring_t p_ring, uint32_t from, uint32_t to)
+{
+    if (to >= from)
+    {
+        return (to - from);
+    }
+
+    return ((to + (p_ring->config.period_count * 2u)) - from);
+}
+/***********************************************************************************************************************
+ End of function ring_distance
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: ring_period
+ * Description  : Maps an index onto its period buffer
+ * Arguments    : p_audio_ring_t p_ring - ring
+ *                uint32_t index - ring index
+ * Return Value : period buffer
+ **********************************************************************************************************************/
+static uint8_t *ring_period (p_audio_ring_t p_ring, uint32_t index)
+{
+    if (index >= p_ring->config.period_count)
+    {
+        index -= p_ring->config.period_count;
+    }
+
+    return (p_ring->p_periods + (index * p_ring->config.period_size));
+}
+/***********************************************************************************************************************
+ End of function ring_period
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_ring_create
+ * Description  : Allocates a ring and its DMA aligned period storage in one block
+ * Arguments    : const st_audio_ring_config_t *p_config - ring geometry and watermark callbacks
+ * Return Value : the ring, NULL on failure
+ **********************************************************************************************************************/
+p_audio_ring_t r_audio_ring_create (const st_audio_ring_config_t *p_config)
+{
+    p_audio_ring_t p_ring;
+    uint32_t period_size;
+    uint32_t header_size;
+    void *p_allocation;
+
+    if ((NULL == p_config) || (p_config->period_count < 2u) || (0u == p_config->period_size)
+            || (p_config->high_watermark > p_config->period_count) || (p_config->low_watermark >= p_config->period_count))
+    {
+        return (NULL);
+    }
+
+    /* every period must start on a DMA boundary */
+    period_size = (p_config->period_size + (AUDIO_RING_ALIGN_BYTES - 1u)) & ~(AUDIO_RING_ALIGN_BYTES - 1u);
+
+    /* control block, length table, then the periods after the alignment slack */
+    header_size = sizeof(st_audio_ring_t) + (sizeof(uint32_t) * p_config->period_count);
+
+    p_allocation = R_OS_AllocMem((header_size + (period_size * p_config->period_count) + AUDIO_RING_ALIGN_BYTES),
+            R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL == p_allocation)
+    {
+        return (NULL);
+    }
+
+    p_ring = (p_audio_ring_t) p_allocation;
+    memset(p_ring, 0, header_size);
+
+    p_ring->config = *p_config;
+    p_ring->config.period_size = period_size;
+    p_ring->p_allocation = p_allocation;
+    p_ring->p_lengths = (uint32_t *) (p_ring + 1);
+
+    /* Aligned by clearing lower bits of pointer then adding the alignment size */
+    p_ring->p_periods = (uint8_t *) (((((uint32_t) p_allocation) + header_size)
+            & (uint32_t) ( ~(AUDIO_RING_ALIGN_BYTES - 1u))) + AUDIO_RING_ALIGN_BYTES);
+
+    return (p_ring);
+}
+/***********************************************************************************************************************
+ End of function r_audio_ring_create
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_ring_destroy
+ * Description  : Frees a ring created with r_audio_ring_create
+ * Arguments    : p_audio_ring_t p_ring - ring
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_ring_destroy (p_audio_ring_t p_ring)
+{
+    if (NULL != p_ring)
+    {
+        R_OS_FreeMem(p_ring->p_allocation);
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_ring_destroy
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_ring_reset
+ * Description  : Empties the ring, only call while nothing is queued to the DMA
+ * Arguments    : p_audio_ring_t p_ring - ring
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_ring_reset (p_audio_ring_t p_ring)
+{
+    p_ring->write_index = 0u;
+    p_ring->read_index = 0u;
+    p_ring->release_index = 0u;
+}
+/***********************************************************************************************************************
+ End of function r_audio_ring_reset
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_ring_get_write_period
+ * Description  : Producer side, returns the next free period
+ * Arguments    : p_audio_ring_t p_ring - ring
+ * Return Value : period buffer, NULL when the ring is full
+ **********************************************************************************************************************/
+uint8_t *r_audio_ring_get_write_period (p_audio_ring_t p_ring)
+{
+    if (0u == r_audio_ring_free(p_ring))
+    {
+        p_ring->overruns++;
+        return (NULL);
+    }
+
+    return (ring_period(p_ring, p_ring->write_index));
+}
+/***********************************************************************************************************************
+ End of function r_audio_ring_get_write_period
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_ring_commit_write
+ * Description  : Producer side, publishes the period returned by r_audio_ring_get_write_period
+ * Arguments    : p_audio_ring_t p_ring - ring
+ *                uint32_t length - valid bytes in the period
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_ring_commit_write (p_audio_ring_t p_ring, uint32_t length)
+{
+    uint32_t index = p_ring->write_index;
+
+    if (index >= p_ring->config.period_count)
+    {
+        p_ring->p_lengths[index - p_ring->config.period_count] = length;
+    }
+    else
+    {
+        p_ring->p_lengths[index] = length;
+    }
+
+    AUDIO_RING_PRV_BARRIER();
+    p_ring->write_index = ring_advance(p_ring, index);
+
+    if ((NULL != p_ring->config.high_callback) && (r_audio_ring_filled(p_ring) == p_ring->config.high_watermark))
+    {
+        p_ring->config.high_callback(p_ring, p_ring->config.p_context);
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_ring_commit_write
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_ring_get_read_period
+ * Description  : Consumer side, returns the oldest filled period not yet queued to the DMA
+ * Arguments    : p_audio_ring_t p_ring - ring
+ *                uint32_t *p_length - receives the valid bytes in the period
+ * Return Value : period buffer, NULL when nothing is readable
+ **********************************************************************************************************************/
+uint8_t *r_audio_ring_get_read_period (p_audio_ring_t p_ring, uint32_t *p_length)
+{
+    uint32_t index = p_ring->read_index;
+
+    if (0u == r_audio_ring_readable(p_ring))
+    {
+        return (NULL);
+    }
+
+    AUDIO_RING_PRV_BARRIER();
+
+    if (NULL != p_length)
+    {
+        *p_length = p_ring->p_lengths[(index >= p_ring->config.period_count) ?
+                (index - p_ring->config.period_count) : index];
+    }
+
+    return (ring_period(p_ring, index));
+}
+/***********************************************************************************************************************
+ End of function r_audio_ring_get_read_period
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_ring_commit_read
+ * Description  : Consumer side, marks the period returned by r_audio_ring_get_read_period as queued to the DMA
+ * Arguments    : p_audio_ring_t p_ring - ring
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_ring_commit_read (p_audio_ring_t p_ring)
+{
+    p_ring->read_index = ring_advance(p_ring, p_ring->read_index);
+}
+/***********************************************************************************************************************
+ End of function r_audio_ring_commit_read
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_ring_release
+ * Description  : Consumer side, hands the oldest queued period back to the producer. Called from the DMA end
+ *                callback so it must stay short and interrupt safe.
+ * Arguments    : p_audio_ring_t p_ring - ring
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_ring_release (p_audio_ring_t p_ring)
+{
+    if (p_ring->release_index == p_ring->read_index)
+    {
+        /* nothing queued, a dummy transfer has completed */
+        return;
+    }
+
+    p_ring->release_index = ring_advance(p_ring, p_ring->release_index);
+
+    if ((NULL != p_ring->config.low_callback) && (r_audio_ring_filled(p_ring) == p_ring->config.low_watermark))
+    {
+        p_ring->config.low_callback(p_ring, p_ring->config.p_context);
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_ring_release
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_ring_filled
+ * Description  : Periods holding data, filled or queued to the DMA
+ * Arguments    : p_audio_ring_t p_ring - ring
+ * Return Value : period count
+ **********************************************************************************************************************/
+uint32_t r_audio_ring_filled (p_audio_ring_t p_ring)
+{
+    return (ring_distance(p_ring, p_ring->release_index, p_ring->write_index));
+}
+/***********************************************************************************************************************
+ End of function r_audio_ring_filled
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_ring_free
+ * Description  : Periods the producer can fill
+ * Arguments    : p_audio_ring_t p_ring - ring
+ * Return Value : period count
+ **********************************************************************************************************************/
+uint32_t r_audio_ring_free (p_audio_ring_t p_ring)
+{
+    return (p_ring->config.period_count - r_audio_ring_filled(p_ring));
+}
+/***********************************************************************************************************************
+ End of function r_audio_ring_free
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_ring_readable
+ * Description  : Filled periods waiting to be queued to the DMA
+ * Arguments    : p_audio_ring_t p_ring - ring
+ * Return Value : period count
+ **********************************************************************************************************************/
+uint32_t r_audio_ring_readable (p_audio_ring_t p_ring)
+{
+    return (ring_distance(p_ring, p_ring->read_index, p_ring->write_index));
+}
+/***********************************************************************************************************************
+ End of function r_audio_ring_readable
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_ring_note_underrun
+ * Description  : Consumer side, counts a period the DMA needed while the ring was empty
+ * Arguments    : p_audio_ring_t p_ring - ring
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_ring_note_underrun (p_audio_ring_t p_ring)
+{
+    p_ring->underruns++;
+}
+/***********************************************************************************************************************
+ End of function r_audio_ring_note_underrun
+ **********************************************************************************************************************/
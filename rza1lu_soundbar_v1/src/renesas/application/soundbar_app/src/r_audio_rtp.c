@@ -0,0 +1,414 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ ******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.  */
+/******************************************************************************
+ * File Name    : r_audio_rtp.c
+ * Device(s)    : RZ/A1L
+ * Tool-Chain   : GNUARM-NONE-EABI-v16.01
+ * H/W Platform : Stream it! v2 board
+ * Description  : RTP/UDP linear PCM receiver, a receive task depacketises
+ *                the stream into a jitter buffer
+ ******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 13.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ *****************************************************************************/
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+#include "application_cfg.h"
+
+#if (R_SELF_LOAD_MIDDLEWARE_ETHERNET_MODULES)
+
+#include <string.h>
+
+#include "r_typedefs.h"
+#include "r_os_abstraction_api.h"
+#include "r_task_priority.h"
+#include "iodefine_cfg.h"
+
+#include "FreeRTOS.h"
+
+#include "socket.h"
+#include "r_audio_rtp.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+/* Free running OSTM1 counter used to time stamp each datagram */
+#define AUDIO_RTP_PRV_TIME_STAMP()          (OSTM1.OSTMnCNT)
+#define AUDIO_RTP_PRV_COUNTS_PER_US         (configPERIPHERAL_CLOCK0_HZ / 1000000UL)
+
+/* Fixed part of the RTP header, RFC 3550 section 5.1 */
+#define AUDIO_RTP_PRV_HEADER_BYTES          (12u)
+#define AUDIO_RTP_PRV_VERSION               (2u)
+
+/* Largest datagram taken off the socket */
+#define AUDIO_RTP_PRV_DATAGRAM_BYTES        (1500u)
+
+/* The socket is polled, this is how long the task sleeps once it has been drained */
+#define AUDIO_RTP_PRV_POLL_MS               (1)
+
+/******************************************************************************
+ Typedef definitions
+ ******************************************************************************/
+typedef struct st_audio_rtp
+{
+    st_audio_rtp_config_t config;
+    p_audio_jitter_t p_jitter;
+    int      socket;
+
+    volatile bool_t running;        /* written by destroy, the receive task keeps going while set */
+    volatile bool_t active;         /* written by the receive task, it is using the socket */
+
+    uint8_t  datagram[AUDIO_RTP_PRV_DATAGRAM_BYTES];
+
+    /* receive task counters */
+    volatile uint32_t datagrams;
+    volatile uint32_t invalid;
+    volatile uint32_t wrong_type;
+} st_audio_rtp_t;
+
+/******************************************************************************
+ Private global variables and functions
+ ******************************************************************************/
+static void task_audio_rtp_receive (void *parameters);
+static void receive_datagram (p_audio_rtp_t p_rtp, uint32_t length, uint32_t arrival);
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_rtp_default_config
+ * Description  : L16 stereo at 44.1 kHz, static payload type 10, on the default port
+ * Arguments    : st_audio_rtp_config_t *p_config - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_rtp_default_config (st_audio_rtp_config_t *p_config)
+{
+    memset(p_config, 0, sizeof(st_audio_rtp_config_t));
+    p_config->port = AUDIO_RTP_DEFAULT_PORT;
+    p_config->payload_type = AUDIO_RTP_PT_L16_STEREO;
+    p_config->min_delay_ms = 20u;
+    p_config->max_delay_ms = 250u;
+}
+/***********************************************************************************************************************
+ End of function r_audio_rtp_default_config
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_rtp_create
+ * Description  : Creates the jitter buffer, binds the port and starts the receive task
+ * Arguments    : const st_audio_rtp_config_t *p_config - settings
+ * Return Value : the receiver, NULL on failure
+ **********************************************************************************************************************/
+p_audio_rtp_t r_audio_rtp_create (const st_audio_rtp_config_t *p_config)
+{
+    st_audio_jitter_config_t jitter_config;
+    struct sockaddr_in address;
+    p_audio_rtp_t p_rtp;
+
+    p_rtp = R_OS_AllocMem(sizeof(st_audio_rtp_t), R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL == p_rtp)
+    {
+        return (NULL);
+    }
+
+    memset(p_rtp, 0, sizeof(st_audio_rtp_t));
+    p_rtp->config = *p_config;
+    p_rtp->socket = -1;
+
+    /* the static payload types fix the format, RFC 3551 table 4 */
+    if ((AUDIO_RTP_PT_L16_STEREO == p_config->payload_type) || (AUDIO_RTP_PT_L16_MONO == p_config->payload_type))
+    {
+        p_rtp->config.format.sample_rate = 44100u;
+        p_rtp->config.format.bits_per_sample = 16u;
+        p_rtp->config.format.channels = (AUDIO_RTP_PT_L16_STEREO == p_config->payload_type) ? 2u : 1u;
+    }
+
+    p_rtp->config.format.total_frames = 0u;
+
+    jitter_config.format = p_rtp->config.format;
+    jitter_config.min_delay_ms = p_config->min_delay_ms;
+    jitter_config.max_delay_ms = p_config->max_delay_ms;
+    jitter_config.counts_per_us = AUDIO_RTP_PRV_COUNTS_PER_US;
+
+    p_rtp->p_jitter = r_audio_jitter_create( &jitter_config);
+
+    if (NULL == p_rtp->p_jitter)
+    {
+        R_OS_FreeMem(p_rtp);
+        return (NULL);
+    }
+
+    p_rtp->socket = socket(AF_INET, SOCK_DGRAM, 0);
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(p_config->port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if ((p_rtp->socket < 0) || (bind(p_rtp->socket, (struct sockaddr *) &address, sizeof(address)) < 0))
+    {
+        if (p_rtp->socket >= 0)
+        {
+            close(p_rtp->socket);
+        }
+
+        r_audio_jitter_destroy(p_rtp->p_jitter);
+        R_OS_FreeMem(p_rtp);
+        return (NULL);
+    }
+
+    p_rtp->running = true;
+    p_rtp->active = true;
+
+    if (NULL == R_OS_CreateTask("rtp receive", task_audio_rtp_receive, p_rtp, R_OS_ABSTRACTION_PRV_DEFAULT_STACK_SIZE,
+            TASK_RTP_RECEIVE_PRI))
+    {
+        close(p_rtp->socket);
+        r_audio_jitter_destroy(p_rtp->p_jitter);
+        R_OS_FreeMem(p_rtp);
+        return (NULL);
+    }
+
+    return (p_rtp);
+}
+/***********************************************************************************************************************
+ End of function r_audio_rtp_create
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_rtp_destroy
+ * Description  : Stops the receive task, which closes the socket on its way out, and frees the receiver
+ * Arguments    : p_audio_rtp_t p_rtp - receiver, may be NULL
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_rtp_destroy (p_audio_rtp_t p_rtp)
+{
+    if (NULL != p_rtp)
+    {
+        p_rtp->running = false;
+
+        while (false != p_rtp->active)
+        {
+            R_OS_TaskSleep(AUDIO_RTP_PRV_POLL_MS);
+        }
+
+        r_audio_jitter_destroy(p_rtp->p_jitter);
+        R_OS_FreeMem(p_rtp);
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_rtp_destroy
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_rtp_get_format
+ * Description  : Copies the stream format
+ * Arguments    : p_audio_rtp_t p_rtp - receiver
+ *                st_audio_format_t *p_format - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_rtp_get_format (p_audio_rtp_t p_rtp, st_audio_format_t *p_format)
+{
+    *p_format = p_rtp->config.format;
+}
+/***********************************************************************************************************************
+ End of function r_audio_rtp_get_format
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_rtp_read
+ * Description  : Plays out frames from the jitter buffer
+ * Arguments    : p_audio_rtp_t p_rtp - receiver
+ *                uint32_t *p_frames - destination
+ *                uint32_t frames - frames wanted
+ *                uint32_t playout - OSTM1 count at which the first frame will be heard
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_rtp_read (p_audio_rtp_t p_rtp, uint32_t *p_frames, uint32_t frames, uint32_t playout)
+{
+    r_audio_jitter_get(p_rtp->p_jitter, p_frames, frames, playout);
+}
+/***********************************************************************************************************************
+ End of function r_audio_rtp_read
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_rtp_get_trim
+ * Description  : Reads the rate correction worked out by the jitter buffer
+ * Arguments    : p_audio_rtp_t p_rtp - receiver
+ * Return Value : ppm
+ **********************************************************************************************************************/
+int32_t r_audio_rtp_get_trim (p_audio_rtp_t p_rtp)
+{
+    return (r_audio_jitter_get_trim(p_rtp->p_jitter));
+}
+/***********************************************************************************************************************
+ End of function r_audio_rtp_get_trim
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_rtp_get_stats
+ * Description  : Copies the receiver counters and the jitter buffer statistics
+ * Arguments    : p_audio_rtp_t p_rtp - receiver
+ *                st_audio_rtp_stats_t *p_stats - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_rtp_get_stats (p_audio_rtp_t p_rtp, st_audio_rtp_stats_t *p_stats)
+{
+    p_stats->datagrams = p_rtp->datagrams;
+    p_stats->invalid = p_rtp->invalid;
+    p_stats->wrong_type = p_rtp->wrong_type;
+    r_audio_jitter_get_stats(p_rtp->p_jitter, &p_stats->jitter);
+}
+/***********************************************************************************************************************
+ End of function r_audio_rtp_get_stats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_rtp_reset_stats
+ * Description  : Clears the receiver and jitter buffer counters
+ * Arguments    : p_audio_rtp_t p_rtp - receiver
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_rtp_reset_stats (p_audio_rtp_t p_rtp)
+{
+    p_rtp->datagrams = 0u;
+    p_rtp->invalid = 0u;
+    p_rtp->wrong_type = 0u;
+    r_audio_jitter_reset_stats(p_rtp->p_jitter);
+}
+/***********************************************************************************************************************
+ End of function r_audio_rtp_reset_stats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: task_audio_rtp_receive
+ * Description  : Drains the socket without blocking, then sleeps for a tick. lwIP sockets must not be closed under a
+ *                blocked receive, polling lets the task close the socket itself when told to stop. The arrival time
+ *                is only as good as the poll interval, which the jitter estimate absorbs.
+ * Arguments    : void *parameters - the receiver
+ * Return Value : none
+ **********************************************************************************************************************/
+static void task_audio_rtp_receive (void *parameters)
+{
+    p_audio_rtp_t p_rtp = (p_audio_rtp_t) parameters;
+    int received;
+
+    while (false != p_rtp->running)
+    {
+        received = recvfrom(p_rtp->socket, p_rtp->datagram, sizeof(p_rtp->datagram), MSG_DONTWAIT, NULL, NULL);
+
+        if (received > 0)
+        {
+            receive_datagram(p_rtp, (uint32_t) received, AUDIO_RTP_PRV_TIME_STAMP());
+        }
+        else
+        {
+            /* drained, or an error which there is nothing to do about but try again */
+            R_OS_TaskSleep(AUDIO_RTP_PRV_POLL_MS);
+        }
+    }
+
+    close(p_rtp->socket);
+    p_rtp->active = false;
+
+    R_OS_DeleteTask(NULL);
+}
+/***********************************************************************************************************************
+ End of function task_audio_rtp_receive
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: receive_datagram
+ * Description  : Checks the RTP header, skips the CSRC list, header extension and padding, and stores the payload
+ * Arguments    : p_audio_rtp_t p_rtp - receiver, the datagram is in p_rtp->datagram
+ *                uint32_t length - datagram length
+ *                uint32_t arrival - OSTM1 count on receipt
+ * Return Value : none
+ **********************************************************************************************************************/
+static void receive_datagram (p_audio_rtp_t p_rtp, uint32_t length, uint32_t arrival)
+{
+    const uint8_t *p_data = p_rtp->datagram;
+    uint32_t header = AUDIO_RTP_PRV_HEADER_BYTES;
+    uint32_t padding = 0u;
+    uint16_t seq;
+    uint32_t timestamp;
+    uint32_t ssrc;
+
+    p_rtp->datagrams++;
+
+    if ((length < AUDIO_RTP_PRV_HEADER_BYTES) || (AUDIO_RTP_PRV_VERSION != (p_data[0] >> 6)))
+    {
+        p_rtp->invalid++;
+        return;
+    }
+
+    if ((p_data[1] & 0x7Fu) != p_rtp->config.payload_type)
+    {
+        p_rtp->wrong_type++;
+        return;
+    }
+
+    /* CSRC list */
+    header += (uint32_t) (p_data[0] & 0x0Fu) * 4u;
+
+    /* header extension, a 4 byte header giving its length in words */
+    if (0u != (p_data[0] & 0x10u))
+    {
+        if ((header + 4u) > length)
+        {
+            p_rtp->invalid++;
+            return;
+        }
+
+        header += 4u + ((((uint32_t) p_data[header + 2u] << 8) | p_data[header + 3u]) * 4u);
+    }
+
+    /* padding, the last byte counts the padding bytes including itself */
+    if (0u != (p_data[0] & 0x20u))
+    {
+        padding = p_data[length - 1u];
+    }
+
+    if ((header + padding) >= length)
+    {
+        p_rtp->invalid++;
+        return;
+    }
+
+    seq = (uint16_t) (((uint32_t) p_data[2] << 8) | p_data[3]);
+    timestamp = ((uint32_t) p_data[4] << 24) | ((uint32_t) p_data[5] << 16) | ((uint32_t) p_data[6] << 8) | p_data[7];
+    ssrc = ((uint32_t) p_data[8] << 24) | ((uint32_t) p_data[9] << 16) | ((uint32_t) p_data[10] << 8) | p_data[11];
+
+    r_audio_jitter_put(p_rtp->p_jitter, seq, timestamp, ssrc, p_data + header, length - header - padding, arrival);
+}
+/***********************************************************************************************************************
+ End of function receive_datagram
+ **********************************************************************************************************************/
+
+#endif /* R_SELF_LOAD_MIDDLEWARE_ETHERNET_MODULES */
@@ -0,0 +1,481 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ ******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.  */
+/******************************************************************************
+ * File Name    : r_audio_stream.c
+ * Device(s)    : RZ/A1L
+ * Tool-Chain   : GNUARM-NONE-EABI-v16.01
+ * H/W Platform : Stream it! v2 board
+ * Description  : Streaming file source, a prefetch task reads large chunk
+ *                aligned blocks of the file ahead of the playhead
+ ******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 13.06.2018 1.00 First Release
+ *****************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ *****************************************************************************/
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+#include <string.h>
+
+#include "r_typedefs.h"
+#include "r_os_abstraction_api.h"
+#include "r_task_priority.h"
+#include "iodefine_cfg.h"
+
+#include "FreeRTOS.h"
+
+#include "ff.h"
+#include "r_audio_ring.h"
+#include "r_audio_stream.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+/* Free running OSTM1 counter used to time each f_read */
+#define AUDIO_STREAM_PRV_TIME_STAMP()       (OSTM1.OSTMnCNT)
+#define AUDIO_STREAM_PRV_COUNTS_PER_US      (configPERIPHERAL_CLOCK0_HZ / 1000000UL)
+
+/* How long the reader waits for the prefetch task before checking again */
+#define AUDIO_STREAM_PRV_WAIT_MS            (10)
+
+/******************************************************************************
+ Typedef definitions
+ ******************************************************************************/
+typedef struct st_audio_stream
+{
+    p_audio_ring_t p_ring;          /* queue of chunk buffers */
+    uint32_t prefetch_semaphore;    /* wakes the prefetch task */
+    uint32_t data_semaphore;        /* given each time a chunk is queued */
+
+    /* owned by the prefetch task while running */
+    FIL      *fp;
+    uint32_t remaining;
+    uint32_t next_offset;
+
+    volatile bool_t running;        /* written by the reader, prefetch may use the file */
+    volatile bool_t active;         /* written by the prefetch task, it is using the file */
+    volatile bool_t eof;            /* written by the prefetch task, nothing more will be queued */
+
+    /* owned by the reader */
+    uint8_t  *p_head;               /* chunk being copied out */
+    uint32_t head_len;
+    uint32_t head_pos;
+    bool_t   waiting;
+
+    /* single writer counters */
+    volatile uint32_t bytes_fetched;    /* prefetch task */
+    volatile uint32_t bytes_consumed;   /* reader */
+    volatile uint32_t underruns;        /* reader */
+    volatile uint32_t chunks_read;      /* prefetch task */
+    volatile uint32_t max_read_us;      /* prefetch task */
+    volatile uint32_t read_errors;      /* prefetch task */
+} st_audio_stream_t;
+
+/******************************************************************************
+ Private global variables and functions
+ ******************************************************************************/
+static void task_audio_prefetch (void *parameters);
+static void stream_low_callback (p_audio_ring_t p_ring, void *p_context);
+static size_t stream_source_read (void *p_context, void *p_buf, size_t len);
+static bool_t stream_source_seek (void *p_context, uint32_t offset);
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_stream_create
+ * Description  : Allocates the chunk queue and starts the (idle) prefetch task
+ * Arguments    : const char_t *p_task_name - name of the prefetch task
+ * Return Value : the stream, NULL on failure
+ **********************************************************************************************************************/
+p_audio_stream_t r_audio_stream_create (const char_t *p_task_name)
+{
+    p_audio_stream_t p_stream;
+    st_audio_ring_config_t ring_config;
+
+    p_stream = R_OS_AllocMem(sizeof(st_audio_stream_t), R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL == p_stream)
+    {
+        return (NULL);
+    }
+
+    memset(p_stream, 0, sizeof(st_audio_stream_t));
+    p_stream->eof = true;
+
+    /* refill as soon as one chunk has been consumed */
+    ring_config.period_count = AUDIO_STREAM_CHUNK_COUNT;
+    ring_config.period_size = AUDIO_STREAM_CHUNK_BYTES;
+    ring_config.high_watermark = AUDIO_STREAM_CHUNK_COUNT;
+    ring_config.low_watermark = AUDIO_STREAM_CHUNK_COUNT - 1u;
+    ring_config.high_callback = NULL;
+    ring_config.low_callback = &stream_low_callback;
+    ring_config.p_context = p_stream;
+
+    p_stream->p_ring = r_audio_ring_create( &ring_config);
+
+    if ((NULL == p_stream->p_ring)
+            || (true != R_OS_CreateSemaphore( &p_stream->prefetch_semaphore, 0))
+            || (true != R_OS_CreateSemaphore( &p_stream->data_semaphore, 0)))
+    {
+        r_audio_ring_destroy(p_stream->p_ring);
+        R_OS_FreeMem(p_stream);
+        return (NULL);
+    }
+
+    R_OS_CreateTask(p_task_name, task_audio_prefetch, p_stream, R_OS_ABSTRACTION_PRV_DEFAULT_STACK_SIZE,
+            TASK_AUDIO_PREFETCH_PRI);
+
+    return (p_stream);
+}
+/***********************************************************************************************************************
+ End of function r_audio_stream_create
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_stream_start
+ * Description  : Points the stream at a file region and wakes the prefetch task
+ * Arguments    : p_audio_stream_t p_stream - stream
+ *                FIL *fp - open file
+ *                uint32_t offset - file offset of the region
+ *                uint32_t length - bytes in the region
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_stream_start (p_audio_stream_t p_stream, FIL *fp, uint32_t offset, uint32_t length)
+{
+    r_audio_stream_stop(p_stream);
+
+    p_stream->fp = fp;
+    p_stream->next_offset = offset;
+    p_stream->remaining = (NULL != fp) ? length : 0u;
+    p_stream->bytes_fetched = 0u;
+    p_stream->bytes_consumed = 0u;
+
+    if (0u != p_stream->remaining)
+    {
+        f_lseek(fp, offset);
+        p_stream->eof = false;
+        p_stream->running = true;
+        R_OS_ReleaseSemaphore( &p_stream->prefetch_semaphore);
+    }
+}
+/***********************************************************************************************************************
+ End of function r_audio_stream_start
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_stream_stop
+ * Description  : Parks the prefetch task and drops everything queued
+ * Arguments    : p_audio_stream_t p_stream - stream
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_stream_stop (p_audio_stream_t p_stream)
+{
+    p_stream->running = false;
+
+    /* the prefetch task finishes the f_read it is in, then leaves the file alone */
+    while (false != p_stream->active)
+    {
+        R_OS_TaskSleep(1);
+    }
+
+    r_audio_ring_reset(p_stream->p_ring);
+    p_stream->p_head = NULL;
+    p_stream->head_len = 0u;
+    p_stream->head_pos = 0u;
+    p_stream->waiting = false;
+    p_stream->eof = true;
+}
+/***********************************************************************************************************************
+ End of function r_audio_stream_stop
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_stream_read
+ * Description  : Copies the next bytes of the region out of the chunk queue
+ * Arguments    : p_audio_stream_t p_stream - stream
+ *                void *p_buf - destination
+ *                size_t len - bytes wanted
+ * Return Value : bytes copied
+ **********************************************************************************************************************/
+size_t r_audio_stream_read (p_audio_stream_t p_stream, void *p_buf, size_t len)
+{
+    uint8_t *p_dst = (uint8_t *) p_buf;
+    size_t copied = 0u;
+    size_t count;
+    bool_t eof;
+
+    while (copied < len)
+    {
+        if (p_stream->head_pos == p_stream->head_len)
+        {
+            if (NULL != p_stream->p_head)
+            {
+                /* chunk used up, hand it back to the prefetch task */
+                p_stream->p_head = NULL;
+                r_audio_ring_release(p_stream->p_ring);
+            }
+
+            /* sample eof before looking at the queue, the last chunk is queued before eof is set */
+            eof = p_stream->eof;
+            p_stream->p_head = r_audio_ring_get_read_period(p_stream->p_ring, &p_stream->head_len);
+
+            if (NULL == p_stream->p_head)
+            {
+                p_stream->head_len = 0u;
+                p_stream->head_pos = 0u;
+
+                if (false != eof)
+                {
+                    break;
+                }
+
+                /* count each time the playhead catches the prefetch task, not each poll */
+                if (false == p_stream->waiting)
+                {
+                    p_stream->underruns++;
+                    p_stream->waiting = true;
+                }
+
+                R_OS_WaitForSemaphore( &p_stream->data_semaphore, AUDIO_STREAM_PRV_WAIT_MS);
+                continue;
+            }
+
+            r_audio_ring_commit_read(p_stream->p_ring);
+            p_stream->head_pos = 0u;
+            p_stream->waiting = false;
+        }
+
+        count = p_stream->head_len - p_stream->head_pos;
+
+        if (count > (len - copied))
+        {
+            count = len - copied;
+        }
+
+        memcpy(p_dst + copied, p_stream->p_head + p_stream->head_pos, count);
+        p_stream->head_pos += count;
+        copied += count;
+    }
+
+    p_stream->bytes_consumed += copied;
+
+    return (copied);
+}
+/***********************************************************************************************************************
+ End of function r_audio_stream_read
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_stream_init_source
+ * Description  : Starts streaming the whole file and fills in a decoder source that reads from the stream
+ * Arguments    : p_audio_stream_t p_stream - stream
+ *                FIL *fp - open file
+ *                st_audio_source_t *p_source - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_stream_init_source (p_audio_stream_t p_stream, FIL *fp, st_audio_source_t *p_source)
+{
+    p_source->read = &stream_source_read;
+    p_source->seek = &stream_source_seek;
+    p_source->size = (uint32_t) f_size(fp);
+    p_source->p_context = p_stream;
+
+    r_audio_stream_start(p_stream, fp, 0u, p_source->size);
+}
+/***********************************************************************************************************************
+ End of function r_audio_stream_init_source
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_audio_stream_get_stats
+ * Description  : Copies the stream statistics
+ * Arguments    : p_audio_stream_t p_stream - stream
+ *                st_audio_stream_stats_t *p_stats - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_audio_stream_get_stats (p_audio_stream_t p_stream, st_audio_stream_stats_t *p_stats)
+{
+    if ((NULL == p_stream) || (NULL == p_stats))
+    {
+        return;
+    }
+
+    p_stats->fill_bytes = p_stream->bytes_fetched - p_stream->bytes_consumed;
+    p_stats->capacity_bytes = AUDIO_STREAM_CHUNK_BYTES * AUDIO_STREAM_CHUNK_COUNT;
+    p_stats->underruns = p_stream->underruns;
+    p_stats->chunks_read = p_stream->chunks_read;
+    p_stats->max_read_us = p_stream->max_read_us;
+    p_stats->read_errors = p_stream->read_errors;
+}
+/***********************************************************************************************************************
+ End of function r_audio_stream_get_stats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: task_audio_prefetch
+ * Description  : Fills every free chunk buffer, then sleeps until the reader frees one. The first read is cut short so
+ *                that every later read starts on a AUDIO_STREAM_CHUNK_BYTES boundary of the file.
+ * Arguments    : void *parameters - the stream
+ * Return Value : none
+ **********************************************************************************************************************/
+static void task_audio_prefetch (void *parameters)
+{
+    p_audio_stream_t p_stream = (p_audio_stream_t) parameters;
+    uint8_t *p_chunk;
+    uint32_t length;
+    uint32_t start;
+    uint32_t read_us;
+    UINT bytes_read;
+    FRESULT res;
+
+    while (1)
+    {
+        R_OS_WaitForSemaphore( &p_stream->prefetch_semaphore, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
+
+        p_stream->active = true;
+
+        while ((false != p_stream->running) && (0u != p_stream->remaining))
+        {
+            p_chunk = r_audio_ring_get_write_period(p_stream->p_ring);
+
+            if (NULL == p_chunk)
+            {
+                /* queue full, the reader releasing a chunk wakes us */
+                break;
+            }
+
+            length = AUDIO_STREAM_CHUNK_BYTES - (p_stream->next_offset & (AUDIO_STREAM_CHUNK_BYTES - 1u));
+
+            if (length > p_stream->remaining)
+            {
+                length = p_stream->remaining;
+            }
+
+            start = AUDIO_STREAM_PRV_TIME_STAMP();
+            res = f_read(p_stream->fp, p_chunk, length, &bytes_read);
+            read_us = (AUDIO_STREAM_PRV_TIME_STAMP() - start) / AUDIO_STREAM_PRV_COUNTS_PER_US;
+
+            p_stream->chunks_read++;
+
+            if (read_us > p_stream->max_read_us)
+            {
+                p_stream->max_read_us = read_us;
+            }
+
+            if ((FR_OK != res) || (0u == bytes_read))
+            {
+                /* treat a failed read as the end of the region */
+                p_stream->read_errors++;
+                bytes_read = 0u;
+                p_stream->remaining = 0u;
+            }
+            else
+            {
+                p_stream->next_offset += bytes_read;
+                p_stream->remaining -= bytes_read;
+                p_stream->bytes_fetched += bytes_read;
+                r_audio_ring_commit_write(p_stream->p_ring, bytes_read);
+            }
+
+            if (0u == p_stream->remaining)
+            {
+                p_stream->eof = true;
+            }
+
+            R_OS_ReleaseSemaphore( &p_stream->data_semaphore);
+        }
+
+        p_stream->active = false;
+    }
+}
+/***********************************************************************************************************************
+ End of function task_audio_prefetch
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: stream_low_callback
+ * Description  : The reader has freed a chunk, wake the prefetch task to refill it
+ * Arguments    : p_audio_ring_t p_ring - chunk queue
+ *                void *p_context - the stream
+ * Return Value : none
+ **********************************************************************************************************************/
+static void stream_low_callback (p_audio_ring_t p_ring, void *p_context)
+{
+    UNUSED_PARAM(p_ring);
+
+    R_OS_ReleaseSemaphore( &((p_audio_stream_t) p_context)->prefetch_semaphore);
+}
+/***********************************************************************************************************************
+ End of function stream_low_callback
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: stream_source_read
+ * Description  : st_audio_source_t read on top of r_audio_stream_read
+ * Arguments    : void *p_context - the stream
+ *                void *p_buf - destination
+ *                size_t len - bytes wanted
+ * Return Value : bytes copied
+ **********************************************************************************************************************/
+static size_t stream_source_read (void *p_context, void *p_buf, size_t len)
+{
+    return (r_audio_stream_read((p_audio_stream_t) p_context, p_buf, len));
+}
+/***********************************************************************************************************************
+ End of function stream_source_read
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: stream_source_seek
+ * Description  : st_audio_source_t seek, restarts the prefetch at the new offset and streams to the end of the file
+ * Arguments    : void *p_context - the stream
+ *                uint32_t offset - file offset
+ * Return Value : false if the offset is past the end of the file
+ **********************************************************************************************************************/
+static bool_t stream_source_seek (void *p_context, uint32_t offset)
+{
+    p_audio_stream_t p_stream = (p_audio_stream_t) p_context;
+    uint32_t size;
+
+    if (NULL == p_stream->fp)
+    {
+        return (false);
+    }
+
+    size = (uint32_t) f_size(p_stream->fp);
+
+    if (offset > size)
+    {
+        return (false);
+    }
+
+    r_audio_stream_start(p_stream, p_stream->fp, offset, size - offset);
+
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function stream_source_seek
+ **********************************************************************************************************************/
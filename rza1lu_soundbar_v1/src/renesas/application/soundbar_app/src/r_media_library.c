@@ -0,0 +1,1891 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ ******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.  */
+/******************************************************************************
+ * File Name    : r_media_library.c
+ * Device(s)    : RZ/A1L
+ * Tool-Chain   : GNUARM-NONE-EABI-v16.01
+ * H/W Platform : Stream it! v2 board
+ * Description  : Index of the audio files on the mounted drives, scanned in
+ *                the background and kept on each drive between insertions
+ ******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 02.07.2018 1.00 First Release
+ *****************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ *****************************************************************************/
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "r_typedefs.h"
+#include "r_os_abstraction_api.h"
+#include "r_task_priority.h"
+#include "dev_drv.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "dskManager.h"
+#include "r_fatfs_abstraction.h"
+#include "ff.h"
+#include "r_audio_decoder.h"
+#include "r_media_library.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+/* "RMLI" when read as a little endian word, the version changes with the layout of the records */
+#define MEDIA_LIBRARY_PRV_MAGIC             (0x494C4D52uL)
+#define MEDIA_LIBRARY_PRV_VERSION           (1u)
+
+/* Written next to the index and renamed over it once complete */
+#define MEDIA_LIBRARY_PRV_TEMP_NAME         "MEDIALIB.TMP"
+
+/* Drives A: to H:, the ones FatFs has volumes for */
+#define MEDIA_LIBRARY_PRV_DRIVES            (8u)
+
+/* Limits, also used to reject a corrupt index file */
+#define MEDIA_LIBRARY_PRV_MAX_DIRS          (4096u)
+#define MEDIA_LIBRARY_PRV_MAX_TRACKS        (32768u)
+#define MEDIA_LIBRARY_PRV_MAX_POOL          (4u * 1024u * 1024u)
+
+/* Starting sizes, each doubles as the scan needs more */
+#define MEDIA_LIBRARY_PRV_INITIAL_DIRS      (16u)
+#define MEDIA_LIBRARY_PRV_INITIAL_TRACKS    (64u)
+#define MEDIA_LIBRARY_PRV_INITIAL_POOL      (4096u)
+
+/* Chunks or metadata blocks looked at for tags before giving up */
+#define MEDIA_LIBRARY_PRV_MAX_CHUNKS        (64u)
+
+/* Longest Vorbis comment field name looked for, "ARTIST=" */
+#define MEDIA_LIBRARY_PRV_MAX_FIELD         (8u)
+
+#define MEDIA_LIBRARY_PRV_TIME_MS()         ((uint32_t) (xTaskGetTickCount() * portTICK_PERIOD_MS))
+
+/* FNV-1a, for path hashes, directory signatures and the file checksum */
+#define MEDIA_LIBRARY_PRV_HASH_BASIS        (2166136261uL)
+#define MEDIA_LIBRARY_PRV_HASH_PRIME        (16777619uL)
+
+/******************************************************************************
+ Typedef definitions
+ ******************************************************************************/
+/* Start of the index file, followed by the directories, the tracks and the string pool */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t dir_count;
+    uint32_t track_count;
+    uint32_t pool_bytes;
+    uint32_t checksum;          /* of everything after the header */
+} st_library_header_t;
+
+/* Strings are offsets into the pool, offset 0 is always "" */
+typedef struct
+{
+    uint32_t path;              /* "" for the root, otherwise "/dir/sub" */
+    uint32_t hash;              /* of the path */
+    uint32_t signature;         /* of the names, sizes and dates of the audio files */
+    uint32_t first_track;
+    uint32_t track_count;
+} st_library_dir_t;
+
+typedef struct
+{
+    uint32_t dir;
+    uint32_t name;
+    uint32_t size;
+    uint32_t date;
+    uint32_t sample_rate;
+    uint32_t total_frames;
+    uint32_t title;
+    uint32_t artist;
+    uint32_t album;
+    uint16_t bits_per_sample;
+    uint8_t  channels;
+    uint8_t  format;
+} st_library_track_t;
+
+typedef struct
+{
+    st_library_header_t header; /* the counts are what is in use */
+    st_library_dir_t    *p_dirs;
+    st_library_track_t  *p_tracks;
+    char_t              *p_pool;
+    uint32_t dir_capacity;
+    uint32_t track_capacity;
+    uint32_t pool_capacity;
+} st_library_t;
+
+typedef struct
+{
+    st_library_t *p_library;    /* published index, replaced under gsp_mutex */
+    st_media_library_status_t status;
+} st_library_drive_t;
+
+/* Work space of the scan task, too big for its stack */
+typedef struct
+{
+    DIR      dir;
+    FATENTRY entry;
+    st_audio_decoder_t decoder;
+    char_t   path[MEDIA_LIBRARY_MAX_PATH];      /* FatFs path being listed or opened */
+    char_t   dir_path[MEDIA_LIBRARY_MAX_PATH];  /* directory being scanned */
+    char_t   title[MEDIA_LIBRARY_MAX_TAG];
+    char_t   artist[MEDIA_LIBRARY_MAX_TAG];
+    char_t   album[MEDIA_LIBRARY_MAX_TAG];
+    uint8_t  field[MEDIA_LIBRARY_PRV_MAX_FIELD + MEDIA_LIBRARY_MAX_TAG];
+    uint32_t files_parsed;
+    uint32_t dirs_reused;
+    bool_t   changed;
+} st_library_scan_t;
+
+/******************************************************************************
+ Private global variables and functions
+ ******************************************************************************/
+static st_library_drive_t gs_drives[MEDIA_LIBRARY_PRV_DRIVES];
+static st_library_scan_t gs_scan;
+static void *gsp_mutex = NULL;
+static uint32_t gs_semaphore;
+
+/* Drive bits, set by the disk manager and taken by the scan task */
+static volatile uint32_t gs_pending_scan = 0u;
+static volatile uint32_t gs_pending_remove = 0u;
+
+/* application/stricmp.c, the C library does not have them */
+extern int stricmp (const char *s1, const char *s2);
+extern int strnicmp (const char *s1, const char *s2, size_t count);
+
+static void task_media_library (void *parameters);
+static void library_media_change (int8_t chDriveLetter, _Bool bfMounted);
+static void library_scan_drive (uint32_t slot);
+static st_library_t *library_build (uint32_t slot, const st_library_t *p_old);
+static bool_t library_scan_directory (uint32_t slot, st_library_t *p_lib, uint32_t dir_index);
+static bool_t library_fill_tracks (uint32_t slot, st_library_t *p_lib, uint32_t dir_index, const st_library_t *p_old);
+static bool_t library_parse_file (uint32_t slot, const char_t *p_name, st_library_track_t *p_track);
+static st_library_t *library_create (uint32_t dirs, uint32_t tracks, uint32_t pool_bytes);
+static void library_free (st_library_t *p_lib);
+static bool_t library_add_string (st_library_t *p_lib, const char_t *p_text, uint32_t *p_offset);
+static bool_t library_add_tag (st_library_t *p_lib, const char_t *p_text, uint32_t previous, uint32_t *p_offset);
+static const st_library_dir_t *library_find_dir (const st_library_t *p_lib, const char_t *p_path, uint32_t hash,
+        uint32_t hint);
+static st_library_t *library_load (uint32_t slot);
+static bool_t library_save (uint32_t slot, const st_library_t *p_lib);
+static void library_publish (uint32_t slot, st_library_t *p_lib);
+static uint32_t library_hash (uint32_t hash, const void *p_data, uint32_t length);
+static uint32_t library_checksum (const st_library_t *p_lib);
+static void library_copy_string (char_t *p_dest, const char_t *p_src, uint32_t size);
+static bool_t library_contains (const char_t *p_text, const char_t *p_find);
+static bool_t library_is_audio_file (const char_t *p_name);
+static int32_t library_slot (char_t drive);
+static bool_t scan_read (FIL *fp, uint32_t offset, void *p_buf, uint32_t len);
+static void scan_read_tags (FIL *fp);
+static void scan_riff_info (FIL *fp, uint32_t offset, uint32_t end);
+static void scan_aiff_tags (FIL *fp, uint32_t offset, uint32_t end);
+static void scan_flac_comments (FIL *fp, uint32_t offset, uint32_t end);
+static void scan_set_tag (char_t *p_tag, const uint8_t *p_text, uint32_t length);
+static size_t scan_source_read (void *p_context, void *p_buf, size_t len);
+static bool_t scan_source_seek (void *p_context, uint32_t offset);
+
+/***********************************************************************************************************************
+ * Function Name: r_media_library_init
+ * Description  : Creates the scan task and asks the disk manager to report drives as they come and go
+ * Arguments    : none
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_media_library_init (void)
+{
+    if (NULL != gsp_mutex)
+    {
+        return;
+    }
+
+    memset(gs_drives, 0, sizeof(gs_drives));
+
+    gsp_mutex = R_OS_CreateMutex();
+
+    if ((NULL == gsp_mutex) || (true != R_OS_CreateSemaphore( &gs_semaphore, 0)))
+    {
+        return;
+    }
+
+    R_OS_CreateTask("Media Library", task_media_library, NULL, R_OS_ABSTRACTION_PRV_DEFAULT_STACK_SIZE,
+            TASK_MEDIA_LIBRARY_PRI);
+
+    /* drives that are already mounted are reported straight away */
+    dskSetMediaCallback( &library_media_change);
+}
+/***********************************************************************************************************************
+ End of function r_media_library_init
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_media_library_rescan
+ * Description  : Queues a check of a drive for changes
+ * Arguments    : char_t drive - drive letter
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_media_library_rescan (char_t drive)
+{
+    int32_t slot = library_slot(drive);
+
+    if ((slot >= 0) && (NULL != gsp_mutex))
+    {
+        R_OS_EnterCritical();
+        gs_pending_scan |= (1u << slot);
+        R_OS_ExitCritical();
+
+        R_OS_ReleaseSemaphore( &gs_semaphore);
+    }
+}
+/***********************************************************************************************************************
+ End of function r_media_library_rescan
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_media_library_get_status
+ * Description  : Copies the state of the index of a drive
+ * Arguments    : char_t drive - drive letter
+ *                st_media_library_status_t *p_status - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_media_library_get_status (char_t drive, st_media_library_status_t *p_status)
+{
+    int32_t slot = library_slot(drive);
+
+    memset(p_status, 0, sizeof(st_media_library_status_t));
+
+    if ((slot >= 0) && (NULL != gsp_mutex))
+    {
+        R_OS_AcquireMutex(gsp_mutex);
+        *p_status = gs_drives[slot].status;
+        R_OS_ReleaseMutex(gsp_mutex);
+    }
+}
+/***********************************************************************************************************************
+ End of function r_media_library_get_status
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_media_library_get_count
+ * Description  : Number of tracks in the index of a drive
+ * Arguments    : char_t drive - drive letter
+ * Return Value : tracks
+ **********************************************************************************************************************/
+uint32_t r_media_library_get_count (char_t drive)
+{
+    int32_t slot = library_slot(drive);
+    uint32_t count = 0u;
+
+    if ((slot >= 0) && (NULL != gsp_mutex))
+    {
+        R_OS_AcquireMutex(gsp_mutex);
+
+        if (NULL != gs_drives[slot].p_library)
+        {
+            count = gs_drives[slot].p_library->header.track_count;
+        }
+
+        R_OS_ReleaseMutex(gsp_mutex);
+    }
+
+    return (count);
+}
+/***********************************************************************************************************************
+ End of function r_media_library_get_count
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_media_library_get_track
+ * Description  : Copies a track out of the index
+ * Arguments    : char_t drive - drive letter
+ *                uint32_t index - track index
+ *                st_media_track_t *p_track - destination
+ * Return Value : DEVDRV_SUCCESS or DEVDRV_ERROR
+ **********************************************************************************************************************/
+int32_t r_media_library_get_track (char_t drive, uint32_t index, st_media_track_t *p_track)
+{
+    int32_t slot = library_slot(drive);
+    int32_t result = DEVDRV_ERROR;
+    const st_library_t *p_lib;
+    const st_library_track_t *p_entry;
+
+    if ((slot < 0) || (NULL == gsp_mutex))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    R_OS_AcquireMutex(gsp_mutex);
+
+    p_lib = gs_drives[slot].p_library;
+
+    if ((NULL != p_lib) && (index < p_lib->header.track_count))
+    {
+        p_entry = &p_lib->p_tracks[index];
+
+        snprintf(p_track->path, sizeof(p_track->path), "%c:%s/%s", (char) ('A' + slot),
+                &p_lib->p_pool[p_lib->p_dirs[p_entry->dir].path], &p_lib->p_pool[p_entry->name]);
+        library_copy_string(p_track->title, &p_lib->p_pool[p_entry->title], sizeof(p_track->title));
+        library_copy_string(p_track->artist, &p_lib->p_pool[p_entry->artist], sizeof(p_track->artist));
+        library_copy_string(p_track->album, &p_lib->p_pool[p_entry->album], sizeof(p_track->album));
+
+        p_track->size = p_entry->size;
+        p_track->date = p_entry->date;
+        p_track->sample_rate = p_entry->sample_rate;
+        p_track->duration_ms = (0u != p_entry->sample_rate) ?
+                (uint32_t) (((uint64_t) p_entry->total_frames * 1000u) / p_entry->sample_rate) : 0u;
+        p_track->bits_per_sample = p_entry->bits_per_sample;
+        p_track->channels = p_entry->channels;
+        p_track->format = p_entry->format;
+
+        result = DEVDRV_SUCCESS;
+    }
+
+    R_OS_ReleaseMutex(gsp_mutex);
+
+    return (result);
+}
+/***********************************************************************************************************************
+ End of function r_media_library_get_track
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_media_library_find
+ * Description  : Looks for the next track of one of the formats whose file name or tags contain the text
+ * Arguments    : char_t drive - drive letter
+ *                const char_t *p_text - text to find, NULL or "" for any
+ *                uint32_t formats - mask of MEDIA_LIBRARY_FORMAT_x
+ *                uint32_t start - first index to look at
+ * Return Value : index of the track or -1
+ **********************************************************************************************************************/
+int32_t r_media_library_find (char_t drive, const char_t *p_text, uint32_t formats, uint32_t start)
+{
+    int32_t slot = library_slot(drive);
+    int32_t result = -1;
+    const st_library_t *p_lib;
+    const st_library_track_t *p_entry;
+    uint32_t index;
+
+    if ((slot < 0) || (NULL == gsp_mutex))
+    {
+        return (-1);
+    }
+
+    R_OS_AcquireMutex(gsp_mutex);
+
+    p_lib = gs_drives[slot].p_library;
+
+    if (NULL != p_lib)
+    {
+        for (index = start; index < p_lib->header.track_count; index++)
+        {
+            p_entry = &p_lib->p_tracks[index];
+
+            if ((0u != (formats & p_entry->format))
+                    && ((NULL == p_text) || ('\0' == p_text[0])
+                            || library_contains( &p_lib->p_pool[p_entry->name], p_text)
+                            || library_contains( &p_lib->p_pool[p_entry->title], p_text)
+                            || library_contains( &p_lib->p_pool[p_entry->artist], p_text)
+                            || library_contains( &p_lib->p_pool[p_entry->album], p_text)))
+            {
+                result = (int32_t) index;
+                break;
+            }
+        }
+    }
+
+    R_OS_ReleaseMutex(gsp_mutex);
+
+    return (result);
+}
+/***********************************************************************************************************************
+ End of function r_media_library_find
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_media_change
+ * Description  : Disk manager callback, queues the drive for the scan task. Called with the disk list locked
+ * Arguments    : int8_t chDriveLetter - drive letter
+ *                _Bool bfMounted - true if the drive has been mounted, false if it has gone
+ * Return Value : none
+ **********************************************************************************************************************/
+static void library_media_change (int8_t chDriveLetter, _Bool bfMounted)
+{
+    int32_t slot = library_slot((char_t) chDriveLetter);
+
+    if (slot < 0)
+    {
+        return;
+    }
+
+    R_OS_EnterCritical();
+
+    if (bfMounted)
+    {
+        gs_pending_scan |= (1u << slot);
+    }
+    else
+    {
+        gs_pending_scan &= ~(1u << slot);
+        gs_pending_remove |= (1u << slot);
+    }
+
+    R_OS_ExitCritical();
+
+    R_OS_ReleaseSemaphore( &gs_semaphore);
+}
+/***********************************************************************************************************************
+ End of function library_media_change
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: task_media_library
+ * Description  : Drops the index of drives that have gone and scans drives that have been mounted
+ * Arguments    : void *parameters - not used
+ * Return Value : none
+ **********************************************************************************************************************/
+static void task_media_library (void *parameters)
+{
+    uint32_t remove;
+    uint32_t scan;
+    uint32_t slot;
+
+    UNUSED_PARAM(parameters);
+
+    while (1)
+    {
+        R_OS_WaitForSemaphore( &gs_semaphore, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
+
+        do
+        {
+            R_OS_EnterCritical();
+            remove = gs_pending_remove;
+            gs_pending_remove = 0u;
+            scan = gs_pending_scan;
+            R_OS_ExitCritical();
+
+            for (slot = 0u; slot < MEDIA_LIBRARY_PRV_DRIVES; slot++)
+            {
+                if (0u != (remove & (1u << slot)))
+                {
+                    library_publish(slot, NULL);
+                }
+            }
+
+            /* one drive at a time so a removal is seen between scans */
+            for (slot = 0u; slot < MEDIA_LIBRARY_PRV_DRIVES; slot++)
+            {
+                if (0u != (scan & (1u << slot)))
+                {
+                    R_OS_EnterCritical();
+                    gs_pending_scan &= ~(1u << slot);
+                    R_OS_ExitCritical();
+
+                    library_scan_drive(slot);
+                    break;
+                }
+            }
+        } while ((0u != remove) || (0u != scan));
+    }
+}
+/***********************************************************************************************************************
+ End of function task_media_library
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_scan_drive
+ * Description  : Brings the index of a drive up to date. An index saved on the drive is published before the
+ *                scan so it can be used while the drive is checked, and the drive is only written if the scan
+ *                found a change.
+ * Arguments    : uint32_t slot - drive
+ * Return Value : none
+ **********************************************************************************************************************/
+static void library_scan_drive (uint32_t slot)
+{
+    st_library_t *p_old;
+    st_library_t *p_new;
+    uint32_t start = MEDIA_LIBRARY_PRV_TIME_MS();
+    bool_t loaded = false;
+    bool_t saved = false;
+
+    R_OS_AcquireMutex(gsp_mutex);
+    gs_drives[slot].status.scanning = true;
+    R_OS_ReleaseMutex(gsp_mutex);
+
+    /* only this task replaces the published index, so it can be read without the mutex */
+    p_old = gs_drives[slot].p_library;
+
+    if (NULL == p_old)
+    {
+        p_old = library_load(slot);
+
+        if (NULL != p_old)
+        {
+            loaded = true;
+            library_publish(slot, p_old);
+        }
+    }
+
+    p_new = library_build(slot, p_old);
+
+    if (NULL != p_new)
+    {
+        if (false != gs_scan.changed)
+        {
+            saved = library_save(slot, p_new);
+        }
+
+        library_publish(slot, p_new);
+    }
+
+    R_OS_AcquireMutex(gsp_mutex);
+    gs_drives[slot].status.scanning = false;
+    gs_drives[slot].status.files_parsed = gs_scan.files_parsed;
+    gs_drives[slot].status.dirs_reused = gs_scan.dirs_reused;
+    gs_drives[slot].status.scan_ms = MEDIA_LIBRARY_PRV_TIME_MS() - start;
+    gs_drives[slot].status.loaded = loaded;
+    gs_drives[slot].status.saved = saved;
+    R_OS_ReleaseMutex(gsp_mutex);
+}
+/***********************************************************************************************************************
+ End of function library_scan_drive
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_build
+ * Description  : Lists every directory of the drive, breadth first, and fills in the tracks of each from the
+ *                previous index where the file is unchanged
+ * Arguments    : uint32_t slot - drive
+ *                const st_library_t *p_old - previous index or NULL
+ * Return Value : the new index, NULL if the drive went or memory ran out
+ **********************************************************************************************************************/
+static st_library_t *library_build (uint32_t slot, const st_library_t *p_old)
+{
+    st_library_t *p_lib;
+    uint32_t dir_index;
+
+    gs_scan.files_parsed = 0u;
+    gs_scan.dirs_reused = 0u;
+    gs_scan.changed = (NULL == p_old);
+
+    p_lib = library_create(MEDIA_LIBRARY_PRV_INITIAL_DIRS, MEDIA_LIBRARY_PRV_INITIAL_TRACKS,
+            MEDIA_LIBRARY_PRV_INITIAL_POOL);
+
+    if (NULL == p_lib)
+    {
+        return (NULL);
+    }
+
+    /* the root, its path is the empty string at offset 0 */
+    memset( &p_lib->p_dirs[0], 0, sizeof(st_library_dir_t));
+    p_lib->p_dirs[0].hash = library_hash(MEDIA_LIBRARY_PRV_HASH_BASIS, "", 0u);
+    p_lib->header.dir_count = 1u;
+
+    /* directories found are appended, so this walks the whole tree */
+    for (dir_index = 0u; dir_index < p_lib->header.dir_count; dir_index++)
+    {
+        if ((0u != (gs_pending_remove & (1u << slot)))
+                || (false == library_scan_directory(slot, p_lib, dir_index))
+                || (false == library_fill_tracks(slot, p_lib, dir_index, p_old)))
+        {
+            library_free(p_lib);
+            return (NULL);
+        }
+    }
+
+    if ((NULL != p_old) && (p_old->header.dir_count != p_lib->header.dir_count))
+    {
+        gs_scan.changed = true;
+    }
+
+    return (p_lib);
+}
+/***********************************************************************************************************************
+ End of function library_build
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_scan_directory
+ * Description  : Lists a directory, appending its sub directories and a blank track for each audio file. The
+ *                signature of the directory is taken over the names, sizes and dates of the audio files.
+ * Arguments    : uint32_t slot - drive
+ *                st_library_t *p_lib - index being built
+ *                uint32_t dir_index - directory to list
+ * Return Value : false if the drive could not be read or memory ran out
+ **********************************************************************************************************************/
+static bool_t library_scan_directory (uint32_t slot, st_library_t *p_lib, uint32_t dir_index)
+{
+    st_library_dir_t *p_dir;
+    st_library_track_t *p_track;
+    FRESULT result;
+    uint32_t signature = MEDIA_LIBRARY_PRV_HASH_BASIS;
+    uint32_t first_track = p_lib->header.track_count;
+    size_t dir_length;
+    size_t name_length;
+
+    /* the pool moves as it grows, work from a copy of the path */
+    library_copy_string(gs_scan.dir_path, &p_lib->p_pool[p_lib->p_dirs[dir_index].path], sizeof(gs_scan.dir_path));
+    dir_length = strlen(gs_scan.dir_path);
+
+    /* FatFs volume numbers rather than drive letters, the path is not remapped */
+    snprintf(gs_scan.path, sizeof(gs_scan.path), "%c:%s", (char) ('0' + slot),
+            (0u != dir_length) ? gs_scan.dir_path : "/");
+
+    result = R_FAT_FindFirst( &gs_scan.dir, &gs_scan.entry, gs_scan.path, "*");
+
+    if (FR_OK != result)
+    {
+        p_lib->p_dirs[dir_index].first_track = first_track;
+        p_lib->p_dirs[dir_index].track_count = 0u;
+
+        /* an unreadable root means the drive has gone */
+        return (0u != dir_index);
+    }
+
+    while ((FR_OK == result) && ('\0' != gs_scan.entry.FileName[0]))
+    {
+        name_length = strlen(gs_scan.entry.FileName);
+
+        /* "A:" + path + "/" + name must fit a track path */
+        if ((0u == (gs_scan.entry.Attrib & (AM_HID | AM_SYS))) && ('.' != gs_scan.entry.FileName[0])
+                && ((dir_length + name_length + 4u) < MEDIA_LIBRARY_MAX_PATH))
+        {
+            if (0u != (gs_scan.entry.Attrib & AM_DIR))
+            {
+                if (p_lib->header.dir_count < MEDIA_LIBRARY_PRV_MAX_DIRS)
+                {
+                    if (p_lib->header.dir_count == p_lib->dir_capacity)
+                    {
+                        st_library_dir_t *p_dirs = R_OS_AllocMem(p_lib->dir_capacity * 2u * sizeof(st_library_dir_t),
+                                R_REGION_LARGE_CAPACITY_RAM);
+
+                        if (NULL == p_dirs)
+                        {
+                            return (false);
+                        }
+
+                        memcpy(p_dirs, p_lib->p_dirs, p_lib->header.dir_count * sizeof(st_library_dir_t));
+                        R_OS_FreeMem(p_lib->p_dirs);
+                        p_lib->p_dirs = p_dirs;
+                        p_lib->dir_capacity *= 2u;
+                    }
+
+                    snprintf(gs_scan.path, sizeof(gs_scan.path), "%s/%s", gs_scan.dir_path, gs_scan.entry.FileName);
+
+                    p_dir = &p_lib->p_dirs[p_lib->header.dir_count];
+                    memset(p_dir, 0, sizeof(st_library_dir_t));
+                    p_dir->hash = library_hash(MEDIA_LIBRARY_PRV_HASH_BASIS, gs_scan.path, strlen(gs_scan.path));
+
+                    if (false == library_add_string(p_lib, gs_scan.path, &p_dir->path))
+                    {
+                        return (false);
+                    }
+
+                    p_lib->header.dir_count++;
+                }
+            }
+            else if ((false != library_is_audio_file(gs_scan.entry.FileName))
+                    && (p_lib->header.track_count < MEDIA_LIBRARY_PRV_MAX_TRACKS))
+            {
+                if (p_lib->header.track_count == p_lib->track_capacity)
+                {
+                    st_library_track_t *p_tracks = R_OS_AllocMem(
+                            p_lib->track_capacity * 2u * sizeof(st_library_track_t), R_REGION_LARGE_CAPACITY_RAM);
+
+                    if (NULL == p_tracks)
+                    {
+                        return (false);
+                    }
+
+                    memcpy(p_tracks, p_lib->p_tracks, p_lib->header.track_count * sizeof(st_library_track_t));
+                    R_OS_FreeMem(p_lib->p_tracks);
+                    p_lib->p_tracks = p_tracks;
+                    p_lib->track_capacity *= 2u;
+                }
+
+                p_track = &p_lib->p_tracks[p_lib->header.track_count];
+                memset(p_track, 0, sizeof(st_library_track_t));
+                p_track->dir = dir_index;
+                p_track->size = gs_scan.entry.Filesize;
+                p_track->date = ((uint32_t) ((gs_scan.entry.ModifiedTime.Year - 1980u) & 0x7fu) << 25)
+                        | ((uint32_t) (gs_scan.entry.ModifiedTime.Month & 0xfu) << 21)
+                        | ((uint32_t) (gs_scan.entry.ModifiedTime.Day & 0x1fu) << 16)
+                        | ((uint32_t) (gs_scan.entry.ModifiedTime.Hour & 0x1fu) << 11)
+                        | ((uint32_t) (gs_scan.entry.ModifiedTime.Minute & 0x3fu) << 5)
+                        | ((uint32_t) (gs_scan.entry.ModifiedTime.Second & 0x3fu) >> 1);
+
+                if (false == library_add_string(p_lib, gs_scan.entry.FileName, &p_track->name))
+                {
+                    return (false);
+                }
+
+                signature = library_hash(signature, gs_scan.entry.FileName, name_length + 1u);
+                signature = library_hash(signature, &p_track->size, sizeof(p_track->size));
+                signature = library_hash(signature, &p_track->date, sizeof(p_track->date));
+
+                p_lib->header.track_count++;
+            }
+            else
+            {
+                /* not audio */
+            }
+        }
+
+        result = R_FAT_FindNext( &gs_scan.dir, &gs_scan.entry);
+    }
+
+    p_dir = &p_lib->p_dirs[dir_index];
+    p_dir->signature = signature;
+    p_dir->first_track = first_track;
+    p_dir->track_count = p_lib->header.track_count - first_track;
+
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function library_scan_directory
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_fill_tracks
+ * Description  : Fills in the format and tags of the tracks of a directory. Unchanged files are taken from the
+ *                previous index. Other files are opened, unless the directory signature is unchanged, in which
+ *                case they were not playable last time either. Files that cannot be played are dropped.
+ * Arguments    : uint32_t slot - drive
+ *                st_library_t *p_lib - index being built
+ *                uint32_t dir_index - directory just listed
+ *                const st_library_t *p_old - previous index or NULL
+ * Return Value : false if memory ran out
+ **********************************************************************************************************************/
+static bool_t library_fill_tracks (uint32_t slot, st_library_t *p_lib, uint32_t dir_index, const st_library_t *p_old)
+{
+    st_library_dir_t *p_dir = &p_lib->p_dirs[dir_index];
+    const st_library_dir_t *p_old_dir = NULL;
+    const st_library_track_t *p_old_track;
+    st_library_track_t *p_track;
+    st_library_track_t *p_previous;
+    bool_t same = false;
+    uint32_t read;
+    uint32_t write;
+    uint32_t old_index;
+    uint32_t count;
+    int32_t offset = 0;
+
+    if (NULL != p_old)
+    {
+        p_old_dir = library_find_dir(p_old, &p_lib->p_pool[p_dir->path], p_dir->hash, dir_index);
+    }
+
+    if ((NULL != p_old_dir) && (p_old_dir->signature == p_dir->signature))
+    {
+        same = true;
+        gs_scan.dirs_reused++;
+    }
+    else
+    {
+        gs_scan.changed = true;
+    }
+
+    write = p_dir->first_track;
+
+    for (read = p_dir->first_track; read < (p_dir->first_track + p_dir->track_count); read++)
+    {
+        p_track = &p_lib->p_tracks[read];
+        p_old_track = NULL;
+
+        /* files are listed in directory order, look where the last match suggests first */
+        if (NULL != p_old_dir)
+        {
+            old_index = (uint32_t) ((int32_t) (read - p_dir->first_track) + offset);
+
+            for (count = 0u; count < p_old_dir->track_count; count++)
+            {
+                if (old_index >= p_old_dir->track_count)
+                {
+                    old_index = 0u;
+                }
+
+                if (0 == strcmp( &p_old->p_pool[p_old->p_tracks[p_old_dir->first_track + old_index].name],
+                        &p_lib->p_pool[p_track->name]))
+                {
+                    p_old_track = &p_old->p_tracks[p_old_dir->first_track + old_index];
+                    offset = (int32_t) old_index - (int32_t) (read - p_dir->first_track);
+                    break;
+                }
+
+                old_index++;
+            }
+        }
+
+        if ((NULL != p_old_track) && (p_old_track->size == p_track->size) && (p_old_track->date == p_track->date))
+        {
+            library_copy_string(gs_scan.title, &p_old->p_pool[p_old_track->title], sizeof(gs_scan.title));
+            library_copy_string(gs_scan.artist, &p_old->p_pool[p_old_track->artist], sizeof(gs_scan.artist));
+            library_copy_string(gs_scan.album, &p_old->p_pool[p_old_track->album], sizeof(gs_scan.album));
+            p_track->sample_rate = p_old_track->sample_rate;
+            p_track->total_frames = p_old_track->total_frames;
+            p_track->bits_per_sample = p_old_track->bits_per_sample;
+            p_track->channels = p_old_track->channels;
+            p_track->format = p_old_track->format;
+        }
+        else if ((false != same) || (false == library_parse_file(slot, &p_lib->p_pool[p_track->name], p_track)))
+        {
+            /* not playable, its name stays in the pool unused */
+            continue;
+        }
+        else
+        {
+            gs_scan.files_parsed++;
+        }
+
+        /* tracks in a directory often share the artist and album */
+        p_previous = (write > p_dir->first_track) ? &p_lib->p_tracks[write - 1u] : NULL;
+
+        if ((false == library_add_string(p_lib, gs_scan.title, &p_track->title))
+                || (false == library_add_tag(p_lib, gs_scan.artist, (NULL != p_previous) ? p_previous->artist : 0u,
+                        &p_track->artist))
+                || (false == library_add_tag(p_lib, gs_scan.album, (NULL != p_previous) ? p_previous->album : 0u,
+                        &p_track->album)))
+        {
+            return (false);
+        }
+
+        if (write != read)
+        {
+            p_lib->p_tracks[write] = *p_track;
+        }
+
+        write++;
+    }
+
+    p_dir->track_count = write - p_dir->first_track;
+    p_lib->header.track_count = write;
+
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function library_fill_tracks
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_parse_file
+ * Description  : Opens a file, reads its tags into the scan work space and its format into the track
+ * Arguments    : uint32_t slot - drive
+ *                const char_t *p_name - file name, in the directory being scanned
+ *                st_library_track_t *p_track - destination
+ * Return Value : false if the file is not one the decoders can play
+ **********************************************************************************************************************/
+static bool_t library_parse_file (uint32_t slot, const char_t *p_name, st_library_track_t *p_track)
+{
+    st_audio_source_t source;
+    st_audio_format_t format;
+    FIL *fp;
+    bool_t result = false;
+
+    gs_scan.title[0] = '\0';
+    gs_scan.artist[0] = '\0';
+    gs_scan.album[0] = '\0';
+
+    snprintf(gs_scan.path, sizeof(gs_scan.path), "%c:%s/%s", (char) ('0' + slot), gs_scan.dir_path, p_name);
+
+    fp = R_FAT_OpenFile(gs_scan.path, FA_READ);
+
+    if (NULL == fp)
+    {
+        return (false);
+    }
+
+    scan_read_tags(fp);
+
+    /* the decoders decide what can be played, the header is all they read on open */
+    source.read = &scan_source_read;
+    source.seek = &scan_source_seek;
+    source.size = (uint32_t) f_size(fp);
+    source.p_context = fp;
+
+    if ((FR_OK == f_lseek(fp, 0u)) && (DEVDRV_SUCCESS == r_audio_decoder_open( &gs_scan.decoder, &source)))
+    {
+        r_audio_decoder_get_format( &gs_scan.decoder, &format);
+
+        if ( &g_audio_decoder_wav == gs_scan.decoder.p_ops)
+        {
+            p_track->format = MEDIA_LIBRARY_FORMAT_WAV;
+        }
+        else if ( &g_audio_decoder_aiff == gs_scan.decoder.p_ops)
+        {
+            p_track->format = MEDIA_LIBRARY_FORMAT_AIFF;
+        }
+        else
+        {
+            p_track->format = MEDIA_LIBRARY_FORMAT_FLAC;
+        }
+
+        p_track->sample_rate = format.sample_rate;
+        p_track->total_frames = format.total_frames;
+        p_track->bits_per_sample = format.bits_per_sample;
+        p_track->channels = (uint8_t) format.channels;
+
+        r_audio_decoder_close( &gs_scan.decoder);
+        result = true;
+    }
+
+    R_FAT_CloseFile(fp);
+
+    return (result);
+}
+/***********************************************************************************************************************
+ End of function library_parse_file
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: scan_read
+ * Description  : Reads from a file offset
+ * Arguments    : FIL *fp - file
+ *                uint32_t offset - file offset
+ *                void *p_buf - destination
+ *                uint32_t len - bytes
+ * Return Value : true if all the bytes were read
+ **********************************************************************************************************************/
+static bool_t scan_read (FIL *fp, uint32_t offset, void *p_buf, uint32_t len)
+{
+    if (FR_OK != f_lseek(fp, offset))
+    {
+        return (false);
+    }
+
+    return ((int) len == R_FAT_ReadFile(fp, p_buf, (unsigned int) len));
+}
+/***********************************************************************************************************************
+ End of function scan_read
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: scan_read_tags
+ * Description  : Reads the title, artist and album from a RIFF INFO list, the AIFF text chunks or a FLAC Vorbis
+ *                comment block into the scan work space
+ * Arguments    : FIL *fp - file
+ * Return Value : none
+ **********************************************************************************************************************/
+static void scan_read_tags (FIL *fp)
+{
+    uint8_t header[12];
+    uint8_t chunk[12];
+    uint32_t end = (uint32_t) f_size(fp);
+    uint32_t offset;
+    uint32_t size;
+    uint32_t next;
+    uint32_t count;
+
+    if (false == scan_read(fp, 0u, header, sizeof(header)))
+    {
+        return;
+    }
+
+    if ((0 == memcmp(header, "RIFF", 4)) && (0 == memcmp( &header[8], "WAVE", 4)))
+    {
+        /* the list is as likely to follow the data as precede it, seeking over the data is cheap */
+        for (count = 0u, offset = 12u; (count < MEDIA_LIBRARY_PRV_MAX_CHUNKS) && ((offset + 8u) <= end); count++)
+        {
+            if (false == scan_read(fp, offset, chunk, 12u))
+            {
+                break;
+            }
+
+            size = (uint32_t) chunk[4] | ((uint32_t) chunk[5] << 8) | ((uint32_t) chunk[6] << 16)
+                    | ((uint32_t) chunk[7] << 24);
+            next = offset + 8u + size + (size & 1u);
+
+            if ((0 == memcmp(chunk, "LIST", 4)) && (size >= 4u) && (0 == memcmp( &chunk[8], "INFO", 4)))
+            {
+                scan_riff_info(fp, offset + 12u, (next > end) ? end : next);
+            }
+
+            if (next <= offset)
+            {
+                break;
+            }
+
+            offset = next;
+        }
+    }
+    else if ((0 == memcmp(header, "FORM", 4))
+            && ((0 == memcmp( &header[8], "AIFF", 4)) || (0 == memcmp( &header[8], "AIFC", 4))))
+    {
+        scan_aiff_tags(fp, 12u, end);
+    }
+    else if (0 == memcmp(header, "fLaC", 4))
+    {
+        /* metadata blocks until the one flagged last */
+        for (count = 0u, offset = 4u; (count < MEDIA_LIBRARY_PRV_MAX_CHUNKS) && ((offset + 4u) <= end); count++)
+        {
+            if (false == scan_read(fp, offset, chunk, 4u))
+            {
+                break;
+            }
+
+            size = ((uint32_t) chunk[1] << 16) | ((uint32_t) chunk[2] << 8) | (uint32_t) chunk[3];
+
+            if (4u == (chunk[0] & 0x7fu))
+            {
+                scan_flac_comments(fp, offset + 4u, ((offset + 4u + size) > end) ? end : (offset + 4u + size));
+                break;
+            }
+
+            if (0u != (chunk[0] & 0x80u))
+            {
+                break;
+            }
+
+            offset += 4u + size;
+        }
+    }
+    else
+    {
+        /* no tags that are understood */
+    }
+}
+/***********************************************************************************************************************
+ End of function scan_read_tags
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: scan_riff_info
+ * Description  : Reads INAM, IART and IPRD from the sub chunks of a RIFF INFO list
+ * Arguments    : FIL *fp - file
+ *                uint32_t offset - first sub chunk
+ *                uint32_t end - end of the list
+ * Return Value : none
+ **********************************************************************************************************************/
+static void scan_riff_info (FIL *fp, uint32_t offset, uint32_t end)
+{
+    uint8_t chunk[8];
+    uint32_t size;
+    uint32_t length;
+    uint32_t count;
+    char_t *p_tag;
+
+    for (count = 0u; (count < MEDIA_LIBRARY_PRV_MAX_CHUNKS) && ((offset + 8u) <= end); count++)
+    {
+        if (false == scan_read(fp, offset, chunk, 8u))
+        {
+            break;
+        }
+
+        size = (uint32_t) chunk[4] | ((uint32_t) chunk[5] << 8) | ((uint32_t) chunk[6] << 16)
+                | ((uint32_t) chunk[7] << 24);
+
+        if (size > (end - offset - 8u))
+        {
+            break;
+        }
+
+        p_tag = NULL;
+
+        if (0 == memcmp(chunk, "INAM", 4))
+        {
+            p_tag = gs_scan.title;
+        }
+        else if (0 == memcmp(chunk, "IART", 4))
+        {
+            p_tag = gs_scan.artist;
+        }
+        else if (0 == memcmp(chunk, "IPRD", 4))
+        {
+            p_tag = gs_scan.album;
+        }
+        else
+        {
+            /* not kept */
+        }
+
+        if (NULL != p_tag)
+        {
+            length = (size < (MEDIA_LIBRARY_MAX_TAG - 1u)) ? size : (MEDIA_LIBRARY_MAX_TAG - 1u);
+
+            if (false != scan_read(fp, offset + 8u, gs_scan.field, length))
+            {
+                scan_set_tag(p_tag, gs_scan.field, length);
+            }
+        }
+
+        offset += 8u + size + (size & 1u);
+    }
+}
+/***********************************************************************************************************************
+ End of function scan_riff_info
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: scan_aiff_tags
+ * Description  : Reads the NAME and AUTH chunks of an AIFF file, AIFF has nothing for the album
+ * Arguments    : FIL *fp - file
+ *                uint32_t offset - first chunk
+ *                uint32_t end - end of the file
+ * Return Value : none
+ **********************************************************************************************************************/
+static void scan_aiff_tags (FIL *fp, uint32_t offset, uint32_t end)
+{
+    uint8_t chunk[8];
+    uint32_t size;
+    uint32_t length;
+    uint32_t next;
+    uint32_t count;
+    char_t *p_tag;
+
+    for (count = 0u; (count < MEDIA_LIBRARY_PRV_MAX_CHUNKS) && ((offset + 8u) <= end); count++)
+    {
+        if (false == scan_read(fp, offset, chunk, 8u))
+        {
+            break;
+        }
+
+        size = ((uint32_t) chunk[4] << 24) | ((uint32_t) chunk[5] << 16) | ((uint32_t) chunk[6] << 8)
+                | (uint32_t) chunk[7];
+        next = offset + 8u + size + (size & 1u);
+
+        p_tag = NULL;
+
+        if (0 == memcmp(chunk, "NAME", 4))
+        {
+            p_tag = gs_scan.title;
+        }
+        else if (0 == memcmp(chunk, "AUTH", 4))
+        {
+            p_tag = gs_scan.artist;
+        }
+        else
+        {
+            /* not kept */
+        }
+
+        if ((NULL != p_tag) && (size <= (end - offset - 8u)))
+        {
+            length = (size < (MEDIA_LIBRARY_MAX_TAG - 1u)) ? size : (MEDIA_LIBRARY_MAX_TAG - 1u);
+
+            if (false != scan_read(fp, offset + 8u, gs_scan.field, length))
+            {
+                scan_set_tag(p_tag, gs_scan.field, length);
+            }
+        }
+
+        if (next <= offset)
+        {
+            break;
+        }
+
+        offset = next;
+    }
+}
+/***********************************************************************************************************************
+ End of function scan_aiff_tags
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: scan_flac_comments
+ * Description  : Reads TITLE, ARTIST and ALBUM from a FLAC Vorbis comment block
+ * Arguments    : FIL *fp - file
+ *                uint32_t offset - start of the block data
+ *                uint32_t end - end of the block
+ * Return Value : none
+ **********************************************************************************************************************/
+static void scan_flac_comments (FIL *fp, uint32_t offset, uint32_t end)
+{
+    static const struct
+    {
+        const char_t *p_field;
+        uint32_t     length;
+    } s_fields[] =
+    {
+        {"TITLE=", 6u},
+        {"ARTIST=", 7u},
+        {"ALBUM=", 6u},
+    };
+    char_t * const p_tags[] =
+    {
+        gs_scan.title,
+        gs_scan.artist,
+        gs_scan.album,
+    };
+    uint8_t word[4];
+    uint32_t comments;
+    uint32_t length;
+    uint32_t read;
+    uint32_t field;
+    uint32_t i;
+
+    /* the block is little endian, unlike the rest of FLAC: vendor string, comment count, comments */
+    if (false == scan_read(fp, offset, word, 4u))
+    {
+        return;
+    }
+
+    length = (uint32_t) word[0] | ((uint32_t) word[1] << 8) | ((uint32_t) word[2] << 16) | ((uint32_t) word[3] << 24);
+
+    if (length > (end - offset - 4u))
+    {
+        return;
+    }
+
+    offset += 4u + length;
+
+    if (((offset + 4u) > end) || (false == scan_read(fp, offset, word, 4u)))
+    {
+        return;
+    }
+
+    comments = (uint32_t) word[0] | ((uint32_t) word[1] << 8) | ((uint32_t) word[2] << 16)
+            | ((uint32_t) word[3] << 24);
+    offset += 4u;
+
+    for (i = 0u; (i < comments) && (i < MEDIA_LIBRARY_PRV_MAX_CHUNKS) && ((offset + 4u) <= end); i++)
+    {
+        if (false == scan_read(fp, offset, word, 4u))
+        {
+            break;
+        }
+
+        length = (uint32_t) word[0] | ((uint32_t) word[1] << 8) | ((uint32_t) word[2] << 16)
+                | ((uint32_t) word[3] << 24);
+
+        if (length > (end - offset - 4u))
+        {
+            break;
+        }
+
+        read = (length < sizeof(gs_scan.field)) ? length : sizeof(gs_scan.field);
+
+        if (false == scan_read(fp, offset + 4u, gs_scan.field, read))
+        {
+            break;
+        }
+
+        for (field = 0u; field < (sizeof(s_fields) / sizeof(s_fields[0])); field++)
+        {
+            if ((read > s_fields[field].length)
+                    && (0 == strnicmp((const char *) gs_scan.field, s_fields[field].p_field,
+                            s_fields[field].length)))
+            {
+                scan_set_tag(p_tags[field], &gs_scan.field[s_fields[field].length], read - s_fields[field].length);
+                break;
+            }
+        }
+
+        offset += 4u + length;
+    }
+}
+/***********************************************************************************************************************
+ End of function scan_flac_comments
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: scan_set_tag
+ * Description  : Keeps the first value found for a tag, without trailing padding
+ * Arguments    : char_t *p_tag - MEDIA_LIBRARY_MAX_TAG bytes
+ *                const uint8_t *p_text - value, not terminated
+ *                uint32_t length - bytes in the value
+ * Return Value : none
+ **********************************************************************************************************************/
+static void scan_set_tag (char_t *p_tag, const uint8_t *p_text, uint32_t length)
+{
+    uint32_t i;
+
+    if ('\0' != p_tag[0])
+    {
+        return;
+    }
+
+    for (i = 0u; (i < length) && (i < (MEDIA_LIBRARY_MAX_TAG - 1u)) && ('\0' != p_text[i]); i++)
+    {
+        p_tag[i] = (char_t) p_text[i];
+    }
+
+    while ((i > 0u) && (' ' == p_tag[i - 1u]))
+    {
+        i--;
+    }
+
+    p_tag[i] = '\0';
+}
+/***********************************************************************************************************************
+ End of function scan_set_tag
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: scan_source_read
+ * Description  : Decoder source read directly from FatFs
+ * Arguments    : void *p_context - the file
+ *                void *p_buf - destination
+ *                size_t len - bytes wanted
+ * Return Value : bytes read
+ **********************************************************************************************************************/
+static size_t scan_source_read (void *p_context, void *p_buf, size_t len)
+{
+    int bytes = R_FAT_ReadFile((FIL *) p_context, p_buf, (unsigned int) len);
+
+    return ((bytes > 0) ? (size_t) bytes : 0u);
+}
+/***********************************************************************************************************************
+ End of function scan_source_read
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: scan_source_seek
+ * Description  : Decoder source seek directly on FatFs
+ * Arguments    : void *p_context - the file
+ *                uint32_t offset - byte offset
+ * Return Value : true for success
+ **********************************************************************************************************************/
+static bool_t scan_source_seek (void *p_context, uint32_t offset)
+{
+    return (FR_OK == f_lseek((FIL *) p_context, offset));
+}
+/***********************************************************************************************************************
+ End of function scan_source_seek
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_create
+ * Description  : Allocates an empty index
+ * Arguments    : uint32_t dirs - directory capacity
+ *                uint32_t tracks - track capacity
+ *                uint32_t pool_bytes - string pool capacity
+ * Return Value : the index, NULL if memory ran out
+ **********************************************************************************************************************/
+static st_library_t *library_create (uint32_t dirs, uint32_t tracks, uint32_t pool_bytes)
+{
+    st_library_t *p_lib = R_OS_AllocMem(sizeof(st_library_t), R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL == p_lib)
+    {
+        return (NULL);
+    }
+
+    memset(p_lib, 0, sizeof(st_library_t));
+
+    p_lib->dir_capacity = (0u != dirs) ? dirs : 1u;
+    p_lib->track_capacity = (0u != tracks) ? tracks : 1u;
+    p_lib->pool_capacity = (0u != pool_bytes) ? pool_bytes : 1u;
+
+    p_lib->p_dirs = R_OS_AllocMem(p_lib->dir_capacity * sizeof(st_library_dir_t), R_REGION_LARGE_CAPACITY_RAM);
+    p_lib->p_tracks = R_OS_AllocMem(p_lib->track_capacity * sizeof(st_library_track_t), R_REGION_LARGE_CAPACITY_RAM);
+    p_lib->p_pool = R_OS_AllocMem(p_lib->pool_capacity, R_REGION_LARGE_CAPACITY_RAM);
+
+    if ((NULL == p_lib->p_dirs) || (NULL == p_lib->p_tracks) || (NULL == p_lib->p_pool))
+    {
+        library_free(p_lib);
+        return (NULL);
+    }
+
+    p_lib->header.magic = MEDIA_LIBRARY_PRV_MAGIC;
+    p_lib->header.version = MEDIA_LIBRARY_PRV_VERSION;
+
+    /* offset 0 is the empty string */
+    p_lib->p_pool[0] = '\0';
+    p_lib->header.pool_bytes = 1u;
+
+    return (p_lib);
+}
+/***********************************************************************************************************************
+ End of function library_create
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_free
+ * Description  : Frees an index
+ * Arguments    : st_library_t *p_lib - index, may be NULL
+ * Return Value : none
+ **********************************************************************************************************************/
+static void library_free (st_library_t *p_lib)
+{
+    if (NULL != p_lib)
+    {
+        if (NULL != p_lib->p_dirs)
+        {
+            R_OS_FreeMem(p_lib->p_dirs);
+        }
+
+        if (NULL != p_lib->p_tracks)
+        {
+            R_OS_FreeMem(p_lib->p_tracks);
+        }
+
+        if (NULL != p_lib->p_pool)
+        {
+            R_OS_FreeMem(p_lib->p_pool);
+        }
+
+        R_OS_FreeMem(p_lib);
+    }
+}
+/***********************************************************************************************************************
+ End of function library_free
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_add_string
+ * Description  : Appends a string to the pool, growing it as needed
+ * Arguments    : st_library_t *p_lib - index
+ *                const char_t *p_text - string
+ *                uint32_t *p_offset - destination for the offset of the string
+ * Return Value : false if the pool is full or memory ran out
+ **********************************************************************************************************************/
+static bool_t library_add_string (st_library_t *p_lib, const char_t *p_text, uint32_t *p_offset)
+{
+    uint32_t length = (uint32_t) strlen(p_text) + 1u;
+    uint32_t capacity;
+    char_t *p_pool;
+
+    if (1u == length)
+    {
+        *p_offset = 0u;
+        return (true);
+    }
+
+    if ((p_lib->header.pool_bytes + length) > MEDIA_LIBRARY_PRV_MAX_POOL)
+    {
+        return (false);
+    }
+
+    if ((p_lib->header.pool_bytes + length) > p_lib->pool_capacity)
+    {
+        capacity = p_lib->pool_capacity * 2u;
+
+        while (capacity < (p_lib->header.pool_bytes + length))
+        {
+            capacity *= 2u;
+        }
+
+        p_pool = R_OS_AllocMem(capacity, R_REGION_LARGE_CAPACITY_RAM);
+
+        if (NULL == p_pool)
+        {
+            return (false);
+        }
+
+        memcpy(p_pool, p_lib->p_pool, p_lib->header.pool_bytes);
+        R_OS_FreeMem(p_lib->p_pool);
+        p_lib->p_pool = p_pool;
+        p_lib->pool_capacity = capacity;
+    }
+
+    memcpy( &p_lib->p_pool[p_lib->header.pool_bytes], p_text, length);
+    *p_offset = p_lib->header.pool_bytes;
+    p_lib->header.pool_bytes += length;
+
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function library_add_string
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_add_tag
+ * Description  : Adds a tag to the pool unless it is the same as the previous track's
+ * Arguments    : st_library_t *p_lib - index
+ *                const char_t *p_text - tag
+ *                uint32_t previous - offset of the previous track's tag
+ *                uint32_t *p_offset - destination for the offset of the tag
+ * Return Value : false if the pool is full or memory ran out
+ **********************************************************************************************************************/
+static bool_t library_add_tag (st_library_t *p_lib, const char_t *p_text, uint32_t previous, uint32_t *p_offset)
+{
+    if (0 == strcmp( &p_lib->p_pool[previous], p_text))
+    {
+        *p_offset = previous;
+        return (true);
+    }
+
+    return (library_add_string(p_lib, p_text, p_offset));
+}
+/***********************************************************************************************************************
+ End of function library_add_tag
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_find_dir
+ * Description  : Looks for a directory by path, trying the same position first as the tree is walked in the same
+ *                order each time
+ * Arguments    : const st_library_t *p_lib - index
+ *                const char_t *p_path - path
+ *                uint32_t hash - hash of the path
+ *                uint32_t hint - where to look first
+ * Return Value : the directory or NULL
+ **********************************************************************************************************************/
+static const st_library_dir_t *library_find_dir (const st_library_t *p_lib, const char_t *p_path, uint32_t hash,
+        uint32_t hint)
+{
+    const st_library_dir_t *p_dir;
+    uint32_t count;
+
+    for (count = 0u; count < p_lib->header.dir_count; count++, hint++)
+    {
+        if (hint >= p_lib->header.dir_count)
+        {
+            hint = 0u;
+        }
+
+        p_dir = &p_lib->p_dirs[hint];
+
+        if ((p_dir->hash == hash) && (0 == strcmp( &p_lib->p_pool[p_dir->path], p_path)))
+        {
+            return (p_dir);
+        }
+    }
+
+    return (NULL);
+}
+/***********************************************************************************************************************
+ End of function library_find_dir
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_load
+ * Description  : Reads the index saved on a drive, rejecting it if anything in it does not add up
+ * Arguments    : uint32_t slot - drive
+ * Return Value : the index or NULL
+ **********************************************************************************************************************/
+static st_library_t *library_load (uint32_t slot)
+{
+    st_library_header_t header;
+    st_library_t *p_lib = NULL;
+    const st_library_dir_t *p_dir;
+    const st_library_track_t *p_track;
+    uint32_t dir_bytes;
+    uint32_t track_bytes;
+    uint32_t i;
+    bool_t valid;
+    FIL *fp;
+
+    snprintf(gs_scan.path, sizeof(gs_scan.path), "%c:/" MEDIA_LIBRARY_FILE_NAME, (char) ('0' + slot));
+
+    fp = R_FAT_OpenFile(gs_scan.path, FA_READ);
+
+    if (NULL == fp)
+    {
+        return (NULL);
+    }
+
+    valid = ((int) sizeof(header) == R_FAT_ReadFile(fp, &header, sizeof(header)))
+            && (MEDIA_LIBRARY_PRV_MAGIC == header.magic) && (MEDIA_LIBRARY_PRV_VERSION == header.version)
+            && (header.dir_count >= 1u) && (header.dir_count <= MEDIA_LIBRARY_PRV_MAX_DIRS)
+            && (header.track_count <= MEDIA_LIBRARY_PRV_MAX_TRACKS) && (header.pool_bytes >= 1u)
+            && (header.pool_bytes <= MEDIA_LIBRARY_PRV_MAX_POOL);
+
+    if (false != valid)
+    {
+        dir_bytes = header.dir_count * sizeof(st_library_dir_t);
+        track_bytes = header.track_count * sizeof(st_library_track_t);
+
+        valid = ((uint32_t) f_size(fp) == (sizeof(header) + dir_bytes + track_bytes + header.pool_bytes));
+    }
+
+    if (false != valid)
+    {
+        p_lib = library_create(header.dir_count, header.track_count, header.pool_bytes);
+
+        valid = (NULL != p_lib) && ((int) dir_bytes == R_FAT_ReadFile(fp, p_lib->p_dirs, dir_bytes))
+                && ((int) track_bytes == R_FAT_ReadFile(fp, p_lib->p_tracks, track_bytes))
+                && ((int) header.pool_bytes == R_FAT_ReadFile(fp, p_lib->p_pool, header.pool_bytes));
+    }
+
+    R_FAT_CloseFile(fp);
+
+    if (false != valid)
+    {
+        p_lib->header = header;
+
+        valid = (header.checksum == library_checksum(p_lib)) && ('\0' == p_lib->p_pool[0])
+                && ('\0' == p_lib->p_pool[header.pool_bytes - 1u]);
+    }
+
+    /* every offset must land inside what was read */
+    for (i = 0u; (false != valid) && (i < header.dir_count); i++)
+    {
+        p_dir = &p_lib->p_dirs[i];
+        valid = (p_dir->path < header.pool_bytes) && (p_dir->first_track <= header.track_count)
+                && (p_dir->track_count <= (header.track_count - p_dir->first_track));
+    }
+
+    for (i = 0u; (false != valid) && (i < header.track_count); i++)
+    {
+        p_track = &p_lib->p_tracks[i];
+        valid = (p_track->dir < header.dir_count) && (p_track->name < header.pool_bytes)
+                && (p_track->title < header.pool_bytes) && (p_track->artist < header.pool_bytes)
+                && (p_track->album < header.pool_bytes);
+    }
+
+    if (false == valid)
+    {
+        library_free(p_lib);
+        return (NULL);
+    }
+
+    return (p_lib);
+}
+/***********************************************************************************************************************
+ End of function library_load
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_save
+ * Description  : Writes the index to a temporary file and renames it over the index on the drive, so a drive
+ *                pulled part way through keeps the index it had
+ * Arguments    : uint32_t slot - drive
+ *                const st_library_t *p_lib - index
+ * Return Value : true if the index was written
+ **********************************************************************************************************************/
+static bool_t library_save (uint32_t slot, const st_library_t *p_lib)
+{
+    st_library_header_t header = p_lib->header;
+    uint32_t dir_bytes = header.dir_count * sizeof(st_library_dir_t);
+    uint32_t track_bytes = header.track_count * sizeof(st_library_track_t);
+    char_t index_path[sizeof(MEDIA_LIBRARY_FILE_NAME) + 3u];
+    bool_t result;
+    FIL *fp;
+
+    header.checksum = library_checksum(p_lib);
+
+    snprintf(gs_scan.path, sizeof(gs_scan.path), "%c:/" MEDIA_LIBRARY_PRV_TEMP_NAME, (char) ('0' + slot));
+
+    fp = R_FAT_OpenFile(gs_scan.path, FA_WRITE | FA_CREATE_ALWAYS);
+
+    if (NULL == fp)
+    {
+        /* write protected */
+        return (false);
+    }
+
+    result = ((int) sizeof(header) == R_FAT_WriteFile(fp, (unsigned char *) &header, sizeof(header)))
+            && ((int) dir_bytes == R_FAT_WriteFile(fp, (unsigned char *) p_lib->p_dirs, dir_bytes))
+            && ((int) track_bytes == R_FAT_WriteFile(fp, (unsigned char *) p_lib->p_tracks, track_bytes))
+            && ((int) header.pool_bytes == R_FAT_WriteFile(fp, (unsigned char *) p_lib->p_pool, header.pool_bytes));
+
+    result = (FR_OK == R_FAT_CloseFile(fp)) && (false != result);
+
+    snprintf(index_path, sizeof(index_path), "%c:/" MEDIA_LIBRARY_FILE_NAME, (char) ('0' + slot));
+
+    if (false != result)
+    {
+        /* there is no index the first time */
+        R_FAT_RemoveFile(index_path);
+        result = (FR_OK == R_FAT_ReName(gs_scan.path, index_path));
+    }
+    else
+    {
+        R_FAT_RemoveFile(gs_scan.path);
+    }
+
+    return (result);
+}
+/***********************************************************************************************************************
+ End of function library_save
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_publish
+ * Description  : Makes an index the one queries see and frees the one it replaces
+ * Arguments    : uint32_t slot - drive
+ *                st_library_t *p_lib - index, NULL when the drive has gone
+ * Return Value : none
+ **********************************************************************************************************************/
+static void library_publish (uint32_t slot, st_library_t *p_lib)
+{
+    st_library_t *p_old;
+    st_media_library_status_t *p_status = &gs_drives[slot].status;
+
+    R_OS_AcquireMutex(gsp_mutex);
+
+    p_old = gs_drives[slot].p_library;
+    gs_drives[slot].p_library = p_lib;
+
+    p_status->ready = (NULL != p_lib);
+    p_status->generation++;
+
+    if (NULL != p_lib)
+    {
+        p_status->dirs = p_lib->header.dir_count;
+        p_status->tracks = p_lib->header.track_count;
+        p_status->bytes = sizeof(st_library_t) + (p_lib->dir_capacity * sizeof(st_library_dir_t))
+                + (p_lib->track_capacity * sizeof(st_library_track_t)) + p_lib->pool_capacity;
+    }
+    else
+    {
+        p_status->dirs = 0u;
+        p_status->tracks = 0u;
+        p_status->bytes = 0u;
+    }
+
+    R_OS_ReleaseMutex(gsp_mutex);
+
+    if (p_old != p_lib)
+    {
+        library_free(p_old);
+    }
+}
+/***********************************************************************************************************************
+ End of function library_publish
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_hash
+ * Description  : Adds bytes to an FNV-1a hash
+ * Arguments    : uint32_t hash - hash so far, MEDIA_LIBRARY_PRV_HASH_BASIS to start
+ *                const void *p_data - bytes
+ *                uint32_t length - number of bytes
+ * Return Value : the hash
+ **********************************************************************************************************************/
+static uint32_t library_hash (uint32_t hash, const void *p_data, uint32_t length)
+{
+    const uint8_t *p_byte = (const uint8_t *) p_data;
+
+    while (length--)
+    {
+        hash = (hash ^ *p_byte++) * MEDIA_LIBRARY_PRV_HASH_PRIME;
+    }
+
+    return (hash);
+}
+/***********************************************************************************************************************
+ End of function library_hash
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_checksum
+ * Description  : Hash of the records and strings of an index as they are written to the drive
+ * Arguments    : const st_library_t *p_lib - index
+ * Return Value : the checksum
+ **********************************************************************************************************************/
+static uint32_t library_checksum (const st_library_t *p_lib)
+{
+    uint32_t hash = MEDIA_LIBRARY_PRV_HASH_BASIS;
+
+    hash = library_hash(hash, p_lib->p_dirs, p_lib->header.dir_count * sizeof(st_library_dir_t));
+    hash = library_hash(hash, p_lib->p_tracks, p_lib->header.track_count * sizeof(st_library_track_t));
+
+    return (library_hash(hash, p_lib->p_pool, p_lib->header.pool_bytes));
+}
+/***********************************************************************************************************************
+ End of function library_checksum
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_copy_string
+ * Description  : Copies a string, truncating it to fit
+ * Arguments    : char_t *p_dest - destination
+ *                const char_t *p_src - source
+ *                uint32_t size - size of the destination
+ * Return Value : none
+ **********************************************************************************************************************/
+static void library_copy_string (char_t *p_dest, const char_t *p_src, uint32_t size)
+{
+    strncpy(p_dest, p_src, size - 1u);
+    p_dest[size - 1u] = '\0';
+}
+/***********************************************************************************************************************
+ End of function library_copy_string
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_contains
+ * Description  : Case insensitive search for text in a string
+ * Arguments    : const char_t *p_text - string to search
+ *                const char_t *p_find - text to look for
+ * Return Value : true if found
+ **********************************************************************************************************************/
+static bool_t library_contains (const char_t *p_text, const char_t *p_find)
+{
+    size_t length = strlen(p_find);
+
+    while ('\0' != *p_text)
+    {
+        if (0 == strnicmp(p_text, p_find, length))
+        {
+            return (true);
+        }
+
+        p_text++;
+    }
+
+    return (false);
+}
+/***********************************************************************************************************************
+ End of function library_contains
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_is_audio_file
+ * Description  : Checks the extension against the formats there are decoders for, so other files are not opened
+ * Arguments    : const char_t *p_name - file name
+ * Return Value : true for .wav, .aif, .aiff, .aifc and .flac
+ **********************************************************************************************************************/
+static bool_t library_is_audio_file (const char_t *p_name)
+{
+    static const char_t * const s_extensions[] =
+    {
+        ".wav", ".aif", ".aiff", ".aifc", ".flac",
+    };
+    const char_t *p_extension = strrchr(p_name, '.');
+    uint32_t i;
+
+    if (NULL != p_extension)
+    {
+        for (i = 0u; i < (sizeof(s_extensions) / sizeof(s_extensions[0])); i++)
+        {
+            if (0 == stricmp(p_extension, s_extensions[i]))
+            {
+                return (true);
+            }
+        }
+    }
+
+    return (false);
+}
+/***********************************************************************************************************************
+ End of function library_is_audio_file
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: library_slot
+ * Description  : Maps a drive letter to its entry in gs_drives
+ * Arguments    : char_t drive - drive letter
+ * Return Value : the slot or -1 for a letter without a FatFs volume
+ **********************************************************************************************************************/
+static int32_t library_slot (char_t drive)
+{
+    int32_t slot = (int32_t) toupper((int) drive) - 'A';
+
+    return (((slot >= 0) && (slot < (int32_t) MEDIA_LIBRARY_PRV_DRIVES)) ? slot : -1);
+}
+/***********************************************************************************************************************
+ End of function library_slot
+ **********************************************************************************************************************/
+
+/******************************************************************************
+End  Of File
+******************************************************************************/
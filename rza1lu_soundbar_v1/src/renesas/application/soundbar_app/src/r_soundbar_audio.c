@@ -42,6 +42,7 @@
 /* Standard includes. */
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <fcntl.h>
 #include <renesas/application/soundbar_app/inc/r_soundbar.h>
 #include <unistd.h>
@@ -50,6 +51,10 @@
 #include "r_os_abstraction_api.h"
 #include "r_task_priority.h"
 #include "dev_drv.h"
+#include "iodefine_cfg.h"
+
+#include "FreeRTOS.h"
+#include "semphr.h"
 
 #include "console.h"
 #include "trace.h"
@@ -69,6 +74,17 @@
 #include "r_fatfs_abstraction.h"
 #include "ff.h"
 
+#include "r_audio_ring.h"
+#include "r_audio_convert.h"
+#include "r_audio_stream.h"
+#include "r_audio_decoder.h"
+#include "r_audio_resample.h"
+#include "r_audio_dsp.h"
+#include "r_audio_rtp.h"
+#include "r_audio_gain.h"
+
+#include "application_cfg.h"
+
 /******************************************************************************
  Macro definitions
  ******************************************************************************/
@@ -77,6 +93,13 @@
 #define WAVE_DMA_SIZE_PRV_                  (4096)  /* size of blocks for data operations with SSIF/DMA */
 #define WAVEDATA_STORAGE_ALIGN_BYTES_PRV_   (32)    /* buffer alignment required for dma access */
 
+/* File playback ring, periods of WAVE_DMA_SIZE_PRV_ bytes between the file reader and the SSIF */
+#define PLAY_RING_PERIODS_PRV_              (8)     /* periods in the ring */
+#define PLAY_RING_HIGH_WATERMARK_PRV_       (6)     /* filled periods needed before the SSIF is (re)started */
+#define PLAY_RING_LOW_WATERMARK_PRV_        (4)     /* filled periods at which the reader is woken */
+#define PLAY_SSIF_QUEUE_DEPTH_PRV_          (3)     /* periods queued to the SSIF driver at once, by default */
+#define PLAY_SSIF_QUEUE_MAX_PRV_            (SOUND_SSIF_QUEUE_DEPTH_MAX) /* AIOCBs, leaves the reader 2 periods */
+
 /* Record/play demo settings */
 #define NUM_AUDIO_BUFFER_BLOCKS_PRV_        (3)
 #define REC_DMA_SIZE_PRV_                   (512)
@@ -86,6 +109,16 @@
 /* SSIF Channel */
 #define STREAM_IT_SOUND_CHANNEL_PRV_        (0)
 
+/* The codec is only ever run at this rate, other sources go through the sample rate converter */
+#define SOUND_PRV_OUTPUT_RATE               (SOUND_FREQ_44100)
+
+/* Playlist settings */
+#define SOUND_PRV_PLAYLIST_MAX_TRACKS       (256)   /* entries r_soundtst_PlaylistAdd accepts */
+#define SOUND_PRV_PLAYLIST_MAX_PATH         (260)   /* longest path, including the drive and terminator */
+#define SOUND_PRV_TRACK_SLOTS               (2)     /* the track being decoded and the one opened ahead of it */
+#define SOUND_PRV_TRACK_STARTS              (4)     /* track starts still in the ring or queued to the SSIF */
+#define SOUND_PRV_POSITION_STEP_MS          (250)   /* playhead movement that sets the position event */
+
 /* Comment this line out to turn ON module trace in this file */
 /* #undef _TRACE_ON_ */
 
@@ -97,6 +130,10 @@
 /* SSIF Channel */
 #define SOUUND_BAR_INTERFACE_CH        (0)
 
+/* Free running OSTM1 counter (run time stats timer) used to time stamp DMA completions */
+#define SOUND_PRV_TIME_STAMP()              (OSTM1.OSTMnCNT)
+#define SOUND_PRV_TIME_STAMP_COUNTS_PER_US  (configPERIPHERAL_CLOCK0_HZ / 1000000UL)
+
 /*******************************************************************************
  Typedef definitions
  ******************************************************************************/
@@ -115,6 +152,19 @@ typedef struct st_sound_config_t
 
     uint32_t playback_semaphore; /* semaphore to control playback */
     uint32_t record_semaphore; /* semaphore to control record   */
+    uint32_t period_semaphore; /* counting semaphore given by every SSIF DMA completion */
+    uint32_t reader_semaphore; /* wakes the file reader when the play ring drains */
+    uint32_t loader_semaphore; /* wakes the track loader when a slot is freed or the playlist grows */
+
+    event_t  position_changed; /* set when the playhead moves SOUND_PRV_POSITION_STEP_MS or changes track */
+    void     *p_playlist_mutex; /* guards the playlist paths */
+
+    p_audio_ring_t p_play_ring; /* periods read from file waiting for the SSIF */
+    uint32_t *p_resample_in; /* one period of decoded frames waiting for the sample rate converter */
+    volatile bool_t reader_eof; /* file reader reached the end of the playlist, or was told to stop */
+    volatile bool_t reader_active; /* file reader is touching the ring or the file */
+    volatile bool_t loader_hold; /* play task is opening or closing the track slots itself */
+    volatile bool_t loader_active; /* track loader is touching the track slots */
 
     uint32_t ul_delaytime_ms;
 
@@ -122,6 +172,36 @@ typedef struct st_sound_config_t
 
 typedef st_sound_config_t *p_sound_config_t;
 
+/* Track slot states, a slot only moves forward and each step is taken by one task */
+typedef enum
+{
+    SOUND_TRACK_EMPTY = 0,  /* closed, the loader may open the next playlist entry into it */
+    SOUND_TRACK_READY,      /* opened ahead by the loader, header parsed and the prefetch running */
+    SOUND_TRACK_PLAYING,    /* being decoded by the reader */
+    SOUND_TRACK_DONE        /* the reader has moved on, the loader closes it */
+} e_sound_track_state_t;
+
+typedef struct
+{
+    volatile e_sound_track_state_t state;
+    FIL                 *fp;
+    bool_t              external;   /* fp came from r_soundtst_LoadSample and is closed by the caller */
+    p_audio_stream_t    p_stream;   /* prefetch, one per slot so the next track reads ahead of its start */
+    st_audio_decoder_t  decoder;
+    uint32_t            index;      /* playlist entry */
+} st_sound_track_t;
+
+/* First output frame of a track, the DMA end count is compared against it to tell which track is audible */
+typedef struct
+{
+    uint32_t start_frame;   /* gs_frames_played value once the first frame of the track has been played */
+    uint32_t index;         /* playlist entry */
+    uint32_t start_ms;      /* position of that frame in the track, not 0 after a seek */
+    uint32_t duration_ms;   /* 0 if the decoder does not know */
+    uint32_t sample_rate;   /* rate of the file */
+    uint32_t bits_per_sample;
+} st_sound_track_start_t;
+
 /*******************************************************************************
  Exported global variables (to be accessed by other files)
  ******************************************************************************/
@@ -138,6 +218,16 @@ static st_sound_config_t gs_sound_t;
 static p_sound_config_t gsp_sound_control_t;
 
 static void task_play_sound_demo (void *parameters);
+static void task_read_sound_file (void *parameters);
+static void task_load_track (void *parameters);
+static void play_ring_high_callback (p_audio_ring_t p_ring, void *p_context);
+static void play_ring_low_callback (p_audio_ring_t p_ring, void *p_context);
+#if (R_SELF_INSERT_APP_USB_AUDIO)
+static uint8_t *usb_get_buffer (void *p_context, uint32_t *p_space);
+static void usb_commit (void *p_context, uint8_t *p_data, uint32_t length);
+static uint32_t usb_get_level (void *p_context);
+static void usb_volume (void *p_context, BOOL mute, int16_t volume);
+#endif
 static void task_playback_sound_demo (void *parameters);
 
 static void initalize_control_if ( void );
@@ -146,32 +236,114 @@ static void close_audio (void);
 
 static void setup_playsample (FILE *p_in, FILE *p_out, void *p_data);
 static void setup_playback (FILE *p_in, FILE *p_out);
-static bool_t AnalyzeHeader(uint8_t * p_title, uint8_t * p_artist, uint8_t * p_album, uint16_t tag_size, FIL * fp);
-static size_t GetNextData(void *buf, size_t len);
 
 /* dma read/write to SSIF callback functions */
 static void userdef_tx_callback (union sigval signo);
 static void userdef_rx_callback (union sigval signo);
 
-/* flags used to control read/write operations with SSIF */
-static volatile bool_t gs_rx_set_flag = 0u;
-static volatile bool_t gs_tx_set_flag = 0u;
-static volatile bool_t gs_rx_first_return_flag = 0u;
-static volatile bool_t gs_tx_first_set_flag = 0u;
+static void update_period_stats (uint32_t pending);
+static uint32_t fill_period (uint32_t *p_period);
+static uint32_t fill_network_period (uint32_t *p_period);
+
+static bool_t open_track (st_sound_track_t *p_track, uint32_t index);
+static void close_track (st_sound_track_t *p_track);
+static bool_t start_playlist (uint32_t index, uint32_t position_ms);
+static bool_t next_track (void);
+static void add_track_start (uint32_t output_frame, uint32_t start_ms);
+static void read_position (st_sound_position_t *p_position);
+static void update_position (void);
+static void update_play_stats (uint32_t queued, bool_t underrun);
+
+/* DMA completion counters, only written by the SSIF callbacks (interrupt context) */
+static volatile uint32_t gs_rx_complete_count = 0u;
+static volatile uint32_t gs_tx_complete_count = 0u;
+
+/* OSTM1 count captured by the most recent DMA completion */
+static volatile uint32_t gs_period_time_stamp = 0u;
+
+/* wake-up latency of the record/playback task, see r_soundtst_GetPeriodStats */
+static st_sound_period_stats_t gs_period_stats;
 
 /* handle for SSIF driver */
 static int_t gs_ssif_handle = -1;
 
-#define FILE_READ_BUFF_SIZE    (4096)
-
 static FIL * m_wav_fp;
-static uint16_t m_fp_pos = 0;
-static uint32_t m_music_data_size;
-static uint32_t m_music_data_index;
-static uint16_t m_channel;
-static uint16_t m_block_size;
-static uint32_t m_sampling_rate;
-static uint8_t m_wk_wavfile_buff[FILE_READ_BUFF_SIZE];
+
+/* playlist, paths copied by r_soundtst_PlaylistAdd, guarded by p_playlist_mutex */
+static char_t *gs_playlist[SOUND_PRV_PLAYLIST_MAX_TRACKS];
+static volatile uint32_t gs_playlist_count = 0u;
+
+/* path being opened, only used by whichever of the play task or the loader owns the slots */
+static char_t gs_open_path[SOUND_PRV_PLAYLIST_MAX_PATH];
+
+/* the track being decoded and the next one, opened while the first still plays */
+static st_sound_track_t gs_tracks[SOUND_PRV_TRACK_SLOTS];
+static volatile uint32_t gs_track_slot = 0u;    /* slot the reader decodes */
+static volatile uint32_t gs_next_index = 0u;    /* playlist entry the loader opens next */
+
+/* the reader has a track to decode */
+static volatile bool_t gs_decoder_open = false;
+
+/* the reader ran out of the current track before the loader had the next one open */
+static bool_t gs_track_waiting = false;
+
+/* frames already decoded into the ring period being filled, kept while the reader waits for the next track */
+static uint32_t gs_period_frames = 0u;
+
+/* frames committed to the ring since the SSIF started, in the same count as gs_frames_played */
+static volatile uint32_t gs_frames_written = 0u;
+
+/* starts of the tracks still between the reader and the DAC, written by the reader, read by anyone */
+static volatile st_sound_track_start_t gs_track_starts[SOUND_PRV_TRACK_STARTS];
+static volatile uint32_t gs_track_start_count = 0u;
+static volatile uint32_t gs_transitions = 0u;
+
+/* jump or seek waiting for the play task, see r_soundtst_PlaylistPlay */
+static volatile bool_t gs_request_pending = false;
+static volatile uint32_t gs_request_index = 0u;
+static volatile uint32_t gs_request_ms = 0u;
+
+/* last position reported through the position_changed event */
+static st_sound_position_t gs_position_reported;
+
+/* periods kept queued to the SSIF, see r_soundtst_SetQueueDepth */
+static volatile uint32_t gs_queue_depth = PLAY_SSIF_QUEUE_DEPTH_PRV_;
+
+/* underruns and SSIF queue headroom by source format, see r_soundtst_GetPlayStats */
+static st_sound_play_stats_t gs_play_stats;
+static uint32_t gs_play_stats_frames = 0u;    /* gs_frames_played when the periods were last counted */
+
+/* sample rate converter, only created when the file is not at SOUND_PRV_OUTPUT_RATE */
+static p_audio_resampler_t gs_resampler = NULL;
+static e_audio_resample_quality_t gs_resample_quality = AUDIO_RESAMPLE_QUALITY_MEDIUM;
+static uint32_t gs_resample_in_pos;
+static uint32_t gs_resample_in_len;
+static bool_t gs_resample_flushed;
+
+/* equaliser, crossover and limiter applied to each period by the reader */
+static p_audio_dsp_t gs_dsp = NULL;
+
+/* network receiver, when set the play task takes its periods from it instead of the loaded file */
+static p_audio_rtp_t gs_rtp = NULL;
+static volatile bool_t gs_network_open = false;
+static volatile bool_t gs_network_playing = false;
+
+#if (R_SELF_INSERT_APP_USB_AUDIO)
+/* USB audio function, when open the USB interrupt writes host frames straight into the play ring */
+static int_t gs_usb_handle = -1;
+static volatile bool_t gs_usb_open = false;
+static volatile bool_t gs_usb_playing = false;
+
+/* period being filled by the USB interrupt and the bytes already in it */
+static uint8_t *gs_usb_period = NULL;
+static uint32_t gs_usb_fill = 0u;
+
+/* host volume and mute, applied as the frames land since the DSP is bypassed */
+static volatile int32_t gs_usb_gain_q23 = AUDIO_GAIN_Q23_ONE;
+#endif
+
+/* frames the SSIF has played, advanced by the DMA end callback, paces the USB feedback endpoint */
+static volatile uint32_t gs_frames_played = 0u;
 
 /******************************************************************************
  Exported global variables and functions (to be accessed by other files)
@@ -197,11 +369,24 @@ static void initalize_control_if ( void )
 
         gsp_sound_control_t->playback_semaphore = 0;
         gsp_sound_control_t->record_semaphore = 0;
+        gsp_sound_control_t->period_semaphore = 0;
+        gsp_sound_control_t->reader_semaphore = 0;
+        gsp_sound_control_t->loader_semaphore = 0;
+        gsp_sound_control_t->p_play_ring = NULL;
+        gsp_sound_control_t->p_resample_in = NULL;
+        gsp_sound_control_t->reader_eof = true;
+        gsp_sound_control_t->reader_active = false;
+        gsp_sound_control_t->loader_hold = true;
+        gsp_sound_control_t->loader_active = false;
 
         R_OS_CreateEvent( &gsp_sound_control_t->task_running);
         R_OS_CreateEvent( &gsp_sound_control_t->task_play);
         R_OS_CreateEvent( &gsp_sound_control_t->task_stop);
         R_OS_CreateEvent( &gsp_sound_control_t->task_trackdone);
+        R_OS_CreateEvent( &gsp_sound_control_t->position_changed);
+
+        /* created here rather than by the play task so the playlist can be filled before it runs */
+        gsp_sound_control_t->p_playlist_mutex = R_OS_CreateMutex();
 
     }
 }
@@ -211,17 +396,19 @@ static void initalize_control_if ( void )
 
 /***********************************************************************************************************************
  * Function Name: task_play_sound_demo
- * Description  :
- * Arguments    :
- * Return Value :
+ * Description  : Plays the playlist, or the loaded wave file. The file reader task fills the play ring, this task
+ *                keeps up to gs_queue_depth periods queued to the SSIF and the DMA end callback returns
+ *                each period to the ring, so a slow USB read only drains the ring rather than stalling the SSIF.
+ *                Track changes happen in the reader and never stop the SSIF; a jump or seek lets the queued periods
+ *                play out and starts again from the requested position.
+ * Arguments    : void *parameters - FILE * for status output
+ * Return Value : none
  **********************************************************************************************************************/
 static void task_play_sound_demo (void *parameters)
 {
-    /* May be required l8tr */
     int32_t res = DEVDRV_SUCCESS;
-    int i;
-	uint32_t track = 0;
-	float32_t wave_length = 0.0;
+    st_audio_ring_config_t ring_config;
+    p_audio_ring_t p_ring = NULL;
     R_OS_ResetEvent( &gsp_sound_control_t->task_play);
     R_OS_ResetEvent( &gsp_sound_control_t->task_stop);
 
@@ -234,63 +421,295 @@ static void task_play_sound_demo (void *parameters)
     /* initialise SSIF and Sound driver for audio streaming */
     res = configure_audio();
 
+    if (DEVDRV_SUCCESS == res)
+    {
+        ring_config.period_count = PLAY_RING_PERIODS_PRV_;
+        ring_config.period_size = WAVE_DMA_SIZE_PRV_;
+        ring_config.high_watermark = PLAY_RING_HIGH_WATERMARK_PRV_;
+        ring_config.low_watermark = PLAY_RING_LOW_WATERMARK_PRV_;
+        ring_config.high_callback = &play_ring_high_callback;
+        ring_config.low_callback = &play_ring_low_callback;
+        ring_config.p_context = gsp_sound_control_t;
+
+        p_ring = r_audio_ring_create( &ring_config);
+
+        /* file reads are issued by the prefetch tasks, never by the audio path */
+        gs_tracks[0].p_stream = r_audio_stream_create("wav prefetch");
+        gs_tracks[1].p_stream = r_audio_stream_create("next prefetch");
+
+        gsp_sound_control_t->p_resample_in = R_OS_AllocMem(WAVE_DMA_SIZE_PRV_, R_REGION_LARGE_CAPACITY_RAM);
+
+        /* kept across restarts of the task so the settings survive */
+        if (NULL == gs_dsp)
+        {
+            gs_dsp = r_audio_dsp_create(SOUND_PRV_OUTPUT_RATE);
+        }
+
+        if ((NULL == p_ring) || (NULL == gs_tracks[0].p_stream) || (NULL == gs_tracks[1].p_stream)
+                || (NULL == gsp_sound_control_t->p_resample_in) || (NULL == gs_dsp))
+        {
+            res = DEVDRV_ERROR;
+        }
+    }
+
+    /* Create semaphores: DMA end / data ready for this task, ring space for the reader and free slots for the loader */
+    if ((DEVDRV_SUCCESS == res)
+            && ((true != R_OS_CreateSemaphore( &gsp_sound_control_t->playback_semaphore, 0))
+                    || (true != R_OS_CreateSemaphore( &gsp_sound_control_t->reader_semaphore, 0))
+                    || (true != R_OS_CreateSemaphore( &gsp_sound_control_t->loader_semaphore, 0))))
+    {
+        res = DEVDRV_ERROR;
+    }
 
     if (DEVDRV_SUCCESS == res)
     {
         /* Array of message blocks for DMA control of buffer writes */
-        AIOCB aiocb[NUM_AUDIO_BUFFER_BLOCKS_PRV_];
+        AIOCB aiocb[PLAY_SSIF_QUEUE_MAX_PRV_];
         uint32_t loop = 0u;
+        uint32_t queued;
+        uint32_t length;
+        uint8_t *p_period;
+        bool_t started;
+        bool_t restart;
+#if (R_SELF_LOAD_MIDDLEWARE_ETHERNET_MODULES)
+        st_audio_format_t format;
+#endif
 
-        /* Create semaphore to control buffer access */
-        R_OS_CreateSemaphore( &gsp_sound_control_t->playback_semaphore, 0);
+        gsp_sound_control_t->p_play_ring = p_ring;
+
+        /* The reader owns the producer side of the ring */
+        R_OS_CreateTask("wav reader", task_read_sound_file, NULL, R_OS_ABSTRACTION_PRV_DEFAULT_STACK_SIZE,
+                TASK_READ_SOUND_FILE_PRI);
+
+        /* The loader opens the next playlist entry while the reader decodes the current one */
+        R_OS_CreateTask("track loader", task_load_track, NULL, R_OS_ABSTRACTION_PRV_DEFAULT_STACK_SIZE,
+                TASK_TRACK_LOADER_PRI);
+
+        for (loop = 0u; loop < PLAY_SSIF_QUEUE_MAX_PRV_; loop++)
+        {
+            /* register access semaphore */
+            aiocb[loop].aio_sigevent.sigev_value.sival_ptr = (void *) &gsp_sound_control_t->playback_semaphore;
+
+            /* register user callback function after dma transfer to SSIF */
+            aiocb[loop].aio_sigevent.sigev_notify_function = &userdef_aio_callback;
+        }
 
         while (1)
         {
             R_OS_WaitForEvent( &gsp_sound_control_t->task_play, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
             // Reset any pending stop requests
             R_OS_ResetEvent( &gsp_sound_control_t->task_stop);
-            /* Set the wave file length */
-            wave_length = (float32_t)(m_music_data_size / WAVE_DMA_SIZE_PRV_);
+
+#if (R_SELF_INSERT_APP_USB_AUDIO)
+            if (gs_usb_handle >= 0)
+            {
+                /* frames arrive at the output rate, the host follows the feedback endpoint */
+                gs_usb_open = true;
+            }
+            else
+#endif
+#if (R_SELF_LOAD_MIDDLEWARE_ETHERNET_MODULES)
+            if (NULL != gs_rtp)
+            {
+                /* a variable ratio even at equal rates, the sender's clock is followed by trimming it */
+                r_audio_rtp_get_format(gs_rtp, &format);
+                gs_resampler = r_audio_resample_create_variable(format.sample_rate, SOUND_PRV_OUTPUT_RATE,
+                        gs_resample_quality);
+                gs_network_open = (NULL != gs_resampler);
+            }
+            else
+#endif
+            /* the decoder reads the whole file through the prefetch stream */
+            {
+                /* the playhead counts on from the frames already played */
+                gs_frames_written = gs_frames_played;
+                gs_play_stats_frames = gs_frames_played;
+                gs_transitions = 0u;
+                gs_request_pending = false;
+                gs_decoder_open = start_playlist(gs_request_index, gs_request_ms);
+            }
+
+            /* start the reader on an empty ring */
+            r_audio_ring_reset(p_ring);
+            gs_period_frames = 0u;
+
+            if (false != gs_decoder_open)
+            {
+                /* the loader may now open the following entry */
+                gsp_sound_control_t->loader_hold = false;
+                R_OS_ReleaseSemaphore( &gsp_sound_control_t->loader_semaphore);
+            }
+
+            gsp_sound_control_t->reader_eof = false;
+
+#if (R_SELF_INSERT_APP_USB_AUDIO)
+            if (false != gs_usb_open)
+            {
+                st_usbf_audio_sink_t sink;
+
+                /* the USB interrupt produces into the ring, the reader stays parked */
+                gs_usb_period = NULL;
+                gs_usb_fill = 0u;
+                sink.p_get_buffer = &usb_get_buffer;
+                sink.p_commit = &usb_commit;
+                sink.p_get_level = &usb_get_level;
+                sink.p_volume = &usb_volume;
+                sink.p_frames_played = &gs_frames_played;
+                sink.target_level = PLAY_RING_LOW_WATERMARK_PRV_ * (WAVE_DMA_SIZE_PRV_ / AUDIO_CONVERT_DST_FRAME_BYTES);
+                sink.p_context = p_ring;
+                control(gs_usb_handle, CTL_USBF_SET_AUDIO_SINK, &sink);
+            }
+            else
+#endif
+            {
+                R_OS_ReleaseSemaphore( &gsp_sound_control_t->reader_semaphore);
+            }
 
             /*******************************************************************/
             /* Playback start                                                  */
             /*******************************************************************/
+            started = false;
+            restart = false;
+            loop = 0u;
 
-            /* Pass through the data, writing out to the SSIF */
-            for (loop = 0; (loop * WAVE_DMA_SIZE_PRV_) < ((uint32_t) m_music_data_size - WAVE_DMA_SIZE_PRV_); loop++)
+            while (1)
             {
-                if ( R_OS_EventState( &gsp_sound_control_t->task_stop ) == EV_SET ) {
-                    R_OS_ResetEvent( &gsp_sound_control_t->task_play);
-                    R_OS_ResetEvent( &gsp_sound_control_t->task_stop);
-                    break;
+                /* periods handed to the SSIF and not yet returned by the DMA end callback */
+                queued = r_audio_ring_filled(p_ring) - r_audio_ring_readable(p_ring);
+
+                if (R_OS_EventState( &gsp_sound_control_t->task_stop) == EV_SET)
+                {
+                    /* ring can only be reset once the DMA has finished with it */
+                    if (0u == queued)
+                    {
+                        R_OS_ResetEvent( &gsp_sound_control_t->task_play);
+                        R_OS_ResetEvent( &gsp_sound_control_t->task_stop);
+                        gs_request_pending = false;
+                        break;
+                    }
+                }
+                else if (false != gs_request_pending)
+                {
+                    /* jump or seek, let the queued periods play out then start again from the new position */
+                    if (0u == queued)
+                    {
+                        restart = true;
+                        break;
+                    }
                 }
-                /* Get the current element in the aiocb message array */
-                int_t div = (int_t) (loop % NUM_AUDIO_BUFFER_BLOCKS_PRV_);
+                else
+                {
+                    /* left queued since the last top up, 0 means the SSIF drained before this task woke */
+                    if ((false != started) && (false != gs_decoder_open)
+                            && (false == gsp_sound_control_t->reader_eof))
+                    {
+                        update_play_stats(queued, (0u == queued));
+                    }
+
+                    /* wait for the high watermark before (re)starting so a single late read does not underrun */
+                    if ((false == started)
+                            && ((r_audio_ring_filled(p_ring) >= PLAY_RING_HIGH_WATERMARK_PRV_)
+                                    || (false != gsp_sound_control_t->reader_eof)))
+                    {
+                        started = true;
+                    }
+
+                    while ((false != started) && (queued < gs_queue_depth))
+                    {
+                        p_period = r_audio_ring_get_read_period(p_ring, &length);
+
+                        if (NULL == p_period)
+                        {
+                            break;
+                        }
+
+                        /* Get the current element in the aiocb message array, the DMA completes in order so the
+                           next AIOCB is free while no more than PLAY_SSIF_QUEUE_MAX_PRV_ are queued */
+                        int_t div = (int_t) (loop % PLAY_SSIF_QUEUE_MAX_PRV_);
 
-                /* register access semaphore */
-                aiocb[div].aio_sigevent.sigev_value.sival_ptr = (void *) &gsp_sound_control_t->playback_semaphore;
+                        /* Queueing request */
+                        control(gs_ssif_handle, R_SSIF_AIO_WRITE_CONTROL, &aiocb[div]);
+                        write(gs_ssif_handle, p_period, length);
 
-                /* register user callback function after dma transfer to SSIF */
-                aiocb[div].aio_sigevent.sigev_notify_function = &userdef_aio_callback;
+                        r_audio_ring_commit_read(p_ring);
+                        queued++;
+                        loop++;
+                    }
+
+                    if (0u == queued)
+                    {
+                        if (false != gsp_sound_control_t->reader_eof)
+                        {
+                            /* every period read from the file has been played */
+                            break;
+                        }
+
+                        if (false != started)
+                        {
+                            /* the SSIF ran dry before the reader caught up, prefill again */
+                            r_audio_ring_note_underrun(p_ring);
+                            started = false;
+                        }
+                    }
+                }
 
-                /* Queueing request #(NUM_AUDIO_BUFFER_BLOCKS_PRV_ -1) to #N */
-                control(gs_ssif_handle, R_SSIF_AIO_WRITE_CONTROL, &aiocb[div]);
-                if ( m_wav_fp != NULL ) {
-                    GetNextData( &m_wk_wavfile_buff[0], (size_t)WAVE_DMA_SIZE_PRV_);
+                /* Wait for a DMA end or the reader publishing data, time out to poll for stop requests */
+                R_OS_WaitForSemaphore( &gsp_sound_control_t->playback_semaphore, gsp_sound_control_t->ul_delaytime_ms);
 
-                    write(gs_ssif_handle, &m_wk_wavfile_buff[0], WAVE_DMA_SIZE_PRV_);
-					
+                if (false != gs_decoder_open)
+                {
+                    update_position();
                 }
+            }
+#if (R_SELF_INSERT_APP_USB_AUDIO)
+            if (false != gs_usb_open)
+            {
+                /* detach the ring from the USB interrupt before it is reset */
+                control(gs_usb_handle, CTL_USBF_SET_AUDIO_SINK, NULL);
+                gs_usb_open = false;
+                gs_usb_playing = false;
+            }
+#endif
+            if (false == restart)
+            {
+                R_OS_SetEvent( &gsp_sound_control_t->task_trackdone );
+
+                R_OS_ResetEvent( &gsp_sound_control_t->task_play);
+            }
+
+            /* park the reader and the loader before closing the files they read from */
+            gsp_sound_control_t->reader_eof = true;
+            gsp_sound_control_t->loader_hold = true;
 
-                /* Waiting complete request #0to#(N-2) */
-                R_OS_WaitForSemaphore( &gsp_sound_control_t->playback_semaphore, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
+            while ((false != gsp_sound_control_t->reader_active) || (false != gsp_sound_control_t->loader_active))
+            {
+                R_OS_TaskSleep(1);
+            }
+
+            gs_decoder_open = false;
+
+            for (loop = 0u; loop < SOUND_PRV_TRACK_SLOTS; loop++)
+            {
+                close_track( &gs_tracks[loop]);
             }
-            R_OS_SetEvent( &gsp_sound_control_t->task_trackdone );
 
-            R_OS_ResetEvent( &gsp_sound_control_t->task_play);
-            f_lseek( m_wav_fp, 0);
-            AnalyzeHeader(NULL, NULL, NULL, 0, m_wav_fp);
+            r_audio_resample_destroy(gs_resampler);
+            gs_resampler = NULL;
+
+            gs_network_open = false;
+            gs_network_playing = false;
+
+            /* a jump or seek picks the playlist up again without waiting for r_soundtst_PlaySample */
+            if ((false == restart) && (false != gs_request_pending))
+            {
+                /* arrived as the last track ended */
+                R_OS_SetEvent( &gsp_sound_control_t->task_play);
+            }
 
+            if ((false == restart) && (false == gs_request_pending))
+            {
+                update_position();
+            }
         }
 
 		R_OS_DeleteEvent(&gsp_sound_control_t->task_stop);
@@ -308,145 +727,1492 @@ static void task_play_sound_demo (void *parameters)
  **********************************************************************************************************************/
 
 /***********************************************************************************************************************
- * Function Name: task_playback_sound_demo
- * Description  : This task records from the MIC connector on the board and plays the received audio back to the
- *                LINE OUT
- * Arguments    : void *parameters - task parameter - not used
- * Return Value : void
+ * Function Name: task_read_sound_file
+ * Description  : Producer side of the play ring. Decodes the playlist straight into free ring periods until the
+ *                ring is full, then sleeps until the DMA drains it to the low watermark. Tracks follow each other
+ *                inside a period, so the SSIF keeps running across the change.
+ * Arguments    : void *parameters - not used
+ * Return Value : none
  **********************************************************************************************************************/
-static void task_playback_sound_demo (void *parameters)
+static void task_read_sound_file (void *parameters)
 {
-    uint32_t div;
-    uint32_t txi_data = 0;
-    uint32_t txi_aio = 0;
-    uint32_t rxi_data = 0;
-    uint32_t rxi_aio = 0;
-    uint32_t loop;
-
-    /* message blocks for transmit and receive */
-    AIOCB rx_aiocb[NUM_AUDIO_BUFFER_BLOCKS_PRV_];
-    AIOCB tx_aiocb[NUM_AUDIO_BUFFER_BLOCKS_PRV_];
+    p_audio_ring_t p_ring = gsp_sound_control_t->p_play_ring;
+    uint8_t *p_period;
+    size_t length;
+    bool_t last;
 
     /* unused argument */
     UNUSED_PARAM(parameters);
 
-    /* populate transmit aiocb message blocks as part of this initialization process (but not sending yet) */
-    for (loop = 0u; loop < NUM_AUDIO_BUFFER_BLOCKS_PRV_; loop++)
+    while (1)
     {
-        /* register access semaphore */
-        tx_aiocb[loop].aio_sigevent.sigev_value.sival_ptr = (void *) &gsp_sound_control_t->playback_semaphore;
+        R_OS_WaitForSemaphore( &gsp_sound_control_t->reader_semaphore, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
 
-        /* register user callback function after dma transfer to SSIF */
-        tx_aiocb[loop].aio_sigevent.sigev_notify_function = &userdef_tx_callback;
-    }
+        gsp_sound_control_t->reader_active = true;
 
-    /* initialise each read message block and read from SSIF to fill buffer with audio data */
-    for (loop = 0u; loop < NUM_AUDIO_BUFFER_BLOCKS_PRV_; loop++)
-    {
-        /* register access semaphore */
-        rx_aiocb[loop].aio_sigevent.sigev_value.sival_ptr = (void *) &gsp_sound_control_t->record_semaphore;
+        while (false == gsp_sound_control_t->reader_eof)
+        {
+            if ((false == gs_decoder_open) && (false == gs_network_open))
+            {
+                /* nothing loaded or not a format we decode, let the play task finish straight away */
+                gsp_sound_control_t->reader_eof = true;
+                R_OS_ReleaseSemaphore( &gsp_sound_control_t->playback_semaphore);
+                break;
+            }
 
-        /* register user callback function after dma transfer from SSIF */
-        rx_aiocb[loop].aio_sigevent.sigev_notify_function = &userdef_rx_callback;
+            p_period = r_audio_ring_get_write_period(p_ring);
 
-        /* Update SSIF configuration */
-        control(gs_ssif_handle, R_SSIF_AIO_READ_CONTROL, (void *) &rx_aiocb[loop]);
+            if (NULL == p_period)
+            {
+                /* ring full, the low watermark callback wakes us */
+                break;
+            }
 
-        /* read data from SSIF to buffer block */
-        read(gs_ssif_handle, &gsp_sound_control_t->p_record_data[loop * REC_DMA_SIZE_PRV_], REC_DMA_SIZE_PRV_);
+            last = false;
 
-        /* update buffer/message tracking variables */
-        rxi_data++;
-        rxi_aio++;
-    }
+            if (false != gs_network_open)
+            {
+                length = fill_network_period((uint32_t *) p_period);
+            }
+            else
+            {
+                length = fill_period((uint32_t *) p_period);
+            }
 
-    /* reset flags prior to loop */
-    gs_tx_set_flag = false;
-    gs_rx_set_flag = false;
-    gs_rx_first_return_flag = false;
-    gs_tx_first_set_flag = false;
+            if (length < WAVE_DMA_SIZE_PRV_)
+            {
+                if (false != gs_track_waiting)
+                {
+                    /* the next track is still being opened, the loader wakes us with the partial period kept */
+                    break;
+                }
 
-    /* audio loop, exited by keypress on the console (implemented in calling task) */
-    while (1)
-    {
+                /* end of the playlist, the tail of the last track is padded out to a whole period */
+                if (0u == length)
+                {
+                    gsp_sound_control_t->reader_eof = true;
+                    R_OS_ReleaseSemaphore( &gsp_sound_control_t->playback_semaphore);
+                    break;
+                }
 
-        /* if audio receive dma has finished, update pointers and re-start dma transfer */
-        if (false != gs_rx_set_flag)
-        {
-            /* use correct block */
-            div = rxi_aio % NUM_AUDIO_BUFFER_BLOCKS_PRV_;
+                memset(p_period + length, 0, WAVE_DMA_SIZE_PRV_ - length);
+                last = true;
+            }
 
-            /* Update SSIF configuration */
-            control(gs_ssif_handle, R_SSIF_AIO_READ_CONTROL, (void *) &rx_aiocb[div]);
+            /* returns straight away while the chain is bypassed */
+            r_audio_dsp_process(gs_dsp, (uint32_t *) p_period, WAVE_DMA_SIZE_PRV_ / AUDIO_CONVERT_DST_FRAME_BYTES);
 
-            /* read from SSIF into block */
-            read(gs_ssif_handle, &gsp_sound_control_t->p_record_data[rxi_data * REC_DMA_SIZE_PRV_], REC_DMA_SIZE_PRV_);
+            r_audio_ring_commit_write(p_ring, WAVE_DMA_SIZE_PRV_);
+            gs_frames_written += (WAVE_DMA_SIZE_PRV_ / AUDIO_CONVERT_DST_FRAME_BYTES);
+            gs_period_frames = 0u;
 
-            /* update rx buffer/message tracking variables */
-            rxi_data++;
-            rxi_aio++;
+            if (false != last)
+            {
+                /* published before the flag so the play task cannot finish ahead of the last period */
+                gsp_sound_control_t->reader_eof = true;
+                R_OS_ReleaseSemaphore( &gsp_sound_control_t->playback_semaphore);
+            }
+        }
 
-            /* check for buffer boundary overflow */
-            if ((SIZEOF_WAVEDATA_RECPLAY_PRV_ / REC_DMA_SIZE_PRV_) < rxi_data)
+        gsp_sound_control_t->reader_active = false;
+    }
+}
+/***********************************************************************************************************************
+ End of function task_read_sound_file
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: fill_period
+ * Description  : Decodes the rest of the period being filled at the output rate. Files at another rate are decoded
+ *                into p_resample_in and run through the sample rate converter. When a track ends the next one, opened
+ *                ahead by the loader, carries on in the same period; the converter is only flushed with silence when
+ *                the rate changes or the playlist ends, so tracks at the same rate follow each other sample for
+ *                sample. The frames decoded so far are kept in gs_period_frames when the next track is not open yet.
+ * Arguments    : uint32_t *p_period - destination, WAVE_DMA_SIZE_PRV_ bytes
+ * Return Value : bytes in the period, less than a period at the end of the playlist or while gs_track_waiting is set
+ **********************************************************************************************************************/
+static uint32_t fill_period (uint32_t *p_period)
+{
+    uint32_t frames = WAVE_DMA_SIZE_PRV_ / AUDIO_CONVERT_DST_FRAME_BYTES;
+    uint32_t *p_in = gsp_sound_control_t->p_resample_in;
+    p_audio_decoder_t p_dec;
+    st_sound_track_t *p_next;
+    uint32_t decoded;
+    uint32_t used;
+
+    gs_track_waiting = false;
+
+    while ((gs_period_frames < frames) && (false != gs_decoder_open))
+    {
+        p_dec = &gs_tracks[gs_track_slot].decoder;
+
+        if (NULL == gs_resampler)
+        {
+            decoded = r_audio_decoder_decode(p_dec, p_period + (gs_period_frames * 2u), frames - gs_period_frames);
+            gs_period_frames += decoded;
+
+            if ((0u == decoded) && (false == next_track()))
             {
-                rxi_data = 0;
+                break;
             }
 
-            gs_rx_set_flag = false;
+            continue;
         }
 
-        /* Start transmission of audio from via SSIF if there is at least 1  */
-        if ((false != gs_rx_first_return_flag) && (false == gs_tx_first_set_flag))
+        if (gs_resample_in_pos == gs_resample_in_len)
         {
-            /* initialise each message block and write from buffer to SSIF to fill buffer with data */
-            for (loop = 0u; loop < NUM_AUDIO_BUFFER_BLOCKS_PRV_; loop++)
+            gs_resample_in_pos = 0u;
+            gs_resample_in_len = 0u;
+
+            if (false == gs_resample_flushed)
             {
-                /* Update SSIF configuration */
-                control(gs_ssif_handle, R_SSIF_AIO_WRITE_CONTROL, (void *) &tx_aiocb[loop]);
+                gs_resample_in_len = r_audio_decoder_decode(p_dec, p_in, frames);
+            }
 
-                /* write from block to SSIF */
-                write(gs_ssif_handle, &gsp_sound_control_t->p_playback_data[loop * REC_DMA_SIZE_PRV_],
-                REC_DMA_SIZE_PRV_);
+            if (0u == gs_resample_in_len)
+            {
+                p_next = &gs_tracks[gs_track_slot ^ 1u];
 
-                /* update tx buffer/message tracking variables */
-                txi_data++;
-                txi_aio++;
-            }
+                if (false != gs_resample_flushed)
+                {
+                    /* the filter is empty, the next track starts in a converter of its own */
+                    if (false == next_track())
+                    {
+                        break;
+                    }
 
-            /* prevent future access of this block */
-            gs_tx_first_set_flag = true;
+                    continue;
+                }
+
+                if ((SOUND_TRACK_READY != p_next->state) && (gs_next_index < gs_playlist_count))
+                {
+                    /* the rate of the next track is not known until the loader has opened it */
+                    gs_track_waiting = true;
+                    break;
+                }
+
+                if ((SOUND_TRACK_READY == p_next->state)
+                        && (p_next->decoder.format.sample_rate == p_dec->format.sample_rate))
+                {
+                    /* same rate, the next track runs on through the filter */
+                    next_track();
+                    continue;
+                }
+
+                /* new rate or end of the playlist, play out the frames still in the filter */
+                gs_resample_in_len = r_audio_resample_get_delay(gs_resampler);
+                memset(p_in, 0, gs_resample_in_len * AUDIO_CONVERT_DST_FRAME_BYTES);
+                gs_resample_flushed = true;
+            }
         }
 
-        /* if audio transmit dma has finished, update pointers and re-start dma transfer */
-        if (false != gs_tx_set_flag)
-        {
-            /* point to next buffer area */
-            div = txi_aio % NUM_AUDIO_BUFFER_BLOCKS_PRV_;
+        gs_period_frames += r_audio_resample_process(gs_resampler, p_in + (gs_resample_in_pos * 2u),
+                gs_resample_in_len - gs_resample_in_pos, &used, p_period + (gs_period_frames * 2u),
+                frames - gs_period_frames);
+        gs_resample_in_pos += used;
+    }
+
+    return (gs_period_frames * AUDIO_CONVERT_DST_FRAME_BYTES);
+}
+/***********************************************************************************************************************
+ End of function fill_period
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: next_track
+ * Description  : Reader side of a track change. Makes the slot opened ahead by the loader the one being decoded,
+ *                replaces the sample rate converter if the rate changes and notes where the new track starts in the
+ *                output so the playhead follows it once it reaches the DAC.
+ * Arguments    : none
+ * Return Value : true if the reader moved on, false at the end of the playlist or while the next track is being
+ *                opened (gs_track_waiting is set)
+ **********************************************************************************************************************/
+static bool_t next_track (void)
+{
+    st_sound_track_t *p_track = &gs_tracks[gs_track_slot];
+    st_sound_track_t *p_next = &gs_tracks[gs_track_slot ^ 1u];
+    uint32_t delay = 0u;
+
+    if (SOUND_TRACK_READY != p_next->state)
+    {
+        /* entries left means the loader has not finished with the next one yet */
+        gs_track_waiting = (gs_next_index < gs_playlist_count);
+        return (false);
+    }
+
+    if (p_next->decoder.format.sample_rate != p_track->decoder.format.sample_rate)
+    {
+        /* only reached once the old converter has been flushed */
+        r_audio_resample_destroy(gs_resampler);
+        gs_resampler = NULL;
+        gs_resample_in_pos = 0u;
+        gs_resample_in_len = 0u;
+        gs_resample_flushed = false;
+
+        if (SOUND_PRV_OUTPUT_RATE != p_next->decoder.format.sample_rate)
+        {
+            gs_resampler = r_audio_resample_create(p_next->decoder.format.sample_rate, SOUND_PRV_OUTPUT_RATE,
+                    gs_resample_quality);
+
+            if (NULL == gs_resampler)
+            {
+                /* out of memory, end the playlist here */
+                gs_decoder_open = false;
+                return (false);
+            }
+        }
+    }
+    else if (NULL != gs_resampler)
+    {
+        /* the end of the old track is still in the filter and comes out first */
+        delay = (uint32_t) (((uint64_t) r_audio_resample_get_delay(gs_resampler) * SOUND_PRV_OUTPUT_RATE)
+                / p_track->decoder.format.sample_rate);
+    }
+
+    p_track->state = SOUND_TRACK_DONE;
+    p_next->state = SOUND_TRACK_PLAYING;
+    gs_track_slot ^= 1u;
+    gs_transitions++;
+
+    add_track_start(gs_frames_written + gs_period_frames + delay, 0u);
+
+    /* the loader closes the finished track and opens the one after */
+    R_OS_ReleaseSemaphore( &gsp_sound_control_t->loader_semaphore);
+
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function next_track
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: open_track
+ * Description  : Opens a playlist entry into a track slot, the prefetch starts and the header is parsed here so the
+ *                reader can decode from it straight away
+ * Arguments    : st_sound_track_t *p_track - empty slot
+ *                uint32_t index - playlist entry
+ * Return Value : true if the file opened and is in a format we decode
+ **********************************************************************************************************************/
+static bool_t open_track (st_sound_track_t *p_track, uint32_t index)
+{
+    st_audio_source_t source;
+    FIL *fp = NULL;
+
+    /* copied out so the playlist can be changed while the drive is busy */
+    R_OS_AcquireMutex(gsp_sound_control_t->p_playlist_mutex);
+    gs_open_path[0] = '\0';
+
+    if (index < gs_playlist_count)
+    {
+        strncpy(gs_open_path, gs_playlist[index], sizeof(gs_open_path) - 1u);
+        gs_open_path[sizeof(gs_open_path) - 1u] = '\0';
+    }
+
+    R_OS_ReleaseMutex(gsp_sound_control_t->p_playlist_mutex);
+
+    if ('\0' != gs_open_path[0])
+    {
+        fp = R_FAT_OpenFile(gs_open_path, FA_READ);
+    }
+
+    if (NULL == fp)
+    {
+        return (false);
+    }
+
+    r_audio_stream_init_source(p_track->p_stream, fp, &source);
+
+    if (DEVDRV_SUCCESS != r_audio_decoder_open( &p_track->decoder, &source))
+    {
+        r_audio_stream_stop(p_track->p_stream);
+        R_FAT_CloseFile(fp);
+        return (false);
+    }
+
+    p_track->fp = fp;
+    p_track->external = false;
+    p_track->index = index;
+
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function open_track
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: close_track
+ * Description  : Closes the decoder and the file of a track slot and stops its prefetch
+ * Arguments    : st_sound_track_t *p_track - slot, may already be empty
+ * Return Value : none
+ **********************************************************************************************************************/
+static void close_track (st_sound_track_t *p_track)
+{
+    if (SOUND_TRACK_EMPTY == p_track->state)
+    {
+        return;
+    }
+
+    r_audio_decoder_close( &p_track->decoder);
+    r_audio_stream_stop(p_track->p_stream);
+
+    if (false == p_track->external)
+    {
+        R_FAT_CloseFile(p_track->fp);
+    }
+
+    p_track->fp = NULL;
+    p_track->state = SOUND_TRACK_EMPTY;
+}
+/***********************************************************************************************************************
+ End of function close_track
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: start_playlist
+ * Description  : Opens the first track into slot 0 for the play task, skipping entries that cannot be played. With an
+ *                empty playlist the file handed over by r_soundtst_LoadSample is played instead.
+ * Arguments    : uint32_t index - playlist entry to start from
+ *                uint32_t position_ms - position in that track
+ * Return Value : true if there is a track for the reader
+ **********************************************************************************************************************/
+static bool_t start_playlist (uint32_t index, uint32_t position_ms)
+{
+    st_sound_track_t *p_track = &gs_tracks[0];
+    st_audio_source_t source;
+    bool_t open = false;
+    uint32_t rate;
+
+    gs_track_slot = 0u;
+    gs_track_start_count = 0u;
+
+    if (0u == gs_playlist_count)
+    {
+        if (NULL != m_wav_fp)
+        {
+            r_audio_stream_init_source(p_track->p_stream, m_wav_fp, &source);
+            open = (DEVDRV_SUCCESS == r_audio_decoder_open( &p_track->decoder, &source));
+
+            if (false == open)
+            {
+                r_audio_stream_stop(p_track->p_stream);
+            }
+        }
+
+        p_track->fp = m_wav_fp;
+        p_track->external = true;
+        p_track->index = 0u;
+        gs_next_index = 0u;
+    }
+    else
+    {
+        while ((false == open) && (index < gs_playlist_count))
+        {
+            open = open_track(p_track, index);
+            index++;
+        }
+
+        gs_next_index = index;
+    }
+
+    if (false == open)
+    {
+        return (false);
+    }
+
+    p_track->state = SOUND_TRACK_PLAYING;
+    rate = p_track->decoder.format.sample_rate;
+
+    if ((0u != position_ms)
+            && (DEVDRV_SUCCESS != r_audio_decoder_seek( &p_track->decoder,
+                    (uint32_t) (((uint64_t) position_ms * rate) / 1000u))))
+    {
+        /* not seekable, play from the start */
+        position_ms = 0u;
+    }
+
+    /* run every file at the codec rate rather than reprogramming the codec per track */
+    gs_resample_in_pos = 0u;
+    gs_resample_in_len = 0u;
+    gs_resample_flushed = false;
+
+    if (SOUND_PRV_OUTPUT_RATE != rate)
+    {
+        gs_resampler = r_audio_resample_create(rate, SOUND_PRV_OUTPUT_RATE, gs_resample_quality);
+
+        if (NULL == gs_resampler)
+        {
+            close_track(p_track);
+            return (false);
+        }
+    }
+
+    add_track_start(gs_frames_written, position_ms);
+
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function start_playlist
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: add_track_start
+ * Description  : Records where the track the reader has just started will be heard. The entry is filled in before
+ *                the count moves on, readers of the count never see a half written entry.
+ * Arguments    : uint32_t output_frame - gs_frames_played value at its first frame
+ *                uint32_t start_ms - position of that frame in the track
+ * Return Value : none
+ **********************************************************************************************************************/
+static void add_track_start (uint32_t output_frame, uint32_t start_ms)
+{
+    volatile st_sound_track_start_t *p_start = &gs_track_starts[gs_track_start_count % SOUND_PRV_TRACK_STARTS];
+    const st_audio_format_t *p_format = &gs_tracks[gs_track_slot].decoder.format;
+
+    p_start->start_frame = output_frame;
+    p_start->index = gs_tracks[gs_track_slot].index;
+    p_start->start_ms = start_ms;
+    p_start->sample_rate = p_format->sample_rate;
+    p_start->bits_per_sample = p_format->bits_per_sample;
+    p_start->duration_ms = 0u;
+
+    if (0u != p_format->sample_rate)
+    {
+        p_start->duration_ms = (uint32_t) (((uint64_t) p_format->total_frames * 1000u) / p_format->sample_rate);
+    }
+
+    gs_track_start_count++;
+}
+/***********************************************************************************************************************
+ End of function add_track_start
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: read_position
+ * Description  : Works out the playhead from the frames the DMA has played, the newest track start already reached
+ *                is the track being heard
+ * Arguments    : st_sound_position_t *p_position - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+static void read_position (st_sound_position_t *p_position)
+{
+    uint32_t played = gs_frames_played;
+    uint32_t count = gs_track_start_count;
+    uint32_t oldest;
+    uint32_t elapsed;
+    volatile st_sound_track_start_t *p_start = NULL;
+
+    memset(p_position, 0, sizeof(st_sound_position_t));
+
+    if ((false == gs_decoder_open) || (0u == count))
+    {
+        return;
+    }
+
+    oldest = (count > SOUND_PRV_TRACK_STARTS) ? (count - SOUND_PRV_TRACK_STARTS) : 0u;
+
+    /* walk back from the newest, the oldest is used until the first frame reaches the DAC */
+    do
+    {
+        count--;
+        p_start = &gs_track_starts[count % SOUND_PRV_TRACK_STARTS];
+    }
+    while ((count > oldest) && (((int32_t) (played - p_start->start_frame)) < 0));
+
+    elapsed = (((int32_t) (played - p_start->start_frame)) > 0) ? (played - p_start->start_frame) : 0u;
+
+    p_position->playing = true;
+    p_position->track = p_start->index;
+    p_position->duration_ms = p_start->duration_ms;
+    p_position->sample_rate = p_start->sample_rate;
+    p_position->bits_per_sample = p_start->bits_per_sample;
+    p_position->position_ms = p_start->start_ms
+            + (uint32_t) (((uint64_t) elapsed * 1000u) / SOUND_PRV_OUTPUT_RATE);
+    p_position->transitions = gs_transitions;
+
+    /* the silence padding the last period is not part of the track */
+    if ((0u != p_position->duration_ms) && (p_position->position_ms > p_position->duration_ms))
+    {
+        p_position->position_ms = p_position->duration_ms;
+    }
+}
+/***********************************************************************************************************************
+ End of function read_position
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: update_position
+ * Description  : Play task side of the position event, set when the playhead changes track, starts or stops, jumps
+ *                back, or moves SOUND_PRV_POSITION_STEP_MS since it was last set. Listeners get one event per step
+ *                rather than one message per DMA period.
+ * Arguments    : none
+ * Return Value : none
+ **********************************************************************************************************************/
+static void update_position (void)
+{
+    st_sound_position_t position;
+
+    read_position( &position);
+
+    if ((position.playing != gs_position_reported.playing) || (position.track != gs_position_reported.track)
+            || (position.position_ms < gs_position_reported.position_ms)
+            || ((position.position_ms - gs_position_reported.position_ms) >= SOUND_PRV_POSITION_STEP_MS))
+    {
+        gs_position_reported = position;
+        R_OS_SetEvent( &gsp_sound_control_t->position_changed);
+    }
+}
+/***********************************************************************************************************************
+ End of function update_position
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: update_play_stats
+ * Description  : Play task side of the playback statistics, charged to the format of the track being heard. Called
+ *                each time the task wakes while the SSIF is running, before the queue is topped up again.
+ * Arguments    : uint32_t queued - periods still queued to the SSIF
+ *                bool_t underrun - the SSIF drained
+ * Return Value : none
+ **********************************************************************************************************************/
+static void update_play_stats (uint32_t queued, bool_t underrun)
+{
+    st_sound_position_t position;
+    st_sound_format_stats_t *p_format = NULL;
+    uint32_t played = gs_frames_played;
+    uint32_t entry;
+
+    read_position( &position);
+
+    for (entry = 0u; entry < gs_play_stats.formats; entry++)
+    {
+        if ((gs_play_stats.format[entry].sample_rate == position.sample_rate)
+                && (gs_play_stats.format[entry].bits_per_sample == position.bits_per_sample))
+        {
+            p_format = &gs_play_stats.format[entry];
+        }
+    }
+
+    if ((NULL == p_format) && (gs_play_stats.formats < SOUND_PLAY_STATS_FORMATS))
+    {
+        p_format = &gs_play_stats.format[gs_play_stats.formats];
+        p_format->sample_rate = position.sample_rate;
+        p_format->bits_per_sample = position.bits_per_sample;
+        p_format->min_queued = queued;
+        gs_play_stats.formats++;
+    }
+
+    if (NULL == p_format)
+    {
+        /* table full, the formats already in it keep counting */
+        gs_play_stats_frames = played;
+        return;
+    }
+
+    p_format->periods += (played - gs_play_stats_frames) / (WAVE_DMA_SIZE_PRV_ / AUDIO_CONVERT_DST_FRAME_BYTES);
+    gs_play_stats_frames = played;
+
+    if (queued < p_format->min_queued)
+    {
+        p_format->min_queued = queued;
+    }
+
+    if (false != underrun)
+    {
+        p_format->underruns++;
+    }
+}
+/***********************************************************************************************************************
+ End of function update_play_stats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: task_load_track
+ * Description  : Closes the track the reader has finished with and opens the next playlist entry into the free slot
+ *                while the current one plays, so the file open, header parse and first prefetch reads are done
+ *                before the reader needs them. Entries that cannot be played are skipped.
+ * Arguments    : void *parameters - not used
+ * Return Value : none
+ **********************************************************************************************************************/
+static void task_load_track (void *parameters)
+{
+    st_sound_track_t *p_next;
+    uint32_t slot;
+    uint32_t index;
+
+    /* unused argument */
+    UNUSED_PARAM(parameters);
+
+    while (1)
+    {
+        R_OS_WaitForSemaphore( &gsp_sound_control_t->loader_semaphore, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
+
+        /* flag first, the play task sets loader_hold and then waits for loader_active to clear */
+        gsp_sound_control_t->loader_active = true;
+
+        if (false == gsp_sound_control_t->loader_hold)
+        {
+            for (slot = 0u; slot < SOUND_PRV_TRACK_SLOTS; slot++)
+            {
+                if (SOUND_TRACK_DONE == gs_tracks[slot].state)
+                {
+                    close_track( &gs_tracks[slot]);
+                }
+            }
+
+            p_next = &gs_tracks[gs_track_slot ^ 1u];
+
+            while ((SOUND_TRACK_EMPTY == p_next->state) && (gs_next_index < gs_playlist_count)
+                    && (false == gsp_sound_control_t->loader_hold))
+            {
+                index = gs_next_index;
+
+                if (false != open_track(p_next, index))
+                {
+                    p_next->state = SOUND_TRACK_READY;
+                }
+
+                /* moved on after the slot is ready, the reader waits for the slot while entries are left */
+                gs_next_index = index + 1u;
+            }
+
+            if (SOUND_TRACK_READY == p_next->state)
+            {
+                /* the reader may be holding a part filled period for this track */
+                R_OS_ReleaseSemaphore( &gsp_sound_control_t->reader_semaphore);
+            }
+        }
+
+        gsp_sound_control_t->loader_active = false;
+    }
+}
+/***********************************************************************************************************************
+ End of function task_load_track
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: fill_network_period
+ * Description  : Pulls one period from the network receiver through the variable rate converter. The ratio is trimmed
+ *                every period so the jitter buffer drains at the sender's rate rather than the SSIF's. The playout
+ *                time handed to the receiver counts the periods already in the ring and the converter's delay, so its
+ *                latency figures run from packet arrival to the DAC.
+ * Arguments    : uint32_t *p_period - destination, WAVE_DMA_SIZE_PRV_ bytes
+ * Return Value : bytes written, always a full period
+ **********************************************************************************************************************/
+static uint32_t fill_network_period (uint32_t *p_period)
+{
+#if (R_SELF_LOAD_MIDDLEWARE_ETHERNET_MODULES)
+    uint32_t frames = WAVE_DMA_SIZE_PRV_ / AUDIO_CONVERT_DST_FRAME_BYTES;
+    uint32_t *p_in = gsp_sound_control_t->p_resample_in;
+    uint32_t written = 0u;
+    uint32_t used;
+    uint32_t queued_us;
+    st_audio_format_t format;
+
+    r_audio_rtp_get_format(gs_rtp, &format);
+    r_audio_resample_set_trim(gs_resampler, r_audio_rtp_get_trim(gs_rtp));
+
+    while (written < frames)
+    {
+        if (gs_resample_in_pos == gs_resample_in_len)
+        {
+            queued_us = (uint32_t) (((uint64_t) ((r_audio_ring_filled(gsp_sound_control_t->p_play_ring) * frames)
+                    + written) * 1000000u) / SOUND_PRV_OUTPUT_RATE)
+                    + (uint32_t) (((uint64_t) r_audio_resample_get_delay(gs_resampler) * 1000000u)
+                            / format.sample_rate);
+
+            r_audio_rtp_read(gs_rtp, p_in, frames,
+                    SOUND_PRV_TIME_STAMP() + (queued_us * SOUND_PRV_TIME_STAMP_COUNTS_PER_US));
+            gs_resample_in_pos = 0u;
+            gs_resample_in_len = frames;
+        }
+
+        written += r_audio_resample_process(gs_resampler, p_in + (gs_resample_in_pos * 2u),
+                gs_resample_in_len - gs_resample_in_pos, &used, p_period + (written * 2u), frames - written);
+        gs_resample_in_pos += used;
+    }
+
+    return (written * AUDIO_CONVERT_DST_FRAME_BYTES);
+#else
+    /* no network, ends the track straight away */
+    UNUSED_PARAM(p_period);
+
+    return (0u);
+#endif
+}
+/***********************************************************************************************************************
+ End of function fill_network_period
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: play_ring_high_callback
+ * Description  : Reader has filled the ring to the high watermark, wake the play task to start the SSIF
+ * Arguments    : p_audio_ring_t p_ring - play ring
+ *                void *p_context - sound control structure
+ * Return Value : none
+ **********************************************************************************************************************/
+static void play_ring_high_callback (p_audio_ring_t p_ring, void *p_context)
+{
+    UNUSED_PARAM(p_ring);
+
+#if (R_SELF_INSERT_APP_USB_AUDIO)
+    /* the USB interrupt is the producer while the host is streaming */
+    if (false != gs_usb_open)
+    {
+        BaseType_t woken = pdFALSE;
+
+        xSemaphoreGiveFromISR((SemaphoreHandle_t) ((p_sound_config_t) p_context)->playback_semaphore, &woken);
+        portYIELD_FROM_ISR(woken);
+        return;
+    }
+#endif
+
+    R_OS_ReleaseSemaphore( &((p_sound_config_t) p_context)->playback_semaphore);
+}
+/***********************************************************************************************************************
+ End of function play_ring_high_callback
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: play_ring_low_callback
+ * Description  : Runs in the DMA end interrupt when the ring drains to the low watermark, wakes the file reader
+ * Arguments    : p_audio_ring_t p_ring - play ring
+ *                void *p_context - sound control structure
+ * Return Value : none
+ **********************************************************************************************************************/
+static void play_ring_low_callback (p_audio_ring_t p_ring, void *p_context)
+{
+    BaseType_t woken = pdFALSE;
+
+    UNUSED_PARAM(p_ring);
+
+    xSemaphoreGiveFromISR((SemaphoreHandle_t) ((p_sound_config_t) p_context)->reader_semaphore, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+/***********************************************************************************************************************
+ End of function play_ring_low_callback
+ **********************************************************************************************************************/
+
+#if (R_SELF_INSERT_APP_USB_AUDIO)
+/***********************************************************************************************************************
+ * Function Name: usb_get_buffer
+ * Description  : USB audio sink, runs in the USB interrupt. Returns the unfilled part of the current ring period so
+ *                the FIFO is read straight into it, claiming a new period when the last one was published.
+ * Arguments    : void *p_context - play ring
+ *                uint32_t *p_space - bytes that fit at the returned address
+ * Return Value : write address, NULL when the ring is full
+ **********************************************************************************************************************/
+static uint8_t *usb_get_buffer (void *p_context, uint32_t *p_space)
+{
+    if (NULL == gs_usb_period)
+    {
+        gs_usb_period = r_audio_ring_get_write_period((p_audio_ring_t) p_context);
+        gs_usb_fill = 0u;
+
+        if (NULL == gs_usb_period)
+        {
+            return (NULL);
+        }
+    }
+
+    (*p_space) = WAVE_DMA_SIZE_PRV_ - gs_usb_fill;
+
+    return (gs_usb_period + gs_usb_fill);
+}
+/***********************************************************************************************************************
+ End of function usb_get_buffer
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: usb_commit
+ * Description  : USB audio sink, runs in the USB interrupt. Applies the host volume to the frames just read and
+ *                publishes the period once it is full.
+ * Arguments    : void *p_context - play ring
+ *                uint8_t *p_data - frames returned by usb_get_buffer
+ *                uint32_t length - bytes written there
+ * Return Value : none
+ **********************************************************************************************************************/
+static void usb_commit (void *p_context, uint8_t *p_data, uint32_t length)
+{
+    int32_t gain = gs_usb_gain_q23;
+    int32_t *p_sample = (int32_t *) p_data;
+    uint32_t count = length / sizeof(int32_t);
+
+    if (AUDIO_GAIN_Q23_ONE != gain)
+    {
+        while (count > 0u)
+        {
+            (*p_sample) = (int32_t) (((int64_t) (*p_sample) * gain) >> 23);
+            p_sample++;
+            count--;
+        }
+    }
+
+    gs_usb_fill += length;
+
+    if (gs_usb_fill >= WAVE_DMA_SIZE_PRV_)
+    {
+        r_audio_ring_commit_write((p_audio_ring_t) p_context, WAVE_DMA_SIZE_PRV_);
+        gs_usb_period = NULL;
+    }
+}
+/***********************************************************************************************************************
+ End of function usb_commit
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: usb_get_level
+ * Description  : USB audio sink, frames in the ring not yet played including those queued to the SSIF
+ * Arguments    : void *p_context - play ring
+ * Return Value : frames
+ **********************************************************************************************************************/
+static uint32_t usb_get_level (void *p_context)
+{
+    return ((r_audio_ring_filled((p_audio_ring_t) p_context) * (WAVE_DMA_SIZE_PRV_ / AUDIO_CONVERT_DST_FRAME_BYTES))
+            + (gs_usb_fill / AUDIO_CONVERT_DST_FRAME_BYTES));
+}
+/***********************************************************************************************************************
+ End of function usb_get_level
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: usb_volume
+ * Description  : USB audio sink, host changed the feature unit. The 1/256 dB volume is rounded to the quarter dB
+ *                steps of the gain table.
+ * Arguments    : void *p_context - not used
+ *                BOOL mute - host mute
+ *                int16_t volume - host volume, 1/256 dB
+ * Return Value : none
+ **********************************************************************************************************************/
+static void usb_volume (void *p_context, BOOL mute, int16_t volume)
+{
+    UNUSED_PARAM(p_context);
+
+    gs_usb_gain_q23 = (FALSE != mute) ? 0 : r_audio_gain_q23(((int32_t) volume) / 64);
+}
+/***********************************************************************************************************************
+ End of function usb_volume
+ **********************************************************************************************************************/
+#endif
+
+/***********************************************************************************************************************
+ * Function Name: task_playback_sound_demo
+ * Description  : This task records from the MIC connector on the board and plays the received audio back to the
+ *                LINE OUT. The task blocks on period_semaphore between DMA periods, every SSIF DMA completion
+ *                gives the semaphore so the task only runs when a block has to be re-queued.
+ * Arguments    : void *parameters - task parameter - not used
+ * Return Value : void
+ **********************************************************************************************************************/
+static void task_playback_sound_demo (void *parameters)
+{
+    uint32_t div;
+    uint32_t txi_data = 0;
+    uint32_t txi_aio = 0;
+    uint32_t rxi_data = 0;
+    uint32_t rxi_aio = 0;
+    uint32_t loop;
+    uint32_t rx_handled = 0u;
+    uint32_t tx_handled = 0u;
+    uint32_t pending;
+    bool_t   tx_started = false;
+
+    /* message blocks for transmit and receive */
+    AIOCB rx_aiocb[NUM_AUDIO_BUFFER_BLOCKS_PRV_];
+    AIOCB tx_aiocb[NUM_AUDIO_BUFFER_BLOCKS_PRV_];
+
+    /* unused argument */
+    UNUSED_PARAM(parameters);
+
+    /* populate transmit aiocb message blocks as part of this initialization process (but not sending yet) */
+    for (loop = 0u; loop < NUM_AUDIO_BUFFER_BLOCKS_PRV_; loop++)
+    {
+        /* register access semaphore */
+        tx_aiocb[loop].aio_sigevent.sigev_value.sival_ptr = (void *) &gsp_sound_control_t->period_semaphore;
+
+        /* register user callback function after dma transfer to SSIF */
+        tx_aiocb[loop].aio_sigevent.sigev_notify_function = &userdef_tx_callback;
+    }
+
+    /* reset completion counters prior to queueing the first request */
+    gs_tx_complete_count = 0u;
+    gs_rx_complete_count = 0u;
+    r_soundtst_ResetPeriodStats();
+
+    /* initialise each read message block and read from SSIF to fill buffer with audio data */
+    for (loop = 0u; loop < NUM_AUDIO_BUFFER_BLOCKS_PRV_; loop++)
+    {
+        /* register access semaphore */
+        rx_aiocb[loop].aio_sigevent.sigev_value.sival_ptr = (void *) &gsp_sound_control_t->period_semaphore;
+
+        /* register user callback function after dma transfer from SSIF */
+        rx_aiocb[loop].aio_sigevent.sigev_notify_function = &userdef_rx_callback;
+
+        /* Update SSIF configuration */
+        control(gs_ssif_handle, R_SSIF_AIO_READ_CONTROL, (void *) &rx_aiocb[loop]);
+
+        /* read data from SSIF to buffer block */
+        read(gs_ssif_handle, &gsp_sound_control_t->p_record_data[loop * REC_DMA_SIZE_PRV_], REC_DMA_SIZE_PRV_);
+
+        /* update buffer/message tracking variables */
+        rxi_data++;
+        rxi_aio++;
+    }
+
+    /* audio loop, exited by keypress on the console (implemented in calling task) */
+    while (1)
+    {
+        /* sleep until the SSIF signals the end of a DMA period */
+        R_OS_WaitForSemaphore( &gsp_sound_control_t->period_semaphore, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
+
+        /* more than one period outstanding means the task woke up late */
+        pending = (gs_rx_complete_count - rx_handled) + (gs_tx_complete_count - tx_handled);
+
+        /* the semaphore count can run ahead of the work already drained below */
+        if (0u == pending)
+        {
+            continue;
+        }
+
+        update_period_stats(pending);
+
+        /* if audio receive dma has finished, update pointers and re-start dma transfer */
+        while (rx_handled != gs_rx_complete_count)
+        {
+            /* use correct block */
+            div = rxi_aio % NUM_AUDIO_BUFFER_BLOCKS_PRV_;
+
+            /* Update SSIF configuration */
+            control(gs_ssif_handle, R_SSIF_AIO_READ_CONTROL, (void *) &rx_aiocb[div]);
+
+            /* read from SSIF into block */
+            read(gs_ssif_handle, &gsp_sound_control_t->p_record_data[rxi_data * REC_DMA_SIZE_PRV_], REC_DMA_SIZE_PRV_);
+
+            /* update rx buffer/message tracking variables */
+            rxi_data++;
+            rxi_aio++;
+
+            /* check for buffer boundary overflow */
+            if ((SIZEOF_WAVEDATA_RECPLAY_PRV_ / REC_DMA_SIZE_PRV_) < rxi_data)
+            {
+                rxi_data = 0;
+            }
+
+            rx_handled++;
+        }
+
+        /* Start transmission of audio from via SSIF if there is at least 1  */
+        if ((0u != rx_handled) && (false == tx_started))
+        {
+            /* initialise each message block and write from buffer to SSIF to fill buffer with data */
+            for (loop = 0u; loop < NUM_AUDIO_BUFFER_BLOCKS_PRV_; loop++)
+            {
+                /* Update SSIF configuration */
+                control(gs_ssif_handle, R_SSIF_AIO_WRITE_CONTROL, (void *) &tx_aiocb[loop]);
+
+                /* write from block to SSIF */
+                write(gs_ssif_handle, &gsp_sound_control_t->p_playback_data[loop * REC_DMA_SIZE_PRV_],
+                REC_DMA_SIZE_PRV_);
+
+                /* update tx buffer/message tracking variables */
+                txi_data++;
+                txi_aio++;
+            }
+
+            /* prevent future access of this block */
+            tx_started = true;
+        }
+
+        /* if audio transmit dma has finished, update pointers and re-start dma transfer */
+        while (tx_handled != gs_tx_complete_count)
+        {
+            /* point to next buffer area */
+            div = txi_aio % NUM_AUDIO_BUFFER_BLOCKS_PRV_;
+
+            /* Update SSIF configuration */
+            control(gs_ssif_handle, R_SSIF_AIO_WRITE_CONTROL, (void *) &tx_aiocb[div]);
+
+            /* write from block to SSIF */
+            write(gs_ssif_handle, &gsp_sound_control_t->p_playback_data[txi_data * REC_DMA_SIZE_PRV_],
+            REC_DMA_SIZE_PRV_);
+
+            /* update tx buffer/message tracking variables */
+            txi_data++;
+            txi_aio++;
+
+            /* check for buffer boundary overflow */
+            if ((SIZEOF_WAVEDATA_RECPLAY_PRV_ / REC_DMA_SIZE_PRV_) < txi_data)
+            {
+                txi_data = 0;
+            }
+
+            tx_handled++;
+        }
+    }
+}
+/***********************************************************************************************************************
+ End of function task_playback_sound_demo
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: update_period_stats
+ * Description  : Accumulates the time between the last SSIF DMA completion and the audio task running
+ * Arguments    : uint32_t pending - number of DMA completions handled by this wake-up
+ * Return Value : none
+ **********************************************************************************************************************/
+static void update_period_stats (uint32_t pending)
+{
+    /* unsigned subtraction handles the counter wrapping */
+    uint32_t latency_us = (SOUND_PRV_TIME_STAMP() - gs_period_time_stamp) / SOUND_PRV_TIME_STAMP_COUNTS_PER_US;
+
+    gs_period_stats.wakeups++;
+    gs_period_stats.periods += pending;
+    gs_period_stats.total_latency_us += latency_us;
+
+    if (latency_us < gs_period_stats.min_latency_us)
+    {
+        gs_period_stats.min_latency_us = latency_us;
+    }
+
+    if (latency_us > gs_period_stats.max_latency_us)
+    {
+        gs_period_stats.max_latency_us = latency_us;
+    }
+
+    /* rx and tx complete together, anything beyond one period per direction was missed */
+    if (pending > 2u)
+    {
+        gs_period_stats.late_wakeups++;
+    }
+}
+/***********************************************************************************************************************
+ End of function update_period_stats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_GetPeriodStats
+ * Description  : Copies the per period wake-up latency statistics of the record/playback task
+ * Arguments    : st_sound_period_stats_t *p_stats - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_soundtst_GetPeriodStats (st_sound_period_stats_t *p_stats)
+{
+    if (NULL != p_stats)
+    {
+        *p_stats = gs_period_stats;
+    }
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_GetPeriodStats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_GetStreamStats
+ * Description  : Copies the fill level and underrun counters of the prefetch of the track being decoded
+ * Arguments    : st_audio_stream_stats_t *p_stats - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_soundtst_GetStreamStats (st_audio_stream_stats_t *p_stats)
+{
+    if (NULL != p_stats)
+    {
+        memset(p_stats, 0, sizeof(st_audio_stream_stats_t));
+
+        if (NULL != gsp_sound_control_t)
+        {
+            /* the slot being decoded, the other one is only read ahead of the next track */
+            r_audio_stream_get_stats(gs_tracks[gs_track_slot].p_stream, p_stats);
+        }
+    }
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_GetStreamStats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_ResetPeriodStats
+ * Description  : Clears the per period wake-up latency statistics
+ * Arguments    : none
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_soundtst_ResetPeriodStats (void)
+{
+    memset(&gs_period_stats, 0, sizeof(gs_period_stats));
+    gs_period_stats.min_latency_us = 0xFFFFFFFFu;
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_ResetPeriodStats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_SetQueueDepth
+ * Description  : Sets how many periods the play task keeps queued to the SSIF, applied from its next top up. Deeper
+ *                queues ride out longer stalls of the play task, the periods come out of the play ring.
+ * Arguments    : uint32_t depth - 1 to SOUND_SSIF_QUEUE_DEPTH_MAX
+ * Return Value : DEVDRV_SUCCESS, DEVDRV_ERROR if out of range
+ **********************************************************************************************************************/
+int32_t r_soundtst_SetQueueDepth (uint32_t depth)
+{
+    if ((0u == depth) || (depth > PLAY_SSIF_QUEUE_MAX_PRV_))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    gs_queue_depth = depth;
+
+    return (DEVDRV_SUCCESS);
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_SetQueueDepth
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_GetQueueDepth
+ * Description  : Reads how many periods the play task keeps queued to the SSIF
+ * Arguments    : none
+ * Return Value : periods
+ **********************************************************************************************************************/
+uint32_t r_soundtst_GetQueueDepth (void)
+{
+    return (gs_queue_depth);
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_GetQueueDepth
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_GetPlayStats
+ * Description  : Copies the file playback underrun and SSIF queue headroom counters, one entry per source format
+ * Arguments    : st_sound_play_stats_t *p_stats - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_soundtst_GetPlayStats (st_sound_play_stats_t *p_stats)
+{
+    if (NULL != p_stats)
+    {
+        *p_stats = gs_play_stats;
+        p_stats->queue_depth = gs_queue_depth;
+    }
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_GetPlayStats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_ResetPlayStats
+ * Description  : Clears the file playback counters
+ * Arguments    : none
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_soundtst_ResetPlayStats (void)
+{
+    memset(&gs_play_stats, 0, sizeof(gs_play_stats));
+    gs_play_stats_frames = gs_frames_played;
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_ResetPlayStats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_SetResampleQuality
+ * Description  : Selects the sample rate converter quality for the next track
+ * Arguments    : e_audio_resample_quality_t quality - quality mode
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_soundtst_SetResampleQuality (e_audio_resample_quality_t quality)
+{
+    if (quality < AUDIO_RESAMPLE_QUALITY_COUNT)
+    {
+        gs_resample_quality = quality;
+    }
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_SetResampleQuality
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_GetResampleQuality
+ * Description  : Reads the sample rate converter quality
+ * Arguments    : none
+ * Return Value : quality mode
+ **********************************************************************************************************************/
+e_audio_resample_quality_t r_soundtst_GetResampleQuality (void)
+{
+    return (gs_resample_quality);
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_GetResampleQuality
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_GetOutputRate
+ * Description  : Rate the codec runs at
+ * Arguments    : none
+ * Return Value : sample rate in Hz
+ **********************************************************************************************************************/
+uint32_t r_soundtst_GetOutputRate (void)
+{
+    return (SOUND_PRV_OUTPUT_RATE);
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_GetOutputRate
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_SetDspConfig
+ * Description  : Reconfigures the playback DSP chain, the change is picked up at the next period
+ * Arguments    : const st_audio_dsp_config_t *p_config - settings
+ * Return Value : DEVDRV_SUCCESS, DEVDRV_ERROR if out of range or playback has not been initialised
+ **********************************************************************************************************************/
+int32_t r_soundtst_SetDspConfig (const st_audio_dsp_config_t *p_config)
+{
+    if (NULL == gs_dsp)
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    return (r_audio_dsp_configure(gs_dsp, p_config));
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_SetDspConfig
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_GetDspConfig
+ * Description  : Reads the playback DSP chain settings
+ * Arguments    : st_audio_dsp_config_t *p_config - destination, defaults if playback has not been initialised
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_soundtst_GetDspConfig (st_audio_dsp_config_t *p_config)
+{
+    if (NULL == gs_dsp)
+    {
+        r_audio_dsp_default_config(p_config);
+    }
+    else
+    {
+        r_audio_dsp_get_config(gs_dsp, p_config);
+    }
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_GetDspConfig
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_StartNetwork
+ * Description  : Binds the RTP receiver and starts the play task on it, in place of the loaded file
+ * Arguments    : uint16_t port - UDP port, 0 for AUDIO_RTP_DEFAULT_PORT
+ * Return Value : DEVDRV_SUCCESS, DEVDRV_ERROR if playback has not been initialised, a track is playing, the network
+ *                is not built in or the port could not be bound
+ **********************************************************************************************************************/
+int32_t r_soundtst_StartNetwork (uint16_t port)
+{
+#if (R_SELF_LOAD_MIDDLEWARE_ETHERNET_MODULES)
+    st_audio_rtp_config_t config;
+
+    if ((NULL == gsp_sound_control_t) || (NULL == gsp_sound_control_t->p_play_ring) || (NULL != gs_rtp)
+            || (EV_SET == R_OS_EventState( &gsp_sound_control_t->task_play)))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    r_audio_rtp_default_config( &config);
+
+    if (0u != port)
+    {
+        config.port = port;
+    }
+
+    gs_rtp = r_audio_rtp_create( &config);
+
+    if (NULL == gs_rtp)
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    gs_network_playing = true;
+    R_OS_SetEvent( &gsp_sound_control_t->task_play);
+
+    return (DEVDRV_SUCCESS);
+#else
+    UNUSED_PARAM(port);
+
+    return (DEVDRV_ERROR);
+#endif
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_StartNetwork
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_StopNetwork
+ * Description  : Stops the play task and frees the receiver once the reader has let go of it. The stop is repeated
+ *                because the play task clears stale stop requests when it picks up a new start.
+ * Arguments    : none
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_soundtst_StopNetwork (void)
+{
+#if (R_SELF_LOAD_MIDDLEWARE_ETHERNET_MODULES)
+    if (NULL == gs_rtp)
+    {
+        return;
+    }
+
+    while (false != gs_network_playing)
+    {
+        R_OS_SetEvent( &gsp_sound_control_t->task_stop);
+        R_OS_TaskSleep(gsp_sound_control_t->ul_delaytime_ms);
+    }
+
+    r_audio_rtp_destroy(gs_rtp);
+    gs_rtp = NULL;
+#endif
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_StopNetwork
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_GetNetworkStats
+ * Description  : Copies the receiver and jitter buffer statistics, including end to end latency and underruns
+ * Arguments    : st_audio_rtp_stats_t *p_stats - destination
+ * Return Value : DEVDRV_SUCCESS, DEVDRV_ERROR if the receiver is not running
+ **********************************************************************************************************************/
+int32_t r_soundtst_GetNetworkStats (st_audio_rtp_stats_t *p_stats)
+{
+#if (R_SELF_LOAD_MIDDLEWARE_ETHERNET_MODULES)
+    if (NULL == gs_rtp)
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    r_audio_rtp_get_stats(gs_rtp, p_stats);
+
+    return (DEVDRV_SUCCESS);
+#else
+    UNUSED_PARAM(p_stats);
+
+    return (DEVDRV_ERROR);
+#endif
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_GetNetworkStats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_ResetNetworkStats
+ * Description  : Clears the receiver and jitter buffer counters
+ * Arguments    : none
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_soundtst_ResetNetworkStats (void)
+{
+#if (R_SELF_LOAD_MIDDLEWARE_ETHERNET_MODULES)
+    if (NULL != gs_rtp)
+    {
+        r_audio_rtp_reset_stats(gs_rtp);
+    }
+#endif
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_ResetNetworkStats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_StartUsb
+ * Description  : Opens the USB audio function and starts the play task on it, in place of the loaded file. The play
+ *                task keeps running while the host is silent, it only prefills again when frames arrive.
+ * Arguments    : none
+ * Return Value : DEVDRV_SUCCESS, DEVDRV_ERROR if playback has not been initialised, a track is playing, USB audio is
+ *                not built in or the function could not be started
+ **********************************************************************************************************************/
+int32_t r_soundtst_StartUsb (void)
+{
+#if (R_SELF_INSERT_APP_USB_AUDIO)
+    if ((NULL == gsp_sound_control_t) || (NULL == gsp_sound_control_t->p_play_ring) || (gs_usb_handle >= 0)
+            || (EV_SET == R_OS_EventState( &gsp_sound_control_t->task_play)))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    gs_usb_handle = open(DEVICE_INDENTIFIER "usbf0_audio", O_RDWR);
+
+    if (gs_usb_handle < 0)
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    if (0 != control(gs_usb_handle, CTL_USBF_START, NULL))
+    {
+        close(gs_usb_handle);
+        gs_usb_handle = -1;
+        return (DEVDRV_ERROR);
+    }
+
+    gs_usb_playing = true;
+    R_OS_SetEvent( &gsp_sound_control_t->task_play);
+
+    return (DEVDRV_SUCCESS);
+#else
+    return (DEVDRV_ERROR);
+#endif
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_StartUsb
+ **********************************************************************************************************************/
 
-            /* Update SSIF configuration */
-            control(gs_ssif_handle, R_SSIF_AIO_WRITE_CONTROL, (void *) &tx_aiocb[div]);
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_StopUsb
+ * Description  : Stops the play task, then detaches from the bus and closes the USB audio function
+ * Arguments    : none
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_soundtst_StopUsb (void)
+{
+#if (R_SELF_INSERT_APP_USB_AUDIO)
+    if (gs_usb_handle < 0)
+    {
+        return;
+    }
 
-            /* write from block to SSIF */
-            write(gs_ssif_handle, &gsp_sound_control_t->p_playback_data[txi_data * REC_DMA_SIZE_PRV_],
-            REC_DMA_SIZE_PRV_);
+    while (false != gs_usb_playing)
+    {
+        R_OS_SetEvent( &gsp_sound_control_t->task_stop);
+        R_OS_TaskSleep(gsp_sound_control_t->ul_delaytime_ms);
+    }
 
-            /* update tx buffer/message tracking variables */
-            txi_data++;
-            txi_aio++;
+    control(gs_usb_handle, CTL_USBF_STOP, NULL);
+    close(gs_usb_handle);
+    gs_usb_handle = -1;
+#endif
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_StopUsb
+ **********************************************************************************************************************/
 
-            /* check for buffer boundary overflow */
-            if ((SIZEOF_WAVEDATA_RECPLAY_PRV_ / REC_DMA_SIZE_PRV_) < txi_data)
-            {
-                txi_data = 0;
-            }
+#if (R_SELF_INSERT_APP_USB_AUDIO)
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_GetUsbStats
+ * Description  : Copies the USB stream counters and converts the buffered level into output latency
+ * Arguments    : st_usbf_audio_stats_t *p_stats - destination
+ *                uint32_t *p_latency_us - buffered audio from the USB FIFO to the SSIF, may be NULL
+ * Return Value : DEVDRV_SUCCESS, DEVDRV_ERROR if the function is not open
+ **********************************************************************************************************************/
+int32_t r_soundtst_GetUsbStats (st_usbf_audio_stats_t *p_stats, uint32_t *p_latency_us)
+{
+    if ((gs_usb_handle < 0) || (0 != control(gs_usb_handle, CTL_USBF_GET_AUDIO_STATS, p_stats)))
+    {
+        return (DEVDRV_ERROR);
+    }
 
-            gs_tx_set_flag = false;
-        }
+    if (NULL != p_latency_us)
+    {
+        (*p_latency_us) = (uint32_t) (((uint64_t) p_stats->level * 1000000uLL) / USBF_AUDIO_SAMPLE_RATE);
     }
+
+    return (DEVDRV_SUCCESS);
 }
 /***********************************************************************************************************************
- End of function task_playback_sound_demo
+ End of function r_soundtst_GetUsbStats
  **********************************************************************************************************************/
+#endif
 
 /***********************************************************************************************************************
  * Function Name: r_soundtst_PlaySample_init
@@ -516,6 +2282,8 @@ void r_soundtst_PlayBack_init ( void )
 
 void r_soundtst_PlaySample (void)
 {
+    gs_request_index = 0u;
+    gs_request_ms = 0u;
     R_OS_SetEvent( &gsp_sound_control_t->task_play);
 }
 
@@ -530,14 +2298,308 @@ void r_soundtst_StopSample (void)
 }
 
 int r_soundtst_LoadSample (FIL* fp ) {
-	if ( fp != 0) {
-		AnalyzeHeader(NULL, NULL, NULL, 0, fp);
-	} else {
-		m_wav_fp = NULL;
-	}
+	/* the format is probed when the track is played */
+	m_wav_fp = fp;
 	return 0;
 }
 
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_PlaylistAdd
+ * Description  : Appends a file to the playlist. Entries added while the last track plays are still picked up by
+ *                the loader, so a queue can be fed one track at a time.
+ * Arguments    : const char_t *p_path - file, "A:\\dir\\file.wav"
+ * Return Value : index of the entry, DEVDRV_ERROR if the playlist is full or playback has not been initialised
+ **********************************************************************************************************************/
+int32_t r_soundtst_PlaylistAdd (const char_t *p_path)
+{
+    int32_t index = DEVDRV_ERROR;
+    size_t length;
+    char_t *p_copy;
+
+    if ((NULL == gsp_sound_control_t) || (NULL == gsp_sound_control_t->p_playlist_mutex) || (NULL == p_path))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    length = strlen(p_path);
+
+    if ((0u == length) || (length >= SOUND_PRV_PLAYLIST_MAX_PATH))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    p_copy = R_OS_AllocMem(length + 1u, R_REGION_LARGE_CAPACITY_RAM);
+
+    if (NULL == p_copy)
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    memcpy(p_copy, p_path, length + 1u);
+
+    R_OS_AcquireMutex(gsp_sound_control_t->p_playlist_mutex);
+
+    if (gs_playlist_count < SOUND_PRV_PLAYLIST_MAX_TRACKS)
+    {
+        index = (int32_t) gs_playlist_count;
+        gs_playlist[gs_playlist_count] = p_copy;
+        gs_playlist_count++;
+        p_copy = NULL;
+    }
+
+    R_OS_ReleaseMutex(gsp_sound_control_t->p_playlist_mutex);
+
+    if (NULL != p_copy)
+    {
+        R_OS_FreeMem(p_copy);
+    }
+    else if (EV_SET == R_OS_EventState( &gsp_sound_control_t->task_play))
+    {
+        /* the loader may be idle with a free slot */
+        R_OS_ReleaseSemaphore( &gsp_sound_control_t->loader_semaphore);
+    }
+
+    return (index);
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_PlaylistAdd
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_PlaylistClear
+ * Description  : Empties the playlist. The tracks already opened play to the end, nothing is opened after them.
+ * Arguments    : none
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_soundtst_PlaylistClear (void)
+{
+    uint32_t index;
+
+    if ((NULL == gsp_sound_control_t) || (NULL == gsp_sound_control_t->p_playlist_mutex))
+    {
+        return;
+    }
+
+    R_OS_AcquireMutex(gsp_sound_control_t->p_playlist_mutex);
+
+    for (index = 0u; index < gs_playlist_count; index++)
+    {
+        R_OS_FreeMem(gs_playlist[index]);
+        gs_playlist[index] = NULL;
+    }
+
+    gs_playlist_count = 0u;
+
+    R_OS_ReleaseMutex(gsp_sound_control_t->p_playlist_mutex);
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_PlaylistClear
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_PlaylistGetCount
+ * Description  : Number of entries in the playlist
+ * Arguments    : none
+ * Return Value : entries
+ **********************************************************************************************************************/
+uint32_t r_soundtst_PlaylistGetCount (void)
+{
+    return (gs_playlist_count);
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_PlaylistGetCount
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_PlaylistGetPath
+ * Description  : Copies the path of a playlist entry
+ * Arguments    : uint32_t index - entry
+ *                char_t *p_path - destination
+ *                uint32_t size - bytes at p_path
+ * Return Value : DEVDRV_SUCCESS, DEVDRV_ERROR if there is no such entry
+ **********************************************************************************************************************/
+int32_t r_soundtst_PlaylistGetPath (uint32_t index, char_t *p_path, uint32_t size)
+{
+    int32_t res = DEVDRV_ERROR;
+
+    if ((NULL == gsp_sound_control_t) || (NULL == gsp_sound_control_t->p_playlist_mutex) || (NULL == p_path)
+            || (0u == size))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    R_OS_AcquireMutex(gsp_sound_control_t->p_playlist_mutex);
+
+    if (index < gs_playlist_count)
+    {
+        strncpy(p_path, gs_playlist[index], size - 1u);
+        p_path[size - 1u] = '\0';
+        res = DEVDRV_SUCCESS;
+    }
+
+    R_OS_ReleaseMutex(gsp_sound_control_t->p_playlist_mutex);
+
+    return (res);
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_PlaylistGetPath
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_PlaylistPlay
+ * Description  : Plays the playlist from an entry and a position in it. When playback is already running the periods
+ *                queued to the SSIF play out and the play task starts again from the new position, the SSIF driver
+ *                is not closed. With an empty playlist the file from r_soundtst_LoadSample is used.
+ * Arguments    : uint32_t index - entry to start from
+ *                uint32_t position_ms - position in that entry
+ * Return Value : DEVDRV_SUCCESS, DEVDRV_ERROR if playback has not been initialised, there is no such entry or the
+ *                network or USB stream is playing
+ **********************************************************************************************************************/
+int32_t r_soundtst_PlaylistPlay (uint32_t index, uint32_t position_ms)
+{
+    if ((NULL == gsp_sound_control_t) || (NULL == gsp_sound_control_t->p_play_ring) || (NULL != gs_rtp)
+            || ((index >= gs_playlist_count) && ((0u != index) || (NULL == m_wav_fp))))
+    {
+        return (DEVDRV_ERROR);
+    }
+
+#if (R_SELF_INSERT_APP_USB_AUDIO)
+    if (gs_usb_handle >= 0)
+    {
+        return (DEVDRV_ERROR);
+    }
+#endif
+
+    gs_request_index = index;
+    gs_request_ms = position_ms;
+
+    /* pending first, the play task resets task_play before it looks for requests */
+    gs_request_pending = true;
+
+    if (EV_SET == R_OS_EventState( &gsp_sound_control_t->task_play))
+    {
+        R_OS_ReleaseSemaphore( &gsp_sound_control_t->playback_semaphore);
+    }
+    else
+    {
+        R_OS_SetEvent( &gsp_sound_control_t->task_play);
+    }
+
+    return (DEVDRV_SUCCESS);
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_PlaylistPlay
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_PlaylistStop
+ * Description  : Stops playback once the periods queued to the SSIF have played
+ * Arguments    : none
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_soundtst_PlaylistStop (void)
+{
+    if ((NULL != gsp_sound_control_t) && (EV_SET == R_OS_EventState( &gsp_sound_control_t->task_play)))
+    {
+        R_OS_SetEvent( &gsp_sound_control_t->task_stop);
+    }
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_PlaylistStop
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_Seek
+ * Description  : Moves the playhead within the track being heard
+ * Arguments    : uint32_t position_ms - position in the track
+ * Return Value : DEVDRV_SUCCESS, DEVDRV_ERROR if nothing is playing from the playlist
+ **********************************************************************************************************************/
+int32_t r_soundtst_Seek (uint32_t position_ms)
+{
+    st_sound_position_t position;
+
+    if (NULL == gsp_sound_control_t)
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    read_position( &position);
+
+    if (false == position.playing)
+    {
+        return (DEVDRV_ERROR);
+    }
+
+    return (r_soundtst_PlaylistPlay(position.track, position_ms));
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_Seek
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_GetPosition
+ * Description  : Reads the playhead, taken from the DMA end count so it follows what the DAC is playing rather than
+ *                what the reader has decoded
+ * Arguments    : st_sound_position_t *p_position - destination, playing is false when stopped
+ * Return Value : none
+ **********************************************************************************************************************/
+void r_soundtst_GetPosition (st_sound_position_t *p_position)
+{
+    if (NULL != p_position)
+    {
+        read_position(p_position);
+    }
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_GetPosition
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_PositionChanged
+ * Description  : Polls the position event, cleared by the call
+ * Arguments    : st_sound_position_t *p_position - destination for the playhead when the event was set, may be NULL
+ * Return Value : true if the playhead moved, changed track, started or stopped since the last call
+ **********************************************************************************************************************/
+bool_t r_soundtst_PositionChanged (st_sound_position_t *p_position)
+{
+    if ((NULL == gsp_sound_control_t) || (EV_SET != R_OS_EventState( &gsp_sound_control_t->position_changed)))
+    {
+        return (false);
+    }
+
+    R_OS_ResetEvent( &gsp_sound_control_t->position_changed);
+    r_soundtst_GetPosition(p_position);
+
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_PositionChanged
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: r_soundtst_WaitPosition
+ * Description  : Blocks until the position event is set, then clears it
+ * Arguments    : st_sound_position_t *p_position - destination for the playhead, may be NULL
+ *                uint32_t timeout_ms - longest wait
+ * Return Value : true if the event was set, false on time out
+ **********************************************************************************************************************/
+bool_t r_soundtst_WaitPosition (st_sound_position_t *p_position, uint32_t timeout_ms)
+{
+    if ((NULL == gsp_sound_control_t)
+            || (false == R_OS_WaitForEvent( &gsp_sound_control_t->position_changed, timeout_ms)))
+    {
+        return (false);
+    }
+
+    R_OS_ResetEvent( &gsp_sound_control_t->position_changed);
+    r_soundtst_GetPosition(p_position);
+
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function r_soundtst_WaitPosition
+ **********************************************************************************************************************/
+
 /***********************************************************************************************************************
  * Function Name: play_file_data
  * Description  :
@@ -629,6 +2691,13 @@ static void setup_playback ( FILE *p_in, FILE *p_out )
             gsp_sound_control_t->playback_semaphore = gsp_sound_control_t->record_semaphore;
         }
 
+        /* counting semaphore the DMA completions wake the record/playback task with */
+        if ((DEVDRV_SUCCESS == res)
+                && (true != R_OS_CreateSemaphore((semaphore_t) &gsp_sound_control_t->period_semaphore, 0)))
+        {
+            res = DEVDRV_ERROR;
+        }
+
         if (DEVDRV_SUCCESS == res)
         {
             /* open SSIF driver for read and write */
@@ -650,7 +2719,7 @@ static void setup_playback ( FILE *p_in, FILE *p_out )
         /* Sound - set sampling rate */
         if (DEVDRV_SUCCESS == res)
         {
-            res = R_SOUND_SetSamplingRate(STREAM_IT_SOUND_CHANNEL_PRV_, SOUND_FREQ_44100);
+            res = R_SOUND_SetSamplingRate(STREAM_IT_SOUND_CHANNEL_PRV_, SOUND_PRV_OUTPUT_RATE);
         }
 
         /* Sound - set Volume in percent */
@@ -741,235 +2810,28 @@ static void close_audio (void)
  End of function close_audio
  ******************************************************************************/
 
-/*******************************************************************************
- * Function Name: AnalyzeHeader
- * Description  : Decides Wave File Header
- * Arguments    : void
- * @param uint8_t*  p_title     : title tag buffer
- * @param uint8_t*  p_artist    : artist tag buffer
- * @param uint8_t*  p_album     : album tag buffer
- * @param uint16_t  tag_size    : tag buffer size
- * @param FIL       fp          : file pointer
- * @return true = success, false = failure
-
- ******************************************************************************/
-static bool_t AnalyzeHeader(uint8_t * p_title, uint8_t * p_artist, uint8_t * p_album, uint16_t tag_size, FIL * fp) {
-
-    bool_t result = false;
-    size_t read_size;
-    uint8_t wk_read_buff[36];
-    uint8_t *data;
-    uint32_t chunk_size;
-    uint32_t sub_chunk_size;
-    uint32_t list_index_max;
-    bool_t list_ok = false;
-    uint32_t read_index = 0;
-    uint32_t data_index = 0;
-    uint16_t wk_len;
-
-    if (fp == NULL) {
-        return false;
-    }
-    m_music_data_size  = 0;
-    m_music_data_index = 0;
-    m_wav_fp = fp;
-    if (p_title != NULL) {
-        p_title[0] = '\0';
-    }
-    if (p_artist != NULL) {
-        p_artist[0] = '\0';
-    }
-    if (p_album != NULL) {
-        p_album[0] = '\0';
-    }
-
-    f_read( m_wav_fp, &wk_read_buff[0], 36, &read_size );
-    if (read_size < 36) {
-        // do nothing
-    } else if (memcmp(&wk_read_buff[0], "RIFF", 4) != 0) {
-        // do nothing
-    } else if (memcmp(&wk_read_buff[8], "WAVE", 4) != 0) {
-        // do nothing
-    } else if (memcmp(&wk_read_buff[12], "fmt ", 4) != 0) {
-        // do nothing
-    } else {
-        // Parse Format Sub-chunk 1
-        read_index += 36;
-        m_channel = ((uint32_t)wk_read_buff[22] << 0) + ((uint32_t)wk_read_buff[23] << 8);
-        m_sampling_rate = ((uint32_t)wk_read_buff[24] << 0)
-                      + ((uint32_t)wk_read_buff[25] << 8)
-                      + ((uint32_t)wk_read_buff[26] << 16)
-                      + ((uint32_t)wk_read_buff[27] << 24);
-        m_block_size = ((uint32_t)wk_read_buff[34] << 0) + ((uint32_t)wk_read_buff[35] << 8);
-        {
-            uint32_t subchunksize;
-            subchunksize = ((uint32_t)wk_read_buff[16] << 0)
-                         + ((uint32_t)wk_read_buff[17] << 8)
-                         + ((uint32_t)wk_read_buff[18] << 16)
-                         + ((uint32_t)wk_read_buff[19] << 24);
-            if( subchunksize > 16 )
-            {
-                subchunksize -= 16;
-                f_read( m_wav_fp, &wk_read_buff[0], subchunksize, &read_size );
-                read_index += subchunksize;
-            }
-        }
-        while (1) {
-        	// Parsse Sub-chunk II .....
-            f_read( m_wav_fp, &wk_read_buff[0], 8, &read_size );
-            read_index += 8;
-            if (read_size < 8) {
-                break;
-            } else {
-                chunk_size = ((uint32_t)wk_read_buff[4] << 0)
-                           + ((uint32_t)wk_read_buff[5] << 8)
-                           + ((uint32_t)wk_read_buff[6] << 16)
-                           + ((uint32_t)wk_read_buff[7] << 24);
-                if (memcmp(&wk_read_buff[0], "data", 4) == 0) {
-                    result = true;
-                    m_music_data_size = chunk_size;
-                    if (list_ok == true) {
-                        break;
-                    } else {
-                        data_index = read_index;
-                        f_lseek(m_wav_fp, f_tell(m_wav_fp) + chunk_size);
-                        read_index += chunk_size;
-                    }
-                } else if (memcmp(&wk_read_buff[0], "LIST", 4) == 0) {
-                    list_ok = true;
-                    list_index_max = read_index + chunk_size;
-                    f_read( m_wav_fp, &wk_read_buff[0], 4, &read_size );
-                    read_index += 4;
-                    while (read_index < list_index_max) {
-                        f_read( m_wav_fp, &wk_read_buff[0], 8, &read_size );
-                        read_index += 8;
-                        if (read_size < 8) {
-                            break;
-                        } else if (memcmp(&wk_read_buff[0], "INAM", 4) == 0) {
-                            data = p_title;
-                        } else if (memcmp(&wk_read_buff[0], "IART", 4) == 0) {
-                            data = p_artist;
-                        } else if (memcmp(&wk_read_buff[0], "IPRD", 4) == 0) {
-                            data = p_album;
-                        } else {
-                            data = NULL;
-                        }
-                        if ((data != NULL) && (tag_size != 0)) {
-                            sub_chunk_size = ((uint32_t)wk_read_buff[4] << 0)
-                                           + ((uint32_t)wk_read_buff[5] << 8)
-                                           + ((uint32_t)wk_read_buff[6] << 16)
-                                           + ((uint32_t)wk_read_buff[7] << 24);
-                            if (sub_chunk_size > (tag_size - 1)) {
-                                wk_len = (tag_size - 1);
-                            } else {
-                                wk_len = sub_chunk_size;
-                            }
-                            f_read( m_wav_fp, &wk_read_buff[0], wk_len, &read_size );
-                            read_index += sub_chunk_size;
-                            f_lseek(m_wav_fp, read_index);
-                            data[wk_len] = '\0';
-                        }
-                    }
-                    if (data_index != 0) {
-                        break;
-                    } else {
-                        f_lseek(m_wav_fp, list_index_max);
-                    }
-                } else {
-                    f_lseek(m_wav_fp, f_tell(m_wav_fp) + chunk_size);
-                    read_index += chunk_size;
-                }
-            }
-        }
-
-        if (data_index != 0) {
-            f_lseek(m_wav_fp, data_index);
-        }
-    }
-
-    return result;
-};
-
-
-/*******************************************************************************
- * Function Name: GetNextData
- * Description  : Index through wave file
- * @param void*     buf     : data buffer address
- * @param size_t    len     : data buffer length
- * @return get data size
-
- ******************************************************************************/
-
-static size_t GetNextData(void *buf, size_t len) {
-    size_t ret;
-
-    if (m_block_size == 24) {
-        // 24 Bit word contains 16 bit data + 8 bit padding
-        // Add padding
-        int write_index = 0;
-        int wavfile_index;
-        int read_len;
-        int pading_index = 0;
-        uint8_t * p_buf = (uint8_t *)buf;
-
-
-        if ((m_music_data_index + len) > m_music_data_size) {
-            len = m_music_data_size - m_music_data_index;
-        }
-        while (write_index < len) {
-            read_len = (len - write_index) * 3 / 4;
-            if (read_len > sizeof(m_wk_wavfile_buff)) {
-                read_len = sizeof(m_wk_wavfile_buff);
-            }
-            m_music_data_index += read_len;
-            f_read( m_wav_fp, m_wk_wavfile_buff, read_len, &ret );
-            if (ret < read_len) {
-                break;
-            }
-            wavfile_index = 0;
-            while ((write_index < len) && (wavfile_index < read_len)) {
-                if (pading_index == 0) {
-                    p_buf[write_index] = 0;
-                } else {
-                    p_buf[write_index] = m_wk_wavfile_buff[wavfile_index];
-                    wavfile_index++;
-                }
-                if (pading_index < 3) {
-                    pading_index++;
-                } else {
-                    pading_index = 0;
-                }
-                write_index++;
-            }
-        }
-
-        return write_index;
-    } else {
-        // 16 bit word no padding
-        if ((m_music_data_index + len) > m_music_data_size) {
-            len = m_music_data_size - m_music_data_index;
-        }
-        m_music_data_index += len;
-        f_read( m_wav_fp, buf, (int)len, &ret );
-        return ret;
-    }
-};
-
 /**************************************************************************//**
  * Function Name: userdef_tx_callback
  * @brief         SSIF driver : transfer request end callback function
  *
  *                Description:<br>
- *                SCIF transmit request end callback function
+ *                SCIF transmit request end callback function, runs in the
+ *                DMA end interrupt and wakes the record/playback task
  * @param[in]     signo.sival_ptr : semaphore id
  * @retval        none
  ******************************************************************************/
 static void userdef_tx_callback (union sigval signo)
 {
-    /* function argument is unused */
-    UNUSED_PARAM(signo);
+    BaseType_t woken = pdFALSE;
+
+    gs_period_time_stamp = SOUND_PRV_TIME_STAMP();
+    gs_tx_complete_count++;
+
+    /* cast semaphore_t used by OS abstraction to SemaphoreHandle_t used by FreeRTOS */
+    xSemaphoreGiveFromISR((SemaphoreHandle_t) (*(uint32_t *) signo.sival_ptr), &woken);
 
-    gs_tx_set_flag = true;
+    /* switch straight to the audio task rather than waiting for the next tick */
+    portYIELD_FROM_ISR(woken);
 }
 /*******************************************************************************
  End of function userdef_tx_callback
@@ -980,17 +2842,23 @@ static void userdef_tx_callback (union sigval signo)
  * @brief         SSIF driver : receive request end callback function
  *
  *                Description:<br>
- *                SCIF receive request end callback function
+ *                SCIF receive request end callback function, runs in the
+ *                DMA end interrupt and wakes the record/playback task
  * @param[in]     signo.sival_ptr : semaphore id
  * @retval        none
  ******************************************************************************/
 static void userdef_rx_callback (union sigval signo)
 {
-    /* function argument is unused */
-    UNUSED_PARAM(signo);
+    BaseType_t woken = pdFALSE;
 
-    gs_rx_set_flag = true;
-    gs_rx_first_return_flag = true;
+    gs_period_time_stamp = SOUND_PRV_TIME_STAMP();
+    gs_rx_complete_count++;
+
+    /* cast semaphore_t used by OS abstraction to SemaphoreHandle_t used by FreeRTOS */
+    xSemaphoreGiveFromISR((SemaphoreHandle_t) (*(uint32_t *) signo.sival_ptr), &woken);
+
+    /* switch straight to the audio task rather than waiting for the next tick */
+    portYIELD_FROM_ISR(woken);
 }
 /*******************************************************************************
  End of function userdef_rx_callback
@@ -1008,7 +2876,15 @@ static void userdef_rx_callback (union sigval signo)
  ******************************************************************************/
 static void userdef_aio_callback (union sigval signo)
 {
-    R_OS_ReleaseSemaphore(signo.sival_ptr);
+    BaseType_t woken = pdFALSE;
+
+    /* period has left the SSIF, hand it back to the file reader */
+    r_audio_ring_release(gsp_sound_control_t->p_play_ring);
+    gs_frames_played += (WAVE_DMA_SIZE_PRV_ / AUDIO_CONVERT_DST_FRAME_BYTES);
+
+    /* cast semaphore_t used by OS abstraction to SemaphoreHandle_t used by FreeRTOS */
+    xSemaphoreGiveFromISR((SemaphoreHandle_t) (*(uint32_t *) signo.sival_ptr), &woken);
+    portYIELD_FROM_ISR(woken);
 }
 /*******************************************************************************
  End of function userdef_aio_callback
@@ -36,12 +36,15 @@ Includes   <System Includes> , "Project Includes"
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
-#include <math.h>
 #include "r_typedefs.h"
+#include "dev_drv.h"
 #include "compiler_settings.h"
 #include "r_switch_driver.h"
 #include "r_riic_dae6_if.h"
 #include "RegisterSet.h"
+#include "r_audio_gain.h"
+#include <renesas/application/soundbar_app/inc/r_soundbar.h>
+#include "nonVolatileData.h"
 
 #include "r_os_abstraction_api.h"
 #include "FreeRTOS.h"
@@ -89,8 +92,8 @@ typedef union {
 /******************************************************************************
 Macro definitions
 ******************************************************************************/
-#define DAE_REG_WR_INPUT_SELECT 0x00020001
-#define DAE_REG_RD_INPUT_SELECT 0x00020002
+#define DAE_REG_WR_INPUT_SELECT DAE6_REG_WR_INPUT_SELECT
+#define DAE_REG_RD_INPUT_SELECT DAE6_REG_RD_INPUT_SELECT
 #define DAE_REG_WR_VOLUME_CONTROL SharedVolume_1_VOL
 
 #define SW_POWER_BUTTON			P1_11
@@ -145,6 +148,15 @@ Macro definitions
 
 #define DEBOUNCE_DELAY	(100)
 
+// Shared volume, in quarter dB steps of the gain table
+#define VOLUME_DEFAULT_DB		(-50)
+#define VOLUME_BUTTON_STEP		AUDIO_GAIN_DB_TO_STEPS(1)
+
+// Largest change in one DAE write and the time between writes, 0.5 dB every 4 ms ramps the
+// whole range in under a second without an audible step
+#define VOLUME_RAMP_STEP_MAX	(2)
+#define VOLUME_RAMP_INTERVAL	(4)
+
 /******************************************************************************
 Imported global variables and functions (from other files)
 ******************************************************************************/
@@ -165,7 +177,13 @@ static void switch_callback ( int sense );
 
 static void r_sound_audio_input_select ( void );
 
-static void calculate_and_send_gain ( void );
+static void task_volume_ramp ( void );
+
+static void send_gain ( int32_t steps );
+
+static void set_volume_target ( int32_t steps );
+
+static void save_audio_settings ( void );
 
 static PinName g_button_pins[] = {
 	SW_VOLUME_UP_BUTTON,
@@ -175,7 +193,14 @@ static PinName g_button_pins[] = {
 	SW_BT_PAIRING_BUTTON
 };
 
-static int16_t g_Shared_Gain = -50;
+// Written by the switch task, followed by the ramp task
+static volatile int32_t g_volume_target = AUDIO_GAIN_DB_TO_STEPS(VOLUME_DEFAULT_DB);
+
+static uint32_t g_volume_semaphore;
+
+// Input applied by the next select press and the one applied last, saved so it is selected again at start up
+static intype_t g_input_select = INPUT_TYPE_LINE_IN;
+static intype_t g_input_applied = INPUT_TYPE_LINE_IN;
 
 static bool_t g_EnableIterrupts = false;
 
@@ -194,6 +219,8 @@ Exported global functions (to be accessed by other files)
 
 void r_sound_init_controls ( bool_t enble_interrupts ) {
 
+	NVAUDIO settings;
+
 	/*** Enable Power Stages ***/
 	// Enable power to 3.3v and 1.8v line
 	gpio_init ( BOARD_LV_EN_PIN );
@@ -225,6 +252,21 @@ void r_sound_init_controls ( bool_t enble_interrupts ) {
 	// Switch Message Queue
 	g_switch_queue = xQueueCreate ( 3, sizeof(void*));
 
+	// Volume and input from the last session, this is the one EEPROM read, later stores only touch RAM
+	if ( 0 == nvLoad( NVDT_AUDIO_SETTINGS_V1, &settings, sizeof(settings)) ) {
+		if ( (settings.sVolume <= 0) && (settings.sVolume >= AUDIO_GAIN_DB_TO_STEPS(AUDIO_GAIN_MIN_DB)) ) {
+			g_volume_target = settings.sVolume;
+		}
+		if ( settings.byInput <= INPUT_TYPE_WIFI ) {
+			g_input_select = (intype_t)settings.byInput;
+			g_input_applied = g_input_select;
+		}
+	}
+
+	// Volume Ramp Task, started first so the initial gain reaches the DAE before the first button press
+	R_OS_CreateSemaphore( &g_volume_semaphore, 0);
+	R_OS_CreateTask("Volume Ramp", task_volume_ramp, NULL, R_OS_ABSTRACTION_PRV_DEFAULT_STACK_SIZE, TASK_VOLUME_RAMP_PRI);
+
 	// Switch Task
 	R_OS_CreateTask("Soundbar Control", task_switch_listenter, NULL, R_OS_ABSTRACTION_PRV_DEFAULT_STACK_SIZE, TASK_SWITCH_TASK_PRI);
 
@@ -278,21 +320,18 @@ static void r_sound_power ( void ) {
 
 /***********************************************************************************************************************
  * Function Name: r_sound_volumeup
- * Description  : Initialize all the soundbar switches and leds
+ * Description  : Raises the shared volume by one step per press
  *
- * Arguments    : none
+ * Arguments    : presses - volume up presses coalesced by the debounce
  * Return Value : none
  **********************************************************************************************************************/
-static void r_sound_volumeup ( void ) {
+static void r_sound_volumeup ( int32_t presses ) {
 
 	// Turn on LED
 	gpio_write(LED_VOLUME_UP_PIN, 1);
 
-	// Calculate gain
-	if (++g_Shared_Gain > 0 ) {
-		g_Shared_Gain = 0;
-	}
-	calculate_and_send_gain();
+	// Move the target, the ramp task does the I2C
+	set_volume_target( g_volume_target + (presses * VOLUME_BUTTON_STEP));
 
 	// Wait 100 us this will This will allow the led to be visible
 	R_OS_TaskSleep(LED_HOLD_TIME);
@@ -306,22 +345,18 @@ static void r_sound_volumeup ( void ) {
 
 /***********************************************************************************************************************
  * Function Name: r_sound_volumedown
- * Description  : Initialize all the soundbar switches and leds
+ * Description  : Lowers the shared volume by one step per press
  *
- * Arguments    : none
+ * Arguments    : presses - volume down presses coalesced by the debounce
  * Return Value : none
  **********************************************************************************************************************/
-static void r_sound_volumedown ( void ) {
+static void r_sound_volumedown ( int32_t presses ) {
 
 	// Turn on LED
 	gpio_write(LED_VOLUME_DWN_PIN, 1);
 
-	// Calculate gain
-	if (--g_Shared_Gain < -100 ) {
-		g_Shared_Gain = -100;
-	}
-	calculate_and_send_gain();
-
+	// Move the target, the ramp task does the I2C
+	set_volume_target( g_volume_target - (presses * VOLUME_BUTTON_STEP));
 
 	// Wait 100 us this will This will allow the led to be visable
 	R_OS_TaskSleep(LED_HOLD_TIME);
@@ -341,7 +376,7 @@ static void r_sound_volumedown ( void ) {
  **********************************************************************************************************************/
 static void r_sound_audio_input_select ( void ) {
 
-	static intype_t in_select = INPUT_TYPE_LINE_IN;
+	intype_t in_select = g_input_select;
 
 	input_reg_t data;
 	data.dword = 0;
@@ -351,6 +386,10 @@ static void r_sound_audio_input_select ( void ) {
 	// Turn on LED
 	gpio_write(LED_AUDIO_INPUT_SELECT_PIN, 1);
 
+	// Leaving WIFI or USB, close the stream (nothing to do if it is not running)
+	r_soundtst_StopNetwork();
+	r_soundtst_StopUsb();
+
 	// Clear Source LEDs
 	gpio_write(LED_LINE_IN_PIN, 0);
 	gpio_write(LED_SPDIF_PIN, 0);
@@ -399,7 +438,13 @@ static void r_sound_audio_input_select ( void ) {
 			break;
 
 		case INPUT_TYPE_USB :
-			gpio_write(LED_USB_PIN, 1);
+			data.bit.ch12 = INPUT_TYPE_SSI;
+			data.bit.ch34 = INPUT_TYPE_SSI;
+			data.bit.ch56 = INPUT_TYPE_SSI;
+			data.bit.ch78 = INPUT_TYPE_SSI;
+
+			// USB audio function into the SSIF playback engine, the LED shows whether the host side started
+			gpio_write(LED_USB_PIN, (DEVDRV_SUCCESS == r_soundtst_StartUsb()) ? 1 : 0);
 			in_select = INPUT_TYPE_BT;
 			break;
 		case INPUT_TYPE_BT :
@@ -416,7 +461,9 @@ static void r_sound_audio_input_select ( void ) {
 			data.bit.ch34 = INPUT_TYPE_SSI;
 			data.bit.ch56 = INPUT_TYPE_SSI;
 			data.bit.ch78 = INPUT_TYPE_SSI;
-			gpio_write(LED_WIFI_PIN, 1);
+
+			// RTP stream into the SSIF playback engine, the LED shows whether the receiver started
+			gpio_write(LED_WIFI_PIN, (DEVDRV_SUCCESS == r_soundtst_StartNetwork(0u)) ? 1 : 0);
 			in_select = INPUT_TYPE_LINE_IN;
 			break;
 #if 0
@@ -432,6 +479,12 @@ static void r_sound_audio_input_select ( void ) {
 		default:
 			break;
 	}
+
+	// Remember the input just applied, it is selected again at the next start up
+	g_input_applied = g_input_select;
+	g_input_select = in_select;
+	save_audio_settings();
+
 #ifdef BUILD_CONFIG_RELEASE
 	if ( in_select != INPUT_TYPE_USB) {
 		// Send DAE-x Imput Select Command to i2C command to DAE-x
@@ -489,6 +542,7 @@ static void task_switch_listenter ( void ) {
 	static but_t last_msg;
 	bool_t ret;
 	static uint16_t ms;
+	int32_t volume_presses;
 
 	// Setup Control Leds
 	LED_INIT ( LED_POWER_PIN );
@@ -518,9 +572,8 @@ static void task_switch_listenter ( void ) {
 	R_SWITCH_Init(SW_BT_PAIRING_BUTTON, 	NULL);
 #endif
 
-	// Initialize DAE
+	// Initialize DAE, the ramp task has already sent the gain
 	r_sound_audio_input_select();
-	calculate_and_send_gain();
 
 
 	while (1) {
@@ -528,9 +581,17 @@ static void task_switch_listenter ( void ) {
 		// Waitl for message Queue
 		ret = xQueueReceive( g_switch_queue, (void*)&current_msg, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE );
 		last_msg = current_msg;
+		volume_presses = 0;
 
 		// Filter debouce
 		while(ret ) {
+			// Count volume presses so a burst becomes one move of the target instead of being dropped
+			if ( BUTTON_PRESS_VOLUP == current_msg ) {
+				volume_presses++;
+			} else if ( BUTTON_PRESS_VOLDWN == current_msg ) {
+				volume_presses--;
+			}
+
 			// Read Queue for addtional message every 10ms till queue is empty
 			ret = xQueueReceive( g_switch_queue, (void*)&current_msg, 10 );
 		}
@@ -555,10 +616,12 @@ static void task_switch_listenter ( void ) {
 				r_sound_power();
 				break;
 			case BUTTON_PRESS_VOLUP:
-				r_sound_volumeup();
-				break;
 			case BUTTON_PRESS_VOLDWN:
-				r_sound_volumedown();
+				if ( volume_presses > 0 ) {
+					r_sound_volumeup( volume_presses );
+				} else if ( volume_presses < 0 ) {
+					r_sound_volumedown( -volume_presses );
+				}
 				break;
 			case BUTTON_PRESS_BTPAIR:
 				r_sound_bt_pairing();
@@ -612,32 +675,110 @@ static void switch_callback ( int sense )
  **********************************************************************************************************************/
 
 /***********************************************************************************************************************
- * Function Name: calculate_and_send_gain
- * Description  : Calculates the hex value of the shared gain based on Normal Polarity ( -100 db to 0 db).
+ * Function Name: set_volume_target
+ * Description  : Clamps a new shared volume to the gain table and wakes the ramp task.
+ *
+ * Arguments    : steps - volume in quarter dB, 0 or below
+ * Return Value : none
+ **********************************************************************************************************************/
+static void set_volume_target ( int32_t steps ) {
+
+	if ( steps > 0 ) {
+		steps = 0;
+	}
+	if ( steps < AUDIO_GAIN_DB_TO_STEPS(AUDIO_GAIN_MIN_DB) ) {
+		steps = AUDIO_GAIN_DB_TO_STEPS(AUDIO_GAIN_MIN_DB);
+	}
+
+	g_volume_target = steps;
+	R_OS_ReleaseSemaphore( &g_volume_semaphore );
+
+	// Only the RAM copy changes here, the EEPROM is written in the background once the presses stop
+	save_audio_settings();
+}
+/***********************************************************************************************************************
+ End of function set_volume_target
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: save_audio_settings
+ * Description  : Stores the volume target and the input last applied. Does not wait for the EEPROM.
+ *
+ * Arguments    : none
+ * Return Value : none
+ **********************************************************************************************************************/
+static void save_audio_settings ( void ) {
+
+	NVAUDIO settings;
+
+	settings.sVolume = (int16_t)g_volume_target;
+	settings.byInput = (uint8_t)g_input_applied;
+	settings.byReserved = 0;
+
+	nvStore( NVDT_AUDIO_SETTINGS_V1, &settings, sizeof(settings));
+}
+/***********************************************************************************************************************
+ End of function save_audio_settings
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: task_volume_ramp
+ * Description  : Moves the DAE shared volume towards the target no faster than VOLUME_RAMP_STEP_MAX per
+ *                VOLUME_RAMP_INTERVAL. The target is re-read before every write, so presses that arrive
+ *                during a ramp extend it rather than starting a new sequence.
  *
  * Arguments    : none
  * Return Value : none
  **********************************************************************************************************************/
-static void calculate_and_send_gain ( void ) {
+static void task_volume_ramp ( void ) {
 
-	float TWO2TWEENTYTHIRD = 8388608;
-	float value = 0;
-	int32_t data = 0;
+	int32_t current = g_volume_target;
+	int32_t step;
 
-	// Calculate the New Shared Volume Gain
-	value = g_Shared_Gain / 20;
-	value = pow(10.0, value);
-	value *= TWO2TWEENTYTHIRD * -1;
-	data = (int32_t)value;
+	send_gain( current );
+
+	while (1) {
+		R_OS_WaitForSemaphore( &g_volume_semaphore, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE );
+
+		while ( current != g_volume_target ) {
+			step = g_volume_target - current;
+
+			if ( step > VOLUME_RAMP_STEP_MAX ) {
+				step = VOLUME_RAMP_STEP_MAX;
+			} else if ( step < -VOLUME_RAMP_STEP_MAX ) {
+				step = -VOLUME_RAMP_STEP_MAX;
+			}
+
+			current += step;
+			send_gain( current );
+
+			R_OS_TaskSleep( VOLUME_RAMP_INTERVAL );
+		}
+	}
+}
+/***********************************************************************************************************************
+ End of function task_volume_ramp
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: send_gain
+ * Description  : Writes the shared gain to the DAE in Normal Polarity ( -100 db to 0 db).
+ *
+ * Arguments    : steps - volume in quarter dB
+ * Return Value : none
+ **********************************************************************************************************************/
+static void send_gain ( int32_t steps ) {
+
+	// Normal Polarity is the negated Q23 gain
+	int32_t data = -r_audio_gain_q23( steps );
 
 #ifdef BUILD_CONFIG_RELEASE
 	// Send Volume Command to i2C command to DAE-x
-	// Send DAE-x Imput Select Command to i2C command to DAE-x
 	r_riic_dae6_Write( DAE_REG_WR_VOLUME_CONTROL, (uint8_t*)&data);
+#else
+	(void)data;
 #endif
-
-
 }
 /***********************************************************************************************************************
- End of function calculate_and_send_gain
+ End of function send_gain
  **********************************************************************************************************************/
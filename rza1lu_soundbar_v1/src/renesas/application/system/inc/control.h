@@ -253,6 +253,14 @@ typedef enum _CTLCODE
     CTL_USBF_SEND_HID_REPORTIN,
     CTL_USBF_START,
     CTL_USBF_STOP,
+    CTL_ETHER_READ_BATCH,
+    CTL_ETHER_RELEASE_FRAME,
+    CTL_ETHER_WRITE_GATHER,
+    CTL_ETHER_RECLAIM_TX,
+    CTL_SET_SPEAKER_SAMPLE_RATE,
+    CTL_GET_SPEAKER_STATUS,
+    CTL_USBF_SET_AUDIO_SINK,
+    CTL_USBF_GET_AUDIO_STATS,
     /* TODO: add device specific control functions here */
     /* must be last control code, dynamic driver will reuse
        control code from this point forward */
@@ -551,10 +559,39 @@ typedef struct _SPKDAT
     short           siMinVol;
     short           siVolSteps;
     short           siStepSize;
+    short           siCurVol;
     uint8_t         bfMute;
 } SPKDAT,
 *PSPKDAT;
 
+/** Control structure for CTL_GET_SPEAKER_STATUS */
+typedef struct _ACSTAT
+{
+    uint32_t        dwSampleRate;
+    /** Samples per packet in 16.16 fixed point, nominal and in use */
+    uint32_t        dwNominalRate;
+    uint32_t        dwCurrentRate;
+    uint32_t        dwPacketsOut;
+    uint32_t        dwUnderruns;
+    uint32_t        dwFeedbackReads;
+    uint32_t        dwFeedbackRejected;
+    uint32_t        dwPacketsIn;
+    uint32_t        dwOverruns;
+    uint32_t        dwTransferErrors;
+    uint16_t        wADC;
+    uint8_t         byOutChannels;
+    uint8_t         byOutSubslotSize;
+    uint8_t         byOutBitResolution;
+    uint8_t         byOutSyncType;
+    uint8_t         byInChannels;
+    uint8_t         byInSubslotSize;
+    uint8_t         byInBitResolution;
+    uint8_t         bfExplicitFeedback;
+    uint8_t         bfPlaying;
+    uint8_t         bfCapturing;
+} ACSTAT,
+*PACSTAT;
+
 /** Control structure for CTL_SET_START_OFFSETS */
 typedef struct _ETSOFF
 {
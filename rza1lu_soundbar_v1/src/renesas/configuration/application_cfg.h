@@ -112,6 +112,11 @@
 /** Enable control for src/application/app_cdc_serial_port application */
 #define R_SELF_INSERT_APP_CDC_SERIAL_PORT (R_OPTION_DISABLE)
 
+/** Enable control for the USB Audio Class 2.0 speaker function on USB port 0,
+ *  played through the soundbar_app audio path. Port 0 is also used by the
+ *  host controller so the two must not be enabled together */
+#define R_SELF_INSERT_APP_USB_AUDIO (R_OPTION_DISABLE)
+
 #if R_SELF_INSERT_APP_CDC_SERIAL_PORT
 
 /** Configure driver mode when R_SELF_INSERT_APP_CDC_SERIAL_PORT is enabled
@@ -71,6 +71,27 @@
 
 #define R_OS_ABSTRACTION_PRV_MAX_TASK_NAME_SIZE    (24)
 
+/** Size classes served from the fixed block pools, 16 bytes doubling up to 2048 */
+#define R_OS_ABSTRACTION_MEM_POOL_CLASSES          (8)
+
+/** Memory regions with their own pools, R_REGION_LARGE_CAPACITY_RAM then R_REGION_UNCACHED_RAM */
+#define R_OS_ABSTRACTION_MEM_POOL_REGIONS          (2)
+
+/** Allocation events held by the trace ring, a power of two */
+#define R_OS_ABSTRACTION_MEM_TRACE_EVENTS          (1024)
+
+/** Task name bytes kept by a R_OS_MEM_EVENT_TASK event, not terminated when full */
+#define R_OS_ABSTRACTION_MEM_TRACE_NAME_SIZE       (12)
+
+/** Allocation trace event types */
+#define R_OS_MEM_EVENT_ALLOC                       (0)
+#define R_OS_MEM_EVENT_FREE                        (1)
+#define R_OS_MEM_EVENT_FAIL                        (2)
+#define R_OS_MEM_EVENT_TASK                        (3)
+
+/** Set in the region of an event when the block is on the heap rather than in a pool */
+#define R_OS_MEM_EVENT_HEAP                        (0x80)
+
 /** Milliseconds to system ticks */
 #ifndef OS_MS_TO_SYSTICKS
    #define OS_MS_TO_SYSTICKS(n) (n)
@@ -117,6 +138,55 @@ typedef uint32_t systime_t;
 /** task handle object */
 typedef void os_task_t;
 
+/** Usage of one size class of a memory pool, counters run from R_OS_InitMemManager */
+typedef struct
+{
+    uint32_t block_size;        /*!< bytes in each block of the class */
+    uint32_t capacity;          /*!< blocks in the class */
+    uint32_t in_use;            /*!< blocks allocated now */
+    uint32_t high_water;        /*!< most blocks ever allocated at once */
+    uint32_t allocs;            /*!< allocations served by the class */
+    uint32_t exhausted;         /*!< requests of the class's size passed to the heap because the class was full */
+    uint64_t requested_bytes;   /*!< bytes asked for by the allocations served, the rest of the blocks is wasted */
+} st_os_mem_pool_stats_t;
+
+/** One entry of the allocation trace. A task is numbered the first time it allocates or frees and a
+ *  R_OS_MEM_EVENT_TASK event carrying its name is written ahead of its first event */
+typedef struct
+{
+    uint32_t timestamp;         /*!< system tick, ms */
+    uint16_t task;              /*!< task number, 0 from an interrupt or before the scheduler started */
+    uint8_t  type;              /*!< R_OS_MEM_EVENT_xxx */
+    uint8_t  region;            /*!< pool index of the request, R_OS_MEM_EVENT_HEAP set if the block is on the heap */
+    union
+    {
+        struct
+        {
+            uint32_t size;      /*!< bytes asked for, 0 for a free */
+            uint32_t address;   /*!< the block, 0 for a failure */
+            uint32_t caller;    /*!< return address in the function that called R_OS_AllocMem or R_OS_FreeMem */
+        } block;
+        char_t name[R_OS_ABSTRACTION_MEM_TRACE_NAME_SIZE];  /*!< R_OS_MEM_EVENT_TASK only */
+    } data;
+} st_os_mem_event_t;
+
+/** A running task and the number it is traced as */
+typedef struct
+{
+    uint16_t task;              /*!< task number, 0 if it has not allocated since tracing started */
+    char_t   name[R_OS_ABSTRACTION_PRV_MAX_TASK_NAME_SIZE];
+} st_os_mem_trace_task_t;
+
+/** Usage of the general heap behind the pools */
+typedef struct
+{
+    size_t   free_bytes;        /*!< bytes free now */
+    size_t   min_free_bytes;    /*!< fewest bytes ever free */
+    uint32_t in_use;            /*!< blocks allocated now through R_OS_AllocMem */
+    uint32_t allocs;            /*!< allocations larger than the largest class or passed on by a full class */
+    uint32_t failures;          /*!< allocations that returned NULL */
+} st_os_mem_heap_stats_t;
+
 /** task body prototype */
 typedef void (*os_task_code_t)(void *params);
 
@@ -250,10 +320,65 @@ void   R_OS_SysWaitAccess(void);
 void   R_OS_SysReleaseAccess(void);
 
 /* Memory management */
+/** OS Abstraction AllocMem Function
+ *  @brief     Allocate a block of memory. Requests up to the largest size class are served in constant time from
+ *             the fixed block pools of the region, larger requests and those of a full class from the heap.
+ *  @param[in] size Bytes wanted.
+ *  @param[in] region R_REGION_LARGE_CAPACITY_RAM or R_REGION_UNCACHED_RAM, anything else uses the first.
+ *  @retval    Pointer to the block, aligned to 8 bytes, or NULL if memory ran out.
+*/
 void *R_OS_AllocMem (size_t size, uint32_t region);
 
+/** OS Abstraction FreeMem Function
+ *  @brief     Free a block from R_OS_AllocMem, returning it to the pool or heap it came from.
+ *  @param[in] p Block, may be NULL.
+ *  @retval    None.
+*/
 void   R_OS_FreeMem(void *p);
 
+/** OS Abstraction GetMemPoolStats Function
+ *  @brief     Read the usage of one size class of a region's pools.
+ *  @param[in] region Pool index below R_OS_ABSTRACTION_MEM_POOL_REGIONS.
+ *  @param[in] size_class Class index below R_OS_ABSTRACTION_MEM_POOL_CLASSES, smallest first.
+ *  @param[out] p_stats Destination.
+ *  @retval    FALSE if the region or class is out of range or the pools were not created.
+*/
+bool_t R_OS_GetMemPoolStats(uint32_t region, uint32_t size_class, st_os_mem_pool_stats_t *p_stats);
+
+/** OS Abstraction GetMemHeapStats Function
+ *  @brief     Read the usage of the heap behind the pools.
+ *  @param[out] p_stats Destination.
+ *  @retval    None.
+*/
+void   R_OS_GetMemHeapStats(st_os_mem_heap_stats_t *p_stats);
+
+/** OS Abstraction SetMemTrace Function
+ *  @brief     Start or stop recording allocation events, recording is on from start up.
+ *  @param[in] enable TRUE to record.
+ *  @retval    None.
+*/
+void   R_OS_SetMemTrace(bool_t enable);
+
+/** OS Abstraction GetMemTrace Function
+ *  @brief     Copy events out of the allocation trace ring. Every event has a sequence number one above the
+ *             one before; a reader passes back the sequence it got plus the count to carry on from there.
+ *  @param[in,out] p_sequence In: the first event wanted. Out: the sequence of the first event copied, later
+ *             than asked for if the ring overwrote the events in between. Pass 0 for the oldest held.
+ *  @param[out] p_events Destination.
+ *  @param[in] count Events wanted.
+ *  @retval    Events copied, 0 when the reader is up to date.
+*/
+uint32_t R_OS_GetMemTrace(uint32_t *p_sequence, st_os_mem_event_t *p_events, uint32_t count);
+
+/** OS Abstraction GetMemTraceTasks Function
+ *  @brief     List the running tasks with their trace numbers, to name tasks whose R_OS_MEM_EVENT_TASK event
+ *             has left the ring.
+ *  @param[out] p_tasks Destination.
+ *  @param[in] count Entries available.
+ *  @retval    Entries filled.
+*/
+uint32_t R_OS_GetMemTraceTasks(st_os_mem_trace_task_t *p_tasks, uint32_t count);
+
 /* Semaphore management */
 /** OS Abstraction CreateSemaphore Function
  *  @brief     Create a semaphore.
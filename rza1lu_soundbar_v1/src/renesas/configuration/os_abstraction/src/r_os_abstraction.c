@@ -66,6 +66,12 @@
 
 #define R_OS_PRV_INFINITE_DELAY               (portMAX_DELAY)
 
+/* Block size of the smallest pool class as a power of two, each class doubles it */
+#define R_OS_PRV_MEM_POOL_MIN_SHIFT       (4)
+
+/* Pool index used for R_REGION_UNCACHED_RAM, anything else uses pool 0 */
+#define R_OS_PRV_MEM_POOL_UNCACHED        (1)
+
 
 #define MIRROR_HEAP_START           ((void *) &_ld_mirrored_heap_start)
 #define MIRROR_HEAP_END             ((void *) &_ld_mirrored_heap_end)
@@ -124,7 +130,45 @@ UBaseType_t uxSavedInterruptStatus;
 static volatile char s_pcFile[200];
 static volatile unsigned long s_ulLine;
 
+/* A free pool block holds the link to the next free block of its class */
+typedef struct st_os_mem_block
+{
+    struct st_os_mem_block *p_next;
+} st_os_mem_block_t;
+
+typedef struct
+{
+    uint8_t                *p_end;      /* first byte after the class's blocks */
+    st_os_mem_block_t      *p_free;     /* head of the free list */
+    st_os_mem_pool_stats_t stats;
+} st_os_mem_class_t;
+
+typedef struct
+{
+    uint8_t           *p_start;         /* slab carved from the heap, NULL if it could not be */
+    uint8_t           *p_end;
+    st_os_mem_class_t size_class[R_OS_ABSTRACTION_MEM_POOL_CLASSES];
+} st_os_mem_pool_t;
+
+/* Blocks per class, 16 to 2048 bytes. lwIP is the only user of R_REGION_UNCACHED_RAM, its pool is weighted
+ * towards headers and full size frames */
+static const uint16_t gs_mem_pool_blocks[R_OS_ABSTRACTION_MEM_POOL_REGIONS][R_OS_ABSTRACTION_MEM_POOL_CLASSES] =
+{
+    { 128, 128, 64, 64, 32, 16, 8, 8 },
+    {  64,  64, 64, 32, 16,  8, 4, 16 }
+};
+
+static st_os_mem_pool_t gs_mem_pools[R_OS_ABSTRACTION_MEM_POOL_REGIONS];
+static st_os_mem_heap_stats_t gs_mem_heap_stats;
+
+/* Allocation trace ring. Event n is held at n modulo the ring size, sequence 0 is kept for "the oldest held" */
+static st_os_mem_event_t gs_mem_trace[R_OS_ABSTRACTION_MEM_TRACE_EVENTS];
+static uint32_t gs_mem_trace_next = 1;
+static uint16_t gs_mem_trace_tasks = 0;
+static volatile bool_t gs_mem_trace_enabled = true;
+
 /* local functions */
+static void mem_pool_create (uint32_t pool);
 
 /* LOG_TASK_INFO provides logging of information into a circular buffer. This is currently
  * configured to do so in mallocs and frees.
@@ -505,6 +549,10 @@ void R_OS_InitMemManager(void)
 
     /* Pass the array into vPortDefineHeapRegions(). */
     vPortDefineHeapRegions( xHeapRegions );
+
+    /* Carve the fixed block pools from the heap before anything else can fragment it */
+    mem_pool_create(0);
+    mem_pool_create(R_OS_PRV_MEM_POOL_UNCACHED);
 }
 /**********************************************************************************************************************
  End of function R_OS_InitMemManager
@@ -1001,40 +1049,345 @@ void R_OS_SysReleaseAccess (void)
  End of function R_OS_SysReleaseAccess
  **********************************************************************************************************************/
 
+/***********************************************************************************************************************
+ * Function Name: mem_pool_lock
+ * Description  : Mask interrupts around a pool update, from a task or an interrupt handler. Unlike
+ *                vTaskSuspendAll this is held for a handful of instructions only.
+ * Arguments    : None
+ * Return Value : Interrupt status to hand to mem_pool_unlock
+ **********************************************************************************************************************/
+static UBaseType_t mem_pool_lock (void)
+{
+    UBaseType_t status = 0;
+
+    if (0 == ulPortInterruptNesting)
+    {
+        taskENTER_CRITICAL()
+        ;
+    }
+    else
+    {
+        status = taskENTER_CRITICAL_FROM_ISR();
+    }
+    return (status);
+}
+/***********************************************************************************************************************
+ End of function mem_pool_lock
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: mem_pool_unlock
+ * Description  : End a pool update
+ * Arguments    : status - from mem_pool_lock
+ * Return Value : None
+ **********************************************************************************************************************/
+static void mem_pool_unlock (UBaseType_t status)
+{
+    if (0 == ulPortInterruptNesting)
+    {
+        taskEXIT_CRITICAL()
+        ;
+    }
+    else
+    {
+        taskEXIT_CRITICAL_FROM_ISR(status);
+    }
+}
+/***********************************************************************************************************************
+ End of function mem_pool_unlock
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: mem_pool_create
+ * Description  : Allocate one slab for a region's pools and thread every block onto its class's free list. If the
+ *                heap is too small the pools stay empty and every request goes to the heap.
+ * Arguments    : pool - index into gs_mem_pools
+ * Return Value : None
+ **********************************************************************************************************************/
+static void mem_pool_create (uint32_t pool)
+{
+    st_os_mem_pool_t *p_pool = &gs_mem_pools[pool];
+    size_t total = 0;
+    uint8_t *p_block;
+    uint32_t size_class;
+    uint32_t block;
+
+    for (size_class = 0; size_class < R_OS_ABSTRACTION_MEM_POOL_CLASSES; size_class++)
+    {
+        total += ((size_t) gs_mem_pool_blocks[pool][size_class]) << (R_OS_PRV_MEM_POOL_MIN_SHIFT + size_class);
+    }
+
+    pvPortsetDesiredBlockForMalloc((size_t)xHeapRegions[0].pucStartAddress);
+    p_block = pvPortMalloc(total);
+    if (NULL == p_block)
+    {
+        return;
+    }
+
+    p_pool->p_start = p_block;
+    p_pool->p_end = p_block + total;
+
+    for (size_class = 0; size_class < R_OS_ABSTRACTION_MEM_POOL_CLASSES; size_class++)
+    {
+        st_os_mem_class_t *p_class = &p_pool->size_class[size_class];
+        uint32_t size = 1uL << (R_OS_PRV_MEM_POOL_MIN_SHIFT + size_class);
+
+        p_class->stats.block_size = size;
+        p_class->stats.capacity = gs_mem_pool_blocks[pool][size_class];
+        p_class->p_free = NULL;
+
+        /* Thread the blocks from the top down so they are handed out in address order */
+        p_block += (size * p_class->stats.capacity);
+        p_class->p_end = p_block;
+        for (block = 0; block < p_class->stats.capacity; block++)
+        {
+            st_os_mem_block_t *p_free = (st_os_mem_block_t *) (p_class->p_end - ((block + 1) * size));
+
+            p_free->p_next = p_class->p_free;
+            p_class->p_free = p_free;
+        }
+    }
+}
+/***********************************************************************************************************************
+ End of function mem_pool_create
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: mem_pool_index
+ * Description  : Pick the pools that serve a region
+ * Arguments    : region - R_REGION_xxx
+ * Return Value : index into gs_mem_pools
+ **********************************************************************************************************************/
+static uint32_t mem_pool_index (uint32_t region)
+{
+    return ((R_REGION_UNCACHED_RAM == region) ? R_OS_PRV_MEM_POOL_UNCACHED : 0);
+}
+/***********************************************************************************************************************
+ End of function mem_pool_index
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: mem_pool_alloc
+ * Description  : Take a block from the smallest class that fits
+ * Arguments    : size - request size, not 0
+ *                pool - index into gs_mem_pools
+ * Return Value : ptr to memory block, NULL if the request is too large or the class is empty
+ **********************************************************************************************************************/
+static void *mem_pool_alloc (size_t size, uint32_t pool)
+{
+    st_os_mem_pool_t *p_pool = &gs_mem_pools[pool];
+    st_os_mem_class_t *p_class;
+    st_os_mem_block_t *p_block;
+    uint32_t size_class = 0;
+    UBaseType_t status;
+
+    while (size > (1uL << (R_OS_PRV_MEM_POOL_MIN_SHIFT + size_class)))
+    {
+        size_class++;
+        if (size_class >= R_OS_ABSTRACTION_MEM_POOL_CLASSES)
+        {
+            return (NULL);
+        }
+    }
+    p_class = &p_pool->size_class[size_class];
+
+    status = mem_pool_lock();
+    p_block = p_class->p_free;
+    if (NULL != p_block)
+    {
+        p_class->p_free = p_block->p_next;
+        p_class->stats.in_use++;
+        p_class->stats.allocs++;
+        p_class->stats.requested_bytes += size;
+        if (p_class->stats.in_use > p_class->stats.high_water)
+        {
+            p_class->stats.high_water = p_class->stats.in_use;
+        }
+    }
+    else if (0 != p_class->stats.capacity)
+    {
+        p_class->stats.exhausted++;
+    }
+    else
+    {
+        /* The pools were not created */
+        ;
+    }
+    mem_pool_unlock(status);
+
+    return ((void *) p_block);
+}
+/***********************************************************************************************************************
+ End of function mem_pool_alloc
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: mem_pool_free
+ * Description  : Return a block to its class if it came from one of the pools
+ * Arguments    : p - ptr to memory block
+ * Return Value : index of the pool the block belonged to, -1 if it is a heap block
+ **********************************************************************************************************************/
+static int_t mem_pool_free (void *p)
+{
+    uint8_t *p_byte = (uint8_t *) p;
+    uint32_t pool;
+    uint32_t size_class;
+    UBaseType_t status;
+
+    for (pool = 0; pool < R_OS_ABSTRACTION_MEM_POOL_REGIONS; pool++)
+    {
+        st_os_mem_pool_t *p_pool = &gs_mem_pools[pool];
+
+        if ((p_byte >= p_pool->p_start) && (p_byte < p_pool->p_end))
+        {
+            for (size_class = 0; size_class < R_OS_ABSTRACTION_MEM_POOL_CLASSES; size_class++)
+            {
+                st_os_mem_class_t *p_class = &p_pool->size_class[size_class];
+
+                if (p_byte < p_class->p_end)
+                {
+                    st_os_mem_block_t *p_block = (st_os_mem_block_t *) p;
+
+                    status = mem_pool_lock();
+                    p_block->p_next = p_class->p_free;
+                    p_class->p_free = p_block;
+                    p_class->stats.in_use--;
+                    mem_pool_unlock(status);
+                    return ((int_t) pool);
+                }
+            }
+        }
+    }
+    return ( -1);
+}
+/***********************************************************************************************************************
+ End of function mem_pool_free
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: mem_trace_write
+ * Description  : Add an event to the allocation trace. A task that has not been seen before is given a number and
+ *                its name is written ahead of the event.
+ * Arguments    : type - R_OS_MEM_EVENT_xxx
+ *                region - pool index, with R_OS_MEM_EVENT_HEAP for a heap block
+ *                size - bytes asked for
+ *                p - the block
+ *                caller - return address of the caller of R_OS_AllocMem or R_OS_FreeMem
+ * Return Value : None
+ **********************************************************************************************************************/
+static void mem_trace_write (uint8_t type, uint8_t region, size_t size, void *p, uint32_t caller)
+{
+    st_os_mem_event_t *p_event;
+    TickType_t timestamp;
+    UBaseType_t task = 0;
+    UBaseType_t status;
+
+    if (!gs_mem_trace_enabled)
+    {
+        return;
+    }
+
+    status = mem_pool_lock();
+    if (0 == ulPortInterruptNesting)
+    {
+        timestamp = xTaskGetTickCount();
+        if (taskSCHEDULER_NOT_STARTED != xTaskGetSchedulerState())
+        {
+            TaskHandle_t handle = xTaskGetCurrentTaskHandle();
+
+            task = uxTaskGetTaskNumber(handle);
+            if (0 == task)
+            {
+                task = ++gs_mem_trace_tasks;
+                vTaskSetTaskNumber(handle, task);
+
+                p_event = &gs_mem_trace[gs_mem_trace_next++ & (R_OS_ABSTRACTION_MEM_TRACE_EVENTS - 1)];
+                p_event->timestamp = timestamp;
+                p_event->task = (uint16_t) task;
+                p_event->type = R_OS_MEM_EVENT_TASK;
+                p_event->region = 0;
+                strncpy(p_event->data.name, pcTaskGetName(handle), R_OS_ABSTRACTION_MEM_TRACE_NAME_SIZE);
+            }
+        }
+    }
+    else
+    {
+        timestamp = xTaskGetTickCountFromISR();
+    }
+
+    p_event = &gs_mem_trace[gs_mem_trace_next++ & (R_OS_ABSTRACTION_MEM_TRACE_EVENTS - 1)];
+    p_event->timestamp = timestamp;
+    p_event->task = (uint16_t) task;
+    p_event->type = type;
+    p_event->region = region;
+    p_event->data.block.size = size;
+    p_event->data.block.address = (uint32_t) p;
+    p_event->data.block.caller = caller;
+    mem_pool_unlock(status);
+}
+/***********************************************************************************************************************
+ End of function mem_trace_write
+ **********************************************************************************************************************/
+
 /***********************************************************************************************************************
  * Function Name: R_OS_AllocMem
- * Description  : Allocate a block of memory
+ * Description  : Allocate a block of memory. Small requests are served from the region's fixed block pools without
+ *                stopping the scheduler, the rest from the heap.
  * Arguments    : size - request size
+ *                region - R_REGION_xxx
  * Return Value : ptr to memory block
  **********************************************************************************************************************/
 void *R_OS_AllocMem (size_t size, uint32_t region)
 {
-    volatile void *p;
+    volatile void *p = NULL;
+    uint8_t pool = (uint8_t) mem_pool_index(region);
 
-    /* The call sequence pvPortsetDesiredBlockForMalloc() to pvPortMalloc() must not be interrupted. */
-	/* If interrupted (via task switching) the chosen memory region might be changed by the swapped-in task */
-    vTaskSuspendAll();
-
-    switch (region)
+    if (0 != size)
     {
-		case R_REGION_LARGE_CAPACITY_RAM:
-		{
-	        /* Initial Region R_REGION_LARGE_CAPACITY_RAM */
-	        pvPortsetDesiredBlockForMalloc((size_t)xHeapRegions[0].pucStartAddress);
-	        break;
-		}
-		default:
-		{
-	        /* if region is incorrectly specified assign the requested memory to the first block */
-	        pvPortsetDesiredBlockForMalloc((size_t)xHeapRegions[0].pucStartAddress);
-		}
+        p = mem_pool_alloc(size, pool);
     }
 
-    /* Allocate a memory block */
-    p = pvPortMalloc(size);
+    if (NULL == p)
+    {
+        pool |= R_OS_MEM_EVENT_HEAP;
 
-    xTaskResumeAll();
+        /* The call sequence pvPortsetDesiredBlockForMalloc() to pvPortMalloc() must not be interrupted. */
+        /* If interrupted (via task switching) the chosen memory region might be changed by the swapped-in task */
+        vTaskSuspendAll();
+
+        switch (region)
+        {
+            case R_REGION_LARGE_CAPACITY_RAM:
+            {
+                /* Initial Region R_REGION_LARGE_CAPACITY_RAM */
+                pvPortsetDesiredBlockForMalloc((size_t)xHeapRegions[0].pucStartAddress);
+                break;
+            }
+            default:
+            {
+                /* if region is incorrectly specified assign the requested memory to the first block */
+                pvPortsetDesiredBlockForMalloc((size_t)xHeapRegions[0].pucStartAddress);
+            }
+        }
 
+        /* Allocate a memory block */
+        p = pvPortMalloc(size);
+
+        if (NULL != p)
+        {
+            gs_mem_heap_stats.in_use++;
+            gs_mem_heap_stats.allocs++;
+        }
+        else
+        {
+            gs_mem_heap_stats.failures++;
+        }
+
+        xTaskResumeAll();
+    }
+
+    mem_trace_write((NULL != p) ? R_OS_MEM_EVENT_ALLOC : R_OS_MEM_EVENT_FAIL, pool, size, (void *) p,
+            (uint32_t) __builtin_return_address(0));
 
 #ifdef LOG_TASK_INFO
     {
@@ -1070,11 +1423,27 @@ void R_OS_FreeMem (void *p)
     //Make sure the pointer is valid
     if (p != NULL)
     {
+        int_t pool;
+
         //Debug message
         TRACE(("Freeing memory at 0x%08x \r\n", p));
 
         /* Free memory block */
-        vPortFree(p);
+        pool = mem_pool_free(p);
+
+        if (pool < 0)
+        {
+            UBaseType_t status;
+
+            vPortFree(p);
+
+            status = mem_pool_lock();
+            gs_mem_heap_stats.in_use--;
+            mem_pool_unlock(status);
+        }
+
+        mem_trace_write(R_OS_MEM_EVENT_FREE, (pool < 0) ? R_OS_MEM_EVENT_HEAP : (uint8_t) pool, 0, p,
+                (uint32_t) __builtin_return_address(0));
 
 #ifdef LOG_TASK_INFO
         {
@@ -1094,6 +1463,136 @@ void R_OS_FreeMem (void *p)
  End of function R_OS_FreeMem
  **********************************************************************************************************************/
 
+/***********************************************************************************************************************
+ * Function Name: R_OS_GetMemPoolStats
+ * Description  : Read the usage of one size class of a region's pools
+ * Arguments    : region - pool index
+ *                size_class - class index, smallest first
+ *                p_stats - destination
+ * Return Value : false if the indexes are out of range or the pools were not created
+ **********************************************************************************************************************/
+bool_t R_OS_GetMemPoolStats (uint32_t region, uint32_t size_class, st_os_mem_pool_stats_t *p_stats)
+{
+    UBaseType_t status;
+
+    if ((region >= R_OS_ABSTRACTION_MEM_POOL_REGIONS) || (size_class >= R_OS_ABSTRACTION_MEM_POOL_CLASSES)
+            || (NULL == gs_mem_pools[region].p_start))
+    {
+        return (false);
+    }
+
+    status = mem_pool_lock();
+    *p_stats = gs_mem_pools[region].size_class[size_class].stats;
+    mem_pool_unlock(status);
+    return (true);
+}
+/***********************************************************************************************************************
+ End of function R_OS_GetMemPoolStats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: R_OS_GetMemHeapStats
+ * Description  : Read the usage of the heap behind the pools
+ * Arguments    : p_stats - destination
+ * Return Value : none
+ **********************************************************************************************************************/
+void R_OS_GetMemHeapStats (st_os_mem_heap_stats_t *p_stats)
+{
+    vTaskSuspendAll();
+    *p_stats = gs_mem_heap_stats;
+    p_stats->free_bytes = xPortGetFreeHeapSize();
+    p_stats->min_free_bytes = xPortGetMinimumEverFreeHeapSize();
+    xTaskResumeAll();
+}
+/***********************************************************************************************************************
+ End of function R_OS_GetMemHeapStats
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: R_OS_SetMemTrace
+ * Description  : Start or stop recording allocation events
+ * Arguments    : enable - true to record
+ * Return Value : none
+ **********************************************************************************************************************/
+void R_OS_SetMemTrace (bool_t enable)
+{
+    gs_mem_trace_enabled = enable;
+}
+/***********************************************************************************************************************
+ End of function R_OS_SetMemTrace
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: R_OS_GetMemTrace
+ * Description  : Copy events out of the allocation trace ring
+ * Arguments    : p_sequence - in: first event wanted, 0 for the oldest. out: sequence of the first event copied
+ *                p_events - destination
+ *                count - events wanted
+ * Return Value : events copied
+ **********************************************************************************************************************/
+uint32_t R_OS_GetMemTrace (uint32_t *p_sequence, st_os_mem_event_t *p_events, uint32_t count)
+{
+    uint32_t oldest;
+    uint32_t copied = 0;
+    UBaseType_t status;
+
+    status = mem_pool_lock();
+    oldest = (gs_mem_trace_next > R_OS_ABSTRACTION_MEM_TRACE_EVENTS) ?
+            (gs_mem_trace_next - R_OS_ABSTRACTION_MEM_TRACE_EVENTS) : 1;
+    if ((*p_sequence < oldest) || (*p_sequence > gs_mem_trace_next))
+    {
+        *p_sequence = oldest;
+    }
+    while ((copied < count) && ((*p_sequence + copied) != gs_mem_trace_next))
+    {
+        p_events[copied] = gs_mem_trace[(*p_sequence + copied) & (R_OS_ABSTRACTION_MEM_TRACE_EVENTS - 1)];
+        copied++;
+    }
+    mem_pool_unlock(status);
+
+    return (copied);
+}
+/***********************************************************************************************************************
+ End of function R_OS_GetMemTrace
+ **********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: R_OS_GetMemTraceTasks
+ * Description  : List the running tasks with the numbers they are traced as
+ * Arguments    : p_tasks - destination
+ *                count - entries available
+ * Return Value : entries filled
+ **********************************************************************************************************************/
+uint32_t R_OS_GetMemTraceTasks (st_os_mem_trace_task_t *p_tasks, uint32_t count)
+{
+    xTaskStatusType *p_task_status_array;
+    uint32_t ux_array_size = uxTaskGetNumberOfTasks() + 2;
+    uint32_t filled = 0;
+    uint32_t i;
+
+    /* Allow for tasks created while the array is allocated */
+    p_task_status_array = R_OS_AllocMem((ux_array_size * sizeof(xTaskStatusType)), R_REGION_LARGE_CAPACITY_RAM);
+    if (NULL == p_task_status_array)
+    {
+        return (0);
+    }
+
+    ux_array_size = uxTaskGetSystemState(p_task_status_array, ux_array_size, NULL);
+    for (i = 0; (i < ux_array_size) && (filled < count); i++)
+    {
+        p_tasks[filled].task = (uint16_t) uxTaskGetTaskNumber(p_task_status_array[i].xHandle);
+        strncpy(p_tasks[filled].name, p_task_status_array[i].pcTaskName, R_OS_ABSTRACTION_PRV_MAX_TASK_NAME_SIZE - 1);
+        p_tasks[filled].name[R_OS_ABSTRACTION_PRV_MAX_TASK_NAME_SIZE - 1] = '\0';
+        filled++;
+    }
+
+    R_OS_FreeMem(p_task_status_array);
+    return (filled);
+}
+/***********************************************************************************************************************
+ End of function R_OS_GetMemTraceTasks
+ **********************************************************************************************************************/
+
 /* Semaphore management */
 /***********************************************************************************************************************
  * Function Name: R_OS_CreateSemaphore
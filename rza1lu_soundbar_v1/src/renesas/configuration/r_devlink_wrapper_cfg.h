@@ -65,6 +65,10 @@
 #include "hwusbf_hid_rskrza1_0.h"
 #endif
 
+#if R_SELF_INSERT_APP_USB_AUDIO
+#include "hwusbf_audio_rskrza1_0.h"
+#endif
+
 #if R_SELF_INSERT_APP_PMOD
 #include "r_pmod_lcd_drv_api.h"
 #endif
@@ -167,6 +171,11 @@ static st_mount_table_t gs_mount_table[] =
    {"usbf0_hid",  (st_r_driver_t *)&g_usbf0_hid_driver, R_SC0},
 #endif
 
+#if R_SELF_INSERT_APP_USB_AUDIO
+   /** USBF0 audio driver added by USER */
+   {"usbf0_audio",  (st_r_driver_t *)&g_usbf0_audio_driver, R_SC0},
+#endif
+
    /** EEPROM driver added by USER */
    {"eeprom", (st_r_driver_t *)&g24C04Driver, R_SC0},
 
@@ -136,8 +136,12 @@
 #define TASK_ETHERC_INPUT_PRI       (TC_SOFT_ISR_PRIORITY - 1)
 #define TASK_ETHERC_OUTPUT_PRI      (TC_SOFT_ISR_PRIORITY - 1)
 #define TASK_LWIP_MAIN_PRI          (TC_SOFT_ISR_PRIORITY - 1)
+#define TASK_USB_AUDIO_PLAY_PRI     (TC_SOFT_ISR_PRIORITY - 2)
+#define TASK_USB_AUDIO_CAPTURE_PRI  (TC_SOFT_ISR_PRIORITY - 3)
 #define TASK_WEB_SERVER_PRI         (TC_SOFT_ISR_PRIORITY - 4)
 #define TASK_UDP_IP_CONSOLE_PRI     (TC_SOFT_ISR_PRIORITY - 6)
+#define TASK_RTP_RECEIVE_PRI        (TC_SOFT_ISR_PRIORITY - 6)
+#define TASK_USB_MS_QUEUE_PRI       (TC_SOFT_ISR_PRIORITY - 6)
 #define TASK_PMOD_APP_PRI           (TC_SOFT_ISR_PRIORITY - 9)
 #define TASK_MAC_ERROR_FLASH_PRI    (TC_SOFT_ISR_PRIORITY - 9)
 #define TASK_TELNET_MON_PRI         (TC_SOFT_ISR_PRIORITY - 9)
@@ -147,8 +151,15 @@
 #define TASK_WR_PERF_TEST_PRI       (TC_SOFT_ISR_PRIORITY - 9)
 #define TASK_BLINK_TASK_PRI         (TC_SOFT_ISR_PRIORITY - 9)
 #define TASK_SWITCH_TASK_PRI        (TC_SOFT_ISR_PRIORITY - 9)
+#define TASK_VOLUME_RAMP_PRI        (TC_SOFT_ISR_PRIORITY - 9)
+#define TASK_DAE6_QUEUE_PRI         (TC_SOFT_ISR_PRIORITY - 9)
 #define TASK_PLAY_SOUND_APP_PRI     (TC_SOFT_ISR_PRIORITY - 9)
 #define TASK_RECORD_SOUND_APP_PRI   (TC_SOFT_ISR_PRIORITY - 9)
+#define TASK_READ_SOUND_FILE_PRI    (TC_SOFT_ISR_PRIORITY - 9)
+#define TASK_AUDIO_PREFETCH_PRI     (TC_SOFT_ISR_PRIORITY - 9)
+#define TASK_TRACK_LOADER_PRI       (TC_SOFT_ISR_PRIORITY - 9)
+#define TASK_MEDIA_LIBRARY_PRI      (TC_SOFT_ISR_PRIORITY - 9)
+#define TASK_NV_FLUSH_PRI           (TC_SOFT_ISR_PRIORITY - 9)
 
 #endif /* TASKPRIORITY_H_INCLUDED */
 
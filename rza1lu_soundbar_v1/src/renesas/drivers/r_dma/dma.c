@@ -44,6 +44,16 @@ Includes <System Includes>, "Project Includes"
 #include "Renesas_RZ_A1.h"
 #include "system_Renesas_RZ_A1.H"
 #include "dma_if.h"
+#include "core_ca.h"
+#include "core_caFunc.h"
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+
+/* L1 data cache line of the Cortex-A9 */
+#define DMA_CACHE_LINE_SIZE     (0x00000020u)
+#define DMA_CACHE_LINE_MASK     (0xFFFFFFE0u)
 
 /******************************************************************************
 Private global driver management information
@@ -250,6 +260,9 @@ int_t DMA_Initialize(const dma_drv_init_t * const p_dma_init_param)
         /* initialise next DMA setting flag */
         gb_info_drv.info_ch[ch_count].next_dma_flag = false;
 
+        /* initialise link mode flag */
+        gb_info_drv.info_ch[ch_count].link_flag = false;
+
         if (1U == ((uint32_t)ch_count & CHECK_ODD_EVEN_MASK))
         {
             /* set shift number when channel is odd value */
@@ -827,6 +840,126 @@ void DMA_SetNextData(const int_t channel, const dma_trans_data_t * const p_dma_d
  End of function DMA_Nextdata
  ******************************************************************************/
 
+/******************************************************************************
+ * Function Name: DMA_SetLinkData
+ * Description : Build a link mode descriptor chain from the channel setting
+ *               made by DMA_SetParam and write it back from the cache
+ * Arguments : channel - Set address channel number
+ *             *p_desc - Descriptors to build
+ *             *p_dma_data - DMA transfer address parameter sets, one per descriptor
+ *             count - Number of descriptors
+ *             cyclic - Link the last descriptor to the first
+ * Return Value : None
+ ******************************************************************************/
+void DMA_SetLinkData(const int_t channel, dma_link_desc_t * const p_desc,
+                     const dma_trans_data_t * const p_dma_data, const uint32_t count, const bool_t cyclic)
+{
+    uint32_t index;
+    uint32_t chcfg;
+    uint32_t line;
+
+    /* prevent access to channels below DMA_START_CHANNEL */
+    if (channel < DMA_START_CHANNEL)
+    {
+        return;
+    }
+
+    /* descriptors carry the register mode setting with link mode selected and the end interrupt unmasked */
+    chcfg = (gb_info_drv.info_ch[channel].p_dma_ch_reg->CHCFG_n
+            & ~(uint32_t) (CHCFG_SET_DEM | CHCFG_SET_REN | CHCFG_SET_RSW | CHCFG_SET_RSEL)) | CHCFG_SET_DMS;
+
+    for (index = 0; index < count; index++)
+    {
+        /* bus parameter is worked out per address */
+        DMA_BusParam(channel, &p_dma_data[index]);
+
+        /* ->MISRA 11.3 This cast is needed for setting address to descriptor */
+        p_desc[index].src_addr = (uint32_t) p_dma_data[index].src_addr;
+        p_desc[index].dst_addr = (uint32_t) p_dma_data[index].dst_addr;
+        /* <-MISRA 11.3 */
+        p_desc[index].count = p_dma_data[index].count;
+        p_desc[index].chcfg = chcfg;
+        p_desc[index].chitvl = CHITVL_INIT_VALUE;
+        p_desc[index].chext = gb_info_drv.info_ch[channel].p_dma_ch_reg->CHEXT_n;
+
+        if ((index + 1U) < count)
+        {
+            p_desc[index].header = DMA_LINK_HEADER_LV | DMA_LINK_HEADER_WBD;
+            p_desc[index].next_link_addr = (uint32_t) &p_desc[index + 1U];
+        }
+        else if (cyclic)
+        {
+            /* valid bits are never written back, so the chain can go round again */
+            p_desc[index].header = DMA_LINK_HEADER_LV | DMA_LINK_HEADER_WBD;
+            p_desc[index].next_link_addr = (uint32_t) &p_desc[0];
+        }
+        else
+        {
+            p_desc[index].header = DMA_LINK_HEADER_LV | DMA_LINK_HEADER_WBD | DMA_LINK_HEADER_LE;
+            p_desc[index].next_link_addr = 0U;
+        }
+    }
+
+    /* the DMAC reads the descriptors from memory */
+    for (line = ((uint32_t) p_desc) & DMA_CACHE_LINE_MASK;
+         line < (((uint32_t) p_desc) + (count * sizeof(dma_link_desc_t)));
+         line += DMA_CACHE_LINE_SIZE)
+    {
+        __v7_clean_dcache_mva((void *) line);
+    }
+}
+/******************************************************************************
+ End of function DMA_SetLinkData
+ ******************************************************************************/
+
+/******************************************************************************
+ * Function Name: DMA_LinkStart
+ * Description : Start DMA transfer from a link mode descriptor chain.
+ * Arguments : channel -
+ *                  DMA transfer start channel number.
+ *             *p_desc -
+ *                  First descriptor of the chain.
+ * Return Value : None.
+ ******************************************************************************/
+void DMA_LinkStart(const int_t channel, const dma_link_desc_t * const p_desc)
+{
+    /* prevent access to channels below DMA_START_CHANNEL */
+    if (channel < DMA_START_CHANNEL)
+    {
+        return;
+    }
+
+    /* clear continuous DMA setting, the chain replaces the next register sets */
+    gb_info_drv.info_ch[channel].p_dma_ch_reg->CHCFG_n &= ~(uint32_t)(CHCFG_SET_RSW | CHCFG_SET_RSEL | CHCFG_SET_REN);
+    gb_info_drv.info_ch[channel].next_dma_flag = false;
+    gb_info_drv.info_ch[channel].link_flag = true;
+
+    /* clear setup flag */
+    gb_info_drv.info_ch[channel].setup_flag = false;
+
+    /* reset DMA */
+    gb_info_drv.info_ch[channel].p_dma_ch_reg->CHCTRL_n = CHCTRL_SET_SWRST;
+
+    /* ->MISRA 11.3 This cast is needed for setting address to register */
+    gb_info_drv.info_ch[channel].p_dma_ch_reg->NXLA_n = (uint32_t) p_desc;
+    /* <-MISRA 11.3 */
+
+    /* select link mode, the rest of CHCFG is loaded from the first descriptor */
+    gb_info_drv.info_ch[channel].p_dma_ch_reg->CHCFG_n |= (uint32_t) CHCFG_SET_DMS;
+    gb_info_drv.info_ch[channel].p_dma_ch_reg->CHCFG_n &= ~((uint32_t) CHCFG_SET_DEM);
+
+    R_INTC_Enable(gb_info_drv.info_ch[channel].end_irq_num);
+
+    /* start DMA transfer */
+    gb_info_drv.info_ch[channel].p_dma_ch_reg->CHCTRL_n = CHCTRL_SET_SETEN;
+
+    /* set channel status to DMA_CH_TRANSFER */
+    gb_info_drv.info_ch[channel].ch_stat = DMA_CH_TRANSFER;
+}
+/******************************************************************************
+ End of function DMA_LinkStart
+ ******************************************************************************/
+
 /******************************************************************************
  * Function Name: DMA_SoftwareTrigger
  * Description : Software trigger DMA transfer
@@ -935,14 +1068,15 @@ void DMA_Stop(const int_t channel, uint32_t * const p_remain)
     /* set mask of DMA transfer end */
     gb_info_drv.info_ch[channel].p_dma_ch_reg->CHCFG_n |= (uint32_t)CHCFG_SET_DEM;
 
-    /* clear setting of continuous DMA */
-    gb_info_drv.info_ch[channel].p_dma_ch_reg->CHCFG_n &= ~(uint32_t)(CHCFG_SET_RSW | CHCFG_SET_RSEL);
+    /* clear setting of continuous DMA and link mode */
+    gb_info_drv.info_ch[channel].p_dma_ch_reg->CHCFG_n &= ~(uint32_t)(CHCFG_SET_RSW | CHCFG_SET_RSEL | CHCFG_SET_DMS);
 
     /* clear TC, END bit */
     gb_info_drv.info_ch[channel].p_dma_ch_reg->CHCTRL_n = (CHCTRL_SET_CLRTC | CHCTRL_SET_CLREND);
 
     /* clear flag which indicates that next DMA transfer set already */
     gb_info_drv.info_ch[channel].next_dma_flag = false;
+    gb_info_drv.info_ch[channel].link_flag = false;
 
     /* interrupt clear, if interrupt occurred already */
     R_INTC_ClearPendingInt(gb_info_drv.info_ch[channel].end_irq_num);
@@ -1344,9 +1478,15 @@ __inline static void R_DMA_EndHandlerProcess(const int_t channel)
         was_masked = __disable_irq();
 #endif
 
-        /* store next_dma_flag */
+        /* store next_dma_flag, a descriptor chain still running counts as next DMA set already */
         store_next_dma_flag = gb_info_drv.info_ch[channel].next_dma_flag;
 
+        if (gb_info_drv.info_ch[channel].link_flag)
+        {
+            store_next_dma_flag = (0U != (gb_info_drv.info_ch[channel].p_dma_ch_reg->CHSTAT_n & CHSTAT_MASK_EN));
+            gb_info_drv.info_ch[channel].link_flag = store_next_dma_flag;
+        }
+
         /* clear flag which indicates that next DMA transfer set already */
         gb_info_drv.info_ch[channel].next_dma_flag = false;
 
@@ -1362,8 +1502,8 @@ __inline static void R_DMA_EndHandlerProcess(const int_t channel)
             /* set mask of DMA transfer end */
             gb_info_drv.info_ch[channel].p_dma_ch_reg->CHCFG_n |= (uint32_t)CHCFG_SET_DEM;
 
-            /* clear setting of continuous DMA */
-            gb_info_drv.info_ch[channel].p_dma_ch_reg->CHCFG_n &= ~(uint32_t)(CHCFG_SET_RSW | CHCFG_SET_RSEL);
+            /* clear setting of continuous DMA and link mode */
+            gb_info_drv.info_ch[channel].p_dma_ch_reg->CHCFG_n &= ~(uint32_t)(CHCFG_SET_RSW | CHCFG_SET_RSEL | CHCFG_SET_DMS);
 
             /* check EN bit is clear */
             if (0U == (gb_info_drv.info_ch[channel].p_dma_ch_reg->CHSTAT_n & CHSTAT_MASK_EN))
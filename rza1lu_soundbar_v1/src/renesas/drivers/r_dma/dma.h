@@ -93,6 +93,8 @@ Macro definitions
 #define CHCTRL_SET_CLREN       (0x00000002U)
 #define CHCTRL_SET_SETEN       (0x00000001U)
 /* CHCFG */
+#define CHCFG_SET_DMS          (0x80000000U)
+#define CHCFG_MASK_DMS         (0x80000000U)
 #define CHCFG_SET_REN          (0x40000000U)
 #define CHCFG_MASK_REN         (0x40000000U)
 #define CHCFG_SET_RSW          (0x20000000U)
@@ -214,6 +216,7 @@ typedef struct
     IRQn_Type          end_irq_num;       /* DMA end interrupt number */
     AIOCB              *p_end_aio;        /* set callback function (DMA end interrupt) */
     bool_t             next_dma_flag;     /* Setting Flag of Continuous DMA */
+    bool_t             link_flag;         /* Channel runs from a link mode descriptor chain */
     uint32_t           shift_dmars;       /* set SHIFT_DMARS_ODD_CH or SHIFT_DMARS_EVEN_CH */
     uint32_t           mask_dmars;        /* set MASK_DMA_ODD_CH or MASK_DMARS_EVEN_CH */
     bool_t             setup_flag;        /* indicate called DMA_Setup() flag */
@@ -257,6 +260,9 @@ void  DMA_BusParam(const int_t channel, const dma_trans_data_t * const p_dma_dat
 void  DMA_SetData(const int_t channel, const dma_trans_data_t * const p_dma_data,
                  const uint32_t next_register_set);
 void  DMA_SetNextData(const int_t channel, const dma_trans_data_t * const p_dma_data);
+void  DMA_SetLinkData(const int_t channel, dma_link_desc_t * const p_desc,
+                      const dma_trans_data_t * const p_dma_data, const uint32_t count, const bool_t cyclic);
+void  DMA_LinkStart(const int_t channel, const dma_link_desc_t * const p_desc);
 void  DMA_SoftwareTrigger(const int_t channel);
 void  DMA_Start(const int_t channel, const bool_t restart_flag);
 void  DMA_Stop(const int_t channel, uint32_t * const p_remain);
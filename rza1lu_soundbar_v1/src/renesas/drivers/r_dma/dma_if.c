@@ -38,6 +38,7 @@
  *******************************************************************************/
 
 #include "dma.h"
+#include "dmac_iodefine.h"
 #include "mcu_board_select.h"
 #include "dev_drv.h"
 
@@ -1017,6 +1018,243 @@ int_t R_DMA_NextData(const int_t channel, const dma_trans_data_t * const p_dma_d
  End of function R_DMA_NextData
  ******************************************************************************/
 
+/******************************************************************************
+* Function Name: R_DMA_LinkSetup
+* Description : Build a link mode descriptor chain.
+*               Check parameter in this function mainly.
+* Arguments : channel -
+*                  DMA channel number, set up with R_DMA_Setup.
+*             *p_desc -
+*                  Descriptors to build, DMA_LINK_DESC_ALIGN aligned.
+*             *p_dma_data -
+*                  DMA address parameters, one per descriptor.
+*             count -
+*                  Number of descriptors.
+*             cyclic -
+*                  Link the last descriptor back to the first.
+*             *p_errno -
+*                  Pointer of error code.
+*                  When pointer is NULL, it isn't set error code.
+*                  error code -
+*                     DRV_ERROR : Value of the ch is outside the range of
+*                              (-1) < ch < (DMA_CH_NUM + 1).
+*                     DRV_ERROR : Channel status isn't DMA_CH_OPEN or
+*                              R_DMA_Setup has not been called.
+*                     DRV_ERROR : p_desc or p_dma_data is NULL, p_desc is
+*                              not aligned, count or a transfer size is 0.
+* Return Value : DRV_SUCCESS -
+*                  Operation successful.
+*                DRV_ERROR -
+*                  Error occured.
+******************************************************************************/
+int_t R_DMA_LinkSetup(const int_t channel, dma_link_desc_t * const p_desc,
+                      const dma_trans_data_t * const p_dma_data, const uint32_t count,
+                      const bool_t cyclic, int32_t * const p_errno)
+{
+    int_t retval = DRV_SUCCESS;
+    dma_info_ch_t *dma_info_ch;
+    uint32_t index;
+    uint32_t was_masked;
+
+    DMA_SetErrCode(DRV_SUCCESS, p_errno);
+
+    /* check channel and parameters of argument */
+    if ((channel < 0) || (channel >= DMA_CH_NUM) || (NULL == p_desc) || (NULL == p_dma_data) || (0U == count)
+            || (0U != ((uint32_t) p_desc & (DMA_LINK_DESC_ALIGN - 1U))))
+    {
+        retval = DRV_ERROR;
+    }
+
+    for (index = 0; (DRV_SUCCESS == retval) && (index < count); index++)
+    {
+        /* check DMA transfer count of every descriptor */
+        if (0U == p_dma_data[index].count)
+        {
+            retval = DRV_ERROR;
+        }
+    }
+
+    if (DRV_SUCCESS == retval)
+    {
+        /* disable all IRQ */
+#if defined (__ICCARM__)
+        was_masked = __disable_irq_iar();
+#else
+        was_masked = __disable_irq();
+#endif
+
+        dma_info_ch = DMA_GetDrvChInfo(channel);
+
+        if ((DMA_CH_OPEN == dma_info_ch->ch_stat) && (false != dma_info_ch->setup_flag))
+        {
+            DMA_SetLinkData(channel, p_desc, p_dma_data, count, cyclic);
+        }
+        else
+        {
+            retval = DRV_ERROR;
+        }
+
+        if (0 == was_masked)
+        {
+            __enable_irq();
+        }
+    }
+
+    if (DRV_SUCCESS != retval)
+    {
+        DMA_SetErrCode(DRV_ERROR, p_errno);
+    }
+
+    return retval;
+}
+/******************************************************************************
+ End of function R_DMA_LinkSetup
+ ******************************************************************************/
+
+/******************************************************************************
+* Function Name: R_DMA_LinkStart
+* Description : Start DMA transfer from a descriptor chain.
+*               Check parameter in this function mainly.
+* Arguments : channel -
+*                  DMA start channel number.
+*             *p_desc -
+*                  First descriptor, built by R_DMA_LinkSetup.
+*             *p_errno -
+*                  Pointer of error code.
+*                  When pointer is NULL, it isn't set error code.
+*                  error code -
+*                     DRV_ERROR : Value of the ch is outside the range of
+*                              (-1) < ch < (DMA_CH_NUM + 1).
+*                     DRV_ERROR : Channel status isn't DMA_CH_OPEN.
+*                     DRV_ERROR : p_desc is NULL.
+* Return Value : DRV_SUCCESS -
+*                  Operation successful.
+*                DRV_ERROR -
+*                  Error occured.
+******************************************************************************/
+int_t R_DMA_LinkStart(const int_t channel, const dma_link_desc_t * const p_desc, int32_t * const p_errno)
+{
+    int_t retval = DRV_SUCCESS;
+    dma_info_ch_t *dma_info_ch;
+    uint32_t was_masked;
+
+    DMA_SetErrCode(DRV_SUCCESS, p_errno);
+
+    /* check channel and descriptor of argument */
+    if ((channel < 0) || (channel >= DMA_CH_NUM) || (NULL == p_desc))
+    {
+        retval = DRV_ERROR;
+    }
+    else
+    {
+        /* disable all IRQ */
+#if defined (__ICCARM__)
+        was_masked = __disable_irq_iar();
+#else
+        was_masked = __disable_irq();
+#endif
+
+        dma_info_ch = DMA_GetDrvChInfo(channel);
+
+        if (DMA_CH_OPEN == dma_info_ch->ch_stat)
+        {
+            DMA_LinkStart(channel, p_desc);
+        }
+        else
+        {
+            retval = DRV_ERROR;
+        }
+
+        if (0 == was_masked)
+        {
+            __enable_irq();
+        }
+    }
+
+    if (DRV_SUCCESS != retval)
+    {
+        DMA_SetErrCode(DRV_ERROR, p_errno);
+    }
+
+    return retval;
+}
+/******************************************************************************
+ End of function R_DMA_LinkStart
+ ******************************************************************************/
+
+/******************************************************************************
+* Function Name: R_DMA_LinkPosition
+* Description : Read the descriptor being transferred and its remain size.
+* Arguments : channel -
+*                  DMA channel number.
+*             *p_link_addr -
+*                  Address of the current descriptor.
+*             *p_remain -
+*                  Remain data size of its transfer.
+*             *p_errno -
+*                  Pointer of error code.
+*                  When pointer is NULL, it isn't set error code.
+*                  error code -
+*                     DRV_ERROR : Value of the ch is outside the range of
+*                              (-1) < ch < (DMA_CH_NUM + 1).
+*                     DRV_ERROR : Channel isn't running a descriptor chain.
+*                     DRV_ERROR : p_link_addr or p_remain is NULL.
+* Return Value : DRV_SUCCESS -
+*                  Operation successful.
+*                DRV_ERROR -
+*                  Error occured.
+******************************************************************************/
+int_t R_DMA_LinkPosition(const int_t channel, uint32_t * const p_link_addr, uint32_t * const p_remain,
+                         int32_t * const p_errno)
+{
+    int_t retval = DRV_SUCCESS;
+    dma_info_ch_t *dma_info_ch;
+    uint32_t was_masked;
+
+    DMA_SetErrCode(DRV_SUCCESS, p_errno);
+
+    if ((channel < 0) || (channel >= DMA_CH_NUM) || (NULL == p_link_addr) || (NULL == p_remain))
+    {
+        retval = DRV_ERROR;
+    }
+    else
+    {
+        /* disable all IRQ so address and remain come from the same descriptor */
+#if defined (__ICCARM__)
+        was_masked = __disable_irq_iar();
+#else
+        was_masked = __disable_irq();
+#endif
+
+        dma_info_ch = DMA_GetDrvChInfo(channel);
+
+        if ((DMA_CH_TRANSFER == dma_info_ch->ch_stat) && (false != dma_info_ch->link_flag))
+        {
+            *p_link_addr = dma_info_ch->p_dma_ch_reg->CRLA_n;
+            *p_remain = dma_info_ch->p_dma_ch_reg->CRTB_n;
+        }
+        else
+        {
+            retval = DRV_ERROR;
+        }
+
+        if (0 == was_masked)
+        {
+            __enable_irq();
+        }
+    }
+
+    if (DRV_SUCCESS != retval)
+    {
+        DMA_SetErrCode(DRV_ERROR, p_errno);
+    }
+
+    return retval;
+}
+/******************************************************************************
+ End of function R_DMA_LinkPosition
+ ******************************************************************************/
+
 /******************************************************************************
 * Function Name: R_DMA_Cancel
 * Description : Cancel DMA transfer.
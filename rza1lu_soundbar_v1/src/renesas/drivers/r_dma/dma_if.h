@@ -83,6 +83,15 @@ extern "C"
 /* for searching free channel */
 #define DMA_ALLOC_CH  (-1)
 
+/* Link mode descriptor header */
+#define DMA_LINK_HEADER_LV   (0x00000001U)  /*!< Descriptor is valid */
+#define DMA_LINK_HEADER_LE   (0x00000002U)  /*!< Last descriptor of the chain */
+#define DMA_LINK_HEADER_WBD  (0x00000004U)  /*!< Do not clear LV after the transfer, needed to reuse the chain */
+#define DMA_LINK_HEADER_DIM  (0x00000008U)  /*!< No DMA end interrupt for this descriptor */
+
+/* Link mode descriptors are read from memory one cache line at a time */
+#define DMA_LINK_DESC_ALIGN  (32U)
+
 /***********************************************************************************
 * @brief      dma channels below this will not be affected by this driver,
 *             to ensure compatibility with USBH which uses channels 0,1, with
@@ -251,6 +260,20 @@ typedef struct
     uint32_t   count;        /*!< DMA Transfer Size */
 } dma_trans_data_t;
 
+/* DMA Link Mode Descriptor, read by the DMAC in place of the Next Register Sets.
+   Must be DMA_LINK_DESC_ALIGN aligned. */
+typedef struct
+{
+    uint32_t   header;          /*!< DMA_LINK_HEADER_xx */
+    uint32_t   src_addr;        /*!< Source Address */
+    uint32_t   dst_addr;        /*!< Destination Address */
+    uint32_t   count;           /*!< DMA Transfer Size */
+    uint32_t   chcfg;           /*!< CHCFG loaded for this descriptor */
+    uint32_t   chitvl;          /*!< CHITVL loaded for this descriptor */
+    uint32_t   chext;           /*!< CHEXT loaded for this descriptor */
+    uint32_t   next_link_addr;  /*!< Address of the next descriptor */
+} dma_link_desc_t;
+
 /***********************************************************************************
  Function Prototypes
 ***********************************************************************************/
@@ -377,6 +400,62 @@ extern int_t R_DMA_NextData(const int_t channel, const dma_trans_data_t * const
 extern int_t R_DMA_Cancel(const int_t channel, uint32_t * const p_remain, int32_t * const p_errno);
 
 
+/***********************************************************************************
+* @brief       This function builds a link mode descriptor chain for a channel
+*              set up with R_DMA_Setup(). Every descriptor raises the DMA end
+*              interrupt when it completes. A cyclic chain links the last
+*              descriptor back to the first and keeps running until
+*              R_DMA_Cancel(), otherwise the channel stops after the last.
+*
+* @param[in] channel:      set up channel.
+* @param[out] p_desc:      count descriptors, DMA_LINK_DESC_ALIGN aligned.
+* @param[in] p_dma_data:   count transfers, one per descriptor.
+* @param[in] count:        number of descriptors.
+* @param[in] cyclic:       link the last descriptor to the first.
+* @param[in/out] p_errno:  Get error code.
+*                          (when p_errno is NULL, erroc code isn't set.)
+*
+* @retval IOIF_ESUCCESS:  Successfully built.
+* @retval -1:             Error occurred.
+***********************************************************************************/
+
+extern int_t R_DMA_LinkSetup(const int_t channel, dma_link_desc_t * const p_desc,
+                             const dma_trans_data_t * const p_dma_data, const uint32_t count,
+                             const bool_t cyclic, int32_t * const p_errno);
+
+/***********************************************************************************
+* @brief       This function starts a channel on a chain built by
+*              R_DMA_LinkSetup(). The channel needs no further CPU
+*              involvement until it is cancelled.
+*
+* @param[in] channel:      DMA start channel.
+* @param[in] p_desc:       first descriptor of the chain.
+* @param[in/out] p_errno:  Get error code.
+*                          (when p_errno is NULL, erroc code isn't set.)
+*
+* @retval IOIF_ESUCCESS:  Successfully DMA start.
+* @retval -1:             Error occurred.
+***********************************************************************************/
+
+extern int_t R_DMA_LinkStart(const int_t channel, const dma_link_desc_t * const p_desc,
+                             int32_t * const p_errno);
+
+/***********************************************************************************
+* @brief       This function reads the position of a link mode transfer.
+*
+* @param[in] channel:      DMA channel.
+* @param[out] p_link_addr: address of the descriptor being transferred.
+* @param[out] p_remain:    remain size of its transfer.
+* @param[in/out] p_errno:  Get error code.
+*                          (when p_errno is NULL, erroc code isn't set.)
+*
+* @retval IOIF_ESUCCESS:  Successfully read.
+* @retval -1:             Error occurred.
+***********************************************************************************/
+
+extern int_t R_DMA_LinkPosition(const int_t channel, uint32_t * const p_link_addr, uint32_t * const p_remain,
+                                int32_t * const p_errno);
+
 /***********************************************************************************
 * @brief This function get DMA driver version.
 *
@@ -59,6 +59,7 @@ typedef enum _NVDT
     NVDT_DHCP_SETTINGS_V1,
     NVDT_TEST_IP_ADDR_AND_PORT_V1,
     NVDT_LOGINS_AND_PASSWORDS_V1,
+    NVDT_AUDIO_SETTINGS_V1,
 
     /* TODO: Add other non volatile settings here.
        The laws of compatibility:
@@ -103,6 +104,17 @@ typedef struct _NVUSERS
     int8_t          *pszList;
 } NVUSERS;
 
+/* Define the data structure for the NVDT_AUDIO_SETTINGS_V1 data type. It is
+   kept in the journal, so it must not grow beyond 4 bytes */
+typedef struct _NVAUDIO
+{
+    int16_t         sVolume;            /* quarter dB steps, 0 or below */
+    uint8_t         byInput;            /* input selected with the button */
+    uint8_t         byReserved;
+
+} NVAUDIO,
+*PNVAUDIO;
+
 /* TODO: Add other non volatile structures here
    The laws of compatibility:
    If you need to change a structure don't edit it! Take a copy of the
@@ -160,7 +172,9 @@ extern  int nvLoad(NVDT nvDataType, void *pvDest, size_t stLength);
 
 /*****************************************************************************
 Function Name: nvStore
-Description:   Function to store settings to non volatile memory
+Description:   Function to store settings to non volatile memory. Only a RAM
+               copy is changed, so this does not wait for the EEPROM. A task
+               writes the changed pages once the stores stop.
 Arguments:     IN  nvDataType - The data type to load
                IN  pvSrc - Pointer to the data structure to store
                IN  stLength - The length of the destination memory
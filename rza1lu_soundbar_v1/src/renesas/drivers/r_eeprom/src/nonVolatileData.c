@@ -0,0 +1,821 @@
+/******************************************************************************
+* DISCLAIMER
+* This software is supplied by Renesas Electronics Corporation and is only
+* intended for use with Renesas products. No other uses are authorized. This
+* software is owned by Renesas Electronics Corporation and is protected under
+* all applicable laws, including copyright laws.
+* THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+* THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+* LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+* AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+* TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+* ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+* FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+* ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+* BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+* Renesas reserves the right, without notice, to make changes to this software
+* and to discontinue the availability of this software. By using this software,
+* you agree to the additional terms and conditions found by accessing the
+* following link:
+* http://www.renesas.com/disclaimer
+*******************************************************************************
+* Copyright (C) 2012 Renesas Electronics Corporation. All rights reserved.
+*******************************************************************************
+* File Name    : nonVolatileData.c
+* Version      : 1.02
+* Device(s)    : Renesas
+* Tool-Chain   : GNUARM-NONE-EABI v14.02
+* OS           : None
+* H/W Platform : Renesas
+* Description  : Functions to store and recall data from non-volatile memory
+*******************************************************************************
+* History      : DD.MM.YYYY Version Description
+*              : 04.02.2010 1.00    First Release
+*              : 10.06.2010 1.01    Updated type definitions
+*              : 17.10.2026 1.02    RAM copy flushed in the background,
+*                                   journal for frequently changed settings
+******************************************************************************/
+
+/******************************************************************************
+  WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+  OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+  SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+******************************************************************************/
+
+/*
+    The EEPROM is used to hold the Media Access Control Address (MAC) for
+    the Ethernet controller. This address is programmed during production
+    into the first 7 bytes of the memory.
+
+    The remainder of the memory can be used for storing other non volatile
+    parameters. In this case the first two bytes of each data entry contain
+    a the length and the type of the data. The first entry on the list is
+    positioned at NV_USER_DATA_START_OFFSET.
+
+    The restrictions are that there may not be more than 254 data types and
+    the maximum length of data is 246 bytes.
+
+    The whole of the memory is copied into RAM on first use. nvLoad reads the
+    copy and nvStore only changes it, so neither waits for the EEPROM after
+    the first call. A task writes the changed pages some time after the last
+    store, so a burst of stores costs one write of each page.
+
+    Settings that change often, such as the volume, are not kept in the list.
+    Each store appends a record to a journal in the upper 256 bytes of the
+    memory, which the list has never used, overwriting the oldest, so the
+    writes are spread over all of its pages. The list stays in the lower
+    256 bytes where existing boards have it. Records carry a sequence number; the newest record of a
+    type with a good CRC is the one loaded, so a write interrupted by a power
+    cut leaves the previous value.
+*/
+
+/******************************************************************************
+Includes   <System Includes> , "Project Includes"
+******************************************************************************/
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "nonVolatileData.h"
+#include "r_os_abstraction_api.h"
+#include "r_task_priority.h"
+
+/******************************************************************************
+Typedef definitions
+******************************************************************************/
+/* Define the structure of the data header */
+typedef struct _NVHDR
+{
+    uint8_t         byLength;
+    uint8_t         byDataType;
+
+} NVHDR,
+*PNVHDR;
+
+/* Define the structure of a journal record, one EEPROM page */
+typedef struct _NVJREC
+{
+    uint8_t         bySequence;
+    uint8_t         byDataType;
+    uint8_t         pbyData[4];
+    uint16_t        usCRC;
+
+} NVJREC,
+*PNVJREC;
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+
+#define NV_USER_DATA_START_OFFSET   8UL
+                                    /* Data header + 16 bit CRC */
+#define NV_MIN_DATA_LENGTH          (sizeof(NVHDR) + sizeof(uint16_t))
+                                    /* 0x0 and OxFF are reserved as list
+                                       termination values */
+#define NV_MAX_DATA_LENGTH          0xFE
+
+                                    /* Both 256 byte blocks of the EEPROM,
+                                       the driver selects the block */
+#define NV_MEMORY_SIZE              512UL
+                                    /* The list of data is kept in the first
+                                       block as it always has been */
+#define NV_RECORD_AREA_END          256UL
+                                    /* Page write buffer of the EEPROM, one
+                                       bit of gullNvDirty per page */
+#define NV_PAGE_SIZE                8UL
+#define NV_PAGES                    (NV_MEMORY_SIZE / NV_PAGE_SIZE)
+
+                                    /* Journal fills the second block */
+#define NV_JOURNAL_OFFSET           NV_RECORD_AREA_END
+#define NV_JOURNAL_SLOTS            ((NV_MEMORY_SIZE - NV_JOURNAL_OFFSET) / sizeof(NVJREC))
+#define NV_JOURNAL_DATA_LENGTH      (sizeof(((PNVJREC) 0)->pbyData))
+
+                                    /* Time after the last store before the
+                                       changed pages are written */
+#define NV_FLUSH_DELAY_MS           2000UL
+
+                                    /* The Ethernet controller only loads the
+                                       MAC address when this is the first
+                                       byte */
+#define NV_MAC_LOAD_MARKER          0xA5
+
+/* Comment this line out to turn ON module trace in this file */
+#undef _TRACE_ON_
+
+#ifndef _TRACE_ON_
+#undef TRACE
+#define TRACE(x)
+#endif
+
+/******************************************************************************
+Imported global variables and functions (from other files)
+******************************************************************************/
+
+/******************************************************************************
+Exported global variables and functions (to be accessed by other files)
+******************************************************************************/
+
+/* The data tables for the CRC function */
+const uint8_t       gpbyC16l[] =
+{
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+};
+
+const uint8_t       gbyC16h[] =
+{
+    0x00, 0xC0, 0xC1, 0x01, 0xC3, 0x03, 0x02, 0xC2,
+    0xC6, 0x06, 0x07, 0xC7, 0x05, 0xC5, 0xC4, 0x04,
+    0xCC, 0x0C, 0x0D, 0xCD, 0x0F, 0xCF, 0xCE, 0x0E,
+    0x0A, 0xCA, 0xCB, 0x0B, 0xC9, 0x09, 0x08, 0xC8,
+    0xD8, 0x18, 0x19, 0xD9, 0x1B, 0xDB, 0xDA, 0x1A,
+    0x1E, 0xDE, 0xDF, 0x1F, 0xDD, 0x1D, 0x1C, 0xDC,
+    0x14, 0xD4, 0xD5, 0x15, 0xD7, 0x17, 0x16, 0xD6,
+    0xD2, 0x12, 0x13, 0xD3, 0x11, 0xD1, 0xD0, 0x10,
+    0xF0, 0x30, 0x31, 0xF1, 0x33, 0xF3, 0xF2, 0x32,
+    0x36, 0xF6, 0xF7, 0x37, 0xF5, 0x35, 0x34, 0xF4,
+    0x3C, 0xFC, 0xFD, 0x3D, 0xFF, 0x3F, 0x3E, 0xFE,
+    0xFA, 0x3A, 0x3B, 0xFB, 0x39, 0xF9, 0xF8, 0x38,
+    0x28, 0xE8, 0xE9, 0x29, 0xEB, 0x2B, 0x2A, 0xEA,
+    0xEE, 0x2E, 0x2F, 0xEF, 0x2D, 0xED, 0xEC, 0x2C,
+    0xE4, 0x24, 0x25, 0xE5, 0x27, 0xE7, 0xE6, 0x26,
+    0x22, 0xE2, 0xE3, 0x23, 0xE1, 0x21, 0x20, 0xE0,
+    0xA0, 0x60, 0x61, 0xA1, 0x63, 0xA3, 0xA2, 0x62,
+    0x66, 0xA6, 0xA7, 0x67, 0xA5, 0x65, 0x64, 0xA4,
+    0x6C, 0xAC, 0xAD, 0x6D, 0xAF, 0x6F, 0x6E, 0xAE,
+    0xAA, 0x6A, 0x6B, 0xAB, 0x69, 0xA9, 0xA8, 0x68,
+    0x78, 0xB8, 0xB9, 0x79, 0xBB, 0x7B, 0x7A, 0xBA,
+    0xBE, 0x7E, 0x7F, 0xBF, 0x7D, 0xBD, 0xBC, 0x7C,
+    0xB4, 0x74, 0x75, 0xB5, 0x77, 0xB7, 0xB6, 0x76,
+    0x72, 0xB2, 0xB3, 0x73, 0xB1, 0x71, 0x70, 0xB0,
+    0x50, 0x90, 0x91, 0x51, 0x93, 0x53, 0x52, 0x92,
+    0x96, 0x56, 0x57, 0x97, 0x55, 0x95, 0x94, 0x54,
+    0x9C, 0x5C, 0x5D, 0x9D, 0x5F, 0x9F, 0x9E, 0x5E,
+    0x5A, 0x9A, 0x9B, 0x5B, 0x99, 0x59, 0x58, 0x98,
+    0x88, 0x48, 0x49, 0x89, 0x4B, 0x8B, 0x8A, 0x4A,
+    0x4E, 0x8E, 0x8F, 0x4F, 0x8D, 0x4D, 0x4C, 0x8C,
+    0x44, 0x84, 0x85, 0x45, 0x87, 0x47, 0x46, 0x86,
+    0x82, 0x42, 0x43, 0x83, 0x41, 0x81, 0x80, 0x40,
+};
+
+/******************************************************************************
+Function Prototypes
+******************************************************************************/
+
+static int nvInit(void);
+static int nvFindEntry(NVDT nvDataType, size_t stLength, size_t *pstPos);
+static void nvStoreData(NVDT nvDataType, const void *pvSrc, size_t stLength, size_t stPos);
+static int nvIsJournalled(NVDT nvDataType);
+static int nvJournalFind(NVDT nvDataType);
+static void nvJournalScan(void);
+static void nvJournalAppend(NVDT nvDataType, const void *pvSrc, size_t stLength);
+static void nvShadowWrite(size_t stOffset, const void *pvSrc, size_t stLength);
+static int nvFlushDirty(void);
+static void nvFlushTask(void *pvParameters);
+static uint16_t vnCalcCrC(const uint8_t *pbyData, size_t stLength);
+
+/******************************************************************************
+Private global variables
+******************************************************************************/
+
+/* RAM copy of the memory and one bit for each page that differs from it */
+static uint8_t gpbyNvShadow[NV_MEMORY_SIZE];
+static uint64_t gullNvDirty = 0ULL;
+static int gbNvLoaded = 0;
+static int gbNvLoadTried = 0;
+
+/* Snapshot of the copy taken by the flush so stores can carry on during it */
+static uint8_t gpbyNvFlushCopy[NV_MEMORY_SIZE];
+
+/* The slot the next journal record goes in and its sequence number */
+static uint32_t gulNvJournalNext = 0UL;
+static uint8_t gbyNvJournalSequence = 0U;
+
+/* gpvNvMutex guards the copy, gpvNvFlushMutex keeps one flush at a time */
+static void *gpvNvMutex = NULL;
+static void *gpvNvFlushMutex = NULL;
+static event_t gpvNvFlushEvent = NULL;
+
+/******************************************************************************
+Public Functions
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name: nvLoad
+* Description  : Function to load settings from non volatile memory
+* Arguments    : IN  nvDataType - The data type to load
+*                OUT pvDest - Pointer to the destination
+*                IN  stLength - The length of the destination memory
+* Return Value : 0 for success -1 on error
+*****************************************************************************/
+int nvLoad(NVDT nvDataType, void *pvDest, size_t stLength)
+{
+    int iResult = -1;
+
+    if (nvInit() == 0)
+    {
+        R_OS_AcquireMutex(gpvNvMutex);
+
+        if (nvIsJournalled(nvDataType))
+        {
+            int iSlot = nvJournalFind(nvDataType);
+
+            if ((iSlot >= 0) && (stLength <= NV_JOURNAL_DATA_LENGTH))
+            {
+                PNVJREC pRecord = (PNVJREC) &gpbyNvShadow[NV_JOURNAL_OFFSET + ((size_t) iSlot * sizeof(NVJREC))];
+
+                memcpy(pvDest, pRecord->pbyData, stLength);
+                iResult = 0;
+            }
+        }
+        else
+        {
+            size_t stPos;
+            int iLength = nvFindEntry(nvDataType, stLength, &stPos);
+
+            if (iLength > 0)
+            {
+                /* A 16 bit CRC is added at the end of the data section */
+                size_t stRead = (size_t) iLength - NV_MIN_DATA_LENGTH;
+                uint16_t usFileCRC;
+
+                memcpy(&usFileCRC, &gpbyNvShadow[stPos + sizeof(NVHDR) + stRead], sizeof(uint16_t));
+
+                /* Check the CRC's match */
+                if (usFileCRC == vnCalcCrC(&gpbyNvShadow[stPos + sizeof(NVHDR)], stRead))
+                {
+                    memcpy(pvDest, &gpbyNvShadow[stPos + sizeof(NVHDR)], stRead);
+                    iResult = 0;
+                }
+            }
+        }
+
+        R_OS_ReleaseMutex(gpvNvMutex);
+    }
+
+    return iResult;
+}
+/*****************************************************************************
+End of function  nvLoad
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name: nvStore
+* Description  : Function to store settings to non volatile memory. Only the
+*                RAM copy is changed, the flush task writes the EEPROM.
+* Arguments    : IN  nvDataType - The data type to load
+*                IN  pvSrc - Pointer to the data structure to store
+*                IN  stLength - The length of the destination memory
+* Return Value : 0 for success -1 on error
+*****************************************************************************/
+int nvStore(NVDT nvDataType, const void *pvSrc, size_t stLength)
+{
+    int iResult = -1;
+    uint8_t byData = NV_MAC_LOAD_MARKER;
+
+    if (nvInit() == 0)
+    {
+        R_OS_AcquireMutex(gpvNvMutex);
+
+        if (nvIsJournalled(nvDataType))
+        {
+            if (stLength <= NV_JOURNAL_DATA_LENGTH)
+            {
+                nvJournalAppend(nvDataType, pvSrc, stLength);
+                iResult = 0;
+            }
+        }
+        else if ((stLength + NV_MIN_DATA_LENGTH) <= NV_MAX_DATA_LENGTH)
+        {
+            size_t stPos;
+
+            /* Settings already exist so overwrite them, otherwise add to the end of the list */
+            if ((nvFindEntry(nvDataType, stLength, &stPos) > 0)
+            ||  ((stPos + stLength + NV_MIN_DATA_LENGTH) <= NV_RECORD_AREA_END))
+            {
+                nvStoreData(nvDataType, pvSrc, stLength, stPos);
+                iResult = 0;
+            }
+        }
+
+        /* The Ethernet controller will only auto-load the MAC address
+           if the first byte in the EEROM is 0xA5. Make sure that it is
+           always present */
+        nvShadowWrite(0UL, &byData, 1UL);
+
+        R_OS_ReleaseMutex(gpvNvMutex);
+
+        if (gullNvDirty)
+        {
+            R_OS_SetEvent(&gpvNvFlushEvent);
+        }
+    }
+
+    return iResult;
+}
+/*****************************************************************************
+End of function  nvStore
+******************************************************************************/
+
+/******************************************************************************
+Private global variables and functions
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name: nvInit
+* Description  : Function to create the flush task and read the EEPROM into
+*                the RAM copy on first use
+* Arguments    : none
+* Return Value : 0 when the RAM copy is valid -1 on error
+*****************************************************************************/
+static int nvInit(void)
+{
+    if (NULL == gpvNvMutex)
+    {
+        gpvNvMutex = R_OS_CreateMutex();
+        gpvNvFlushMutex = R_OS_CreateMutex();
+        R_OS_CreateEvent(&gpvNvFlushEvent);
+
+        R_OS_CreateTask("NV Flush", nvFlushTask, NULL, R_OS_ABSTRACTION_PRV_DEFAULT_STACK_SIZE,
+                        TASK_NV_FLUSH_PRI);
+    }
+
+    if ((NULL == gpvNvMutex) || (NULL == gpvNvFlushMutex))
+    {
+        return -1;
+    }
+
+    R_OS_AcquireMutex(gpvNvMutex);
+
+    /* Read once. If the EEPROM could not be read nothing is stored, the
+       copy must never be written over the MAC address, and later calls do
+       not wait for the bus to time out again */
+    if (!gbNvLoadTried)
+    {
+        FILE *pFile = fopen("\\\\.\\eeprom", "r");
+
+        gbNvLoadTried = 1;
+
+        if (pFile)
+        {
+            if (fread(gpbyNvShadow, 1UL, NV_MEMORY_SIZE, pFile) == NV_MEMORY_SIZE)
+            {
+                nvJournalScan();
+                gullNvDirty = 0ULL;
+                gbNvLoaded = 1;
+            }
+
+            fclose(pFile);
+        }
+    }
+
+    R_OS_ReleaseMutex(gpvNvMutex);
+
+    return gbNvLoaded ? 0 : -1;
+}
+/*****************************************************************************
+End of function  nvInit
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name: nvFindEntry
+* Description  : Function to look for a data type in the list in the RAM copy
+* Arguments    : IN  nvDataType - The data type to find
+*                IN  stLength - The length of the caller's data
+*                OUT pstPos - The position of the entry, or of the end of the
+*                             list if it is not found
+* Return Value : The length of the entry or 0 if it was not found
+*****************************************************************************/
+static int nvFindEntry(NVDT nvDataType, size_t stLength, size_t *pstPos)
+{
+    size_t stPos = NV_USER_DATA_START_OFFSET;
+
+    /* Until the end of the list */
+    while ((stPos + sizeof(NVHDR)) <= NV_RECORD_AREA_END)
+    {
+        /* Get the length of the entry */
+        int iLength = gpbyNvShadow[stPos];
+
+        /* Check that it is valid, an entry running into the journal ends the list */
+        if ((iLength <= (int) NV_MIN_DATA_LENGTH) || (iLength > NV_MAX_DATA_LENGTH)
+        ||  ((stPos + (size_t) iLength) > NV_RECORD_AREA_END))
+        {
+            break;
+        }
+
+        /* Check for a type and length match */
+        if ((gpbyNvShadow[stPos + 1UL] == (uint8_t) nvDataType)
+        &&  (stLength >= ((size_t) iLength - NV_MIN_DATA_LENGTH)))
+        {
+            *pstPos = stPos;
+            return iLength;
+        }
+
+        /* Add on the length of this data segment and move to the next */
+        stPos += (size_t) iLength;
+    }
+
+    *pstPos = stPos;
+    return 0;
+}
+/*****************************************************************************
+End of function  nvFindEntry
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name: nvStoreData
+* Description  : Function to write an entry of the list to the RAM copy
+* Arguments    : IN  nvDataType - The data type to store
+*                IN  pvSrc - Pointer to the data structure to store
+*                IN  stLength - The length of the data
+*                IN  stPos - The position of the entry
+* Return Value : none
+*****************************************************************************/
+static void nvStoreData(NVDT nvDataType, const void *pvSrc, size_t stLength, size_t stPos)
+{
+    NVHDR nvHeader;
+    uint16_t usCRC = vnCalcCrC(pvSrc, stLength);
+
+    /* The length of the data + the length of the header + the length of the CRC */
+    nvHeader.byLength = (uint8_t) (stLength + NV_MIN_DATA_LENGTH);
+
+    /* The type of data - last byte of header */
+    nvHeader.byDataType = (uint8_t) nvDataType;
+
+    nvShadowWrite(stPos, &nvHeader, sizeof(NVHDR));
+    nvShadowWrite(stPos + sizeof(NVHDR), pvSrc, stLength);
+    nvShadowWrite(stPos + sizeof(NVHDR) + stLength, &usCRC, sizeof(uint16_t));
+}
+/*****************************************************************************
+End of function  nvStoreData
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name: nvIsJournalled
+* Description  : Function to check if a data type is kept in the journal
+* Arguments    : IN  nvDataType - The data type
+* Return Value : true for the small settings that change often
+*****************************************************************************/
+static int nvIsJournalled(NVDT nvDataType)
+{
+    switch (nvDataType)
+    {
+        case NVDT_AUDIO_SETTINGS_V1:
+        {
+            return 1;
+        }
+
+        default:
+        {
+            return 0;
+        }
+    }
+}
+/*****************************************************************************
+End of function  nvIsJournalled
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name: nvJournalFind
+* Description  : Function to find the newest good journal record of a type
+* Arguments    : IN  nvDataType - The data type
+* Return Value : The slot of the record or -1 if there is none
+*****************************************************************************/
+static int nvJournalFind(NVDT nvDataType)
+{
+    uint32_t ulCount;
+    uint32_t ulSlot = gulNvJournalNext;
+
+    /* Search back from the newest record */
+    for (ulCount = 0UL; ulCount < NV_JOURNAL_SLOTS; ulCount++)
+    {
+        PNVJREC pRecord;
+
+        ulSlot = (ulSlot + NV_JOURNAL_SLOTS - 1UL) % NV_JOURNAL_SLOTS;
+        pRecord = (PNVJREC) &gpbyNvShadow[NV_JOURNAL_OFFSET + (ulSlot * sizeof(NVJREC))];
+
+        if ((pRecord->byDataType == (uint8_t) nvDataType)
+        &&  (pRecord->usCRC == vnCalcCrC((const uint8_t *) pRecord, offsetof(NVJREC, usCRC))))
+        {
+            return (int) ulSlot;
+        }
+    }
+
+    return -1;
+}
+/*****************************************************************************
+End of function  nvJournalFind
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name: nvJournalScan
+* Description  : Function to find the slot after the newest journal record.
+*                Records are written to the slots in turn with sequence
+*                numbers one apart, so the newest is a good record that is not
+*                followed by a good record with the next sequence number.
+* Arguments    : none
+* Return Value : none
+*****************************************************************************/
+static void nvJournalScan(void)
+{
+    uint32_t ulSlot;
+
+    gulNvJournalNext = 0UL;
+    gbyNvJournalSequence = 0U;
+
+    for (ulSlot = 0UL; ulSlot < NV_JOURNAL_SLOTS; ulSlot++)
+    {
+        PNVJREC pRecord = (PNVJREC) &gpbyNvShadow[NV_JOURNAL_OFFSET + (ulSlot * sizeof(NVJREC))];
+        PNVJREC pNext = (PNVJREC) &gpbyNvShadow[NV_JOURNAL_OFFSET
+                                                + (((ulSlot + 1UL) % NV_JOURNAL_SLOTS) * sizeof(NVJREC))];
+
+        if ((pRecord->usCRC == vnCalcCrC((const uint8_t *) pRecord, offsetof(NVJREC, usCRC)))
+        &&  ((pNext->usCRC != vnCalcCrC((const uint8_t *) pNext, offsetof(NVJREC, usCRC)))
+        ||   (pNext->bySequence != (uint8_t) (pRecord->bySequence + 1U))))
+        {
+            gulNvJournalNext = (ulSlot + 1UL) % NV_JOURNAL_SLOTS;
+            gbyNvJournalSequence = (uint8_t) (pRecord->bySequence + 1U);
+            break;
+        }
+    }
+}
+/*****************************************************************************
+End of function  nvJournalScan
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name: nvJournalAppend
+* Description  : Function to add a record to the journal in the RAM copy,
+*                unless the newest record of the type holds the same data
+* Arguments    : IN  nvDataType - The data type to store
+*                IN  pvSrc - Pointer to the data to store
+*                IN  stLength - The length of the data
+* Return Value : none
+*****************************************************************************/
+static void nvJournalAppend(NVDT nvDataType, const void *pvSrc, size_t stLength)
+{
+    NVJREC nvRecord;
+    int iSlot = nvJournalFind(nvDataType);
+
+    nvRecord.bySequence = gbyNvJournalSequence;
+    nvRecord.byDataType = (uint8_t) nvDataType;
+    memset(nvRecord.pbyData, 0xFF, NV_JOURNAL_DATA_LENGTH);
+    memcpy(nvRecord.pbyData, pvSrc, stLength);
+
+    if ((iSlot >= 0)
+    &&  (0 == memcmp(((PNVJREC) &gpbyNvShadow[NV_JOURNAL_OFFSET + ((size_t) iSlot * sizeof(NVJREC))])->pbyData,
+                     nvRecord.pbyData, NV_JOURNAL_DATA_LENGTH)))
+    {
+        /* No change, save a write */
+        return;
+    }
+
+    nvRecord.usCRC = vnCalcCrC((const uint8_t *) &nvRecord, offsetof(NVJREC, usCRC));
+
+    nvShadowWrite(NV_JOURNAL_OFFSET + (gulNvJournalNext * sizeof(NVJREC)), &nvRecord, sizeof(NVJREC));
+
+    gulNvJournalNext = (gulNvJournalNext + 1UL) % NV_JOURNAL_SLOTS;
+    gbyNvJournalSequence++;
+}
+/*****************************************************************************
+End of function  nvJournalAppend
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name: nvShadowWrite
+* Description  : Function to change the RAM copy and mark the pages that now
+*                differ from the EEPROM. Call with gpvNvMutex held.
+* Arguments    : IN  stOffset - The position in the memory
+*                IN  pvSrc - Pointer to the data
+*                IN  stLength - The length of the data
+* Return Value : none
+*****************************************************************************/
+static void nvShadowWrite(size_t stOffset, const void *pvSrc, size_t stLength)
+{
+    const uint8_t *pbySrc = (const uint8_t *) pvSrc;
+
+    while (stLength--)
+    {
+        if (gpbyNvShadow[stOffset] != *pbySrc)
+        {
+            gpbyNvShadow[stOffset] = *pbySrc;
+            gullNvDirty |= (1ULL << (stOffset / NV_PAGE_SIZE));
+        }
+
+        stOffset++;
+        pbySrc++;
+    }
+}
+/*****************************************************************************
+End of function  nvShadowWrite
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name: nvFlushDirty
+* Description  : Function to write the changed pages of the RAM copy to the
+*                EEPROM, each run of adjacent pages in one write. Pages that
+*                fail are marked again for the next flush.
+* Arguments    : none
+* Return Value : 0 for success -1 on error
+*****************************************************************************/
+static int nvFlushDirty(void)
+{
+    uint64_t ullDirty;
+    uint64_t ullFailed = 0ULL;
+    uint32_t ulPage = 0UL;
+
+    R_OS_AcquireMutex(gpvNvFlushMutex);
+
+    /* Take the changes, stores made from here on mark the pages again */
+    R_OS_AcquireMutex(gpvNvMutex);
+    ullDirty = gullNvDirty;
+    gullNvDirty = 0ULL;
+    memcpy(gpbyNvFlushCopy, gpbyNvShadow, NV_MEMORY_SIZE);
+    R_OS_ReleaseMutex(gpvNvMutex);
+
+    if (ullDirty)
+    {
+        FILE *pFile = fopen("\\\\.\\eeprom", "r+");
+
+        while (ulPage < NV_PAGES)
+        {
+            uint32_t ulRun = 0UL;
+            uint64_t ullMask;
+
+            /* Find the next run of changed pages */
+            while ((ulPage < NV_PAGES) && (!(ullDirty & (1ULL << ulPage))))
+            {
+                ulPage++;
+            }
+
+            while (((ulPage + ulRun) < NV_PAGES) && (ullDirty & (1ULL << (ulPage + ulRun))))
+            {
+                ulRun++;
+            }
+
+            if (0UL == ulRun)
+            {
+                break;
+            }
+
+            ullMask = ((ulRun < 64UL) ? ((1ULL << ulRun) - 1ULL) : ~0ULL) << ulPage;
+
+            if ((NULL == pFile)
+            ||  (fseek(pFile, (long) (ulPage * NV_PAGE_SIZE), SEEK_SET))
+            ||  (fwrite(&gpbyNvFlushCopy[ulPage * NV_PAGE_SIZE], 1UL, ulRun * NV_PAGE_SIZE, pFile)
+                 != (ulRun * NV_PAGE_SIZE))
+            ||  (fflush(pFile)))
+            {
+                ullFailed |= ullMask;
+            }
+
+            ulPage += ulRun;
+        }
+
+        if (pFile)
+        {
+            fclose(pFile);
+        }
+
+        if (ullFailed)
+        {
+            R_OS_AcquireMutex(gpvNvMutex);
+            gullNvDirty |= ullFailed;
+            R_OS_ReleaseMutex(gpvNvMutex);
+        }
+    }
+
+    R_OS_ReleaseMutex(gpvNvFlushMutex);
+
+    return ullFailed ? -1 : 0;
+}
+/*****************************************************************************
+End of function  nvFlushDirty
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name: nvFlushTask
+* Description  : Task to write the RAM copy to the EEPROM once the stores
+*                have stopped for NV_FLUSH_DELAY_MS. A failed write is tried
+*                again after the next store.
+* Arguments    : IN  pvParameters - not used
+* Return Value : none
+*****************************************************************************/
+static void nvFlushTask(void *pvParameters)
+{
+    (void) pvParameters;
+
+    while (1)
+    {
+        R_OS_WaitForEvent(&gpvNvFlushEvent, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
+
+        /* Let a burst of stores settle, each store restarts the wait */
+        do
+        {
+            R_OS_ResetEvent(&gpvNvFlushEvent);
+        } while (R_OS_WaitForEvent(&gpvNvFlushEvent, NV_FLUSH_DELAY_MS));
+
+        nvFlushDirty();
+    }
+}
+/*****************************************************************************
+End of function  nvFlushTask
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name: vnCalcCrC
+* Description  : Function to calaculate a 16bit CRC check number
+* Arguments    : IN  pbyData - Pointer to the data to sum
+*                IN  stLength - The length of the data
+* Return Value : The 16bit CRC
+*****************************************************************************/
+static uint16_t vnCalcCrC(const uint8_t *pbyData, size_t stLength)
+{
+    uint8_t byTableValue;
+    uint16_t usCRC = 0;
+
+    while (stLength--)
+    {
+        byTableValue = (uint8_t) (((uint8_t) usCRC) ^ *pbyData++);
+        usCRC = (uint16_t) (((gbyC16h[byTableValue]) << 8)
+              + (gpbyC16l[byTableValue] ^ (uint8_t) ((usCRC) >> 8)));
+    }
+
+    return usCRC;
+}
+/*****************************************************************************
+End of function  vnCalcCrC
+******************************************************************************/
+
+/*****************************************************************************
+End  Of File
+******************************************************************************/
@@ -70,6 +70,19 @@
  * */
 #define EE_MEMORY_SIZE              (512UL)        // 512 for Stream-It! EEPROM (4 k bit -> 1/2 k byte)
 
+/* Page write buffer of the device, a write must not cross a page boundary */
+#define EE_PAGE_SIZE                (8u)
+
+/* The word address is one byte, the ninth address bit is bit 1 of the device
+ * address. Offsets 0 to 255 are the block at EEPROM_SLAVE_ADDRESS, as they
+ * always have been, and 256 to 511 the other block */
+#define EE_BLOCK_SIZE               (256u)
+#define EE_DEVICE_ADDRESS(a)        ((uint8_t) (EEPROM_SLAVE_ADDRESS ^ ((((a) / EE_BLOCK_SIZE) & 1u) << 1)))
+
+/* Longest internal write cycle, tWR is 5ms for the CAT24C04. The device does
+ * not acknowledge its address until the cycle has finished */
+#define EE_WRITE_CYCLE_MAX_MS       (10u)
+
 /* Comment this line out to turn ON module trace in this file */
 #undef _TRACE_ON_
 
@@ -111,6 +124,7 @@ static int_t romGetVersion (st_stream_ptr_t p_stream, st_ver_info_t *p_ver_info)
 
 static e_eeprom_error_t eeprom_write (uint16_t address, const void *data, size_t length);
 static e_eeprom_error_t eeprom_read (uint16_t address, void *data, size_t length);
+static e_eeprom_error_t eeprom_wait_ready (int_t iic0_handle, uint16_t address);
 
 /*****************************************************************************
  Constant Data
@@ -372,7 +386,7 @@ static int_t romGetVersion (st_stream_ptr_t p_stream, st_ver_info_t *p_ver_info)
 /***********************************************************************************************************************
  * Function Name: eeprom_write
  * Description  : Write data to EEPROM memory
- * Arguments    : uint8_t address - memory location where to write data
+ * Arguments    : uint16_t address - memory location where to write data
  *              : const void *data - pointer to the data to be written
  *              : size_t length - number of data bytes
  * Return Value : error_t - error code
@@ -382,6 +396,7 @@ static e_eeprom_error_t eeprom_write (uint16_t address, const void *data, size_t
     e_eeprom_error_t error = EEPROM_ERROR;
     size_t block_length;
     const uint8_t *p_data;
+    uint8_t word_address;
     int_t iic0_handle = ( -1);
     st_r_drv_riic_create_t riic_clock;
 
@@ -409,9 +424,6 @@ static e_eeprom_error_t eeprom_write (uint16_t address, const void *data, size_t
                 /* i2c access control structure */
                 st_r_drv_riic_config_t i2c_write;
 
-                /* configure i2c device address on channel */
-                i2c_write.device_address = EEPROM_SLAVE_ADDRESS;
-
                 /* riic successfully created and configured */
                 error = EEPROM_NO_ERROR;
 
@@ -420,13 +432,15 @@ static e_eeprom_error_t eeprom_write (uint16_t address, const void *data, size_t
                 {
 
                     /* Prevent page write operations that would attempt to cross a page boundary */
-                    block_length = (uint8_t) (8 - (address % 8));
+                    block_length = (uint8_t) (EE_PAGE_SIZE - (address % EE_PAGE_SIZE));
 
                     /* Limit the number of bytes to write */
                     block_length = MIN(block_length, length);
 
-                    /* configure eeprom memory address and number of bytes */
-                    i2c_write.sub_address = &address;
+                    /* configure eeprom memory address and number of bytes, pages never cross a block */
+                    word_address = (uint8_t) address;
+                    i2c_write.device_address = EE_DEVICE_ADDRESS(address);
+                    i2c_write.sub_address = &word_address;
                     i2c_write.number_of_bytes = block_length;
 
                     /* buffer is not declared as const, so cast to char * to avoid warning */
@@ -442,13 +456,13 @@ static e_eeprom_error_t eeprom_write (uint16_t address, const void *data, size_t
                         p_data += block_length;
 
                         /* Increment word address */
-                        address = (uint8_t) (address + block_length);
+                        address = (uint16_t) (address + block_length);
 
                         /* Remaining bytes to be written */
                         length -= block_length;
 
-                        /* allow some time for EEPROM to complete write process */
-                        R_OS_TaskSleep(5);
+                        /* poll for the end of the write cycle rather than sleeping for the worst case */
+                        error = eeprom_wait_ready(iic0_handle, address);
                     }
                 }
             }
@@ -468,10 +482,49 @@ static e_eeprom_error_t eeprom_write (uint16_t address, const void *data, size_t
  End of function eeprom_write
  *****************************************************************************/
 
+/***********************************************************************************************************************
+ * Function Name: eeprom_wait_ready
+ * Description  : Wait for the EEPROM to finish its internal write cycle by addressing it until it acknowledges.
+ *                Each poll is a start, the device address, the word address and a stop, about 0.3ms at 100kHz.
+ * Arguments    : int_t iic0_handle - open and configured I2C channel
+ *              : uint16_t address - memory location sent with each poll
+ * Return Value : error_t - error code, EEPROM_ERROR if the device is still busy after EE_WRITE_CYCLE_MAX_MS
+ ***********************************************************************************************************************/
+static e_eeprom_error_t eeprom_wait_ready (int_t iic0_handle, uint16_t address)
+{
+    st_r_drv_riic_config_t i2c_poll;
+    uint8_t word_address = (uint8_t) address;
+    uint32_t waited_ms;
+
+    /* a write of no data, the device NACKs its address while the write cycle is running */
+    i2c_poll.device_address = EE_DEVICE_ADDRESS(address);
+    i2c_poll.sub_address = &word_address;
+    i2c_poll.number_of_bytes = 0;
+    i2c_poll.p_data_buffer = NULL;
+
+    for (waited_ms = 0u; waited_ms < EE_WRITE_CYCLE_MAX_MS; waited_ms++)
+    {
+        /* the cycle has only just started, give the bus to other devices for a tick first */
+        R_OS_TaskSleep(1);
+
+        if (0 == control(iic0_handle, CTL_RIIC_WRITE, &i2c_poll))
+        {
+            return (EEPROM_NO_ERROR);
+        }
+    }
+
+    TRACE(("eeprom_wait_ready: no ACK after write\r\n"));
+
+    return (EEPROM_ERROR);
+}
+/*****************************************************************************
+ End of function eeprom_wait_ready
+ *****************************************************************************/
+
 /***********************************************************************************************************************
  * Function Name: eeprom_read
  * Description  : Read data from EEPROM memory
- * Arguments    : uint8_t address - memory location where to read data
+ * Arguments    : uint16_t address - memory location where to read data
  *              : const void *data - pointer to the buffer where to copy the data
  *              : size_t length - number of data bytes to read
  * Return Value : error_t - error code
@@ -480,6 +533,8 @@ static e_eeprom_error_t eeprom_read (uint16_t address, void *data, size_t length
 {
     e_eeprom_error_t error = EEPROM_ERROR;
     uint8_t *p_data;
+    uint8_t word_address;
+    size_t block_length;
     int_t iic0_handle = ( -1);
     st_r_drv_riic_create_t riic_clock;
 
@@ -492,20 +547,12 @@ static e_eeprom_error_t eeprom_read (uint16_t address, void *data, size_t length
         /* i2c access control structure */
         st_r_drv_riic_config_t i2c_read;
 
-        /* configure eeprom device address on i2c channel */
-        i2c_read.device_address = EEPROM_SLAVE_ADDRESS;
-
         /* Acquire exclusive access to the EEPROM */
         R_OS_AcquireMutex(gsp_eeprom_mutex);
 
         /* Cast data pointer */
         p_data = (uint8_t *) data;
 
-        /* configure eeprom memory address and number of bytes */
-        i2c_read.sub_address = address;
-        i2c_read.number_of_bytes = length;
-        i2c_read.p_data_buffer = p_data;
-
         /* open the I2C channel0 driver */
         iic0_handle = open(DEVICE_INDENTIFIER "iic0", O_RDWR);
 
@@ -516,11 +563,28 @@ static e_eeprom_error_t eeprom_read (uint16_t address, void *data, size_t length
             if (0 == control(iic0_handle, CTL_RIIC_CREATE, &riic_clock))
             {
                 /* riic successfully created and configured */
+                error = EEPROM_NO_ERROR;
 
-                /* read data from eeprom */
-                if (0 == control(iic0_handle, CTL_RIIC_READ, &i2c_read))
+                /* read data from eeprom, one block at a time */
+                while ((length > 0) && (EEPROM_NO_ERROR == error))
                 {
-                    error = EEPROM_NO_ERROR;
+                    block_length = MIN(EE_BLOCK_SIZE - (address % EE_BLOCK_SIZE), length);
+
+                    /* configure eeprom memory address and number of bytes */
+                    word_address = (uint8_t) address;
+                    i2c_read.device_address = EE_DEVICE_ADDRESS(address);
+                    i2c_read.sub_address = &word_address;
+                    i2c_read.number_of_bytes = block_length;
+                    i2c_read.p_data_buffer = p_data;
+
+                    if (0 != control(iic0_handle, CTL_RIIC_READ, &i2c_read))
+                    {
+                        error = EEPROM_ERROR;
+                    }
+
+                    p_data += block_length;
+                    address = (uint16_t) (address + block_length);
+                    length -= block_length;
                 }
             }
         }
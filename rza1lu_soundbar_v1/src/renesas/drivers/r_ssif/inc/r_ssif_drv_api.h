@@ -97,6 +97,9 @@
  * \arg \b R_SSIF_CONTROL_STATUS Report SSIF status, uses parameter @ref st_r_ssif_drv_control_t <BR>
  * \arg \b R_SSIF_AIO_READ_CONTROL Configure SSIF to read, uses parameter @ref aiocb <BR>
  * \arg \b R_SSIF_AIO_WRITE_CONTROL Configure SSIF to write, uses parameter @ref aiocb <BR>
+ * \arg \b R_SSIF_CYCLIC_WRITE_START Transmit from a looping period buffer, uses parameter @ref st_r_ssif_cyclic_t <BR>
+ * \arg \b R_SSIF_CYCLIC_WRITE_STOP Return to queued writes, uses parameter @ref st_r_ssif_cyclic_t <BR>
+ * \arg \b R_SSIF_CYCLIC_WRITE_POSITION Byte offset being transmitted, uses parameter uint32_t <BR>
  *
  * \c ssif_get_version - Get driver version<BR>
  */
@@ -133,7 +136,10 @@ typedef enum
     R_SSIF_READ_CONTROL,
     R_SSIF_WRITE_CONTROL,
     R_SSIF_AIO_READ_CONTROL,        /*!< Configure SSIF to read, uses parameter @ref aiocb */
-    R_SSIF_AIO_WRITE_CONTROL        /*!< Configure SSIF to write, uses parameter @ref aiocb */
+    R_SSIF_AIO_WRITE_CONTROL,       /*!< Configure SSIF to write, uses parameter @ref aiocb */
+    R_SSIF_CYCLIC_WRITE_START,      /*!< Transmit from a looping period buffer, uses parameter @ref st_r_ssif_cyclic_t */
+    R_SSIF_CYCLIC_WRITE_STOP,       /*!< Return to queued writes, uses parameter @ref st_r_ssif_cyclic_t */
+    R_SSIF_CYCLIC_WRITE_POSITION    /*!< Byte offset in the buffer being transmitted, uses parameter uint32_t */
 } e_control_codes_ssif_t;
 
 typedef struct st_r_ssif_drv_control_t
@@ -144,6 +150,18 @@ typedef struct st_r_ssif_drv_control_t
 
 } st_r_ssif_drv_control_t;
 
+/** Cyclic transmit. The DMA runs over period_count periods of p_buf by itself
+ *  with no gap on reload, p_aio is completed at the end of every period with
+ *  aio_return set to the index of the period just transmitted, which may then
+ *  be refilled. write() is refused while cyclic transmit runs. */
+typedef struct st_r_ssif_cyclic_t
+{
+        void     *p_buf;            /*!< period_count * period_size bytes, word aligned */
+        uint32_t period_size;       /*!< bytes per period */
+        uint32_t period_count;      /*!< 2 to SSIF_CYCLIC_MAX_PERIODS */
+        AIOCB    *p_aio;            /*!< period callback, called in the DMA end interrupt */
+} st_r_ssif_cyclic_t;
+
     #define SSIF_CONTROL
 
 #endif /* R_SSIF_DRV_API */
@@ -100,6 +100,9 @@ Macro definitions
 
 #define SSIF_MAX_PATH_LEN           (32u)
 
+/** Most periods in a cyclic transmit buffer */
+#define SSIF_CYCLIC_MAX_PERIODS     (16u)
+
 #define SSIF_CR_SHIFT_CKS   (30u)
 #define SSIF_CR_SHIFT_TUIEN (29u)
 #define SSIF_CR_SHIFT_TOIEN (28u)
@@ -250,6 +253,11 @@ typedef struct ssif_info_ch
     AIOCB*      p_aio_tx_next;
     AIOCB*      p_aio_rx_curr;
     AIOCB*      p_aio_rx_next;
+    AIOCB*      p_aio_tx_cyclic;        /* period callback, NULL unless transmit runs in cyclic mode */
+    uint8_t*    p_tx_cyclic_buf;
+    uint32_t    tx_cyclic_period_size;
+    uint32_t    tx_cyclic_periods;
+    uint32_t    tx_cyclic_index;        /* period the DMA is transmitting */
     ssif_chcfg_cks_t                clk_select;
     ssif_chcfg_multi_ch_t           multi_ch;
     ssif_chcfg_data_word_t          data_word;
@@ -382,6 +390,37 @@ void SSIF_CancelDMA(const ssif_info_ch_t* const p_info_ch);
  **/
 int_t SSIF_RestartDMA(ssif_info_ch_t* const p_info_ch);
 
+/**
+ * @brief Switch transmit from queued requests to a DMA descriptor chain that
+ *        loops over period_count periods of p_buf without CPU involvement.
+ *        p_aio is completed at the end of every period with aio_return set to
+ *        the index of the period just transmitted.
+ * @param[in,out] p_info_ch    :channel object.
+ * @param[in]     p_buf        :periods, contiguous.
+ * @param[in]     period_size  :bytes per period.
+ * @param[in]     period_count :2 to SSIF_CYCLIC_MAX_PERIODS.
+ * @param[in]     p_aio        :period callback.
+ * @return        DEVDRV_SUCCESS   :Success.
+ *                error code       :Failure, IOIF_EBUSY while requests are queued.
+ **/
+int_t SSIF_StartCyclicDMA(ssif_info_ch_t* const p_info_ch, void* const p_buf, const uint32_t period_size,
+                const uint32_t period_count, AIOCB* const p_aio);
+
+/**
+ * @brief Stop cyclic transmit and return to queued requests.
+ * @param[in,out] p_info_ch  :channel object.
+ **/
+void SSIF_StopCyclicDMA(ssif_info_ch_t* const p_info_ch);
+
+/**
+ * @brief Byte offset in the cyclic buffer the DMA is transmitting from.
+ * @param[in]     p_info_ch  :channel object.
+ * @param[out]    p_offset   :offset from the start of the buffer.
+ * @return        DEVDRV_SUCCESS   :Success.
+ *                error code       :Failure, cyclic mode is not running.
+ **/
+int_t SSIF_GetCyclicPosition(const ssif_info_ch_t* const p_info_ch, uint32_t* const p_offset);
+
 /**
  * @brief Convert SSICR:SWL bits to system word length
  * @param[in]     ssicr_swl  :SSICR register SWL field value(0 to 7)
@@ -290,6 +290,34 @@ static int_t ssif_control (st_stream_ptr_t pStream, uint32_t ctlCode, void *pCtl
             }
             break;
 
+            case R_SSIF_CYCLIC_WRITE_START:
+            {
+                st_r_ssif_cyclic_t *p_cyclic = pCtlStruct;
+
+                if (IOIF_ESUCCESS == SSIF_StartCyclicDMA(gsp_info_ch, p_cyclic->p_buf, p_cyclic->period_size,
+                        p_cyclic->period_count, p_cyclic->p_aio))
+                {
+                    result = DEVDRV_SUCCESS;
+                }
+            }
+            break;
+
+            case R_SSIF_CYCLIC_WRITE_STOP:
+            {
+                SSIF_StopCyclicDMA(gsp_info_ch);
+                result = DEVDRV_SUCCESS;
+            }
+            break;
+
+            case R_SSIF_CYCLIC_WRITE_POSITION:
+            {
+                if (IOIF_ESUCCESS == SSIF_GetCyclicPosition(gsp_info_ch, (uint32_t *) pCtlStruct))
+                {
+                    result = DEVDRV_SUCCESS;
+                }
+            }
+            break;
+
             default:
             {
                 result = DEVDRV_ERROR;
@@ -324,8 +352,8 @@ static int_t ssif_write (st_stream_ptr_t pStream, uint8_t *pbyBuffer, uint32_t u
     if (O_RDONLY != pStream->file_flag)
     {
 
-        /* Ensure that the ssif is configured correctly */
-        if ((NULL == gsp_info_ch) || (NULL == gsp_aio_w))
+        /* Ensure that the ssif is configured correctly and not transmitting a cyclic buffer */
+        if ((NULL == gsp_info_ch) || (NULL == gsp_aio_w) || (NULL != gsp_info_ch->p_aio_tx_cyclic))
         {
             ercd = DEVDRV_ERROR;
         }
@@ -343,6 +343,9 @@ int_t SSIF_DisableChannel(ssif_info_ch_t* const p_info_ch)
                 __enable_irq();
             }
 
+            /* closing leaves cyclic mode, the chain has already been cancelled with the DMA */
+            p_info_ch->p_aio_tx_cyclic = NULL;
+
             /* cancel event to ongoing request */
             if (NULL != p_info_ch->p_aio_tx_curr)
             {
@@ -767,6 +770,7 @@ static int_t SSIF_InitChannel(ssif_info_ch_t* const p_info_ch)
 
             p_info_ch->p_aio_tx_curr = NULL;       /* tx request pointer */
             p_info_ch->p_aio_tx_next = NULL;       /* tx request pointer */
+            p_info_ch->p_aio_tx_cyclic = NULL;     /* tx queued mode */
             p_info_ch->p_aio_rx_curr = NULL;       /* rx request pointer */
             p_info_ch->p_aio_rx_next = NULL;       /* rx request pointer */
         }
@@ -68,6 +68,10 @@ Private global variables and functions
 
 static void SSIF_DMA_TxCallback(union sigval param);
 static void SSIF_DMA_RxCallback(union sigval param);
+static void SSIF_DMA_CyclicTxCallback(union sigval param);
+static dma_link_desc_t* SSIF_TxLinkDesc(const uint32_t ssif_ch);
+static int_t SSIF_StartTxLink(ssif_info_ch_t* const p_info_ch);
+static int_t SSIF_StartTxDummy(ssif_info_ch_t* const p_info_ch);
 
 static const dma_res_select_t gb_ssif_dma_tx_resource[SSIF_NUM_CHANS] =
 {
@@ -106,6 +110,10 @@ static dma_trans_data_t gb_ssif_rxdma_dummy_trparam[SSIF_NUM_CHANS];
 static uint32_t ssif_tx_dummy_buf[SSIF_DUMMY_DMA_BUF_SIZE / sizeof(uint32_t)];
 static uint32_t ssif_rx_dummy_buf[SSIF_DUMMY_DMA_BUF_SIZE / sizeof(uint32_t)];
 
+/* descriptor chains for cyclic transmit, aligned by SSIF_TxLinkDesc */
+static uint8_t gb_ssif_tx_link_mem[SSIF_NUM_CHANS][(SSIF_CYCLIC_MAX_PERIODS * sizeof(dma_link_desc_t))
+                                                   + DMA_LINK_DESC_ALIGN];
+
 /******************************************************************************
 * Function Name: SSIF_InitDMA
 * @brief         Allocate and Setup DMA_CH for specified SSIF channel.
@@ -543,7 +551,12 @@ int_t SSIF_RestartDMA(ssif_info_ch_t* const p_info_ch)
         /* start DMA dummy transfer for write(if necessary) */
         if (IOIF_ESUCCESS == ercd)
         {
-            if (O_RDONLY != p_info_ch->openflag)
+            if ((O_RDONLY != p_info_ch->openflag) && (NULL != p_info_ch->p_aio_tx_cyclic))
+            {
+                /* resume the descriptor chain from the period that was interrupted */
+                ercd = SSIF_StartTxLink(p_info_ch);
+            }
+            else if (O_RDONLY != p_info_ch->openflag)
             {
                 /* setup short dummy transfer */
                 gb_ssif_txdma_dummy_trparam[ssif_ch].src_addr = (void*)&ssif_tx_dummy_buf[0];
@@ -564,6 +577,10 @@ int_t SSIF_RestartDMA(ssif_info_ch_t* const p_info_ch)
                     }
                 }
             }
+            else
+            {
+                /* read only */
+            }
         }
 
         /* start DMA dummy transfer for read(if necessary) */
@@ -670,10 +687,290 @@ void SSIF_CancelDMA(const ssif_info_ch_t* const p_info_ch)
     return;
 }
 
+/******************************************************************************
+* Function Name: SSIF_StartCyclicDMA
+* @brief         Switch transmit to a cyclic descriptor chain.
+*
+*                Description:<br>
+*                The DMA loops over the periods by itself, p_aio is completed
+*                at the end of every period so the caller can refill it.
+*                Queued write requests are refused until SSIF_StopCyclicDMA.
+* @param[in,out] p_info_ch    :channel object.
+* @param[in]     p_buf        :periods, contiguous.
+* @param[in]     period_size  :bytes per period.
+* @param[in]     period_count :number of periods.
+* @param[in]     p_aio        :period callback.
+* @retval        IOIF_ESUCCESS   :Success.
+* @retval        error code :Failure.
+******************************************************************************/
+int_t SSIF_StartCyclicDMA(ssif_info_ch_t* const p_info_ch, void* const p_buf, const uint32_t period_size,
+                const uint32_t period_count, AIOCB* const p_aio)
+{
+    int_t ercd = IOIF_ESUCCESS;
+    int32_t dma_ercd;
+    uint32_t remain;
+
+    if ((NULL == p_info_ch) || (NULL == p_buf) || (NULL == p_aio))
+    {
+        ercd = IOIF_EFAULT;
+    }
+    else if ((period_count < 2u) || (period_count > SSIF_CYCLIC_MAX_PERIODS) || (0u == period_size)
+            || (0u != (period_size % sizeof(uint32_t))) || (O_RDONLY == p_info_ch->openflag))
+    {
+        ercd = IOIF_EINVAL;
+    }
+    else if ((NULL != p_info_ch->p_aio_tx_curr) || (NULL != p_info_ch->p_aio_tx_next)
+            || (NULL != p_info_ch->p_aio_tx_cyclic))
+    {
+        /* queued requests have to finish first */
+        ercd = IOIF_EBUSY;
+    }
+    else
+    {
+        /* stop the dummy transfer the channel idles on */
+        if (IOIF_EERROR == R_DMA_Cancel(p_info_ch->dma_tx_ch, &remain, &dma_ercd))
+        {
+            /* NON_NOTICE_ASSERT: dummy transfer had already ended */
+        }
+
+        p_info_ch->p_tx_cyclic_buf = (uint8_t*)p_buf;
+        p_info_ch->tx_cyclic_period_size = period_size;
+        p_info_ch->tx_cyclic_periods = period_count;
+        p_info_ch->tx_cyclic_index = 0u;
+        p_info_ch->p_aio_tx_cyclic = p_aio;
+
+        ercd = SSIF_StartTxLink(p_info_ch);
+
+        if (IOIF_ESUCCESS != ercd)
+        {
+            /* fall back to queued mode so the channel keeps running */
+            p_info_ch->p_aio_tx_cyclic = NULL;
+            (void)SSIF_StartTxDummy(p_info_ch);
+        }
+    }
+
+    return ercd;
+}
+
+/******************************************************************************
+* Function Name: SSIF_StopCyclicDMA
+* @brief         Stop cyclic transmit and return to queued requests.
+*
+*                Description:<br>
+*
+* @param[in,out] p_info_ch  :channel object.
+* @retval        none
+******************************************************************************/
+void SSIF_StopCyclicDMA(ssif_info_ch_t* const p_info_ch)
+{
+    int32_t dma_ercd;
+    uint32_t remain;
+
+    if ((NULL == p_info_ch) || (NULL == p_info_ch->p_aio_tx_cyclic))
+    {
+        /* NON_NOTICE_ASSERT: not in cyclic mode */
+    }
+    else
+    {
+        if (IOIF_EERROR == R_DMA_Cancel(p_info_ch->dma_tx_ch, &remain, &dma_ercd))
+        {
+            /* NON_NOTICE_ASSERT: unexpected dma error */
+        }
+
+        p_info_ch->p_aio_tx_cyclic = NULL;
+
+        if (IOIF_ESUCCESS != SSIF_StartTxDummy(p_info_ch))
+        {
+            /* NON_NOTICE_ASSERT: unexpected dma error */
+        }
+    }
+
+    return;
+}
+
+/******************************************************************************
+* Function Name: SSIF_GetCyclicPosition
+* @brief         Byte offset in the cyclic buffer the DMA is transmitting from.
+*
+*                Description:<br>
+*
+* @param[in]     p_info_ch  :channel object.
+* @param[out]    p_offset   :offset from the start of the buffer.
+* @retval        IOIF_ESUCCESS   :Success.
+* @retval        error code :Failure.
+******************************************************************************/
+int_t SSIF_GetCyclicPosition(const ssif_info_ch_t* const p_info_ch, uint32_t* const p_offset)
+{
+    int_t ercd = IOIF_ESUCCESS;
+    int32_t dma_ercd;
+    uint32_t link_addr;
+    uint32_t remain;
+    uint32_t index;
+
+    if ((NULL == p_info_ch) || (NULL == p_offset) || (NULL == p_info_ch->p_aio_tx_cyclic))
+    {
+        ercd = IOIF_EFAULT;
+    }
+    else if (IOIF_EERROR == R_DMA_LinkPosition(p_info_ch->dma_tx_ch, &link_addr, &remain, &dma_ercd))
+    {
+        ercd = IOIF_EIO;
+    }
+    else
+    {
+        index = (link_addr - (uint32_t)SSIF_TxLinkDesc(p_info_ch->channel)) / sizeof(dma_link_desc_t);
+
+        if ((index >= p_info_ch->tx_cyclic_periods) || (remain > p_info_ch->tx_cyclic_period_size))
+        {
+            /* between descriptors, the next period starts now */
+            index = p_info_ch->tx_cyclic_index;
+            remain = p_info_ch->tx_cyclic_period_size;
+        }
+
+        *p_offset = (index * p_info_ch->tx_cyclic_period_size) + (p_info_ch->tx_cyclic_period_size - remain);
+    }
+
+    return ercd;
+}
+
 /******************************************************************************
 Private functions
 ******************************************************************************/
 
+/******************************************************************************
+* Function Name: SSIF_TxLinkDesc
+* @brief         Descriptor chain storage of a channel.
+*
+*                Description:<br>
+*
+* @param[in]     ssif_ch    :channel number.
+* @retval        first descriptor, DMA_LINK_DESC_ALIGN aligned.
+******************************************************************************/
+static dma_link_desc_t* SSIF_TxLinkDesc(const uint32_t ssif_ch)
+{
+    uint32_t addr = (uint32_t)&gb_ssif_tx_link_mem[ssif_ch][0];
+
+    addr = (addr + (DMA_LINK_DESC_ALIGN - 1u)) & ~(DMA_LINK_DESC_ALIGN - 1u);
+
+    return (dma_link_desc_t*)addr;
+}
+
+/******************************************************************************
+* Function Name: SSIF_StartTxLink
+* @brief         Setup the write DMA_CH with the cyclic chain and start it at
+*                tx_cyclic_index.
+*
+*                Description:<br>
+*
+* @param[in,out] p_info_ch  :channel object.
+* @retval        IOIF_ESUCCESS   :Success.
+* @retval        error code :Failure.
+******************************************************************************/
+static int_t SSIF_StartTxLink(ssif_info_ch_t* const p_info_ch)
+{
+    int_t ercd = IOIF_ESUCCESS;
+    int32_t dma_ercd;
+    uint32_t ssif_ch = p_info_ch->channel;
+    uint32_t period;
+    dma_ch_setup_t dma_ch_setup;
+    dma_trans_data_t dma_data[SSIF_CYCLIC_MAX_PERIODS];
+    dma_link_desc_t* const p_desc = SSIF_TxLinkDesc(ssif_ch);
+    AIOCB* const p_tx_aio = &gb_ssif_dma_tx_end_aiocb[ssif_ch];
+
+    p_tx_aio->aio_sigevent.sigev_notify = SIGEV_THREAD;
+    p_tx_aio->aio_sigevent.sigev_value.sival_ptr = (void*)p_info_ch;
+    p_tx_aio->aio_sigevent.sigev_notify_function = &SSIF_DMA_CyclicTxCallback;
+
+    dma_ch_setup.resource = gb_ssif_dma_tx_resource[ssif_ch];
+    dma_ch_setup.direction = DMA_REQ_DES;
+    dma_ch_setup.dst_width = DMA_UNIT_4;
+    dma_ch_setup.src_width = DMA_UNIT_4;
+    dma_ch_setup.dst_cnt = DMA_ADDR_FIX;
+    dma_ch_setup.src_cnt = DMA_ADDR_INCREMENT;
+    dma_ch_setup.p_aio = p_tx_aio;
+
+    for (period = 0u; period < p_info_ch->tx_cyclic_periods; period++)
+    {
+        dma_data[period].src_addr = (void*)&p_info_ch->p_tx_cyclic_buf[period * p_info_ch->tx_cyclic_period_size];
+        dma_data[period].dst_addr = (void*)&g_ssireg[ssif_ch]->SSIFTDR;
+        dma_data[period].count = p_info_ch->tx_cyclic_period_size;
+    }
+
+    if (IOIF_EERROR == R_DMA_Setup(p_info_ch->dma_tx_ch, &dma_ch_setup, &dma_ercd))
+    {
+        ercd = IOIF_EFAULT;
+    }
+    else if (IOIF_EERROR == R_DMA_LinkSetup(p_info_ch->dma_tx_ch, p_desc, &dma_data[0],
+                    p_info_ch->tx_cyclic_periods, true, &dma_ercd))
+    {
+        ercd = IOIF_EFAULT;
+    }
+    else if (IOIF_EERROR == R_DMA_LinkStart(p_info_ch->dma_tx_ch, &p_desc[p_info_ch->tx_cyclic_index], &dma_ercd))
+    {
+        ercd = IOIF_EFAULT;
+    }
+    else
+    {
+        /* running */
+    }
+
+    return ercd;
+}
+
+/******************************************************************************
+* Function Name: SSIF_StartTxDummy
+* @brief         Setup the write DMA_CH for queued requests and start it on
+*                the dummy transfer.
+*
+*                Description:<br>
+*
+* @param[in,out] p_info_ch  :channel object.
+* @retval        IOIF_ESUCCESS   :Success.
+* @retval        error code :Failure.
+******************************************************************************/
+static int_t SSIF_StartTxDummy(ssif_info_ch_t* const p_info_ch)
+{
+    int_t ercd = IOIF_ESUCCESS;
+    int32_t dma_ercd;
+    uint32_t ssif_ch = p_info_ch->channel;
+    dma_ch_setup_t dma_ch_setup;
+    AIOCB* const p_tx_aio = &gb_ssif_dma_tx_end_aiocb[ssif_ch];
+
+    p_tx_aio->aio_sigevent.sigev_notify = SIGEV_THREAD;
+    p_tx_aio->aio_sigevent.sigev_value.sival_ptr = (void*)p_info_ch;
+    p_tx_aio->aio_sigevent.sigev_notify_function = &SSIF_DMA_TxCallback;
+
+    dma_ch_setup.resource = gb_ssif_dma_tx_resource[ssif_ch];
+    dma_ch_setup.direction = DMA_REQ_DES;
+    dma_ch_setup.dst_width = DMA_UNIT_4;
+    dma_ch_setup.src_width = DMA_UNIT_4;
+    dma_ch_setup.dst_cnt = DMA_ADDR_FIX;
+    dma_ch_setup.src_cnt = DMA_ADDR_INCREMENT;
+    dma_ch_setup.p_aio = p_tx_aio;
+
+    gb_ssif_txdma_dummy_trparam[ssif_ch].src_addr = (void*)&ssif_tx_dummy_buf[0];
+    gb_ssif_txdma_dummy_trparam[ssif_ch].dst_addr = (void*)&g_ssireg[ssif_ch]->SSIFTDR;
+    gb_ssif_txdma_dummy_trparam[ssif_ch].count = SSIF_DUMMY_DMA_TRN_SIZE;
+
+    if (IOIF_EERROR == R_DMA_Setup(p_info_ch->dma_tx_ch, &dma_ch_setup, &dma_ercd))
+    {
+        ercd = IOIF_EFAULT;
+    }
+    else if (IOIF_EERROR == R_DMA_NextData(p_info_ch->dma_tx_ch, &gb_ssif_txdma_dummy_trparam[ssif_ch], &dma_ercd))
+    {
+        ercd = IOIF_EFAULT;
+    }
+    else if (IOIF_EERROR == R_DMA_Start(p_info_ch->dma_tx_ch, &gb_ssif_txdma_dummy_trparam[ssif_ch], &dma_ercd))
+    {
+        ercd = IOIF_EFAULT;
+    }
+    else
+    {
+        /* running */
+    }
+
+    return ercd;
+}
+
 /******************************************************************************
 * Function Name: SSIF_DMA_TxCallback
 * @brief         DMA callback function
@@ -816,3 +1113,44 @@ static void SSIF_DMA_RxCallback(const union sigval param)
 
     return;
 }
+
+/******************************************************************************
+* Function Name: SSIF_DMA_CyclicTxCallback
+* @brief         DMA callback function in cyclic mode, once per period
+*
+*                Description:<br>
+*                The chain reloads itself, only the caller is told which
+*                period has been transmitted.
+* @param[in]     param      :callback param
+* @retval        none
+******************************************************************************/
+static void SSIF_DMA_CyclicTxCallback(const union sigval param)
+{
+    ssif_info_ch_t* const p_info_ch = param.sival_ptr;
+    AIOCB* p_aio;
+
+    if (NULL == p_info_ch)
+    {
+        /* NON_NOTICE_ASSERT: illegal pointer */
+    }
+    else
+    {
+        p_aio = p_info_ch->p_aio_tx_cyclic;
+
+        if (NULL != p_aio)
+        {
+            p_aio->aio_return = (ssize_t)p_info_ch->tx_cyclic_index;
+
+            p_info_ch->tx_cyclic_index++;
+
+            if (p_info_ch->tx_cyclic_index >= p_info_ch->tx_cyclic_periods)
+            {
+                p_info_ch->tx_cyclic_index = 0u;
+            }
+
+            ahf_complete(NULL, p_aio);
+        }
+    }
+
+    return;
+}
@@ -48,6 +48,7 @@
 #include "gpio_iobitmask.h"
 #include "sound_dae6.h"
 #include "r_soundbar.h"
+#include "r_media_library.h"
 #include "r_switch_driver.h"
 
 #include "command.h"
@@ -212,6 +213,9 @@ int_t main (void)
     gpio_init(LED0);
     gpio_dir( LED0, PIN_OUTPUT);
 
+    /* Index the drives as the disk manager mounts them */
+    r_media_library_init();
+
     /* Create a task to blink the LED */
     p_os_task = R_OS_CreateTask("Blink", blink_task, NULL, R_OS_ABSTRACTION_PRV_DEFAULT_STACK_SIZE, TASK_BLINK_TASK_PRI);
 
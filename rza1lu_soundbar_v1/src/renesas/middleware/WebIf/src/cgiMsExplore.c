@@ -40,6 +40,7 @@
  ******************************************************************************/
 
 #include <ctype.h>
+#include <stdlib.h>
 #include <fcntl.h>
 #include "websys.h"
 #include "webCGI.h"
@@ -49,6 +50,7 @@
 #include "r_os_abstraction_api.h"
 #include "r_fatfs_abstraction.h"
 #include "r_timer.h"
+#include "scsiRBC.h"
 
 /******************************************************************************
  Defines
@@ -62,9 +64,23 @@
  time the browser page was loaded */
 #define BD_CLIENT_PATH_CACHE_SIZE   (16)
 #define BD_CLIENT_PATH_LENGTH       (1024)
+/* Directory indexes kept so that paging through a listing, changing the sort
+ and going back up to the parent do not read the directory again */
+#define BD_INDEX_CACHE_SIZE         (4)
+/* The first allocations of an index, doubled as the directory is read */
+#define BD_INDEX_INITIAL_ENTRIES    (64)
+#define BD_INDEX_INITIAL_NAMES      (2048)
+/* FAT directories are limited to 65536 entries, which includes the "." and
+ ".." entries, so the sort orders can be arrays of 16 bit positions */
+#define BD_INDEX_MAX_ENTRIES        (0xFFFF)
+/* The directory filled with files by the directory index benchmark */
+#define BD_BENCH_DIR                "/DIRBENCH"
 
 #define MAX_BUFFER_SIZE_PRV_        (256 * 1024)
 
+/* The number of READ 10 commands kept in the queue by the raw read test */
+#define MS_TEST_QUEUE_DEPTH         (4)
+
 /******************************************************************************
  Constant Macros
  ******************************************************************************/
@@ -100,17 +116,60 @@ typedef enum _SESRT
     DIR_SORT_BY_NONE = 0, DIR_SORT_BY_NAME, DIR_SORT_BY_DATE, DIR_SORT_BY_SIZE
 } SESRT, *PSESRT;
 
+/* The keys a directory index is sorted by. Each DSORT is one of these read
+ forwards or backwards */
+typedef enum _DKEY
+{
+    DIR_KEY_NAME = 0, DIR_KEY_DATE, DIR_KEY_SIZE, DIR_KEY_NUM
+} DKEY;
+
 /******************************************************************************
  Typedefs
  ******************************************************************************/
 
-typedef struct _DLST
+/* An entry in a directory index */
+typedef struct _DIENT
 {
-    struct _DLST *pNext;
-    FATENTRY     fatEntry;
-} DLST, *PDLST;
-
-typedef _Bool (* const PDCMP) (PDLST pDLST, PDLST pNew);
+    /* Offset of the name in the name pool of the index */
+    unsigned long ulName;
+    unsigned long ulSize;
+    /* The FAT date and time packed so that a later time compares greater */
+    unsigned long ulDate;
+    unsigned char byAttrib;
+    unsigned char byNameLength;
+} DIENT, *PDIENT;
+
+/* The index of one directory. It is built once by reading the directory and
+ stays valid until R_FAT_GetChangeCount moves on */
+typedef struct _DIDX
+{
+    /* The drive and directory path the index is of */
+    char          chDrive;
+    char          pszDir[BD_CLIENT_PATH_LENGTH];
+    /* R_FAT_GetChangeCount before the directory was read */
+    unsigned long ulChangeCount;
+    /* Least Recently Used count to identify which index to replace */
+    unsigned long ulLRU;
+    /* The entries in the order they were read, NULL when not in use */
+    PDIENT        pEntry;
+    int           iDirCount;
+    int           iFileCount;
+    /* The names of the entries, each terminated */
+    char          *pszNames;
+    size_t        stNamesLength;
+    /* The positions in pEntry sorted in ascending order. The directories
+     are only ever listed by name */
+    unsigned short *pusOrder;
+    unsigned short *pusDirOrder;
+    unsigned short *ppusFileOrder[DIR_KEY_NUM];
+} DIDX, *PDIDX;
+
+/* How a DSORT is read from an index */
+typedef struct _DORDER
+{
+    DKEY  dirKey;
+    _Bool bfDescending;
+} DORDER;
 
 
 /* This is the data that is required by almost every function used to generate
@@ -143,9 +202,8 @@ typedef struct _HTDIR
     _Bool    bfGetPrev;
     /* Flag to get the next page */
     _Bool    bfGetNext;
-    /* The sorted lists */
-    PDLST    pDirList;
-    PDLST    pFileList;
+    /* The index of the directory */
+    PDIDX    pIndex;
 } HTDIR, *PHTDIR;
 
 typedef struct _MSTEST
@@ -158,12 +216,41 @@ typedef struct _MSTEST
     char      pszWriteSpeed[64];
     char      pszReadSpeed[64];
     char      pszTestResult[64];
+    char      pszWriteLatency[192];
+    char      pszReadLatency[192];
+    char      pszRawRead[128];
 } MSTEST, *PMSTEST;
 
+/* Shared by the raw read test and the completion of its queued commands */
+typedef struct _MSQTEST
+{
+    MSREQ     pMsReq[MS_TEST_QUEUE_DEPTH];
+    event_t   evComplete;
+    volatile uint32_t dwCompleted;
+    volatile _Bool bfError;
+} MSQTEST, *PMSQTEST;
+
 /******************************************************************************
  Constant Data
  ******************************************************************************/
 
+/* The index key and direction of each DSORT */
+static const DORDER gcpSortOrder[DIR_SORT_NUM] =
+{
+    /* DIR_SORT_BY_NAME_A_Z */
+    { DIR_KEY_NAME, false },
+    /* DIR_SORT_BY_NAME_Z_A */
+    { DIR_KEY_NAME, true },
+    /* DIR_SORT_BY_DATE_RECENT */
+    { DIR_KEY_DATE, true },
+    /* DIR_SORT_BY_DATE_OLD */
+    { DIR_KEY_DATE, false },
+    /* DIR_SORT_BY_SIZE_LARGE */
+    { DIR_KEY_SIZE, true },
+    /* DIR_SORT_BY_SIZE_SMALL */
+    { DIR_KEY_SIZE, false }
+};
+
 /* Nothing inserted */
 static const char * const gcpszHeader = "<table width=\"100%%\" height=\"315\" border=\"0\">\r\n<tr>\r\n"
         "<td height=\"300\" colspan=\"2\" valign=\"top\">\r\n<pre>\r\n";
@@ -239,12 +326,31 @@ static const char * const gcpszNoFatLib = "<table width=\"100%%\" height=\"250\"
         "td>\r\n<td>&nbsp;</td>\r\n</tr>\r\n<tr>\r\n<td>&nbsp;</td>\r\n"
         "<td>&nbsp;</td>\r\n<td>&nbsp;</td>\r\n</tr>\r\n</table>\r\n";
 
+/* 1. Number of files requested
+ 2. Time to create them in seconds
+ 3. Directory entries
+ 4. File entries
+ 5. Bytes used by the index
+ 6. Time to build the index from cold in mS
+ 7. Time to find the index again in uS
+ 8. Pages served in every sort order
+ 9. Average time to serve a page in uS */
+static const char * const pcpszBenchResults = "<div><p>Directory: " BD_BENCH_DIR "</p></div>\r\n"
+        "<div><p>Files requested: %d, created in %lu S</p></div>\r\n"
+        "<div><p>Index of %d directories and %d files uses %lu bytes</p></div>\r\n"
+        "<div><p>Index build: %lu mS</p></div>\r\n"
+        "<div><p>Index lookup: %lu uS</p></div>\r\n"
+        "<div><p>%d pages served, average %lu uS</p></div>\r\n";
+
 static const char * const pcpszTestInProgress = "<div><p align=\"center\"><img src=\"images/spinner3-black.gif\""
         " width=\"36\" height=\"36\" /></p></div>\r\n";
 
 static const char * const pcpszTestResults = "<div><p>File: %s</p></div>\r\n"
         "<div><p>%s</p></div>\r\n"
         "<div><p>%s</p></div>\r\n"
+        "<div><p>%s</p></div>\r\n"
+        "<div><p>Write commands: %s</p></div>\r\n"
+        "<div><p>Read commands: %s</p></div>\r\n"
         "<div><p>%s</p></div>\r\n";
 
 /* This is a lazy way but it means the ws_printf function can be used.
@@ -266,12 +372,21 @@ static void bdCache (PSESS pSess, char *pchDrive, char *pszDir, int *piIndex, PD
 static void bdSetArgumentFlags (char *pszArgument, PHTDIR pHtDir, PSESRT pSortSelect);
 static DSORT bdModifySortType (DSORT dirSort, SESRT sortSelect);
 static int bdGeneratePage (PHTDIR pHtDir);
+static PDIDX bdIndexGet (char chDrive, char *pszDir);
+static void bdIndexFlush (void);
+static PDIENT bdIndexEntry (PDIDX pIndex, DSORT dirSort, int iPosition);
+static void bdIndexUnpack (PDIDX pIndex, PDIENT pEntry, PFATENTRY pFatEntry);
+static size_t bgGetMaxNameLength (PHTDIR pHtDir, int iIndex, int iEntryCount);
+static int bdBenchFill (int iFileCount);
 static void cgiMakeWRTestFileName (char *pszDestFileName, uint32_t fFileSize, char chDrive);
+static void cgiShowLatency (char *pszDest, PMSSTATS pMsStats);
+static void cgiRawReadTest (PMSTEST pMsTest, uint8_t *pbyBuffer, uint32_t buffer_size, uint32_t uiLength);
+static void cgiRawReadComplete (PMSREQ pMsReq);
 
 int cgiMsExplore (PSESS pSess, PEOFILE pEoFile);
 int cgiMsTest (PSESS pSess, PEOFILE pEoFile);
+int cgiMsDirBench (PSESS pSess, PEOFILE pEoFile);
 void cgiShowDataRate (char *pszDest, float fTransferTime, size_t stLength, _Bool bfDirection);
-float bdCompareDate (PDLST pDLST, PDLST pNew);
 
 /******************************************************************************
  External Variables
@@ -305,6 +420,14 @@ static struct _CACHE
     DSORT         dirSort;
 } gpClientPathCache[BD_CLIENT_PATH_CACHE_SIZE];
 
+/* The directory indexes, see bdIndexGet */
+static DIDX gpDirIndex[BD_INDEX_CACHE_SIZE];
+static unsigned long gulIndexLRU = 0;
+
+/* The index being sorted and the key, qsort does not pass a context */
+static PDIDX gpSortIndex = NULL;
+static DKEY gSortKey = DIR_KEY_NAME;
+
 /******************************************************************************
  Public Functions
  ******************************************************************************/
@@ -332,8 +455,6 @@ int cgiMsExplore (PSESS pSess, PEOFILE pEoFile)
         HTDIR htDir;
 
         memset(&htDir, 0, sizeof(HTDIR));
-        memset(&(htDir.pDirList->fatEntry), 0, sizeof(FATENTRY));
-        memset(&(htDir.pFileList->fatEntry), 0, sizeof(FATENTRY));
 
         /* Ask the disk manager to check to see if there are any new drives */
         dskNewPnPDrive();
@@ -394,7 +515,7 @@ int cgiMsExplore (PSESS pSess, PEOFILE pEoFile)
 
                     /* dirSort references a table of function pointers. Make sure
                      that the value obtained does not exceed the table length */
-                    htDir.dirSort = (htDir.dirSort >= DIR_SORT_NUM) ? DIR_SORT_NUM : htDir.dirSort;
+                    htDir.dirSort = (htDir.dirSort >= DIR_SORT_NUM) ? DIR_SORT_BY_NAME_A_Z : htDir.dirSort;
 
                     /* Modify the previous directory sort type */
                     NewDirSort = bdModifySortType(htDir.dirSort, sortSelect);
@@ -484,7 +605,7 @@ int cgiMsTest (PSESS pSess, PEOFILE pEoFile)
     static MSTEST msTest =
     {
         0, 'A', 0,
-        false, "", "", "", ""
+        false, "", "", "", "", "", "", ""
     };
 
     if (NULL == msTest.uiTaskID)
@@ -515,6 +636,9 @@ int cgiMsTest (PSESS pSess, PEOFILE pEoFile)
             msTest.pszWriteSpeed[0] = '\0';
             msTest.pszReadSpeed[0] = '\0';
             msTest.pszTestResult[0] = '\0';
+            msTest.pszWriteLatency[0] = '\0';
+            msTest.pszReadLatency[0] = '\0';
+            msTest.pszRawRead[0] = '\0';
 
             /* Check that A FAT library is included */
             if (R_FAT_LoadLibrary())
@@ -541,7 +665,7 @@ int cgiMsTest (PSESS pSess, PEOFILE pEoFile)
         if (msTest.bfResultsValid)
         {
             wi_printf(pSess, pcpszTestResults, msTest.pszFileName, msTest.pszWriteSpeed, msTest.pszReadSpeed,
-                    msTest.pszTestResult);
+                    msTest.pszTestResult, msTest.pszWriteLatency, msTest.pszReadLatency, msTest.pszRawRead);
         }
     }
     else
@@ -555,10 +679,185 @@ int cgiMsTest (PSESS pSess, PEOFILE pEoFile)
  End of function  cgiMsTest
  ******************************************************************************/
 
+/*****************************************************************************
+ Function Name: cgiMsDirBench
+ Description:   Function to benchmark the directory index. BD_BENCH_DIR on
+                the first drive is filled up to the requested number of
+                files, then its index is built from cold, looked up again
+                and every page of the listing is served in every sort order
+ Parameters:    IN  pSess - Pointer to the session
+                IN  pEoFile - Pointer to the file object
+ Return value:  0 for success
+ *****************************************************************************/
+int cgiMsDirBench (PSESS pSess, PEOFILE pEoFile)
+{
+    char *pszArgument;
+    HTDIR htDir;
+    int iFileCount = 0;
+
+    (void) pEoFile;
+
+    memset(&htDir, 0, sizeof(HTDIR));
+
+    /* The argument is the number of files wanted in the directory */
+    pszArgument = cgiGetArgument(pSess, true);
+    if ((pszArgument) && (isdigit(*pszArgument)))
+    {
+        sscanf(pszArgument, "%d", &iFileCount);
+    }
+
+    /* Cap at what a FAT directory can hold */
+    iFileCount = (iFileCount > (BD_INDEX_MAX_ENTRIES - 2)) ? (BD_INDEX_MAX_ENTRIES - 2) : iFileCount;
+
+    /* ensure that directory object is initialised */
+    if (0u == dir_init)
+    {
+        memset(&gs_dir, 0x30u, sizeof(DIR));
+        dir_init = 1u;
+    }
+
+    if (R_FAT_LoadLibrary())
+    {
+        wi_printf(pSess, gcpszNoFatLib);
+    }
+    else if (!dskGetFirstDrive((int8_t *) &htDir.chDrive))
+    {
+        wi_printf(pSess, gcpszNoDisks);
+    }
+    else
+    {
+        TMSTMP perfTimer;
+        float fFill = 0.0f;
+        float fBuild;
+        float fLookup;
+        float fPages;
+        int iPages = 0;
+        int iLookup;
+
+        if (iFileCount > 0)
+        {
+            timerStartMeasurement( &perfTimer);
+            if (bdBenchFill(iFileCount))
+            {
+                wi_printf(pSess, "<div><p>Failed to create the files in " BD_BENCH_DIR "</p></div>\r\n");
+                return 0;
+            }
+
+            ptimerStopMeasurement( &perfTimer, &fFill);
+        }
+
+        /* Start from cold */
+        bdIndexFlush();
+        strcpy(gpszPath, BD_BENCH_DIR);
+
+        timerStartMeasurement( &perfTimer);
+        htDir.pIndex = bdIndexGet(htDir.chDrive, gpszPath);
+        ptimerStopMeasurement( &perfTimer, &fBuild);
+
+        if (!htDir.pIndex)
+        {
+            wi_printf(pSess, "<div><p>Failed to read " BD_BENCH_DIR "</p></div>\r\n");
+            return 0;
+        }
+
+        /* Looking up an index that is current, as every page view after the first does */
+        timerStartMeasurement( &perfTimer);
+        for (iLookup = 0; iLookup < 100; iLookup++)
+        {
+            htDir.pIndex = bdIndexGet(htDir.chDrive, gpszPath);
+        }
+
+        ptimerStopMeasurement( &perfTimer, &fLookup);
+
+        /* Serve every page in every order without the HTTP output */
+        timerStartMeasurement( &perfTimer);
+        for (htDir.dirSort = DIR_SORT_BY_NAME_A_Z; htDir.dirSort < DIR_SORT_NUM; htDir.dirSort++)
+        {
+            int iCount = htDir.pIndex->iDirCount + htDir.pIndex->iFileCount;
+            int iIndex;
+
+            for (iIndex = 0; iIndex < iCount; iIndex += BD_MAX_FILE_ENTRIES)
+            {
+                int iPosition;
+
+                htDir.stFileNamePadding = bgGetMaxNameLength(&htDir, iIndex, BD_MAX_FILE_ENTRIES);
+                for (iPosition = iIndex; (iPosition < iCount) && (iPosition < (iIndex + BD_MAX_FILE_ENTRIES));
+                        iPosition++)
+                {
+                    bdIndexUnpack(htDir.pIndex, bdIndexEntry(htDir.pIndex, htDir.dirSort, iPosition),
+                            &htDir.fatEntry);
+                }
+
+                iPages++;
+            }
+        }
+
+        ptimerStopMeasurement( &perfTimer, &fPages);
+
+        wi_printf(pSess, pcpszBenchResults, iFileCount, (unsigned long) fFill, htDir.pIndex->iDirCount,
+                htDir.pIndex->iFileCount,
+                (unsigned long) ((sizeof(DIENT) * (size_t) (htDir.pIndex->iDirCount + htDir.pIndex->iFileCount))
+                        + htDir.pIndex->stNamesLength
+                        + (sizeof(unsigned short)
+                                * (size_t) (htDir.pIndex->iDirCount + (DIR_KEY_NUM * htDir.pIndex->iFileCount)))),
+                (unsigned long) (fBuild * 1000.0f), (unsigned long) (fLookup * 10000.0f), iPages,
+                (iPages) ? (unsigned long) ((fPages * 1000000.0f) / (float) iPages) : 0UL);
+    }
+
+    return 0;
+}
+/*****************************************************************************
+ End of function  cgiMsDirBench
+ ******************************************************************************/
+
 /******************************************************************************
  Private Functions
  ******************************************************************************/
 
+/*****************************************************************************
+ Function Name: bdBenchFill
+ Description:   Function to fill BD_BENCH_DIR with files T00000.WAV upwards.
+                Files that are already there are left as they are
+ Parameters:    IN  iFileCount - The number of files wanted
+ Return value:  0 for success or -1 on a write error
+ *****************************************************************************/
+static int bdBenchFill (int iFileCount)
+{
+    int iFile;
+
+    /* Fails harmlessly if the directory is already there */
+    strcpy(gpszTemp1, BD_BENCH_DIR);
+    R_FAT_MakeDirectory(gpszTemp1);
+
+    /* Any data will do */
+    memset(gpszTemp2, 0x55, sizeof(gpszTemp2));
+
+    for (iFile = 0; iFile < iFileCount; iFile++)
+    {
+        FIL *pFile;
+
+        sprintf(gpszTemp1, BD_BENCH_DIR "/T%05d.WAV", iFile);
+        pFile = R_FAT_OpenFile(gpszTemp1, FA_CREATE_NEW | FA_WRITE);
+        if (pFile)
+        {
+            /* Vary the size so that the size orders are not the name order */
+            int iResult = R_FAT_WriteFile(pFile, (unsigned char *) gpszTemp2,
+                    (unsigned int) ((iFile * 97) % (int) sizeof(gpszTemp2)));
+
+            R_FAT_CloseFile(pFile);
+            if (iResult < 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+/*****************************************************************************
+ End of function  bdBenchFill
+ ******************************************************************************/
+
 /******************************************************************************
  Function Name: cgiMakeWRTestFileName
  Description:   Function to make a file name based on the file size
@@ -733,6 +1032,7 @@ static void taskReadWritePerfTest (PMSTEST pMsTest)
             int iResult;
             uint32_t chunk_size;
             TMSTMP perfTimer;
+            MSSTATS msStats;
             float write_time;
 
             /* Seek to the beginning of the file */
@@ -743,6 +1043,7 @@ static void taskReadWritePerfTest (PMSTEST pMsTest)
                 control(iFile, CTL_FILE_SEEK, &fileSeek);
             }
 
+            usbMsResetStats();
             timerStartMeasurement( &perfTimer);
 
             do
@@ -771,6 +1072,8 @@ static void taskReadWritePerfTest (PMSTEST pMsTest)
 
             /* Stop the timer */
             ptimerStopMeasurement( &perfTimer, &write_time);
+            usbMsGetStats( &msStats);
+            cgiShowLatency(pMsTest->pszWriteLatency, &msStats);
 
             if (iResult >= 0)
             {
@@ -801,6 +1104,7 @@ static void taskReadWritePerfTest (PMSTEST pMsTest)
                 memset(pbyFileData, 0, (size_t) buffer_size);
 
                 /* Read the data back in */
+                usbMsResetStats();
                 timerStartMeasurement( &perfTimer);
 
                 do
@@ -833,6 +1137,8 @@ static void taskReadWritePerfTest (PMSTEST pMsTest)
                 } while ((bytes_remaining > 0) && (iResult >= 0));
 
                 ptimerStopMeasurement( &perfTimer, &read_time);
+                usbMsGetStats( &msStats);
+                cgiShowLatency(pMsTest->pszReadLatency, &msStats);
 
                 if (iResult >= 0)
                 {
@@ -848,6 +1154,9 @@ static void taskReadWritePerfTest (PMSTEST pMsTest)
                     {
                         sprintf(pMsTest->pszTestResult, "Error in file data\r\n");
                     }
+
+                    /* The same length again below the file system */
+                    cgiRawReadTest(pMsTest, pbyFileData, buffer_size, uiTestFileSize);
                 }
                 else
                 {
@@ -884,6 +1193,184 @@ static void taskReadWritePerfTest (PMSTEST pMsTest)
  End of function  taskReadWritePerfTest
  ******************************************************************************/
 
+/******************************************************************************
+ Function Name: cgiShowLatency
+ Description:   Function to print the command count, time and latency
+                histogram of the USB MS transport
+ Arguments:     OUT pszDest - Pointer to the destination string, 192 bytes
+                IN  pMsStats - Pointer to the transport counters
+ Return value:  none
+ ******************************************************************************/
+static void cgiShowLatency (char *pszDest, PMSSTATS pMsStats)
+{
+    int iBin;
+    int iLength;
+
+    if (0UL == pMsStats->dwCommands)
+    {
+        sprintf(pszDest, "none");
+        return;
+    }
+
+    iLength = sprintf(pszDest, "%lu (%lu failed), mean %lu uS, max %lu uS,",
+            pMsStats->dwCommands, pMsStats->dwErrors,
+            (uint32_t) (pMsStats->ullTotal_uS / pMsStats->dwCommands), pMsStats->dwMax_uS);
+
+    /* Only the bins that were used */
+    for (iBin = 0; iBin < USB_MS_LATENCY_BINS; iBin++)
+    {
+        if ((pMsStats->pdwLatency[iBin]) && (iLength < (192 - 24)))
+        {
+            if (iBin < (USB_MS_LATENCY_BINS - 1))
+            {
+                iLength += sprintf(pszDest + iLength, " &lt;%lu:%lu",
+                        1UL << (iBin + USB_MS_LATENCY_FIRST_BIN), pMsStats->pdwLatency[iBin]);
+            }
+            else
+            {
+                iLength += sprintf(pszDest + iLength, " more:%lu", pMsStats->pdwLatency[iBin]);
+            }
+        }
+    }
+}
+/******************************************************************************
+ End of function  cgiShowLatency
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cgiRawReadComplete
+ Description:   Function called by the USB MS queue task when a read of the
+                raw read test has completed
+ Arguments:     IN  pMsReq - Pointer to the completed request
+ Return value:  none
+ ******************************************************************************/
+static void cgiRawReadComplete (PMSREQ pMsReq)
+{
+    PMSQTEST pQueueTest = (PMSQTEST) pMsReq->pvParameter;
+
+    if (pMsReq->iResult)
+    {
+        pQueueTest->bfError = true;
+    }
+    pQueueTest->dwCompleted++;
+    R_OS_SetEvent( &pQueueTest->evComplete);
+}
+/******************************************************************************
+ End of function  cgiRawReadComplete
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cgiRawReadTest
+ Description:   Function to read from the start of the drive with READ 10,
+                first one command at a time and then with MS_TEST_QUEUE_DEPTH
+                commands queued so the next CBW is always waiting
+ Arguments:     IN/OUT pMsTest - Pointer to the MS test data
+                IN  pbyBuffer - Pointer to the memory to read into
+                IN  buffer_size - The size of the memory
+                IN  uiLength - The number of bytes to read
+ Return value:  none
+ ******************************************************************************/
+static void cgiRawReadTest (PMSTEST pMsTest, uint8_t *pbyBuffer, uint32_t buffer_size, uint32_t uiLength)
+{
+    PDRIVE pDrive = dskGetDrive((int8_t) pMsTest->chDrive);
+    PMSQTEST pQueueTest;
+    TMSTMP perfTimer;
+    float sync_time;
+    float queued_time;
+    uint32_t block_size;
+    uint32_t blocks_per_command;
+    uint32_t command_count;
+    uint32_t issued;
+    uint32_t index;
+
+    if ((NULL == pDrive) || (0UL == pDrive->dwBlockSize))
+    {
+        return;
+    }
+
+    /* Each queued command needs its own part of the buffer */
+    block_size = (uint32_t) pDrive->dwBlockSize;
+    blocks_per_command = (buffer_size / MS_TEST_QUEUE_DEPTH) / block_size;
+    if (0UL == blocks_per_command)
+    {
+        return;
+    }
+    command_count = ((uiLength / block_size) + blocks_per_command - 1UL) / blocks_per_command;
+    if (((command_count * blocks_per_command) > pDrive->dwNumBlocks) || (0UL == command_count))
+    {
+        return;
+    }
+
+    pQueueTest = (PMSQTEST) R_OS_AllocMem(sizeof(MSQTEST), R_REGION_LARGE_CAPACITY_RAM);
+    if (NULL == pQueueTest)
+    {
+        return;
+    }
+    memset(pQueueTest, 0, sizeof(MSQTEST));
+    R_OS_CreateEvent( &pQueueTest->evComplete);
+
+    /* One command at a time */
+    timerStartMeasurement( &perfTimer);
+    for (index = 0UL; index < command_count; index++)
+    {
+        size_t stLength;
+
+        if (scsiRead10(pDrive->iMsDev, pDrive->iLun, index * blocks_per_command, (uint16_t) blocks_per_command,
+                pbyBuffer, (size_t) (blocks_per_command * block_size), &stLength))
+        {
+            pQueueTest->bfError = true;
+            break;
+        }
+    }
+    ptimerStopMeasurement( &perfTimer, &sync_time);
+
+    /* Keep the queue full, the commands complete in order so the part of the
+       buffer used by the oldest is free once it has completed */
+    issued = 0UL;
+    timerStartMeasurement( &perfTimer);
+    while ((pQueueTest->dwCompleted < issued) || ((issued < command_count) && (!pQueueTest->bfError)))
+    {
+        while ((issued < command_count) && ((issued - pQueueTest->dwCompleted) < MS_TEST_QUEUE_DEPTH)
+                && (!pQueueTest->bfError))
+        {
+            index = issued % MS_TEST_QUEUE_DEPTH;
+            if (scsiQueueRead10( &pQueueTest->pMsReq[index], pDrive->iMsDev, pDrive->iLun,
+                    issued * blocks_per_command, (uint16_t) blocks_per_command,
+                    pbyBuffer + (index * blocks_per_command * block_size),
+                    (size_t) (blocks_per_command * block_size), cgiRawReadComplete, pQueueTest))
+            {
+                pQueueTest->bfError = true;
+                break;
+            }
+            issued++;
+        }
+        if (pQueueTest->dwCompleted < issued)
+        {
+            R_OS_WaitForEvent( &pQueueTest->evComplete, 100UL);
+        }
+    }
+    ptimerStopMeasurement( &perfTimer, &queued_time);
+
+    if (pQueueTest->bfError)
+    {
+        sprintf(pMsTest->pszRawRead, "Raw READ 10 failed\r\n");
+    }
+    else if ((sync_time > 0.0f) && (queued_time > 0.0f))
+    {
+        float fBytes = (float) (command_count * blocks_per_command * block_size);
+
+        sprintf(pMsTest->pszRawRead, "Raw READ 10 of %lu kB: %.2f MB/s one at a time, %.2f MB/s with %d queued\r\n",
+                (command_count * blocks_per_command * block_size) / 1024UL, (fBytes / sync_time) / 1e6f,
+                (fBytes / queued_time) / 1e6f, MS_TEST_QUEUE_DEPTH);
+    }
+
+    R_OS_DeleteEvent( &pQueueTest->evComplete);
+    R_OS_FreeMem(pQueueTest);
+}
+/******************************************************************************
+ End of function  cgiRawReadTest
+ ******************************************************************************/
+
 /*****************************************************************************
  Function Name: bdSearch
  Description:   Function to search the cache for a client IP address
@@ -1060,265 +1547,472 @@ static DSORT bdModifySortType (DSORT dirSort, SESRT sortSelect)
  End of function  bdModifySortType
  ******************************************************************************/
 
-/******************************************************************************
- Function Name: bdAddEntry
- Description:   Function to add an entry to the directory list
- Arguments:     IN  ppDLST - Pointer to the directory list pointer to add the
- entry to
- IN  pDLST - Pointer to the entry to add
- IN  pfnCompare - Pointer to a function to compare the new entry
- with the current item on the list
- Return value:  none
- ******************************************************************************/
-static void bdAddEntry (PDLST *ppDLST, PDLST pDLST, PDCMP pfnCompare)
+/*****************************************************************************
+ Function Name: bdPackDate
+ Description:   Function to pack a FAT date and time into a value that is
+                greater for a later time
+ Parameters:    IN  pFatTime - Pointer to the date and time
+ Return value:  The packed date and time
+ *****************************************************************************/
+static unsigned long bdPackDate (PFATTIME pFatTime)
 {
-    while ((*ppDLST) && (pfnCompare(*ppDLST, pDLST)))
-    {
-        ppDLST = &(*ppDLST)->pNext;
-    }
+    unsigned long ulYear = (pFatTime->Year > 1980) ? (unsigned long) (pFatTime->Year - 1980) : 0UL;
 
-    pDLST->pNext = *ppDLST;
-    *ppDLST = pDLST;
+    return ((ulYear & 0x7f) << 25) | ((unsigned long) (pFatTime->Month & 0xf) << 21)
+            | ((unsigned long) (pFatTime->Day & 0x1f) << 16) | ((unsigned long) (pFatTime->Hour & 0x1f) << 11)
+            | ((unsigned long) (pFatTime->Minute & 0x3f) << 5) | ((unsigned long) (pFatTime->Second & 0x3f) >> 1);
 }
-/******************************************************************************
- End of function  bdAddEntry
+/*****************************************************************************
+ End of function  bdPackDate
  ******************************************************************************/
 
-/******************************************************************************
- Function Name: bdRemoveEntry
- Description:   Function to remove an entry from the list
- Arguments:     IN  ppDLST - Pointer to the directory list pointer to remove the
- entry from
- IN  pDLST - Pointer to the transfer request to remove
+/*****************************************************************************
+ Function Name: bdIndexUnpack
+ Description:   Function to make a FAT entry from an index entry
+ Parameters:    IN  pIndex - Pointer to the index
+                IN  pEntry - Pointer to the entry in the index
+                OUT pFatEntry - Pointer to the destination FAT entry
  Return value:  none
+ *****************************************************************************/
+static void bdIndexUnpack (PDIDX pIndex, PDIENT pEntry, PFATENTRY pFatEntry)
+{
+    strcpy(pFatEntry->FileName, pIndex->pszNames + pEntry->ulName);
+    pFatEntry->Attrib = pEntry->byAttrib;
+    pFatEntry->Filesize = (unsigned int) pEntry->ulSize;
+    pFatEntry->CreateTime.Year = (unsigned short) ((pEntry->ulDate >> 25) + 1980);
+    pFatEntry->CreateTime.Month = (unsigned short) ((pEntry->ulDate >> 21) & 0xf);
+    pFatEntry->CreateTime.Day = (unsigned short) ((pEntry->ulDate >> 16) & 0x1f);
+    pFatEntry->CreateTime.Hour = (unsigned short) ((pEntry->ulDate >> 11) & 0x1f);
+    pFatEntry->CreateTime.Minute = (unsigned short) ((pEntry->ulDate >> 5) & 0x3f);
+    pFatEntry->CreateTime.Second = (unsigned short) ((pEntry->ulDate & 0x1f) << 1);
+}
+/*****************************************************************************
+ End of function  bdIndexUnpack
  ******************************************************************************/
-static void bdRemoveEntry (PDLST *ppDLST, PDLST pDLST)
+
+/*****************************************************************************
+ Function Name: bdIndexCompare
+ Description:   qsort function to compare two positions in the index being
+                sorted by the current key. Entries with an equal date or
+                size are ordered by name
+ Parameters:    IN  pvA - Pointer to the first position
+                IN  pvB - Pointer to the second position
+ Return value:  < 0, 0 or > 0 as the first entry sorts before, equal to or
+                after the second
+ *****************************************************************************/
+static int bdIndexCompare (const void *pvA, const void *pvB)
 {
-    /* Search the list for the request */
-    while ((*ppDLST != NULL) && (*ppDLST != pDLST))
+    PDIENT pA = &gpSortIndex->pEntry[*(const unsigned short *) pvA];
+    PDIENT pB = &gpSortIndex->pEntry[*(const unsigned short *) pvB];
+    unsigned long ulA = 0;
+    unsigned long ulB = 0;
+
+    if (DIR_KEY_DATE == gSortKey)
+    {
+        ulA = pA->ulDate;
+        ulB = pB->ulDate;
+    }
+    else if (DIR_KEY_SIZE == gSortKey)
     {
-        ppDLST = &( *ppDLST)->pNext;
+        ulA = pA->ulSize;
+        ulB = pB->ulSize;
     }
 
-    /* If it has been found */
-    if (*ppDLST)
+    if (ulA < ulB)
     {
-        /* Delete from the list */
-        *ppDLST = (*ppDLST)->pNext;
-        pDLST->pNext = NULL;
+        return -1;
     }
-}
-/******************************************************************************
- End of function  bdRemoveEntry
- ******************************************************************************/
 
-/*****************************************************************************
- Function Name: bdCompareNameAZ
- Description:   Function to perform the DIR_SORT_BY_NAME_A_Z sort
- Parameters:    IN  pDLST - Pointer to the current list entry
- IN  pNew - Pointer to the new entry
- Return value:  false when the new entry should be inserted into the list
- *****************************************************************************/
-static _Bool bdCompareNameAZ (PDLST pDLST, PDLST pNew)
-{
-    if (stricmp(pDLST->fatEntry.FileName, pNew->fatEntry.FileName) < 0)
+    if (ulA > ulB)
     {
-        return true;
+        return 1;
     }
 
-    return false;
+    return stricmp(gpSortIndex->pszNames + pA->ulName, gpSortIndex->pszNames + pB->ulName);
 }
 /*****************************************************************************
- End of function  bdCompareNameAZ
+ End of function  bdIndexCompare
  ******************************************************************************/
 
 /*****************************************************************************
- Function Name: bdCompareNameZA
- Description:   Function to perform the DIR_SORT_BY_NAME_Z_A sort
- Parameters:    IN  pDLST - Pointer to the current list entry
- IN  pNew - Pointer to the new entry
- Return value:  false when the new entry should be inserted into the list
+ Function Name: bdIndexFree
+ Description:   Function to free the memory of an index and mark it unused
+ Parameters:    IN  pIndex - Pointer to the index
+ Return value:  none
  *****************************************************************************/
-static _Bool bdCompareNameZA (PDLST pDLST, PDLST pNew)
+static void bdIndexFree (PDIDX pIndex)
 {
-    if (stricmp(pDLST->fatEntry.FileName, pNew->fatEntry.FileName) > 0)
-    {
-        return true;
-    }
-
-    return false;
+    free(pIndex->pEntry);
+    free(pIndex->pszNames);
+    free(pIndex->pusOrder);
+    memset(pIndex, 0, sizeof(DIDX));
 }
 /*****************************************************************************
- End of function  bdCompareNameZA
+ End of function  bdIndexFree
  ******************************************************************************/
 
 /*****************************************************************************
- Function Name: bdCompareDate
- Description:   Function to compare the date
- Parameters:    IN  pDLST - Pointer to the current list entry
- IN  pNew - Pointer to the new entry
- Return value:  signed representation of the difference in date
+ Function Name: bdIndexAddEntry
+ Description:   Function to add a FAT entry to an index that is being built
+ Parameters:    IN  pIndex - Pointer to the index
+                IN  pFatEntry - Pointer to the FAT entry to add
+                IN/OUT piEntrySize - The number of entries allocated
+                IN/OUT pstNamesSize - The size of the name pool allocated
+ Return value:  0 for success or -1 when out of memory or the index is full
  *****************************************************************************/
-float bdCompareDate (PDLST pDLST, PDLST pNew)
+static int bdIndexAddEntry (PDIDX pIndex, PFATENTRY pFatEntry, int *piEntrySize, size_t *pstNamesSize)
 {
-    DATE List, New;
-    List.Field.Year = pDLST->fatEntry.CreateTime.Year;
-    List.Field.Month = (unsigned) (pDLST->fatEntry.CreateTime.Month & 0xf);
-    List.Field.Day = (unsigned) (pDLST->fatEntry.CreateTime.Day & 0x1f);
-    List.Field.Hour = (unsigned) (pDLST->fatEntry.CreateTime.Hour & 0x1f);
-    List.Field.Minute = (unsigned) (pDLST->fatEntry.CreateTime.Minute & 0x3f);
-    List.Field.Second = (unsigned) (pDLST->fatEntry.CreateTime.Second & 0x3f);
-    List.Field.WeekDay = 0;
-    New.Field.Year = pNew->fatEntry.CreateTime.Year;
-    New.Field.Month = (unsigned) (pNew->fatEntry.CreateTime.Month & 0xf);
-    New.Field.Day = (unsigned) (pNew->fatEntry.CreateTime.Day & 0x1f);
-    New.Field.Hour = (unsigned) (pNew->fatEntry.CreateTime.Hour & 0x1f);
-    New.Field.Minute = (unsigned) (pNew->fatEntry.CreateTime.Minute & 0x3f);
-    New.Field.Second = (unsigned) (pNew->fatEntry.CreateTime.Second & 0x3f);
-    New.Field.WeekDay = 0;
-    return (float) (List.llCode - New.llCode);
+    int iCount = pIndex->iDirCount + pIndex->iFileCount;
+    size_t stLength = strlen(pFatEntry->FileName);
+    PDIENT pEntry;
+
+    if (iCount >= BD_INDEX_MAX_ENTRIES)
+    {
+        return -1;
+    }
+
+    /* Double the entries when they are full */
+    if (iCount == *piEntrySize)
+    {
+        PDIENT pGrow = (PDIENT) realloc(pIndex->pEntry, sizeof(DIENT) * (size_t) (*piEntrySize * 2));
+
+        if (!pGrow)
+        {
+            return -1;
+        }
+
+        pIndex->pEntry = pGrow;
+        *piEntrySize *= 2;
+    }
+
+    /* And the name pool */
+    if ((pIndex->stNamesLength + stLength + 1) > *pstNamesSize)
+    {
+        char *pszGrow = (char *) realloc(pIndex->pszNames, *pstNamesSize * 2);
+
+        if (!pszGrow)
+        {
+            return -1;
+        }
+
+        pIndex->pszNames = pszGrow;
+        *pstNamesSize *= 2;
+    }
+
+    pEntry = &pIndex->pEntry[iCount];
+    pEntry->ulName = (unsigned long) pIndex->stNamesLength;
+    pEntry->ulSize = pFatEntry->Filesize;
+    pEntry->ulDate = bdPackDate(&pFatEntry->CreateTime);
+    pEntry->byAttrib = pFatEntry->Attrib;
+    pEntry->byNameLength = (unsigned char) stLength;
+    strcpy(pIndex->pszNames + pIndex->stNamesLength, pFatEntry->FileName);
+    pIndex->stNamesLength += stLength + 1;
+
+    if (pFatEntry->Attrib & FAT_ATTR_DIR)
+    {
+        pIndex->iDirCount++;
+    }
+    else
+    {
+        pIndex->iFileCount++;
+    }
+
+    return 0;
 }
 /*****************************************************************************
- End of function  bdCompareDate
+ End of function  bdIndexAddEntry
  ******************************************************************************/
 
 /*****************************************************************************
- Function Name: bdCompareDateRecent
- Description:   Function to perform the DIR_SORT_BY_DATE_RECENT sort
- Parameters:    IN  pDLST - Pointer to the current list entry
- IN  pNew - Pointer to the new entry
- Return value:  false when the new entry should be inserted into the list
+ Function Name: bdIndexSort
+ Description:   Function to make the sort orders of an index once all of the
+                entries have been added
+ Parameters:    IN  pIndex - Pointer to the index
+ Return value:  0 for success or -1 when out of memory
  *****************************************************************************/
-static _Bool bdCompareDateRecent (PDLST pDLST, PDLST pNew)
+static int bdIndexSort (PDIDX pIndex)
 {
-    if (bdCompareDate(pDLST, pNew) > 0)
+    int iCount = pIndex->iDirCount + pIndex->iFileCount;
+    int iDir = 0;
+    int iFile = 0;
+    int iEntry;
+    int iKey;
+
+    /* One block for all of the orders, never empty so that NULL is an error */
+    pIndex->pusOrder = (unsigned short *) malloc(
+            sizeof(unsigned short) * (size_t) (pIndex->iDirCount + (DIR_KEY_NUM * pIndex->iFileCount) + 1));
+    if (!pIndex->pusOrder)
     {
-        return false;
+        return -1;
     }
 
-    return true;
+    pIndex->pusDirOrder = pIndex->pusOrder;
+    for (iKey = 0; iKey < DIR_KEY_NUM; iKey++)
+    {
+        pIndex->ppusFileOrder[iKey] = pIndex->pusOrder + pIndex->iDirCount + (iKey * pIndex->iFileCount);
+    }
+
+    /* Split the directories from the files */
+    for (iEntry = 0; iEntry < iCount; iEntry++)
+    {
+        if (pIndex->pEntry[iEntry].byAttrib & FAT_ATTR_DIR)
+        {
+            pIndex->pusDirOrder[iDir++] = (unsigned short) iEntry;
+        }
+        else
+        {
+            pIndex->ppusFileOrder[DIR_KEY_NAME][iFile++] = (unsigned short) iEntry;
+        }
+    }
+
+    gpSortIndex = pIndex;
+    gSortKey = DIR_KEY_NAME;
+    qsort(pIndex->pusDirOrder, (size_t) pIndex->iDirCount, sizeof(unsigned short), bdIndexCompare);
+    qsort(pIndex->ppusFileOrder[DIR_KEY_NAME], (size_t) pIndex->iFileCount, sizeof(unsigned short), bdIndexCompare);
+
+    /* The other keys start from the name order */
+    for (iKey = DIR_KEY_NAME + 1; iKey < DIR_KEY_NUM; iKey++)
+    {
+        memcpy(pIndex->ppusFileOrder[iKey], pIndex->ppusFileOrder[DIR_KEY_NAME],
+                sizeof(unsigned short) * (size_t) pIndex->iFileCount);
+        gSortKey = (DKEY) iKey;
+        qsort(pIndex->ppusFileOrder[iKey], (size_t) pIndex->iFileCount, sizeof(unsigned short), bdIndexCompare);
+    }
+
+    gpSortIndex = NULL;
+    return 0;
 }
 /*****************************************************************************
- End of function  bdCompareDateRecent
+ End of function  bdIndexSort
  ******************************************************************************/
 
 /*****************************************************************************
- Function Name: bdCompareDateOld
- Description:   Function to perform the DIR_SORT_BY_DATE_OLD sort
- Parameters:    IN  pDLST - Pointer to the current list entry
- IN  pNew - Pointer to the new entry
- Return value:  false when the new entry should be inserted into the list
+ Function Name: bdIndexBuild
+ Description:   Function to read a directory into an index
+ Parameters:    IN  pIndex - Pointer to the index to build
+                IN  chDrive - The drive letter
+                IN  pszDir - Pointer to the directory path
+ Return value:  0 for success or -1 on error
  *****************************************************************************/
-static _Bool bdCompareDateOld (PDLST pDLST, PDLST pNew)
+static int bdIndexBuild (PDIDX pIndex, char chDrive, char *pszDir)
 {
-    if (bdCompareDate(pDLST, pNew) < 0)
+    FATENTRY fatEntry;
+    int iEntrySize = BD_INDEX_INITIAL_ENTRIES;
+    size_t stNamesSize = BD_INDEX_INITIAL_NAMES;
+    int iResult = -1;
+
+    bdIndexFree(pIndex);
+
+    /* Taken before the directory is read so that a change made while it is
+     being read makes the index out of date */
+    pIndex->ulChangeCount = R_FAT_GetChangeCount();
+    pIndex->pEntry = (PDIENT) malloc(sizeof(DIENT) * BD_INDEX_INITIAL_ENTRIES);
+    pIndex->pszNames = (char *) malloc(BD_INDEX_INITIAL_NAMES);
+
+    if ((pIndex->pEntry) && (pIndex->pszNames) && (!R_FAT_FindFirst(&gs_dir, &fatEntry, pszDir, "*")))
+    {
+        /* Find first returns the first entry, with no name when the
+         directory is empty */
+        while (fatEntry.FileName[0])
+        {
+            /* Skip the references to the parent directory */
+            if ((strcmp(fatEntry.FileName, ".")) && (strcmp(fatEntry.FileName, ".."))
+
+            /* Skip if the file is hidden */
+            && (!(fatEntry.Attrib & FAT_ATTR_HIDDEN))
+
+            /* Skip if it is a system file */
+            && (!(fatEntry.Attrib & FAT_ATTR_SYSTEM)))
+            {
+                /* Out of memory or more entries than an index can hold, list
+                 what has been read */
+                if (bdIndexAddEntry(pIndex, &fatEntry, &iEntrySize, &stNamesSize))
+                {
+                    break;
+                }
+            }
+
+            if (R_FAT_FindNext(&gs_dir, &fatEntry))
+            {
+                break;
+            }
+        }
+
+        if (!bdIndexSort(pIndex))
+        {
+            pIndex->chDrive = chDrive;
+            strcpy(pIndex->pszDir, pszDir);
+            iResult = 0;
+        }
+    }
+
+    if (iResult)
     {
-        return false;
+        bdIndexFree(pIndex);
     }
 
-    return true;
+    return iResult;
 }
 /*****************************************************************************
- End of function  bdCompareDateOld
+ End of function  bdIndexBuild
  ******************************************************************************/
 
 /*****************************************************************************
- Function Name: bdCompareSizeLarge
- Description:   Function to perform the DIR_SORT_BY_SIZE_LARGE sort
- Parameters:    IN  pDLST - Pointer to the current list entry
- IN  pNew - Pointer to the new entry
- Return value:  false when the new entry should be inserted into the list
+ Function Name: bdIndexGet
+ Description:   Function to get the index of a directory. An index that was
+                built since the last change to the file system is returned
+                as it is, otherwise the directory is read into the least
+                recently used index.
+                The returned index is valid until the next call
+ Parameters:    IN  chDrive - The drive letter
+                IN  pszDir - Pointer to the directory path
+ Return value:  Pointer to the index or NULL on error
  *****************************************************************************/
-static _Bool bdCompareSizeLarge (PDLST pDLST, PDLST pNew)
+static PDIDX bdIndexGet (char chDrive, char *pszDir)
 {
-    if (pDLST->fatEntry.Filesize > pNew->fatEntry.Filesize)
+    unsigned long ulChangeCount = R_FAT_GetChangeCount();
+    unsigned long ulLRU = -1UL;
+    PDIDX pIndex = NULL;
+    int iCount = BD_INDEX_CACHE_SIZE;
+    int iLRU = 0;
+
+    /* Longer paths are not cached by the client path cache either */
+    if (strlen(pszDir) >= BD_CLIENT_PATH_LENGTH)
+    {
+        return NULL;
+    }
+
+    while (iCount--)
+    {
+        PDIDX pSearch = &gpDirIndex[iCount];
+        unsigned long ulSearchLRU = pSearch->ulLRU;
+
+        /* An unused or out of date index is the first to be replaced */
+        if ((!pSearch->pEntry) || (pSearch->ulChangeCount != ulChangeCount))
+        {
+            ulSearchLRU = 0;
+        }
+        else if ((pSearch->chDrive == chDrive) && (!strcmp(pSearch->pszDir, pszDir)))
+        {
+            pIndex = pSearch;
+        }
+
+        /* Look for the least recently used */
+        if (ulSearchLRU <= ulLRU)
+        {
+            ulLRU = ulSearchLRU;
+            iLRU = iCount;
+        }
+    }
+
+    if (!pIndex)
     {
-        return true;
+        pIndex = &gpDirIndex[iLRU];
+        if (bdIndexBuild(pIndex, chDrive, pszDir))
+        {
+            return NULL;
+        }
     }
 
-    return false;
+    pIndex->ulLRU = ++gulIndexLRU;
+    return pIndex;
 }
 /*****************************************************************************
- End of function  bdCompareSizeLarge
+ End of function  bdIndexGet
  ******************************************************************************/
 
 /*****************************************************************************
- Function Name: bdCompareSizeSmall
- Description:   Function to perform the DIR_SORT_BY_SIZE_SMALL sort
- Parameters:    IN  pDLST - Pointer to the current list entry
- IN  pNew - Pointer to the new entry
- Return value:  false when the new entry should be inserted into the list
+ Function Name: bdIndexFlush
+ Description:   Function to free all of the directory indexes
+ Parameters:    none
+ Return value:  none
  *****************************************************************************/
-static _Bool bdCompareSizeSmall (PDLST pDLST, PDLST pNew)
+static void bdIndexFlush (void)
 {
-    if (pDLST->fatEntry.Filesize < pNew->fatEntry.Filesize)
+    int iCount = BD_INDEX_CACHE_SIZE;
+
+    while (iCount--)
     {
-        return true;
+        bdIndexFree(&gpDirIndex[iCount]);
     }
-
-    return false;
 }
 /*****************************************************************************
- End of function  bdCompareSizeSmall
+ End of function  bdIndexFlush
  ******************************************************************************/
 
 /*****************************************************************************
- Function Name: bdAddToList
- Description:   Function to add an enty to the list
- Parameters:    IN  ppDLST - Pointer to the list to add the entry to
- IN  pFatEntry - Pointer to the FAT entry to add
- IN  dirSort - The directory sorting method
- Return value:  pointer to the new entry on success. NULL on error
+ Function Name: bdIndexEntry
+ Description:   Function to get the entry at a position in the listing.
+                Directories are listed first, by name
+ Parameters:    IN  pIndex - Pointer to the index
+                IN  dirSort - The directory sorting method
+                IN  iPosition - The position in the listing, must be less
+                                than the number of entries
+ Return value:  Pointer to the entry
  *****************************************************************************/
-static PDLST bdAddToList (PDLST *ppDLST, PFATENTRY pFatEntry, DSORT dirSort)
+static PDIENT bdIndexEntry (PDIDX pIndex, DSORT dirSort, int iPosition)
 {
-    PDLST pDLST = (PDLST) malloc(sizeof(DLST));
-    if (pDLST)
+    if (iPosition < pIndex->iDirCount)
     {
-        static const PDCMP ppfnCompare[DIR_SORT_NUM] =
+        /* Directories can't be sorted any other way than alpha forward or reverse */
+        if (DIR_SORT_BY_NAME_Z_A == dirSort)
         {
-        /* DIR_SORT_BY_NAME_A_Z */
-        bdCompareNameAZ,
-        /* DIR_SORT_BY_NAME_Z_A */
-        bdCompareNameZA,
-        /* DIR_SORT_BY_DATE_RECENT */
-        bdCompareDateRecent,
-        /* DIR_SORT_BY_DATE_OLD */
-        bdCompareDateOld,
-        /* DIR_SORT_BY_SIZE_LARGE */
-        bdCompareSizeLarge,
-        /* DIR_SORT_BY_SIZE_SMALL */
-        bdCompareSizeSmall };
-        /* Take a copy of the FAT entry */
-        pDLST->fatEntry = *pFatEntry;
-        /* Add to the appropriate place in the list */
-        bdAddEntry(ppDLST, pDLST, ppfnCompare[dirSort]);
-        return pDLST;
+            iPosition = pIndex->iDirCount - 1 - iPosition;
+        }
+
+        return &pIndex->pEntry[pIndex->pusDirOrder[iPosition]];
     }
 
-    return NULL;
+    iPosition -= pIndex->iDirCount;
+    if (gcpSortOrder[dirSort].bfDescending)
+    {
+        iPosition = pIndex->iFileCount - 1 - iPosition;
+    }
+
+    return &pIndex->pEntry[pIndex->ppusFileOrder[gcpSortOrder[dirSort].dirKey][iPosition]];
 }
 /*****************************************************************************
- End of function  bdAddToList
+ End of function  bdIndexEntry
  ******************************************************************************/
 
 /*****************************************************************************
- Function Name: bdFreeList
- Description:   Function to free the list
- Parameters:    IN  ppDLST - Pointer to the list to add the entry to
- Return value:  none
+ Function Name: bdIndexFindDirectory
+ Description:   Function to find a directory in an index by name
+ Parameters:    IN  pIndex - Pointer to the index
+                IN  pszName - Pointer to the directory name
+ Return value:  Pointer to the entry or NULL if not found
  *****************************************************************************/
-static void bdFreeList (PDLST *ppDLST)
+static PDIENT bdIndexFindDirectory (PDIDX pIndex, const char *pszName)
 {
-    while (*ppDLST)
+    int iLow = 0;
+    int iHigh = pIndex->iDirCount - 1;
+
+    /* The directory order is by name */
+    while (iLow <= iHigh)
     {
-        PDLST pFree = *ppDLST;
-        bdRemoveEntry(ppDLST, pFree);
-        free(pFree);
+        int iMiddle = (iLow + iHigh) / 2;
+        PDIENT pEntry = &pIndex->pEntry[pIndex->pusDirOrder[iMiddle]];
+        int iCompare = stricmp(pIndex->pszNames + pEntry->ulName, pszName);
+
+        if (!iCompare)
+        {
+            return pEntry;
+        }
+
+        if (iCompare < 0)
+        {
+            iLow = iMiddle + 1;
+        }
+        else
+        {
+            iHigh = iMiddle - 1;
+        }
     }
+
+    return NULL;
 }
 /*****************************************************************************
- End of function  bdFreeList
+ End of function  bdIndexFindDirectory
  ******************************************************************************/
 
 /*****************************************************************************
@@ -1577,6 +2271,7 @@ static void bdGetDirectoryDate (PHTDIR pHtDir, char *pszDirDate)
         if ((*pszSplit == '/') || (*pszSplit == '\\'))
         {
             char *pszRootDir = gpszTemp1;
+            PDIDX pParent;
 
             /* Split the file directory from the path */
             *pszSplit = '\0';
@@ -1587,23 +2282,16 @@ static void bdGetDirectoryDate (PHTDIR pHtDir, char *pszDirDate)
                 pszRootDir = "/";
             }
 
-            /* Find the directory */
-            if (!R_FAT_FindFirst(&gs_dir, &(pHtDir->fatEntry), pszRootDir, "*"))
+            /* Find the directory in the index of its parent */
+            pParent = bdIndexGet(pHtDir->chDrive, pszRootDir);
+            if (pParent)
             {
-                while (true)
+                PDIENT pEntry = bdIndexFindDirectory(pParent, pszSplit);
+
+                if (pEntry)
                 {
-                    if (!R_FAT_FindNext( &gs_dir, &(pHtDir->fatEntry)))
-                    {
-                        if (!strcmp(pszSplit, (pHtDir->fatEntry).FileName))
-                        {
-                            bdFormatDate(pszDirDate, &(pHtDir->fatEntry));
-                            break;
-                        }
-                    }
-                    else
-                    {
-                        break;
-                    }
+                    bdIndexUnpack(pParent, pEntry, &(pHtDir->fatEntry));
+                    bdFormatDate(pszDirDate, &(pHtDir->fatEntry));
                 }
             }
             break;
@@ -1615,73 +2303,6 @@ static void bdGetDirectoryDate (PHTDIR pHtDir, char *pszDirDate)
  End of function  bdGetDirectoryDate
  ******************************************************************************/
 
-/*****************************************************************************
- Function Name: bdBuildDirectoryList
- Description:   Function to build a
- Parameters:    IN  pHtDir - Pointer to html directory information
- Return value:  0 for success or -1 on error
- *****************************************************************************/
-static int bdBuildDirectoryList (PHTDIR pHtDir)
-{
-    int iResult = 0;
-    int first_entry = 1;
-
-    /* Build the list of the entire directory */
-    while (true)
-    {
-        /* only continue if this is the first entry or an object was previously found and no error */
-        if (( !pHtDir->fatError) && ((0 != pHtDir->fatEntry.FileName[0]) || first_entry))
-        {
-            first_entry = 0;
-
-            /* Skip the references to the parent directory */
-            if ((strcmp(pHtDir->fatEntry.FileName, ".")) && (strcmp(pHtDir->fatEntry.FileName, ".."))
-
-            /* Skip if the file is hidden */
-            && (!(pHtDir->fatEntry.Attrib & FAT_ATTR_HIDDEN))
-
-            /* Skip if it is a system file */
-            && (!(pHtDir->fatEntry.Attrib & FAT_ATTR_SYSTEM)))
-            {
-                if (pHtDir->fatEntry.Attrib & FAT_ATTR_DIR)
-                {
-                    DSORT l_dir_sort;
-
-                    /* Directories can't be sorted any other way than alpha forward or reverse */
-                    l_dir_sort = (pHtDir->dirSort > DIR_SORT_BY_NAME_Z_A) ? DIR_SORT_BY_NAME_A_Z : pHtDir->dirSort;
-                    if (!bdAddToList(&pHtDir->pDirList, &pHtDir->fatEntry, l_dir_sort))
-                    {
-                        /* Out of memory */
-                        iResult = -1;
-                        break;
-                    }
-                }
-                else
-                {
-                    if (!bdAddToList(&pHtDir->pFileList, &pHtDir->fatEntry, pHtDir->dirSort))
-                    {
-                        /* Out of memory */
-                        iResult = -1;
-                        break;
-                    }
-                }
-            }
-        }
-        else
-        {
-            pHtDir->fatError = 0;
-            break;
-        }
-
-        /* find next file / directory */
-        pHtDir->fatError = R_FAT_FindNext(&gs_dir, &pHtDir->fatEntry);
-    }
-    return iResult;
-}
-/*****************************************************************************
- End of function  bdBuildDirectoryList
- ******************************************************************************/
-
 /*****************************************************************************
  Function Name: bgDirectory
  Description:   Function to format the directoy listing itself
@@ -1692,79 +2313,23 @@ static int bdBuildDirectoryList (PHTDIR pHtDir)
  *****************************************************************************/
 static _Bool bgDirectory (PHTDIR pHtDir, int iIndex, int iEntryCount)
 {
-    _Bool bfNext = false;
-    PDLST pSearch;
-
-    /* Go through the directory list */
-    pSearch = pHtDir->pDirList;
-    while (pSearch)
-    {
-        /* Don't print until the index is zero */
-        if (!iIndex)
-        {
-            /* Count the number of entries that need to be shown */
-            if (iEntryCount)
-            {
-                /* Count the number of entries */
-                iEntryCount--;
-
-                /* Format this entry */
-                bdEntry(pHtDir, &pSearch->fatEntry);
-            }
-            else
-            {
-                /* There are more entries and a next button is required */
-                bfNext = true;
-                break;
-            }
-        }
-        else
-        {
-            /* Count until desired position in the directory has been reached */
-            iIndex--;
-        }
+    int iCount = pHtDir->pIndex->iDirCount + pHtDir->pIndex->iFileCount;
+    int iPosition;
 
-        pSearch = pSearch->pNext;
-    }
+    iIndex = (iIndex < 0) ? 0 : iIndex;
 
-    if (iEntryCount)
+    /* Go straight to the desired position in the directory */
+    for (iPosition = iIndex; (iPosition < iCount) && (iPosition < (iIndex + iEntryCount)); iPosition++)
     {
-        /* Go through the file list */
-        pSearch = pHtDir->pFileList;
+        PDIENT pEntry = bdIndexEntry(pHtDir->pIndex, pHtDir->dirSort, iPosition);
 
-        while (pSearch)
-        {
-            /* Don't print until the index is zero */
-            if (!iIndex)
-            {
-                /* Count the number of entries that need to be shown */
-                if (iEntryCount)
-                {
-                    /* Count the number of entries */
-                    iEntryCount--;
-
-                    /* Format this entry */
-                    bdEntry(pHtDir, &pSearch->fatEntry);
-                }
-                else
-                {
-                    /* There are more entries and a next button is required */
-                    bfNext = true;
-                    break;
-                }
-            }
-            else
-            {
-                /* Count until desired position in the directory has been reached */
-                iIndex--;
-            }
-
-            pSearch = pSearch->pNext;
-        }
+        /* Format this entry */
+        bdIndexUnpack(pHtDir->pIndex, pEntry, &pHtDir->fatEntry);
+        bdEntry(pHtDir, &pHtDir->fatEntry);
     }
 
-    /* Return the next button status */
-    return bfNext;
+    /* A next button is required if there are more entries */
+    return (_Bool) ((iIndex + iEntryCount) < iCount);
 }
 /*****************************************************************************
  End of function  bgDirectory
@@ -1780,84 +2345,23 @@ static _Bool bgDirectory (PHTDIR pHtDir, int iIndex, int iEntryCount)
  *****************************************************************************/
 static size_t bgGetMaxNameLength (PHTDIR pHtDir, int iIndex, int iEntryCount)
 {
+    int iCount = pHtDir->pIndex->iDirCount + pHtDir->pIndex->iFileCount;
     size_t stMaxNameLength = 0;
-    PDLST pSearch;
+    int iPosition;
 
-    /* Go through the directory list */
-    pSearch = pHtDir->pDirList;
+    iIndex = (iIndex < 0) ? 0 : iIndex;
 
-    while (pSearch)
+    for (iPosition = iIndex; (iPosition < iCount) && (iPosition < (iIndex + iEntryCount)); iPosition++)
     {
-        /* Don't print until the index is zero */
-        if (!iIndex)
-        {
-            /* Count the number of entries that need to be shown */
-            if (iEntryCount)
-            {
-                /* Check the length of this entry */
-                size_t stLength = strlen(pSearch->fatEntry.FileName);
-
-                if (stLength > stMaxNameLength)
-                {
-                    stMaxNameLength = stLength;
-                }
+        /* Check the length of this entry */
+        size_t stLength = bdIndexEntry(pHtDir->pIndex, pHtDir->dirSort, iPosition)->byNameLength;
 
-                /* Count the number of entries */
-                iEntryCount--;
-            }
-            else
-            {
-                break;
-            }
-        }
-        else
+        if (stLength > stMaxNameLength)
         {
-            /* Count until desired position in the directory has been reached */
-            iIndex--;
+            stMaxNameLength = stLength;
         }
-
-        pSearch = pSearch->pNext;
     }
 
-    if (iEntryCount)
-    {
-        /* Go through the file list */
-        pSearch = pHtDir->pFileList;
-        while (pSearch)
-        {
-            /* Don't print until the index is zero */
-            if (!iIndex)
-            {
-                /* Count the number of entries that need to be shown */
-                if (iEntryCount)
-                {
-                    /* Check the length of this entry */
-                    size_t stLength = strlen(pSearch->fatEntry.FileName);
-                    if (stLength > stMaxNameLength)
-                    {
-                        stMaxNameLength = stLength;
-                    }
-
-                    /* Count the number of entries */
-                    iEntryCount--;
-                }
-                else
-                {
-                    break;
-                }
-            }
-            else
-            {
-                /* Count until desired position in the directory has been
-                 reached */
-                iIndex--;
-            }
-
-            pSearch = pSearch->pNext;
-        }
-    }
-
-    /* Return the next button status */
     return stMaxNameLength;
 }
 /*****************************************************************************
@@ -1892,16 +2396,11 @@ static int bdGeneratePage (PHTDIR pHtDir)
         /* Print the current drive and folder */
         wi_printf(pHtDir->pSess, gcpszCurrentFolder, pHtDir->chDrive, pHtDir->pszDir);
 
+        /* Shown when the directory can't be found in its parent */
+        strcpy(pszDirDate, "                -");
+
         if (iReady)
         {
-            /* Get the details of the directory itself */
-            pHtDir->fatError = R_FAT_FindFirst(&gs_dir, &pHtDir->fatEntry, pHtDir->pszDir, "*");
-
-            /* Make the data string for the directory */
-            bdFormatDate(pszDirDate, &pHtDir->fatEntry);
-
-            /* Build a list of the directory */
-            bdBuildDirectoryList(pHtDir);
             /* Check to see if this is the root folder - in which case
              there is no need for the parent directory entry in the listing */
             if (khanCompare((const int8_t *) "/", (const int8_t *) pHtDir->pszDir, 1))
@@ -1913,8 +2412,18 @@ static int bdGeneratePage (PHTDIR pHtDir)
                 {
                     bfPrevious = true;
                 }
+
+                /* Find the date for the parent directory entry. This gets
+                 the index of the parent so it is done before the index of
+                 this directory is got */
+                bdGetDirectoryDate(pHtDir, pszDirDate);
             }
 
+            /* Get the index of the directory, it is only read again if the
+             file system has changed since it was last read */
+            pHtDir->pIndex = bdIndexGet(pHtDir->chDrive, pHtDir->pszDir);
+            pHtDir->fatError = (pHtDir->pIndex) ? FAT_ERROR_NONE : FAT_ERROR_DIR_INVALID_PATH;
+
             /* Adjust the index if there is a page change request */
             if (pHtDir->bfGetNext)
             {
@@ -1935,7 +2444,12 @@ static int bdGeneratePage (PHTDIR pHtDir)
             }
 
             /* Look at the length of the file names on the list */
-            stMaxName = bgGetMaxNameLength(pHtDir, pHtDir->iIndex, pHtDir->iEntryCount);
+            stMaxName = 0;
+            if (pHtDir->pIndex)
+            {
+                stMaxName = bgGetMaxNameLength(pHtDir, pHtDir->iIndex, pHtDir->iEntryCount);
+            }
+
             if (stMaxName < BD_MIN_FILE_NAME_PADDIND)
             {
                 pHtDir->stFileNamePadding = BD_MIN_FILE_NAME_PADDIND;
@@ -1965,9 +2479,6 @@ static int bdGeneratePage (PHTDIR pHtDir)
             /* If this is not the root directory */
             if (!bfRoot)
             {
-                /* Find the date for the parent directory */
-                bdGetDirectoryDate(pHtDir, pszDirDate);
-
                 /* Print the parent directory entry */
                 bgParentDirectory(pHtDir, pszDirDate);
             }
@@ -1999,12 +2510,6 @@ static int bdGeneratePage (PHTDIR pHtDir)
 
         /* Print the footer to the directory table */
         wi_printf(pHtDir->pSess, gcpszTableFooter, gpszTemp1, gpszTemp2);
-
-        /* Free the directory listing */
-        bdFreeList(&pHtDir->pDirList);
-
-        /* Free the directory listing */
-        bdFreeList(&pHtDir->pFileList);
         return 0;
     }
 
@@ -39,11 +39,31 @@
 Includes   <System Includes> , "Project Includes"
 ******************************************************************************/
 
+#include <stdio.h>
 #include "websys.h"
 #include "webio.h"
 #include "liveFile.h"
+#include "r_task_priority.h"
+#include "r_os_abstraction_api.h"
 //#include "sysUsage.h"
 
+/******************************************************************************
+Macro Definitions
+******************************************************************************/
+
+/* Longest JSON line written for one pool size class */
+#define LIVE_POOL_CLASS_JSON_SIZE   (160)
+
+/* Longest JSON entries written for an allocation event and a task */
+#define LIVE_MEM_EVENT_JSON_SIZE    (80)
+#define LIVE_MEM_TASK_JSON_SIZE     (48)
+
+/* Tasks listed by sri_memtrace.json */
+#define LIVE_MEM_TRACE_TASKS        (32)
+
+/* Allocation events read at a time */
+#define LIVE_MEM_TRACE_CHUNK        (16)
+
 /******************************************************************************
 Global Variables
 ******************************************************************************/
@@ -205,42 +225,89 @@ End of function  liveGetTimers
 ******************************************************************************/
 
 /*****************************************************************************
-Function Name: liveGetHeap0
-Description:   Function to get the system resource information for Heap 0
+Function Name: liveGetPool
+Description:   Function to describe the size classes of a memory pool. The
+               waste is the part of the blocks handed out that was not
+               asked for, the internal fragmentation of the class
 Arguments:     IN  pszFileName - Pointer to the file name
                OUT pEfsFile - Pointer to the embedded file system object
+               IN  uiRegion - The pool index
 Return value:  0 for success -1 on error
 *****************************************************************************/
-static int liveGetHeap0(const int8_t *pszFileName, PEFS pEfsFile)
+static int liveGetPool(const int8_t *pszFileName, PEFS pEfsFile,
+                       uint32_t uiRegion)
 {
-    /* Get the data */
-    int8_t    *pszData = sriGet(SYRES_NUM + HEAP_WEB_SERVER);
+    st_os_mem_pool_stats_t poolStats;
+    uint32_t uiClass;
+    char    *pszData = R_OS_AllocMem((R_OS_ABSTRACTION_MEM_POOL_CLASSES + 1)
+                                     * LIVE_POOL_CLASS_JSON_SIZE,
+                                     R_REGION_LARGE_CAPACITY_RAM);
+    char    *pszDest = pszData;
     if (pszData)
     {
+        pszDest += sprintf(pszDest, "{\"region\":%u,\"classes\":[",
+                           (unsigned) uiRegion);
+        for (uiClass = 0;
+             R_OS_GetMemPoolStats(uiRegion, uiClass, &poolStats);
+             uiClass++)
+        {
+            uint64_t ullHandedOut = (uint64_t) poolStats.allocs
+                                  * poolStats.block_size;
+            unsigned uWaste = 0;
+            if (ullHandedOut > poolStats.requested_bytes)
+            {
+                uWaste = (unsigned) (((ullHandedOut
+                                       - poolStats.requested_bytes) * 100)
+                                     / ullHandedOut);
+            }
+            pszDest += sprintf(pszDest,
+                               "%s{\"size\":%u,\"capacity\":%u,\"used\":%u,"
+                               "\"peak\":%u,\"allocs\":%u,\"exhausted\":%u,"
+                               "\"waste\":%u}",
+                               (uiClass) ? "," : "",
+                               (unsigned) poolStats.block_size,
+                               (unsigned) poolStats.capacity,
+                               (unsigned) poolStats.in_use,
+                               (unsigned) poolStats.high_water,
+                               (unsigned) poolStats.allocs,
+                               (unsigned) poolStats.exhausted,
+                               uWaste);
+        }
+        sprintf(pszDest, "]}");
         return liveCreateFile(pszFileName, pEfsFile, pszData);
     }
     return -1;
 }
 /*****************************************************************************
+End of function  liveGetPool
+******************************************************************************/
+
+/*****************************************************************************
+Function Name: liveGetHeap0
+Description:   Function to get the pool usage of R_REGION_LARGE_CAPACITY_RAM
+Arguments:     IN  pszFileName - Pointer to the file name
+               OUT pEfsFile - Pointer to the embedded file system object
+Return value:  0 for success -1 on error
+*****************************************************************************/
+static int liveGetHeap0(const int8_t *pszFileName, PEFS pEfsFile)
+{
+    return liveGetPool(pszFileName, pEfsFile, 0);
+}
+/*****************************************************************************
 End of function  liveGetHeap0
 ******************************************************************************/
 
 /*****************************************************************************
 Function Name: liveGetHeap1
-Description:   Function to get the system resource information for Heap 1
+Description:   Function to get the pool usage of R_REGION_UNCACHED_RAM, which
+               is what lwIP allocates from
 Arguments:     IN  pszFileName - Pointer to the file name
                OUT pEfsFile - Pointer to the embedded file system object
 Return value:  0 for success -1 on error
 *****************************************************************************/
 static int liveGetHeap1(const int8_t *pszFileName, PEFS pEfsFile)
 {
-    /* Get the data */
-    int8_t    *pszData = sriGet(SYRES_NUM + HEAP_LWIP_PRIMARY);
-    if (pszData)
-    {
-        return liveCreateFile(pszFileName, pEfsFile, pszData);
-    }
-    return -1;
+    return liveGetPool(pszFileName, pEfsFile, 1);
 }
 /*****************************************************************************
 End of function  liveGetHeap1
@@ -248,17 +315,28 @@ End of function  liveGetHeap1
 
 /*****************************************************************************
 Function Name: liveGetHeap2
-Description:   Function to get the system resource information for Heap 2
+Description:   Function to get the usage of the heap behind the pools, which
+               serves the large blocks and any request of a full class
 Arguments:     IN  pszFileName - Pointer to the file name
                OUT pEfsFile - Pointer to the embedded file system object
 Return value:  0 for success -1 on error
 *****************************************************************************/
 static int liveGetHeap2(const int8_t *pszFileName, PEFS pEfsFile)
 {
-    /* Get the data */
-    int8_t    *pszData = sriGet(SYRES_NUM + HEAP_SDRAM);
+    st_os_mem_heap_stats_t heapStats;
+    char    *pszData = R_OS_AllocMem(LIVE_POOL_CLASS_JSON_SIZE,
+                                     R_REGION_LARGE_CAPACITY_RAM);
     if (pszData)
     {
+        R_OS_GetMemHeapStats(&heapStats);
+        sprintf(pszData,
+                "{\"free\":%u,\"minFree\":%u,\"used\":%u,"
+                "\"allocs\":%u,\"failures\":%u}",
+                (unsigned) heapStats.free_bytes,
+                (unsigned) heapStats.min_free_bytes,
+                (unsigned) heapStats.in_use,
+                (unsigned) heapStats.allocs,
+                (unsigned) heapStats.failures);
         return liveCreateFile(pszFileName, pEfsFile, pszData);
     }
     return -1;
@@ -269,17 +347,46 @@ End of function  liveGetHeap2
 
 /*****************************************************************************
 Function Name: liveGetHeap3
-Description:   Function to get the system resource information for Heap 3
+Description:   Function to get a summary of all the pools, the bytes they
+               reserve, hold now and held at most per class
 Arguments:     IN  pszFileName - Pointer to the file name
                OUT pEfsFile - Pointer to the embedded file system object
 Return value:  0 for success -1 on error
 *****************************************************************************/
 static int liveGetHeap3(const int8_t *pszFileName, PEFS pEfsFile)
 {
-    /* Get the data */
-    int8_t    *pszData = sriGet(SYRES_NUM + HEAP_SRAM);
+    st_os_mem_pool_stats_t poolStats;
+    uint32_t uiRegion;
+    uint32_t uiClass;
+    uint32_t uiReserved = 0;
+    uint32_t uiUsed = 0;
+    uint32_t uiPeak = 0;
+    uint32_t uiExhausted = 0;
+    char    *pszData = R_OS_AllocMem(LIVE_POOL_CLASS_JSON_SIZE,
+                                     R_REGION_LARGE_CAPACITY_RAM);
     if (pszData)
     {
+        for (uiRegion = 0;
+             uiRegion < R_OS_ABSTRACTION_MEM_POOL_REGIONS;
+             uiRegion++)
+        {
+            for (uiClass = 0;
+                 R_OS_GetMemPoolStats(uiRegion, uiClass, &poolStats);
+                 uiClass++)
+            {
+                uiReserved += poolStats.capacity * poolStats.block_size;
+                uiUsed += poolStats.in_use * poolStats.block_size;
+                uiPeak += poolStats.high_water * poolStats.block_size;
+                uiExhausted += poolStats.exhausted;
+            }
+        }
+        sprintf(pszData,
+                "{\"reserved\":%u,\"used\":%u,\"peak\":%u,"
+                "\"exhausted\":%u}",
+                (unsigned) uiReserved,
+                (unsigned) uiUsed,
+                (unsigned) uiPeak,
+                (unsigned) uiExhausted);
         return liveCreateFile(pszFileName, pEfsFile, pszData);
     }
     return -1;
@@ -288,6 +395,100 @@ static int liveGetHeap3(const int8_t *pszFileName, PEFS pEfsFile)
 End of function  liveGetHeap3
 ******************************************************************************/
 
+/*****************************************************************************
+Function Name: liveGetMemTrace
+Description:   Function to get the allocation trace, the running tasks and
+               every event held in the ring, for util/memtrace/memtrace.py.
+               Events are [seq,tick,task,type,region,size,address,caller]
+               or [seq,tick,task,"t",name] for a task's first event
+Arguments:     IN  pszFileName - Pointer to the file name
+               OUT pEfsFile - Pointer to the embedded file system object
+Return value:  0 for success -1 on error
+*****************************************************************************/
+static int liveGetMemTrace(const int8_t *pszFileName, PEFS pEfsFile)
+{
+    static const char pszType[] = "afxt";
+    st_os_mem_event_t  pEvents[LIVE_MEM_TRACE_CHUNK];
+    st_os_mem_trace_task_t *pTasks;
+    uint32_t uiSequence = 0;
+    uint32_t uiTotal = 0;
+    uint32_t uiCount;
+    uint32_t uiIndex;
+    char    *pszDest;
+    char    *pszData = R_OS_AllocMem((R_OS_ABSTRACTION_MEM_TRACE_EVENTS
+                                      * LIVE_MEM_EVENT_JSON_SIZE)
+                                     + (LIVE_MEM_TRACE_TASKS
+                                        * LIVE_MEM_TASK_JSON_SIZE)
+                                     + LIVE_MEM_EVENT_JSON_SIZE,
+                                     R_REGION_LARGE_CAPACITY_RAM);
+    if (!pszData)
+    {
+        return -1;
+    }
+    pszDest = pszData + sprintf(pszData, "{\"tasks\":[");
+    pTasks = R_OS_AllocMem(LIVE_MEM_TRACE_TASKS
+                           * sizeof(st_os_mem_trace_task_t),
+                           R_REGION_LARGE_CAPACITY_RAM);
+    if (pTasks)
+    {
+        uiCount = R_OS_GetMemTraceTasks(pTasks, LIVE_MEM_TRACE_TASKS);
+        for (uiIndex = 0; uiIndex < uiCount; uiIndex++)
+        {
+            pszDest += sprintf(pszDest, "%s[%u,\"%s\"]",
+                               (uiIndex) ? "," : "",
+                               (unsigned) pTasks[uiIndex].task,
+                               pTasks[uiIndex].name);
+        }
+        R_OS_FreeMem(pTasks);
+    }
+    pszDest += sprintf(pszDest, "],\"events\":[");
+    /* Stop after one ring's worth, the events made while this runs are
+       left for the next read */
+    while ((uiTotal < R_OS_ABSTRACTION_MEM_TRACE_EVENTS)
+    &&     (uiCount = R_OS_GetMemTrace(&uiSequence, pEvents,
+                                       LIVE_MEM_TRACE_CHUNK)) != 0)
+    {
+        for (uiIndex = 0;
+             (uiIndex < uiCount)
+             && ((uiTotal + uiIndex) < R_OS_ABSTRACTION_MEM_TRACE_EVENTS);
+             uiIndex++)
+        {
+            st_os_mem_event_t *pEvent = &pEvents[uiIndex];
+            if (R_OS_MEM_EVENT_TASK == pEvent->type)
+            {
+                pszDest += sprintf(pszDest, "%s[%lu,%lu,%u,\"t\",\"%.*s\"]",
+                                   (uiTotal + uiIndex) ? "," : "",
+                                   (unsigned long) (uiSequence + uiIndex),
+                                   (unsigned long) pEvent->timestamp,
+                                   (unsigned) pEvent->task,
+                                   R_OS_ABSTRACTION_MEM_TRACE_NAME_SIZE,
+                                   pEvent->data.name);
+            }
+            else
+            {
+                pszDest += sprintf(pszDest,
+                                   "%s[%lu,%lu,%u,\"%c\",%u,%lu,%lu,%lu]",
+                                   (uiTotal + uiIndex) ? "," : "",
+                                   (unsigned long) (uiSequence + uiIndex),
+                                   (unsigned long) pEvent->timestamp,
+                                   (unsigned) pEvent->task,
+                                   pszType[pEvent->type],
+                                   (unsigned) pEvent->region,
+                                   (unsigned long) pEvent->data.block.size,
+                                   (unsigned long) pEvent->data.block.address,
+                                   (unsigned long) pEvent->data.block.caller);
+            }
+        }
+        uiSequence += uiIndex;
+        uiTotal += uiIndex;
+    }
+    sprintf(pszDest, "],\"next\":%lu}", (unsigned long) uiSequence);
+    return liveCreateFile(pszFileName, pEfsFile, pszData);
+}
+/*****************************************************************************
+End of function  liveGetMemTrace
+******************************************************************************/
+
 /*****************************************************************************
 Constant Data
 ******************************************************************************/
@@ -316,7 +517,10 @@ static const LIFNASS gpLiveFnAss[] =
     liveGetHeap2,
 
     "sri_heap3.json",
-    liveGetHeap3
+    liveGetHeap3,
+
+    "sri_memtrace.json",
+    liveGetMemTrace
     /* TODO: Add more live file names and handling functions */
 
 };
@@ -41,16 +41,22 @@
 
 #include <ctype.h>
 #include <stdio.h>
+#include <math.h>
 #include "control.h"
 #include "websys.h"
 #include "webCGI.h"
 #include "iodefine_cfg.h"
 #include "r_led_drv_api.h"
 #include "command.h"
+#include "dev_drv.h"
+#include "r_soundbar.h"
+#include "r_media_library.h"
 
 /******************************************************************************
  Macro definitions
  ******************************************************************************/
+/* Tracks listed on one media library page */
+#define CGI_MEDIA_LIBRARY_MAX_TRACKS    (100)
 
 /*****************************************************************************
  Function Macros
@@ -74,6 +80,17 @@ static const char * const gpszLedCtrl = "<p><input type=\"checkbox\" onclick=\"c
         "<a href=\"#\"    onclick=\"callFunc"
         "('ledCheckBox', 'led_ctrl.cgi', '0,%d')\">User LED</a></p>\r\n";
 
+/* The check box for the playback DSP and a line per stage */
+static const char * const gpszDspCtrl = "<p><input type=\"checkbox\" onclick=\"callFunc"
+        "('dspCheckBox', 'dsp_ctrl.cgi', '0')\" %s/>\r\n"
+        "<a href=\"#\"    onclick=\"callFunc"
+        "('dspCheckBox', 'dsp_ctrl.cgi', '0')\">Playback DSP</a></p>\r\n";
+
+static const char * const gpszDspBand = "<p>EQ %u: %s %ld Hz %s%ld.%ld dB Q %ld.%.2ld</p>\r\n";
+
+static const char * const gpszDspStages = "<p>Crossover: %s %ld Hz</p>\r\n"
+        "<p>Limiter: %s -%ld.%ld dB, release %ld ms</p>\r\n";
+
 static const char * const gpszNotifyString =
         "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01 Transitional//EN\" \"http://www.w3c.org/TR/1999/REC-html401-19991224/loose.dtd\">\r\n"
                 "<HTML lang=en xml:lang=\"en\" xmlns=\"http://www.w3.org/1999/xhtml\"><HEAD><TITLE>%s | Renesas Electronics</TITLE>\r\n"
@@ -117,6 +134,7 @@ static const char * const gpszNotifyString =
 
 extern int cgiMsExplore (PSESS pSess, PEOFILE pEoFile);
 int cgiMsTest (PSESS pSess, PEOFILE pEoFile);
+int cgiMsDirBench (PSESS pSess, PEOFILE pEoFile);
 extern int cmdUserName (int iArgCount, int8_t **ppszArgument, pst_comset_t pCom);
 extern int cmdChangePassword (int iArgCount, int8_t **ppszArgument, pst_comset_t pCom);
 
@@ -614,6 +632,272 @@ static int cgiLedCtrl (PSESS pSess, PEOFILE pEoFile)
  End of function  cgiLedCtrl
  ******************************************************************************/
 
+/******************************************************************************
+ Function Name: cgiDspCtrl
+ Description:   Function to show the playback DSP settings, the argument '0'
+                switches the chain on or off
+ Arguments:     IN/OUT pSess - Pointer to the session data
+ IN/OUT pEoFile - Pointer to the embedded file object
+ Return value:  0 for success or error code
+ ******************************************************************************/
+static int cgiDspCtrl (PSESS pSess, PEOFILE pEoFile)
+{
+    static char *pp_checked[2] =
+    { "", "checked=\"checked\"" };
+    st_audio_dsp_config_t config;
+    char *p_szarg;
+    uint32_t band;
+    long tenths;
+    long hundredths;
+
+    UNUSED_PARAM(pEoFile);
+
+    r_soundtst_GetDspConfig( &config);
+
+    p_szarg = cgiGetArgument(pSess, true);
+
+    if ((p_szarg) && ('0' == *p_szarg))
+    {
+        config.enable = (config.enable) ? false : true;
+        r_soundtst_SetDspConfig( &config);
+        r_soundtst_GetDspConfig( &config);
+    }
+
+    wi_printf(pSess, gpszDspCtrl, pp_checked[(config.enable) ? 1 : 0]);
+
+    for (band = 0u; band < AUDIO_DSP_EQ_BANDS; band++)
+    {
+        /* the web server printf has no floating point support */
+        tenths = lrintf(fabsf(config.eq[band].gain_db) * 10.0f);
+        hundredths = lrintf(config.eq[band].q * 100.0f);
+
+        wi_printf(pSess, gpszDspBand, (unsigned) (band + 1u), r_audio_dsp_filter_name(config.eq[band].type),
+                lrintf(config.eq[band].freq_hz), (config.eq[band].gain_db < 0.0f) ? "-" : "", tenths / 10, tenths % 10,
+                hundredths / 100, hundredths % 100);
+    }
+
+    tenths = lrintf(fabsf(config.limiter_threshold_db) * 10.0f);
+
+    wi_printf(pSess, gpszDspStages, (config.crossover_enable) ? "on" : "off", lrintf(config.crossover_hz),
+            (config.limiter_enable) ? "on" : "off", tenths / 10, tenths % 10, lrintf(config.limiter_release_ms));
+
+    return (0);
+}
+/******************************************************************************
+ End of function  cgiDspCtrl
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cgiMediaText
+ Description:   Function to copy text from the media library so that it can
+                be put in a page, markup and unprintable chars are replaced
+ Arguments:     OUT pszDest - Pointer to the destination
+                IN  pszSrc - Pointer to the text
+                IN  stSize - The size of the destination
+ Return value:  Pointer to the destination
+ ******************************************************************************/
+static char *cgiMediaText (char *pszDest, const char *pszSrc, size_t stSize)
+{
+    char *pszResult = pszDest;
+
+    while ((*pszSrc) && (stSize > 1))
+    {
+        *pszDest = (strchr("<>&\"'", *pszSrc)) ? '_' : *pszSrc;
+        pszDest++;
+        pszSrc++;
+        stSize--;
+    }
+
+    *pszDest = '\0';
+    cgiReplaceUnprintableChars(pszResult, '_');
+
+    return pszResult;
+}
+/******************************************************************************
+ End of function  cgiMediaText
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cgiMediaLibrary
+ Description:   Function to show the media library of a drive. The first
+                argument is the drive letter, the second is either "rescan"
+                or a text the tracks listed must contain
+ Arguments:     IN/OUT pSess - Pointer to the session data
+ IN/OUT pEoFile - Pointer to the embedded file object
+ Return value:  0 for success or error code
+ ******************************************************************************/
+static int cgiMediaLibrary (PSESS pSess, PEOFILE pEoFile)
+{
+    static const char * const pszFormats[] =
+    { "WAV", "AIFF", "FLAC" };
+    st_media_library_status_t status;
+    st_media_track_t track;
+    char pszFind[32] = "";
+    char pszText[MEDIA_LIBRARY_MAX_PATH];
+    char chDrive = 'A';
+    char *pszArgument;
+    int iListed = 0;
+    int32_t lIndex;
+
+    UNUSED_PARAM(pEoFile);
+
+    pszArgument = cgiGetArgument(pSess, true);
+    if ((pszArgument) && (isalpha(*pszArgument)))
+    {
+        chDrive = (char) toupper(*pszArgument);
+        pszArgument = cgiGetArgument(pSess, false);
+    }
+
+    if ((pszArgument) && (0 == strncmp(pszArgument, "rescan", 6)))
+    {
+        r_media_library_rescan(chDrive);
+    }
+    else if (pszArgument)
+    {
+        /* The argument runs to the end of the request line */
+        sscanf(pszArgument, "%31[^ \t\r\n]", pszFind);
+    }
+
+    r_media_library_get_status(chDrive, &status);
+
+    if (!status.ready)
+    {
+        wi_printf(pSess, "<div><p>%c: has no media library%s</p></div>\r\n", chDrive,
+                (status.scanning) ? ", it is being scanned" : "");
+        return (0);
+    }
+
+    wi_printf(pSess, "<div><p>%c: %lu tracks in %lu folders%s</p>\r\n", chDrive, (unsigned long) status.tracks,
+            (unsigned long) status.dirs, (status.scanning) ? ", checking for changes" : "");
+    wi_printf(pSess, "<p>Last scan %lu ms, %lu files read, %lu folders unchanged</p>\r\n<table>\r\n",
+            (unsigned long) status.scan_ms, (unsigned long) status.files_parsed, (unsigned long) status.dirs_reused);
+
+    lIndex = r_media_library_find(chDrive, pszFind, MEDIA_LIBRARY_FORMAT_ALL, 0u);
+    while ((lIndex >= 0) && (iListed < CGI_MEDIA_LIBRARY_MAX_TRACKS)
+            && (DEVDRV_SUCCESS == r_media_library_get_track(chDrive, (uint32_t) lIndex, &track)))
+    {
+        const char *pszFormat = "";
+        uint32_t ulSeconds = track.duration_ms / 1000u;
+        int iFormat;
+
+        for (iFormat = 0; iFormat < 3; iFormat++)
+        {
+            if (track.format == (1u << iFormat))
+            {
+                pszFormat = pszFormats[iFormat];
+            }
+        }
+
+        wi_printf(pSess, "<tr><td>%s</td>", cgiMediaText(pszText, track.path, sizeof(pszText)));
+        wi_printf(pSess, "<td>%s</td>", cgiMediaText(pszText, track.title, sizeof(pszText)));
+        wi_printf(pSess, "<td>%s</td>", cgiMediaText(pszText, track.artist, sizeof(pszText)));
+        wi_printf(pSess, "<td>%s</td>", cgiMediaText(pszText, track.album, sizeof(pszText)));
+        wi_printf(pSess, "<td>%s %lu Hz %u bit</td><td>%lu:%.2lu</td></tr>\r\n", pszFormat,
+                (unsigned long) track.sample_rate, (unsigned) track.bits_per_sample,
+                (unsigned long) (ulSeconds / 60u), (unsigned long) (ulSeconds % 60u));
+
+        iListed++;
+        lIndex = r_media_library_find(chDrive, pszFind, MEDIA_LIBRARY_FORMAT_ALL, (uint32_t) lIndex + 1u);
+    }
+
+    wi_printf(pSess, "</table>\r\n%s</div>\r\n", (lIndex >= 0) ? "<p>More tracks match, refine the search</p>" : "");
+
+    return (0);
+}
+/******************************************************************************
+ End of function  cgiMediaLibrary
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: cgiDspSet
+ Description:   Function to change the playback DSP. The form fields are, in
+                order: band (1-5), type (0 off, 1 peak, 2 low shelf, 3 high
+                shelf, 4 low pass, 5 high pass), frequency, gain dB, Q,
+                crossover Hz (0 off), limiter threshold dB (above 0 off) and
+                limiter release ms. Empty fields leave the setting unchanged.
+ Arguments:     IN/OUT pSess - Pointer to the session data
+ IN/OUT pEoFile - Pointer to the embedded file object
+ Return value:  0 for success or error code
+ ******************************************************************************/
+static int cgiDspSet (PSESS pSess, PEOFILE pEoFile)
+{
+    (void) pEoFile;
+    if (pSess->ws_formlist)
+    {
+        st_audio_dsp_config_t config;
+        st_audio_dsp_band_t *p_band = NULL;
+        int iBand = 0;
+        int iType = -1;
+        float fValue;
+
+        r_soundtst_GetDspConfig( &config);
+
+        sscanf(pSess->ws_formlist->pairs[0].value, "%d", &iBand);
+        if ((iBand >= 1) && (iBand <= (int) AUDIO_DSP_EQ_BANDS))
+        {
+            p_band = &config.eq[iBand - 1];
+        }
+
+        if (p_band)
+        {
+            if ((1 == sscanf(pSess->ws_formlist->pairs[1].value, "%d", &iType)) && (iType >= 0)
+                    && (iType < (int) AUDIO_DSP_FILTER_COUNT))
+            {
+                p_band->type = (e_audio_dsp_filter_t) iType;
+            }
+            if (1 == sscanf(pSess->ws_formlist->pairs[2].value, "%f", &fValue))
+            {
+                p_band->freq_hz = fValue;
+            }
+            if (1 == sscanf(pSess->ws_formlist->pairs[3].value, "%f", &fValue))
+            {
+                p_band->gain_db = fValue;
+            }
+            if (1 == sscanf(pSess->ws_formlist->pairs[4].value, "%f", &fValue))
+            {
+                p_band->q = fValue;
+            }
+        }
+
+        if (1 == sscanf(pSess->ws_formlist->pairs[5].value, "%f", &fValue))
+        {
+            config.crossover_enable = (fValue > 0.0f);
+            if (config.crossover_enable)
+            {
+                config.crossover_hz = fValue;
+            }
+        }
+
+        if (1 == sscanf(pSess->ws_formlist->pairs[6].value, "%f", &fValue))
+        {
+            config.limiter_enable = (fValue <= 0.0f);
+            if (config.limiter_enable)
+            {
+                config.limiter_threshold_db = fValue;
+            }
+        }
+
+        if (1 == sscanf(pSess->ws_formlist->pairs[7].value, "%f", &fValue))
+        {
+            config.limiter_release_ms = fValue;
+        }
+
+        if (DEVDRV_SUCCESS == r_soundtst_SetDspConfig( &config))
+        {
+            wi_printf(pSess, gpszNotifyString, "DSP Settings", "The playback DSP settings have been changed.");
+        }
+        else
+        {
+            wi_printf(pSess, gpszNotifyString, "DSP Settings",
+                    "A setting is out of range or playback has not been started.");
+        }
+    }
+    return 0;
+}
+/******************************************************************************
+ End of function  cgiDspSet
+ ******************************************************************************/
+
 /******************************************************************************
  Function Name: cgiSetTime
  Description:   Function to set the time
@@ -854,8 +1138,12 @@ static const CGIFNASS gpCgiFnAss[] =
 {
     {(int8_t *) "get_time.cgi", cgiGetTime},
 	{(int8_t *) "led_ctrl.cgi", cgiLedCtrl},
+	{(int8_t *) "dsp_ctrl.cgi", cgiDspCtrl},
+	{(int8_t *) "dsp_set.cgi", cgiDspSet},
+	{(int8_t *) "media_lib.cgi", cgiMediaLibrary},
 	{(int8_t *) "ms_explore.cgi", cgiMsExplore},
 	{(int8_t *) "ms_test.cgi", cgiMsTest},
+	{(int8_t *) "ms_dir_bench.cgi", cgiMsDirBench},
 	{(int8_t *) "set_time.cgi", cgiSetTime},
 	{(int8_t *) "set_date.cgi", cgiSetDate},
 	{(int8_t *) "set_user.cgi", cgiSetUserName},
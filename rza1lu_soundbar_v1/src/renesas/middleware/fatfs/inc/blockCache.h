@@ -35,12 +35,63 @@
 #ifndef BLOCKCACHE_H_INCLUDED
 #define BLOCKCACHE_H_INCLUDED
 
+/***********************************************************************************
+Defines
+***********************************************************************************/
+
+/* Default geometry, a line is read from the device in one transfer */
+#define BC_DEFAULT_LINE_SIZE        8
+#define BC_DEFAULT_NUM_ENTRIES      64
+
+/* Lines per set, a sector can only be cached in the lines of the set its
+   line number hashes to */
+#define BC_WAYS                     4
+
+/* Read-ahead window in sectors. A read that carries on from the last one
+   starts at the minimum, each time the stream uses up what was read ahead
+   the window doubles up to the maximum, which is also the buffer size */
+#define BC_READ_AHEAD_MIN_SECTORS   16
+#define BC_READ_AHEAD_SECTORS       128
+
+/* Write-back buffer in sectors, and the number of separate runs of
+   adjacent sectors it holds. Each run goes to the device as one write */
+#define BC_WRITE_BACK_SECTORS       128
+#define BC_WRITE_BACK_EXTENTS       8
+
 /***********************************************************************************
 Typedefs
 ***********************************************************************************/
 
 typedef struct _BCACHE *PBACHE;
 
+/* Cache counters, reset by bcResetStats */
+typedef struct _BCSTATS
+{
+    /* Single sector reads served from the cache */
+    unsigned long   ulHits;
+    /* Single sector reads that loaded a line */
+    unsigned long   ulMisses;
+    /* Valid lines replaced by a miss */
+    unsigned long   ulEvictions;
+    /* Lines dropped because they were written to */
+    unsigned long   ulInvalidations;
+    /* Multiple sector reads passed straight to the device */
+    unsigned long   ulBypassed;
+    /* Sectors read from the read-ahead buffer */
+    unsigned long   ulReadAheadHits;
+    /* Transfers that filled the read-ahead buffer */
+    unsigned long   ulReadAheadFills;
+    /* Sectors read ahead and dropped without being used */
+    unsigned long   ulReadAheadWasted;
+    /* Writes taken into the write-back buffer */
+    unsigned long   ulWritesBuffered;
+    /* Transfers that emptied the write-back buffer, one per run */
+    unsigned long   ulWriteBackTransfers;
+    /* Sectors written by those transfers */
+    unsigned long   ulWriteBackSectors;
+} BCSTATS,
+*PBCSTATS;
+
 /***********************************************************************************
 Public Functions
 ***********************************************************************************/
@@ -55,7 +106,8 @@ Description:   Function to create a block cache
 Parameters:    IN  iMsDev - The file descriptor of the MS device
                IN  iLun  - The logical unit number of the device
                IN  iLineSize - The cache line size in sectors
-               IN  iNumEntries - The number of entries
+               IN  iNumEntries - The number of entries, rounded down to a
+                                 power of two number of BC_WAYS sets
                IN  iBlockSize - The block size of the device
                IN  ulNumBlocks - The total number of blocks
 Return value:  pointer to the block cache or NULL on error
@@ -70,7 +122,8 @@ extern  PBACHE bcCreate(int iMsDev,
 
 /**********************************************************************************
 Function Name: bcDestroy
-Description:   Function to destroy a block cache
+Description:   Function to destroy a block cache, buffered writes are flushed
+               first
 Parameters:    IN  pBlkCache - Pointer to the block cache to destroy
 Return value:  none
 **********************************************************************************/
@@ -94,7 +147,9 @@ extern  unsigned long bcRead(PBACHE         pBlkCache,
 
 /**********************************************************************************
 Function Name: bcWrite
-Description:   Function to write with cache
+Description:   Function to write through the write-back buffer. The data
+               reaches the device when the buffer fills, when a read needs
+               it, on bcFlush or on bcDestroy
 Parameters:    IN  pBlkCache - Pointer to the block cache
                IN  pbyBuffer - Pointer to the source buffer memory
                IN  ulSector - The starting sector (block)
@@ -107,6 +162,35 @@ extern  unsigned long bcWrite(PBACHE         pBlkCache,
                               unsigned long  ulSector,
                               unsigned long  ulNumberOfSectors);
 
+/**********************************************************************************
+Function Name: bcFlush
+Description:   Function to write everything held in the write-back buffer to
+               the device
+Parameters:    IN  pBlkCache - Pointer to the block cache
+Return value:  0 for success -1 on error, the data is dropped either way
+**********************************************************************************/
+
+extern  int bcFlush(PBACHE pBlkCache);
+
+/**********************************************************************************
+Function Name: bcGetStats
+Description:   Function to read the cache counters
+Parameters:    IN  pBlkCache - Pointer to the block cache
+               OUT pStats - Pointer to the destination
+Return value:  none
+**********************************************************************************/
+
+extern  void bcGetStats(PBACHE pBlkCache, PBCSTATS pStats);
+
+/**********************************************************************************
+Function Name: bcResetStats
+Description:   Function to clear the cache counters
+Parameters:    IN  pBlkCache - Pointer to the block cache
+Return value:  none
+**********************************************************************************/
+
+extern  void bcResetStats(PBACHE pBlkCache);
+
 #ifdef __cplusplus
 }
 #endif
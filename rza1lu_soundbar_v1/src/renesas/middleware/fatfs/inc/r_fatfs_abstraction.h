@@ -441,6 +441,18 @@ FRESULT R_FAT_FormatDrive (PDRIVE pDrive);
  */
 int R_FAT_DriveIsAvailable (PDRIVE pDrive);
 
+/**
+ * @brief   Function to get the count of changes made through this layer.
+ *          It is advanced by every call that can change what a directory
+ *          listing returns: mounting or removing a drive, opening a file
+ *          for writing, writing, closing a written file, removing, renaming
+ *          and making directories. A cached listing is current for as long
+ *          as this value is unchanged.
+ *
+ * @retval     The change count
+ */
+unsigned long R_FAT_GetChangeCount (void);
+
 /**
  * @brief    Function to translate the FullFAT error code to the library code
  *     
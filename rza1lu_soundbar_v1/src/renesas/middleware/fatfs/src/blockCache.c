@@ -56,21 +56,28 @@ Typedefs
 /* The structure if the cache index */
 typedef struct _BCIDX
 {
-    /* The cache status */
-    union {
-            unsigned long   ulStatus;
-        struct {
-            /* Set when the cache entry is valid */
-            unsigned long   Valid:1;
-            /* The used count for the LRU entry replacement */
-            unsigned long   Count:31;
-        } Field;
-    } Status;
-    /* The tag */
+    /* The tag, the first sector of the line */
     unsigned long   ulSector;
+    /* The access clock when the line was last used, the oldest line in a set
+       is the least recently used */
+    unsigned long   ulLastUsed;
+    /* Set when the cache entry is valid */
+    int             iValid;
 } BCIDX,
 *PBCIDX;
 
+/* A run of adjacent sectors held in the write-back buffer */
+typedef struct _BCEXTENT
+{
+    /* The first sector of the run */
+    unsigned long   ulSector;
+    /* The number of sectors in the run */
+    unsigned long   ulCount;
+    /* The position of the first sector in the buffer, in sectors */
+    unsigned long   ulOffset;
+} BCEXTENT,
+*PBCEXTENT;
+
 /* The structure of the cache object */
 typedef struct _BCACHE
 {
@@ -85,24 +92,86 @@ typedef struct _BCACHE
     int     iBlockSize;
     /* The total number of sectors on the MS device */
     unsigned long ulNumBlocks;
+    /* The number of entries in each set */
+    int     iWays;
+    /* The number of sets less one, the number of sets is a power of two */
+    unsigned long ulSetMask;
+    /* Incremented on every lookup to order the lines in a set */
+    unsigned long ulClock;
+    /* The cache counters */
+    BCSTATS Stats;
     /* Pointer to the start of the index */
     PBCIDX  pIndex;
     /* Pointer to the start of cache memory */
     unsigned char *pbyCache;
+    /* Serialises the buffers, FatFs is not built reentrant and each drive
+       can be reached from several tasks */
+    void   *pvMutex;
+
+    /* The sector following the last read of the stream being followed */
+    unsigned long ulStreamNext;
+    /* The current read-ahead window in sectors */
+    unsigned long ulWindow;
+    /* The sectors held in the read-ahead buffer */
+    unsigned long ulRaSector;
+    unsigned long ulRaCount;
+    /* The sector following the last one read from the read-ahead buffer */
+    unsigned long ulRaUsed;
+    /* Pointer to the read-ahead buffer */
+    unsigned char *pbyReadAhead;
+
+    /* The runs of sectors in the write-back buffer, in the order written */
+    BCEXTENT Extents[BC_WRITE_BACK_EXTENTS];
+    int     iNumExtents;
+    /* The number of sectors of the write-back buffer in use */
+    unsigned long ulWbUsed;
+    /* Pointer to the write-back buffer */
+    unsigned char *pbyWriteBack;
 
 } BCACHE;
 
+/***********************************************************************************
+Defines
+***********************************************************************************/
+
+/* Golden ratio multiplier, spreads strided line numbers across the sets */
+#define BC_HASH_MULTIPLIER          0x9E3779B1UL
+#define BC_HASH_SHIFT               16
+
 /***********************************************************************************
 Function Prototypes
 ***********************************************************************************/
 void dump_sector2 (uint32_t sector, char *buffer);
 static unsigned char *bcSearch(PBACHE         pBlkCache,
-                               unsigned long  ulSector,
+                               unsigned long  ulCacheSector,
                                PBCIDX        *ppEntry);
-static unsigned char *bcGetEntry(PBACHE pBlkCache, PBCIDX *ppEntry);
+static unsigned char *bcGetEntry(PBACHE         pBlkCache,
+                                 unsigned long  ulCacheSector,
+                                 PBCIDX        *ppEntry);
+static PBCIDX bcGetSet(PBACHE pBlkCache, unsigned long ulCacheSector);
+static unsigned char *bcGetLine(PBACHE pBlkCache, PBCIDX pEntry);
 static int bcInvalidate(PBACHE         pBlkCache,
                        unsigned long  ulSector,
                        unsigned long  ulNumSectors);
+static unsigned long bcReadDevice(PBACHE         pBlkCache,
+                                  unsigned char *pbyBuffer,
+                                  unsigned long  ulSector,
+                                  unsigned long  ulNumberOfSectors);
+static unsigned long bcReadAhead(PBACHE         pBlkCache,
+                                 unsigned char *pbyBuffer,
+                                 unsigned long  ulSector,
+                                 unsigned long  ulNumberOfSectors);
+static void bcDropReadAhead(PBACHE pBlkCache);
+static int bcBufferWrite(PBACHE         pBlkCache,
+                         const unsigned char *pbyBuffer,
+                         unsigned long  ulSector,
+                         unsigned long  ulNumberOfSectors);
+static PBCEXTENT bcFindExtent(PBACHE pBlkCache, unsigned long ulSector);
+static unsigned long bcSectorsFree(PBACHE pBlkCache, unsigned long ulSector);
+static int bcIsBuffered(PBACHE         pBlkCache,
+                        unsigned long  ulSector,
+                        unsigned long  ulNumSectors);
+static int bcFlushWriteBack(PBACHE pBlkCache);
 
 extern  int scsiRead10(int      iMsDev,
                        int      iLun,
@@ -142,6 +211,26 @@ PBACHE bcCreate(int iMsDev,
 {
     PBACHE  pBlkCache;
     size_t  stSize = sizeof(BCACHE);
+    int     iWays = BC_WAYS;
+    unsigned long ulSets = 1UL;
+
+    if ((iLineSize <= 0) || (iNumEntries <= 0) || (iBlockSize <= 0))
+    {
+        return NULL;
+    }
+
+    /* Small caches are fully associative */
+    if (iNumEntries < iWays)
+    {
+        iWays = iNumEntries;
+    }
+
+    /* Round the number of sets down to a power of two so a mask selects one */
+    while ((ulSets * 2UL) <= ((unsigned long)iNumEntries / (unsigned long)iWays))
+    {
+        ulSets *= 2UL;
+    }
+    iNumEntries = (int)ulSets * iWays;
 
     /* Add on the size of the cache memory */
     stSize += (size_t)(iLineSize * iNumEntries * iBlockSize);
@@ -149,21 +238,38 @@ PBACHE bcCreate(int iMsDev,
     /* Add on the size of the index */
     stSize += (size_t)(sizeof(BCIDX) * (unsigned int)iNumEntries);
 
+    /* Add on the size of the read-ahead and write-back buffers */
+    stSize += (size_t)((BC_READ_AHEAD_SECTORS + BC_WRITE_BACK_SECTORS) * iBlockSize);
+
     /* Allocate the memory */
     pBlkCache = (PBACHE)R_OS_AllocMem(stSize, R_REGION_LARGE_CAPACITY_RAM);
     if (pBlkCache)
     {
         /* Initialise the data */
+        memset(pBlkCache, 0, sizeof(BCACHE));
         pBlkCache->iMsDev = iMsDev;
         pBlkCache->iLun = iLun;
         pBlkCache->iLineSize = iLineSize;
         pBlkCache->iNumEntries = iNumEntries;
         pBlkCache->iBlockSize = iBlockSize;
         pBlkCache->ulNumBlocks = ulNumBlocks;
+        pBlkCache->iWays = iWays;
+        pBlkCache->ulSetMask = ulSets - 1UL;
         pBlkCache->pIndex =  (PBCIDX)(((char*)pBlkCache) + sizeof(BCACHE));
         pBlkCache->pbyCache = (unsigned char*)((char*)pBlkCache->pIndex + (sizeof(BCIDX) * (unsigned long)iNumEntries));
         memset((int*)pBlkCache->pIndex, 0, (sizeof(BCIDX) * (unsigned long)iNumEntries));
         memset(pBlkCache->pbyCache, 0, (size_t)(iLineSize * iNumEntries * iBlockSize));
+        pBlkCache->pbyReadAhead = pBlkCache->pbyCache + (iLineSize * iNumEntries * iBlockSize);
+        pBlkCache->pbyWriteBack = pBlkCache->pbyReadAhead + (BC_READ_AHEAD_SECTORS * iBlockSize);
+        pBlkCache->ulWindow = BC_READ_AHEAD_MIN_SECTORS;
+        /* No stream until the second of two reads that follow on */
+        pBlkCache->ulStreamNext = ~0UL;
+        pBlkCache->pvMutex = R_OS_CreateMutex();
+        if (!pBlkCache->pvMutex)
+        {
+            R_OS_FreeMem(pBlkCache);
+            pBlkCache = NULL;
+        }
     }
     return pBlkCache;
 }
@@ -173,12 +279,16 @@ End of function  bcCreate
 
 /**********************************************************************************
 Function Name: bcDestroy
-Description:   Function to destroy a block cache
+Description:   Function to destroy a block cache, buffered writes are flushed
+               first
 Parameters:    IN  pBlkCache - Pointer to the block cache to destroy
 Return value:  none
 **********************************************************************************/
 void bcDestroy(PBACHE pBlkCache)
 {
+    /* Nothing more can be done if the device has gone */
+    bcFlush(pBlkCache);
+    R_OS_DeleteMutex(pBlkCache->pvMutex);
     R_OS_FreeMem(pBlkCache);
 }
 /**********************************************************************************
@@ -187,7 +297,9 @@ End of function  bcDestroy
 
 /**********************************************************************************
 Function Name: bcRead
-Description:   Function to read with cache
+Description:   Function to read with cache. A read that follows on from the
+               last one is served through the read-ahead buffer, single
+               sectors elsewhere through the cache lines
 Parameters:    IN  pBlkCache - Pointer to the block cache
                IN  pbyBuffer - Pointer to the destinaton buffer memory
                IN  ulSector - The starting sector (block)
@@ -198,6 +310,169 @@ unsigned long bcRead(PBACHE         pBlkCache,
                      unsigned char *pbyBuffer,
                      unsigned long  ulSector,
                      unsigned long  ulNumberOfSectors)
+{
+    unsigned long ulRead = 0UL;
+
+    R_OS_AcquireMutex(pBlkCache->pvMutex);
+
+    /* Sectors still in the write-back buffer must reach the device before
+       they can be read back from it */
+    if ((!bcIsBuffered(pBlkCache, ulSector, ulNumberOfSectors))
+    ||  (!bcFlushWriteBack(pBlkCache)))
+    {
+        ulRead = bcReadAhead(pBlkCache, pbyBuffer, ulSector, ulNumberOfSectors);
+        if (ulRead < ulNumberOfSectors)
+        {
+            if (bcReadDevice(pBlkCache,
+                             pbyBuffer + (ulRead * (unsigned long)pBlkCache->iBlockSize),
+                             ulSector + ulRead,
+                             ulNumberOfSectors - ulRead))
+            {
+                ulRead = ulNumberOfSectors;
+            }
+            else
+            {
+                ulRead = 0UL;
+            }
+        }
+    }
+
+    R_OS_ReleaseMutex(pBlkCache->pvMutex);
+    return ulRead;
+}
+/**********************************************************************************
+End of function  bcRead
+***********************************************************************************/
+
+/**********************************************************************************
+Function Name: bcWrite
+Description:   Function to write through the write-back buffer. The data
+               reaches the device when the buffer fills, when a read needs
+               it, on bcFlush or on bcDestroy
+Parameters:    IN  pBlkCache - Pointer to the block cache
+               IN  pbyBuffer - Pointer to the source buffer memory
+               IN  ulSector - The starting sector (block)
+               IN  ulNumberOfSectors - The number of sectors (blocks)
+Return value:  The number of blocks written
+**********************************************************************************/
+unsigned long bcWrite(PBACHE         pBlkCache,
+                      const unsigned char *pbyBuffer,
+                      unsigned long  ulSector,
+                      unsigned long  ulNumberOfSectors)
+{
+    unsigned long ulWritten = ulNumberOfSectors;
+    size_t  stLengthWritten;
+
+    R_OS_AcquireMutex(pBlkCache->pvMutex);
+
+    /* Invalidate any entries in the cache which are in this area */
+    bcInvalidate(pBlkCache, ulSector, ulNumberOfSectors);
+    if ((pBlkCache->ulRaCount)
+    &&  (pBlkCache->ulRaSector < (ulSector + ulNumberOfSectors))
+    &&  ((pBlkCache->ulRaSector + pBlkCache->ulRaCount) > ulSector))
+    {
+        bcDropReadAhead(pBlkCache);
+    }
+
+    if (ulNumberOfSectors < BC_WRITE_BACK_SECTORS)
+    {
+        if (bcBufferWrite(pBlkCache, pbyBuffer, ulSector, ulNumberOfSectors))
+        {
+            ulWritten = 0UL;
+        }
+    }
+    else
+    {
+        /* Too big to gain from buffering, keep the order of the writes by
+           emptying the buffer first */
+        if ((bcFlushWriteBack(pBlkCache))
+        ||  (scsiWrite10(pBlkCache->iMsDev,
+                         pBlkCache->iLun,
+                         ulSector,
+                         (WORD)ulNumberOfSectors,
+                         (PBYTE)pbyBuffer,
+                         (size_t)(ulNumberOfSectors * (unsigned long)pBlkCache->iBlockSize),
+                         &stLengthWritten)))
+        {
+            /* Device driver error */
+            ulWritten = 0UL;
+        }
+    }
+
+    R_OS_ReleaseMutex(pBlkCache->pvMutex);
+    return ulWritten;
+}
+/**********************************************************************************
+End of function  bcWrite
+***********************************************************************************/
+
+/**********************************************************************************
+Function Name: bcFlush
+Description:   Function to write everything held in the write-back buffer to
+               the device
+Parameters:    IN  pBlkCache - Pointer to the block cache
+Return value:  0 for success -1 on error
+**********************************************************************************/
+int bcFlush(PBACHE pBlkCache)
+{
+    int     iResult;
+
+    R_OS_AcquireMutex(pBlkCache->pvMutex);
+    iResult = bcFlushWriteBack(pBlkCache);
+    R_OS_ReleaseMutex(pBlkCache->pvMutex);
+    return iResult;
+}
+/**********************************************************************************
+End of function  bcFlush
+***********************************************************************************/
+
+/**********************************************************************************
+Function Name: bcGetStats
+Description:   Function to read the cache counters
+Parameters:    IN  pBlkCache - Pointer to the block cache
+               OUT pStats - Pointer to the destination
+Return value:  none
+**********************************************************************************/
+void bcGetStats(PBACHE pBlkCache, PBCSTATS pStats)
+{
+    *pStats = pBlkCache->Stats;
+}
+/**********************************************************************************
+End of function  bcGetStats
+***********************************************************************************/
+
+/**********************************************************************************
+Function Name: bcResetStats
+Description:   Function to clear the cache counters
+Parameters:    IN  pBlkCache - Pointer to the block cache
+Return value:  none
+**********************************************************************************/
+void bcResetStats(PBACHE pBlkCache)
+{
+    memset(&pBlkCache->Stats, 0, sizeof(BCSTATS));
+}
+/**********************************************************************************
+End of function  bcResetStats
+***********************************************************************************/
+
+/***********************************************************************************
+Private Functions
+***********************************************************************************/
+
+/**********************************************************************************
+Function Name: bcReadDevice
+Description:   Function to read through the cache lines or, for more than one
+               sector, directly from the device
+Parameters:    IN  pBlkCache - Pointer to the block cache
+               IN  pbyBuffer - Pointer to the destinaton buffer memory
+               IN  ulSector - The starting sector (block)
+               IN  ulNumberOfSectors - The number of sectors (blocks)
+Return value:  The number of blocks read
+**********************************************************************************/
+static unsigned long bcReadDevice(PBACHE         pBlkCache,
+                                  unsigned char *pbyBuffer,
+                                  unsigned long  ulSector,
+                                  unsigned long  ulNumberOfSectors)
 {
     unsigned long ulCacheSector = (ulSector - (ulSector % (unsigned long)pBlkCache->iLineSize));
     size_t  stLengthRead;
@@ -208,12 +483,20 @@ unsigned long bcRead(PBACHE         pBlkCache,
     {
         PBCIDX  pEntry;
         /* Search the cache for this entry */
-        unsigned char *pbyCache = bcSearch(pBlkCache, ulSector, &pEntry);
+        unsigned char *pbyCache = bcSearch(pBlkCache, ulCacheSector, &pEntry);
         if (!pbyCache)
         {
             /* Get a new cache entry */
             volatile size_t  stLength = (size_t)(pBlkCache->iLineSize * pBlkCache->iBlockSize);
-            pbyCache = bcGetEntry(pBlkCache, &pEntry);
+            pbyCache = bcGetEntry(pBlkCache, ulCacheSector, &pEntry);
+            pBlkCache->Stats.ulMisses++;
+
+            /* The rest of the line may still be in the write-back buffer */
+            if ((bcIsBuffered(pBlkCache, ulCacheSector, (unsigned long)pBlkCache->iLineSize))
+            &&  (bcFlushWriteBack(pBlkCache)))
+            {
+                return 0UL;
+            }
 
             /* Read into the cache memory */
             if (scsiRead10(pBlkCache->iMsDev,
@@ -234,14 +517,19 @@ unsigned long bcRead(PBACHE         pBlkCache,
             /* Set the start sector */
             pEntry->ulSector = ulCacheSector;
             /* Set the valid flag */
-            pEntry->Status.Field.Valid = TRUE;
-            /* Set the sector address */
-            pbyCache = pbyCache + ((ulSector - ulCacheSector) * (unsigned long)pBlkCache->iBlockSize);
+            pEntry->iValid = TRUE;
+        }
+        else
+        {
+            pBlkCache->Stats.ulHits++;
         }
+        /* Set the sector address */
+        pbyCache = pbyCache + ((ulSector - ulCacheSector) * (unsigned long)pBlkCache->iBlockSize);
         /* Copy to the destination */
         memcpy(pbyBuffer, pbyCache, (size_t)pBlkCache->iBlockSize);
         return 1UL;
     }
+    pBlkCache->Stats.ulBypassed++;
     /* Read directly into memory */
     if (scsiRead10(pBlkCache->iMsDev,
                    pBlkCache->iLun,
@@ -254,89 +542,434 @@ unsigned long bcRead(PBACHE         pBlkCache,
         /* Device driver error */
         return 0UL;
     }
-   // dump_sector2(ulSector, pbyBuffer);
-
     return ulNumberOfSectors;
 }
 /**********************************************************************************
-End of function  bcRead
+End of function  bcReadDevice
 ***********************************************************************************/
 
 /**********************************************************************************
-Function Name: bcWrite
-Description:   Function to write with cache
+Function Name: bcReadAhead
+Description:   Function to serve the start of a read from the read-ahead
+               buffer. When the read follows on from the last one the buffer
+               is refilled from the device with a window that doubles each
+               time the stream uses up the previous one, and shrinks again
+               when a multiple sector read starts somewhere else. Single
+               sector reads elsewhere are FAT and directory accesses in the
+               middle of a file and leave the stream alone
+Parameters:    IN  pBlkCache - Pointer to the block cache
+               IN  pbyBuffer - Pointer to the destinaton buffer memory
+               IN  ulSector - The starting sector (block)
+               IN  ulNumberOfSectors - The number of sectors (blocks)
+Return value:  The number of blocks read, the rest must be read from the device
+**********************************************************************************/
+static unsigned long bcReadAhead(PBACHE         pBlkCache,
+                                 unsigned char *pbyBuffer,
+                                 unsigned long  ulSector,
+                                 unsigned long  ulNumberOfSectors)
+{
+    unsigned long ulBlockSize = (unsigned long)pBlkCache->iBlockSize;
+    unsigned long ulRaEnd = pBlkCache->ulRaSector + pBlkCache->ulRaCount;
+    unsigned long ulRead = 0UL;
+    int     iFollowsOn = (ulSector == pBlkCache->ulStreamNext)
+                      || ((ulSector >= pBlkCache->ulRaSector) && (ulSector < ulRaEnd));
+
+    if (iFollowsOn)
+    {
+        pBlkCache->ulStreamNext = ulSector + ulNumberOfSectors;
+    }
+    else if (ulNumberOfSectors > 1UL)
+    {
+        /* A new stream, start it with a smaller window */
+        pBlkCache->ulStreamNext = ulSector + ulNumberOfSectors;
+        if (pBlkCache->ulWindow > BC_READ_AHEAD_MIN_SECTORS)
+        {
+            pBlkCache->ulWindow /= 2UL;
+        }
+    }
+
+    while (ulRead < ulNumberOfSectors)
+    {
+        unsigned long ulCount;
+        size_t  stLengthRead;
+
+        ulRaEnd = pBlkCache->ulRaSector + pBlkCache->ulRaCount;
+        if ((ulSector >= pBlkCache->ulRaSector) && (ulSector < ulRaEnd))
+        {
+            ulCount = ulRaEnd - ulSector;
+            if (ulCount > (ulNumberOfSectors - ulRead))
+            {
+                ulCount = ulNumberOfSectors - ulRead;
+            }
+            memcpy(pbyBuffer,
+                   pBlkCache->pbyReadAhead + ((ulSector - pBlkCache->ulRaSector) * ulBlockSize),
+                   (size_t)(ulCount * ulBlockSize));
+            pBlkCache->Stats.ulReadAheadHits += ulCount;
+            pbyBuffer += ulCount * ulBlockSize;
+            ulSector += ulCount;
+            ulRead += ulCount;
+            if (ulSector > pBlkCache->ulRaUsed)
+            {
+                pBlkCache->ulRaUsed = ulSector;
+            }
+            continue;
+        }
+
+        /* Only follow a stream, and leave reads the size of the buffer to go
+           to the device directly */
+        if ((!iFollowsOn)
+        ||  ((ulNumberOfSectors - ulRead) >= BC_READ_AHEAD_SECTORS)
+        ||  (ulSector >= pBlkCache->ulNumBlocks))
+        {
+            break;
+        }
+
+        /* The stream used everything read ahead last time */
+        if ((pBlkCache->ulRaCount) && (ulSector == ulRaEnd) && (pBlkCache->ulRaUsed == ulRaEnd)
+        &&  (pBlkCache->ulWindow < BC_READ_AHEAD_SECTORS))
+        {
+            pBlkCache->ulWindow *= 2UL;
+        }
+
+        ulCount = pBlkCache->ulWindow;
+        if (ulCount < (ulNumberOfSectors - ulRead))
+        {
+            ulCount = ulNumberOfSectors - ulRead;
+        }
+        if (ulCount > (pBlkCache->ulNumBlocks - ulSector))
+        {
+            ulCount = pBlkCache->ulNumBlocks - ulSector;
+        }
+
+        bcDropReadAhead(pBlkCache);
+        if ((bcIsBuffered(pBlkCache, ulSector, ulCount))
+        &&  (bcFlushWriteBack(pBlkCache)))
+        {
+            break;
+        }
+        if (scsiRead10(pBlkCache->iMsDev,
+                       pBlkCache->iLun,
+                       ulSector,
+                       (WORD)ulCount,
+                       pBlkCache->pbyReadAhead,
+                       (size_t)(ulCount * ulBlockSize),
+                       &stLengthRead))
+        {
+            /* Leave the rest to the device, it will report the error */
+            break;
+        }
+        pBlkCache->ulRaSector = ulSector;
+        pBlkCache->ulRaCount = ulCount;
+        pBlkCache->ulRaUsed = ulSector;
+        pBlkCache->Stats.ulReadAheadFills++;
+    }
+    return ulRead;
+}
+/**********************************************************************************
+End of function  bcReadAhead
+***********************************************************************************/
+
+/**********************************************************************************
+Function Name: bcDropReadAhead
+Description:   Function to empty the read-ahead buffer
+Parameters:    IN  pBlkCache - Pointer to the block cache
+Return value:  none
+**********************************************************************************/
+static void bcDropReadAhead(PBACHE pBlkCache)
+{
+    unsigned long ulRaEnd = pBlkCache->ulRaSector + pBlkCache->ulRaCount;
+
+    if (pBlkCache->ulRaCount)
+    {
+        pBlkCache->Stats.ulReadAheadWasted += ulRaEnd - pBlkCache->ulRaUsed;
+        pBlkCache->ulRaCount = 0UL;
+    }
+}
+/**********************************************************************************
+End of function  bcDropReadAhead
+***********************************************************************************/
+
+/**********************************************************************************
+Function Name: bcBufferWrite
+Description:   Function to copy a write into the write-back buffer. Sectors
+               already buffered are overwritten where they are, a write that
+               follows on from the last run extends it and anything else
+               starts a new run. The buffer is flushed when it is full
 Parameters:    IN  pBlkCache - Pointer to the block cache
                IN  pbyBuffer - Pointer to the source buffer memory
                IN  ulSector - The starting sector (block)
                IN  ulNumberOfSectors - The number of sectors (blocks)
-Return value:  The number of blocks written
+Return value:  0 for success -1 on error
 **********************************************************************************/
-unsigned long bcWrite(PBACHE         pBlkCache,
-                      const unsigned char *pbyBuffer,
-                      unsigned long  ulSector,
-                      unsigned long  ulNumberOfSectors)
+static int bcBufferWrite(PBACHE         pBlkCache,
+                         const unsigned char *pbyBuffer,
+                         unsigned long  ulSector,
+                         unsigned long  ulNumberOfSectors)
 {
-    size_t  stLengthWritten;
-    /* Invalidate any entries in the cache which are in this area */
-    bcInvalidate(pBlkCache, ulSector, ulNumberOfSectors);
-    /* Write directly to the device */
-    if (scsiWrite10(pBlkCache->iMsDev,
-                    pBlkCache->iLun,
-                    ulSector,
-                    (WORD)ulNumberOfSectors,
-                    (PBYTE)pbyBuffer,
-                    (size_t)(ulNumberOfSectors * (unsigned long)pBlkCache->iBlockSize),
-                    &stLengthWritten))
+    unsigned long ulBlockSize = (unsigned long)pBlkCache->iBlockSize;
+
+    while (ulNumberOfSectors)
     {
-        /* Device driver error */
-        return 0UL;
+        PBCEXTENT pExtent = bcFindExtent(pBlkCache, ulSector);
+        unsigned long ulCount;
+
+        if (pExtent)
+        {
+            /* Overwrite the buffered copy */
+            ulCount = pExtent->ulSector + pExtent->ulCount - ulSector;
+            if (ulCount > ulNumberOfSectors)
+            {
+                ulCount = ulNumberOfSectors;
+            }
+            memcpy(pBlkCache->pbyWriteBack
+                   + ((pExtent->ulOffset + ulSector - pExtent->ulSector) * ulBlockSize),
+                   pbyBuffer, (size_t)(ulCount * ulBlockSize));
+        }
+        else
+        {
+            /* Stop short of the next run so no sector is buffered twice */
+            ulCount = bcSectorsFree(pBlkCache, ulSector);
+            if (ulCount > ulNumberOfSectors)
+            {
+                ulCount = ulNumberOfSectors;
+            }
+            if (ulCount > (BC_WRITE_BACK_SECTORS - pBlkCache->ulWbUsed))
+            {
+                ulCount = BC_WRITE_BACK_SECTORS - pBlkCache->ulWbUsed;
+            }
+
+            /* Only the last run ends at the end of the used buffer */
+            if (pBlkCache->iNumExtents)
+            {
+                pExtent = &pBlkCache->Extents[pBlkCache->iNumExtents - 1];
+            }
+            if ((ulCount) && (pExtent)
+            &&  ((pExtent->ulSector + pExtent->ulCount) == ulSector))
+            {
+                pExtent->ulCount += ulCount;
+            }
+            else if ((ulCount) && (pBlkCache->iNumExtents < BC_WRITE_BACK_EXTENTS))
+            {
+                pExtent = &pBlkCache->Extents[pBlkCache->iNumExtents++];
+                pExtent->ulSector = ulSector;
+                pExtent->ulCount = ulCount;
+                pExtent->ulOffset = pBlkCache->ulWbUsed;
+            }
+            else
+            {
+                /* Full, make room and try again */
+                if (bcFlushWriteBack(pBlkCache))
+                {
+                    return -1;
+                }
+                continue;
+            }
+            memcpy(pBlkCache->pbyWriteBack + (pBlkCache->ulWbUsed * ulBlockSize),
+                   pbyBuffer, (size_t)(ulCount * ulBlockSize));
+            pBlkCache->ulWbUsed += ulCount;
+        }
+        pbyBuffer += ulCount * ulBlockSize;
+        ulSector += ulCount;
+        ulNumberOfSectors -= ulCount;
     }
-    return ulNumberOfSectors;
+    pBlkCache->Stats.ulWritesBuffered++;
+    return 0;
 }
 /**********************************************************************************
-End of function  bcWrite
+End of function  bcBufferWrite
 ***********************************************************************************/
 
-/***********************************************************************************
-Private Functions
+/**********************************************************************************
+Function Name: bcFindExtent
+Description:   Function to find the run in the write-back buffer holding a
+               sector
+Parameters:    IN  pBlkCache - Pointer to the block cache
+               IN  ulSector - The sector
+Return value:  Pointer to the run or NULL if the sector is not buffered
+**********************************************************************************/
+static PBCEXTENT bcFindExtent(PBACHE pBlkCache, unsigned long ulSector)
+{
+    int     iExtent;
+
+    for (iExtent = 0; iExtent < pBlkCache->iNumExtents; iExtent++)
+    {
+        PBCEXTENT pExtent = &pBlkCache->Extents[iExtent];
+        if ((ulSector >= pExtent->ulSector)
+        &&  (ulSector < (pExtent->ulSector + pExtent->ulCount)))
+        {
+            return pExtent;
+        }
+    }
+    return NULL;
+}
+/**********************************************************************************
+End of function  bcFindExtent
+***********************************************************************************/
+
+/**********************************************************************************
+Function Name: bcSectorsFree
+Description:   Function to count the sectors from one that is not buffered to
+               the start of the next run in the write-back buffer
+Parameters:    IN  pBlkCache - Pointer to the block cache
+               IN  ulSector - The sector
+Return value:  The number of sectors, ~0 when no run follows
+**********************************************************************************/
+static unsigned long bcSectorsFree(PBACHE pBlkCache, unsigned long ulSector)
+{
+    unsigned long ulFree = ~0UL;
+    int     iExtent;
+
+    for (iExtent = 0; iExtent < pBlkCache->iNumExtents; iExtent++)
+    {
+        PBCEXTENT pExtent = &pBlkCache->Extents[iExtent];
+        if ((pExtent->ulSector > ulSector)
+        &&  ((pExtent->ulSector - ulSector) < ulFree))
+        {
+            ulFree = pExtent->ulSector - ulSector;
+        }
+    }
+    return ulFree;
+}
+/**********************************************************************************
+End of function  bcSectorsFree
+***********************************************************************************/
+
+/**********************************************************************************
+Function Name: bcIsBuffered
+Description:   Function to check for sectors of a range in the write-back
+               buffer
+Parameters:    IN  pBlkCache - Pointer to the block cache
+               IN  ulSector - The starting sector
+               IN  ulNumSectors - The number of sectors
+Return value:  true if any sector of the range is buffered
+**********************************************************************************/
+static int bcIsBuffered(PBACHE         pBlkCache,
+                        unsigned long  ulSector,
+                        unsigned long  ulNumSectors)
+{
+    int     iExtent;
+
+    for (iExtent = 0; iExtent < pBlkCache->iNumExtents; iExtent++)
+    {
+        PBCEXTENT pExtent = &pBlkCache->Extents[iExtent];
+        if ((pExtent->ulSector < (ulSector + ulNumSectors))
+        &&  ((pExtent->ulSector + pExtent->ulCount) > ulSector))
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+/**********************************************************************************
+End of function  bcIsBuffered
+***********************************************************************************/
+
+/**********************************************************************************
+Function Name: bcFlushWriteBack
+Description:   Function to write each run in the write-back buffer to the
+               device with one command. The buffer is emptied even on error,
+               FatFs has no way to retry and holding the data would only
+               fail every later write as well
+Parameters:    IN  pBlkCache - Pointer to the block cache
+Return value:  0 for success -1 on error
+**********************************************************************************/
+static int bcFlushWriteBack(PBACHE pBlkCache)
+{
+    int     iResult = 0;
+    int     iExtent;
+
+    for (iExtent = 0; iExtent < pBlkCache->iNumExtents; iExtent++)
+    {
+        PBCEXTENT pExtent = &pBlkCache->Extents[iExtent];
+        size_t  stLengthWritten;
+
+        if (scsiWrite10(pBlkCache->iMsDev,
+                        pBlkCache->iLun,
+                        pExtent->ulSector,
+                        (WORD)pExtent->ulCount,
+                        pBlkCache->pbyWriteBack + (pExtent->ulOffset * (unsigned long)pBlkCache->iBlockSize),
+                        (size_t)(pExtent->ulCount * (unsigned long)pBlkCache->iBlockSize),
+                        &stLengthWritten))
+        {
+            /* Device driver error */
+            iResult = -1;
+            break;
+        }
+        pBlkCache->Stats.ulWriteBackTransfers++;
+        pBlkCache->Stats.ulWriteBackSectors += pExtent->ulCount;
+    }
+    pBlkCache->iNumExtents = 0;
+    pBlkCache->ulWbUsed = 0UL;
+    return iResult;
+}
+/**********************************************************************************
+End of function  bcFlushWriteBack
+***********************************************************************************/
+
+/**********************************************************************************
+Function Name: bcGetSet
+Description:   Function to find the set a line is cached in
+Parameters:    IN  pBlkCache - Pointer to the block cache
+               IN  ulCacheSector - The first sector of the line
+Return value:  Pointer to the first entry of the set
+**********************************************************************************/
+static PBCIDX bcGetSet(PBACHE pBlkCache, unsigned long ulCacheSector)
+{
+    unsigned long ulLine = ulCacheSector / (unsigned long)pBlkCache->iLineSize;
+    unsigned long ulSet = ((ulLine * BC_HASH_MULTIPLIER) >> BC_HASH_SHIFT) & pBlkCache->ulSetMask;
+
+    return pBlkCache->pIndex + (ulSet * (unsigned long)pBlkCache->iWays);
+}
+/**********************************************************************************
+End of function  bcGetSet
+***********************************************************************************/
+
+/**********************************************************************************
+Function Name: bcGetLine
+Description:   Function to get the cache memory of an entry
+Parameters:    IN  pBlkCache - Pointer to the block cache
+               IN  pEntry - Pointer to the entry
+Return value:  Pointer to the first sector of the line
+**********************************************************************************/
+static unsigned char *bcGetLine(PBACHE pBlkCache, PBCIDX pEntry)
+{
+    return pBlkCache->pbyCache
+         + ((pEntry - pBlkCache->pIndex) * pBlkCache->iLineSize * pBlkCache->iBlockSize);
+}
+/**********************************************************************************
+End of function  bcGetLine
 ***********************************************************************************/
 
 /**********************************************************************************
 Function Name: bcSearch
 Description:   Function to search the cache for a valid entry
 Parameters:    IN  pBlkCache - Pointer to the block cache
-               IN  ulSector - The starting sector (block)
+               IN  ulCacheSector - The first sector of the line
                OUT ppEntry - Pointer to the entry pointer
 Return value:  Pointer to the cache memory or NULL if not found
 **********************************************************************************/
 static unsigned char *bcSearch(PBACHE         pBlkCache,
-                               unsigned long  ulSector,
+                               unsigned long  ulCacheSector,
                                PBCIDX        *ppEntry)
 {
-    PBCIDX  pEntry = pBlkCache->pIndex;
-    PBCIDX  pEnd = pEntry + pBlkCache->iNumEntries;
-    /* Search each entry in the cache index */
+    PBCIDX  pEntry = bcGetSet(pBlkCache, ulCacheSector);
+    PBCIDX  pEnd = pEntry + pBlkCache->iWays;
+
+    pBlkCache->ulClock++;
+
+    /* Only the lines of one set can hold the sector */
     while (pEntry < pEnd)
     {
-        /* If the entry is valid */
-        if ((pEntry->Status.Field.Valid)
-        /* And the sector is within the line */
-        &&  (ulSector >= pEntry->ulSector)
-        &&  (ulSector < (unsigned long)((unsigned long)pEntry->ulSector + (unsigned long)pBlkCache->iLineSize)))
+        if ((pEntry->iValid) && (pEntry->ulSector == ulCacheSector))
         {
-            /* Calculate the position in the cache memory */
-            unsigned char *pbySrc = (pBlkCache->pbyCache
-                                  + ((pEntry - pBlkCache->pIndex)
-                                  * pBlkCache->iLineSize * pBlkCache->iBlockSize)
-                                  + ((ulSector - (unsigned long)pEntry->ulSector) * (unsigned long)pBlkCache->iBlockSize));
+            /* Mark as the most recently used */
+            pEntry->ulLastUsed = pBlkCache->ulClock;
             if (ppEntry)
             {
                 *ppEntry = pEntry;
             }
-            return pbySrc;
+            return bcGetLine(pBlkCache, pEntry);
         }
-        /* Count the times each entry is searched */
-        pEntry->Status.Field.Count++;
         pEntry++;
     }
     return NULL;
@@ -347,45 +980,53 @@ End of function  bcSearch
 
 /**********************************************************************************
 Function Name: bcGetEntry
-Description:   Function to get a pointer to a free entry
+Description:   Function to get a free entry, or the least recently used one in
+               the set of the line
 Parameters:    IN  pBlkCache - Pointer to the block cache
+               IN  ulCacheSector - The first sector of the line to be loaded
                OUT ppEntry - Pointer to an entry pointer
 Return value:  Pointer to the cache memory associated with the entry
 **********************************************************************************/
-static unsigned char *bcGetEntry(PBACHE pBlkCache, PBCIDX *ppEntry)
+static unsigned char *bcGetEntry(PBACHE         pBlkCache,
+                                 unsigned long  ulCacheSector,
+                                 PBCIDX        *ppEntry)
 {
-    PBCIDX  pEntry = pBlkCache->pIndex;
+    PBCIDX  pEntry = bcGetSet(pBlkCache, ulCacheSector);
     PBCIDX  pResult = pEntry;
-    PBCIDX  pEnd = pEntry + pBlkCache->iNumEntries;
-    unsigned char *pbySrc = pBlkCache->pbyCache;
-    int     iUsedCount = 0;
-    /* Search each entry in the cache index */
+    PBCIDX  pEnd = pEntry + pBlkCache->iWays;
+    unsigned long ulOldest = 0UL;
+
+    /* Search each entry in the set */
     while (pEntry < pEnd)
     {
-        int iCount = (int)pEntry->Status.Field.Count;
+        /* The age is wrap safe where the clock value itself is not */
+        unsigned long ulAge = pBlkCache->ulClock - pEntry->ulLastUsed;
+
         /* If an entry is not valid it is good to use */
-        if (!pEntry->Status.Field.Valid)
+        if (!pEntry->iValid)
         {
             pResult = pEntry;
             break;
         }
         /* Check for the least recently used */
-        if (iCount > iUsedCount)
+        if (ulAge > ulOldest)
         {
-            iUsedCount = iCount;
+            ulOldest = ulAge;
             pResult = pEntry;
         }
         pEntry++;
     }
-    /* Calculate the position in the cache memory */
-    pbySrc += ((pResult - pBlkCache->pIndex)
-           * pBlkCache->iLineSize * pBlkCache->iBlockSize);
+    if (pResult->iValid)
+    {
+        pBlkCache->Stats.ulEvictions++;
+    }
     /* Return the entry */
     *ppEntry = pResult;
-    /* Reset the status flags */
-    pResult->Status.ulStatus = 0UL;
+    /* Invalid until the line has been read, used now */
+    pResult->iValid = FALSE;
+    pResult->ulLastUsed = pBlkCache->ulClock;
     /* Return the position */
-   return pbySrc;
+    return bcGetLine(pBlkCache, pResult);
 }
 /**********************************************************************************
 End of function  bcGetEntry
@@ -403,24 +1044,47 @@ static int bcInvalidate(PBACHE         pBlkCache,
                         unsigned long  ulSector,
                         unsigned long  ulNumSectors)
 {
-    PBCIDX  pEntry = pBlkCache->pIndex;
-    PBCIDX  pEnd = pEntry + pBlkCache->iNumEntries;
+    unsigned long ulLineSize = (unsigned long)pBlkCache->iLineSize;
     unsigned long ulEndSector = ulSector + ulNumSectors;
-    /* Search each entry in the cache index */
-    while (pEntry < pEnd)
+    unsigned long ulCacheSector = (ulSector - (ulSector % ulLineSize));
+    PBCIDX  pEntry;
+    PBCIDX  pEnd;
+
+    if (((ulEndSector - ulCacheSector) / ulLineSize) >= (unsigned long)pBlkCache->iNumEntries)
     {
-        if (pEntry->Status.Field.Valid)
+        /* Large writes, check every entry rather than every line written */
+        pEntry = pBlkCache->pIndex;
+        pEnd = pEntry + pBlkCache->iNumEntries;
+        while (pEntry < pEnd)
         {
-            unsigned long   ulEntryStart = pEntry->ulSector;
-            unsigned long   ulEntryEnd = (ulEntryStart + (unsigned long)pBlkCache->iLineSize);
-            if (((ulSector >= ulEntryStart) && (ulSector < ulEntryEnd))
-            ||  ((ulEndSector >= ulEntryStart) && (ulEndSector < ulEntryEnd)))
+            /* Invalidate if any sector of the line was written */
+            if ((pEntry->iValid)
+            &&  (pEntry->ulSector < ulEndSector)
+            &&  ((pEntry->ulSector + ulLineSize) > ulSector))
             {
-                /* Invalidate */
-                pEntry->Status.ulStatus = 0;
+                pEntry->iValid = FALSE;
+                pBlkCache->Stats.ulInvalidations++;
             }
+            pEntry++;
         }
-        pEntry++;
+        return 0;
+    }
+
+    /* Look each line written up in its set */
+    while (ulCacheSector < ulEndSector)
+    {
+        pEntry = bcGetSet(pBlkCache, ulCacheSector);
+        pEnd = pEntry + pBlkCache->iWays;
+        while (pEntry < pEnd)
+        {
+            if ((pEntry->iValid) && (pEntry->ulSector == ulCacheSector))
+            {
+                pEntry->iValid = FALSE;
+                pBlkCache->Stats.ulInvalidations++;
+            }
+            pEntry++;
+        }
+        ulCacheSector += ulLineSize;
     }
     return 0;
 }
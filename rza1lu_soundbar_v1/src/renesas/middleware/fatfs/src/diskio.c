@@ -238,11 +238,20 @@ DRESULT disk_ioctl (
     void *buff        /* Buffer to send/receive control data */
 )
 {
-    (void) cmd;
-    (void) pdrv;
     (void) buff;
 
-    return 0;
+    if (CTRL_SYNC == cmd)
+    {
+        PDRIVE p_drive =  get_drive(pdrv);
+
+        /* Write out what the block cache is holding back */
+        if ((p_drive) && (p_drive->pBlockCache) && (bcFlush(p_drive->pBlockCache)))
+        {
+            return RES_ERROR;
+        }
+    }
+
+    return RES_OK;
 }
 
 DWORD get_fattime (void)
@@ -131,6 +131,9 @@ void map_drive_id (char *p_path);
 void remove_path_drive (char *path);
 static void replace_character (char *string, char find, char replace);
 
+/* Advanced on anything that could change a directory listing */
+static volatile unsigned long gs_change_count = 0;
+
 /**********************************************************************************
  Function Name: map_drive_id
  Description:   Function to map drive A to 0, etc
@@ -255,7 +258,7 @@ PDRIVE R_FAT_CreateDrive (int iMsDev, int iLun, unsigned long dwBlockSize, unsig
 
     if (p_drive)
     {
-        p_drive->pBlockCache = bcCreate(iMsDev, iLun, 8, 64, (int) dwBlockSize, dwNumBlocks);
+        p_drive->pBlockCache = bcCreate(iMsDev, iLun, BC_DEFAULT_LINE_SIZE, BC_DEFAULT_NUM_ENTRIES, (int) dwBlockSize, dwNumBlocks);
         if ( !p_drive->pBlockCache)
         {
             R_OS_FreeMem(p_drive);
@@ -266,6 +269,7 @@ PDRIVE R_FAT_CreateDrive (int iMsDev, int iLun, unsigned long dwBlockSize, unsig
     p_drive->dwNumBlocks = dwNumBlocks;
     p_drive->iMsDev = iMsDev;
     p_drive->iLun = iLun;
+    gs_change_count++;
 
     return p_drive;
 }
@@ -277,6 +281,7 @@ FRESULT R_FAT_DestroyDrive (PDRIVE pDrive)
 {
     bcDestroy(pDrive->pBlockCache);
     R_OS_FreeMem(pDrive);
+    gs_change_count++;
 
     return 0;
 }
@@ -307,6 +312,7 @@ FRESULT R_FAT_MountPartition (PDRIVE p_drive)
         /* Setting third argument to one forces the FATFS to mount */
         sprintf(buffer, "%d:", p_drive->proposed_drive_index);
         result = f_mount(p_drive->p_fat_fs, buffer, 1);
+        gs_change_count++;
 
         if (FR_OK == result)
         {
@@ -406,8 +412,13 @@ FIL *R_FAT_OpenFile (char *p_path, int iMode)
             result = f_open(fp, (char *)p_path_local, (BYTE) iMode);
             if (result)
             {
+                R_OS_FreeMem(fp);
                 fp = NULL;
             }
+            else if (iMode & (FA_WRITE | FA_CREATE_NEW | FA_CREATE_ALWAYS | FA_OPEN_ALWAYS))
+            {
+                gs_change_count++;
+            }
         }
 
         /* allocation for path not now needed */
@@ -428,7 +439,15 @@ FIL *R_FAT_OpenFile (char *p_path, int iMode)
  **********************************************************************************/
 FRESULT R_FAT_CloseFile (FIL *p_file)
 {
-    FRESULT result = f_close(p_file);
+    FRESULT result;
+
+    /* The size and date in the directory entry are written on close */
+    if (p_file->flag & FA_WRITE)
+    {
+        gs_change_count++;
+    }
+
+    result = f_close(p_file);
 
     R_OS_FreeMem(p_file);
 
@@ -486,6 +505,7 @@ int R_FAT_WriteFile (FIL *p_file, unsigned char *p_buff, unsigned int no_of_byte
     int return_value;
 
     return_value = f_write(p_file, p_buff, no_of_bytes, &bytes_written);
+    gs_change_count++;
 
     if (no_of_bytes != bytes_written)
     {
@@ -569,6 +589,7 @@ FRESULT R_FAT_RemoveFile (char *p_pszPath)
     map_drive_id(p_pszPath);
 
     result = f_unlink(p_pszPath);
+    gs_change_count++;
 
     result =  R_FAT_ConvertErrorCode(result);
 
@@ -694,6 +715,7 @@ FRESULT R_FAT_MakeDirectory (char *p_path)
     map_drive_id(p_path);
 
     err = f_mkdir(p_path);
+    gs_change_count++;
 
     return R_FAT_ConvertErrorCode(err);
 }
@@ -711,6 +733,7 @@ FRESULT R_FAT_MakeDirectory (char *p_path)
 FRESULT R_FAT_RemoveDirectory (char *p_path)
 {
     map_drive_id(p_path);
+    gs_change_count++;
 
     return R_FAT_ConvertErrorCode((FATERR) f_unlink(p_path));
 }
@@ -729,6 +752,8 @@ FRESULT R_FAT_ReName (const char *p_old_name, const char *p_new_name)
 {
     FATERR err = f_rename(p_old_name, p_new_name);
 
+    gs_change_count++;
+
     /* */
     return R_FAT_ConvertErrorCode((FS_T_INT32) err);
 }
@@ -769,6 +794,20 @@ int R_FAT_DriveIsAvailable (PDRIVE pDrive)
  End of function  fatDriveIsAvailable
  ******************************************************************************/
 
+/**********************************************************************************
+ Function Name: R_FAT_GetChangeCount
+ Description:   Function to get the count of changes made through this layer
+ Parameters:    none
+ Return value:  The change count
+ **********************************************************************************/
+unsigned long R_FAT_GetChangeCount (void)
+{
+    return gs_change_count;
+}
+/**********************************************************************************
+ End of function  R_FAT_GetChangeCount
+ ***********************************************************************************/
+
 /**********************************************************************************
  Function Name: R_FAT_GetErrorString
  Description:   Function to convert the error code in to a string
@@ -59,6 +59,57 @@
 Includes   <System Includes> , "Project Includes"
 ******************************************************************************/
 #include "r_devlink_wrapper.h"
+#include "r_ether.h"
+
+/******************************************************************************
+Typedef definitions
+******************************************************************************/
+/** Frame lent by CTL_ETHER_READ_BATCH. The ET_RX_FRAME_HEADROOM bytes in front
+    of pbyFrame belong to the caller until the frame is given back with
+    CTL_ETHER_RELEASE_FRAME, passing pbyFrame as the control structure */
+typedef struct _ETFRAME
+{
+    uint8_t     *pbyFrame;
+    uint32_t    uiLength;
+} ETFRAME,
+*PETFRAME;
+
+/** Frames taken by CTL_ETHER_READ_BATCH. The call blocks until the receive
+    interrupt reports a frame, then takes every completed descriptor up to
+    ET_RX_BATCH_MAX. When every spare buffer is lent bfCopyPending is set and
+    read() copies the frame left on the descriptor */
+typedef struct _ETRXBATCH
+{
+    uint32_t    uiCount;            /* Frames in pFrames */
+    _Bool       bfCopyPending;      /* A frame waits for read() */
+    uint32_t    uiRingOccupancy;    /* Full descriptors when the task woke */
+    uint32_t    uiErrors;           /* Frames discarded with receive errors */
+    uint32_t    uiMissed;           /* Frames dropped by the controller */
+    ETFRAME     pFrames[NUM_OF_RX_DESCRIPTOR];
+} ETRXBATCH,
+*PETRXBATCH;
+
+/** Frame sent in place by CTL_ETHER_WRITE_GATHER. The buffers must not change
+    until CTL_ETHER_RECLAIM_TX returns pvOwner */
+typedef struct _ETGATHER
+{
+    const ether_segment_t   *pSegments;
+    uint32_t                uiCount;
+    void                    *pvOwner;
+} ETGATHER,
+*PETGATHER;
+
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+/** Caller owned bytes in front of every frame from CTL_ETHER_READ_BATCH */
+#define ET_RX_FRAME_HEADROOM        (RX_BUFFER_HEADROOM)
+
+/** Most frames one CTL_ETHER_READ_BATCH returns, the receive ring depth */
+#define ET_RX_BATCH_MAX             (NUM_OF_RX_DESCRIPTOR)
+
+/** Most buffers one CTL_ETHER_WRITE_GATHER frame may have */
+#define ET_TX_MAX_SEGMENTS          (R_ETHER_MAX_SEGMENTS)
 
 /*****************************************************************************
 Public Functions
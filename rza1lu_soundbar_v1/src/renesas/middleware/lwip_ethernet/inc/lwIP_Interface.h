@@ -73,6 +73,33 @@ Includes   <System Includes> , "Project Includes"
 #define ETHERNET_SIMULTANEOUS_READS         _NET_MAX_RX_
 #define ETHERNET_SIMULTANEOUS_WRITES        _NET_MAX_TX_
 
+/* Number of batch sizes counted separately by IPRXSTATS, larger batches
+   are counted in the last entry */
+#define IP_RX_BATCH_SIZES                   10U
+
+/******************************************************************************
+Typedef definitions
+******************************************************************************/
+
+/** Receive statistics of an interface, used to size the receive descriptor
+    ring and ETHERNET_INPUT_BUFFER_SIZE */
+typedef struct _IPRXSTATS
+{
+    uint32_t    uiWakeups;                  /*!< Receive interrupts serviced */
+    uint32_t    uiBatches;                  /*!< Batches passed to lwIP */
+    uint32_t    uiFrames;                   /*!< Frames passed to lwIP */
+    uint32_t    uiCopied;                   /*!< Frames copied because the driver had no spare buffer */
+    uint32_t    pBatchSize[IP_RX_BATCH_SIZES]; /*!< Number of batches of each size */
+    uint32_t    uiMaxBatch;                 /*!< Largest batch */
+    uint32_t    uiRingOccupancySum;         /*!< Full descriptors at each wake up, divide by uiWakeups */
+    uint32_t    uiMaxRingOccupancy;         /*!< Most full descriptors at a wake up */
+    uint32_t    uiBackPressure;             /*!< Times the task waited for lwIP to take a batch */
+    uint32_t    uiErrors;                   /*!< Frames received with errors */
+    uint32_t    uiMissed;                   /*!< Frames dropped by the controller with the ring full */
+    uint32_t    uiDropped;                  /*!< Frames dropped for want of memory or a full lwIP mailbox */
+} IPRXSTATS,
+*PIPRXSTATS;
+
 
 /******************************************************************************
 Functions Prototypes
@@ -183,6 +210,27 @@ extern int32_t ipSetPromiscuousMode(char_t *pszInterface, _Bool bfPromiscuous);
 */
 extern  _Bool ipGetPromiscuousMode(char_t *pszInterface);
 
+/**
+ * @brief         Function to get the receive statistics of an interface
+ *
+ * @param[in]     pszInterface: Pointer to the interface, NULL for the first
+ * @param[out]    pStats:       Pointer to the destination statistics
+ *
+ * @retval        0: For success
+ * @retval       -1: On error
+*/
+extern  int32_t ipGetRxStats(char_t *pszInterface, PIPRXSTATS pStats);
+
+/**
+ * @brief         Function to clear the receive statistics of an interface
+ *
+ * @param[in]     pszInterface: Pointer to the interface, NULL for the first
+ *
+ * @retval        0: For success
+ * @retval       -1: On error
+*/
+extern  int32_t ipResetRxStats(char_t *pszInterface);
+
 #ifdef __cplusplus
 }
 #endif
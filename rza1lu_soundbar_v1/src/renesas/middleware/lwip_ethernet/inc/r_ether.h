@@ -70,11 +70,15 @@ Macro definitions
 #define ADDR_OF_TXRX_DESC       0x60500000
 #define ADDR_OF_TXRX_BUFF       0x60501000
 
-#define NUM_OF_TX_DESCRIPTOR    (8)
+#define NUM_OF_TX_DESCRIPTOR    (16)
 #define NUM_OF_RX_DESCRIPTOR    (8)
 #define NUM_OF_TX_BUFFER        NUM_OF_TX_DESCRIPTOR
-#define NUM_OF_RX_BUFFER        NUM_OF_RX_DESCRIPTOR
+#define NUM_OF_RX_BUFFER        (NUM_OF_RX_DESCRIPTOR * 2)  /* The spare half re-arms descriptors whose frame
+                                                               has been lent with R_Ether_ReadFrame */
 #define SIZE_OF_BUFFER          (1600)    /* Must be an integral multiple of 32 */
+#define RX_BUFFER_HEADROOM      (32)      /* Bytes in front of each received frame owned by the caller of
+                                             R_Ether_ReadFrame. Must be an integral multiple of 32 */
+#define R_ETHER_MAX_SEGMENTS    (6)       /* Most buffers R_Ether_WriteGather maps onto one frame */
 
 #define R_ETHER_OK              (0)
 #define R_ETHER_ERROR           (-1)
@@ -82,6 +86,7 @@ Macro definitions
 #define R_ETHER_HARD_ERROR      (-3)
 #define R_ETHER_RECOVERAVLE     (-4)
 #define R_ETHER_NODATA          (-5)
+#define R_ETHER_NOBUFFER        (-6)
 #define MIN_FRAME_SIZE          (60)
 #define MAX_FRAME_SIZE          (1514)
 
@@ -212,10 +217,17 @@ typedef txrx_descriptor_set_t * txrx_descriptor_set_t_ptr;
 typedef struct
 {
     uint8_t bsend[NUM_OF_TX_BUFFER][SIZE_OF_BUFFER];
-    uint8_t brecv[NUM_OF_RX_BUFFER][SIZE_OF_BUFFER];
+    uint8_t brecv[NUM_OF_RX_BUFFER][RX_BUFFER_HEADROOM + SIZE_OF_BUFFER];
 } txrx_buffer_set_t; 
 typedef txrx_buffer_set_t * txrx_buffer_set_t_ptr;
 
+/** @brief One buffer of a frame passed to R_Ether_WriteGather */
+typedef struct
+{
+    const uint8_t * pbyData;        /*!< Start of the data, any byte alignment */
+    uint32_t        uiLength;       /*!< Bytes in this buffer */
+} ether_segment_t;
+
 /******************************************************************************
 Exported global functions (to be accessed by other files)
 ******************************************************************************/
@@ -273,6 +285,82 @@ int32_t R_Ether_Read(uint32_t ch, void *buf);
 */ 
 int32_t R_Ether_Write(uint32_t ch, void *buf, uint32_t len);
 
+/**
+ * Description   Takes the received Ethernet frame without copying it. The
+ *               descriptor is re-armed with a spare buffer so reception
+ *               continues while the caller holds the frame. The
+ *               RX_BUFFER_HEADROOM bytes in front of the frame belong to the
+ *               caller until the frame is released.
+ *
+ * @param[in]    ch:         Ethernet channel number
+ * @param[out]   ppbyFrame:  Set to the start of the received frame
+ *
+ * @retval       Greater than 0   : Success. Returns number of bytes received
+ * @retval       R_ETHER_ERROR(-1): Error, nothing to release
+ * @retval       R_ETHER_NODATA(-5): No data received
+ * @retval       R_ETHER_NOBUFFER(-6): A frame is waiting but every spare
+ *                                     buffer is lent, release one and retry
+*/
+int32_t R_Ether_ReadFrame(uint32_t ch, uint8_t **ppbyFrame);
+
+/**
+ * @brief        Returns a frame from R_Ether_ReadFrame to the spare buffers.
+ *               Every frame must be released before R_Ether_Close.
+ *
+ * @param[in]    ch:        Ethernet channel number
+ * @param[in]    pbyFrame:  The frame pointer from R_Ether_ReadFrame
+ *
+ * @return       None.
+*/
+void R_Ether_ReleaseFrame(uint32_t ch, uint8_t *pbyFrame);
+
+/**
+ * Description   Sends an Ethernet frame held in several buffers without
+ *               copying it, one transmit descriptor per buffer. The buffers
+ *               are read by the E-DMAC after this function returns, so they
+ *               must stay valid until R_Ether_ReclaimTx hands back pvOwner.
+ *
+ * @param[in]    ch:          Ethernet channel number
+ * @param[in]    pSegments:   The buffers in frame order
+ * @param[in]    uiCount:     Number of buffers, 1 to R_ETHER_MAX_SEGMENTS
+ * @param[in]    pvOwner:     Returned by R_Ether_ReclaimTx once the frame is
+ *                            sent, must not be NULL
+ *
+ * @retval       R_ETHER_OK(0):     Success
+ * @retval       R_ETHER_ERROR(-1): Link down, not enough free descriptors or
+ *                                  the frame is shorter than MIN_FRAME_SIZE
+*/
+int32_t R_Ether_WriteGather(uint32_t ch, const ether_segment_t *pSegments, uint32_t uiCount, void *pvOwner);
+
+/**
+ * @brief        Finds a frame sent by R_Ether_WriteGather whose buffers are
+ *               no longer needed by the E-DMAC. Call until it returns NULL.
+ *
+ * @param[in]    ch: Ethernet channel number
+ *
+ * @retval       pvOwner of a sent frame, NULL if there are none
+*/
+void *R_Ether_ReclaimTx(uint32_t ch);
+
+/**
+ * @brief        Counts the received frames waiting in the descriptor ring.
+ *
+ * @param[in]    ch: Ethernet channel number
+ *
+ * @retval       Number of frames waiting, 0 to NUM_OF_RX_DESCRIPTOR
+*/
+uint32_t R_Ether_RxPending(uint32_t ch);
+
+/**
+ * @brief        Reads and clears the count of frames dropped by the
+ *               controller because every receive descriptor was full.
+ *
+ * @param[in]    ch: Ethernet channel number
+ *
+ * @retval       Frames missed since the last call
+*/
+uint32_t R_Ether_MissedFrames(uint32_t ch);
+
 void INT_Ether(uint32_t status);
 
 /**               
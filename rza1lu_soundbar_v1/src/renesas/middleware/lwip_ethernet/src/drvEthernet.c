@@ -450,6 +450,98 @@ static int etControl(st_stream_ptr_t pStream, uint32_t ctlCode, void *pCtlStruct
             break;
         }
 
+        case CTL_ETHER_READ_BATCH:
+        {
+            if (pCtlStruct)
+            {
+                PETRXBATCH pBatch = (PETRXBATCH) pCtlStruct;
+                uint32_t uiDescriptor;
+                int32_t iResult;
+
+                pBatch->uiCount = 0;
+                pBatch->bfCopyPending = false;
+                pBatch->uiErrors = 0;
+
+                /* Sleep until the receive interrupt, as etRead does */
+                while (0 == R_Ether_RxPending(ET_CHANNEL))
+                {
+                    eventWait(&pEtDrv->ppEventList[ET_RX_ISR], 1, true);
+                }
+
+                pBatch->uiRingOccupancy = R_Ether_RxPending(ET_CHANNEL);
+                pBatch->uiMissed = R_Ether_MissedFrames(ET_CHANNEL);
+
+                /* Take every completed descriptor in one pass */
+                for (uiDescriptor = 0; uiDescriptor < ET_RX_BATCH_MAX; uiDescriptor++)
+                {
+                    PETFRAME pFrame = &pBatch->pFrames[pBatch->uiCount];
+
+                    iResult = R_Ether_ReadFrame(ET_CHANNEL, &pFrame->pbyFrame);
+
+                    if (iResult > 0)
+                    {
+                        pFrame->uiLength = (uint32_t) iResult;
+                        pBatch->uiCount++;
+                    }
+                    else if (R_ETHER_ERROR == iResult)
+                    {
+                        /* The descriptor has been re-armed, carry on */
+                        pBatch->uiErrors++;
+                    }
+                    else
+                    {
+                        /* No more frames, or every spare buffer is held by
+                           the stack and the caller copies the next with read */
+                        pBatch->bfCopyPending = (R_ETHER_NOBUFFER == iResult);
+                        break;
+                    }
+                }
+
+                return 0;
+            }
+            break;
+        }
+
+        case CTL_ETHER_RELEASE_FRAME:
+        {
+            if (pCtlStruct)
+            {
+                R_Ether_ReleaseFrame(ET_CHANNEL, (uint8_t *) pCtlStruct);
+                return 0;
+            }
+            break;
+        }
+
+        case CTL_ETHER_WRITE_GATHER:
+        {
+            if (pCtlStruct)
+            {
+                PETGATHER pGather = (PETGATHER) pCtlStruct;
+
+                if (R_ETHER_OK == R_Ether_WriteGather(ET_CHANNEL, pGather->pSegments,
+                                                      pGather->uiCount, pGather->pvOwner))
+                {
+                    return 0;
+                }
+            }
+            break;
+        }
+
+        case CTL_ETHER_RECLAIM_TX:
+        {
+            if (pCtlStruct)
+            {
+                /* The control structure is the address of the owner pointer */
+                *((void **) pCtlStruct) = R_Ether_ReclaimTx(ET_CHANNEL);
+
+                if (NULL != *((void **) pCtlStruct))
+                {
+                    return 0;
+                }
+            }
+            break;
+        }
+
         default:
         {
             TRACE(("etControl: Unknown control code\r\n"));
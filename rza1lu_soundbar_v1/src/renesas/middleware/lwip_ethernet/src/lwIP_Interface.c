@@ -55,6 +55,7 @@ Includes   <System Includes> , "Project Includes"
 #include "trace.h"
 #include "lwip/sockets.h"
 #include "lwip/ip_addr.h"
+#include "drvEthernet.h"
 
 /******************************************************************************
 Macro definitions
@@ -66,6 +67,16 @@ Macro definitions
 #define ETHERNET_MAX_ADAPTER_NAME_LENGTH    16U
 #define ETHERNET_NETIF_MTU                  1500U
 
+/* Attempts to find free transmit descriptors before a frame is dropped */
+#define ETHERNET_OUTPUT_RETRIES             4U
+
+/* Batches of received frames queued to the lwIP task at once. When they are
+   all queued the input task stops reading and the descriptor ring fills */
+#define ETHERNET_INPUT_BATCHES              4U
+
+/* Attempts to allocate a pbuf for a copied frame before it is dropped */
+#define ETHERNET_INPUT_ALLOC_RETRIES        4U
+
 /* Comment this line out to turn ON module trace in this file */
 #undef _TRACE_ON_
 
@@ -82,6 +93,16 @@ typedef struct ip_addr *PIPADDR;
 
 typedef struct _RTEIP *PRTEIP;
 
+/* Frames taken from one receive interrupt and given to lwIP with a single
+   call-back. One more than the driver batch for the frame copied with read */
+typedef struct _IPRXBATCH
+{
+    PRTEIP          pEtherC;
+    uint32_t        uiCount;
+    struct pbuf     *ppPackets[ET_RX_BATCH_MAX + 1U];
+} IPRXBATCH,
+*PIPRXBATCH;
+
 /* A structure to keep a list of events which are set when the link status
    changes */
 typedef struct _LNKMON
@@ -129,9 +150,35 @@ typedef struct _RTEIP
 
     /* The mutex event used to protect the output buffer */
     PEVENT          pevOutputBufferMutex;
+
+    /* The batches passed to lwIP, used in turn */
+    IPRXBATCH       pRxBatch[ETHERNET_INPUT_BATCHES];
+    uint32_t        uiRxBatchNext;
+
+    /* Counts the batches not held by lwIP */
+    uint32_t        uiRxBatchFree;
+
+    /* Buffer a frame is read into when there is no memory to keep it */
+    uint8_t         pbyInputDiscard[ETHERNET_INPUT_BUFFER_SIZE];
+
+    /* The receive statistics */
+    IPRXSTATS       rxStats;
 } RTEIP;
 #pragma pack()
 
+/* A received frame wrapped as a pbuf. This lives in the driver's headroom in
+   front of the frame so no memory is allocated per frame */
+typedef struct _RXPBUF
+{
+    struct pbuf_custom  ipCustom;
+    PRTEIP              pEtherC;
+    uint8_t             *pbyFrame;
+} RXPBUF,
+*PRXPBUF;
+
+/* The wrapper and the Ethernet padding must both fit in the headroom */
+typedef char RXPBUF_FITS_HEADROOM[((sizeof(RXPBUF) + ETH_PAD_SIZE) <= ET_RX_FRAME_HEADROOM) ? 1 : -1];
+
 /******************************************************************************
 Function Prototypes
 ******************************************************************************/
@@ -139,10 +186,14 @@ Function Prototypes
 static void ipIfStatusDisplay(PRTEIP pEtherC, FILE *pOut);
 static err_t ipInitialise(struct netif *pIpNetIf);
 static void ipInputTask(PRTEIP pEtherC);
+static struct pbuf *ipInputCopy(PRTEIP pEtherC);
+static void ipInputStats(PRTEIP pEtherC, PETRXBATCH pRxBatch, uint32_t uiCount, _Bool bfCopied);
 static void ipLinkMonitor(PRTEIP pEtherC);
 static void ipLinkStatus(struct netif *pIpNetIf);
 static void ipSetTcpIpTaskID(PRTEIP pEtherC);
 static err_t ipOutput(struct netif *pIpNetIf, struct pbuf *pPacket);
+static _Bool ipOutputGather(PRTEIP pEtherC, struct pbuf *pPacket);
+static void ipRxPacketFree(struct pbuf *pPacket);
 static void ipAddNetIf(PRTEIP *ppEtherC, PRTEIP pEtherC);
 static PRTEIP ipRemoveNetIf(PRTEIP *ppEtherC, PRTEIP pEtherC);
 static PRTEIP ipFindNetIf(PRTEIP *ppEtherC, char_t *pszInterface);
@@ -303,6 +354,7 @@ void ipStop(void)
         R_OS_DeleteTask(pEtherC->uilwIPTaskID);
         R_OS_DeleteTask(pEtherC->uiInputTaskID);
         R_OS_DeleteTask(pEtherC->uiLinkMonitorTaskID);
+        R_OS_DeleteSemaphore(&pEtherC->uiRxBatchFree);
 
         /* Close the interface */
         close(pEtherC->iEtherC);
@@ -569,6 +621,55 @@ _Bool ipGetPromiscuousMode(char_t *pszInterface)
 End of function  ipGetPromiscuousMode
 ******************************************************************************/
 
+/******************************************************************************
+* Function Name: ipGetRxStats
+* Description  : Function to get the receive statistics of an interface
+* Arguments    : IN  pszInterface - Pointer to the interface, NULL for the first
+*                OUT pStats - Pointer to the destination statistics
+* Return Value : 0 for success or -1 on error
+******************************************************************************/
+int32_t ipGetRxStats(char_t *pszInterface, PIPRXSTATS pStats)
+{
+    PRTEIP pEtherC = ipFindNetIf(&gpEtherC, pszInterface);
+
+    if (pEtherC)
+    {
+        R_OS_EnterCritical();
+        *pStats = pEtherC->rxStats;
+        R_OS_ExitCritical();
+        return 0;
+    }
+
+    return -1;
+}
+/******************************************************************************
+End of function  ipGetRxStats
+******************************************************************************/
+
+/******************************************************************************
+* Function Name: ipResetRxStats
+* Description  : Function to clear the receive statistics of an interface
+* Arguments    : IN  pszInterface - Pointer to the interface, NULL for the first
+* Return Value : 0 for success or -1 on error
+******************************************************************************/
+int32_t ipResetRxStats(char_t *pszInterface)
+{
+    PRTEIP pEtherC = ipFindNetIf(&gpEtherC, pszInterface);
+
+    if (pEtherC)
+    {
+        R_OS_EnterCritical();
+        memset(&pEtherC->rxStats, 0, sizeof(IPRXSTATS));
+        R_OS_ExitCritical();
+        return 0;
+    }
+
+    return -1;
+}
+/******************************************************************************
+End of function  ipResetRxStats
+******************************************************************************/
+
 /******************************************************************************
 Private Functions
 ******************************************************************************/
@@ -736,6 +837,8 @@ static err_t ipInitialise(struct netif *pIpNetIf)
 
         pEtherC->uiLinkMonitorTaskID  = R_OS_CreateTask("EtherC Link Mon", (os_task_code_t) ipLinkMonitor, pEtherC,
                 R_OS_ABSTRACTION_PRV_DEFAULT_STACK_SIZE, TASK_ETHERC_LINK_MON_PRI);
+        /* Every batch starts free */
+        R_OS_CreateSemaphore(&pEtherC->uiRxBatchFree, ETHERNET_INPUT_BATCHES);
         pEtherC->uiInputTaskID  = R_OS_CreateTask("EtherC Input", (os_task_code_t) ipInputTask, pEtherC,
                 R_OS_ABSTRACTION_PRV_DEFAULT_STACK_SIZE, TASK_ETHERC_INPUT_PRI);
 
@@ -1064,16 +1167,18 @@ End of function  ipLinkChangeNotification
 *****************************************************************************/
 
 /******************************************************************************
-* Function Name: ipRead
-* Description  : Function to allocate a packet buffer
+* Function Name: ipAllocPacketBuffer
+* Description  : Function to allocate a packet buffer. Each failure sleeps to
+*                let lwIP free memory rather than spinning on the CPU
 * Arguments    : IN  stLength - The length of the buffer to allocate
-* Return Value : Pointer to the allocated buffer
+* Return Value : Pointer to the allocated buffer or NULL if there is no memory
 ******************************************************************************/
 static struct pbuf * ipAllocPacketBuffer(size_t stLength)
 {
     struct pbuf *pPacket = NULL;
+    uint32_t    uiRetry;
 
-    while (!pPacket)
+    for (uiRetry = 0; uiRetry < ETHERNET_INPUT_ALLOC_RETRIES; uiRetry++)
     {
         /* Allocate the pbuf to receive the data */
         pPacket = pbuf_alloc(PBUF_RAW, (u16_t) stLength, PBUF_RAM);
@@ -1082,11 +1187,9 @@ static struct pbuf * ipAllocPacketBuffer(size_t stLength)
         {
             break;
         }
-        else
-        {
-            /* Failed to allocate a packet - try again */
-            R_OS_Yield();
-        }
+
+        /* Failed to allocate a packet - wait for lwIP to free some */
+        R_OS_TaskSleep(1UL);
     }
 
     return pPacket;
@@ -1097,24 +1200,151 @@ End of function  ipAllocPacketBuffer
 
 /******************************************************************************
 * Function Name: ipInputCallBack
-* Description  : Function to put the received packet into lwIP via the call-back
-*                mechanism. This is so the input timing is defined.
-* Arguments    : IN  pPacket - Pointer to the input packet
+* Description  : Function to put a batch of received packets into lwIP via the
+*                call-back mechanism. This is so the input timing is defined.
+* Arguments    : IN  pInput - Pointer to the batch
 * Return Value : none
 ******************************************************************************/
-static void ipInputCallBack(struct pbuf *pPacket)
+static void ipInputCallBack(PIPRXBATCH pInput)
 {
-    PRTEIP pEtherC = (PRTEIP) pPacket->next;
-    pPacket->next = NULL;
-    pEtherC->ipNetIf.input(pPacket, &pEtherC->ipNetIf);
+    PRTEIP      pEtherC = pInput->pEtherC;
+    uint32_t    uiPacket;
+
+    for (uiPacket = 0; uiPacket < pInput->uiCount; uiPacket++)
+    {
+        struct pbuf *pPacket = pInput->ppPackets[uiPacket];
+
+        if (pEtherC->ipNetIf.input(pPacket, &pEtherC->ipNetIf) != ERR_OK)
+        {
+            pbuf_free(pPacket);
+        }
+    }
+
+    /* Let the input task use the batch again */
+    pInput->uiCount = 0;
+    R_OS_ReleaseSemaphore(&pEtherC->uiRxBatchFree);
 }
 /******************************************************************************
 End of function  ipInputCallBack
 ******************************************************************************/
 
+/******************************************************************************
+* Function Name: ipRxPacketFree
+* Description  : Called by lwIP when a received frame is freed, gives the
+*                buffer back to the driver
+* Arguments    : IN  pPacket - Pointer to the RXPBUF of the frame
+* Return Value : none
+******************************************************************************/
+static void ipRxPacketFree(struct pbuf *pPacket)
+{
+    PRXPBUF pRx = (PRXPBUF) pPacket;
+
+    control(pRx->pEtherC->iEtherC, CTL_ETHER_RELEASE_FRAME, pRx->pbyFrame);
+}
+/******************************************************************************
+End of function  ipRxPacketFree
+******************************************************************************/
+
+/******************************************************************************
+* Function Name: ipInputCopy
+* Description  : Copies the waiting frame into a new pbuf, used when all the
+*                driver's spare buffers are held by lwIP. Without the memory
+*                for a pbuf the frame is read and dropped.
+* Arguments    : IN  pEtherC - Pointer to the ethernet controller data
+* Return Value : Pointer to the packet or NULL if it was dropped
+******************************************************************************/
+static struct pbuf *ipInputCopy(PRTEIP pEtherC)
+{
+    struct pbuf *pPacket = ipAllocPacketBuffer(ETHERNET_INPUT_BUFFER_SIZE);
+    int32_t     iResult;
+
+    if (NULL == pPacket)
+    {
+        /* Take the frame off the descriptor so reception carries on */
+        read(pEtherC->iEtherC, pEtherC->pbyInputDiscard, ETHERNET_INPUT_BUFFER_SIZE);
+        pEtherC->rxStats.uiDropped++;
+        return NULL;
+    }
+
+    /* Copy the frame from the Ethernet controller. Padding is required from
+       the start */
+    iResult = read(pEtherC->iEtherC, (uint8_t *) pPacket->payload + ETH_PAD_SIZE, ETHERNET_INPUT_BUFFER_SIZE);
+
+    /* Check the result */
+    if (iResult <= 0)
+    {
+        pEtherC->rxStats.uiErrors++;
+        pbuf_free(pPacket);
+        return NULL;
+    }
+
+    /* Put in the actual length of data delivered */
+    pPacket->tot_len = (u16_t)(iResult + ETH_PAD_SIZE);
+
+    /* Making segment length the same as the packet length tells lwIP
+       that this is the end of the packet chain. This is slightly
+       pointless since lwIP does not support packet queues */
+    pPacket->len = (u16_t)(iResult + ETH_PAD_SIZE);
+
+    return pPacket;
+}
+/******************************************************************************
+End of function  ipInputCopy
+******************************************************************************/
+
+/******************************************************************************
+* Function Name: ipInputStats
+* Description  : Function to add a receive interrupt to the statistics
+* Arguments    : IN  pEtherC - Pointer to the ethernet controller data
+*                IN  pRxBatch - Pointer to the batch from the driver
+*                IN  uiCount - The number of frames passed to lwIP
+*                IN  bfCopied - true if a frame was copied
+* Return Value : none
+******************************************************************************/
+static void ipInputStats(PRTEIP pEtherC, PETRXBATCH pRxBatch, uint32_t uiCount, _Bool bfCopied)
+{
+    PIPRXSTATS pStats = &pEtherC->rxStats;
+
+    pStats->uiWakeups++;
+    pStats->uiErrors += pRxBatch->uiErrors;
+    pStats->uiMissed += pRxBatch->uiMissed;
+    pStats->uiRingOccupancySum += pRxBatch->uiRingOccupancy;
+
+    if (pRxBatch->uiRingOccupancy > pStats->uiMaxRingOccupancy)
+    {
+        pStats->uiMaxRingOccupancy = pRxBatch->uiRingOccupancy;
+    }
+
+    if (bfCopied)
+    {
+        pStats->uiCopied++;
+    }
+
+    if (uiCount)
+    {
+        pStats->uiBatches++;
+        pStats->uiFrames += uiCount;
+        pStats->pBatchSize[(uiCount < IP_RX_BATCH_SIZES) ? uiCount : (IP_RX_BATCH_SIZES - 1U)]++;
+
+        if (uiCount > pStats->uiMaxBatch)
+        {
+            pStats->uiMaxBatch = uiCount;
+        }
+    }
+}
+/******************************************************************************
+End of function  ipInputStats
+******************************************************************************/
+
 /******************************************************************************
 * Function Name: ipInputTask
 * Description  : Task to read data from the ethernet driver and pass it to lwIP
+*                Each receive interrupt wakes the task, which takes every frame
+*                in the descriptor ring. The driver lends its receive buffers,
+*                which are passed to lwIP as custom pbufs in one call-back.
+*                Only when all the driver's spare buffers are held by lwIP is
+*                a frame copied into a new pbuf. When lwIP holds every batch
+*                the task waits, the ring fills and the controller drops.
 * Arguments    : IN  pEtherC - Pointer to the ethernet controller data
 * Return Value : none
 ******************************************************************************/
@@ -1125,41 +1355,99 @@ static void ipInputTask(PRTEIP pEtherC)
     /* Enter the main function of the input task */
     while (true)
     {
-        /* Allocate a buffer to hold the received data */
-        struct pbuf *pPacket = ipAllocPacketBuffer(ETHERNET_INPUT_BUFFER_SIZE);
+        PIPRXBATCH  pInput;
+        ETRXBATCH   rxBatch;
+        uint32_t    uiFrame;
+        _Bool       bfCopied = false;
+
+        /* Wait for lwIP to finish with a batch */
+        if (!R_OS_WaitForSemaphore(&pEtherC->uiRxBatchFree, 0UL))
+        {
+            pEtherC->rxStats.uiBackPressure++;
+            R_OS_WaitForSemaphore(&pEtherC->uiRxBatchFree, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
+        }
+
+        /* lwIP handles the call-backs in order so the batches are freed in
+           the order they are queued */
+        pInput = &pEtherC->pRxBatch[pEtherC->uiRxBatchNext];
+        pInput->pEtherC = pEtherC;
+        pInput->uiCount = 0;
 
-        /* Get a pointer to the payload */
-        uint8_t     *pbyBuffer = pPacket->payload;
-        int32_t     iResult;
+        /* Wait for the receive interrupt and take the frames in the ring */
+        if (control(pEtherC->iEtherC, CTL_ETHER_READ_BATCH, &rxBatch) != 0)
+        {
+            R_OS_ReleaseSemaphore(&pEtherC->uiRxBatchFree);
+            R_OS_TaskSleep(1UL);
+            continue;
+        }
+
+        for (uiFrame = 0; uiFrame < rxBatch.uiCount; uiFrame++)
+        {
+            PETFRAME    pFrame = &rxBatch.pFrames[uiFrame];
+            PRXPBUF     pRx = (PRXPBUF) (pFrame->pbyFrame - ET_RX_FRAME_HEADROOM);
+            u16_t       usLength = (u16_t) (pFrame->uiLength + ETH_PAD_SIZE);
+            struct pbuf *pPacket;
 
-        /* Padding is required from the start */
-        pbyBuffer += ETH_PAD_SIZE;
+            pRx->ipCustom.custom_free_function = ipRxPacketFree;
+            pRx->pEtherC = pEtherC;
+            pRx->pbyFrame = pFrame->pbyFrame;
 
-        /* Read from the Ethernet controller */
-        iResult = read(pEtherC->iEtherC, pbyBuffer, ETHERNET_INPUT_BUFFER_SIZE);
+            /* Padding is required from the start, it sits in the headroom */
+            pPacket = pbuf_alloced_custom(PBUF_RAW, usLength, PBUF_REF, &pRx->ipCustom,
+                                          pFrame->pbyFrame - ETH_PAD_SIZE, usLength);
 
-        /* Check the result */
-        if (iResult > 0)
+            if (NULL == pPacket)
+            {
+                control(pEtherC->iEtherC, CTL_ETHER_RELEASE_FRAME, pFrame->pbyFrame);
+                pEtherC->rxStats.uiDropped++;
+                continue;
+            }
+
+            pInput->ppPackets[pInput->uiCount++] = pPacket;
+        }
+
+        /* A frame left on a descriptor is copied once the frames before it
+           are with lwIP. That way the copy does not wait for memory while
+           this task holds frames that lwIP could free */
+        if ((rxBatch.bfCopyPending) && (0 == pInput->uiCount))
         {
-            /* Put in the actual length of data delivered */
-            pPacket->tot_len = (u16_t)(iResult + ETH_PAD_SIZE);
+            struct pbuf *pPacket = ipInputCopy(pEtherC);
+
+            if (pPacket)
+            {
+                pInput->ppPackets[pInput->uiCount++] = pPacket;
+                bfCopied = true;
+            }
+        }
+
+        ipInputStats(pEtherC, &rxBatch, pInput->uiCount, bfCopied);
 
-            /* Making segment length the same as the packet length tells lwIP
-               that this is the end of the packet chain. This is slightly
-               pointless since lwIP does not support packet queues */
-            pPacket->len = (u16_t)(iResult + ETH_PAD_SIZE);
 #ifdef _TRACE_RX_DATA_
-            Trace("RX %d\r\n", iResult);
-            dbgPrintBuffer(pbyBuffer, iResult);
+        for (uiFrame = 0; uiFrame < pInput->uiCount; uiFrame++)
+        {
+            struct pbuf *pPacket = pInput->ppPackets[uiFrame];
+            Trace("RX %d\r\n", pPacket->tot_len - ETH_PAD_SIZE);
+            dbgPrintBuffer((uint8_t *) pPacket->payload + ETH_PAD_SIZE, pPacket->tot_len - ETH_PAD_SIZE);
+        }
 #endif
-            /* Put the packet into lwIP */
-            pPacket->next = (struct pbuf *)pEtherC;
-            tcpip_callback((void(*)(void*))ipInputCallBack, pPacket);
+        /* Put the packets into lwIP */
+        if ((pInput->uiCount)
+        &&  (tcpip_callback((void(*)(void*))ipInputCallBack, pInput) == ERR_OK))
+        {
+            pEtherC->uiRxBatchNext = (pEtherC->uiRxBatchNext + 1U) % ETHERNET_INPUT_BATCHES;
         }
         else
         {
-            /* Error in the read, free the buffer and try again */
-            pbuf_free(pPacket);
+            /* Not queued, free them so lent buffers go back to the driver */
+            pEtherC->rxStats.uiDropped += pInput->uiCount;
+
+            for (uiFrame = 0; uiFrame < pInput->uiCount; uiFrame++)
+            {
+                pbuf_free(pInput->ppPackets[uiFrame]);
+            }
+
+            pInput->uiCount = 0;
+            R_OS_ReleaseSemaphore(&pEtherC->uiRxBatchFree);
         }
     }
 }
@@ -1167,6 +1455,96 @@ static void ipInputTask(PRTEIP pEtherC)
 End of function  ipInputTask
 ******************************************************************************/
 
+/******************************************************************************
+* Function Name: ipOutputGather
+* Description  : Sends the frame by pointing the driver's transmit descriptors
+*                at the pbuf payloads. The pbuf is referenced until the driver
+*                has sent it and freed by a later call to this function.
+* Arguments    : IN  pEtherC - Pointer to the ethernet controller data
+*                IN  pPacket - Pointer to the lwIP pbuf chain
+* Return Value : true if the frame was queued, false if it must be copied
+******************************************************************************/
+static _Bool ipOutputGather(PRTEIP pEtherC, struct pbuf *pPacket)
+{
+    ether_segment_t pSegments[ET_TX_MAX_SEGMENTS];
+    ETGATHER        gather;
+    struct pbuf     *pGather = pPacket;
+    void            *pvSent;
+    uint32_t        uiSkip = ETH_PAD_SIZE;
+    uint32_t        uiRetry;
+
+    /* Free the frames the driver has finished with */
+    while (control(pEtherC->iEtherC, CTL_ETHER_RECLAIM_TX, &pvSent) == 0)
+    {
+        pbuf_free((struct pbuf *) pvSent);
+    }
+
+    /* Short frames are padded by the driver's copy */
+    if ((pPacket->tot_len - ETH_PAD_SIZE) < MIN_FRAME_SIZE)
+    {
+        return false;
+    }
+
+    gather.pSegments = pSegments;
+    gather.uiCount = 0;
+    gather.pvOwner = pPacket;
+
+    /* Describe each segment, stepping over the padding at the start */
+    while (pGather)
+    {
+        /* Only heap memory is known to be readable by the E-DMAC and stay put */
+        if ((PBUF_RAM != pGather->type) && (PBUF_POOL != pGather->type))
+        {
+            return false;
+        }
+
+        if (pGather->len > uiSkip)
+        {
+            if (ET_TX_MAX_SEGMENTS == gather.uiCount)
+            {
+                return false;
+            }
+
+            pSegments[gather.uiCount].pbyData = (uint8_t *) pGather->payload + uiSkip;
+            pSegments[gather.uiCount].uiLength = pGather->len - uiSkip;
+            gather.uiCount++;
+            uiSkip = 0;
+        }
+        else
+        {
+            uiSkip -= pGather->len;
+        }
+
+        pGather = pGather->next;
+    }
+
+    /* Hold the chain until the driver hands it back */
+    pbuf_ref(pPacket);
+
+    for (uiRetry = 0; uiRetry < ETHERNET_OUTPUT_RETRIES; uiRetry++)
+    {
+        if (control(pEtherC->iEtherC, CTL_ETHER_WRITE_GATHER, &gather) == 0)
+        {
+            return true;
+        }
+
+        /* The descriptors are busy, wait for some to be sent */
+        R_OS_TaskSleep(1UL);
+
+        while (control(pEtherC->iEtherC, CTL_ETHER_RECLAIM_TX, &pvSent) == 0)
+        {
+            pbuf_free((struct pbuf *) pvSent);
+        }
+    }
+
+    /* Dropped, as the copying write does when the descriptors are full */
+    pbuf_free(pPacket);
+    return true;
+}
+/******************************************************************************
+End of function  ipOutputGather
+******************************************************************************/
+
 /******************************************************************************
 * Function Name: ipOutput
 * Description  : This function is called by the ARP module when it wants
@@ -1185,6 +1563,13 @@ static err_t ipOutput(struct netif *pIpNetIf, struct pbuf *pPacket)
 
     eventWaitMutex(&pEtherC->pevOutputBufferMutex, EV_WAIT_INFINITE);
 
+    /* Send the pbufs in place when the driver can */
+    if (ipOutputGather(pEtherC, pPacket))
+    {
+        eventReleaseMutex(&pEtherC->pevOutputBufferMutex);
+        return ERR_OK;
+    }
+
     /* Check to see if the packet needs to be concatenated */
     if (pPacket->next)
     {
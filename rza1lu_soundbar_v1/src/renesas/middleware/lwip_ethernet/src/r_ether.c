@@ -35,6 +35,7 @@ Includes <System Includes> , ï¿½gProject Includesï¿½h
 #include "compiler_settings.h"
 #include "r_task_priority.h"
 #include "r_cache_l1_rz_api.h"
+#include "r_os_abstraction_api.h"
 
 #include "dev_drv.h"
 #include "r_intc.h"
@@ -93,6 +94,19 @@ static void *gpv_rx_parameter = NULL;
 static void (*gpfn_tx_call_back)(void *) = NULL;
 /* ---- Tx call-back parameter ---- */
 static void *gpv_tx_parameter = NULL;
+/* ---- Receive buffers not attached to a descriptor or lent out ---- */
+static uint8_t  *gpby_rx_spare[NUM_OF_RX_BUFFER];
+static uint32_t gui_rx_spare_count = 0;
+/* ---- Owner of the gathered frame ending at each transmit descriptor ---- */
+static void *gpv_tx_owner[NUM_OF_TX_DESCRIPTOR];
+
+/* TD0 bits, TFP is the position of the descriptor within the frame */
+#define TD0_TACT            (0x80000000UL)
+#define TD0_TDLE            (0x40000000UL)
+#define TD0_TFP_ONLY        (0x30000000UL)
+#define TD0_TFP_FIRST       (0x20000000UL)
+#define TD0_TFP_LAST        (0x10000000UL)
+#define TD0_TFP_MIDDLE      (0x00000000UL)
 
 static int32_t lan_desc_create(void);
 static void lan_reg_reset(void);
@@ -463,7 +477,7 @@ int32_t R_Ether_Write (uint32_t ch, void * buf, uint32_t len)
     }
 
     /* ==== When the buffer is full ==== */
-    if (p->td0.BIT.TACT == 1)
+    if ((p->td0.BIT.TACT == 1) || (NULL != gpv_tx_owner[p - geth_desc_ptr->dsend]))
     {
         return R_ETHER_ERROR;
     }
@@ -471,6 +485,7 @@ int32_t R_Ether_Write (uint32_t ch, void * buf, uint32_t len)
     /* ==== Transfer 1 frame ==== */
     
     /* ---- Copies the transmit frame ---- */
+    p->td2.TBA = geth_buf_ptr->bsend[p - geth_desc_ptr->dsend];   /* R_Ether_WriteGather may have moved it */
     memcpy(p->td2.TBA, buf, len);
     
     /* Need to write back the cache to physical mem */
@@ -513,6 +528,310 @@ int32_t R_Ether_Write (uint32_t ch, void * buf, uint32_t len)
     return R_ETHER_OK;
 }
 
+/******************************************************************************
+* Outline       : Take the frame
+* Include       : none
+* Function Name : R_Ether_ReadFrame
+* Description   : Lends the received Ethernet frame to the caller instead of
+*               : copying it, the descriptor is re-armed with a spare buffer.
+* Argument      : uint32_t ch        ; I : Ethernet channel number
+*               : uint8_t **ppbyFrame; O : Set to the start of the frame
+* Return Value  : Greater than 0   : Success. Returns number of bytes received
+*               : R_ETHER_ERROR(-1): Error
+*               : R_ETHER_NODATA(-5): No data received
+*               : R_ETHER_NOBUFFER(-6): No spare buffer, the frame is kept
+******************************************************************************/
+int32_t R_Ether_ReadFrame (uint32_t ch, uint8_t **ppbyFrame)
+{
+    (void) ch;
+    edmac_recv_desc_t * p   = geth_desc_ptr->pRecv_end;   /* Current descriptor */
+    int32_t             ret = 0;
+
+    /* Sanity check 1 */
+    if ((p < (edmac_recv_desc_t *)geth_desc_ptr)
+    ||  (p > (edmac_recv_desc_t *)(geth_desc_ptr + sizeof(txrx_descriptor_set_t))))
+    {
+        TRACE(("R_Ether_ReadFrame: Error in list 0x%p\r\n", p));
+        return R_ETHER_ERROR;
+    }
+
+    /* ==== No data ==== */
+    if (p->rd0.BIT.RACT == 1)
+    {
+        return R_ETHER_NODATA;
+    }
+
+    /* ---- Receive frame error ---- */
+    if ((p->rd0.BIT.RFE == 1)  &&  ((p->rd0.LONG & 0x025f0000) != 0))
+    {
+        p->rd0.LONG &= 0x70000000;          /* Processes the error flag */
+        ret = R_ETHER_ERROR;
+    }
+    /* ---- Swaps the received frame for a spare buffer ---- */
+    else
+    {
+        uint8_t *pbySpare = NULL;
+
+        R_OS_EnterCritical();
+        if (gui_rx_spare_count > 0)
+        {
+            pbySpare = gpby_rx_spare[--gui_rx_spare_count];
+        }
+        R_OS_ExitCritical();
+
+        /* Leave the frame on the descriptor until the caller releases one */
+        if (NULL == pbySpare)
+        {
+            return R_ETHER_NOBUFFER;
+        }
+
+        /* Need to invalidate the cache */
+        R_CACHE_L1_CleanInvalidLine((uint32_t) p->rd2.RBA, p->rd1.RDL);
+
+        *ppbyFrame = p->rd2.RBA;
+        ret = p->rd1.RDL;                   /* number of bytes received */
+        p->rd2.RBA = pbySpare;
+    }
+
+    /* ---- Sets the receive descriptor to receive again ---- */
+    p->rd0.BIT.RACT = 1;
+
+    /* ---- Starts receiving frame ---- */
+    if( (ETHER.EDRRR0 & 0x00000001) == 0 )
+    {
+        ETHER.EDRRR0 |=  0x00000001;
+    }
+
+    /* Sanity check 2 */
+    if ((p->pNext < (edmac_recv_desc_t *)geth_desc_ptr)
+    ||  (p->pNext > (edmac_recv_desc_t *)(geth_desc_ptr + sizeof(txrx_descriptor_set_t))))
+    {
+        TRACE(("R_Ether_ReadFrame: Error in list next 0x%p\r\n", p->pNext));
+        return R_ETHER_ERROR;
+    }
+
+    /* ==== Update the current pointer value ==== */
+    geth_desc_ptr->pRecv_end = p->pNext;
+    return ret;
+}
+/******************************************************************************
+* End of Function : R_Ether_ReadFrame
+******************************************************************************/
+
+/******************************************************************************
+* Outline       : Release the frame
+* Include       : none
+* Function Name : R_Ether_ReleaseFrame
+* Description   : Returns a frame lent by R_Ether_ReadFrame to the spare buffers
+* Argument      : uint32_t ch      ; I : Ethernet channel number
+*               : uint8_t *pbyFrame; I : Frame from R_Ether_ReadFrame
+* Return Value  : none
+******************************************************************************/
+void R_Ether_ReleaseFrame (uint32_t ch, uint8_t *pbyFrame)
+{
+    (void) ch;
+
+    R_OS_EnterCritical();
+    if (gui_rx_spare_count < NUM_OF_RX_BUFFER)
+    {
+        gpby_rx_spare[gui_rx_spare_count++] = pbyFrame;
+    }
+    R_OS_ExitCritical();
+}
+/******************************************************************************
+* End of Function : R_Ether_ReleaseFrame
+******************************************************************************/
+
+/******************************************************************************
+* Outline       : Transfer the frame from several buffers
+* Include       : none
+* Function Name : R_Ether_WriteGather
+* Description   : Points one transmit descriptor at each buffer of the frame
+*               : so the E-DMAC reads them in place. The first descriptor is
+*               : handed over last so a partly built frame is never sent.
+* Argument      : uint32_t ch                      ; I : Ethernet channel number
+*               : const ether_segment_t *pSegments; I : Buffers in frame order
+*               : uint32_t uiCount                 ; I : Number of buffers
+*               : void *pvOwner                    ; I : Returned by R_Ether_ReclaimTx
+* Return Value  : R_ETHER_OK(0)    : Success
+*               : R_ETHER_ERROR(-1): Error, nothing was queued
+******************************************************************************/
+int32_t R_Ether_WriteGather (uint32_t ch, const ether_segment_t *pSegments, uint32_t uiCount, void *pvOwner)
+{
+    (void) ch;
+    edmac_send_desc_t * p       = geth_desc_ptr->pSend_top;   /* Current descriptor */
+    edmac_send_desc_t * pFirst  = p;
+    edmac_send_desc_t * pLast   = p;
+    uint32_t            uiLength = 0;
+    uint32_t            i;
+
+    /* ==== link is down ==== */
+    if (glink_status == NEGO_FAIL)
+    {
+        return R_ETHER_ERROR;
+    }
+
+    if ((0 == uiCount) || (uiCount > R_ETHER_MAX_SEGMENTS) || (NULL == pvOwner))
+    {
+        return R_ETHER_ERROR;
+    }
+
+    /* ==== Every buffer needs a descriptor that is neither active nor waiting to be reclaimed ==== */
+    for (i = 0; i < uiCount; i++)
+    {
+        if ((p->td0.BIT.TACT == 1) || (NULL != gpv_tx_owner[p - geth_desc_ptr->dsend]))
+        {
+            return R_ETHER_ERROR;
+        }
+
+        uiLength += pSegments[i].uiLength;
+        p = p->pNext;
+    }
+
+    /* ==== Short frames are padded by R_Ether_Write ==== */
+    if ((uiLength < MIN_FRAME_SIZE) || (uiLength > MAX_FRAME_SIZE))
+    {
+        return R_ETHER_ERROR;
+    }
+
+    /* ==== Map the buffers onto the descriptors ==== */
+    p = pFirst;
+    for (i = 0; i < uiCount; i++)
+    {
+        uint32_t    uiPosition;
+
+        /* Need to write back the cache to physical mem */
+        R_CACHE_L1_CleanLine((uint32_t) pSegments[i].pbyData, pSegments[i].uiLength);
+
+        if (1 == uiCount)
+        {
+            uiPosition = TD0_TFP_ONLY;
+        }
+        else if (0 == i)
+        {
+            uiPosition = TD0_TFP_FIRST;
+        }
+        else if ((uiCount - 1) == i)
+        {
+            uiPosition = TD0_TFP_LAST;
+        }
+        else
+        {
+            uiPosition = TD0_TFP_MIDDLE;
+        }
+
+        p->td2.TBA  = (uint8_t *) pSegments[i].pbyData;
+        p->td1.TDL  = (uint16_t) pSegments[i].uiLength;
+        p->td0.LONG = (p->td0.LONG & TD0_TDLE) | uiPosition | ((0 == i) ? 0 : TD0_TACT);
+
+        pLast = p;
+        p = p->pNext;
+    }
+
+    /* ---- The owner is reclaimed when the last descriptor is written back ---- */
+    gpv_tx_owner[pLast - geth_desc_ptr->dsend] = pvOwner;
+
+    /* ---- Hand the frame to the E-DMAC ---- */
+    pFirst->td0.LONG |= TD0_TACT;
+
+    /* ---- Starts the transmission ---- */
+    if ((ETHER.EDTRR0&0x00000003) != 3)
+    {
+        ETHER.EDTRR0 |= 0x00000003;
+    }
+
+    /* ==== Update the current pointer value ==== */
+    geth_desc_ptr->pSend_top = p;
+
+    return R_ETHER_OK;
+}
+/******************************************************************************
+* End of Function : R_Ether_WriteGather
+******************************************************************************/
+
+/******************************************************************************
+* Outline       : Reclaim a sent frame
+* Include       : none
+* Function Name : R_Ether_ReclaimTx
+* Description   : Finds a frame from R_Ether_WriteGather that the E-DMAC has
+*               : finished with and frees its descriptors
+* Argument      : uint32_t ch; I : Ethernet channel number
+* Return Value  : The owner passed to R_Ether_WriteGather or NULL
+******************************************************************************/
+void *R_Ether_ReclaimTx (uint32_t ch)
+{
+    (void) ch;
+    int32_t     i;
+    void        *pvOwner;
+
+    for (i = 0; i < NUM_OF_TX_DESCRIPTOR; i++)
+    {
+        pvOwner = gpv_tx_owner[i];
+
+        if ((NULL != pvOwner) && (geth_desc_ptr->dsend[i].td0.BIT.TACT == 0))
+        {
+            gpv_tx_owner[i] = NULL;
+            return pvOwner;
+        }
+    }
+
+    return NULL;
+}
+/******************************************************************************
+* End of Function : R_Ether_ReclaimTx
+******************************************************************************/
+
+/******************************************************************************
+* Outline       : Count the received frames
+* Include       : none
+* Function Name : R_Ether_RxPending
+* Description   : Counts the descriptors holding a frame that has not been
+*               : read yet, starting from the next one to be read
+* Argument      : uint32_t ch; I : Ethernet channel number
+* Return Value  : Number of frames waiting, 0 to NUM_OF_RX_DESCRIPTOR
+******************************************************************************/
+uint32_t R_Ether_RxPending (uint32_t ch)
+{
+    (void) ch;
+    edmac_recv_desc_t * p     = geth_desc_ptr->pRecv_end;
+    uint32_t            count = 0;
+
+    /* The E-DMAC fills the descriptors in ring order */
+    while ((count < NUM_OF_RX_DESCRIPTOR) && (p->rd0.BIT.RACT == 0))
+    {
+        count++;
+        p = p->pNext;
+    }
+
+    return count;
+}
+/******************************************************************************
+* End of Function : R_Ether_RxPending
+******************************************************************************/
+
+/******************************************************************************
+* Outline       : Read the missed frame counter
+* Include       : none
+* Function Name : R_Ether_MissedFrames
+* Description   : Reads and clears the count of frames the controller dropped
+*               : because there was no descriptor to receive them into
+* Argument      : uint32_t ch; I : Ethernet channel number
+* Return Value  : Frames missed since the last call
+******************************************************************************/
+uint32_t R_Ether_MissedFrames (uint32_t ch)
+{
+    (void) ch;
+    uint32_t missed = ETHER.RMFCR0 & 0x0000FFFF;
+
+    /* ---- Writing any value clears the counter ---- */
+    ETHER.RMFCR0 = 0;
+
+    return missed;
+}
+/******************************************************************************
+* End of Function : R_Ether_MissedFrames
+******************************************************************************/
+
 /******************************************************************************
 * ID            : Ã¯Â¿Â½|
 * Outline       : Create the descriptor
@@ -573,11 +892,14 @@ static int32_t lan_desc_create (void)
     geth_desc_ptr->dsend[i - 1].td0.BIT.TDLE = 1;
     geth_desc_ptr->dsend[i - 1].pNext        = &geth_desc_ptr->dsend[0];
 
+    /* ---- No gathered frames are outstanding ---- */
+    memset(gpv_tx_owner, 0, sizeof(gpv_tx_owner));
+
     /* ---- Receive descriptor ---- */
     for (i = 0; i < NUM_OF_RX_DESCRIPTOR; i++)
     {
         TRACE(("geth_desc_ptr->drecv[i].rd2.RBA = 0x%p\r\n", geth_buf_ptr->brecv[i]));
-        geth_desc_ptr->drecv[i].rd2.RBA = geth_buf_ptr->brecv[i];      /* RD2 */
+        geth_desc_ptr->drecv[i].rd2.RBA = &geth_buf_ptr->brecv[i][RX_BUFFER_HEADROOM];  /* RD2 */
         geth_desc_ptr->drecv[i].rd1.RBL = (uint16_t)SIZE_OF_BUFFER;   /* RD1 */
         geth_desc_ptr->drecv[i].rd0.LONG= 0xB0000000;        /* RD0:1frame/1buf, reception enabled */
 
@@ -590,6 +912,13 @@ static int32_t lan_desc_create (void)
     geth_desc_ptr->drecv[i - 1].rd0.BIT.RDLE = 1;                /* Set the last descriptor */
     geth_desc_ptr->drecv[i - 1].pNext        = &geth_desc_ptr->drecv[0];
 
+    /* ---- The remaining receive buffers replace frames lent by R_Ether_ReadFrame ---- */
+    gui_rx_spare_count = 0;
+    for (i = NUM_OF_RX_DESCRIPTOR; i < NUM_OF_RX_BUFFER; i++)
+    {
+        gpby_rx_spare[gui_rx_spare_count++] = &geth_buf_ptr->brecv[i][RX_BUFFER_HEADROOM];
+    }
+
     /* ---- Initialize descriptor management information ---- */
     geth_desc_ptr->pSend_top = &geth_desc_ptr->dsend[0];
     geth_desc_ptr->pRecv_end = &geth_desc_ptr->drecv[0];
@@ -98,3 +98,16 @@ int32_t riic_dae6_Write(const uint32_t addr, const uint8_t *data);
 * @retval        error code :Failure.
 ******************************************************************************/
 int32_t riic_dae6_Read(const uint32_t addr, uint8_t* const p_data);
+/**************************************************************************//**
+* Function Name: riic_dae6_WriteBlock
+* @brief         Write consecutive registers in one transaction
+*
+*                Description:<br>
+*
+* @param         addr       :address of the first register
+* @param         data       :3 bytes per register, most significant byte first
+* @param         count      :number of registers
+* @retval        DEVDRV_SUCCESS   :Success.
+* @retval        error code :Failure.
+******************************************************************************/
+int32_t riic_dae6_WriteBlock(const uint32_t addr, const uint8_t *data, const uint32_t count);
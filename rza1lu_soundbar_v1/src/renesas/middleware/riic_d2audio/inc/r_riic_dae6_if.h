@@ -44,6 +44,19 @@ Typedef definitions
 /******************************************************************************
 Macro definitions
 ******************************************************************************/
+/** Input select is written and read back through different command addresses */
+#define DAE6_REG_WR_INPUT_SELECT    (0x00020001u)
+#define DAE6_REG_RD_INPUT_SELECT    (0x00020002u)
+
+/** Registers held in the shadow cache, each can have one write pending */
+#define DAE6_SHADOW_ENTRIES         (16u)
+
+/** Most registers sent in one bus transaction */
+#define DAE6_BURST_MAX              (8u)
+
+/** Set to 1 if the DAE firmware auto increments the sub-address, adjacent
+ *  registers in the queue are then sent as one transaction */
+#define DAE6_CFG_AUTO_INCREMENT     (0)
 
 /******************************************************************************
 Imported global variables and functions (from other files)
@@ -77,27 +90,42 @@ extern int32_t r_riic_dae6_Open(void);
 extern int32_t r_riic_dae6_Close(void);
 
 /**
- * @brief         Write register to MAX9856
+ * @brief         Queue a register write to the DAE-6
  *
- * @param[in]     addr:  Register address 0-28
- * @param[in]     dat:   Register data 0-255
+ *                Returns once the value is in the shadow cache, the queue
+ *                task puts it on the bus. A register written again before
+ *                it has been sent is sent once with the newest value.
  *
- * @retval        DEVDRV_SUCCESS:   Success.
+ * @param[in]     addr:  24 bit register address
+ * @param[in]     dat:   3 byte register value, least significant byte first
+ *
+ * @retval        DEVDRV_SUCCESS:   Queued.
  * @retval        error code:       Failure.
  */
 extern int32_t r_riic_dae6_Write(const uint32_t addr, const uint8_t *dat);
 
 /**
- * @brief         Read register from MAX9856
+ * @brief         Read register from the DAE-6
+ *
+ *                Registers that have been written are served from the
+ *                shadow cache, anything else is read from the bus.
  *
- * @param[in]     addr:    register address 0-28
- * @param[out]    p_dat:   store address of register data 0-255
+ * @param[in]     addr:    24 bit register address
+ * @param[out]    p_dat:   3 byte register value, most significant byte first
  *
  * @retval        DEVDRV_SUCCESS:  Success.
  * @retval        error code:      Failure.
  */
 extern int32_t r_riic_dae6_Read(const uint32_t addr, uint8_t* const p_dat);
 
+/**
+ * @brief         Wait for queued writes to reach the DAE-6
+ *
+ * @retval        DEVDRV_SUCCESS:  Queue empty.
+ * @retval        error code:      Timed out or a queued write failed.
+ */
+extern int32_t r_riic_dae6_Flush(void);
+
 /**
  * @brief         Get RIIC_CH1 driver version.
 
@@ -77,7 +77,8 @@ static riic_ch1_aio_ctrl_t s_i2c1_ctrl =
 
 };
 
-static int32_t RIIC_CH1_REG24_Write(const uint8_t riic_addr, const uint32_t reg_addr, const uint8_t *reg_data);
+static int32_t RIIC_CH1_REG24_Write(const uint8_t riic_addr, const uint32_t reg_addr, const uint8_t *reg_data,
+        const uint32_t bytes);
 static int32_t RIIC_CH1_REG24_Read(const uint8_t riic_addr, const uint32_t reg_addr, uint8_t* const p_reg_data);
 
 /******************************************************************************
@@ -156,6 +157,7 @@ int32_t riic_dae6_Close(void)
 int32_t riic_dae6_Write(const uint32_t addr, const uint8_t *data)
 {
     int_t ercd;
+    uint8_t bus_data[3];
 
     if (addr > DAE6_REG_MAX)
     {
@@ -163,7 +165,12 @@ int32_t riic_dae6_Write(const uint32_t addr, const uint8_t *data)
     }
     else
     {
-        ercd = RIIC_CH1_REG24_Write(DAE6_DEVICE_ADDR, addr, data);
+        /* Big Endian */
+        bus_data[0] = data[2];
+        bus_data[1] = data[1];
+        bus_data[2] = data[0];
+
+        ercd = RIIC_CH1_REG24_Write(DAE6_DEVICE_ADDR, addr, bus_data, 3u);
     }
 
     return (ercd);
@@ -172,6 +179,37 @@ int32_t riic_dae6_Write(const uint32_t addr, const uint8_t *data)
 End of function riic_dae6_Write
 ******************************************************************************/
 
+/**************************************************************************//**
+* Function Name: riic_dae6_WriteBlock
+* @brief         Write consecutive registers in one transaction
+*
+*                Description:<br>
+*
+* @param         addr       :address of the first register
+* @param         data       :3 bytes per register, most significant byte first
+* @param         count      :number of registers
+* @retval        DEVDRV_SUCCESS   :Success.
+* @retval        error code :Failure.
+******************************************************************************/
+int32_t riic_dae6_WriteBlock(const uint32_t addr, const uint8_t *data, const uint32_t count)
+{
+    int_t ercd;
+
+    if ((0u == count) || ((addr + count - 1u) > DAE6_REG_MAX))
+    {
+        ercd = DEVDRV_ERROR;
+    }
+    else
+    {
+        ercd = RIIC_CH1_REG24_Write(DAE6_DEVICE_ADDR, addr, data, count * 3u);
+    }
+
+    return (ercd);
+}
+/******************************************************************************
+End of function riic_dae6_WriteBlock
+******************************************************************************/
+
 /**************************************************************************//**
 * Function Name: riic_dae6_Read
 * @brief         Read register from MAX9856
@@ -215,34 +253,31 @@ End of function riic_dae6_Read
 *
 * @param[in]     riic_addr       : riic 8bit address 0-255
 * @param[in]     reg_addr        : register address  0-255
-* @param[in]     reg_data        : register data     0-255
+* @param[in]     reg_data        : register data in bus order
+* @param[in]     bytes           : bytes of register data
 * @retval        DEVDRV_SUCCESS   :Success.
 * @retval        error code :Failure.
 ******************************************************************************/
-static int32_t RIIC_CH1_REG24_Write(const uint8_t riic_addr, const uint32_t reg_addr, const uint8_t *reg_data)
+static int32_t RIIC_CH1_REG24_Write(const uint8_t riic_addr, const uint32_t reg_addr, const uint8_t *reg_data,
+        const uint32_t bytes)
 {
     int32_t riic_ret = DEVDRV_ERROR;
     st_r_drv_riic_config_t i2c_write;
 
     uint8_t sub_addr[3];
-    uint8_t data[3];
 
 	// Big Endian
 	sub_addr[0] = (uint8_t)((reg_addr >> 16) & 0x000000FF);
 	sub_addr[1] = (uint8_t)((reg_addr >> 8) & 0x000000FF);
 	sub_addr[2] = (uint8_t)(reg_addr & 0x000000FF);
 
-	data[0] = reg_data[2];
-	data[1] = reg_data[1];
-	data[2] = reg_data[0];
-
     /*Set RIIC Address*/
     i2c_write.device_address = riic_addr;
     i2c_write.sub_address = &sub_addr[0];
 
     /* Assign Data to Write */
-    i2c_write.number_of_bytes = 3u;
-    i2c_write.p_data_buffer = data;
+    i2c_write.number_of_bytes = bytes;
+    i2c_write.p_data_buffer = (uint8_t *) reg_data;
 
     /*Write Data*/
     riic_ret = control(s_i2c1_ctrl.hi2c1, CTL_RIIC_WRITE, &i2c_write);
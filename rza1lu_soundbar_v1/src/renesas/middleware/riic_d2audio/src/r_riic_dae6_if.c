@@ -31,26 +31,54 @@
 /******************************************************************************
 Includes   <System Includes> , "Project Includes"
 ******************************************************************************/
+#include <string.h>
+
 #include "mcu_board_select.h"
 #include "r_errno.h"
 #include "r_os_abstraction_api.h"
+#include "r_task_priority.h"
 #include "r_riic_dae6_if.h"
+#include "r_riic_dae6_drv.h"
 #include "dev_drv.h"
 
 /******************************************************************************
 Typedef definitions
 ******************************************************************************/
+typedef struct riic_ch1_shadow
+{
+    uint32_t         addr;      /* write command address */
+    uint8_t          data[3];   /* register value in bus order, most significant byte first */
+    bool_t           valid;     /* data is on the device or queued for it */
+    bool_t           queued;    /* index is in the pending FIFO */
+} riic_ch1_shadow_t;
+
 typedef struct riic_ch1_ctrl
 {
     bool_t           is_open;
     uint32_t         semid;
+    uint32_t         queue_semid;                   /* wakes the queue task */
+    riic_ch1_shadow_t shadow[DAE6_SHADOW_ENTRIES];
+    uint8_t          fifo[DAE6_SHADOW_ENTRIES];     /* shadow indexes to write, oldest first */
+    uint32_t         fifo_head;
+    uint32_t         fifo_count;
+    uint32_t         in_flight;                     /* registers taken from the FIFO, not yet on the bus */
+    uint32_t         write_errors;                  /* failed queued writes since the last flush */
 } riic_ch1_ctrl_t;
 
+typedef struct riic_ch1_alias
+{
+    uint32_t         rd_addr;
+    uint32_t         wr_addr;
+} riic_ch1_alias_t;
+
 /******************************************************************************
 Macro definitions
 ******************************************************************************/
 #define RIIC_CH1_API_TMOUT (500u)
 
+/* Poll interval of r_riic_dae6_Flush */
+#define RIIC_CH1_FLUSH_POLL (1u)
+
 /******************************************************************************
 Imported global variables and functions (from other files)
 ******************************************************************************/
@@ -67,6 +95,20 @@ static riic_ch1_ctrl_t s_riic1_ctrl =
     false,  /* is_open */
     0       /* semid   */
 };
+
+static bool_t s_queue_task_created = false;
+
+/* Registers read back through a different address than they are written to */
+static const riic_ch1_alias_t s_alias[] =
+{
+    { DAE6_REG_RD_INPUT_SELECT, DAE6_REG_WR_INPUT_SELECT },
+};
+
+static void riic_dae6_queue_task(void *parameters);
+static int32_t shadow_find(const uint32_t addr);
+static uint32_t take_burst(uint32_t *p_addr, uint8_t *p_data, uint8_t *p_index);
+static void complete_burst(const uint8_t *p_index, const uint32_t count, const int32_t ercd);
+
 /******************************************************************************
 Exported global functions (to be accessed by other files)
 ******************************************************************************/
@@ -94,6 +136,16 @@ int32_t r_riic_dae6_Open(void)
             ercd = DEVDRV_ERROR;
         }
 
+        if ((DEVDRV_SUCCESS == ercd) && (0 == s_riic1_ctrl.queue_semid))
+        {
+            R_OS_CreateSemaphore(&s_riic1_ctrl.queue_semid, 0);
+
+            if (0 == s_riic1_ctrl.queue_semid)
+            {
+                ercd = DEVDRV_ERROR;
+            }
+        }
+
         if (DEVDRV_SUCCESS == ercd)
         {
             ercd = riic_dae6_Open();
@@ -101,7 +153,21 @@ int32_t r_riic_dae6_Open(void)
 
         if (DEVDRV_SUCCESS == ercd)
         {
+            /* the device may have been reset since the last open, start with an empty cache */
+            memset(s_riic1_ctrl.shadow, 0, sizeof(s_riic1_ctrl.shadow));
+            s_riic1_ctrl.fifo_head = 0u;
+            s_riic1_ctrl.fifo_count = 0u;
+            s_riic1_ctrl.in_flight = 0u;
+            s_riic1_ctrl.write_errors = 0u;
             s_riic1_ctrl.is_open = true;
+
+            /* the task outlives close, it sleeps on an empty queue */
+            if (false == s_queue_task_created)
+            {
+                R_OS_CreateTask("DAE-6 Queue", riic_dae6_queue_task, NULL, R_OS_ABSTRACTION_PRV_DEFAULT_STACK_SIZE,
+                        TASK_DAE6_QUEUE_PRI);
+                s_queue_task_created = true;
+            }
         }
         else
         {
@@ -134,6 +200,9 @@ int32_t r_riic_dae6_Close(void)
     }
     else
     {
+        /* let queued writes reach the device, a failure does not stop the close */
+        r_riic_dae6_Flush();
+
         sem_token = R_OS_WaitForSemaphore(&s_riic1_ctrl.semid, RIIC_CH1_API_TMOUT);
 
         if (!sem_token)
@@ -149,50 +218,119 @@ int32_t r_riic_dae6_Close(void)
                 s_riic1_ctrl.is_open = false;
                 R_OS_DeleteSemaphore(&s_riic1_ctrl.semid);
             }
+            else
+            {
+                R_OS_ReleaseSemaphore(&s_riic1_ctrl.semid);
+            }
         }
     }
 
     return (ercd);
 }
 /**
- * @brief         Write register to MAX9856
+ * @brief         Queue a register write to the DAE-6
  *
- * @param[in]     addr:  Register address 0-28
- * @param[in]     dat:   Register data 0-255
+ * @param[in]     addr:  24 bit register address
+ * @param[in]     dat:   3 byte register value, least significant byte first
  *
- * @retval        DEVDRV_SUCCESS:   Success.
+ * @retval        DEVDRV_SUCCESS:   Queued.
  * @retval        error code:       Failure.
  */
 int32_t r_riic_dae6_Write(const uint32_t addr, const uint8_t *dat)
 {
     int32_t ercd = DEVDRV_SUCCESS;
+    int32_t index;
+    bool_t wake = false;
     bool_t sem_token;
+    riic_ch1_shadow_t *p_entry;
 
     if (false == s_riic1_ctrl.is_open)
     {
-        ercd = DEVDRV_ERROR;
+        return (DEVDRV_ERROR);
     }
-    else
+
+    R_OS_EnterCritical();
+
+    index = shadow_find(addr);
+
+    if (index < 0)
     {
-        sem_token = R_OS_WaitForSemaphore(&s_riic1_ctrl.semid, RIIC_CH1_API_TMOUT);
-        if (!sem_token)
+        /* reuse the first free entry, or one that is already on the device */
+        for (index = 0; index < (int32_t) DAE6_SHADOW_ENTRIES; index++)
         {
-            ercd = DEVDRV_ERROR;
+            if ((false == s_riic1_ctrl.shadow[index].valid) && (false == s_riic1_ctrl.shadow[index].queued))
+            {
+                break;
+            }
         }
-        else
+
+        if (index >= (int32_t) DAE6_SHADOW_ENTRIES)
         {
-            ercd = riic_dae6_Write(addr, dat);
-            R_OS_ReleaseSemaphore(&s_riic1_ctrl.semid);
+            for (index = 0; index < (int32_t) DAE6_SHADOW_ENTRIES; index++)
+            {
+                if (false == s_riic1_ctrl.shadow[index].queued)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (index < (int32_t) DAE6_SHADOW_ENTRIES)
+    {
+        p_entry = &s_riic1_ctrl.shadow[index];
+        p_entry->addr = addr;
+        p_entry->data[0] = dat[2];
+        p_entry->data[1] = dat[1];
+        p_entry->data[2] = dat[0];
+        p_entry->valid = true;
+
+        /* a register already waiting is sent once, with this value */
+        if (false == p_entry->queued)
+        {
+            p_entry->queued = true;
+            s_riic1_ctrl.fifo[(s_riic1_ctrl.fifo_head + s_riic1_ctrl.fifo_count) % DAE6_SHADOW_ENTRIES] =
+                    (uint8_t) index;
+            s_riic1_ctrl.fifo_count++;
+            wake = true;
+        }
+    }
+
+    R_OS_ExitCritical();
+
+    if (false != wake)
+    {
+        R_OS_ReleaseSemaphore(&s_riic1_ctrl.queue_semid);
+    }
+
+    if (index >= (int32_t) DAE6_SHADOW_ENTRIES)
+    {
+        /* every entry is waiting to be sent, write through once they have gone so the order is kept */
+        ercd = r_riic_dae6_Flush();
+
+        if (DEVDRV_SUCCESS == ercd)
+        {
+            sem_token = R_OS_WaitForSemaphore(&s_riic1_ctrl.semid, RIIC_CH1_API_TMOUT);
+
+            if (!sem_token)
+            {
+                ercd = DEVDRV_ERROR;
+            }
+            else
+            {
+                ercd = riic_dae6_Write(addr, dat);
+                R_OS_ReleaseSemaphore(&s_riic1_ctrl.semid);
+            }
         }
     }
 
     return (ercd);
 }
 /**
- * @brief         Read register from MAX9856
+ * @brief         Read register from the DAE-6
  *
- * @param[in]     addr:    register address 0-28
- * @param[out]    p_dat:   store address of register data 0-255
+ * @param[in]     addr:    24 bit register address
+ * @param[out]    p_dat:   3 byte register value, most significant byte first
  *
  * @retval        DEVDRV_SUCCESS:  Success.
  * @retval        error code:      Failure.
@@ -201,12 +339,41 @@ int32_t r_riic_dae6_Read(const uint32_t addr, uint8_t* const p_dat)
 {
     int32_t ercd = DEVDRV_SUCCESS;
     bool_t sem_token;
+    uint32_t shadow_addr = addr;
+    uint32_t i;
+    int32_t index;
 
     if (false == s_riic1_ctrl.is_open)
     {
-        ercd = DEVDRV_ERROR;
+        return (DEVDRV_ERROR);
+    }
+
+    for (i = 0u; i < (sizeof(s_alias) / sizeof(s_alias[0])); i++)
+    {
+        if (s_alias[i].rd_addr == addr)
+        {
+            shadow_addr = s_alias[i].wr_addr;
+        }
+    }
+
+    R_OS_EnterCritical();
+
+    index = shadow_find(shadow_addr);
+
+    if ((index >= 0) && (false != s_riic1_ctrl.shadow[index].valid))
+    {
+        p_dat[0] = s_riic1_ctrl.shadow[index].data[0];
+        p_dat[1] = s_riic1_ctrl.shadow[index].data[1];
+        p_dat[2] = s_riic1_ctrl.shadow[index].data[2];
     }
     else
+    {
+        index = -1;
+    }
+
+    R_OS_ExitCritical();
+
+    if (index < 0)
     {
         sem_token = R_OS_WaitForSemaphore(&s_riic1_ctrl.semid, RIIC_CH1_API_TMOUT);
 
@@ -223,6 +390,42 @@ int32_t r_riic_dae6_Read(const uint32_t addr, uint8_t* const p_dat)
 
     return (ercd);
 }
+/**
+ * @brief         Wait for queued writes to reach the DAE-6
+ *
+ * @retval        DEVDRV_SUCCESS:  Queue empty.
+ * @retval        error code:      Timed out or a queued write failed.
+ */
+int32_t r_riic_dae6_Flush(void)
+{
+    int32_t ercd = DEVDRV_ERROR;
+    uint32_t waited = 0u;
+    bool_t idle;
+
+    while (waited <= RIIC_CH1_API_TMOUT)
+    {
+        R_OS_EnterCritical();
+        idle = ((0u == s_riic1_ctrl.fifo_count) && (0u == s_riic1_ctrl.in_flight));
+
+        if (false != idle)
+        {
+            ercd = (0u == s_riic1_ctrl.write_errors) ? DEVDRV_SUCCESS : DEVDRV_ERROR;
+            s_riic1_ctrl.write_errors = 0u;
+        }
+
+        R_OS_ExitCritical();
+
+        if (false != idle)
+        {
+            break;
+        }
+
+        R_OS_TaskSleep(RIIC_CH1_FLUSH_POLL);
+        waited += RIIC_CH1_FLUSH_POLL;
+    }
+
+    return (ercd);
+}
 /**
  * @brief         Get RIIC_CH1 driver version.
 
@@ -240,3 +443,149 @@ uint16_t r_riic_dae6_GetVersion(void)
     return version;
 }
 #endif
+
+/**
+ * @brief         Sends queued writes, oldest first. Each wake-up drains
+ *                the whole queue so writes made while the bus was busy go
+ *                out back to back.
+ *
+ * @param[in]     parameters: unused
+ */
+static void riic_dae6_queue_task(void *parameters)
+{
+    uint8_t  data[DAE6_BURST_MAX * 3u];
+    uint8_t  index[DAE6_BURST_MAX];
+    uint32_t addr;
+    uint32_t count;
+    int32_t  ercd;
+
+    (void) parameters;
+
+    while (1)
+    {
+        R_OS_WaitForSemaphore(&s_riic1_ctrl.queue_semid, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
+
+        count = take_burst(&addr, data, index);
+
+        while (0u != count)
+        {
+            if (false != R_OS_WaitForSemaphore(&s_riic1_ctrl.semid, RIIC_CH1_API_TMOUT))
+            {
+                ercd = riic_dae6_WriteBlock(addr, data, count);
+                R_OS_ReleaseSemaphore(&s_riic1_ctrl.semid);
+            }
+            else
+            {
+                ercd = DEVDRV_ERROR;
+            }
+
+            complete_burst(index, count, ercd);
+            count = take_burst(&addr, data, index);
+        }
+    }
+}
+
+/**
+ * @brief         Finds the shadow entry of a register, call with interrupts disabled
+ *
+ * @param[in]     addr: write command address
+ *
+ * @retval        index of the entry, -1 if the register is not cached
+ */
+static int32_t shadow_find(const uint32_t addr)
+{
+    int32_t i;
+
+    for (i = 0; i < (int32_t) DAE6_SHADOW_ENTRIES; i++)
+    {
+        if (((false != s_riic1_ctrl.shadow[i].valid) || (false != s_riic1_ctrl.shadow[i].queued))
+                && (s_riic1_ctrl.shadow[i].addr == addr))
+        {
+            return (i);
+        }
+    }
+
+    return (-1);
+}
+
+/**
+ * @brief         Takes the oldest queued register and, when the device
+ *                auto increments, the queued registers that follow it
+ *
+ * @param[out]    p_addr:  address of the first register
+ * @param[out]    p_data:  register values in bus order
+ * @param[out]    p_index: shadow entries taken
+ *
+ * @retval        registers taken, 0 if the queue is empty
+ */
+static uint32_t take_burst(uint32_t *p_addr, uint8_t *p_data, uint8_t *p_index)
+{
+    uint32_t count = 0u;
+    uint8_t next;
+    riic_ch1_shadow_t *p_entry;
+
+    R_OS_EnterCritical();
+
+    while ((0u != s_riic1_ctrl.fifo_count) && (count < DAE6_BURST_MAX))
+    {
+        next = s_riic1_ctrl.fifo[s_riic1_ctrl.fifo_head];
+        p_entry = &s_riic1_ctrl.shadow[next];
+
+        if (0u == count)
+        {
+            *p_addr = p_entry->addr;
+        }
+        else if ((0 == DAE6_CFG_AUTO_INCREMENT) || (p_entry->addr != ((*p_addr) + count)))
+        {
+            break;
+        }
+
+        s_riic1_ctrl.fifo_head = (s_riic1_ctrl.fifo_head + 1u) % DAE6_SHADOW_ENTRIES;
+        s_riic1_ctrl.fifo_count--;
+
+        /* a write from now on queues the entry again */
+        p_entry->queued = false;
+        memcpy(&p_data[count * 3u], p_entry->data, 3u);
+        p_index[count] = next;
+        count++;
+    }
+
+    s_riic1_ctrl.in_flight = count;
+
+    R_OS_ExitCritical();
+
+    return (count);
+}
+
+/**
+ * @brief         Records the result of a burst. Registers that failed
+ *                and have not been written since are dropped from the
+ *                cache so the next read goes to the bus.
+ *
+ * @param[in]     p_index: shadow entries sent
+ * @param[in]     count:   number of entries
+ * @param[in]     ercd:    result of the transaction
+ */
+static void complete_burst(const uint8_t *p_index, const uint32_t count, const int32_t ercd)
+{
+    uint32_t i;
+
+    R_OS_EnterCritical();
+
+    if (DEVDRV_SUCCESS != ercd)
+    {
+        for (i = 0u; i < count; i++)
+        {
+            if (false == s_riic1_ctrl.shadow[p_index[i]].queued)
+            {
+                s_riic1_ctrl.shadow[p_index[i]].valid = false;
+            }
+        }
+
+        s_riic1_ctrl.write_errors++;
+    }
+
+    s_riic1_ctrl.in_flight = 0u;
+
+    R_OS_ExitCritical();
+}
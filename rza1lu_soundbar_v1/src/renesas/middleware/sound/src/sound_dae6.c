@@ -33,7 +33,7 @@ Includes   <System Includes> , "Project Includes"
 ******************************************************************************/
 #include "r_typedefs.h"
 #include "sound_dae6.h"
-#include "r_riic_dae6_drv.h"
+#include "r_riic_dae6_if.h"
 
 /******************************************************************************
 Typedef definitions
@@ -42,8 +42,8 @@ Typedef definitions
 /******************************************************************************
 Macro definitions
 ******************************************************************************/
-#define DAE6_INPUT_READ	0x00020002
-#define DAE6_INPUT_WRITE 0x00020001
+#define DAE6_INPUT_READ	DAE6_REG_RD_INPUT_SELECT
+#define DAE6_INPUT_WRITE DAE6_REG_WR_INPUT_SELECT
 
 /******************************************************************************
 Imported global variables and functions (from other files)
@@ -72,7 +72,7 @@ Exported global functions (to be accessed by other files)
 int_t sound_dae6_init (void)
 {
 
-	return riic_dae6_Open();
+	return r_riic_dae6_Open();
 }
 
 /**************************************************************************//**
@@ -86,7 +86,7 @@ int_t sound_dae6_init (void)
  ******************************************************************************/
 int_t sound_dae6_uinit (void)
 {
-	return riic_dae6_Close();
+	return r_riic_dae6_Close();
 
 }
 
@@ -141,7 +141,7 @@ int_t sound_dae6_set_input (dae_in_block_t *input )
 
 	data[2] |= input->channel2 &0x01;
 
-	ret = riic_dae6_Write( DAE6_INPUT_WRITE, &data[0]);
+	ret = r_riic_dae6_Write( DAE6_INPUT_WRITE, &data[0]);
 
 	return ret;
 }
@@ -160,7 +160,8 @@ int_t sound_dae6_get_input ( dae_in_block_t *input )
 	uint8_t data[3];
 	int_t ret = -1;
 
-	if ( riic_dae6_Read( DAE6_INPUT_READ,  &data[0]) >= 0 ) {
+	// Served from the shadow cache once the input has been written
+	if ( r_riic_dae6_Read( DAE6_INPUT_READ,  &data[0]) >= 0 ) {
 
 		input->inputSelect = data[0] & 0x0001;
 		input->channel8 = (data[1] & 0x30)>>4;
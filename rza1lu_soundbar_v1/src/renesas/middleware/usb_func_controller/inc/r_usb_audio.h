@@ -0,0 +1,196 @@
+/*******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this
+ * software, you agree to the additional terms and conditions found by
+ * accessing the following link:
+ * http://www.renesas.com/disclaimer
+*******************************************************************************
+* Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *****************************************************************************/
+/******************************************************************************
+ * @headerfile     r_usb_audio.h
+ * @brief          USB Audio Class 2.0 function, asynchronous speaker.
+ * @version        1.00
+ * @date           27.06.2018
+ * H/W Platform    RZ/A1LU
+ *****************************************************************************/
+ /*****************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 27.06.2018 1.00 First Release
+ *****************************************************************************/
+/* Multiple inclusion prevention macro */
+#ifndef USB_AUDIO_H
+#define USB_AUDIO_H
+
+/**************************************************************************//**
+ * @ingroup R_SW_PKG_93_POSIX_MIDDLEWARE
+ * @defgroup R_SW_PKG_93_USB_AUDIO USB Audio Function
+ * @brief USB function Audio Class 2.0 speaker
+ *
+ * @anchor R_SW_PKG_93_USB_AUDIO_SUMMARY
+ * @par Summary
+ *
+ * The device enumerates as a full speed stereo speaker with one
+ * isochronous OUT endpoint carrying 24 bit samples in 4 byte subslots and an
+ * asynchronous feedback endpoint. Packets are read from the FIFO straight
+ * into the buffer supplied by the sink, normally the playback ring, there is
+ * no intermediate copy.
+ *
+ * The sink reports how many frames the audio output has played, the
+ * feedback endpoint tells the host the rate measured from that count
+ * corrected by how far the buffered level is from the sink's target.
+ *
+ * @see RENESAS_APPLICATION_SOFTWARE_PACKAGE
+ * @{
+ *****************************************************************************/
+/******************************************************************************
+User Includes
+******************************************************************************/
+#include "usb_common.h"
+#include "r_usbf_core.h"
+
+/******************************************************************************
+Macro Defines
+******************************************************************************/
+/** Only rate offered to the host */
+#define USBF_AUDIO_SAMPLE_RATE      (44100u)
+
+/** Stereo */
+#define USBF_AUDIO_CHANNELS         (2u)
+
+/** 24 bit samples MSB justified in 32 bit subslots */
+#define USBF_AUDIO_SUBSLOT_BYTES    (4u)
+
+/** Bytes per frame on the bus and in the sink */
+#define USBF_AUDIO_FRAME_BYTES      (USBF_AUDIO_CHANNELS * USBF_AUDIO_SUBSLOT_BYTES)
+
+/** Volume range offered to the host, 1/256 dB units */
+#define USBF_AUDIO_VOLUME_MIN       (-25600)
+#define USBF_AUDIO_VOLUME_MAX       (0)
+#define USBF_AUDIO_VOLUME_RES       (64)
+
+/******************************************************************************
+Type Definitions
+******************************************************************************/
+
+/** Returns where the next frames go and how many bytes fit there, NULL when
+    the sink is full. Called in the USB interrupt. */
+typedef uint8_t *(*CB_AUDIO_GET_BUFFER)(void *, uint32_t *);
+
+/** The bytes at the buffer returned by CB_AUDIO_GET_BUFFER have been
+    filled. Called in the USB interrupt. */
+typedef void (*CB_AUDIO_COMMIT)(void *, uint8_t *, uint32_t);
+
+/** Frames buffered in the sink that have not been played yet */
+typedef uint32_t (*CB_AUDIO_GET_LEVEL)(void *);
+
+/** Host changed mute or volume, volume in 1/256 dB units */
+typedef void (*CB_AUDIO_VOLUME)(void *, BOOL, int16_t);
+
+/** Where the audio goes, set with CTL_USBF_SET_AUDIO_SINK */
+typedef struct
+{
+    CB_AUDIO_GET_BUFFER     p_get_buffer;
+    CB_AUDIO_COMMIT         p_commit;
+    CB_AUDIO_GET_LEVEL      p_get_level;
+    CB_AUDIO_VOLUME         p_volume;
+
+    /** Frames played by the output, advanced by its DMA completion */
+    volatile uint32_t       *p_frames_played;
+
+    /** Level in frames the feedback steers towards */
+    uint32_t                target_level;
+
+    void                    *p_context;
+} st_usbf_audio_sink_t;
+
+/** Returned by CTL_USBF_GET_AUDIO_STATS */
+typedef struct
+{
+    /** Host has selected the streaming alternate setting */
+    BOOL        streaming;
+
+    uint32_t    packets;
+    uint32_t    bytes;
+
+    /** Frames thrown away because the sink was full */
+    uint32_t    dropped;
+    uint32_t    fifo_errors;
+
+    /** Last value sent on the feedback endpoint, frames per ms in 10.14 */
+    uint32_t    feedback;
+
+    /** Measured output rate, frames per ms in 16.16 */
+    uint32_t    rate;
+
+    /** Frames buffered in the sink at the last feedback */
+    uint32_t    level;
+
+    BOOL        mute;
+    int16_t     volume;
+} st_usbf_audio_stats_t;
+
+/******************************************************************************
+Function Prototypes
+******************************************************************************/
+
+/**
+ * @brief              Initialise this module and the USB Core layer.
+ *                     This must be called once before using any of the
+ *                     other API functions.
+ *
+ * @param[in]          _pchannel: current peripheral
+ *
+ * @retval             USB_ERR_OK: If Successful
+*/
+usb_err_t R_USB_AudioInit(volatile st_usb_object_t *_pchannel);
+
+/**
+ * @brief              Set where received audio is written. A NULL sink
+ *                     drops the audio but keeps the stream running.
+ *                     Must not be called while the USB interrupt can run.
+ *
+ * @param[in]          _psink: Sink callbacks, copied.
+*/
+void R_USB_AudioSetSink(const st_usbf_audio_sink_t *_psink);
+
+/**
+ * @brief              Get the USB cable connected state.
+ *
+ * @retval             TRUE:  Connected
+ * @retval             FALSE: Disconnected.
+*/
+BOOL R_USB_AudioIsConnected(volatile st_usb_object_t *_pchannel);
+
+/**
+ * @brief              Copy the stream counters.
+ *
+ * @param[out]         _pstats: Counters.
+*/
+void R_USB_AudioGetStats(st_usbf_audio_stats_t *_pstats);
+
+/**
+ * @brief              Stop streaming and reset the HAL.
+ *
+ * @retval             USB_ER_CODE: Error code.
+*/
+usb_err_t R_USB_AudioCancel(volatile st_usb_object_t *_pchannel);
+
+#endif /* USB_AUDIO_H */
+/**************************************************************************//**
+ * @} (end addtogroup)
+ *****************************************************************************/
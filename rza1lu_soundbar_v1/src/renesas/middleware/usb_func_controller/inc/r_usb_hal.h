@@ -125,6 +125,26 @@ usb_err_t R_USB_HalInterruptIn(volatile st_usb_object_t *_pchannel,
                               const uint8_t* _pbuffer,
                               CB_DONE _CBDone);
 
+/*Isochronous - OUT on PIPE1, IN on PIPE2*/
+usb_err_t R_USB_HalIsocOutStart(volatile st_usb_object_t *_pchannel,
+                                CB_ISOC_OUT _CBData);
+
+uint16_t R_USB_HalIsocOutRead(volatile st_usb_object_t *_pchannel,
+                              uint8_t* _pbuffer,
+                              uint16_t _num_bytes);
+
+usb_err_t R_USB_HalIsocInStart(volatile st_usb_object_t *_pchannel,
+                               CB_ISOC_IN _CBReady);
+
+usb_err_t R_USB_HalIsocInWrite(volatile st_usb_object_t *_pchannel,
+                               uint16_t _num_bytes,
+                               const uint8_t* _pbuffer);
+
+void R_USB_HalIsocStop(volatile st_usb_object_t *_pchannel);
+
+/*Frame number of the last SOF*/
+uint16_t R_USB_HalGetFrameNumber(volatile st_usb_object_t *_pchannel);
+
 /*Cancel all pending operations and call callbacks*/
 usb_err_t R_USB_HalCancel(volatile st_usb_object_t *_pchannel);
 
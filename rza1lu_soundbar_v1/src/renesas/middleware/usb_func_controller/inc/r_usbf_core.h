@@ -175,6 +175,12 @@ typedef void(*CB_DONE)(usb_err_t);
 
 typedef void(*CB_REPORT_OUT)(uint8_t(*)[]);
 
+/*Isochronous OUT packet waiting in the FIFO, returns the bytes read from it*/
+typedef uint16_t(*CB_ISOC_OUT)(volatile void *, usb_err_t, uint16_t);
+
+/*Isochronous IN pipe ready for the next packet*/
+typedef void(*CB_ISOC_IN)(volatile void *);
+
 typedef enum
 {
     USBF_NORMAL = 0,
@@ -198,6 +204,8 @@ typedef struct
     CB_DONE_OUT p_cb_bout_mfpdone;
     CB_DONE_BULK_IN     p_cb_bin_mfpdone;
     CB_DONE     p_cb_iin_mfpdone;
+    CB_ISOC_OUT p_cb_isoc_out;
+    CB_ISOC_IN  p_cb_isoc_in;
 }st_usbf_p_callbacks_t;
 
 
@@ -0,0 +1,94 @@
+/******************************************************************************
+* DISCLAIMER                                                                      
+* This software is supplied by Renesas Electronics Corporation and is only
+* intended for use with Renesas products. No other uses are authorized.
+* This software is owned by Renesas Electronics Corporation and is protected under
+* all applicable laws, including copyright laws.
+* THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES
+* REGARDING THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+* INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NON-INFRINGEMENT.  ALL SUCH WARRANTIES ARE EXPRESSLY
+* DISCLAIMED.
+* TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+* ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+* FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES
+* FOR ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS
+* AFFILIATES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+* Renesas reserves the right, without notice, to make changes to this
+* software and to discontinue the availability of this software.  
+* By using this software, you agree to the additional terms and
+* conditions found by accessing the following link:
+* http://www.renesas.com/disclaimer
+******************************************************************************/
+/* Copyright (C) 2010 Renesas Electronics Corporation. All rights reserved.*/
+
+/******************************************************************************
+* File Name       : usb_audio_descriptors.h
+* Version         : 1.00
+* Device          : RZA1(H)
+* Tool Chain      : GNUARM-NONE-EABI v14.02
+* H/W Platform    : RZ/A1LU
+* Description     : Descriptors required to enumerate a device as a
+*                   USB Audio Class 2.0 full speed speaker.
+*
+*                   NOTE: This will need to be modified for a particular
+*                   product as it includes company/product specific data including
+*                   string descriptors specifying
+*                   Manufacturer, Product and Serial Number.
+******************************************************************************/
+
+/******************************************************************************
+* History         : 27.06.2018 Ver. 1.00 First Release
+******************************************************************************/
+
+#ifndef FILENAME_USB_AUDIO_DESCRIPTORS_H
+#define FILENAME_USB_AUDIO_DESCRIPTORS_H
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+/* Following header file provides rte type definitions. */
+#include "stdint.h"
+#include "r_usbf_core.h"
+#include "r_usb_audio.h"
+
+/******************************************************************************
+Macro Defines
+******************************************************************************/
+#define USBF_AUDIO_CONTROL_PACKET_SIZE      (64)
+
+/* Interfaces */
+#define USBF_AUDIO_IF_CONTROL               (0)
+#define USBF_AUDIO_IF_STREAMING             (1)
+
+/* Entity IDs used in class requests (wIndex high byte) */
+#define USBF_AUDIO_ID_INPUT_TERMINAL        (0x01)
+#define USBF_AUDIO_ID_FEATURE_UNIT          (0x02)
+#define USBF_AUDIO_ID_OUTPUT_TERMINAL       (0x03)
+#define USBF_AUDIO_ID_CLOCK_SOURCE          (0x10)
+
+/* Isochronous OUT, one packet per frame, room for 4 frames above
+   44.1 kHz so the host can follow the feedback */
+#define USBF_AUDIO_MAX_FRAMES_PER_PACKET    (49)
+#define USBF_AUDIO_DATA_PACKET_SIZE         (USBF_AUDIO_MAX_FRAMES_PER_PACKET * USBF_AUDIO_FRAME_BYTES)
+
+/* Feedback, 10.14 frames per ms in 3 bytes at full speed */
+#define USBF_AUDIO_FEEDBACK_SIZE            (3)
+#define USBF_AUDIO_FEEDBACK_PACKET_SIZE     (4)
+
+/******************************************************************************
+Type Definitions
+*******************************************************************************/
+
+/* Device Descriptor */
+extern const descriptor_t g_audio_device_descriptor;
+
+/* Configuration, Interface, Audio Class and Endpoint Descriptors */
+extern const descriptor_t g_audio_configuration_descriptor;
+
+/* String descriptors */
+extern const descriptor_t g_audio_string_desc_manufacturer;
+extern const descriptor_t g_audio_string_desc_product;
+extern const descriptor_t g_audio_string_desc_serial_num;
+
+#endif /* FILENAME_USB_AUDIO_DESCRIPTORS_H */
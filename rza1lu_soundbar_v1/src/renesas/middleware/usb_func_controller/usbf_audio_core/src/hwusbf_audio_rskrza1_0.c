@@ -0,0 +1,392 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ *******************************************************************************
+ * Copyright (C) 2018 Renesas Electronics Corporation. All rights reserved.
+ *******************************************************************************
+ * File Name    : hwusbf_audio_rskrza1_0
+ * Version      : 1.00
+ * Device(s)    : Renesas
+ * Tool-Chain   : GNUARM-NONE-EABI v14.02
+ * OS           : None
+ * H/W Platform : RSK+
+ * Description  : USB function Audio Class 2.0 driver hardware interface
+ *              : functions, Channel 0
+ *******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 27.06.2018 1.00 First Release
+ ******************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ ******************************************************************************/
+
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "iodefine_cfg.h"
+#include "r_intc.h"
+#include "r_task_priority.h"
+#include "r_devlink_wrapper.h"
+#include "rza_io_regrw.h"
+
+
+/*    Following header file provides definition common to Upper and Low Level USB
+    driver. */
+#include "usb_common.h"
+
+/*    Following header file provides definition for Low level driver. */
+#include "r_usb_hal.h"
+
+/*    Following header file provides definition for USB Audio function. */
+#include "r_usb_audio.h"
+
+#include "r_usbf_core.h"
+#include "trace.h"
+
+/* Comment this line out to turn ON module trace in this file */
+//#undef _TRACE_ON_
+
+#ifndef _TRACE_ON_
+#undef TRACE
+#define TRACE(x)
+#endif
+
+/******************************************************************************
+ Defines
+ ******************************************************************************/
+
+/* The root port control functions */
+#define GPIO_BIT_N1  (1u <<  1)
+
+/******************************************************************************
+ Function Prototypes
+ ******************************************************************************/
+
+static int_t  usbf_audio_open (st_stream_ptr_t pStream);
+static void   usbf_audio_close (st_stream_ptr_t pStream);
+static int_t  usbf_audio_no_io (st_stream_ptr_t pStream, uint8_t *pbyBuffer, uint32_t uiCount);
+static int_t  usbf_audio_control (st_stream_ptr_t pStream, uint32_t ctlCode, void *pCtlStruct);
+static void   usbf_audio_interrupt_handler_isr (uint32_t value);
+
+static volatile st_usb_object_t channel;
+static int_t           ref_count = 0;
+
+/* USB interrupt is registered and enabled */
+static bool_t          started = false;
+
+/******************************************************************************
+ Constant Data
+ ******************************************************************************/
+
+/* Define the driver function table for this device */
+
+const st_r_driver_t g_usbf0_audio_driver =
+{ "USB Func Audio Port 0 Device Driver",
+   usbf_audio_open,
+   usbf_audio_close,
+   usbf_audio_no_io,
+   usbf_audio_no_io,
+   usbf_audio_control,
+   no_dev_get_version
+};
+
+
+/******************************************************************************
+ Global Variables
+ ******************************************************************************/
+
+/******************************************************************************
+ Public Functions
+ ******************************************************************************/
+
+/******************************************************************************
+ Private Functions
+ ******************************************************************************/
+
+/*******************************************************************************
+* Function Name: start_device
+* Description  : Initialises the Audio device. Full speed only, the
+*                isochronous endpoints are described for one packet per
+*                1 ms frame.
+* Arguments    : none
+* Return Value : none
+*******************************************************************************/
+static void start_device(void)
+{
+    rza_io_reg_write_8((uint8_t *)&CPG.STBCR7,
+                            0,
+                            CPG_STBCR7_MSTP71_SHIFT,
+                            CPG_STBCR7_MSTP71);
+
+    R_OS_TaskSleep(200);
+
+    /* USB VBUS VOLTAGE DISABLE : P7_1, Low Output */
+    GPIO.PIBC7  &= (uint16_t)(~(uint32_t)GPIO_BIT_N1);
+    GPIO.PBDC7  &= (uint16_t)(~(uint32_t)GPIO_BIT_N1);
+    GPIO.PM7    |=   (uint32_t)GPIO_BIT_N1;
+    GPIO.PMC7   &= (uint16_t)(~(uint32_t)GPIO_BIT_N1);
+    GPIO.PIPC7  &= (uint16_t)(~(uint32_t)GPIO_BIT_N1);
+
+    /* Do not supply 5 volts from the target to the PC/source */
+    GPIO.P7     &= (uint16_t)(~(uint32_t)GPIO_BIT_N1);
+    GPIO.PM7    &= (uint16_t)(~(uint32_t)GPIO_BIT_N1);
+
+    /* Full speed, the descriptors have no high speed configuration */
+    channel.hi_speed_enable = 0;
+
+    /*Initialise the USB Audio Class*/
+    if(USB_ERR_OK == R_USB_AudioInit(&channel))
+    {
+        /* Initialized USB interrupt set priority lvl*/
+        R_INTC_RegistIntFunc(INTC_ID_USBI0, usbf_audio_interrupt_handler_isr);
+        R_INTC_SetPriority(INTC_ID_USBI0, USBF_INTERRUPT_PRIORITY);
+        R_INTC_Enable(INTC_ID_USBI0);
+        started = true;
+    }
+}
+/*******************************************************************************
+End of function start_device
+*******************************************************************************/
+
+/*******************************************************************************
+* Function Name: stop_device
+* Description  : Disables the Audio device
+* Arguments    : none
+* Return Value : none
+*******************************************************************************/
+static void stop_device(void)
+{
+    /* USB cancel the stream */
+    R_USB_AudioCancel(&channel);
+
+    /* USB interrupt disable */
+    R_INTC_Disable(INTC_ID_USBI0);
+    started = false;
+
+    rza_io_reg_write_8((uint8_t *)&CPG.STBCR7,
+                            1,
+                            CPG_STBCR7_MSTP71_SHIFT,
+                            CPG_STBCR7_MSTP71);
+
+    R_INTC_SetPriority(INTC_ID_USBI0, ISR_ENTRY_UNUSED);
+
+    R_OS_TaskSleep(100);
+}
+/*******************************************************************************
+End of function stop_device
+*******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbf_audio_open
+ Description:   Function to open the audio function
+ Arguments:     IN  pStream - Pointer to the file stream
+ Return value:  0 for success otherwise -1
+ ******************************************************************************/
+static int_t usbf_audio_open (st_stream_ptr_t pStream)
+{
+    UNUSED_PARAM(pStream);
+
+    if(NULL == g_usb_devices_events[0])
+    {
+        eventCreate(g_usb_devices_events, R_USB_SUPPORTED_CHANNELS);
+    }
+
+    if(eventSet(g_usb_devices_events[0]))
+    {
+        if(0 == ref_count )
+        {
+            ref_count++;
+
+            memset((st_usb_object_t *)&channel,0,sizeof(channel));
+            R_USB_AudioSetSink(NULL);
+
+            channel.phwdevice = &USB200;
+
+            /* Reset peripheral */
+            rza_io_reg_write_8((uint8_t *)&CPG.STBCR7,
+                                  1,
+                                  CPG_STBCR7_MSTP71_SHIFT,
+                                  CPG_STBCR7_MSTP71);
+
+            return 0;
+        }
+        else
+        {
+            /* device in use */
+            eventReset(g_usb_devices_events[0]);
+            return -1;
+        }
+    }
+    else
+    {
+        /* low level peripheral in use */
+        return -1;
+    }
+}
+/******************************************************************************
+ End of function  usbf_audio_open
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbf_audio_close
+ Description:   Function to close the audio function
+ Arguments:     IN  pStream - Pointer to the file stream
+ Return value:  none
+ ******************************************************************************/
+static void usbf_audio_close (st_stream_ptr_t pStream)
+{
+    UNUSED_PARAM(pStream);
+
+    if(0 != ref_count )
+    {
+        ref_count--;
+
+        stop_device();
+        R_USB_AudioSetSink(NULL);
+        eventReset(g_usb_devices_events[0]);
+        memset((st_usb_object_t *)&channel,0,sizeof(channel));
+    }
+}
+/******************************************************************************
+ End of function  usbf_audio_close
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbf_audio_no_io
+ Description:   The audio goes to the sink set with CTL_USBF_SET_AUDIO_SINK,
+                there is nothing to read or write
+ Arguments:     IN  pStream - Pointer to the file stream
+                IN  pbyBuffer - Pointer to the memory
+                IN  uiCount - The number of bytes to transfer
+ Return value:  -1
+ ******************************************************************************/
+static int_t usbf_audio_no_io (st_stream_ptr_t pStream, uint8_t *pbyBuffer, uint32_t uiCount)
+{
+    UNUSED_PARAM(pStream);
+    UNUSED_PARAM(pbyBuffer);
+    UNUSED_PARAM(uiCount);
+
+    return -1;
+}
+/******************************************************************************
+ End of function  usbf_audio_no_io
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbf_audio_control
+ Description:   Function to handle custom control functions for the USB
+                audio function
+ Arguments:       IN  pStream - Pointer to the file stream
+                  IN  ctlCode    - The custom control code
+                  IN  pCtlStruct - Pointer to the custom control structure
+ Return value:   0 or greater for success, -1 on error
+ ******************************************************************************/
+static int_t usbf_audio_control (st_stream_ptr_t pStream, uint32_t ctlCode, void *pCtlStruct)
+{
+    int_t ret = 0;
+
+    /* File stream is not used */
+    (void) pStream;
+
+    if (ref_count)
+    {
+        switch(ctlCode)
+        {
+            case CTL_USBF_IS_CONNECTED:
+            {
+                ret = R_USB_AudioIsConnected(&channel);
+            }
+            break;
+            case CTL_USBF_START:
+            {
+                start_device();
+            }
+            break;
+            case CTL_USBF_STOP:
+            {
+                stop_device();
+            }
+            break;
+            case CTL_USBF_SET_AUDIO_SINK:
+            {
+                /* The sink is used in the USB interrupt */
+                if(started)
+                {
+                    R_INTC_Disable(INTC_ID_USBI0);
+                }
+                R_USB_AudioSetSink((const st_usbf_audio_sink_t *)pCtlStruct);
+                if(started)
+                {
+                    R_INTC_Enable(INTC_ID_USBI0);
+                }
+            }
+            break;
+            case CTL_USBF_GET_AUDIO_STATS:
+            {
+                if(NULL == pCtlStruct)
+                {
+                    ret = -1;
+                }
+                else
+                {
+                    R_USB_AudioGetStats((st_usbf_audio_stats_t *)pCtlStruct);
+                }
+            }
+            break;
+            default:
+            {
+                ret = -1;
+            }
+        }
+    }
+    return ret;
+}
+/******************************************************************************
+ End of function  usbf_audio_control
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbf_audio_interrupt_handler_isr
+ Description:   Function to handle peripheral interrupts
+ Arguments:     value - associated data may not be used
+ Return value:  none
+ ******************************************************************************/
+static void   usbf_audio_interrupt_handler_isr (uint32_t value)
+{
+    value = 0;
+
+    if(value != (uint32_t)ref_count)
+    {
+        R_USB_HalIsr(&channel);
+    }
+}
+/*******************************************************************************
+End of function usbf_audio_interrupt_handler_isr
+*******************************************************************************/
+
+/******************************************************************************
+ End  Of File
+ ******************************************************************************/
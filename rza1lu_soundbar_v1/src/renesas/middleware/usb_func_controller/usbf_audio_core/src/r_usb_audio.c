@@ -0,0 +1,966 @@
+/******************************************************************************
+* DISCLAIMER                                                                      
+* This software is supplied by Renesas Electronics Corporation and is only
+* intended for use with Renesas products. No other uses are authorized.
+* This software is owned by Renesas Electronics Corporation and is protected under
+* all applicable laws, including copyright laws.
+* THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES
+* REGARDING THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+* INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NON-INFRINGEMENT.  ALL SUCH WARRANTIES ARE EXPRESSLY
+* DISCLAIMED.
+* TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+* ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+* FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES
+* FOR ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS
+* AFFILIATES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+* Renesas reserves the right, without notice, to make changes to this
+* software and to discontinue the availability of this software.  
+* By using this software, you agree to the additional terms and
+* conditions found by accessing the following link:
+* http://www.renesas.com/disclaimer
+******************************************************************************/
+/* Copyright (C) 2010 Renesas Electronics Corporation. All rights reserved.*/
+
+/******************************************************************************
+* File Name      : r_usb_audio.c
+* Version        : 1.00
+* Device         : RZA1(H)
+* Tool Chain     : GNUARM-NONE-EABI v14.02
+* H/W Platform   : RZ/A1LU
+* Description    : USB Audio Class 2.0 function, asynchronous speaker.
+*                  Isochronous OUT packets are read from the FIFO straight
+*                  into the sink buffer in the BRDY interrupt. The feedback
+*                  endpoint reports the rate the sink actually plays at,
+*                  measured from its frame counter against the USB frame
+*                  number, with a correction that pulls the buffered level
+*                  towards the sink's target.
+******************************************************************************/
+
+/******************************************************************************
+* History         : 27.06.2018 Ver. 1.00 First Release
+******************************************************************************/
+
+/******************************************************************************
+System Includes
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+
+#include "compiler_settings.h"
+
+/*    Following header file provides definition common to Upper and Low Level USB 
+    driver. */
+#include "usb_common.h"
+/*    Following header file provides definition for Low level driver. */
+#include "r_usb_hal.h"
+/*    Following header file provides definition for usb_core.c. */
+#include "r_usbf_core.h"
+/*    Following header file provides USB descriptor information. */
+#include "usb_audio_descriptors.h"
+/*    Following header file provides definition for USB Audio function. */
+#include "r_usb_audio.h"
+
+/******************************************************************************
+Macros Defines
+******************************************************************************/
+/* Audio Class 2.0 request codes */
+#define AUDIO_REQUEST_CUR           (0x01)
+#define AUDIO_REQUEST_RANGE         (0x02)
+
+/* Clock source control selectors */
+#define AUDIO_CS_SAM_FREQ_CONTROL   (0x01)
+#define AUDIO_CS_CLOCK_VALID_CONTROL (0x02)
+
+/* Feature unit control selectors */
+#define AUDIO_FU_MUTE_CONTROL       (0x01)
+#define AUDIO_FU_VOLUME_CONTROL     (0x02)
+
+/* Reply sizes */
+#define AUDIO_CUR_4_SIZE            (4)
+#define AUDIO_CUR_2_SIZE            (2)
+#define AUDIO_CUR_1_SIZE            (1)
+#define AUDIO_RANGE_4_SIZE          (14)
+#define AUDIO_RANGE_2_SIZE          (8)
+
+/* Buffers of the isochronous pipes, 64 byte blocks */
+#define ENDPOINT_1_BUFFER_SIZE      (448)
+#define ENDPOINT_2_BUFFER_SIZE      (64)
+
+/* The Endpoint 6,7,8,9 are not used but the table has to cover them */
+#define ENDPOINT_6_7_PACKET_SIZE    (64)
+#define ENDPOINT_8_9_PACKET_SIZE    (64)
+
+/* Nominal frames per ms in 16.16 */
+#define FEEDBACK_NOMINAL            ((uint32_t)(((uint64_t)USBF_AUDIO_SAMPLE_RATE << 16) / 1000u))
+
+/* The host will not follow more than one frame per ms either side */
+#define FEEDBACK_LIMIT              (0x00010000ul)
+
+/* 16.16 per frame of level error, 1024 frames away from the target asks
+   for one frame per ms more or less */
+#define FEEDBACK_LEVEL_GAIN         (64)
+
+/* The output frame counter moves a DMA period at a time, the rate is
+   measured between two of its steps at least this far apart */
+#define FEEDBACK_RATE_WINDOW_MS     (2048u)
+
+/******************************************************************************
+Global Variables
+******************************************************************************/
+
+/* End point configuration array Audio */
+static volatile uint16_t  end_ptbl_1[] =
+{
+    PIPE1 |                                                /* Pipe Window Select Register (0x64)  */
+    C_FIFO_USE,                                            /* This macro specifies the register to
+                                                              be used to read from the FIFO buffer
+                                                              memory and write data to the FIFO
+                                                              buffer memory */
+    (((ISO | DBLBON) | DIR_P_OUT) | EP1),                  /* Pipe Configuration Register (0x68)  */
+    BUF_SIZE(ENDPOINT_1_BUFFER_SIZE) | 16,                 /* Pipe Buffer setting Register (0x6A) */
+    USBF_AUDIO_DATA_PACKET_SIZE,                           /* Pipe Maxpacket Size Register (0x6C) */
+    0,                                                     /* Pipe Cycle Control Register (0x6E)  */
+
+    PIPE2 |                                                /* Pipe Window Select Register (0x64)  */
+    C_FIFO_USE,                                            /* This macro specifies the register to
+                                                              be used to read from the FIFO buffer
+                                                              memory and write data to the FIFO
+                                                              buffer memory */
+    (((ISO | DBLBOFF) | DIR_P_IN) | EP2),                  /* Pipe Configuration Register (0x68)  */
+    BUF_SIZE(ENDPOINT_2_BUFFER_SIZE) | 36,                 /* Pipe Buffer setting Register (0x6A) */
+    USBF_AUDIO_FEEDBACK_PACKET_SIZE,                       /* Pipe Maxpacket Size Register (0x6C) */
+    0,                                                     /* Pipe Cycle Control Register (0x6E)  */
+
+    PIPE3 |                                                /* Pipe Window Select Register (0x64)  */
+    D0_FIFO_USE,                                           /* This macro specifies the register to
+                                                              be used to read from the FIFO buffer
+                                                              memory and write data to the FIFO
+                                                              buffer memory */
+    ((((BULK | DBLBON) | CNTMDOFF) | DIR_P_IN) | EP3),     /* Pipe Configuration Register (0x68)  */
+    BUF_SIZE(BULK_IN_PACKET_SIZE) | 57,                    /* Pipe Buffer setting Register (0x6A) */
+    BULK_IN_PACKET_SIZE,                                   /* Pipe Maxpacket Size Register (0x6C) */
+    0,                                                     /* Pipe Cycle Control Register (0x6E)  */
+
+    PIPE4 |                                                /* Pipe Window Select Register (0x64)  */
+    D0_FIFO_USE,                                           /* This macro specifies the register to
+                                                              be used to read from the FIFO buffer
+                                                              memory and write data to the FIFO
+                                                              buffer memory */
+    ((((BULK | DBLBON) | CNTMDOFF) | DIR_P_OUT) | EP4),    /* Pipe Configuration Register (0x68)  */
+    BUF_SIZE(BULK_OUT_PACKET_SIZE) | 77,                   /* Pipe Buffer setting Register (0x6A) */
+    BULK_OUT_PACKET_SIZE,                                  /* Pipe Maxpacket Size Register (0x6C) */
+    0,                                                     /* Pipe Cycle Control Register (0x6E)  */
+
+    PIPE5 |                                                /* Pipe Window Select Register (0x64)  */
+    D0_FIFO_USE,                                           /* This macro specifies the register to
+                                                              be used to read from the FIFO buffer
+                                                              memory and write data to the FIFO
+                                                              buffer memory */
+    ((((BULK | DBLBOFF) | CNTMDOFF) | DIR_P_IN) | EP5),    /* Pipe Configuration Register (0x68)  */
+    BUF_SIZE(BULK_IN_PACKET_SIZE) | 98,                    /* Pipe Buffer setting Register (0x6A) */
+    BULK_IN_PACKET_SIZE,                                   /* Pipe Maxpacket Size Register (0x6C) */
+    0,                                                     /* Pipe Cycle Control Register (0x6E)  */
+
+    PIPE6,                                                 /* Pipe Window Select Register (0x64)  */
+    ((INT | DIR_P_IN) | EP6),                              /* Pipe Configuration Register (0x68)  */
+    BUF_SIZE(ENDPOINT_6_7_PACKET_SIZE) | 4,                /* Pipe Buffer setting Register (0x6A) */
+    INTERRUPT_IN_PACKET_SIZE,                              /* Pipe Maxpacket Size Register (0x6C) */
+    0,                                                     /* Pipe Cycle Control Register (0x6E)  */
+
+    PIPE7,                                                 /* Pipe Window Select Register (0x64)  */
+    ((INT | DIR_P_OUT) | EP7),                             /* Pipe Configuration Register (0x68)  */
+    BUF_SIZE(ENDPOINT_6_7_PACKET_SIZE) | 5,                /* Pipe Buffer setting Register (0x6A) */
+    INTERRUPT_IN_PACKET_SIZE,                              /* Pipe Maxpacket Size Register (0x6C) */
+    0,                                                     /* Pipe Cycle Control Register (0x6E)  */
+
+    PIPE8,                                                 /* Pipe Window Select Register (0x64)  */
+    ((INT | DIR_P_IN) | EP9),                              /* Pipe Configuration Register (0x68)  */
+    BUF_SIZE(ENDPOINT_8_9_PACKET_SIZE) | 6,                /* Pipe Buffer setting Register (0x6A) */
+    INTERRUPT_IN_PACKET_SIZE,                              /* Pipe Maxpacket Size Register (0x6C) */
+    0,                                                     /* Pipe Cycle Control Register (0x6E) */
+
+    PIPE9,                                                 /* Pipe Window Select Register (0x64) */
+    ((INT | DIR_P_IN) | EP9),                              /* Pipe Configuration Register (0x68) */
+    BUF_SIZE(ENDPOINT_8_9_PACKET_SIZE) | 7,                /* Pipe Buffer setting Register (0x6A) */
+    INTERRUPT_IN_PACKET_SIZE,                              /* Pipe Maxpacket Size Register (0x6C) */
+    0,                                                     /* Pipe Cycle Control Register (0x6E) */
+};
+
+/* Configuration 2 */
+static volatile uint16_t  end_ptbl_2[] = { 0 };
+
+/* Configuration 3 */
+static volatile uint16_t  end_ptbl_3[] = { 0 };
+
+/* Configuration 4 */
+static volatile uint16_t  end_ptbl_4[] = { 0 };
+
+/* Configuration 5 */
+static volatile uint16_t  end_ptbl_5[] = { 0 };
+
+/* Where the audio goes */
+static st_usbf_audio_sink_t sink;
+
+/* Counters returned by R_USB_AudioGetStats */
+static st_usbf_audio_stats_t stats;
+
+/* Cable state */
+static volatile BOOL connected = FALSE;
+
+/* Peripheral given to R_USB_AudioInit, the error callback is not passed it */
+static volatile st_usb_object_t *audio_channel = NULL;
+
+/* Alternate setting of the streaming interface */
+static uint8_t alt_setting = 0;
+
+/* Data stage of class requests, word aligned for the FIFO */
+static uint32_t control_buffer[4];
+
+/* Feedback, 10.14 in 3 bytes */
+static uint32_t feedback_packet;
+
+/* USB frame number extended to a free running ms count */
+static uint16_t frame_last;
+static uint32_t frame_ms;
+
+/* Rate measurement of the sink's output */
+static BOOL     rate_valid;
+static uint32_t played_last;
+static uint32_t window_frames;
+static uint32_t window_ms;
+
+/******************************************************************************
+Function Prototypes
+******************************************************************************/
+static uint16_t initialise_data(volatile st_usb_object_t *_pchannel);
+static void start_streaming(volatile st_usb_object_t *_pchannel);
+static void stop_streaming(volatile st_usb_object_t *_pchannel);
+static usb_err_t process_standard_setup_packet(volatile st_usb_object_t *_pchannel,
+                                               setup_packet_t* _pSetupPacket,
+                                               uint16_t* _pNumBytes,
+                                               uint8_t** _ppBuffer);
+static usb_err_t process_class_setup_packet(volatile st_usb_object_t *_pchannel,
+                                            setup_packet_t* _pSetupPacket,
+                                            uint16_t* _pNumBytes,
+                                            uint8_t** _ppBuffer);
+
+/*Callbacks required by USB CORE*/
+static usb_err_t cb_unhandled_setup_packet(volatile st_usb_object_t *_pchannel,
+                                           setup_packet_t* _pSetupPacket,
+                                           uint16_t* _pNumBytes,
+                                           uint8_t** _ppBuffer);
+
+static void cb_done_control_out(volatile st_usb_object_t *_pchannel, usb_err_t _err, uint32_t _num_bytes);
+static uint16_t cb_isoc_out(volatile st_usb_object_t *_pchannel, usb_err_t _err, uint16_t _num_bytes);
+static void cb_feedback_in(volatile st_usb_object_t *_pchannel);
+static void cb_error(usb_err_t _err);
+static void cb_cable(volatile st_usb_object_t *_pchannel, BOOL _bConnected);
+
+/******************************************************************************
+User Program Code
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :   R_USB_AudioInit
+* Description     :   Initialise this module.
+*                     This must be called once before using any of the
+*                     other API functions.
+*                     Initialise the USB Core layer. The device is full
+*                     speed only so there is no qualifier or other speed
+*                     configuration.
+* Argument        :   _pchannel: current peripheral
+* Return value    :   - USB_ERR_OK
+*****************************************************************************/
+usb_err_t R_USB_AudioInit(volatile st_usb_object_t *_pchannel)
+{
+    _pchannel->err =  USB_ERR_OK;
+    audio_channel = _pchannel;
+
+    /* Initialise the data */
+    if(initialise_data(_pchannel))
+    {
+        /*Initialise the USB core*/
+        _pchannel->err = R_USBF_CoreInit(_pchannel,
+                       g_audio_string_desc_manufacturer.puc_data,
+                       g_audio_string_desc_manufacturer.length,
+                       g_audio_string_desc_product.puc_data,
+                       g_audio_string_desc_product.length,
+                       g_audio_string_desc_serial_num.puc_data,
+                       g_audio_string_desc_serial_num.length,
+                       g_audio_device_descriptor.puc_data,
+                       g_audio_device_descriptor.length,
+                       NULL,
+                       0,
+                       g_audio_configuration_descriptor.puc_data,
+                       g_audio_configuration_descriptor.length,
+                       NULL,
+                       0,
+                       (CB_SETUP_PACKET)cb_unhandled_setup_packet,
+                       (CB_DONE_OUT)cb_done_control_out,
+                       (CB_CABLE)cb_cable,
+                       cb_error);
+    }
+
+    return _pchannel->err;
+}
+/******************************************************************************
+End of function R_USB_AudioInit
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :   R_USB_AudioSetSink
+* Description     :   Set where received audio is written.
+* Argument        :   _psink: Sink, copied. NULL drops the audio.
+* Return value    :   -
+*****************************************************************************/
+void R_USB_AudioSetSink(const st_usbf_audio_sink_t *_psink)
+{
+    if(NULL == _psink)
+    {
+        memset(&sink, 0, sizeof(sink));
+    }
+    else
+    {
+        sink = *_psink;
+
+        /* Tell the new sink what the host last asked for */
+        if(NULL != sink.p_volume)
+        {
+            sink.p_volume(sink.p_context, stats.mute, stats.volume);
+        }
+    }
+    rate_valid = FALSE;
+}
+/******************************************************************************
+End of function R_USB_AudioSetSink
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :    R_USB_AudioIsConnected
+* Description     :    Get the USB cable connected state.
+* Argument        :    -
+* Return value    :    TRUE = Connected, FALSE = Disconnected.
+*****************************************************************************/
+BOOL R_USB_AudioIsConnected(volatile st_usb_object_t *_pchannel)
+{
+    (void) _pchannel;
+    return connected;
+}
+/******************************************************************************
+End of function R_USB_AudioIsConnected
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :    R_USB_AudioGetStats
+* Description     :    Copy the stream counters.
+* Argument        :    _pstats: (OUT) counters.
+* Return value    :    -
+*****************************************************************************/
+void R_USB_AudioGetStats(st_usbf_audio_stats_t *_pstats)
+{
+    *_pstats = stats;
+}
+/******************************************************************************
+End of function R_USB_AudioGetStats
+******************************************************************************/
+
+/******************************************************************************
+* Function Name   :    R_USB_AudioCancel
+* Description     :    Stop streaming and reset the HAL.
+* Return value    :    Error code.
+******************************************************************************/
+usb_err_t R_USB_AudioCancel(volatile st_usb_object_t * _pchannel)
+{
+    _pchannel->err = USB_ERR_OK;
+
+    stop_streaming(_pchannel);
+
+    /*Reset HAL*/
+    _pchannel->err = R_USB_HalReset(_pchannel);
+
+    return _pchannel->err;
+}
+/******************************************************************************
+End of function R_USB_AudioCancel
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :   start_streaming
+* Description     :   Host selected the streaming alternate setting, start
+*                     both isochronous pipes from a nominal feedback.
+* Argument        :   -
+* Return value    :   -
+*****************************************************************************/
+static void start_streaming(volatile st_usb_object_t *_pchannel)
+{
+    frame_last = R_USB_HalGetFrameNumber(_pchannel);
+    frame_ms = 0;
+    rate_valid = FALSE;
+    stats.rate = FEEDBACK_NOMINAL;
+    stats.streaming = TRUE;
+
+    R_USB_HalIsocOutStart(_pchannel, (CB_ISOC_OUT)cb_isoc_out);
+    R_USB_HalIsocInStart(_pchannel, (CB_ISOC_IN)cb_feedback_in);
+}
+/******************************************************************************
+End of function start_streaming
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :   stop_streaming
+* Description     :   Host selected the zero bandwidth alternate setting or
+*                     went away.
+* Argument        :   -
+* Return value    :   -
+*****************************************************************************/
+static void stop_streaming(volatile st_usb_object_t *_pchannel)
+{
+    R_USB_HalIsocStop(_pchannel);
+    alt_setting = 0;
+    stats.streaming = FALSE;
+}
+/******************************************************************************
+End of function stop_streaming
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :   cb_isoc_out
+* Description     :   A packet of audio is waiting in the FIFO. Whole frames
+*                     are read straight into the sink, in two parts when it
+*                     wraps. Whatever does not fit is counted and left for
+*                     the HAL to discard.
+*                     This is a function of type CB_ISOC_OUT.
+* Argument        :   _err - Error code.
+*                     _num_bytes - Size of the packet.
+* Return value    :   Number of bytes read from the FIFO.
+*****************************************************************************/
+static uint16_t cb_isoc_out(volatile st_usb_object_t *_pchannel, usb_err_t _err, uint16_t _num_bytes)
+{
+    uint16_t read = 0;
+    uint16_t frames_bytes;
+    uint16_t chunk;
+    uint32_t space;
+    uint8_t *pbuffer;
+    uint8_t part;
+
+    if(USB_ERR_OK != _err)
+    {
+        stats.fifo_errors++;
+        return 0;
+    }
+
+    stats.packets++;
+    stats.bytes += _num_bytes;
+    frames_bytes = (uint16_t)(_num_bytes - (_num_bytes % USBF_AUDIO_FRAME_BYTES));
+
+    if((NULL != sink.p_get_buffer) && (NULL != sink.p_commit))
+    {
+        for(part = 0; (part < 2) && (read < frames_bytes); part++)
+        {
+            pbuffer = sink.p_get_buffer(sink.p_context, &space);
+            if(NULL == pbuffer)
+            {
+                break;
+            }
+
+            space -= (space % USBF_AUDIO_FRAME_BYTES);
+            chunk = (uint16_t)(frames_bytes - read);
+            if(chunk > space)
+            {
+                chunk = (uint16_t)space;
+            }
+            if(0 == chunk)
+            {
+                break;
+            }
+
+            R_USB_HalIsocOutRead(_pchannel, pbuffer, chunk);
+            sink.p_commit(sink.p_context, pbuffer, chunk);
+            read = (uint16_t)(read + chunk);
+        }
+    }
+
+    stats.dropped += (uint32_t)((frames_bytes - read) / USBF_AUDIO_FRAME_BYTES);
+
+    return read;
+}
+/******************************************************************************
+End of function cb_isoc_out
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :   cb_feedback_in
+* Description     :   The host has taken the last feedback, load the next.
+*                     The rate is the sink's played frames over USB frames
+*                     between two steps of its counter, so the coarse steps
+*                     of a DMA period do not show up as jitter. The level
+*                     term then removes any offset that builds up.
+*                     This is a function of type CB_ISOC_IN.
+* Argument        :   -
+* Return value    :   -
+*****************************************************************************/
+static void cb_feedback_in(volatile st_usb_object_t *_pchannel)
+{
+    uint16_t frame;
+    uint32_t played;
+    int32_t  feedback;
+
+    frame = R_USB_HalGetFrameNumber(_pchannel);
+    frame_ms += (uint32_t)((uint16_t)(frame - frame_last) & BITFRNM);
+    frame_last = frame;
+
+    feedback = (int32_t)stats.rate;
+
+    if(NULL != sink.p_frames_played)
+    {
+        played = *sink.p_frames_played;
+        if(played != played_last)
+        {
+            played_last = played;
+            if(FALSE == rate_valid)
+            {
+                window_frames = played;
+                window_ms = frame_ms;
+                rate_valid = TRUE;
+            }
+            else if((frame_ms - window_ms) >= FEEDBACK_RATE_WINDOW_MS)
+            {
+                stats.rate = (uint32_t)(((uint64_t)(played - window_frames) << 16) / (frame_ms - window_ms));
+                window_frames = played;
+                window_ms = frame_ms;
+            }
+            else
+            {
+                /* Keep measuring */
+                ;
+            }
+        }
+    }
+
+    if(NULL != sink.p_get_level)
+    {
+        stats.level = sink.p_get_level(sink.p_context);
+        feedback += ((int32_t)sink.target_level - (int32_t)stats.level) * FEEDBACK_LEVEL_GAIN;
+    }
+
+    if(feedback > (int32_t)(FEEDBACK_NOMINAL + FEEDBACK_LIMIT))
+    {
+        feedback = (int32_t)(FEEDBACK_NOMINAL + FEEDBACK_LIMIT);
+    }
+    if(feedback < (int32_t)(FEEDBACK_NOMINAL - FEEDBACK_LIMIT))
+    {
+        feedback = (int32_t)(FEEDBACK_NOMINAL - FEEDBACK_LIMIT);
+    }
+
+    /* 16.16 to 10.14, sent little endian */
+    stats.feedback = ((uint32_t)feedback) >> 2;
+    ((uint8_t *)&feedback_packet)[0] = (uint8_t)(stats.feedback & 0xFF);
+    ((uint8_t *)&feedback_packet)[1] = (uint8_t)((stats.feedback >> 8) & 0xFF);
+    ((uint8_t *)&feedback_packet)[2] = (uint8_t)((stats.feedback >> 16) & 0xFF);
+
+    R_USB_HalIsocInWrite(_pchannel, USBF_AUDIO_FEEDBACK_SIZE, (uint8_t *)&feedback_packet);
+}
+/******************************************************************************
+End of function cb_feedback_in
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :   cb_cable
+* Description     :   Callback when the USB cable is connected or disconnected.
+* Argument        :   _bConnected: TRUE = Connected, FALSE = Disconnected.
+* Return value    :   -
+*****************************************************************************/
+static void cb_cable(volatile st_usb_object_t *_pchannel, BOOL _bConnected)
+{
+    if(TRUE == _bConnected)
+    {
+        DEBUG_MSG_HIGH( ("USBAUDIO: Cable Connected\r\n"));
+
+        /* Initialise data - as this is like re-starting */
+        initialise_data(_pchannel);
+
+        connected = TRUE;
+    }
+    else
+    {
+        DEBUG_MSG_HIGH( ("USBAUDIO: Cable Disconnected\r\n"));
+        connected = FALSE;
+
+        stop_streaming(_pchannel);
+    }
+}
+/******************************************************************************
+End of function cb_cable
+******************************************************************************/
+
+/******************************************************************************
+* Function Name   :   cb_error
+* Description     :   Callback saying that an error has occurred in a
+*                     lower layer.
+* Argument        :   _err - error code.
+* Return value    :   -
+*****************************************************************************/
+static void cb_error(usb_err_t _err)
+{
+    DEBUG_MSG_HIGH(("USBAUDIO: ***cb_error***\r\n"));
+
+    if(USB_ERR_BULK_OUT_NO_BUFFER == _err)
+    {
+        DEBUG_MSG_HIGH(("USBAUDIO: No Buffer.\r\n"));
+    }
+    else if(NULL != audio_channel)
+    {
+        stop_streaming(audio_channel);
+
+        /*Try resetting HAL*/
+        R_USB_HalReset(audio_channel);
+
+        /* configure and Reset Endpoints */
+        R_USB_HalResetEp(audio_channel, 1);
+    }
+}
+/******************************************************************************
+End of function cb_error
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :   cb_unhandled_setup_packet
+* Description     :   Called from the USB Core when it can't deal with
+*                     a setup packet, or first for SET_INTERFACE and
+*                     GET_INTERFACE as the alternate settings are ours.
+*                     Provides a buffer if there is a data stage.
+*                     This is a function of type CB_SETUP_PACKET.
+* Argument        :   _pSetupPacket - Setup packet.
+*                     _pNumBytes - (OUT)Buffer size.
+*                     _ppBuffer - (OUT)Buffer.
+* Return value    :    Error code
+*****************************************************************************/
+static usb_err_t cb_unhandled_setup_packet(volatile st_usb_object_t *_pchannel,
+                                           setup_packet_t* _pSetupPacket,
+                                           uint16_t* _pNumBytes,
+                                           uint8_t** _ppBuffer)
+{
+    _pchannel->err = USB_ERR_OK;
+
+    switch(_pSetupPacket->bm_request.bit_val.d65)
+    {
+        case REQUEST_STANDARD:
+        {
+            _pchannel->err = process_standard_setup_packet(_pchannel, _pSetupPacket, _pNumBytes, _ppBuffer);
+            break;
+        }
+        case REQUEST_CLASS:
+        {
+            _pchannel->err = process_class_setup_packet(_pchannel, _pSetupPacket, _pNumBytes, _ppBuffer);
+            break;
+        }
+        case REQUEST_VENDOR:
+        default:
+        {
+            DEBUG_MSG_HIGH(("USBAUDIO: Unsupported Request type\r\n"));
+            _pchannel->err = USB_ERR_UNKNOWN_REQUEST;
+        }
+    }
+
+    return _pchannel->err;
+}
+/******************************************************************************
+End of function cb_unhandled_setup_packet
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :   process_standard_setup_packet
+* Description     :   Selects the alternate setting of the streaming
+*                     interface, which starts and stops the stream.
+* Argument        :   _pSetupPacket - Setup packet.
+*                     _pNumBytes - (OUT)Buffer size.
+*                     _ppBuffer - (OUT)Buffer.
+* Return value    :   Error code
+*****************************************************************************/
+static usb_err_t process_standard_setup_packet(volatile st_usb_object_t *_pchannel,
+                                               setup_packet_t* _pSetupPacket,
+                                               uint16_t* _pNumBytes,
+                                               uint8_t** _ppBuffer)
+{
+    _pchannel->err = USB_ERR_OK;
+
+    switch(_pSetupPacket->b_request)
+    {
+        case SET_INTERFACE:
+        {
+            *_pNumBytes = 0;
+
+            if(USBF_AUDIO_IF_STREAMING == _pSetupPacket->w_index)
+            {
+                if(1 == _pSetupPacket->w_value)
+                {
+                    DEBUG_MSG_HIGH(("USBAUDIO: Streaming\r\n"));
+                    if(1 != alt_setting)
+                    {
+                        start_streaming(_pchannel);
+                        alt_setting = 1;
+                    }
+                }
+                else if(0 == _pSetupPacket->w_value)
+                {
+                    DEBUG_MSG_HIGH(("USBAUDIO: Idle\r\n"));
+                    stop_streaming(_pchannel);
+                }
+                else
+                {
+                    _pchannel->err = USB_ERR_UNKNOWN_REQUEST;
+                }
+            }
+            else if((USBF_AUDIO_IF_CONTROL != _pSetupPacket->w_index) || (0 != _pSetupPacket->w_value))
+            {
+                _pchannel->err = USB_ERR_UNKNOWN_REQUEST;
+            }
+            else
+            {
+                /* Control interface has only alternate setting 0 */
+                ;
+            }
+            break;
+        }
+        case GET_INTERFACE:
+        {
+            ((uint8_t *)control_buffer)[0] = (USBF_AUDIO_IF_STREAMING == _pSetupPacket->w_index) ? alt_setting : 0;
+            *_pNumBytes = 1;
+            *_ppBuffer = (uint8_t *)control_buffer;
+            break;
+        }
+        default:
+        {
+            _pchannel->err = USB_ERR_UNKNOWN_REQUEST;
+        }
+    }
+
+    return _pchannel->err;
+}
+/******************************************************************************
+End of function process_standard_setup_packet
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :   process_class_setup_packet
+* Description     :   Processes the Audio Class 2.0 requests for the clock
+*                     source and the feature unit. The entity is in the
+*                     high byte of wIndex, the control selector in the high
+*                     byte of wValue and the channel in its low byte.
+*                     Provides a buffer if there is a data stage.
+* Argument        :   _pSetupPacket - Setup packet.
+*                     _pNumBytes - (OUT)Buffer size.
+*                     _ppBuffer - (OUT)Buffer.
+* Return value    :   Error code
+*****************************************************************************/
+static usb_err_t process_class_setup_packet(volatile st_usb_object_t *_pchannel,
+                                            setup_packet_t* _pSetupPacket,
+                                            uint16_t* _pNumBytes,
+                                            uint8_t** _ppBuffer)
+{
+    uint8_t *pbuffer = (uint8_t *)control_buffer;
+    uint8_t entity = (uint8_t)(_pSetupPacket->w_index >> 8);
+    uint8_t selector = (uint8_t)(_pSetupPacket->w_value >> 8);
+    uint8_t channel = (uint8_t)(_pSetupPacket->w_value & 0xFF);
+    BOOL    get = (BOOL)_pSetupPacket->bm_request.bit_val.d7;
+
+    _pchannel->err = USB_ERR_UNKNOWN_REQUEST;
+    *_ppBuffer = pbuffer;
+    memset(control_buffer, 0, sizeof(control_buffer));
+
+    if((RECIPIENT_INTERFACE != _pSetupPacket->bm_request.bit_val.d40) ||
+       (USBF_AUDIO_IF_CONTROL != (_pSetupPacket->w_index & 0xFF)) || (0 != channel))
+    {
+        DEBUG_MSG_HIGH(("USBAUDIO: Unsupported Class request %d\r\n", _pSetupPacket->b_request));
+        return _pchannel->err;
+    }
+
+    if(USBF_AUDIO_ID_CLOCK_SOURCE == entity)
+    {
+        if((AUDIO_CS_SAM_FREQ_CONTROL == selector) && (AUDIO_REQUEST_CUR == _pSetupPacket->b_request))
+        {
+            /* Get reports the only rate, set is accepted and ignored */
+            pbuffer[0] = (uint8_t)(USBF_AUDIO_SAMPLE_RATE & 0xFF);
+            pbuffer[1] = (uint8_t)((USBF_AUDIO_SAMPLE_RATE >> 8) & 0xFF);
+            pbuffer[2] = (uint8_t)((USBF_AUDIO_SAMPLE_RATE >> 16) & 0xFF);
+            *_pNumBytes = AUDIO_CUR_4_SIZE;
+            _pchannel->err = USB_ERR_OK;
+        }
+        else if((AUDIO_CS_SAM_FREQ_CONTROL == selector) && (AUDIO_REQUEST_RANGE == _pSetupPacket->b_request) && get)
+        {
+            /* One subrange, min = max = rate, no resolution */
+            pbuffer[0] = 1;
+            pbuffer[2] = (uint8_t)(USBF_AUDIO_SAMPLE_RATE & 0xFF);
+            pbuffer[3] = (uint8_t)((USBF_AUDIO_SAMPLE_RATE >> 8) & 0xFF);
+            pbuffer[4] = (uint8_t)((USBF_AUDIO_SAMPLE_RATE >> 16) & 0xFF);
+            pbuffer[6] = pbuffer[2];
+            pbuffer[7] = pbuffer[3];
+            pbuffer[8] = pbuffer[4];
+            *_pNumBytes = AUDIO_RANGE_4_SIZE;
+            _pchannel->err = USB_ERR_OK;
+        }
+        else if((AUDIO_CS_CLOCK_VALID_CONTROL == selector) && (AUDIO_REQUEST_CUR == _pSetupPacket->b_request) && get)
+        {
+            pbuffer[0] = 1;
+            *_pNumBytes = AUDIO_CUR_1_SIZE;
+            _pchannel->err = USB_ERR_OK;
+        }
+        else
+        {
+            /* Not supported */
+            ;
+        }
+    }
+    else if(USBF_AUDIO_ID_FEATURE_UNIT == entity)
+    {
+        if((AUDIO_FU_MUTE_CONTROL == selector) && (AUDIO_REQUEST_CUR == _pSetupPacket->b_request))
+        {
+            pbuffer[0] = (uint8_t)stats.mute;
+            *_pNumBytes = AUDIO_CUR_1_SIZE;
+            _pchannel->err = USB_ERR_OK;
+        }
+        else if((AUDIO_FU_VOLUME_CONTROL == selector) && (AUDIO_REQUEST_CUR == _pSetupPacket->b_request))
+        {
+            pbuffer[0] = (uint8_t)((uint16_t)stats.volume & 0xFF);
+            pbuffer[1] = (uint8_t)(((uint16_t)stats.volume >> 8) & 0xFF);
+            *_pNumBytes = AUDIO_CUR_2_SIZE;
+            _pchannel->err = USB_ERR_OK;
+        }
+        else if((AUDIO_FU_VOLUME_CONTROL == selector) && (AUDIO_REQUEST_RANGE == _pSetupPacket->b_request) && get)
+        {
+            pbuffer[0] = 1;
+            pbuffer[2] = (uint8_t)((uint16_t)USBF_AUDIO_VOLUME_MIN & 0xFF);
+            pbuffer[3] = (uint8_t)(((uint16_t)USBF_AUDIO_VOLUME_MIN >> 8) & 0xFF);
+            pbuffer[4] = (uint8_t)((uint16_t)USBF_AUDIO_VOLUME_MAX & 0xFF);
+            pbuffer[5] = (uint8_t)(((uint16_t)USBF_AUDIO_VOLUME_MAX >> 8) & 0xFF);
+            pbuffer[6] = (uint8_t)(USBF_AUDIO_VOLUME_RES & 0xFF);
+            pbuffer[7] = (uint8_t)((USBF_AUDIO_VOLUME_RES >> 8) & 0xFF);
+            *_pNumBytes = AUDIO_RANGE_2_SIZE;
+            _pchannel->err = USB_ERR_OK;
+        }
+        else
+        {
+            /* Not supported */
+            ;
+        }
+    }
+    else
+    {
+        /* No controls on the terminals */
+        ;
+    }
+
+    /* Sets take exactly the data the host sends */
+    if((USB_ERR_OK == _pchannel->err) && (!get))
+    {
+        if(_pSetupPacket->w_length != *_pNumBytes)
+        {
+            _pchannel->err = USB_ERR_UNKNOWN_REQUEST;
+        }
+    }
+
+    return _pchannel->err;
+}
+/******************************************************************************
+End of function process_class_setup_packet
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :   cb_done_control_out
+* Description     :   A Control Out has completed in response to a
+*                     class request accepted in process_class_setup_packet,
+*                     the setup packet is still in the channel.
+* Argument        :   _err - Error code.
+*                     _num_bytes - The number of bytes received from the host.
+* Return value    :   -
+*****************************************************************************/
+static void cb_done_control_out(volatile st_usb_object_t *_pchannel,
+                                usb_err_t _err,
+                                uint32_t _num_bytes)
+{
+    uint8_t *pbuffer = (uint8_t *)control_buffer;
+    int32_t volume;
+
+    (void) _num_bytes;
+
+    if((USB_ERR_OK != _err) ||
+       (USBF_AUDIO_ID_FEATURE_UNIT != (uint8_t)(_pchannel->setup_packet.w_index >> 8)))
+    {
+        /* Sample rate sets need no action, there is only one */
+        return;
+    }
+
+    switch((uint8_t)(_pchannel->setup_packet.w_value >> 8))
+    {
+        case AUDIO_FU_MUTE_CONTROL:
+        {
+            stats.mute = (BOOL)(0 != pbuffer[0]);
+            DEBUG_MSG_MID(("USBAUDIO: Mute %d\r\n", stats.mute));
+            break;
+        }
+        case AUDIO_FU_VOLUME_CONTROL:
+        {
+            volume = (int16_t)((uint16_t)pbuffer[0] | ((uint16_t)pbuffer[1] << 8));
+            if(volume < USBF_AUDIO_VOLUME_MIN)
+            {
+                volume = USBF_AUDIO_VOLUME_MIN;
+            }
+            if(volume > USBF_AUDIO_VOLUME_MAX)
+            {
+                volume = USBF_AUDIO_VOLUME_MAX;
+            }
+            stats.volume = (int16_t)volume;
+            DEBUG_MSG_MID(("USBAUDIO: Volume %d/256 dB\r\n", stats.volume));
+            break;
+        }
+        default:
+        {
+            return;
+        }
+    }
+
+    if(NULL != sink.p_volume)
+    {
+        sink.p_volume(sink.p_context, stats.mute, stats.volume);
+    }
+}
+/******************************************************************************
+End of function cb_done_control_out
+******************************************************************************/
+
+/*****************************************************************************
+* Function Name   :   initialise_data
+* Description     :   Initialise this modules data.
+*                     Put into a function so that it can be done each time
+*                     the USB cable is connected. The sink and the volume
+*                     survive a reconnect.
+* Argument        :   -
+* Return value    :   -
+*****************************************************************************/
+static uint16_t initialise_data(volatile st_usb_object_t *_pchannel)
+{
+    _pchannel->pend_pnt[0] = end_ptbl_1;
+    _pchannel->pend_pnt[1] = end_ptbl_2;
+    _pchannel->pend_pnt[2] = end_ptbl_3;
+    _pchannel->pend_pnt[3] = end_ptbl_4;
+    _pchannel->pend_pnt[4] = end_ptbl_5;
+
+    alt_setting = 0;
+    rate_valid = FALSE;
+    feedback_packet = 0;
+
+    stats.streaming = FALSE;
+    stats.rate = FEEDBACK_NOMINAL;
+    stats.feedback = FEEDBACK_NOMINAL >> 2;
+
+    return (1);
+}
+/******************************************************************************
+End of function initialise_data
+******************************************************************************/
@@ -0,0 +1,600 @@
+/******************************************************************************
+* DISCLAIMER                                                                      
+* This software is supplied by Renesas Electronics Corporation and is only
+* intended for use with Renesas products. No other uses are authorized.
+* This software is owned by Renesas Electronics Corporation and is protected under
+* all applicable laws, including copyright laws.
+* THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES
+* REGARDING THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+* INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NON-INFRINGEMENT.  ALL SUCH WARRANTIES ARE EXPRESSLY
+* DISCLAIMED.
+* TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+* ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+* FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES
+* FOR ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS
+* AFFILIATES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+* Renesas reserves the right, without notice, to make changes to this
+* software and to discontinue the availability of this software.  
+* By using this software, you agree to the additional terms and
+* conditions found by accessing the following link:
+* http://www.renesas.com/disclaimer
+******************************************************************************/
+/* Copyright (C) 2010 Renesas Electronics Corporation. All rights reserved.*/
+
+/******************************************************************************
+* File Name       : usb_audio_descriptors.c
+* Version         : 1.00
+* Device          : RZA1(H)
+* Tool Chain      : GNUARM-NONE-EABI v14.02
+* H/W Platform    : RZ/A1LU
+* Description     : Descriptors required to enumerate a device as a
+*                   USB Audio Class 2.0 speaker.
+*                   Full speed only, one configuration with an audio control
+*                   interface and an audio streaming interface whose
+*                   alternate setting 1 has an asynchronous isochronous OUT
+*                   endpoint and its explicit feedback endpoint.
+*
+*                   NOTE: This will need to be modified for a particular
+*                   product as it includes company/product specific data including
+*                   string descriptors specifying
+*                   Manufacturer, Product and Serial Number.
+******************************************************************************/
+
+/******************************************************************************
+* History         : 27.06.2018 Ver. 1.00 First Release
+******************************************************************************/
+
+/******************************************************************************
+User Includes
+******************************************************************************/
+/*    Following header file provides definition for Low level driver. */
+#include "r_usb_hal.h"
+/*    Following header file provides definition for usb_core.c. */
+#include "r_usbf_core.h"
+/*    Following header file provides USB descriptor information. */
+#include "usb_audio_descriptors.h"
+
+/******************************************************************************
+Macros Defines
+******************************************************************************/
+/*Vendor and Product ID*/
+/*NOTE Please use your company Vendor ID when developing a new product.*/
+#define VID (0x045B)
+#define PID (0x2015)
+
+/*    Descriptor sizes    */
+#define DEVICE_DESCRIPTOR_SIZE                   (18)
+#define CONFIG_DESCRIPTOR_SIZE                   (152)
+#define AC_DESCRIPTOR_SIZE                       (64)
+#define STRING_MANUFACTURER_SIZE                 (16)
+#define STRING_PRODUCT_SIZE                      (38)
+#define STRING_SERIAL_NUM_SIZE                   (8)
+
+#define STRING_iMANUFACTURER     (1)
+#define STRING_iPRODUCT          (2)
+#define STRING_iSERIAL           (3)
+
+/******************************************************************************
+Global Variables
+******************************************************************************/
+
+static const uint8_t device_descriptor_data[DEVICE_DESCRIPTOR_SIZE] =
+{
+    /*Size of this descriptor*/
+    DEVICE_DESCRIPTOR_SIZE,
+
+    /*Device Descriptor*/
+    0x01,
+
+    /*USB Version 2.0*/
+    0x00,0x02,
+
+    /*Class Code - Miscellaneous, the function is described by an IAD*/
+    0xEF,
+
+    /*Subclass Code - Common Class*/
+    0x02,
+
+    /*Protocol Code - Interface Association Descriptor*/
+    0x01,
+
+    /*Max Packet Size for endpoint 0*/
+    USBF_AUDIO_CONTROL_PACKET_SIZE,
+
+    /*Vendor ID LSB*/
+    (uint8_t)(VID & 0xFF),
+
+    /*Vendor ID MSB*/
+    (uint8_t)((VID>>8)& 0xFF),
+
+    /*Product ID LSB*/
+    (uint8_t)(PID & 0xFF),
+
+    /*Product ID MSB*/
+    (uint8_t)((PID>>8)& 0xFF),
+
+    /*Device Release Number*/
+    0x00,0x01,
+
+    /*Manufacturer String Descriptor*/
+    STRING_iMANUFACTURER,
+
+    /*Product String Descriptor*/
+    STRING_iPRODUCT,
+
+    /*Serial Number String Descriptor*/
+    STRING_iSERIAL,
+
+    /*Number of Configurations supported*/
+    0x01
+};
+
+/*Configuration Descriptor*/
+static const uint8_t configuration_descriptor_data[CONFIG_DESCRIPTOR_SIZE] =
+{
+    /*Size of this descriptor (Just the configuration part)*/
+    0x09,
+
+    /*Configuration Descriptor*/
+    0x02,
+
+    /*Combined length of all descriptors (little endian)*/
+    (CONFIG_DESCRIPTOR_SIZE & 0xFF), ((CONFIG_DESCRIPTOR_SIZE >> 8) & 0xFF),
+
+    /*Number of interfaces*/
+    0x02,
+
+    /*This Interface Value*/
+    0x01,
+
+    /*No String Descriptor for this configuration*/
+    0x00,
+
+    /*bmAttributes - Self Powered, No Remote Wakeup*/
+    0x80,
+
+    /*bMaxPower (2mA units) 100mA*/
+    50,
+
+/* Interface Association Descriptor */
+    /*Size of this descriptor*/
+    0x08,
+
+    /*INTERFACE ASSOCIATION Descriptor*/
+    0x0B,
+
+    /*bFirstInterface*/
+    USBF_AUDIO_IF_CONTROL,
+
+    /*bInterfaceCount*/
+    0x02,
+
+    /*bFunctionClass = Audio*/
+    0x01,
+
+    /*bFunctionSubClass = Undefined*/
+    0x00,
+
+    /*bFunctionProtocol = IP version 2.00*/
+    0x20,
+
+    /*No String Descriptor for this function*/
+    0x00,
+
+/* Audio Control Interface Descriptor */
+    /*Size of this descriptor*/
+    0x09,
+
+    /*INTERFACE Descriptor*/
+    0x04,
+
+    /*Index of Interface*/
+    USBF_AUDIO_IF_CONTROL,
+
+    /*bAlternateSetting*/
+    0x00,
+
+    /*Number of Endpoints - no interrupt endpoint*/
+    0x00,
+
+    /*Class code = Audio*/
+    0x01,
+
+    /*Subclass = Audio Control*/
+    0x01,
+
+    /*Protocol = IP version 2.00*/
+    0x20,
+
+    /*No String Descriptor for this interface*/
+    0x00,
+
+/* Class-Specific AC Interface Header Descriptor */
+    /*bLength*/
+    0x09,
+
+    /*bDescriptorType = CS_INTERFACE*/
+    0x24,
+
+    /*bDescriptorSubtype = Header*/
+    0x01,
+
+    /*bcdADC 2.0*/
+    0x00,0x02,
+
+    /*bCategory = Desktop Speaker*/
+    0x01,
+
+    /*wTotalLength of the class-specific AC descriptors*/
+    (AC_DESCRIPTOR_SIZE & 0xFF), ((AC_DESCRIPTOR_SIZE >> 8) & 0xFF),
+
+    /*bmControls - latency control not present*/
+    0x00,
+
+/* Clock Source Descriptor */
+    /*bLength*/
+    0x08,
+
+    /*bDescriptorType = CS_INTERFACE*/
+    0x24,
+
+    /*bDescriptorSubtype = Clock Source*/
+    0x0A,
+
+    /*bClockID*/
+    USBF_AUDIO_ID_CLOCK_SOURCE,
+
+    /*bmAttributes - internal fixed clock*/
+    0x01,
+
+    /*bmControls - frequency read only, validity read only*/
+    0x05,
+
+    /*bAssocTerminal*/
+    0x00,
+
+    /*iClockSource*/
+    0x00,
+
+/* Input Terminal Descriptor */
+    /*bLength*/
+    0x11,
+
+    /*bDescriptorType = CS_INTERFACE*/
+    0x24,
+
+    /*bDescriptorSubtype = Input Terminal*/
+    0x02,
+
+    /*bTerminalID*/
+    USBF_AUDIO_ID_INPUT_TERMINAL,
+
+    /*wTerminalType = USB Streaming*/
+    0x01,0x01,
+
+    /*bAssocTerminal*/
+    0x00,
+
+    /*bCSourceID*/
+    USBF_AUDIO_ID_CLOCK_SOURCE,
+
+    /*bNrChannels*/
+    USBF_AUDIO_CHANNELS,
+
+    /*bmChannelConfig - Front Left, Front Right*/
+    0x03,0x00,0x00,0x00,
+
+    /*iChannelNames*/
+    0x00,
+
+    /*bmControls*/
+    0x00,0x00,
+
+    /*iTerminal*/
+    0x00,
+
+/* Feature Unit Descriptor */
+    /*bLength*/
+    0x12,
+
+    /*bDescriptorType = CS_INTERFACE*/
+    0x24,
+
+    /*bDescriptorSubtype = Feature Unit*/
+    0x06,
+
+    /*bUnitID*/
+    USBF_AUDIO_ID_FEATURE_UNIT,
+
+    /*bSourceID*/
+    USBF_AUDIO_ID_INPUT_TERMINAL,
+
+    /*bmaControls(0) master - mute and volume read/write*/
+    0x0F,0x00,0x00,0x00,
+
+    /*bmaControls(1)*/
+    0x00,0x00,0x00,0x00,
+
+    /*bmaControls(2)*/
+    0x00,0x00,0x00,0x00,
+
+    /*iFeature*/
+    0x00,
+
+/* Output Terminal Descriptor */
+    /*bLength*/
+    0x0C,
+
+    /*bDescriptorType = CS_INTERFACE*/
+    0x24,
+
+    /*bDescriptorSubtype = Output Terminal*/
+    0x03,
+
+    /*bTerminalID*/
+    USBF_AUDIO_ID_OUTPUT_TERMINAL,
+
+    /*wTerminalType = Speaker*/
+    0x01,0x03,
+
+    /*bAssocTerminal*/
+    0x00,
+
+    /*bSourceID*/
+    USBF_AUDIO_ID_FEATURE_UNIT,
+
+    /*bCSourceID*/
+    USBF_AUDIO_ID_CLOCK_SOURCE,
+
+    /*bmControls*/
+    0x00,0x00,
+
+    /*iTerminal*/
+    0x00,
+
+/* Audio Streaming Interface Descriptor - Alternate 0, no bandwidth */
+    /*Size of this descriptor*/
+    0x09,
+
+    /*INTERFACE Descriptor*/
+    0x04,
+
+    /*Index of Interface*/
+    USBF_AUDIO_IF_STREAMING,
+
+    /*bAlternateSetting*/
+    0x00,
+
+    /*Number of Endpoints*/
+    0x00,
+
+    /*Class code = Audio*/
+    0x01,
+
+    /*Subclass = Audio Streaming*/
+    0x02,
+
+    /*Protocol = IP version 2.00*/
+    0x20,
+
+    /*No String Descriptor for this interface*/
+    0x00,
+
+/* Audio Streaming Interface Descriptor - Alternate 1, streaming */
+    /*Size of this descriptor*/
+    0x09,
+
+    /*INTERFACE Descriptor*/
+    0x04,
+
+    /*Index of Interface*/
+    USBF_AUDIO_IF_STREAMING,
+
+    /*bAlternateSetting*/
+    0x01,
+
+    /*Number of Endpoints - data and feedback*/
+    0x02,
+
+    /*Class code = Audio*/
+    0x01,
+
+    /*Subclass = Audio Streaming*/
+    0x02,
+
+    /*Protocol = IP version 2.00*/
+    0x20,
+
+    /*No String Descriptor for this interface*/
+    0x00,
+
+/* Class-Specific AS Interface Descriptor */
+    /*bLength*/
+    0x10,
+
+    /*bDescriptorType = CS_INTERFACE*/
+    0x24,
+
+    /*bDescriptorSubtype = AS General*/
+    0x01,
+
+    /*bTerminalLink*/
+    USBF_AUDIO_ID_INPUT_TERMINAL,
+
+    /*bmControls*/
+    0x00,
+
+    /*bFormatType = Type I*/
+    0x01,
+
+    /*bmFormats = PCM*/
+    0x01,0x00,0x00,0x00,
+
+    /*bNrChannels*/
+    USBF_AUDIO_CHANNELS,
+
+    /*bmChannelConfig - Front Left, Front Right*/
+    0x03,0x00,0x00,0x00,
+
+    /*iChannelNames*/
+    0x00,
+
+/* Type I Format Type Descriptor */
+    /*bLength*/
+    0x06,
+
+    /*bDescriptorType = CS_INTERFACE*/
+    0x24,
+
+    /*bDescriptorSubtype = Format Type*/
+    0x02,
+
+    /*bFormatType = Type I*/
+    0x01,
+
+    /*bSubslotSize*/
+    USBF_AUDIO_SUBSLOT_BYTES,
+
+    /*bBitResolution*/
+    24,
+
+/* Endpoint Isochronous OUT */
+    /*Size of this descriptor*/
+    0x07,
+
+    /*ENDPOINT Descriptor*/
+    0x05,
+
+    /*bEndpointAddress - OUT endpoint, endpoint number = 1*/
+    0x01,
+
+    /*Endpoint Type is Isochronous, Asynchronous, Data*/
+    0x05,
+
+    /*Max Packet Size*/
+    (USBF_AUDIO_DATA_PACKET_SIZE & 0xFF), ((USBF_AUDIO_DATA_PACKET_SIZE >> 8) & 0xFF),
+
+    /*Polling Interval - every frame*/
+    0x01,
+
+/* Class-Specific AS Isochronous Audio Data Endpoint Descriptor */
+    /*bLength*/
+    0x08,
+
+    /*bDescriptorType = CS_ENDPOINT*/
+    0x25,
+
+    /*bDescriptorSubtype = EP General*/
+    0x01,
+
+    /*bmAttributes*/
+    0x00,
+
+    /*bmControls*/
+    0x00,
+
+    /*bLockDelayUnits*/
+    0x00,
+
+    /*wLockDelay*/
+    0x00,0x00,
+
+/* Endpoint Isochronous IN - Feedback */
+    /*Size of this descriptor*/
+    0x07,
+
+    /*ENDPOINT Descriptor*/
+    0x05,
+
+    /*bEndpointAddress - IN endpoint, endpoint number = 2*/
+    0x82,
+
+    /*Endpoint Type is Isochronous, No Synchronisation, Feedback*/
+    0x11,
+
+    /*Max Packet Size*/
+    (USBF_AUDIO_FEEDBACK_PACKET_SIZE & 0xFF), ((USBF_AUDIO_FEEDBACK_PACKET_SIZE >> 8) & 0xFF),
+
+    /*Polling Interval - every frame*/
+    0x01
+};
+
+/*String Descriptors*/
+    /*Note Language ID is in USB Core */
+
+/*Manufacturer string*/
+/* "RENESAS" */
+static const uint8_t string_desc_manufacturer_data[STRING_MANUFACTURER_SIZE] =
+{
+    /* Length of this descriptor*/
+    STRING_MANUFACTURER_SIZE,
+
+    /* Descriptor Type = STRING */
+    0x03,
+
+    /* Descriptor Text (unicode) */
+    'R', 0x00, 'E', 0x00, 'N', 0x00, 'E', 0x00,
+    'S', 0x00, 'A', 0x00, 'S', 0x00
+};
+
+/*Product string*/
+/* "Soundbar USB Audio" */
+static const uint8_t string_desc_product_data[STRING_PRODUCT_SIZE] =
+{
+    /* Length of this descriptor*/
+    STRING_PRODUCT_SIZE,
+
+    /* Descriptor Type = STRING */
+    0x03,
+
+    /* Descriptor Text (unicode) */
+    'S', 0x00, 'o', 0x00, 'u', 0x00, 'n', 0x00,
+    'd', 0x00, 'b', 0x00, 'a', 0x00, 'r', 0x00,
+    ' ', 0x00, 'U', 0x00, 'S', 0x00, 'B', 0x00,
+    ' ', 0x00, 'A', 0x00, 'u', 0x00, 'd', 0x00,
+    'i', 0x00, 'o', 0x00
+};
+
+/*Serial number string "1.1"*/
+static const uint8_t string_desc_serial_num_data[STRING_SERIAL_NUM_SIZE] =
+{
+    /* Length of this descriptor*/
+    STRING_SERIAL_NUM_SIZE,
+
+    /* Descriptor Type = STRING */
+    0x03,
+
+    /* Descriptor Text (unicode) */
+    '1', 0x00, '.', 0x00, '1', 0x00
+};
+
+const descriptor_t g_audio_device_descriptor =
+{
+    DEVICE_DESCRIPTOR_SIZE,
+    (uint8_t *)device_descriptor_data
+};
+
+const descriptor_t g_audio_configuration_descriptor =
+{
+    CONFIG_DESCRIPTOR_SIZE,
+    (uint8_t *)configuration_descriptor_data
+};
+
+const descriptor_t g_audio_string_desc_manufacturer =
+{
+    STRING_MANUFACTURER_SIZE,
+    (uint8_t *)string_desc_manufacturer_data
+};
+
+const descriptor_t g_audio_string_desc_product =
+{
+    STRING_PRODUCT_SIZE,
+    (uint8_t *)string_desc_product_data
+};
+
+const descriptor_t g_audio_string_desc_serial_num =
+{
+    STRING_SERIAL_NUM_SIZE,
+    (uint8_t *)string_desc_serial_num_data
+};
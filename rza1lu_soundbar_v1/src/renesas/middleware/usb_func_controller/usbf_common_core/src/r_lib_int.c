@@ -78,7 +78,27 @@ static void intr_int_pipe(volatile st_usb_object_t *_pchannel, uint16_t Status,
         /* BEMP Status Clear */
         rza_io_reg_write_16(&_pchannel->phwdevice->BEMPSTS,  (uint16_t)~BITBEMP1, ACC_16B_SHIFT, ACC_16B_MASK);
         rza_io_reg_write_16(&_pchannel->phwdevice->PIPESEL,   PIPE1, USB_PIPESEL_PIPESEL_SHIFT, USB_PIPESEL_PIPESEL);
-        if( 0  == rza_io_reg_read_16(&_pchannel->phwdevice->PIPECFG, USB_PIPECFG_DIR_SHIFT, USB_PIPECFG_DIR) )
+        if(NULL != _pchannel->callbacks.p_cb_isoc_out)
+        {
+            /* Isochronous OUT - the class reads the packet out of the FIFO itself */
+            _pchannel->endflag_k = R_USBF_DataioFPortChange1(_pchannel, PIPE1, CUSE, USB_NO);
+            if(FIFOERROR == _pchannel->endflag_k)
+            {
+                _pchannel->callbacks.p_cb_isoc_out((volatile void *)_pchannel, USB_ERR_FAIL, 0);
+            }
+            else
+            {
+                _pchannel->rdcnt[PIPE1] = (uint32_t)(_pchannel->endflag_k & BITDTLN);
+                if((0 == _pchannel->rdcnt[PIPE1]) ||
+                   (_pchannel->callbacks.p_cb_isoc_out((volatile void *)_pchannel, USB_ERR_OK,
+                                                       (uint16_t)_pchannel->rdcnt[PIPE1]) < _pchannel->rdcnt[PIPE1]))
+                {
+                    /* Zero length packet or the rest of the packet is discarded */
+                    rza_io_reg_write_16(&_pchannel->phwdevice->CFIFOCTR, BITBCLR, ACC_16B_SHIFT, ACC_16B_MASK);
+                }
+            }
+        }
+        else if( 0  == rza_io_reg_read_16(&_pchannel->phwdevice->PIPECFG, USB_PIPECFG_DIR_SHIFT, USB_PIPECFG_DIR) )
         {
             _pchannel->endflag_k = R_USBF_DataioBufRead(_pchannel, PIPE1);
             switch( _pchannel->endflag_k )
@@ -111,7 +131,12 @@ static void intr_int_pipe(volatile st_usb_object_t *_pchannel, uint16_t Status,
         rza_io_reg_write_16(&_pchannel->phwdevice->BRDYSTS,  (uint16_t)~BITBRDY2, ACC_16B_SHIFT, ACC_16B_MASK);
         rza_io_reg_write_16(&_pchannel->phwdevice->BEMPSTS,  (uint16_t)~BITBEMP2, ACC_16B_SHIFT, ACC_16B_MASK);
         rza_io_reg_write_16(&_pchannel->phwdevice->PIPESEL,   PIPE2, USB_PIPESEL_PIPESEL_SHIFT, USB_PIPESEL_PIPESEL);
-        if(0  == rza_io_reg_read_16(&_pchannel->phwdevice->PIPECFG, USB_PIPECFG_DIR_SHIFT, USB_PIPECFG_DIR) )
+        if(NULL != _pchannel->callbacks.p_cb_isoc_in)
+        {
+            /* Isochronous IN - last packet taken, the class loads the next */
+            _pchannel->callbacks.p_cb_isoc_in((volatile void *)_pchannel);
+        }
+        else if(0  == rza_io_reg_read_16(&_pchannel->phwdevice->PIPECFG, USB_PIPECFG_DIR_SHIFT, USB_PIPECFG_DIR) )
         {
             _pchannel->endflag_k = R_USBF_DataioBufRead(_pchannel, PIPE2);
         } 
@@ -33,7 +33,8 @@
 *                   Provides a hardware independent API to the USB peripheral
 *                   on the SH7269.
 *                   Supports:-
-*                    Control IN, Control OUT, Bulk IN, Bulk OUT, Interrupt IN.
+*                    Control IN, Control OUT, Bulk IN, Bulk OUT, Interrupt IN,
+*                    Isochronous OUT, Isochronous IN.
 *
 ******************************************************************************/
 
@@ -588,6 +589,181 @@ usb_err_t R_USB_HalInterruptIn(volatile st_usb_object_t *_pchannel,
 End of function R_USB_HalInterruptIn
 ******************************************************************************/
 
+/******************************************************************************
+* Function Name   :   R_USB_HalIsocOutStart
+* Description     :   Starts receiving on the ISOCHRONOUS OUT pipe (PIPE1).
+*                     The callback runs in the BRDY interrupt for every
+*                     packet with the packet still in the FIFO, so the class
+*                     can read it straight into its own buffer with
+*                     R_USB_HalIsocOutRead. Whatever it leaves is discarded.
+* Argument        :   _CBData:    Callback called for each packet.
+* Return value    :   Error code.
+******************************************************************************/
+usb_err_t R_USB_HalIsocOutStart(volatile st_usb_object_t *_pchannel, CB_ISOC_OUT _CBData)
+{
+    _pchannel->err = USB_ERR_OK;
+
+    /*Check cable is connected*/
+    if(STATE_DISCONNECTED == usb_control.device_state)
+    {
+        _pchannel->err = USB_ERR_NOT_CONNECTED;
+        DEBUG_MSG_MID(("USBHAL: ISOC OUT - Not Connected\r\n"));
+    }
+    else
+    {
+        _pchannel->callbacks.p_cb_isoc_out = _CBData;
+        _pchannel->pipe_ignore[PIPE1] = 0;
+        _pchannel->pipe_flag[PIPE1] = PIPE_WAIT;
+
+        /* Discard anything left from a previous alternate setting */
+        R_LIB_SetNAK(_pchannel, PIPE1);
+        R_LIB_DoSQCLR(_pchannel, PIPE1);
+        R_LIB_SetACLRM(_pchannel, PIPE1);
+        R_LIB_ClrACLRM(_pchannel, PIPE1);
+
+        /* Set BUF */
+        R_LIB_SetBUF(_pchannel, PIPE1);
+
+        /* Enable Ready Interrupt */
+        R_LIB_EnableIntR(_pchannel, PIPE1);
+    }
+
+    return _pchannel->err;
+}
+/******************************************************************************
+End of function R_USB_HalIsocOutStart
+******************************************************************************/
+
+/******************************************************************************
+* Function Name   :   R_USB_HalIsocOutRead
+* Description     :   Reads part of the packet waiting in the ISOCHRONOUS
+*                     OUT FIFO. Only valid inside the CB_ISOC_OUT callback,
+*                     may be called more than once to split the packet.
+* Argument        :   _pbuffer:   Destination, 32 bit aligned for word access.
+*                     _num_bytes: Number of bytes to read.
+* Return value    :   Number of bytes read.
+******************************************************************************/
+uint16_t R_USB_HalIsocOutRead(volatile st_usb_object_t *_pchannel, uint8_t* _pbuffer, uint16_t _num_bytes)
+{
+    _pchannel->p_dtptr[PIPE1] = _pbuffer;
+    R_USBF_DataioCFifoRead(_pchannel, PIPE1, _num_bytes);
+
+    return _num_bytes;
+}
+/******************************************************************************
+End of function R_USB_HalIsocOutRead
+******************************************************************************/
+
+/******************************************************************************
+* Function Name   :   R_USB_HalIsocInStart
+* Description     :   Starts sending on the ISOCHRONOUS IN pipe (PIPE2).
+*                     The callback is called once here and then from the
+*                     BRDY interrupt each time the host has taken the
+*                     packet, it supplies the next one with
+*                     R_USB_HalIsocInWrite.
+* Argument        :   _CBReady:   Callback called when the pipe can be written.
+* Return value    :   Error code.
+******************************************************************************/
+usb_err_t R_USB_HalIsocInStart(volatile st_usb_object_t *_pchannel, CB_ISOC_IN _CBReady)
+{
+    _pchannel->err = USB_ERR_OK;
+
+    /*Check cable is connected*/
+    if(STATE_DISCONNECTED == usb_control.device_state)
+    {
+        _pchannel->err = USB_ERR_NOT_CONNECTED;
+        DEBUG_MSG_MID(("USBHAL: ISOC IN - Not Connected\r\n"));
+    }
+    else
+    {
+        _pchannel->callbacks.p_cb_isoc_in = _CBReady;
+        _pchannel->pipe_ignore[PIPE2] = 0;
+        _pchannel->pipe_flag[PIPE2] = PIPE_WAIT;
+
+        R_LIB_SetNAK(_pchannel, PIPE2);
+        R_LIB_DoSQCLR(_pchannel, PIPE2);
+        R_LIB_SetACLRM(_pchannel, PIPE2);
+        R_LIB_ClrACLRM(_pchannel, PIPE2);
+
+        /* First packet */
+        _CBReady((volatile void *)_pchannel);
+
+        /* Set BUF */
+        R_LIB_SetBUF(_pchannel, PIPE2);
+
+        /* Enable Ready Interrupt */
+        R_LIB_EnableIntR(_pchannel, PIPE2);
+    }
+
+    return _pchannel->err;
+}
+/******************************************************************************
+End of function R_USB_HalIsocInStart
+******************************************************************************/
+
+/******************************************************************************
+* Function Name   :   R_USB_HalIsocInWrite
+* Description     :   Loads one packet into the ISOCHRONOUS IN FIFO, it is
+*                     sent on the next IN token from the host.
+* Argument        :   _num_bytes: Number of bytes, no more than the buffer.
+*                     _pbuffer:   Data Buffer.
+* Return value    :   Error code.
+******************************************************************************/
+usb_err_t R_USB_HalIsocInWrite(volatile st_usb_object_t *_pchannel, uint16_t _num_bytes, const uint8_t* _pbuffer)
+{
+    _pchannel->err = USB_ERR_OK;
+
+    _pchannel->dtcnt[PIPE2] = _num_bytes;
+    _pchannel->p_dtptr[PIPE2] = (uint8_t*)_pbuffer;
+
+    if(FIFOERROR == R_USBF_DataioBufWriteC(_pchannel, PIPE2))
+    {
+        _pchannel->err = USB_ERR_FAIL;
+    }
+
+    return _pchannel->err;
+}
+/******************************************************************************
+End of function R_USB_HalIsocInWrite
+******************************************************************************/
+
+/******************************************************************************
+* Function Name   :   R_USB_HalIsocStop
+* Description     :   Stops both isochronous pipes and drops their callbacks.
+* Argument        :   None
+* Return value    :   None
+******************************************************************************/
+void R_USB_HalIsocStop(volatile st_usb_object_t *_pchannel)
+{
+    R_LIB_DisableIntR(_pchannel, PIPE1);
+    R_LIB_DisableIntR(_pchannel, PIPE2);
+    R_LIB_SetNAK(_pchannel, PIPE1);
+    R_LIB_SetNAK(_pchannel, PIPE2);
+
+    _pchannel->callbacks.p_cb_isoc_out = NULL;
+    _pchannel->callbacks.p_cb_isoc_in = NULL;
+    _pchannel->pipe_flag[PIPE1] = PIPE_IDLE;
+    _pchannel->pipe_flag[PIPE2] = PIPE_IDLE;
+}
+/******************************************************************************
+End of function R_USB_HalIsocStop
+******************************************************************************/
+
+/******************************************************************************
+* Function Name   :   R_USB_HalGetFrameNumber
+* Description     :   Frame number of the last SOF, counts milliseconds and
+*                     wraps at 2048.
+* Argument        :   None
+* Return value    :   Frame number.
+******************************************************************************/
+uint16_t R_USB_HalGetFrameNumber(volatile st_usb_object_t *_pchannel)
+{
+    return rza_io_reg_read_16(&_pchannel->phwdevice->FRMNUM, USB_FRMNUM_FRNM_SHIFT, USB_FRMNUM_FRNM);
+}
+/******************************************************************************
+End of function R_USB_HalGetFrameNumber
+******************************************************************************/
+
 /******************************************************************************
 * Function Name   :   R_USB_HalControlStall
 * Description     :   Generate a stall on the Control Endpoint and then
@@ -213,6 +213,8 @@ usb_err_t R_USBF_CoreInit(volatile st_usb_object_t *_pchannel,
     _pchannel->callbacks.p_cb_bout_mfpdone = NULL;
     _pchannel->callbacks.p_cb_cout_mfpdone = NULL;
     _pchannel->callbacks.p_cb_iin_mfpdone = NULL;
+    _pchannel->callbacks.p_cb_isoc_out = NULL;
+    _pchannel->callbacks.p_cb_isoc_in = NULL;
 
     /*Initialise USB HAL*/
     _pchannel->err = R_USB_HalInit(_pchannel, cb_setup, _fpCBCable, _fpCBError);
@@ -244,9 +246,29 @@ static void cb_setup(volatile void *__pchannel, const uint8_t(*_pSetupPacket)[US
     /*Populate the Setup Packet structure g_oSetupPacket */
     populate_setup_packet(_pchannel, _pSetupPacket);
     
-    /*Process this setup packet*/
-    _pchannel->err = process_setup_packet(_pchannel, (uint16_t *)(&_pchannel->cb_setup_num_bytes), (uint8_t **)(&_pchannel->pcdsetup_buffer));
-                            
+    _pchannel->err = USB_ERR_UNKNOWN_REQUEST;
+
+    /*Alternate settings belong to the class, offer them there first*/
+    if((REQUEST_STANDARD == _pchannel->setup_packet.bm_request.bit_val.d65) &&
+       ((SET_INTERFACE == _pchannel->setup_packet.b_request) ||
+        (GET_INTERFACE == _pchannel->setup_packet.b_request)))
+    {
+        _pchannel->err = _pchannel->fp_cbc_setup_packet((void *)_pchannel,
+                                                        (setup_packet_t *)(&_pchannel->setup_packet),
+                                                        (uint16_t *)(&_pchannel->cb_setup_num_bytes),
+                                                        (uint8_t **)(&_pchannel->pcdsetup_buffer));
+        if(USB_ERR_UNKNOWN_REQUEST == _pchannel->err)
+        {
+            /*Class doesn't use alternate settings*/
+            _pchannel->err = process_setup_packet(_pchannel, (uint16_t *)(&_pchannel->cb_setup_num_bytes), (uint8_t **)(&_pchannel->pcdsetup_buffer));
+        }
+    }
+    else
+    {
+        /*Process this setup packet*/
+        _pchannel->err = process_setup_packet(_pchannel, (uint16_t *)(&_pchannel->cb_setup_num_bytes), (uint8_t **)(&_pchannel->pcdsetup_buffer));
+    }
+
     if(USB_ERR_UNKNOWN_REQUEST == _pchannel->err)
     {
         DEBUG_MSG_LOW( ("USBCORE: Passing SetupPacket up the stack.\r\n"));
@@ -678,12 +700,23 @@ static usb_err_t process_get_descriptor(volatile st_usb_object_t *_pchannel,
         {
             *_pNumBytes = _pchannel->descriptors.dev_qualifier.length;
             *_ppDescriptor = _pchannel->descriptors.dev_qualifier.puc_data;
+
+            /*A full speed only device has no qualifier, the request is stalled*/
+            if((NULL == *_ppDescriptor) || (0 == *_pNumBytes))
+            {
+                _pchannel->err = USB_ERR_UNKNOWN_REQUEST;
+            }
             break;
         }
         case OTHER_SPEED_CONFIG:
         {
             *_pNumBytes = _pchannel->descriptors.other_speed_config.length;
             *_ppDescriptor = _pchannel->descriptors.other_speed_config.puc_data;
+
+            if((NULL == *_ppDescriptor) || (0 == *_pNumBytes))
+            {
+                _pchannel->err = USB_ERR_UNKNOWN_REQUEST;
+            }
             break;
         }
         default:
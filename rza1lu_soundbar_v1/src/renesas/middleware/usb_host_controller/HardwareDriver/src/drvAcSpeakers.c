@@ -0,0 +1,1473 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ *******************************************************************************
+ * Copyright (C) 2012 Renesas Electronics Corporation. All rights reserved.
+ *******************************************************************************
+ * File Name    : drvAcSpeakers.c
+ * Version      : 1.00
+ * Device(s)    : Renesas
+ * Tool-Chain   : GNUARM-NONE-EABI v14.02
+ * OS           : None
+ * H/W Platform : RSK+
+ * Description  : Device driver for USB Audio Class 1 & 2 speakers, headsets
+ *                and DACs. PCM written to the device is played on the
+ *                isochronous OUT endpoint, the packet sizes follow the
+ *                device clock from the feedback endpoint. PCM read from the
+ *                device is captured from the isochronous IN endpoint.
+ *******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 17.10.2018 1.00 First Release
+ ******************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ ******************************************************************************/
+
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compiler_settings.h"
+#include "control.h"
+#include "ddusbh.h"
+#include "usbhDeviceApi.h"
+#include "usbhAudioClass.h"
+
+#include "r_task_priority.h"
+#include "trace.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+
+/* The number of isochronous packets in each OUT transfer */
+#define AC_PACKETS_PER_TRANSFER     8
+
+/* Two transfers per direction, one on the bus while the other is filled */
+#define AC_NUM_REQUESTS             2
+
+/* The size of the playback and capture buffers, must be a power of 2 */
+#define AC_FIFO_SIZE                (16UL * 1024UL)
+
+/* Playback starts when the buffer holds this much */
+#define AC_PLAY_PRE_FILL            (AC_FIFO_SIZE / 2)
+
+/* Playback stops after this many transfers with no data written and capture
+   stops after this many packets with nobody reading */
+#define AC_IDLE_TRANSFERS           64
+#define AC_IDLE_PACKETS             512
+
+/* The time-out for an isochronous transfer to complete */
+#define AC_TRANSFER_TIME_OUT        200UL
+
+/* The largest configuration descriptor read at open */
+#define AC_MAX_CONFIG_SIZE          1024
+
+/* The response to a RANGE request of the sample frequency */
+#define AC_RANGE_SIZE               (2 + (12 * USB_AC_MAX_SAMPLE_RATES))
+
+/* Class specific request types */
+#define AC_SET_INTERFACE            (uint8_t) (USB_HOST_TO_DEVICE | 0x20 | USB_RECIPIENT_INTERFACE)
+#define AC_GET_INTERFACE            (uint8_t) (USB_DEVICE_TO_HOST | 0x20 | USB_RECIPIENT_INTERFACE)
+#define AC_SET_ENDPOINT             (uint8_t) (USB_HOST_TO_DEVICE | 0x20 | USB_RECIPIENT_ENDPOINT)
+
+/* Comment this line out to turn ON module trace in this file */
+#undef _TRACE_ON_
+
+#ifndef _TRACE_ON_
+#undef TRACE
+#define TRACE(x)
+#endif
+
+/******************************************************************************
+ Typedef definitions
+ ******************************************************************************/
+
+/* A single producer, single consumer byte FIFO. The indices are free running
+   so the used count is the difference */
+typedef struct _ACFIFO
+{
+    uint8_t           *pbyData;
+    volatile uint32_t  dwIn;
+    volatile uint32_t  dwOut;
+    /* Set when data is taken (playback) or added (capture) */
+    event_t            evChange;
+} ACFIFO, *PACFIFO;
+
+typedef struct _ACSPK
+{
+    /* The interfaces and endpoints found by the parser */
+    ASSERVE48 audioInfo;
+    PUSBDI    pDevice;
+    /* The transfer request structures */
+    USBTR     outRequest[AC_NUM_REQUESTS];
+    USBTR     inRequest[AC_NUM_REQUESTS];
+    USBTR     syncRequest;
+    USBTR     deviceRequest;
+    /* The packet size schedule of each OUT transfer */
+    USBIV     outSchedule[AC_NUM_REQUESTS];
+    uint16_t  pwPacketSize[AC_NUM_REQUESTS][AC_PACKETS_PER_TRANSFER];
+    /* The transfer buffers */
+    uint8_t  *pbyOutBuffer[AC_NUM_REQUESTS];
+    uint8_t  *pbyInBuffer[AC_NUM_REQUESTS];
+    uint32_t  pdwFeedback[1];
+    /* The PCM buffers between the application and the stream tasks */
+    ACFIFO    playFifo;
+    ACFIFO    captureFifo;
+    /* Playback packet sizing */
+    ACRATE    rate;
+    uint32_t  dwOutFrameSize;
+    uint32_t  dwInFrameSize;
+    uint32_t  dwFramesSinceFeedback;
+    uint32_t  dwFeedbackPeriod;
+    _Bool     bfSyncQueued;
+    /* The stream tasks */
+    os_task_t *pPlayTask;
+    os_task_t *pCaptureTask;
+    event_t   evPlay;
+    event_t   evCapture;
+    volatile _Bool bfPlay;
+    volatile _Bool bfCapture;
+    volatile _Bool bfClosing;
+    /* Serialises the control pipe requests of the tasks and control() */
+    void     *pControlMutex;
+    /* The volume range of the output feature unit in 1/256dB */
+    SPKDAT    volume;
+    uint8_t   byVolumeChannel;
+    /* The last error code */
+    SPKERR    lastError;
+    /* Counters for CTL_GET_SPEAKER_STATUS */
+    ACSTAT    stats;
+
+} ACSPK, *PACSPK;
+
+/******************************************************************************
+ Function Prototypes
+ ******************************************************************************/
+
+static int_t acOpen (st_stream_ptr_t pStream);
+static void acClose (st_stream_ptr_t pStream);
+static int_t acRead (st_stream_ptr_t pStream, uint8_t *pbyBuffer, uint32_t uiCount);
+static int_t acWrite (st_stream_ptr_t pStream, uint8_t *pbyBuffer, uint32_t uiCount);
+static int_t acControl (st_stream_ptr_t pStream, uint32_t ctlCode, void *pCtlStruct);
+static int acDeviceRequest (PACSPK pAcSpk, uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue,
+        uint16_t wIndex, uint16_t wLength, uint8_t *pbyData);
+static _Bool acReadConfiguration (PACSPK pAcSpk);
+static void acReadRates (PACSPK pAcSpk, PACSTREAM pStream);
+static _Bool acSetInterface (PACSPK pAcSpk, PACSTREAM pStream, _Bool bfEnable);
+static _Bool acSetSampleRate (PACSPK pAcSpk, PACSTREAM pStream);
+static void acReadVolume (PACSPK pAcSpk);
+static int acSetVolume (PACSPK pAcSpk, short siVolume);
+static int acSetMute (PACSPK pAcSpk, _Bool bfMute);
+static _Bool acFifoCreate (PACFIFO pFifo);
+static void acFifoDestroy (PACFIFO pFifo);
+static uint32_t acFifoUsed (PACFIFO pFifo);
+static uint32_t acFifoPut (PACFIFO pFifo, const uint8_t *pbySrc, uint32_t dwLength);
+static uint32_t acFifoGet (PACFIFO pFifo, uint8_t *pbyDest, uint32_t dwLength);
+static _Bool acQueueOut (PACSPK pAcSpk, int iRequest);
+static void acFeedback (PACSPK pAcSpk);
+static void ac_play_task (PACSPK pAcSpk);
+static void ac_capture_task (PACSPK pAcSpk);
+
+/******************************************************************************
+ Constant Data
+ ******************************************************************************/
+
+/* Define the driver function table for this device */
+const st_r_driver_t gAcSpeakersDriver =
+{
+    "USB Audio Device Driver",
+    acOpen,
+    acClose,
+    acRead,
+    acWrite,
+    acControl,
+    no_dev_get_version
+};
+
+/******************************************************************************
+ Exported global variables and functions (to be accessed by other files)
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acLoadDriver
+ Description:   Function to select and start the desired interface.
+ Arguments:     IN  pAudioInfo - Pointer to the audio interface information,
+                                 NULL when only the class has been checked
+                OUT ppDeviceDriver - Pointer to the destination driver
+ Return value:  true if the driver will work with the device
+ ******************************************************************************/
+_Bool acLoadDriver (PASSERVE48 pAudioInfo, PDEVICE *ppDeviceDriver)
+{
+    if ((NULL == pAudioInfo) || (pAudioInfo->Out.bfValid) || (pAudioInfo->In.bfValid))
+    {
+        *ppDeviceDriver = (PDEVICE) &gAcSpeakersDriver;
+        return true;
+    }
+    return false;
+}
+/******************************************************************************
+ End of function  acLoadDriver
+ ******************************************************************************/
+
+/******************************************************************************
+ Private functions
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acOpen
+ Description:   Function to open the audio device driver. The whole
+                configuration descriptor is read because it is truncated
+                during enumeration.
+ Arguments:     IN  pStream - Pointer to the file stream
+ Return value:  0 for success otherwise error code
+ ******************************************************************************/
+static int_t acOpen (st_stream_ptr_t pStream)
+{
+    /* Get a pointer to the device information from the host driver for this device */
+    PUSBDI pDevice = usbhGetDevice((int8_t *) pStream->p_stream_name);
+    PACSPK pAcSpk;
+    int iRequest;
+
+    if (NULL == pDevice)
+    {
+        TRACE(("acOpen: Failed to find device %s\r\n", pStream->p_stream_name));
+        return AC_SPK_DEVICE_NOT_FOUND;
+    }
+
+    /* Allocate the memory for the driver */
+    pAcSpk = R_OS_AllocMem(sizeof(ACSPK), R_REGION_LARGE_CAPACITY_RAM);
+    if (NULL == pAcSpk)
+    {
+        return AC_SPK_MEMORY_ALLOCATION_ERROR;
+    }
+    memset(pAcSpk, 0, sizeof(ACSPK));
+    pAcSpk->pDevice = pDevice;
+
+    /* Add the events to the transfer requests */
+    for (iRequest = 0; iRequest < AC_NUM_REQUESTS; iRequest++)
+    {
+        R_OS_CreateEvent( &pAcSpk->outRequest[iRequest].ioSignal);
+        R_OS_CreateEvent( &pAcSpk->inRequest[iRequest].ioSignal);
+    }
+    R_OS_CreateEvent( &pAcSpk->syncRequest.ioSignal);
+    R_OS_CreateEvent( &pAcSpk->deviceRequest.ioSignal);
+    R_OS_CreateEvent( &pAcSpk->evPlay);
+    R_OS_CreateEvent( &pAcSpk->evCapture);
+    pAcSpk->pControlMutex = R_OS_CreateMutex();
+    pStream->p_extension = pAcSpk;
+
+    if (!acReadConfiguration(pAcSpk))
+    {
+        acClose(pStream);
+        return AC_SPK_ENDPOINT_NOT_FOUND;
+    }
+
+    /* Allocate the buffers for each direction supported */
+    if (pAcSpk->audioInfo.Out.bfValid)
+    {
+        PACSTREAM pOut = &pAcSpk->audioInfo.Out;
+
+        pAcSpk->dwOutFrameSize = (uint32_t) pOut->byNrChannels * pOut->bySubslotSize;
+        for (iRequest = 0; iRequest < AC_NUM_REQUESTS; iRequest++)
+        {
+            pAcSpk->pbyOutBuffer[iRequest] = R_OS_AllocMem(
+                    (size_t) pOut->wMaxPacketSize * AC_PACKETS_PER_TRANSFER, R_REGION_LARGE_CAPACITY_RAM);
+            if (NULL == pAcSpk->pbyOutBuffer[iRequest])
+            {
+                acClose(pStream);
+                return AC_SPK_MEMORY_ALLOCATION_ERROR;
+            }
+        }
+        if (!acFifoCreate( &pAcSpk->playFifo))
+        {
+            acClose(pStream);
+            return AC_SPK_MEMORY_ALLOCATION_ERROR;
+        }
+    }
+    if (pAcSpk->audioInfo.In.bfValid)
+    {
+        PACSTREAM pIn = &pAcSpk->audioInfo.In;
+
+        pAcSpk->dwInFrameSize = (uint32_t) pIn->byNrChannels * pIn->bySubslotSize;
+        for (iRequest = 0; iRequest < AC_NUM_REQUESTS; iRequest++)
+        {
+            pAcSpk->pbyInBuffer[iRequest] = R_OS_AllocMem((size_t) pIn->wMaxPacketSize,
+                    R_REGION_LARGE_CAPACITY_RAM);
+            if (NULL == pAcSpk->pbyInBuffer[iRequest])
+            {
+                acClose(pStream);
+                return AC_SPK_MEMORY_ALLOCATION_ERROR;
+            }
+        }
+        if (!acFifoCreate( &pAcSpk->captureFifo))
+        {
+            acClose(pStream);
+            return AC_SPK_MEMORY_ALLOCATION_ERROR;
+        }
+    }
+
+    /* Start the streaming tasks, they wait for the first write or read */
+    if (pAcSpk->audioInfo.Out.bfValid)
+    {
+        pAcSpk->pPlayTask = R_OS_CreateTask("USB Audio Play", (os_task_code_t) ac_play_task, pAcSpk,
+                R_OS_ABSTRACTION_PRV_SMALL_STACK_SIZE, TASK_USB_AUDIO_PLAY_PRI);
+    }
+    if (pAcSpk->audioInfo.In.bfValid)
+    {
+        pAcSpk->pCaptureTask = R_OS_CreateTask("USB Audio Capture", (os_task_code_t) ac_capture_task, pAcSpk,
+                R_OS_ABSTRACTION_PRV_SMALL_STACK_SIZE, TASK_USB_AUDIO_CAPTURE_PRI);
+    }
+    TRACE(("acOpen: Opened device %s at %luHz\r\n", pStream->p_stream_name, pAcSpk->audioInfo.dwSampleRate));
+    return AC_SPK_OK;
+}
+/******************************************************************************
+ End of function  acOpen
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acClose
+ Description:   Function to close the audio device driver
+ Arguments:     IN  pStream - Pointer to the file stream
+ Return value:  none
+ ******************************************************************************/
+static void acClose (st_stream_ptr_t pStream)
+{
+    PACSPK pAcSpk = pStream->p_extension;
+    int iRequest;
+
+    TRACE(("acClose:\r\n"));
+
+    /* Stop the streams and wait for the tasks to finish with the bus */
+    pAcSpk->bfClosing = true;
+    pAcSpk->bfPlay = false;
+    pAcSpk->bfCapture = false;
+    R_OS_SetEvent( &pAcSpk->evPlay);
+    R_OS_SetEvent( &pAcSpk->evCapture);
+    while ((pAcSpk->pPlayTask) || (pAcSpk->pCaptureTask))
+    {
+        if (pAcSpk->pPlayTask)
+        {
+            if (!pAcSpk->stats.bfPlaying)
+            {
+                R_OS_DeleteTask(pAcSpk->pPlayTask);
+                pAcSpk->pPlayTask = NULL;
+            }
+        }
+        if (pAcSpk->pCaptureTask)
+        {
+            if (!pAcSpk->stats.bfCapturing)
+            {
+                R_OS_DeleteTask(pAcSpk->pCaptureTask);
+                pAcSpk->pCaptureTask = NULL;
+            }
+        }
+        R_OS_TaskSleep(1);
+    }
+
+    for (iRequest = 0; iRequest < AC_NUM_REQUESTS; iRequest++)
+    {
+        R_OS_DeleteEvent( &pAcSpk->outRequest[iRequest].ioSignal);
+        R_OS_DeleteEvent( &pAcSpk->inRequest[iRequest].ioSignal);
+        if (pAcSpk->pbyOutBuffer[iRequest])
+        {
+            R_OS_FreeMem(pAcSpk->pbyOutBuffer[iRequest]);
+        }
+        if (pAcSpk->pbyInBuffer[iRequest])
+        {
+            R_OS_FreeMem(pAcSpk->pbyInBuffer[iRequest]);
+        }
+    }
+    R_OS_DeleteEvent( &pAcSpk->syncRequest.ioSignal);
+    R_OS_DeleteEvent( &pAcSpk->deviceRequest.ioSignal);
+    R_OS_DeleteEvent( &pAcSpk->evPlay);
+    R_OS_DeleteEvent( &pAcSpk->evCapture);
+    R_OS_DeleteMutex(pAcSpk->pControlMutex);
+    acFifoDestroy( &pAcSpk->playFifo);
+    acFifoDestroy( &pAcSpk->captureFifo);
+
+    /* Free the driver extension */
+    R_OS_FreeMem(pAcSpk);
+}
+/******************************************************************************
+ End of function  acClose
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acRead
+ Description:   Function to read captured PCM. Capture starts on the first
+                read and stops when it is not read for a while.
+ Arguments:     IN  pStream - Pointer to the file stream
+                OUT pbyBuffer - Pointer to the destination
+                IN  uiCount - The number of bytes to read, whole frames
+ Return value:  The number of bytes read or -1 on error
+ ******************************************************************************/
+static int_t acRead (st_stream_ptr_t pStream, uint8_t *pbyBuffer, uint32_t uiCount)
+{
+    PACSPK pAcSpk = pStream->p_extension;
+    uint32_t dwRead;
+
+    if (!pAcSpk->audioInfo.In.bfValid)
+    {
+        pAcSpk->lastError = AC_SPK_ENDPOINT_NOT_FOUND;
+        return -1;
+    }
+    if (uiCount % pAcSpk->dwInFrameSize)
+    {
+        pAcSpk->lastError = AC_SPK_INVALID_DATA_SIZE;
+        return -1;
+    }
+    if (!pAcSpk->bfCapture)
+    {
+        pAcSpk->bfCapture = true;
+        R_OS_SetEvent( &pAcSpk->evCapture);
+    }
+
+    /* Wait for at least one frame */
+    while (acFifoUsed( &pAcSpk->captureFifo) < pAcSpk->dwInFrameSize)
+    {
+        if (!R_OS_WaitForEvent( &pAcSpk->captureFifo.evChange, AC_TRANSFER_TIME_OUT))
+        {
+            pAcSpk->lastError = AC_SPK_DATA_TRANSPORT_ERROR;
+            return -1;
+        }
+    }
+    dwRead = acFifoUsed( &pAcSpk->captureFifo);
+    if (dwRead > uiCount)
+    {
+        dwRead = uiCount;
+    }
+    dwRead -= dwRead % pAcSpk->dwInFrameSize;
+    return (int_t) acFifoGet( &pAcSpk->captureFifo, pbyBuffer, dwRead);
+}
+/******************************************************************************
+ End of function  acRead
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acWrite
+ Description:   Function to write PCM for playback. Playback starts when the
+                buffer is half full and stops when writing stops.
+ Arguments:     IN  pStream - Pointer to the file stream
+                IN  pbyBuffer - Pointer to the PCM in the format of the
+                                streaming interface (CTL_GET_SPEAKER_STATUS)
+                IN  uiCount - The number of bytes to write, whole frames
+ Return value:  The number of bytes written or -1 on error
+ ******************************************************************************/
+static int_t acWrite (st_stream_ptr_t pStream, uint8_t *pbyBuffer, uint32_t uiCount)
+{
+    PACSPK pAcSpk = pStream->p_extension;
+    uint32_t dwRemaining = uiCount;
+
+    if (!pAcSpk->audioInfo.Out.bfValid)
+    {
+        pAcSpk->lastError = AC_SPK_ENDPOINT_NOT_FOUND;
+        return -1;
+    }
+    if (uiCount % pAcSpk->dwOutFrameSize)
+    {
+        pAcSpk->lastError = AC_SPK_INVALID_DATA_SIZE;
+        return -1;
+    }
+
+    while (dwRemaining)
+    {
+        uint32_t dwWritten = acFifoPut( &pAcSpk->playFifo, pbyBuffer, dwRemaining);
+
+        pbyBuffer += dwWritten;
+        dwRemaining -= dwWritten;
+        if ((!pAcSpk->bfPlay) && (acFifoUsed( &pAcSpk->playFifo) >= AC_PLAY_PRE_FILL))
+        {
+            pAcSpk->bfPlay = true;
+            R_OS_SetEvent( &pAcSpk->evPlay);
+        }
+        if ((dwRemaining) && (!R_OS_WaitForEvent( &pAcSpk->playFifo.evChange, AC_TRANSFER_TIME_OUT)))
+        {
+            pAcSpk->lastError = AC_SPK_DATA_TRANSPORT_ERROR;
+            return (int_t) (uiCount - dwRemaining);
+        }
+    }
+    return (int_t) uiCount;
+}
+/******************************************************************************
+ End of function  acWrite
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acControl
+ Description:   Function to handle custom control functions for the device
+ Arguments:     IN  pStream - Pointer to the file stream
+                IN  ctlCode - The custom control code
+                IN  pCtlStruct - Pointer to the custom control structure
+ Return value:  0 for success -1 on error
+ ******************************************************************************/
+static int_t acControl (st_stream_ptr_t pStream, uint32_t ctlCode, void *pCtlStruct)
+{
+    PACSPK pAcSpk = pStream->p_extension;
+    PSPKDAT pVolume = (PSPKDAT) pCtlStruct;
+    int iResult = AC_SPK_OK;
+
+    switch (ctlCode)
+    {
+        case CTL_GET_SPEAKER_VOLUME :
+        {
+            if (NULL == pVolume)
+            {
+                return -1;
+            }
+            *pVolume = pAcSpk->volume;
+            return 0;
+        }
+        case CTL_SET_SPEAKER_VOLUME :
+        {
+            if (NULL == pVolume)
+            {
+                return -1;
+            }
+            iResult = acSetVolume(pAcSpk, pVolume->siCurVol);
+            break;
+        }
+        case CTL_INC_SPEAKER_VOLUME :
+        {
+            iResult = acSetVolume(pAcSpk, (short) (pAcSpk->volume.siCurVol + pAcSpk->volume.siStepSize));
+            break;
+        }
+        case CTL_DEC_SPEAKER_VOLUME :
+        {
+            iResult = acSetVolume(pAcSpk, (short) (pAcSpk->volume.siCurVol - pAcSpk->volume.siStepSize));
+            break;
+        }
+        case CTL_SET_SPEAKER_MUTE :
+        {
+            if (NULL == pVolume)
+            {
+                return -1;
+            }
+            iResult = acSetMute(pAcSpk, (pVolume->bfMute) ? true : false);
+            break;
+        }
+        case CTL_GET_SPEAKER_SAMPLE_RATE :
+        {
+            if (NULL == pCtlStruct)
+            {
+                return -1;
+            }
+            *((uint32_t *) pCtlStruct) = pAcSpk->audioInfo.dwSampleRate;
+            return 0;
+        }
+        case CTL_SET_SPEAKER_SAMPLE_RATE :
+        {
+            uint32_t dwSampleRate;
+
+            if (NULL == pCtlStruct)
+            {
+                return -1;
+            }
+            dwSampleRate = *((uint32_t *) pCtlStruct);
+
+            /* The rate can only be changed while the streams are stopped */
+            if ((pAcSpk->stats.bfPlaying) || (pAcSpk->stats.bfCapturing))
+            {
+                iResult = AC_SPK_IO_PENDING;
+            }
+            else if (((pAcSpk->audioInfo.Out.bfValid)
+                    && (!usbhAcRateSupported( &pAcSpk->audioInfo.Out, dwSampleRate)))
+                    || ((pAcSpk->audioInfo.In.bfValid)
+                            && (!usbhAcRateSupported( &pAcSpk->audioInfo.In, dwSampleRate))))
+            {
+                iResult = AC_SPK_REQUEST_ERROR;
+            }
+            else
+            {
+                pAcSpk->audioInfo.dwSampleRate = dwSampleRate;
+            }
+            break;
+        }
+        case CTL_GET_SPEAKER_STATUS :
+        {
+            PACSTAT pStat = (PACSTAT) pCtlStruct;
+
+            if (NULL == pStat)
+            {
+                return -1;
+            }
+            *pStat = pAcSpk->stats;
+            pStat->dwSampleRate = pAcSpk->audioInfo.dwSampleRate;
+            pStat->dwNominalRate = pAcSpk->rate.dwNominal;
+            pStat->dwCurrentRate = pAcSpk->rate.dwCurrent;
+            return 0;
+        }
+        case CTL_GET_LAST_ERROR :
+        {
+            if (NULL == pCtlStruct)
+            {
+                return -1;
+            }
+            *((SPKERR *) pCtlStruct) = pAcSpk->lastError;
+            return 0;
+        }
+        default :
+        return -1;
+    }
+
+    if (AC_SPK_OK != iResult)
+    {
+        pAcSpk->lastError = (SPKERR) iResult;
+        return -1;
+    }
+    if (pVolume)
+    {
+        *pVolume = pAcSpk->volume;
+    }
+    return 0;
+}
+/******************************************************************************
+ End of function  acControl
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acDeviceRequest
+ Description:   Function to send a device request
+ Arguments:     IN  pAcSpk - Pointer to the driver extension
+                IN  bmRequestType - The request type
+                IN  bRequest - The request
+                IN  wValue - The Value
+                IN  wIndex - The Index
+                IN  wLength - The length of the data
+                IN/OUT pbyData - Pointer to the data
+ Return value:  0 for success or error code (control.h)
+ ******************************************************************************/
+static int acDeviceRequest (PACSPK pAcSpk, uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue,
+        uint16_t wIndex, uint16_t wLength, uint8_t *pbyData)
+{
+    REQERR reqResult;
+
+    R_OS_AcquireMutex(pAcSpk->pControlMutex);
+    reqResult = usbhDeviceRequest( &pAcSpk->deviceRequest, pAcSpk->pDevice, bmRequestType, bRequest, wValue, wIndex,
+            wLength, pbyData);
+    R_OS_ReleaseMutex(pAcSpk->pControlMutex);
+    if (reqResult)
+    {
+        pAcSpk->lastError = AC_SPK_REQUEST_ERROR;
+        return AC_SPK_REQUEST_ERROR;
+    }
+    return AC_SPK_OK;
+}
+/******************************************************************************
+ End of function  acDeviceRequest
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acReadConfiguration
+ Description:   Function to read and parse the whole configuration descriptor,
+                then read the sample rates and volume range of the device
+ Arguments:     IN  pAcSpk - Pointer to the driver extension
+ Return value:  true if there is a playback or capture stream
+ ******************************************************************************/
+static _Bool acReadConfiguration (PACSPK pAcSpk)
+{
+    PASSERVE48 pAudioInfo = &pAcSpk->audioInfo;
+    uint8_t pbyHeader[9];
+    uint8_t *pbyConfig;
+    uint16_t wTotalLength;
+    _Bool bfResult;
+
+    if (acDeviceRequest(pAcSpk, (uint8_t) (USB_DEVICE_TO_HOST | USB_RECIPIENT_DEVICE), USB_REQUEST_GET_DESCRIPTOR,
+            USB_SET_VALUE(USB_CONFIGURATION_DESCRIPTOR_TYPE, 0), 0, (uint16_t) sizeof(pbyHeader), pbyHeader))
+    {
+        return false;
+    }
+    wTotalLength = (uint16_t) (pbyHeader[2] | (pbyHeader[3] << 8));
+    if (wTotalLength > AC_MAX_CONFIG_SIZE)
+    {
+        TRACE(("acReadConfiguration: Configuration of %u bytes truncated\r\n", wTotalLength));
+        wTotalLength = AC_MAX_CONFIG_SIZE;
+    }
+    pbyConfig = R_OS_AllocMem((size_t) wTotalLength, R_REGION_LARGE_CAPACITY_RAM);
+    if (NULL == pbyConfig)
+    {
+        return false;
+    }
+    if (acDeviceRequest(pAcSpk, (uint8_t) (USB_DEVICE_TO_HOST | USB_RECIPIENT_DEVICE), USB_REQUEST_GET_DESCRIPTOR,
+            USB_SET_VALUE(USB_CONFIGURATION_DESCRIPTOR_TYPE, 0), 0, wTotalLength, pbyConfig))
+    {
+        R_OS_FreeMem(pbyConfig);
+        return false;
+    }
+
+    /* The parser works within the length read */
+    pbyConfig[2] = (uint8_t) wTotalLength;
+    pbyConfig[3] = (uint8_t) (wTotalLength >> 8);
+    bfResult = usbhLoadAudioClass(pAcSpk->pDevice, pbyConfig, true, NULL, pAudioInfo);
+    R_OS_FreeMem(pbyConfig);
+    if (!bfResult)
+    {
+        return false;
+    }
+
+    /* Audio Class 2 rates are read from the clock source */
+    if (pAudioInfo->wADC >= USB_AUDIO_ADC_2_0)
+    {
+        if (pAudioInfo->Out.bfValid)
+        {
+            acReadRates(pAcSpk, &pAudioInfo->Out);
+        }
+        if (pAudioInfo->In.bfValid)
+        {
+            acReadRates(pAcSpk, &pAudioInfo->In);
+        }
+    }
+
+    /* Choose a rate both directions support */
+    if (pAudioInfo->Out.bfValid)
+    {
+        pAudioInfo->dwSampleRate = usbhAcSelectRate( &pAudioInfo->Out, 48000UL);
+        if ((pAudioInfo->In.bfValid) && (!usbhAcRateSupported( &pAudioInfo->In, pAudioInfo->dwSampleRate)))
+        {
+            pAudioInfo->In.bfValid = false;
+        }
+    }
+    else
+    {
+        pAudioInfo->dwSampleRate = usbhAcSelectRate( &pAudioInfo->In, 48000UL);
+    }
+
+    acReadVolume(pAcSpk);
+
+    pAcSpk->stats.wADC = pAudioInfo->wADC;
+    pAcSpk->stats.byOutChannels = pAudioInfo->Out.byNrChannels;
+    pAcSpk->stats.byOutSubslotSize = pAudioInfo->Out.bySubslotSize;
+    pAcSpk->stats.byOutBitResolution = pAudioInfo->Out.byBitResolution;
+    pAcSpk->stats.byOutSyncType = pAudioInfo->Out.bySyncType;
+    pAcSpk->stats.bfExplicitFeedback = (NULL != pAudioInfo->Out.pSyncEndpoint);
+    if (pAudioInfo->In.bfValid)
+    {
+        pAcSpk->stats.byInChannels = pAudioInfo->In.byNrChannels;
+        pAcSpk->stats.byInSubslotSize = pAudioInfo->In.bySubslotSize;
+        pAcSpk->stats.byInBitResolution = pAudioInfo->In.byBitResolution;
+    }
+    return ((pAudioInfo->dwSampleRate) && ((pAudioInfo->Out.bfValid) || (pAudioInfo->In.bfValid)));
+}
+/******************************************************************************
+ End of function  acReadConfiguration
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acReadRates
+ Description:   Function to read the sample rates of an Audio Class 2 stream
+                from its clock source
+ Arguments:     IN  pAcSpk - Pointer to the driver extension
+                IN/OUT pStream - Pointer to the stream
+ Return value:  none
+ ******************************************************************************/
+static void acReadRates (PACSPK pAcSpk, PACSTREAM pStream)
+{
+    uint8_t pbyRange[AC_RANGE_SIZE];
+
+    memset(pbyRange, 0, sizeof(pbyRange));
+    if ((pStream->byClockID)
+            && (0 == acDeviceRequest(pAcSpk, AC_GET_INTERFACE, USB_AUDIO2_REQUEST_RANGE,
+                    USB_SET_VALUE(USB_AUDIO2_CS_SAM_FREQ_CTRL, 0),
+                    USB_SET_INDEX(pStream->byClockID, pAcSpk->audioInfo.byControlInterface),
+                    (uint16_t) sizeof(pbyRange), pbyRange)))
+    {
+        (void) usbhAcParseRange(pStream, pbyRange, sizeof(pbyRange));
+    }
+    if ((0 == pStream->byNumRates) && (0UL == pStream->dwMaxRate))
+    {
+        /* The clock has no range, assume the usual rate */
+        pStream->pdwSampleRate[0] = 48000UL;
+        pStream->byNumRates = 1;
+    }
+}
+/******************************************************************************
+ End of function  acReadRates
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acSetInterface
+ Description:   Function to select the streaming or the zero bandwidth
+                alternate setting of a stream
+ Arguments:     IN  pAcSpk - Pointer to the driver extension
+                IN  pStream - Pointer to the stream
+                IN  bfEnable - true to select the streaming alternate setting
+ Return value:  true for success
+ ******************************************************************************/
+static _Bool acSetInterface (PACSPK pAcSpk, PACSTREAM pStream, _Bool bfEnable)
+{
+    uint8_t byAlternateSetting = (bfEnable) ? pStream->byAlternateSetting : 0;
+
+    if (acDeviceRequest(pAcSpk, (uint8_t) (USB_HOST_TO_DEVICE | USB_RECIPIENT_INTERFACE), USB_REQUEST_SET_INTERFACE,
+            USB_SET_VALUE(0, byAlternateSetting), USB_SET_INDEX(0, pStream->byInterface), 0, NULL))
+    {
+        pAcSpk->lastError = AC_SPK_FAILED_TO_SET_INTERFACE_ERROR;
+        return false;
+    }
+
+    /* Each alternate setting starts with DATA0 */
+    if (pStream->pDataEndpoint)
+    {
+        pStream->pDataEndpoint->dataPID = USBH_DATA0;
+    }
+    return true;
+}
+/******************************************************************************
+ End of function  acSetInterface
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acSetSampleRate
+ Description:   Function to set the sample rate of a stream, on the endpoint
+                for Audio Class 1 and on the clock source for Audio Class 2
+ Arguments:     IN  pAcSpk - Pointer to the driver extension
+                IN  pStream - Pointer to the stream
+ Return value:  true for success or when the rate is fixed
+ ******************************************************************************/
+static _Bool acSetSampleRate (PACSPK pAcSpk, PACSTREAM pStream)
+{
+    uint32_t dwSampleRate = pAcSpk->audioInfo.dwSampleRate;
+    uint8_t pbyRate[4];
+
+    pbyRate[0] = (uint8_t) dwSampleRate;
+    pbyRate[1] = (uint8_t) (dwSampleRate >> 8);
+    pbyRate[2] = (uint8_t) (dwSampleRate >> 16);
+    pbyRate[3] = (uint8_t) (dwSampleRate >> 24);
+
+    if (pAcSpk->audioInfo.wADC >= USB_AUDIO_ADC_2_0)
+    {
+        if (0 == pStream->byClockID)
+        {
+            return true;
+        }
+        return (0 == acDeviceRequest(pAcSpk, AC_SET_INTERFACE, USB_AUDIO2_REQUEST_CUR,
+                USB_SET_VALUE(USB_AUDIO2_CS_SAM_FREQ_CTRL, 0),
+                USB_SET_INDEX(pStream->byClockID, pAcSpk->audioInfo.byControlInterface), 4, pbyRate));
+    }
+    if ((!pStream->bfRateControl) || (pStream->byNumRates == 1))
+    {
+        return true;
+    }
+    return (0 == acDeviceRequest(pAcSpk, AC_SET_ENDPOINT, USB_AUDIO_REQUEST_SET_CUR,
+            USB_SET_VALUE(USB_AUDIO_SAMP_FREQ_CTRL, 0), USB_SET_INDEX(0, pStream->byEndpointAddress), 3, pbyRate));
+}
+/******************************************************************************
+ End of function  acSetSampleRate
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acReadVolume
+ Description:   Function to read the volume range and settings of the feature
+                unit in the playback path
+ Arguments:     IN  pAcSpk - Pointer to the driver extension
+ Return value:  none
+ ******************************************************************************/
+static void acReadVolume (PACSPK pAcSpk)
+{
+    PACSTREAM pOut = &pAcSpk->audioInfo.Out;
+    uint16_t wIndex = USB_SET_INDEX(pOut->byFeatureUnit, pAcSpk->audioInfo.byControlInterface);
+    uint16_t wValue;
+    uint8_t pbyData[8];
+    short siMin = 0, siMax = 0, siRes = 0, siCur = 0;
+
+    if ((!pOut->bfValid) || (0 == pOut->byFeatureUnit) || (0 == pOut->byVolumeChannels))
+    {
+        return;
+    }
+
+    /* Use the master channel when it has a volume control */
+    pAcSpk->byVolumeChannel = (pOut->byVolumeChannels & BIT_0) ? 0 : 1;
+    wValue = USB_SET_VALUE(USB_AUDIO_VOLUME_CTRL, pAcSpk->byVolumeChannel);
+
+    memset(pbyData, 0, sizeof(pbyData));
+    if (pAcSpk->audioInfo.wADC >= USB_AUDIO_ADC_2_0)
+    {
+        if (acDeviceRequest(pAcSpk, AC_GET_INTERFACE, USB_AUDIO2_REQUEST_RANGE, wValue, wIndex, 8, pbyData))
+        {
+            return;
+        }
+        siMin = (short) (pbyData[2] | (pbyData[3] << 8));
+        siMax = (short) (pbyData[4] | (pbyData[5] << 8));
+        siRes = (short) (pbyData[6] | (pbyData[7] << 8));
+        if (acDeviceRequest(pAcSpk, AC_GET_INTERFACE, USB_AUDIO2_REQUEST_CUR, wValue, wIndex, 2, pbyData))
+        {
+            return;
+        }
+        siCur = (short) (pbyData[0] | (pbyData[1] << 8));
+    }
+    else
+    {
+        if (acDeviceRequest(pAcSpk, AC_GET_INTERFACE, USB_AUDIO_REQUEST_GET_MIN, wValue, wIndex, 2, pbyData))
+        {
+            return;
+        }
+        siMin = (short) (pbyData[0] | (pbyData[1] << 8));
+        if (acDeviceRequest(pAcSpk, AC_GET_INTERFACE, USB_AUDIO_REQUEST_GET_MAX, wValue, wIndex, 2, pbyData))
+        {
+            return;
+        }
+        siMax = (short) (pbyData[0] | (pbyData[1] << 8));
+        if (acDeviceRequest(pAcSpk, AC_GET_INTERFACE, USB_AUDIO_REQUEST_GET_RES, wValue, wIndex, 2, pbyData))
+        {
+            return;
+        }
+        siRes = (short) (pbyData[0] | (pbyData[1] << 8));
+        if (acDeviceRequest(pAcSpk, AC_GET_INTERFACE, USB_AUDIO_REQUEST_GET_CUR, wValue, wIndex, 2, pbyData))
+        {
+            return;
+        }
+        siCur = (short) (pbyData[0] | (pbyData[1] << 8));
+    }
+
+    if (siRes <= 0)
+    {
+        siRes = 256;
+    }
+    pAcSpk->volume.siMinVol = siMin;
+    pAcSpk->volume.siMaxVol = siMax;
+    pAcSpk->volume.siStepSize = siRes;
+    pAcSpk->volume.siVolSteps = (short) ((siMax > siMin) ? ((siMax - siMin) / siRes) : 0);
+    pAcSpk->volume.siCurVol = siCur;
+}
+/******************************************************************************
+ End of function  acReadVolume
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acSetVolume
+ Description:   Function to set the volume of the playback feature unit, both
+                logical channels are set when there is no master control
+ Arguments:     IN  pAcSpk - Pointer to the driver extension
+                IN  siVolume - The volume in 1/256dB
+ Return value:  0 for success or error code (control.h)
+ ******************************************************************************/
+static int acSetVolume (PACSPK pAcSpk, short siVolume)
+{
+    PACSTREAM pOut = &pAcSpk->audioInfo.Out;
+    uint16_t wIndex = USB_SET_INDEX(pOut->byFeatureUnit, pAcSpk->audioInfo.byControlInterface);
+    uint8_t bRequest = (pAcSpk->audioInfo.wADC >= USB_AUDIO_ADC_2_0) ? USB_AUDIO2_REQUEST_CUR
+            : USB_AUDIO_REQUEST_SET_CUR;
+    uint8_t pbyData[2];
+    uint8_t byChannel;
+
+    if (0 == pAcSpk->volume.siVolSteps)
+    {
+        return AC_SPK_REQUEST_ERROR;
+    }
+    if (siVolume > pAcSpk->volume.siMaxVol)
+    {
+        siVolume = pAcSpk->volume.siMaxVol;
+    }
+    if (siVolume < pAcSpk->volume.siMinVol)
+    {
+        siVolume = pAcSpk->volume.siMinVol;
+    }
+    pbyData[0] = (uint8_t) siVolume;
+    pbyData[1] = (uint8_t) ((uint16_t) siVolume >> 8);
+
+    for (byChannel = pAcSpk->byVolumeChannel; byChannel < USB_SPK_MAX_CHANNELS; byChannel++)
+    {
+        if (pOut->byVolumeChannels & (1 << byChannel))
+        {
+            if (acDeviceRequest(pAcSpk, AC_SET_INTERFACE, bRequest, USB_SET_VALUE(USB_AUDIO_VOLUME_CTRL, byChannel),
+                    wIndex, 2, pbyData))
+            {
+                return AC_SPK_REQUEST_ERROR;
+            }
+        }
+        if (0 == byChannel)
+        {
+            break;
+        }
+    }
+    pAcSpk->volume.siCurVol = siVolume;
+    return AC_SPK_OK;
+}
+/******************************************************************************
+ End of function  acSetVolume
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acSetMute
+ Description:   Function to set the mute of the playback feature unit
+ Arguments:     IN  pAcSpk - Pointer to the driver extension
+                IN  bfMute - true to mute
+ Return value:  0 for success or error code (control.h)
+ ******************************************************************************/
+static int acSetMute (PACSPK pAcSpk, _Bool bfMute)
+{
+    PACSTREAM pOut = &pAcSpk->audioInfo.Out;
+    uint8_t bRequest = (pAcSpk->audioInfo.wADC >= USB_AUDIO_ADC_2_0) ? USB_AUDIO2_REQUEST_CUR
+            : USB_AUDIO_REQUEST_SET_CUR;
+    uint8_t byMute = (bfMute) ? 1 : 0;
+    uint8_t byChannel;
+
+    if ((0 == pOut->byFeatureUnit) || (0 == pOut->byMuteChannels))
+    {
+        return AC_SPK_REQUEST_ERROR;
+    }
+    for (byChannel = 0; byChannel < USB_SPK_MAX_CHANNELS; byChannel++)
+    {
+        if ((pOut->byMuteChannels & (1 << byChannel))
+                && (acDeviceRequest(pAcSpk, AC_SET_INTERFACE, bRequest, USB_SET_VALUE(USB_AUDIO_MUTE_CTRL, byChannel),
+                        USB_SET_INDEX(pOut->byFeatureUnit, pAcSpk->audioInfo.byControlInterface), 1, &byMute)))
+        {
+            return AC_SPK_REQUEST_ERROR;
+        }
+
+        /* The master channel mutes them all */
+        if (pOut->byMuteChannels & BIT_0)
+        {
+            break;
+        }
+    }
+    pAcSpk->volume.bfMute = byMute;
+    return AC_SPK_OK;
+}
+/******************************************************************************
+ End of function  acSetMute
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acFifoCreate
+ Description:   Function to create a PCM FIFO
+ Arguments:     OUT pFifo - Pointer to the FIFO
+ Return value:  true for success
+ ******************************************************************************/
+static _Bool acFifoCreate (PACFIFO pFifo)
+{
+    pFifo->pbyData = R_OS_AllocMem(AC_FIFO_SIZE, R_REGION_LARGE_CAPACITY_RAM);
+    pFifo->dwIn = 0UL;
+    pFifo->dwOut = 0UL;
+    R_OS_CreateEvent( &pFifo->evChange);
+    return (NULL != pFifo->pbyData);
+}
+/******************************************************************************
+ End of function  acFifoCreate
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acFifoDestroy
+ Description:   Function to destroy a PCM FIFO
+ Arguments:     IN  pFifo - Pointer to the FIFO, may not have been created
+ Return value:  none
+ ******************************************************************************/
+static void acFifoDestroy (PACFIFO pFifo)
+{
+    if (pFifo->evChange)
+    {
+        R_OS_DeleteEvent( &pFifo->evChange);
+    }
+    if (pFifo->pbyData)
+    {
+        R_OS_FreeMem(pFifo->pbyData);
+        pFifo->pbyData = NULL;
+    }
+}
+/******************************************************************************
+ End of function  acFifoDestroy
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acFifoUsed
+ Description:   Function to get the number of bytes in a FIFO
+ Arguments:     IN  pFifo - Pointer to the FIFO
+ Return value:  The number of bytes
+ ******************************************************************************/
+static uint32_t acFifoUsed (PACFIFO pFifo)
+{
+    return (pFifo->dwIn - pFifo->dwOut);
+}
+/******************************************************************************
+ End of function  acFifoUsed
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acFifoPut
+ Description:   Function to add as much data as will fit to a FIFO
+ Arguments:     IN  pFifo - Pointer to the FIFO
+                IN  pbySrc - Pointer to the data
+                IN  dwLength - The length of the data
+ Return value:  The number of bytes added
+ ******************************************************************************/
+static uint32_t acFifoPut (PACFIFO pFifo, const uint8_t *pbySrc, uint32_t dwLength)
+{
+    uint32_t dwFree = AC_FIFO_SIZE - acFifoUsed(pFifo);
+    uint32_t dwIndex = pFifo->dwIn & (AC_FIFO_SIZE - 1);
+    uint32_t dwFirst;
+
+    if (dwLength > dwFree)
+    {
+        dwLength = dwFree;
+    }
+    dwFirst = AC_FIFO_SIZE - dwIndex;
+    if (dwFirst > dwLength)
+    {
+        dwFirst = dwLength;
+    }
+    memcpy(pFifo->pbyData + dwIndex, pbySrc, dwFirst);
+    memcpy(pFifo->pbyData, pbySrc + dwFirst, dwLength - dwFirst);
+    pFifo->dwIn += dwLength;
+    return dwLength;
+}
+/******************************************************************************
+ End of function  acFifoPut
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acFifoGet
+ Description:   Function to take data from a FIFO
+ Arguments:     IN  pFifo - Pointer to the FIFO
+                OUT pbyDest - Pointer to the destination
+                IN  dwLength - The length wanted
+ Return value:  The number of bytes taken
+ ******************************************************************************/
+static uint32_t acFifoGet (PACFIFO pFifo, uint8_t *pbyDest, uint32_t dwLength)
+{
+    uint32_t dwUsed = acFifoUsed(pFifo);
+    uint32_t dwIndex = pFifo->dwOut & (AC_FIFO_SIZE - 1);
+    uint32_t dwFirst;
+
+    if (dwLength > dwUsed)
+    {
+        dwLength = dwUsed;
+    }
+    dwFirst = AC_FIFO_SIZE - dwIndex;
+    if (dwFirst > dwLength)
+    {
+        dwFirst = dwLength;
+    }
+    memcpy(pbyDest, pFifo->pbyData + dwIndex, dwFirst);
+    memcpy(pbyDest + dwFirst, pFifo->pbyData, dwLength - dwFirst);
+    pFifo->dwOut += dwLength;
+    return dwLength;
+}
+/******************************************************************************
+ End of function  acFifoGet
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acQueueOut
+ Description:   Function to fill an OUT transfer from the playback FIFO and
+                queue it. The size of each packet comes from the current rate,
+                silence is sent when the FIFO runs dry.
+ Arguments:     IN  pAcSpk - Pointer to the driver extension
+                IN  iRequest - The index of the request to queue
+ Return value:  true if data was taken from the FIFO
+ ******************************************************************************/
+static _Bool acQueueOut (PACSPK pAcSpk, int iRequest)
+{
+    PACSTREAM pOut = &pAcSpk->audioInfo.Out;
+    uint8_t *pbyBuffer = pAcSpk->pbyOutBuffer[iRequest];
+    size_t stLength = 0;
+    _Bool bfData = false;
+    int iPacket;
+
+    for (iPacket = 0; iPacket < AC_PACKETS_PER_TRANSFER; iPacket++)
+    {
+        uint32_t dwBytes = usbhAcRateNextPacket( &pAcSpk->rate) * pAcSpk->dwOutFrameSize;
+        uint32_t dwTaken = acFifoGet( &pAcSpk->playFifo, pbyBuffer + stLength, dwBytes);
+
+        if (dwTaken < dwBytes)
+        {
+            memset(pbyBuffer + stLength + dwTaken, 0, dwBytes - dwTaken);
+            pAcSpk->stats.dwUnderruns++;
+        }
+        if (dwTaken)
+        {
+            bfData = true;
+        }
+        pAcSpk->pwPacketSize[iRequest][iPacket] = (uint16_t) dwBytes;
+        stLength += dwBytes;
+    }
+    R_OS_SetEvent( &pAcSpk->playFifo.evChange);
+
+    pAcSpk->outSchedule[iRequest].pwPacketSizeList = pAcSpk->pwPacketSize[iRequest];
+    pAcSpk->outSchedule[iRequest].iScheduleIndex = 0;
+    pAcSpk->outSchedule[iRequest].iListLength = AC_PACKETS_PER_TRANSFER;
+    pAcSpk->outSchedule[iRequest].wPacketSize = 0;
+    if (!usbhIsocTransfer(pAcSpk->pDevice, &pAcSpk->outRequest[iRequest], &pAcSpk->outSchedule[iRequest],
+            pOut->pDataEndpoint, pbyBuffer, stLength, AC_TRANSFER_TIME_OUT))
+    {
+        pAcSpk->stats.dwTransferErrors++;
+    }
+    return bfData;
+}
+/******************************************************************************
+ End of function  acQueueOut
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acFeedback
+ Description:   Function to use the last feedback value and request the next.
+                The read is queued behind any capture transfer on the
+                isochronous IN pipe and never waited for.
+ Arguments:     IN  pAcSpk - Pointer to the driver extension
+ Return value:  none
+ ******************************************************************************/
+static void acFeedback (PACSPK pAcSpk)
+{
+    PACSTREAM pOut = &pAcSpk->audioInfo.Out;
+
+    pAcSpk->dwFramesSinceFeedback += AC_PACKETS_PER_TRANSFER * pAcSpk->rate.dwFramesPerPacket;
+
+    /* A completed read */
+    if (pAcSpk->bfSyncQueued)
+    {
+        if (usbhTransferInProgress( &pAcSpk->syncRequest))
+        {
+            return;
+        }
+        if ((USBH_NO_ERROR == pAcSpk->syncRequest.errorCode)
+                && (usbhAcRateFeedback( &pAcSpk->rate, (uint8_t *) pAcSpk->pdwFeedback,
+                        (size_t) pAcSpk->syncRequest.uiTransferLength)))
+        {
+            pAcSpk->stats.dwFeedbackReads++;
+        }
+        else
+        {
+            pAcSpk->stats.dwFeedbackRejected++;
+        }
+        pAcSpk->bfSyncQueued = false;
+    }
+
+    if (pAcSpk->dwFramesSinceFeedback >= pAcSpk->dwFeedbackPeriod)
+    {
+        pAcSpk->dwFramesSinceFeedback = 0UL;
+        pAcSpk->pdwFeedback[0] = 0UL;
+        pAcSpk->bfSyncQueued = usbhIsocTransfer(pAcSpk->pDevice, &pAcSpk->syncRequest, NULL, pOut->pSyncEndpoint,
+                (uint8_t *) pAcSpk->pdwFeedback, (size_t) pOut->wSyncPacketSize, AC_TRANSFER_TIME_OUT);
+    }
+}
+/******************************************************************************
+ End of function  acFeedback
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: ac_play_task
+ Description:   Task to stream the playback FIFO to the device. Two OUT
+                transfers are kept queued so there is always one ready when
+                the other completes.
+ Arguments:     IN  pAcSpk - Pointer to the driver extension
+ Return value:  none
+ ******************************************************************************/
+static void ac_play_task (PACSPK pAcSpk)
+{
+    PACSTREAM pOut = &pAcSpk->audioInfo.Out;
+
+    while (true)
+    {
+        int iNext = 0;
+        int iIdle = 0;
+        int iRequest;
+
+        R_OS_WaitForEvent( &pAcSpk->evPlay, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
+        if ((!pAcSpk->bfPlay) || (pAcSpk->bfClosing))
+        {
+            continue;
+        }
+        pAcSpk->stats.bfPlaying = true;
+
+        if ((!acSetInterface(pAcSpk, pOut, true)) || (!acSetSampleRate(pAcSpk, pOut)))
+        {
+            TRACE(("ac_play_task: Failed to start the stream\r\n"));
+            pAcSpk->bfPlay = false;
+            pAcSpk->stats.bfPlaying = false;
+            continue;
+        }
+        usbhAcRateInit( &pAcSpk->rate, pAcSpk->audioInfo.dwSampleRate,
+                (_Bool) (USBH_HIGH == pAcSpk->pDevice->transferSpeed), pOut->byInterval,
+                (uint32_t) pOut->wMaxPacketSize / pAcSpk->dwOutFrameSize);
+
+        /* Feedback every 2^bRefresh frames, at least every 8 */
+        pAcSpk->dwFeedbackPeriod = 1UL << ((pOut->bySyncRefresh > 3) ? ((pOut->bySyncRefresh > 9) ? 9
+                : pOut->bySyncRefresh) : 3);
+        pAcSpk->dwFramesSinceFeedback = pAcSpk->dwFeedbackPeriod;
+        pAcSpk->bfSyncQueued = false;
+
+        for (iRequest = 0; iRequest < AC_NUM_REQUESTS; iRequest++)
+        {
+            (void) acQueueOut(pAcSpk, iRequest);
+        }
+
+        while (pAcSpk->bfPlay)
+        {
+            if (!R_OS_WaitForEvent( &pAcSpk->outRequest[iNext].ioSignal, AC_TRANSFER_TIME_OUT))
+            {
+                pAcSpk->lastError = AC_SPK_DATA_TRANSPORT_ERROR;
+                pAcSpk->stats.dwTransferErrors++;
+                break;
+            }
+            if (USBH_NO_ERROR != pAcSpk->outRequest[iNext].errorCode)
+            {
+                pAcSpk->stats.dwTransferErrors++;
+            }
+            pAcSpk->stats.dwPacketsOut += AC_PACKETS_PER_TRANSFER;
+
+            if (pOut->pSyncEndpoint)
+            {
+                acFeedback(pAcSpk);
+            }
+
+            /* Stop when the application stops writing */
+            if (acQueueOut(pAcSpk, iNext))
+            {
+                iIdle = 0;
+            }
+            else if (++iIdle >= AC_IDLE_TRANSFERS)
+            {
+                pAcSpk->bfPlay = false;
+            }
+            iNext = (iNext + 1) % AC_NUM_REQUESTS;
+        }
+
+        for (iRequest = 0; iRequest < AC_NUM_REQUESTS; iRequest++)
+        {
+            if (usbhTransferInProgress( &pAcSpk->outRequest[iRequest]))
+            {
+                usbhCancelTransfer( &pAcSpk->outRequest[iRequest]);
+            }
+        }
+        if ((pAcSpk->bfSyncQueued) && (usbhTransferInProgress( &pAcSpk->syncRequest)))
+        {
+            usbhCancelTransfer( &pAcSpk->syncRequest);
+        }
+        (void) acSetInterface(pAcSpk, pOut, false);
+        pAcSpk->bfPlay = false;
+        pAcSpk->stats.bfPlaying = false;
+    }
+}
+/******************************************************************************
+ End of function  ac_play_task
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: ac_capture_task
+ Description:   Task to stream the device to the capture FIFO. Isochronous IN
+                transfers complete on a short packet so each transfer is one
+                packet, two are kept queued. When playback has no feedback
+                endpoint the capture packet sizes give the device clock.
+ Arguments:     IN  pAcSpk - Pointer to the driver extension
+ Return value:  none
+ ******************************************************************************/
+static void ac_capture_task (PACSPK pAcSpk)
+{
+    PACSTREAM pIn = &pAcSpk->audioInfo.In;
+
+    while (true)
+    {
+        int iNext = 0;
+        int iIdle = 0;
+        int iRequest;
+
+        R_OS_WaitForEvent( &pAcSpk->evCapture, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
+        if ((!pAcSpk->bfCapture) || (pAcSpk->bfClosing))
+        {
+            continue;
+        }
+        pAcSpk->stats.bfCapturing = true;
+
+        if ((!acSetInterface(pAcSpk, pIn, true)) || (!acSetSampleRate(pAcSpk, pIn)))
+        {
+            TRACE(("ac_capture_task: Failed to start the stream\r\n"));
+            pAcSpk->bfCapture = false;
+            pAcSpk->stats.bfCapturing = false;
+            continue;
+        }
+
+        for (iRequest = 0; iRequest < AC_NUM_REQUESTS; iRequest++)
+        {
+            (void) usbhIsocTransfer(pAcSpk->pDevice, &pAcSpk->inRequest[iRequest], NULL, pIn->pDataEndpoint,
+                    pAcSpk->pbyInBuffer[iRequest], (size_t) pIn->wMaxPacketSize, AC_TRANSFER_TIME_OUT);
+        }
+
+        while (pAcSpk->bfCapture)
+        {
+            PUSBTR pRequest = &pAcSpk->inRequest[iNext];
+            uint32_t dwLength;
+
+            if (!R_OS_WaitForEvent( &pRequest->ioSignal, AC_TRANSFER_TIME_OUT))
+            {
+                pAcSpk->lastError = AC_SPK_DATA_TRANSPORT_ERROR;
+                pAcSpk->stats.dwTransferErrors++;
+                break;
+            }
+            dwLength = (USBH_NO_ERROR == pRequest->errorCode) ? pRequest->uiTransferLength : 0UL;
+            dwLength -= dwLength % pAcSpk->dwInFrameSize;
+            if (USBH_NO_ERROR != pRequest->errorCode)
+            {
+                pAcSpk->stats.dwTransferErrors++;
+            }
+            pAcSpk->stats.dwPacketsIn++;
+
+            if ((pAcSpk->stats.bfPlaying) && (NULL == pAcSpk->audioInfo.Out.pSyncEndpoint)
+                    && (USB_AC_SYNC_ASYNCHRONOUS == pAcSpk->audioInfo.Out.bySyncType))
+            {
+                usbhAcRateImplicit( &pAcSpk->rate, dwLength / pAcSpk->dwInFrameSize);
+            }
+
+            /* Stop when the application stops reading */
+            if (acFifoPut( &pAcSpk->captureFifo, pAcSpk->pbyInBuffer[iNext], dwLength) < dwLength)
+            {
+                pAcSpk->stats.dwOverruns++;
+                if (++iIdle >= AC_IDLE_PACKETS)
+                {
+                    pAcSpk->bfCapture = false;
+                }
+            }
+            else
+            {
+                iIdle = 0;
+            }
+            R_OS_SetEvent( &pAcSpk->captureFifo.evChange);
+
+            (void) usbhIsocTransfer(pAcSpk->pDevice, pRequest, NULL, pIn->pDataEndpoint,
+                    pAcSpk->pbyInBuffer[iNext], (size_t) pIn->wMaxPacketSize, AC_TRANSFER_TIME_OUT);
+            iNext = (iNext + 1) % AC_NUM_REQUESTS;
+        }
+
+        for (iRequest = 0; iRequest < AC_NUM_REQUESTS; iRequest++)
+        {
+            if (usbhTransferInProgress( &pAcSpk->inRequest[iRequest]))
+            {
+                usbhCancelTransfer( &pAcSpk->inRequest[iRequest]);
+            }
+        }
+        (void) acSetInterface(pAcSpk, pIn, false);
+
+        /* Discard what was not read */
+        pAcSpk->captureFifo.dwOut = pAcSpk->captureFifo.dwIn;
+        pAcSpk->bfCapture = false;
+        pAcSpk->stats.bfCapturing = false;
+    }
+}
+/******************************************************************************
+ End of function  ac_capture_task
+ ******************************************************************************/
+
+/******************************************************************************
+ End  Of File
+ ******************************************************************************/
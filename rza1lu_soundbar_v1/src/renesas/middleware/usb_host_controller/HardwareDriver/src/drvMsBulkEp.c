@@ -89,6 +89,13 @@ typedef struct _BULKEP
     PUSBEI   pInEndpoint;
     /* The current time-out */
     uint32_t dwTimeOut_mS;
+    /* Set by CTL_SET_OVERLAPPED_xxx_EVENT, the next read or write returns as
+       soon as the transfer has started */
+    _Bool    bfOverlappedRead;
+    _Bool    bfOverlappedWrite;
+    /* Set while an overlapped transfer has not been collected */
+    _Bool    bfReadPending;
+    _Bool    bfWritePending;
 
     /* The mutex event to make sure that devices with more than one logical
      uint are accessed sequentially */
@@ -114,6 +121,7 @@ static int blkepWrite (st_stream_ptr_t pstream, uint8_t *pbyBuffer, uint32_t uiC
 static int blkepControl (st_stream_ptr_t pstream, uint32_t ctlCode, void *pCtlStruct);
 static PUSBEI blkepGetFirstEndpoint (PUSBDI pDevice, USBDIR transferDirection);
 static int bulkepSetErrorCode (REQERR errorCode);
+static int blkepGetOverlappedResult (PBULKEP pBulkEp, PUSBTR pRequest, _Bool *pbfPending, POLD pOverlapped);
 
 /******************************************************************************
  Constant Data
@@ -250,7 +258,15 @@ static int blkepRead (st_stream_ptr_t pstream, uint8_t *pbyBuffer, uint32_t uiCo
                 (size_t) uiCount, pBulkEp->dwTimeOut_mS);
 
         /* If the transfer was started */
-        if (bfResult)
+        if ((bfResult) && (pBulkEp->bfOverlappedRead))
+        {
+            /* Collected with CTL_GET_OVERLAPPED_READ_RESULT */
+            pBulkEp->bfOverlappedRead = false;
+            pBulkEp->bfReadPending = true;
+            pBulkEp->lastError = BULK_EP_IO_PENDING;
+            return 0;
+        }
+        else if (bfResult)
         {
             /* Wait for the transfer to complete or time-out */
             R_OS_WaitForEvent(&pBulkEp->readRequest.ioSignal, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
@@ -268,6 +284,7 @@ static int blkepRead (st_stream_ptr_t pstream, uint8_t *pbyBuffer, uint32_t uiCo
         }
         else
         {
+            pBulkEp->bfOverlappedRead = false;
             TRACE(("blkepRead: Failed to start transfer\r\n"));
             pBulkEp->lastError = BULK_EP_REQUEST_ERROR;
         }
@@ -296,7 +313,15 @@ static int blkepWrite (st_stream_ptr_t pstream, uint8_t *pbyBuffer, uint32_t uiC
         bfResult = usbhStartTransfer(pBulkEp->pDevice, &pBulkEp->writeRequest, pBulkEp->pOutEndpoint, pbyBuffer,
                 (size_t) uiCount, pBulkEp->dwTimeOut_mS);
         /* If the transfer was started */
-        if (bfResult)
+        if ((bfResult) && (pBulkEp->bfOverlappedWrite))
+        {
+            /* Collected with CTL_GET_OVERLAPPED_WRITE_RESULT */
+            pBulkEp->bfOverlappedWrite = false;
+            pBulkEp->bfWritePending = true;
+            pBulkEp->lastError = BULK_EP_IO_PENDING;
+            return 0;
+        }
+        else if (bfResult)
         {
             /* Wait for the transfer to complete or time-out */
             R_OS_WaitForEvent(&pBulkEp->writeRequest.ioSignal, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
@@ -314,6 +339,7 @@ static int blkepWrite (st_stream_ptr_t pstream, uint8_t *pbyBuffer, uint32_t uiC
         }
         else
         {
+            pBulkEp->bfOverlappedWrite = false;
             TRACE(("blkepWrite: Failed to start transfer\r\n"));
             pBulkEp->lastError = BULK_EP_REQUEST_ERROR;
         }
@@ -546,6 +572,41 @@ static int blkepControl (st_stream_ptr_t pstream, uint32_t ctlCode, void *pCtlSt
             }
             return BULK_EP_NO_ERROR;
 
+        case CTL_SET_OVERLAPPED_READ_EVENT :
+            /* The transfer's own event is used, pCtlStruct is not needed */
+            pBulkEp->bfOverlappedRead = true;
+            return BULK_EP_NO_ERROR;
+
+        case CTL_SET_OVERLAPPED_WRITE_EVENT :
+            pBulkEp->bfOverlappedWrite = true;
+            return BULK_EP_NO_ERROR;
+
+        case CTL_GET_OVERLAPPED_READ_RESULT :
+            return blkepGetOverlappedResult(pBulkEp, &pBulkEp->readRequest, &pBulkEp->bfReadPending,
+                    (POLD) pCtlStruct);
+
+        case CTL_GET_OVERLAPPED_WRITE_RESULT :
+            return blkepGetOverlappedResult(pBulkEp, &pBulkEp->writeRequest, &pBulkEp->bfWritePending,
+                    (POLD) pCtlStruct);
+
+        case CTL_CANCEL_OVERLAPPED_READ :
+            if (pBulkEp->bfReadPending)
+            {
+                usbhCancelTransfer(&pBulkEp->readRequest);
+                R_OS_ResetEvent(&pBulkEp->readRequest.ioSignal);
+                pBulkEp->bfReadPending = false;
+            }
+            return BULK_EP_NO_ERROR;
+
+        case CTL_CANCEL_OVERLAPPED_WRITE :
+            if (pBulkEp->bfWritePending)
+            {
+                usbhCancelTransfer(&pBulkEp->writeRequest);
+                R_OS_ResetEvent(&pBulkEp->writeRequest.ioSignal);
+                pBulkEp->bfWritePending = false;
+            }
+            return BULK_EP_NO_ERROR;
+
         case CTL_USB_MS_RESET :
             return blkepMsReset(pBulkEp);
 
@@ -600,6 +661,44 @@ static int blkepControl (st_stream_ptr_t pstream, uint32_t ctlCode, void *pCtlSt
  End of function  blkepControl
  ******************************************************************************/
 
+/******************************************************************************
+ Function Name: blkepGetOverlappedResult
+ Description:   Function to wait for an overlapped transfer to complete
+ Arguments:     IN  pBulkEp - Pointer to the driver data
+                IN  pRequest - Pointer to the transfer request
+                IN/OUT pbfPending - Pointer to the pending flag of the request
+                OUT pOverlapped - Pointer to the length and error code
+ Return value:  0 for success -1 if no transfer was pending
+ ******************************************************************************/
+static int blkepGetOverlappedResult (PBULKEP pBulkEp, PUSBTR pRequest, _Bool *pbfPending, POLD pOverlapped)
+{
+    if ((!*pbfPending) || (!pOverlapped))
+    {
+        return -1;
+    }
+
+    /* Wait for the transfer to complete or time-out */
+    R_OS_WaitForEvent(&pRequest->ioSignal, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE);
+    *pbfPending = false;
+
+    if (pRequest->errorCode)
+    {
+        TRACE(("blkepGetOverlappedResult: Error %d\r\n", pRequest->errorCode));
+        pBulkEp->lastError = (BLKERR) bulkepSetErrorCode(pRequest->errorCode);
+        pOverlapped->stLength = 0UL;
+    }
+    else
+    {
+        pBulkEp->lastError = BULK_EP_NO_ERROR;
+        pOverlapped->stLength = (size_t) pRequest->uiTransferLength;
+    }
+    pOverlapped->iResult = (int) pBulkEp->lastError;
+    return 0;
+}
+/******************************************************************************
+ End of function  blkepGetOverlappedResult
+ ******************************************************************************/
+
 /******************************************************************************
  Function Name: blkepGetFirstEndpoint
  Description:   Function to get the first bulk endpoint with matching transfer
@@ -133,6 +133,7 @@ static void dskDismountDevice (int iMsDev);
 static DSKERR dskMountUnit (int iMsDev, int iLun, PDSKLST pDisk, _Bool bfAdd);
 static _Bool dskRemoveDisk (PDSKLST pDisk);
 static int dskCountAttachedDrives (int iMsDev);
+static void dskNotifyMediaChange (void);
 
 /******************************************************************************
  Global Variables
@@ -142,6 +143,9 @@ static PDSKLST gpDiskList = NULL;
 static int initaliser =  R_OS_ABSTRACTION_PRV_INVALID_HANDLE;
 static os_task_t *guiTaskID = &initaliser;
 static event_t gpevNewDrive = NULL;
+static PDSKCB gpMediaCallback = NULL;
+/* Bit per drive letter from A, as last reported to gpMediaCallback */
+static uint32_t gulMountedDrives = 0;
 
 /******************************************************************************
  Public Functions
@@ -293,6 +297,8 @@ int dskMountAllDevices (void)
             }
             pListTop = pListTop->pNext;
         }
+        /* Tell the application what has come and gone */
+        dskNotifyMediaChange();
     }
     else
     {
@@ -305,6 +311,25 @@ int dskMountAllDevices (void)
  End of function  dskMountAllDevices
  ******************************************************************************/
 
+/******************************************************************************
+ Function Name: dskSetMediaCallback
+ Description:   Function to be told when drives are mounted and dismounted
+ Arguments:     IN  pCallback - The function to call, NULL for none
+ Return value:  none
+ ******************************************************************************/
+void dskSetMediaCallback (PDSKCB pCallback)
+{
+    R_OS_SysWaitAccess();
+    gpMediaCallback = pCallback;
+    /* Report the drives that are already mounted */
+    gulMountedDrives = 0;
+    dskNotifyMediaChange();
+    R_OS_SysReleaseAccess();
+}
+/******************************************************************************
+ End of function  dskSetMediaCallback
+ ******************************************************************************/
+
 /******************************************************************************
  Function Name: dskDismountAllDevices
  Description:   Function to dismount and close all devices
@@ -323,6 +348,7 @@ void dskDismountAllDevices (void)
         close(iMsDev);
         ppDiskList = &gpDiskList;
     }
+    dskNotifyMediaChange();
     R_OS_SysReleaseAccess();
 }
 /******************************************************************************
@@ -368,6 +394,7 @@ _Bool dskEjectMedia (int8_t chDriveLetter)
             pDiskToEject->chDriveLetter = '?';
         }
         bfResult = true;
+        dskNotifyMediaChange();
     }
     R_OS_SysReleaseAccess();
     return bfResult;
@@ -820,6 +847,44 @@ static int dskCountAttachedDrives (int iMsDev)
  End of function  dskCountAttachedDrives
  ******************************************************************************/
 
+/******************************************************************************
+ Function Name: dskNotifyMediaChange
+ Description:   Function to call the media callback for each drive letter that
+                has been mounted or dismounted since it was last called
+ Arguments:     none
+ Return value:  none
+ ******************************************************************************/
+static void dskNotifyMediaChange (void)
+{
+    PDSKLST pDiskList = gpDiskList;
+    uint32_t ulMounted = 0;
+    uint32_t ulChanged;
+    int iDrive;
+    while (pDiskList)
+    {
+        if ((pDiskList->chDriveLetter >= 'A') && (pDiskList->chDriveLetter <= 'Z') && (pDiskList->pDrive))
+        {
+            ulMounted |= (1UL << (pDiskList->chDriveLetter - 'A'));
+        }
+        pDiskList = pDiskList->pNext;
+    }
+    ulChanged = ulMounted ^ gulMountedDrives;
+    gulMountedDrives = ulMounted;
+    if (gpMediaCallback)
+    {
+        for (iDrive = 0; ulChanged; iDrive++, ulChanged >>= 1)
+        {
+            if (ulChanged & 1UL)
+            {
+                gpMediaCallback((int8_t) ('A' + iDrive), (ulMounted & (1UL << iDrive)) ? true : false);
+            }
+        }
+    }
+}
+/******************************************************************************
+ End of function  dskNotifyMediaChange
+ ******************************************************************************/
+
 /******************************************************************************
  Function Name: dskRemoveDisk
  Description:   Function to remove a drive letter
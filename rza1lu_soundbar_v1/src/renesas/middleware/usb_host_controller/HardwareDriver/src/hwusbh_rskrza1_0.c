@@ -134,6 +134,11 @@ static const st_devlink_table_t st_device_link_tbl[] =
         "HID Mouse Device Driver",
     },
 
+    {   /* USB Audio Class speakers, headsets and DACs */
+        "USB Audio",
+        "USB Audio Device Driver",
+    },
+
     {   /* Class support for USB CDC ACM Class */
         "USBCDC",
         "CDC Device Driver",
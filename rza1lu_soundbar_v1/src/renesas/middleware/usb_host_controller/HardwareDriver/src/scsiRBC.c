@@ -557,6 +557,106 @@ int scsiWrite10 (int iMsDev, int iLun, uint32_t dwLBA, uint16_t wNumBlocks, cons
  End of function  scsiWrite10
  ******************************************************************************/
 
+/******************************************************************************
+ Function Name: scsiSetTransfer10
+ Description:   Function to set the LBA and block count of a READ 10 or WRITE
+                10 command
+ Arguments:     OUT pMsCmd - Pointer to the command
+                IN  iLun - The logical uint number
+                IN  dwLBA - The logical block address
+                IN  wNumBlocks - The number of blocks
+                IN  stLength - The length of the data
+ Return value:  none
+ ******************************************************************************/
+static void scsiSetTransfer10 (PMSCMD pMsCmd, int iLun, uint32_t dwLBA, uint16_t wNumBlocks, size_t stLength)
+{
+    /* Add the Lun into the command */
+    pMsCmd->pbyCB[1] |= (uint8_t) (iLun << 4);
+    /* Set the LBA */
+    pMsCmd->pbyCB[2] = (uint8_t) (dwLBA >> 24);
+    pMsCmd->pbyCB[3] = (uint8_t) (dwLBA >> 16);
+    pMsCmd->pbyCB[4] = (uint8_t) (dwLBA >> 8);
+    pMsCmd->pbyCB[5] = (uint8_t) (dwLBA >> 0);
+    /* Set the number of blocks */
+    pMsCmd->pbyCB[7] = (uint8_t) (wNumBlocks >> 8);
+    pMsCmd->pbyCB[8] = (uint8_t) wNumBlocks;
+    /* Set the length of the data */
+    pMsCmd->stTransferLength = stLength;
+}
+/******************************************************************************
+ End of function  scsiSetTransfer10
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: scsiQueueRead10
+ Description:   Function to queue a read from the media
+ Arguments:     OUT pMsReq - Pointer to the request, in scope until completed
+                IN  iMsDev - The mass storage device file descriptor
+                IN  iLun - The logical uint number
+                IN  dwLBA - The logical block address
+                IN  wNumBlocks - The number of blocks
+                OUT pbyDest - Pointer to the destination memory
+                IN  stDestLength - The length of the destination memory
+                IN  pfnComplete - Function called by the queue task when done
+                IN  pvParameter - Passed in the request to pfnComplete
+ Return value:  0 for success otherwise error code
+ ******************************************************************************/
+int scsiQueueRead10 (PMSREQ pMsReq, int iMsDev, int iLun, uint32_t dwLBA, uint16_t wNumBlocks, uint8_t *pbyDest,
+        size_t stDestLength, PFNMSREQ pfnComplete, void *pvParameter)
+{
+    pMsReq->msCmd = USB_MS_SCSI_READ_10;
+    scsiSetTransfer10(&pMsReq->msCmd, iLun, dwLBA, wNumBlocks, stDestLength);
+    pMsReq->iMsDev = iMsDev;
+    pMsReq->iLun = iLun;
+    pMsReq->pvData = pbyDest;
+    pMsReq->pfnComplete = pfnComplete;
+    pMsReq->pvParameter = pvParameter;
+    if (usbMsQueueCommand(pMsReq))
+    {
+        TRACE(("scsiQueueRead10: Queue error\r\n"));
+        return SCSI_COMMAND_ERROR;
+    }
+    return SCSI_OK;
+}
+/******************************************************************************
+ End of function  scsiQueueRead10
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: scsiQueueWrite10
+ Description:   Function to queue a write to the media
+ Arguments:     OUT pMsReq - Pointer to the request, in scope until completed
+                IN  iMsDev - The mass storage device file descriptor
+                IN  iLun - The logical uint number
+                IN  dwLBA - The logical block address
+                IN  wNumBlocks - The number of blocks
+                IN  pbySrc - Pointer to the source memory
+                IN  stSrcLength - The length of the source memory
+                IN  pfnComplete - Function called by the queue task when done
+                IN  pvParameter - Passed in the request to pfnComplete
+ Return value:  0 for success otherwise error code
+ ******************************************************************************/
+int scsiQueueWrite10 (PMSREQ pMsReq, int iMsDev, int iLun, uint32_t dwLBA, uint16_t wNumBlocks,
+        const uint8_t *pbySrc, size_t stSrcLength, PFNMSREQ pfnComplete, void *pvParameter)
+{
+    pMsReq->msCmd = USB_MS_WRITE_10;
+    scsiSetTransfer10(&pMsReq->msCmd, iLun, dwLBA, wNumBlocks, stSrcLength);
+    pMsReq->iMsDev = iMsDev;
+    pMsReq->iLun = iLun;
+    pMsReq->pvData = (void *) pbySrc;
+    pMsReq->pfnComplete = pfnComplete;
+    pMsReq->pvParameter = pvParameter;
+    if (usbMsQueueCommand(pMsReq))
+    {
+        TRACE(("scsiQueueWrite10: Queue error\r\n"));
+        return SCSI_COMMAND_ERROR;
+    }
+    return SCSI_OK;
+}
+/******************************************************************************
+ End of function  scsiQueueWrite10
+ ******************************************************************************/
+
 /******************************************************************************
  Function Name: scsiInquire
  Description:   Function to get the Mass Storage device information
@@ -48,6 +48,10 @@
 
 #include "compiler_settings.h"
 #include "r_devlink_wrapper.h"
+#include "r_os_abstraction_api.h"
+#include "r_task_priority.h"
+#include "iodefine_cfg.h"
+#include "FreeRTOS.h"
 #include "control.h"
 #include "usbMSBulkOnly.h"
 #include "endian.h"
@@ -63,6 +67,10 @@
 #define USB_MS_CSW_SIGNATURE        (uint32_t)(('U') | (('S') << 8) | \
                                            (('B') << 16) | (('S') << 24))
 
+/* Free running OSTM1 counter used to time each command */
+#define USB_MS_TIME_STAMP()         (OSTM1.OSTMnCNT)
+#define USB_MS_COUNTS_PER_US        (configPERIPHERAL_CLOCK0_HZ / 1000000UL)
+
 /* Comment this line out to turn ON module trace in this file */
 #undef _TRACE_ON_
 
@@ -133,10 +141,24 @@ typedef union _CSW
  Function Prototypes
  ******************************************************************************/
 
-static UMSERR usbMsPutGet (int iMsDev, int iLun, PMSCMD pMsCmd, void *pvData, size_t *pstLenTrans);
+static UMSERR usbMsPutGet (int iMsDev, PMSCMD pMsCmd, PCBW pCBW, void *pvData, size_t *pstLenTrans);
 static UMSERR usbMsGetErrorCode (int iDriverErrorCode);
-static UMSERR usbMsSendCBW (int iMsDev, int iLun, PMSCMD pMsCmd, PCBW pCBW);
-static UMSERR usbMsReceiveCSW (int iMsDev, PCSW pCSW);
+static void usbMsMakeCBW (int iLun, PMSCMD pMsCmd, PCBW pCBW);
+static UMSERR usbMsSendCBW (int iMsDev, PMSCMD pMsCmd, PCBW pCBW);
+static UMSERR usbMsReceiveCSW (int iMsDev, PCSW pCSW, uint32_t dwCSWTag, _Bool bfStarted);
+static void usbMsRecordCommand (PMSCMD pMsCmd, UMSERR iResult, size_t stLength, uint32_t dwTime_uS, _Bool bfQueued);
+static _Bool usbMsStartQueue (void);
+static void usbMsQueueTask (void *pvParameter);
+
+/******************************************************************************
+ Private global variables
+ ******************************************************************************/
+
+/* The transport counters */
+static MSSTATS gMsStats;
+
+/* The requests waiting for the queue task */
+static os_msg_queue_handle_t gpMsQueue = NULL;
 
 /******************************************************************************
  Exported global variables and functions (to be accessed by other files)
@@ -197,6 +219,11 @@ UMSERR usbMsClassGetMaxLun (int iMsDev, uint8_t *pbyMaxLun)
 UMSERR usbMsCommand (int iMsDev, int iLun, PMSCMD pMsCmd, void *pvData, size_t *pstLenTrans)
 {
     UMSERR iErrorCode;
+    CBW cmdBlkWpr;
+    size_t stLength = 0UL;
+    uint32_t dwStart;
+
+    usbMsMakeCBW(iLun, pMsCmd, &cmdBlkWpr);
 
     /* The driver has a bug with multiple MS commands because the pipe can
      be re-assigned when the CSW is stuck in the FIFO */
@@ -208,7 +235,14 @@ UMSERR usbMsCommand (int iMsDev, int iLun, PMSCMD pMsCmd, void *pvData, size_t *
      exclusive access must be provided */
     control(iMsDev, CTL_USB_MS_WAIT_MUTEX, NULL);
 #endif
-    iErrorCode = usbMsPutGet(iMsDev, iLun, pMsCmd, pvData, pstLenTrans);
+    dwStart = USB_MS_TIME_STAMP();
+    iErrorCode = usbMsPutGet(iMsDev, pMsCmd, &cmdBlkWpr, pvData, &stLength);
+    usbMsRecordCommand(pMsCmd, iErrorCode, stLength,
+                       (USB_MS_TIME_STAMP() - dwStart) / USB_MS_COUNTS_PER_US, false);
+    if (pstLenTrans)
+    {
+        *pstLenTrans = stLength;
+    }
 #ifndef _MULTIPLE_MS_ACCESS_
     R_OS_EventReleaseMutex(&ms_command_mutex);
 #else
@@ -220,39 +254,121 @@ UMSERR usbMsCommand (int iMsDev, int iLun, PMSCMD pMsCmd, void *pvData, size_t *
  End of function  usbMsCommand
  ******************************************************************************/
 
+/******************************************************************************
+ Function Name: usbMsQueueCommand
+ Description:   Function to queue a USB MS Bulk Only command. The commands are
+                transported in order by the queue task, which calls the
+                completion function of each. There is no retry on error
+ Arguments:     IN  pMsReq - Pointer to the request, the caller sets iMsDev,
+                             iLun, msCmd, pvData and pfnComplete
+ Return value:  0 if the request was queued or error code
+ ******************************************************************************/
+UMSERR usbMsQueueCommand (PMSREQ pMsReq)
+{
+    if ((!pMsReq->pfnComplete) || (!usbMsStartQueue()))
+    {
+        return USB_MS_DRIVER_ERROR;
+    }
+
+    pMsReq->iResult = USB_MS_OK;
+    pMsReq->stLengthTransferred = 0UL;
+    pMsReq->dwTime_uS = 0UL;
+
+    /* Make the CBW now, the queue task only has to send it */
+    usbMsMakeCBW(pMsReq->iLun, &pMsReq->msCmd, (PCBW) pMsReq->pbyCBW);
+
+    if (!R_OS_PutMessageQueue(gpMsQueue, (os_msg_t) pMsReq))
+    {
+        return USB_MS_QUEUE_FULL;
+    }
+    return USB_MS_OK;
+}
+/******************************************************************************
+ End of function  usbMsQueueCommand
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbMsGetStats
+ Description:   Function to read the transport counters
+ Arguments:     OUT pMsStats - Pointer to the destination
+ Return value:  none
+ ******************************************************************************/
+void usbMsGetStats (PMSSTATS pMsStats)
+{
+    int_t iUnlock = R_OS_SysLock(NULL);
+    *pMsStats = gMsStats;
+    R_OS_SysUnlock(NULL, iUnlock);
+}
+/******************************************************************************
+ End of function  usbMsGetStats
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbMsResetStats
+ Description:   Function to clear the transport counters
+ Arguments:     none
+ Return value:  none
+ ******************************************************************************/
+void usbMsResetStats (void)
+{
+    int_t iUnlock = R_OS_SysLock(NULL);
+    memset(&gMsStats, 0, sizeof(MSSTATS));
+    R_OS_SysUnlock(NULL, iUnlock);
+}
+/******************************************************************************
+ End of function  usbMsResetStats
+ ******************************************************************************/
+
 /******************************************************************************
  Private Functions
  ******************************************************************************/
 
 /******************************************************************************
  Function Name: usbMsPutGet
- Description:   Function to transport a USB MS Bulk Only command as per section 5
+ Description:   Function to transport a USB MS Bulk Only command as per section
+                5. The phases are overlapped where the protocol allows, the
+                data IN transfer is started with the CBW and the CSW transfer
+                with the data OUT so the device never waits for the host to
+                ask for the next phase
  Arguments:     IN  iMsDev - The mass storage device file descriptor
- IN  iLun - The logical uint number
- IN  pMsCmd - Pointer to the command to send
- OUT pvData - Pointer to the source or destination data
- OUT pstLenTrans - Pointer to the length of data transferred
+                IN  pMsCmd - Pointer to the command to send
+                IN  pCBW - Pointer to the command block wrapper to send
+                OUT pvData - Pointer to the source or destination data
+                OUT pstLenTrans - Pointer to the length of data transferred
  Return value:  0 for success or error code
  ******************************************************************************/
-static UMSERR usbMsPutGet (int iMsDev, int iLun, PMSCMD pMsCmd, void *pvData, size_t *pstLenTrans)
+static UMSERR usbMsPutGet (int iMsDev, PMSCMD pMsCmd, PCBW pCBW, void *pvData, size_t *pstLenTrans)
 {
-    CBW cmdBlkWpr;
     CSW cmdStsWpr;
+    OLD overlapped;
     UMSERR iErrorCode = USB_MS_OK;
     size_t stLengthTransferred = 0UL;
+    _Bool bfDataIn = (pMsCmd->stTransferLength) && (pMsCmd->transferDirection == USB_MS_DIRECTION_IN);
+    _Bool bfStatusStarted = false;
 
     /* Set the time-out for the command */
     control(iMsDev, CTL_SET_TIME_OUT, &pMsCmd->dwTimeOut);
 
+    if (bfDataIn)
+    {
+        /* Start reading the data before the command goes out */
+        control(iMsDev, CTL_SET_OVERLAPPED_READ_EVENT, NULL);
+        if (read(iMsDev, pvData, (uint32_t) pMsCmd->stTransferLength) != 0)
+        {
+            TRACE(("usbMsPutGet: Failed to start the data phase\r\n"));
+            return USB_MS_DRIVER_ERROR;
+        }
+    }
+
     /* Write the CBW to the device */
-    iErrorCode = usbMsSendCBW(iMsDev, iLun, pMsCmd, &cmdBlkWpr);
+    iErrorCode = usbMsSendCBW(iMsDev, pMsCmd, pCBW);
     if (iErrorCode)
     {
         TRACE(("usbMsPutGet: Failed to send CBW %d\r\n", iErrorCode));
+        control(iMsDev, CTL_CANCEL_OVERLAPPED_READ, NULL);
         /* Section 6.6.1 */
         control(iMsDev, CTL_USB_MS_RESET, NULL);
-        ;
-        return usbMsGetErrorCode(iErrorCode);
+        return iErrorCode;
     }
     else
     {
@@ -262,25 +378,40 @@ static UMSERR usbMsPutGet (int iMsDev, int iLun, PMSCMD pMsCmd, void *pvData, si
     if (pMsCmd->stTransferLength)
     {
         UMSERR iDataPhaseError = USB_MS_OK;
-        if (pMsCmd->transferDirection == USB_MS_DIRECTION_IN)
+
+        /* Left as is if there was no transfer to collect */
+        overlapped.iResult = BULK_EP_REQUEST_ERROR;
+        overlapped.stLength = 0UL;
+        if (bfDataIn)
         {
-            stLengthTransferred = (size_t) read(iMsDev, pvData, (uint32_t) pMsCmd->stTransferLength);
-            TRACE(("usbMsPutGet: Read %d\r\n", stLengthTransferred));
+            control(iMsDev, CTL_GET_OVERLAPPED_READ_RESULT, &overlapped);
+            TRACE(("usbMsPutGet: Read %d\r\n", overlapped.stLength));
         }
         else
         {
-            stLengthTransferred = (size_t) write(iMsDev, pvData, (uint32_t) pMsCmd->stTransferLength);
-            XTRACE(("usbMsPutGet: Write %lu\r\n", stLengthTransferred));
+            /* Start the data then the status, the device sends the CSW as
+               soon as it has taken the data */
+            control(iMsDev, CTL_SET_OVERLAPPED_WRITE_EVENT, NULL);
+            write(iMsDev, pvData, (uint32_t) pMsCmd->stTransferLength);
+            control(iMsDev, CTL_SET_OVERLAPPED_READ_EVENT, NULL);
+            bfStatusStarted = (read(iMsDev, cmdStsWpr.Byte, sizeof(CSW)) == 0);
+            control(iMsDev, CTL_GET_OVERLAPPED_WRITE_RESULT, &overlapped);
+            XTRACE(("usbMsPutGet: Write %lu\r\n", overlapped.stLength));
         }
+        iDataPhaseError = (UMSERR) overlapped.iResult;
+        stLengthTransferred = overlapped.stLength;
         if (pstLenTrans)
         {
             *pstLenTrans = stLengthTransferred;
         }
 
-        /* Get the error code from the data transfer */
-        control(iMsDev, CTL_GET_LAST_ERROR, &iDataPhaseError);
-        if (stLengthTransferred == -1u)
+        if (iDataPhaseError)
         {
+            if (bfStatusStarted)
+            {
+                control(iMsDev, CTL_CANCEL_OVERLAPPED_READ, NULL);
+            }
+
             /* If the command is not supported by the device it may stall
              the IN endpoint */
             if ((int)iDataPhaseError == (int)BULK_EP_STALL_ERROR)
@@ -293,15 +424,13 @@ static UMSERR usbMsPutGet (int iMsDev, int iLun, PMSCMD pMsCmd, void *pvData, si
             else
             {
                 control(iMsDev, CTL_USB_MS_RESET, NULL);
-                ;
                 return usbMsGetErrorCode(iDataPhaseError);
             }
         }
     } XTRACE(("usbMsPutGet: Try to receive CSW\r\n"));
 
     /* Get the status of the command */
-    cmdStsWpr.Field.dCSWTag = cmdBlkWpr.Field.dCBWTag;
-    iErrorCode = usbMsReceiveCSW(iMsDev, &cmdStsWpr);
+    iErrorCode = usbMsReceiveCSW(iMsDev, &cmdStsWpr, pCBW->Field.dCBWTag, bfStatusStarted);
     if (iErrorCode)
     {
         TRACE(("usbMsPutGet: Failed to get CSW\r\n"));
@@ -333,6 +462,136 @@ static UMSERR usbMsPutGet (int iMsDev, int iLun, PMSCMD pMsCmd, void *pvData, si
  End of function  usbMsPutGet
  ******************************************************************************/
 
+/******************************************************************************
+ Function Name: usbMsStartQueue
+ Description:   Function to create the request queue and its task the first
+                time a command is queued
+ Arguments:     none
+ Return value:  true if the queue is running
+ ******************************************************************************/
+static _Bool usbMsStartQueue (void)
+{
+    /* 0 = not started, 1 = starting, 2 = running */
+    static volatile int iState = 0;
+    _Bool bfStart = false;
+    int_t iUnlock;
+
+    iUnlock = R_OS_SysLock(NULL);
+    if (0 == iState)
+    {
+        iState = 1;
+        bfStart = true;
+    }
+    R_OS_SysUnlock(NULL, iUnlock);
+
+    if (bfStart)
+    {
+        if ((R_OS_CreateMessageQueue(USB_MS_QUEUE_DEPTH, &gpMsQueue))
+        &&  (R_OS_CreateTask("USB MS Queue", usbMsQueueTask, NULL,
+                             R_OS_ABSTRACTION_PRV_DEFAULT_STACK_SIZE, TASK_USB_MS_QUEUE_PRI)))
+        {
+            iState = 2;
+        }
+        else
+        {
+            R_OS_DeleteMessageQueue(&gpMsQueue);
+            iState = 0;
+        }
+    }
+
+    /* Another task is starting it */
+    while (1 == iState)
+    {
+        R_OS_TaskSleep(1);
+    }
+    return (2 == iState);
+}
+/******************************************************************************
+ End of function  usbMsStartQueue
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbMsQueueTask
+ Description:   Task to transport the queued commands in order
+ Arguments:     IN  pvParameter - Not used
+ Return value:  none
+ ******************************************************************************/
+static void usbMsQueueTask (void *pvParameter)
+{
+    (void) pvParameter;
+
+    while (1)
+    {
+        os_msg_t pvMessage = NULL;
+
+        if ((R_OS_GetMessageQueue(gpMsQueue, &pvMessage, R_OS_ABSTRACTION_PRV_EV_WAIT_INFINITE, true))
+        &&  (pvMessage))
+        {
+            PMSREQ pMsReq = (PMSREQ) pvMessage;
+            uint32_t dwStart;
+
+            control(pMsReq->iMsDev, CTL_USB_MS_WAIT_MUTEX, NULL);
+            dwStart = USB_MS_TIME_STAMP();
+            pMsReq->iResult = usbMsPutGet(pMsReq->iMsDev, &pMsReq->msCmd, (PCBW) pMsReq->pbyCBW,
+                                          pMsReq->pvData, &pMsReq->stLengthTransferred);
+            pMsReq->dwTime_uS = (USB_MS_TIME_STAMP() - dwStart) / USB_MS_COUNTS_PER_US;
+            control(pMsReq->iMsDev, CTL_USB_MS_RELEASE_MUTEX, NULL);
+
+            usbMsRecordCommand(&pMsReq->msCmd, pMsReq->iResult, pMsReq->stLengthTransferred,
+                               pMsReq->dwTime_uS, true);
+            pMsReq->pfnComplete(pMsReq);
+        }
+    }
+}
+/******************************************************************************
+ End of function  usbMsQueueTask
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbMsRecordCommand
+ Description:   Function to add a command to the transport counters
+ Arguments:     IN  pMsCmd - Pointer to the command
+                IN  iResult - The result of the command
+                IN  stLength - The length of data transferred
+                IN  dwTime_uS - The time the command took
+                IN  bfQueued - true if the command was queued
+ Return value:  none
+ ******************************************************************************/
+static void usbMsRecordCommand (PMSCMD pMsCmd, UMSERR iResult, size_t stLength, uint32_t dwTime_uS, _Bool bfQueued)
+{
+    int iBin = 0;
+    int_t iUnlock;
+
+    (void) pMsCmd;
+
+    while ((iBin < (USB_MS_LATENCY_BINS - 1)) && (dwTime_uS >= (1UL << (iBin + USB_MS_LATENCY_FIRST_BIN))))
+    {
+        iBin++;
+    }
+
+    iUnlock = R_OS_SysLock(NULL);
+    gMsStats.dwCommands++;
+    if (iResult)
+    {
+        gMsStats.dwErrors++;
+    }
+    if (bfQueued)
+    {
+        gMsStats.dwQueued++;
+    }
+    gMsStats.ullBytes += stLength;
+    gMsStats.ullTotal_uS += dwTime_uS;
+    if (dwTime_uS > gMsStats.dwMax_uS)
+    {
+        gMsStats.dwMax_uS = dwTime_uS;
+    }
+    gMsStats.pdwLatency[iBin]++;
+    R_OS_SysUnlock(NULL, iUnlock);
+}
+/******************************************************************************
+ End of function  usbMsRecordCommand
+ ******************************************************************************/
+
 /******************************************************************************
  Private global variables and functions
  ******************************************************************************/
@@ -369,25 +628,31 @@ static UMSERR usbMsGetErrorCode (int iDriverErrorCode)
  ******************************************************************************/
 
 /******************************************************************************
- Function Name: usbMsSendCBW
- Description:   Function to send the USB MS Command Block Wrapper
- Arguments:     IN  iMsDev - The mass storage device file descriptor
- IN  iLun - The logical Unit Number
- IN  pMsCmd - Pointer to the command to send
- OUT pCBW - Pointer to the command block wrapper
- Return value:  0 for success or error code
+ Function Name: usbMsMakeCBW
+ Description:   Function to make the USB MS Command Block Wrapper
+ Arguments:     IN  iLun - The logical Unit Number
+                IN  pMsCmd - Pointer to the command to send
+                OUT pCBW - Pointer to the command block wrapper
+ Return value:  none
  ******************************************************************************/
-static UMSERR usbMsSendCBW (int iMsDev, int iLun, PMSCMD pMsCmd, PCBW pCBW)
+static void usbMsMakeCBW (int iLun, PMSCMD pMsCmd, PCBW pCBW)
 {
     static uint32_t dwCBWTag = 1;
-    size_t stLengthWritten;
+    int_t iUnlock;
 
     /* Initialise the command block wrapper */
     memset(pCBW, 0, sizeof(CBW));
 
     /* Fill out the command block wrapper structure */
     pCBW->Field.dCBWSignature = SWAP_ENDIAN_LONG(USB_MS_CBW_SIGNATURE);
+
+    /* Commands are made by the callers and the queue task */
+    iUnlock = R_OS_SysLock(NULL);
     SWAP_ENDIAN_LONG_AT(&pCBW->Field.dCBWTag, &dwCBWTag);
+    /* Bump the tag for the next packet */
+    dwCBWTag++;
+    R_OS_SysUnlock(NULL, iUnlock);
+
     SWAP_ENDIAN_LONG_AT(&pCBW->Field.dCBWDataTransferLength, &pMsCmd->stTransferLength);
 
     if (pMsCmd->transferDirection == USB_MS_DIRECTION_IN)
@@ -401,14 +666,29 @@ static UMSERR usbMsSendCBW (int iMsDev, int iLun, PMSCMD pMsCmd, PCBW pCBW)
     pCBW->Field.bCBWLUN = (uint8_t) (0x0F & iLun);
     pCBW->Field.bCBWCBLength = pMsCmd->byCBLength;
     memcpy(pCBW->Field.pbCBWCB, pMsCmd->pbyCB, (size_t) ((pMsCmd->byCBLength < 16) ? pMsCmd->byCBLength : 16));
+}
+/******************************************************************************
+ End of function  usbMsMakeCBW
+ ******************************************************************************/
 
+/******************************************************************************
+ Function Name: usbMsSendCBW
+ Description:   Function to send the USB MS Command Block Wrapper
+ Arguments:     IN  iMsDev - The mass storage device file descriptor
+                IN  pMsCmd - Pointer to the command to send
+                IN  pCBW - Pointer to the command block wrapper
+ Return value:  0 for success or error code
+ ******************************************************************************/
+static UMSERR usbMsSendCBW (int iMsDev, PMSCMD pMsCmd, PCBW pCBW)
+{
+    size_t stLengthWritten;
+
+    (void) pMsCmd;
     TRACE(("usbMsSendCBW: %s (%d)\r\n", pMsCmd->pszCommandName, pMsCmd->stTransferLength));
 
     /* Write it to the device */
     stLengthWritten = (size_t) write(iMsDev, (uint8_t *) pCBW, sizeof(CBW));
 
-    /* Bump the tag for the next packet */
-    dwCBWTag++;
     if (stLengthWritten == -1U)
     {
         /* Convert the error code */
@@ -461,12 +741,14 @@ static _Bool usbMsValidateCSW (uint32_t *pdwTempPacket, uint32_t dwCSWTag, size_
  Function Name: usbMsReceiveCSW
  Description:   Function to receive the CSW
  Arguments:     IN  iMsDev - The mass storage device file descriptor
- OUT pCSW - pointer to the Command Status Wrapper
+                OUT pCSW - pointer to the Command Status Wrapper
+                IN  dwCSWTag - The tag sent in the CBW
+                IN  bfStarted - true if an overlapped read of the first packet
+                                into pCSW has already been started
  Return value:  0 for success or error code
  ******************************************************************************/
-static UMSERR usbMsReceiveCSW (int iMsDev, PCSW pCSW)
+static UMSERR usbMsReceiveCSW (int iMsDev, PCSW pCSW, uint32_t dwCSWTag, _Bool bfStarted)
 {
-    CSW msCSW;
     size_t stLengthTransferred;
     int iStallCount = 0;
     PBLKERR ErrorCode;
@@ -477,8 +759,19 @@ static UMSERR usbMsReceiveCSW (int iMsDev, PCSW pCSW)
     {
         ErrorCode = 0;
 
-        /* Read one packet at a time until a CSW is found */
-        stLengthTransferred = (size_t) read(iMsDev, (uint8_t *) &msCSW, sizeof(CSW));
+        if (bfStarted)
+        {
+            /* Collect the packet asked for during the data phase */
+            OLD overlapped;
+            bfStarted = false;
+            control(iMsDev, CTL_GET_OVERLAPPED_READ_RESULT, &overlapped);
+            stLengthTransferred = overlapped.stLength;
+        }
+        else
+        {
+            /* Read one packet at a time until a CSW is found */
+            stLengthTransferred = (size_t) read(iMsDev, pCSW->Byte, sizeof(CSW));
+        }
         /* Get the error code */
         control(iMsDev, CTL_GET_LAST_ERROR, &ErrorCode);
         /* Figure 2 states STALL Bulk-In or Bulk Error - so we don't care about
@@ -519,10 +812,7 @@ static UMSERR usbMsReceiveCSW (int iMsDev, PCSW pCSW)
                 control(iMsDev, CTL_USB_MS_CLEAR_BULK_IN_STALL, NULL);
             }
         }
-    } while (!usbMsValidateCSW((uint32_t *) &msCSW, pCSW->Field.dCSWTag, stLengthTransferred));
-
-    /* Copy the data to the destination CSW */
-    *pCSW = msCSW;
+    } while (!usbMsValidateCSW((uint32_t *) pCSW->Byte, dwCSWTag, stLengthTransferred));
 
     return USB_MS_OK;
 }
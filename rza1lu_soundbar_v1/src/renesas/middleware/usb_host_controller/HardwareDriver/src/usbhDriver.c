@@ -303,13 +303,12 @@ static void usbhSheduleIsoc (PUSBHC pUsbHc)
         PUSBTR pRequest = pUsbHc->pIsochronus;
         while (pRequest)
         {
-            /* See if this request needs to be started */
+            /* See if this request needs to be started. The IN and OUT
+               requests use different pipes so a request waiting for its
+               pipe must not hold up one queued behind it */
             if (!pRequest->bfInProgress)
             {
-                if (!usbhStartIsocTransfer(pRequest))
-                {
-                    break;
-                }
+                (void) usbhStartIsocTransfer(pRequest);
             }
             pRequest = pRequest->pNext;
         }
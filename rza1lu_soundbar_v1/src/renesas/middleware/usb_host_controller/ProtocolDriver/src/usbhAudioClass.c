@@ -0,0 +1,1211 @@
+/******************************************************************************
+ * DISCLAIMER
+ * This software is supplied by Renesas Electronics Corporation and is only
+ * intended for use with Renesas products. No other uses are authorized. This
+ * software is owned by Renesas Electronics Corporation and is protected under
+ * all applicable laws, including copyright laws.
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND RENESAS MAKES NO WARRANTIES REGARDING
+ * THIS SOFTWARE, WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING BUT NOT
+ * LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NON-INFRINGEMENT. ALL SUCH WARRANTIES ARE EXPRESSLY DISCLAIMED.
+ * TO THE MAXIMUM EXTENT PERMITTED NOT PROHIBITED BY LAW, NEITHER RENESAS
+ * ELECTRONICS CORPORATION NOR ANY OF ITS AFFILIATED COMPANIES SHALL BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, SPECIAL, INCIDENTAL OR CONSEQUENTIAL DAMAGES FOR
+ * ANY REASON RELATED TO THIS SOFTWARE, EVEN IF RENESAS OR ITS AFFILIATES HAVE
+ * BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
+ * Renesas reserves the right, without notice, to make changes to this software
+ * and to discontinue the availability of this software. By using this software,
+ * you agree to the additional terms and conditions found by accessing the
+ * following link:
+ * http://www.renesas.com/disclaimer
+ *******************************************************************************
+ * Copyright (C) 2012 Renesas Electronics Corporation. All rights reserved.
+ *******************************************************************************
+ * File Name    : usbhAudioClass.c
+ * Version      : 1.00
+ * Device(s)    : Renesas
+ * Tool-Chain   : GNUARM-NONE-EABI v14.02
+ * OS           : None
+ * H/W Platform : RSK+
+ * Description  : USB Audio Class 1 & 2 descriptor parser and isochronous
+ *                packet sizing. Nothing in this file accesses the hardware
+ *                so it can be built and run against recorded descriptors.
+ *******************************************************************************
+ * History      : DD.MM.YYYY Ver. Description
+ *              : 17.10.2018 1.00 First Release
+ ******************************************************************************/
+
+/******************************************************************************
+ WARNING!  IN ACCORDANCE WITH THE USER LICENCE THIS CODE MUST NOT BE CONVEYED
+ OR REDISTRIBUTED IN COMBINATION WITH ANY SOFTWARE LICENSED UNDER TERMS THE
+ SAME AS OR SIMILAR TO THE GNU GENERAL PUBLIC LICENCE
+ ******************************************************************************/
+
+/******************************************************************************
+ Includes   <System Includes> , "Project Includes"
+ ******************************************************************************/
+#include <string.h>
+
+#include "compiler_settings.h"
+#include "usbhEnum.h"
+#include "usbhAudioClass.h"
+#include "trace.h"
+
+/******************************************************************************
+ Macro definitions
+ ******************************************************************************/
+
+/* The audio class code */
+#define USB_AUDIO_CLASS             0x01
+
+/* The terminal type of a USB streaming terminal */
+#define USB_AC_USB_STREAMING        0x0101
+
+/* Feedback more than 1/8th from the nominal rate is rejected */
+#define USB_AC_FEEDBACK_TOLERANCE   3
+
+/* Comment this line out to turn ON module trace in this file */
+#undef _TRACE_ON_
+
+#ifndef _TRACE_ON_
+#undef TRACE
+#define TRACE(x)
+#endif
+
+/******************************************************************************
+ Typedef definitions
+ ******************************************************************************/
+
+/* A terminal, unit or clock entity of the audio function */
+typedef struct
+{
+    uint16_t wTerminalType;
+    uint8_t  byID;
+    uint8_t  bySubtype;
+    /* The first or only source of a unit or output terminal */
+    uint8_t  bySource;
+    /* The clock entity of an Audio Class 2 terminal */
+    uint8_t  byClock;
+    uint8_t  byMuteChannels;
+    uint8_t  byVolumeChannels;
+} ACENTITY, *PACENTITY;
+
+/* The state of the parser */
+typedef struct
+{
+    ACENTITY pEntity[USB_AC_MAX_ENTITIES];
+    int      iNumEntities;
+    uint16_t wADC;
+    /* The current interface */
+    uint8_t  bySubClass;
+    _Bool    bfAudio;
+    /* The alternate setting being parsed */
+    PUSBIF   pAltInterface;
+    ACSTREAM altStream;
+    _Bool    bfAltPCM;
+    _Bool    bfAltFormat;
+    _Bool    bfAltData;
+    _Bool    bfAltRejected;
+    /* The chosen alternate settings */
+    PUSBIF   pOutInterface;
+    PUSBIF   pInInterface;
+    int      iOutScore;
+    int      iInScore;
+} ACPARSE, *PACPARSE;
+
+/******************************************************************************
+ Function Prototypes
+ ******************************************************************************/
+
+static void acParseControl (PACPARSE pParse, const uint8_t *pbyDesc);
+static void acParseStreaming (PACPARSE pParse, const uint8_t *pbyDesc);
+static void acParseEndpoint (PACPARSE pParse, const uint8_t *pbyDesc);
+static void acFinishAlternate (PACPARSE pParse, PASSERVE48 pAudioInfo);
+static int acScoreStream (PACSTREAM pStream);
+static PACENTITY acFindEntity (PACPARSE pParse, uint8_t byID);
+static _Bool acWalkToInput (PACPARSE pParse, uint8_t bySource, uint8_t byInputTerminal, PACENTITY *ppFeature);
+static void acResolveTopology (PACPARSE pParse, PACSTREAM pStream, _Bool bfPlayback);
+static _Bool acCreateEndpoints (PUSBDI pDevice, PUSBIF pInterface, uint8_t *pbyEnd, PACSTREAM pStream);
+static PUSBEI acFindEndpoint (PUSBDI pDevice, uint8_t byAddress);
+static uint16_t acGetWord (const uint8_t *pbySrc);
+static uint32_t acGet3 (const uint8_t *pbySrc);
+static uint32_t acGetLong (const uint8_t *pbySrc);
+static void acAddRate (PACSTREAM pStream, uint32_t dwSampleRate);
+
+/******************************************************************************
+ Exported global variables and functions (to be accessed by other files)
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbhLoadAudioClass
+ Description:   Function to check the configuration descriptor of an audio
+                class device. Without pAudioInfo only the class is checked,
+                this is the case during enumeration when the configuration
+                descriptor may have been truncated.
+ Arguments:     IN  pDevice - Pointer to the device information
+                IN  pbyConfig - Pointer to the whole configuration descriptor
+                IN  bfCreateInterface - true to create the endpoint
+                                        information of the chosen streams
+                OUT ppDeviceDriver - Pointer to the destination driver, may
+                                     be NULL
+                OUT pAudioInfo - Pointer to the audio information, may be
+                                 NULL
+ Return value:  true if the driver will work with the device
+ ******************************************************************************/
+_Bool usbhLoadAudioClass (PUSBDI pDevice, uint8_t *pbyConfig, _Bool bfCreateInterface, PDEVICE *ppDeviceDriver,
+        PASSERVE48 pAudioInfo)
+{
+    ACPARSE parse;
+    uint8_t *pbyDesc = pbyConfig;
+    uint8_t *pbyEnd;
+
+    if (NULL == pAudioInfo)
+    {
+        /* Only the audio control interface identifies the function */
+        if ((pDevice->byInterfaceClass != USB_AUDIO_CLASS)
+                || (pDevice->byInterfaceSubClass != USB_AUDIO_AUDIOCONTR0L))
+        {
+            return false;
+        }
+        TRACE(("usbhLoadAudioClass: Audio Class %s\r\n",
+                        (pDevice->byInterfaceProtocol == USB_AUDIO_IP_VERSION_02_00) ? "2" : "1"));
+        return (ppDeviceDriver) ? acLoadDriver(NULL, ppDeviceDriver) : true;
+    }
+
+    memset(pAudioInfo, 0, sizeof(ASSERVE48));
+    memset( &parse, 0, sizeof(ACPARSE));
+    pAudioInfo->pDevice = pDevice;
+    pbyEnd = pbyConfig + acGetWord(pbyConfig + 2);
+
+    while (((pbyDesc + 2) <= pbyEnd) && (pbyDesc[0] >= 2) && ((pbyDesc + pbyDesc[0]) <= pbyEnd))
+    {
+        switch (pbyDesc[1])
+        {
+            case USB_INTERFACE_DESCRIPTOR_TYPE :
+            {
+                PUSBIF pInterface = (PUSBIF) pbyDesc;
+
+                /* The previous alternate setting is complete */
+                acFinishAlternate( &parse, pAudioInfo);
+                parse.bfAudio = (pInterface->bInterfaceClass == USB_AUDIO_CLASS);
+                parse.bySubClass = pInterface->bInterfaceSubClass;
+                if ((parse.bfAudio) && (parse.bySubClass == USB_AUDIO_AUDIOSTREAMING)
+                        && (pInterface->bNumEndpoints))
+                {
+                    parse.pAltInterface = pInterface;
+                    parse.altStream.byInterface = pInterface->bInterfaceNumber;
+                    parse.altStream.byAlternateSetting = pInterface->bAlternateSetting;
+                }
+                else if ((parse.bfAudio) && (parse.bySubClass == USB_AUDIO_AUDIOCONTR0L) && (0 == parse.wADC))
+                {
+                    pAudioInfo->byControlInterface = pInterface->bInterfaceNumber;
+                }
+                break;
+            }
+            case USB_AUDIO_INTERFACE :
+            {
+                if ((parse.bfAudio) && (parse.bySubClass == USB_AUDIO_AUDIOCONTR0L))
+                {
+                    acParseControl( &parse, pbyDesc);
+                }
+                else if (parse.pAltInterface)
+                {
+                    acParseStreaming( &parse, pbyDesc);
+                }
+                break;
+            }
+            case USB_ENDPOINT_DESCRIPTOR_TYPE :
+            {
+                if (parse.pAltInterface)
+                {
+                    acParseEndpoint( &parse, pbyDesc);
+                }
+                break;
+            }
+            case USB_AUDIO_ENDPOINT :
+            {
+                /* Audio Class 1 endpoint with a sampling frequency control */
+                if ((parse.pAltInterface) && (parse.wADC < USB_AUDIO_ADC_2_0) && (pbyDesc[0] >= 4))
+                {
+                    parse.altStream.bfRateControl = (pbyDesc[3] & BIT_0) ? true : false;
+                }
+                break;
+            }
+            default :
+            break;
+        }
+        pbyDesc += pbyDesc[0];
+    }
+    acFinishAlternate( &parse, pAudioInfo);
+    pAudioInfo->wADC = parse.wADC;
+
+    /* Find the feature unit and clock of each stream */
+    if (pAudioInfo->Out.bfValid)
+    {
+        acResolveTopology( &parse, &pAudioInfo->Out, true);
+    }
+    if (pAudioInfo->In.bfValid)
+    {
+        acResolveTopology( &parse, &pAudioInfo->In, false);
+    }
+
+    if (bfCreateInterface)
+    {
+        if ((pAudioInfo->Out.bfValid)
+                && (!acCreateEndpoints(pDevice, parse.pOutInterface, pbyEnd, &pAudioInfo->Out)))
+        {
+            pAudioInfo->Out.bfValid = false;
+        }
+        if ((pAudioInfo->In.bfValid)
+                && (!acCreateEndpoints(pDevice, parse.pInInterface, pbyEnd, &pAudioInfo->In)))
+        {
+            pAudioInfo->In.bfValid = false;
+        }
+    }
+    TRACE(("usbhLoadAudioClass: ADC %.4X Out %d In %d\r\n", parse.wADC, pAudioInfo->Out.bfValid,
+                    pAudioInfo->In.bfValid));
+
+    if (ppDeviceDriver)
+    {
+        return acLoadDriver(pAudioInfo, ppDeviceDriver);
+    }
+    return ((pAudioInfo->Out.bfValid) || (pAudioInfo->In.bfValid));
+}
+/******************************************************************************
+ End of function  usbhLoadAudioClass
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbhAcParseRange
+ Description:   Function to read the sample rates of an Audio Class 2 clock
+                from the response to a RANGE request
+ Arguments:     OUT pStream - Pointer to the stream to set the rates of
+                IN  pbyRange - Pointer to the RANGE response
+                IN  stLength - The length of the response
+ Return value:  true if at least one rate was found
+ ******************************************************************************/
+_Bool usbhAcParseRange (PACSTREAM pStream, const uint8_t *pbyRange, size_t stLength)
+{
+    /* The rates commonly supported by devices with a stepped range */
+    static const uint32_t pdwCommon[] =
+    { 8000UL, 16000UL, 22050UL, 24000UL, 32000UL, 44100UL, 48000UL, 88200UL, 96000UL, 176400UL, 192000UL };
+    size_t stSubRanges;
+    size_t stIndex;
+
+    pStream->byNumRates = 0;
+    pStream->dwMinRate = 0UL;
+    pStream->dwMaxRate = 0UL;
+    if (stLength < 2)
+    {
+        return false;
+    }
+    stSubRanges = (size_t) acGetWord(pbyRange);
+    if (stSubRanges > ((stLength - 2) / 12))
+    {
+        stSubRanges = (stLength - 2) / 12;
+    }
+    for (stIndex = 0; stIndex < stSubRanges; stIndex++)
+    {
+        const uint8_t *pbySubRange = pbyRange + 2 + (stIndex * 12);
+        uint32_t dwMin = acGetLong(pbySubRange);
+        uint32_t dwMax = acGetLong(pbySubRange + 4);
+        uint32_t dwRes = acGetLong(pbySubRange + 8);
+
+        if (dwMin == dwMax)
+        {
+            acAddRate(pStream, dwMin);
+        }
+        else if (dwRes)
+        {
+            size_t stRate;
+
+            for (stRate = 0; stRate < (sizeof(pdwCommon) / sizeof(uint32_t)); stRate++)
+            {
+                if ((pdwCommon[stRate] >= dwMin) && (pdwCommon[stRate] <= dwMax)
+                        && (0UL == ((pdwCommon[stRate] - dwMin) % dwRes)))
+                {
+                    acAddRate(pStream, pdwCommon[stRate]);
+                }
+            }
+        }
+        else if ((0 == pStream->byNumRates) && (dwMax > dwMin))
+        {
+            /* Continuous */
+            pStream->dwMinRate = dwMin;
+            pStream->dwMaxRate = dwMax;
+        }
+    }
+    return ((pStream->byNumRates) || (pStream->dwMaxRate));
+}
+/******************************************************************************
+ End of function  usbhAcParseRange
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbhAcRateSupported
+ Description:   Function to test whether a stream supports a sample rate
+ Arguments:     IN  pStream - Pointer to the stream
+                IN  dwSampleRate - The rate
+ Return value:  true if the rate is supported
+ ******************************************************************************/
+_Bool usbhAcRateSupported (PACSTREAM pStream, uint32_t dwSampleRate)
+{
+    int iRate;
+
+    if (0 == pStream->byNumRates)
+    {
+        return ((dwSampleRate) && (dwSampleRate >= pStream->dwMinRate) && (dwSampleRate <= pStream->dwMaxRate));
+    }
+    for (iRate = 0; iRate < (int) pStream->byNumRates; iRate++)
+    {
+        if (pStream->pdwSampleRate[iRate] == dwSampleRate)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+/******************************************************************************
+ End of function  usbhAcRateSupported
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbhAcSelectRate
+ Description:   Function to choose a sample rate supported by a stream
+ Arguments:     IN  pStream - Pointer to the stream
+                IN  dwPreferred - The rate wanted
+ Return value:  The preferred rate when supported, otherwise 48kHz, 44.1kHz or
+                the first rate supported. 0 if there are none
+ ******************************************************************************/
+uint32_t usbhAcSelectRate (PACSTREAM pStream, uint32_t dwPreferred)
+{
+    if (usbhAcRateSupported(pStream, dwPreferred))
+    {
+        return dwPreferred;
+    }
+    if (usbhAcRateSupported(pStream, 48000UL))
+    {
+        return 48000UL;
+    }
+    if (usbhAcRateSupported(pStream, 44100UL))
+    {
+        return 44100UL;
+    }
+    if (pStream->byNumRates)
+    {
+        return pStream->pdwSampleRate[0];
+    }
+    return pStream->dwMaxRate;
+}
+/******************************************************************************
+ End of function  usbhAcSelectRate
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbhAcPacketInterval_uS
+ Description:   Function to calculate the time between isochronous packets
+ Arguments:     IN  bfHighSpeed - true for a high speed device
+                IN  byInterval - The endpoint bInterval
+ Return value:  The packet interval in uS
+ ******************************************************************************/
+uint32_t usbhAcPacketInterval_uS (_Bool bfHighSpeed, uint8_t byInterval)
+{
+    /* 2^(bInterval - 1) frames or micro-frames */
+    uint32_t dwShift = (byInterval) ? (uint32_t) (byInterval - 1) : 0UL;
+
+    if (dwShift > 15UL)
+    {
+        dwShift = 15UL;
+    }
+    return ((bfHighSpeed) ? 125UL : 1000UL) << dwShift;
+}
+/******************************************************************************
+ End of function  usbhAcPacketInterval_uS
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbhAcRateInit
+ Description:   Function to initialise the packet sizing of a stream
+ Arguments:     OUT pRate - Pointer to the rate information
+                IN  dwSampleRate - The sample rate
+                IN  bfHighSpeed - true for a high speed device
+                IN  byInterval - The data endpoint bInterval
+                IN  dwMaxSamples - The number of samples that fit in a packet
+ Return value:  none
+ ******************************************************************************/
+void usbhAcRateInit (PACRATE pRate, uint32_t dwSampleRate, _Bool bfHighSpeed, uint8_t byInterval,
+        uint32_t dwMaxSamples)
+{
+    uint32_t dwInterval_uS = usbhAcPacketInterval_uS(bfHighSpeed, byInterval);
+
+    pRate->bfHighSpeed = bfHighSpeed;
+    pRate->dwFramesPerPacket = dwInterval_uS / ((bfHighSpeed) ? 125UL : 1000UL);
+    pRate->dwNominal = (uint32_t) ((((uint64_t) dwSampleRate << 16) * dwInterval_uS) / 1000000ULL);
+    pRate->dwCurrent = pRate->dwNominal;
+    pRate->dwFraction = 0UL;
+    pRate->dwMaxSamples = dwMaxSamples;
+}
+/******************************************************************************
+ End of function  usbhAcRateInit
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbhAcRateFeedback
+ Description:   Function to apply a value read from a feedback endpoint. The
+                value is samples per frame, 10.14 in three bytes at full speed
+                and 16.16 in four bytes at high speed. Some full speed devices
+                send 16.16 so both formats are tried against the nominal rate.
+ Arguments:     IN/OUT pRate - Pointer to the rate information
+                IN  pbyFeedback - Pointer to the feedback packet
+                IN  stLength - The length of the feedback packet
+ Return value:  true if the value was used
+ ******************************************************************************/
+_Bool usbhAcRateFeedback (PACRATE pRate, const uint8_t *pbyFeedback, size_t stLength)
+{
+    uint32_t pdwCandidate[2];
+    uint32_t dwValue;
+    uint32_t dwTolerance = pRate->dwNominal >> USB_AC_FEEDBACK_TOLERANCE;
+    int iCandidate;
+
+    if (stLength < 3)
+    {
+        return false;
+    }
+    dwValue = (stLength >= 4) ? acGetLong(pbyFeedback) : acGet3(pbyFeedback);
+
+    /* The format the specification requires first */
+    if ((stLength >= 4) && (pRate->bfHighSpeed))
+    {
+        pdwCandidate[0] = dwValue;
+        pdwCandidate[1] = dwValue << 2;
+    }
+    else
+    {
+        pdwCandidate[0] = (dwValue & 0x00FFFFFFUL) << 2;
+        pdwCandidate[1] = dwValue;
+    }
+
+    for (iCandidate = 0; iCandidate < 2; iCandidate++)
+    {
+        uint32_t dwPerPacket = pdwCandidate[iCandidate] * pRate->dwFramesPerPacket;
+
+        if ((dwPerPacket >= (pRate->dwNominal - dwTolerance)) && (dwPerPacket <= (pRate->dwNominal + dwTolerance)))
+        {
+            pRate->dwCurrent = dwPerPacket;
+            return true;
+        }
+    }
+    return false;
+}
+/******************************************************************************
+ End of function  usbhAcRateFeedback
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbhAcRateImplicit
+ Description:   Function to follow the rate of the capture stream of a device
+                that uses implicit feedback. The capture packet sizes are
+                averaged over about 64 packets.
+ Arguments:     IN/OUT pRate - Pointer to the playback rate information
+                IN  dwSamples - The number of samples in a captured packet
+ Return value:  none
+ ******************************************************************************/
+void usbhAcRateImplicit (PACRATE pRate, uint32_t dwSamples)
+{
+    uint32_t dwTolerance = pRate->dwNominal >> USB_AC_FEEDBACK_TOLERANCE;
+    int32_t iError = (int32_t) ((dwSamples << 16) - pRate->dwCurrent);
+    uint32_t dwCurrent = (uint32_t) ((int32_t) pRate->dwCurrent + (iError / 64));
+
+    if ((dwCurrent >= (pRate->dwNominal - dwTolerance)) && (dwCurrent <= (pRate->dwNominal + dwTolerance)))
+    {
+        pRate->dwCurrent = dwCurrent;
+    }
+}
+/******************************************************************************
+ End of function  usbhAcRateImplicit
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: usbhAcRateNextPacket
+ Description:   Function to get the number of samples for the next packet,
+                the fraction left over is carried to the following packet
+ Arguments:     IN/OUT pRate - Pointer to the rate information
+ Return value:  The number of samples
+ ******************************************************************************/
+uint32_t usbhAcRateNextPacket (PACRATE pRate)
+{
+    uint32_t dwSamples;
+
+    pRate->dwFraction += pRate->dwCurrent;
+    dwSamples = pRate->dwFraction >> 16;
+    pRate->dwFraction &= 0xFFFFUL;
+    if (dwSamples > pRate->dwMaxSamples)
+    {
+        dwSamples = pRate->dwMaxSamples;
+    }
+    return dwSamples;
+}
+/******************************************************************************
+ End of function  usbhAcRateNextPacket
+ ******************************************************************************/
+
+/******************************************************************************
+ Private global variables and functions
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acParseControl
+ Description:   Function to parse a class specific audio control descriptor
+ Arguments:     IN/OUT pParse - Pointer to the parser state
+                IN  pbyDesc - Pointer to the descriptor
+ Return value:  none
+ ******************************************************************************/
+static void acParseControl (PACPARSE pParse, const uint8_t *pbyDesc)
+{
+    uint8_t byLength = pbyDesc[0];
+    uint8_t bySubtype = pbyDesc[2];
+    _Bool bfVersion2 = (pParse->wADC >= USB_AUDIO_ADC_2_0);
+    PACENTITY pEntity;
+
+    if (USB_AUDIO_HEADER == bySubtype)
+    {
+        if (byLength >= 5)
+        {
+            pParse->wADC = acGetWord(pbyDesc + 3);
+        }
+        return;
+    }
+    if ((byLength < 5) || (pParse->iNumEntities >= USB_AC_MAX_ENTITIES))
+    {
+        return;
+    }
+
+    pEntity = &pParse->pEntity[pParse->iNumEntities];
+    memset(pEntity, 0, sizeof(ACENTITY));
+    pEntity->byID = pbyDesc[3];
+    pEntity->bySubtype = bySubtype;
+
+    switch (bySubtype)
+    {
+        case USB_AUDIO_INPUT_TERMINAL :
+        {
+            pEntity->wTerminalType = acGetWord(pbyDesc + 4);
+            if ((bfVersion2) && (byLength > 7))
+            {
+                pEntity->byClock = pbyDesc[7];
+            }
+            break;
+        }
+        case USB_AUDIO_OUTPUT_TERMINAL :
+        {
+            if (byLength < 8)
+            {
+                return;
+            }
+            pEntity->wTerminalType = acGetWord(pbyDesc + 4);
+            pEntity->bySource = pbyDesc[7];
+            if ((bfVersion2) && (byLength > 8))
+            {
+                pEntity->byClock = pbyDesc[8];
+            }
+            break;
+        }
+        case USB_AUDIO_MIXER_UNIT :
+        case USB_AUDIO_SELECTOR_UNIT :
+        {
+            if (byLength < 6)
+            {
+                return;
+            }
+            pEntity->bySource = pbyDesc[5];
+            break;
+        }
+        case USB_AUDIO_FEATURE_UNIT :
+        {
+            int iChannel;
+            int iControlSize = (bfVersion2) ? 4 : ((byLength > 5) ? (int) pbyDesc[5] : 0);
+            int iFirst = (bfVersion2) ? 5 : 6;
+
+            pEntity->bySource = pbyDesc[4];
+            if (0 == iControlSize)
+            {
+                break;
+            }
+
+            /* The master channel and the first two logical channels */
+            for (iChannel = 0; iChannel < USB_SPK_MAX_CHANNELS; iChannel++)
+            {
+                int iOffset = iFirst + (iChannel * iControlSize);
+
+                if ((iOffset + 1) > (int) byLength)
+                {
+                    break;
+                }
+                if (bfVersion2)
+                {
+                    /* Two bits per control, both set when host programmable */
+                    if ((pbyDesc[iOffset] & 0x03) == 0x03)
+                    {
+                        pEntity->byMuteChannels |= (uint8_t) (1 << iChannel);
+                    }
+                    if ((pbyDesc[iOffset] & 0x0C) == 0x0C)
+                    {
+                        pEntity->byVolumeChannels |= (uint8_t) (1 << iChannel);
+                    }
+                }
+                else
+                {
+                    if (pbyDesc[iOffset] & USB_AUDIO_CTL_BM_MUTE)
+                    {
+                        pEntity->byMuteChannels |= (uint8_t) (1 << iChannel);
+                    }
+                    if (pbyDesc[iOffset] & USB_AUDIO_CTL_BM_VOLUME)
+                    {
+                        pEntity->byVolumeChannels |= (uint8_t) (1 << iChannel);
+                    }
+                }
+            }
+            break;
+        }
+        case USB_AUDIO_PROCESSING_UNIT :
+        {
+            /* Audio Class 2 effect unit or Audio Class 1 processing unit */
+            if (bfVersion2)
+            {
+                if (byLength < 7)
+                {
+                    return;
+                }
+                pEntity->bySource = pbyDesc[6];
+            }
+            else
+            {
+                if (byLength < 8)
+                {
+                    return;
+                }
+                pEntity->bySource = pbyDesc[7];
+            }
+            break;
+        }
+        case USB_AUDIO_EXTENSION_UNIT :
+        case USB_AUDIO2_EXTENSION_UNIT :
+        {
+            if (byLength < 8)
+            {
+                return;
+            }
+            pEntity->bySource = pbyDesc[7];
+            break;
+        }
+        case USB_AUDIO2_CLOCK_SOURCE :
+        break;
+        case USB_AUDIO2_CLOCK_SELECTOR :
+        {
+            if (byLength < 6)
+            {
+                return;
+            }
+            pEntity->bySource = pbyDesc[5];
+            break;
+        }
+        case USB_AUDIO2_CLOCK_MULTIPLIER :
+        {
+            pEntity->bySource = pbyDesc[4];
+            break;
+        }
+        default :
+        return;
+    }
+    pParse->iNumEntities++;
+}
+/******************************************************************************
+ End of function  acParseControl
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acParseStreaming
+ Description:   Function to parse a class specific audio streaming descriptor
+ Arguments:     IN/OUT pParse - Pointer to the parser state
+                IN  pbyDesc - Pointer to the descriptor
+ Return value:  none
+ ******************************************************************************/
+static void acParseStreaming (PACPARSE pParse, const uint8_t *pbyDesc)
+{
+    PACSTREAM pStream = &pParse->altStream;
+    uint8_t byLength = pbyDesc[0];
+    _Bool bfVersion2 = (pParse->wADC >= USB_AUDIO_ADC_2_0);
+
+    switch (pbyDesc[2])
+    {
+        case USB_AUDIO_GENERAL :
+        {
+            if ((bfVersion2) && (byLength >= 11))
+            {
+                pStream->bTerminalLink = pbyDesc[3];
+                pParse->bfAltPCM = ((pbyDesc[5] == USB_AUDIO_FORMAT_TYPE_1) && (pbyDesc[6] & BIT_0));
+                pStream->byNrChannels = pbyDesc[10];
+            }
+            else if ((!bfVersion2) && (byLength >= 7))
+            {
+                pStream->bTerminalLink = pbyDesc[3];
+                pParse->bfAltPCM = (acGetWord(pbyDesc + 5) == USB_AUDIO_FORMAT1_PCM);
+            }
+            break;
+        }
+        case USB_AUDIO_FORMAT_TYPE :
+        {
+            if ((byLength < 6) || (pbyDesc[3] != USB_AUDIO_FORMAT_TYPE_1))
+            {
+                break;
+            }
+            if (bfVersion2)
+            {
+                pStream->bySubslotSize = pbyDesc[4];
+                pStream->byBitResolution = pbyDesc[5];
+                pParse->bfAltFormat = true;
+            }
+            else if (byLength >= 8)
+            {
+                int iRates = (int) pbyDesc[7];
+                int iRate;
+
+                pStream->byNrChannels = pbyDesc[4];
+                pStream->bySubslotSize = pbyDesc[5];
+                pStream->byBitResolution = pbyDesc[6];
+                if ((0 == iRates) && (byLength >= 14))
+                {
+                    /* Continuous range */
+                    pStream->dwMinRate = acGet3(pbyDesc + 8);
+                    pStream->dwMaxRate = acGet3(pbyDesc + 11);
+                }
+                for (iRate = 0; (iRate < iRates) && ((8 + (iRate * 3) + 3) <= (int) byLength); iRate++)
+                {
+                    acAddRate(pStream, acGet3(pbyDesc + 8 + (iRate * 3)));
+                }
+                pParse->bfAltFormat = true;
+            }
+            break;
+        }
+        default :
+        break;
+    }
+}
+/******************************************************************************
+ End of function  acParseStreaming
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acParseEndpoint
+ Description:   Function to parse an endpoint of an audio streaming alternate
+                setting
+ Arguments:     IN/OUT pParse - Pointer to the parser state
+                IN  pbyDesc - Pointer to the descriptor
+ Return value:  none
+ ******************************************************************************/
+static void acParseEndpoint (PACPARSE pParse, const uint8_t *pbyDesc)
+{
+    PACSTREAM pStream = &pParse->altStream;
+    uint8_t byAttributes;
+    uint16_t wMaxPacketSize;
+
+    if (pbyDesc[0] < 7)
+    {
+        return;
+    }
+    byAttributes = pbyDesc[3];
+    wMaxPacketSize = acGetWord(pbyDesc + 4);
+    if ((byAttributes & USB_ENDPOINT_TYPE_MASK) != (uint8_t) USBH_ISOCHRONOUS)
+    {
+        return;
+    }
+
+    if (((byAttributes >> 4) & 0x03) == USB_AC_USAGE_FEEDBACK)
+    {
+        pStream->bySyncAddress = pbyDesc[2];
+        pStream->wSyncPacketSize = (uint16_t) (wMaxPacketSize & 0x07FF);
+
+        /* Audio Class 1 bRefresh or Audio Class 2 bInterval */
+        if ((pParse->wADC < USB_AUDIO_ADC_2_0) && (pbyDesc[0] >= 9))
+        {
+            pStream->bySyncRefresh = pbyDesc[7];
+        }
+        else
+        {
+            pStream->bySyncRefresh = (pbyDesc[6]) ? (uint8_t) (pbyDesc[6] - 1) : 0;
+        }
+    }
+    else if (!pParse->bfAltData)
+    {
+        pParse->bfAltData = true;
+        pStream->byEndpointAddress = pbyDesc[2];
+        pStream->wMaxPacketSize = (uint16_t) (wMaxPacketSize & 0x07FF);
+        pStream->byInterval = pbyDesc[6];
+        pStream->bySyncType = (uint8_t) ((byAttributes >> 2) & 0x03);
+
+        /* More than one transaction per micro-frame is not supported */
+        if (wMaxPacketSize & 0x1800)
+        {
+            pParse->bfAltRejected = true;
+        }
+    }
+}
+/******************************************************************************
+ End of function  acParseEndpoint
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acFinishAlternate
+ Description:   Function to keep the alternate setting just parsed when it is
+                the best found so far for its direction
+ Arguments:     IN/OUT pParse - Pointer to the parser state
+                OUT pAudioInfo - Pointer to the audio information
+ Return value:  none
+ ******************************************************************************/
+static void acFinishAlternate (PACPARSE pParse, PASSERVE48 pAudioInfo)
+{
+    PACSTREAM pStream = &pParse->altStream;
+
+    if ((pParse->pAltInterface) && (pParse->bfAltPCM) && (pParse->bfAltFormat) && (pParse->bfAltData)
+            && (!pParse->bfAltRejected) && (pStream->byNrChannels) && (pStream->bySubslotSize)
+            && (pStream->bySubslotSize <= 4)
+            && (((uint32_t) pStream->byNrChannels * pStream->bySubslotSize) <= pStream->wMaxPacketSize))
+    {
+        int iScore = acScoreStream(pStream);
+
+        pStream->bfValid = true;
+        if (pStream->byEndpointAddress & USB_ENDPOINT_TYPE_TX)
+        {
+            if ((!pAudioInfo->In.bfValid) || (iScore > pParse->iInScore))
+            {
+                pAudioInfo->In = *pStream;
+                pParse->pInInterface = pParse->pAltInterface;
+                pParse->iInScore = iScore;
+            }
+        }
+        else
+        {
+            if ((!pAudioInfo->Out.bfValid) || (iScore > pParse->iOutScore))
+            {
+                pAudioInfo->Out = *pStream;
+                pParse->pOutInterface = pParse->pAltInterface;
+                pParse->iOutScore = iScore;
+            }
+        }
+    }
+
+    pParse->pAltInterface = NULL;
+    pParse->bfAltPCM = false;
+    pParse->bfAltFormat = false;
+    pParse->bfAltData = false;
+    pParse->bfAltRejected = false;
+    memset(pStream, 0, sizeof(ACSTREAM));
+}
+/******************************************************************************
+ End of function  acFinishAlternate
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acScoreStream
+ Description:   Function to rank an alternate setting, stereo 16 bit is
+                preferred because it needs no conversion of CD audio
+ Arguments:     IN  pStream - Pointer to the stream
+ Return value:  The score, higher is better
+ ******************************************************************************/
+static int acScoreStream (PACSTREAM pStream)
+{
+    int iScore = 0;
+
+    if (2 == pStream->byNrChannels)
+    {
+        iScore += 8;
+    }
+    if (16 == pStream->byBitResolution)
+    {
+        iScore += 4;
+    }
+    else if (24 == pStream->byBitResolution)
+    {
+        iScore += 2;
+    }
+    if ((usbhAcRateSupported(pStream, 48000UL)) || (usbhAcRateSupported(pStream, 44100UL)))
+    {
+        iScore += 1;
+    }
+    return iScore;
+}
+/******************************************************************************
+ End of function  acScoreStream
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acFindEntity
+ Description:   Function to find a terminal, unit or clock by ID
+ Arguments:     IN  pParse - Pointer to the parser state
+                IN  byID - The ID
+ Return value:  Pointer to the entity or NULL if not found
+ ******************************************************************************/
+static PACENTITY acFindEntity (PACPARSE pParse, uint8_t byID)
+{
+    int iEntity;
+
+    for (iEntity = 0; iEntity < pParse->iNumEntities; iEntity++)
+    {
+        if (pParse->pEntity[iEntity].byID == byID)
+        {
+            return &pParse->pEntity[iEntity];
+        }
+    }
+    return NULL;
+}
+/******************************************************************************
+ End of function  acFindEntity
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acWalkToInput
+ Description:   Function to follow the first source of each unit back to an
+                input terminal noting the first feature unit on the way
+ Arguments:     IN  pParse - Pointer to the parser state
+                IN  bySource - The ID to start from
+                IN  byInputTerminal - The input terminal to reach, 0 for any
+                OUT ppFeature - Pointer to the feature unit pointer
+ Return value:  true if the walk reached the input terminal
+ ******************************************************************************/
+static _Bool acWalkToInput (PACPARSE pParse, uint8_t bySource, uint8_t byInputTerminal, PACENTITY *ppFeature)
+{
+    int iHops;
+
+    *ppFeature = NULL;
+    for (iHops = 0; iHops < USB_AC_MAX_ENTITIES; iHops++)
+    {
+        PACENTITY pEntity = acFindEntity(pParse, bySource);
+
+        if (NULL == pEntity)
+        {
+            return false;
+        }
+        if (USB_AUDIO_INPUT_TERMINAL == pEntity->bySubtype)
+        {
+            return ((0 == byInputTerminal) || (pEntity->byID == byInputTerminal));
+        }
+        if ((USB_AUDIO_FEATURE_UNIT == pEntity->bySubtype) && (NULL == *ppFeature))
+        {
+            *ppFeature = pEntity;
+        }
+        bySource = pEntity->bySource;
+    }
+    return false;
+}
+/******************************************************************************
+ End of function  acWalkToInput
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acResolveTopology
+ Description:   Function to find the feature unit and clock source of a stream
+ Arguments:     IN  pParse - Pointer to the parser state
+                IN/OUT pStream - Pointer to the stream
+                IN  bfPlayback - true for the playback stream, whose terminal
+                                 link is an input terminal
+ Return value:  none
+ ******************************************************************************/
+static void acResolveTopology (PACPARSE pParse, PACSTREAM pStream, _Bool bfPlayback)
+{
+    PACENTITY pTerminal = acFindEntity(pParse, pStream->bTerminalLink);
+    PACENTITY pFeature = NULL;
+    int iHops;
+
+    if (bfPlayback)
+    {
+        int iEntity;
+
+        /* The output terminal fed from the streaming input terminal */
+        for (iEntity = 0; iEntity < pParse->iNumEntities; iEntity++)
+        {
+            PACENTITY pEntity = &pParse->pEntity[iEntity];
+
+            if ((USB_AUDIO_OUTPUT_TERMINAL == pEntity->bySubtype)
+                    && (pEntity->wTerminalType != USB_AC_USB_STREAMING)
+                    && (acWalkToInput(pParse, pEntity->bySource, pStream->bTerminalLink, &pFeature)))
+            {
+                break;
+            }
+            pFeature = NULL;
+        }
+    }
+    else if (pTerminal)
+    {
+        (void) acWalkToInput(pParse, pTerminal->bySource, 0, &pFeature);
+    }
+
+    if (pFeature)
+    {
+        pStream->byFeatureUnit = pFeature->byID;
+        pStream->byMuteChannels = pFeature->byMuteChannels;
+        pStream->byVolumeChannels = pFeature->byVolumeChannels;
+    }
+
+    /* Follow clock selectors and multipliers to the clock source */
+    if ((pTerminal) && (pTerminal->byClock))
+    {
+        uint8_t byClock = pTerminal->byClock;
+
+        for (iHops = 0; iHops < USB_AC_MAX_ENTITIES; iHops++)
+        {
+            PACENTITY pClock = acFindEntity(pParse, byClock);
+
+            if ((NULL == pClock) || (USB_AUDIO2_CLOCK_SOURCE == pClock->bySubtype))
+            {
+                break;
+            }
+            byClock = pClock->bySource;
+        }
+        pStream->byClockID = byClock;
+    }
+}
+/******************************************************************************
+ End of function  acResolveTopology
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acCreateEndpoints
+ Description:   Function to make sure the endpoints of the chosen alternate
+                setting are in the endpoint list of the device. The list is
+                kept with the device so the sizes are updated when the
+                endpoints already exist.
+ Arguments:     IN  pDevice - Pointer to the device
+                IN  pInterface - Pointer to the alternate setting descriptor
+                IN  pbyEnd - Pointer to the end of the configuration
+                IN/OUT pStream - Pointer to the stream
+ Return value:  true if the data endpoint is available
+ ******************************************************************************/
+static _Bool acCreateEndpoints (PUSBDI pDevice, PUSBIF pInterface, uint8_t *pbyEnd, PACSTREAM pStream)
+{
+    uint8_t *pbyDesc;
+
+    if (NULL == acFindEndpoint(pDevice, pStream->byEndpointAddress))
+    {
+        if (!usbhCreateInterfaceInformation(pDevice, pInterface))
+        {
+            return false;
+        }
+    }
+
+    /* Update the endpoints from this alternate setting */
+    pbyDesc = (uint8_t *) pInterface + pInterface->bLength;
+    while (((pbyDesc + 2) <= pbyEnd) && (pbyDesc[0] >= 2) && (pbyDesc[1] != USB_INTERFACE_DESCRIPTOR_TYPE))
+    {
+        if ((pbyDesc[1] == USB_ENDPOINT_DESCRIPTOR_TYPE) && (pbyDesc[0] >= 7))
+        {
+            PUSBEI pEndpoint = acFindEndpoint(pDevice, pbyDesc[2]);
+
+            if (pEndpoint)
+            {
+                pEndpoint->wPacketSize = (uint16_t) (acGetWord(pbyDesc + 4) & 0x07FF);
+                pEndpoint->byInterval = pbyDesc[6];
+                pEndpoint->transferType = USBH_ISOCHRONOUS;
+            }
+        }
+        pbyDesc += pbyDesc[0];
+    }
+
+    pStream->pDataEndpoint = acFindEndpoint(pDevice, pStream->byEndpointAddress);
+    pStream->pSyncEndpoint = (pStream->bySyncAddress) ? acFindEndpoint(pDevice, pStream->bySyncAddress) : NULL;
+    return (NULL != pStream->pDataEndpoint);
+}
+/******************************************************************************
+ End of function  acCreateEndpoints
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acFindEndpoint
+ Description:   Function to find an endpoint of a device by address
+ Arguments:     IN  pDevice - Pointer to the device
+                IN  byAddress - The endpoint address
+ Return value:  Pointer to the endpoint or NULL if not found
+ ******************************************************************************/
+static PUSBEI acFindEndpoint (PUSBDI pDevice, uint8_t byAddress)
+{
+    PUSBEI pEndpoint = pDevice->pEndpoint;
+    USBDIR transferDirection = (byAddress & USB_ENDPOINT_TYPE_TX) ? USBH_IN : USBH_OUT;
+    uint8_t byNumber = (uint8_t) (byAddress & ~USB_ENDPOINT_TYPE_TX);
+
+    while (pEndpoint)
+    {
+        if ((pEndpoint->byEndpointNumber == byNumber) && (pEndpoint->transferDirection == transferDirection))
+        {
+            return pEndpoint;
+        }
+        pEndpoint = pEndpoint->pNext;
+    }
+    return NULL;
+}
+/******************************************************************************
+ End of function  acFindEndpoint
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acAddRate
+ Description:   Function to add a discrete sample rate to a stream
+ Arguments:     IN/OUT pStream - Pointer to the stream
+                IN  dwSampleRate - The rate
+ Return value:  none
+ ******************************************************************************/
+static void acAddRate (PACSTREAM pStream, uint32_t dwSampleRate)
+{
+    if ((dwSampleRate) && (pStream->byNumRates < USB_AC_MAX_SAMPLE_RATES)
+            && (!usbhAcRateSupported(pStream, dwSampleRate)))
+    {
+        pStream->pdwSampleRate[pStream->byNumRates++] = dwSampleRate;
+    }
+}
+/******************************************************************************
+ End of function  acAddRate
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acGetWord
+ Description:   Function to get a little endian word irrespective of alignment
+ Arguments:     IN  pbySrc - Pointer to the word
+ Return value:  The word
+ ******************************************************************************/
+static uint16_t acGetWord (const uint8_t *pbySrc)
+{
+    return (uint16_t) ((uint16_t) pbySrc[0] | ((uint16_t) pbySrc[1] << 8));
+}
+/******************************************************************************
+ End of function  acGetWord
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acGet3
+ Description:   Function to get a little endian three byte value
+ Arguments:     IN  pbySrc - Pointer to the value
+ Return value:  The value
+ ******************************************************************************/
+static uint32_t acGet3 (const uint8_t *pbySrc)
+{
+    return ((uint32_t) pbySrc[0] | ((uint32_t) pbySrc[1] << 8) | ((uint32_t) pbySrc[2] << 16));
+}
+/******************************************************************************
+ End of function  acGet3
+ ******************************************************************************/
+
+/******************************************************************************
+ Function Name: acGetLong
+ Description:   Function to get a little endian long irrespective of alignment
+ Arguments:     IN  pbySrc - Pointer to the long
+ Return value:  The long
+ ******************************************************************************/
+static uint32_t acGetLong (const uint8_t *pbySrc)
+{
+    return (acGet3(pbySrc) | ((uint32_t) pbySrc[3] << 24));
+}
+/******************************************************************************
+ End of function  acGetLong
+ ******************************************************************************/
+
+/******************************************************************************
+ End  Of File
+ ******************************************************************************/
@@ -361,9 +361,10 @@ static _Bool usbhSelectDeviceDriver (PUSBDI pDevice, uint8_t *pbyConfig, PDEVICE
     {
         case 0x01 :
         {
-            //ASSERVE48 audioInfo;
-            //TODO RC return usbhLoadAudioClass(pDevice, pbyConfig, true, ppDeviceDriver, &audioInfo);
-            break;
+            /* The configuration may have been truncated, so only the class
+               is checked here and the driver parses it again when opened */
+            TRACE(("Device is Audio class\r\n"));
+            return usbhLoadAudioClass(pDevice, pbyConfig, false, ppDeviceDriver, NULL);
         }
         case 0x02 :
         {
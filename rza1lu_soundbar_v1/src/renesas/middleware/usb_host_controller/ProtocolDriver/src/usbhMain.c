@@ -1045,6 +1045,17 @@ _Bool usbhCreateInterfaceInformation (PUSBDI pDevice, PUSBIF pUsbIfDesc)
         }
         while (byNumEndpoints--)
         {
+            /* Class specific descriptors can follow an endpoint (e.g. audio
+               class), skip them to get to the next endpoint */
+            while (pUsbEpDesc->bDescriptorType != USB_ENDPOINT_DESCRIPTOR_TYPE)
+            {
+                if ((!pUsbEpDesc->bLength) || (pUsbEpDesc->bDescriptorType == USB_INTERFACE_DESCRIPTOR_TYPE))
+                {
+                    return true;
+                }
+                pUsbEpDesc = (PUSBEP) ((uint8_t *) pUsbEpDesc + pUsbEpDesc->bLength);
+            }
+
             /* Create the endpoint */
             pEndpoint = usbhCreateEndpointInformation(pUsbEpDesc);
             if (pEndpoint)
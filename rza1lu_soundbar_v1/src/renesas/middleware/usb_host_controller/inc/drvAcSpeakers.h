@@ -27,10 +27,11 @@
 * Tool-Chain   : GNUARM-NONE-EABI v14.02
 * OS           : None
 * H/W Platform : RSK+
-* Description  : Very basic USB audio class speaker driver
+* Description  : USB audio class 1 & 2 speaker and microphone driver
 *******************************************************************************
 * History      : DD.MM.YYYY Version Description
 *              : 05.08.2010 1.00    First Release
+*              : 17.10.2018 1.01    Streaming with feedback and capture
 ******************************************************************************/
 
 /******************************************************************************
@@ -42,12 +43,22 @@
 #ifndef DRVACSPEAKERS_H_INCLUDED
 #define DRVACSPEAKERS_H_INCLUDED
 
+/******************************************************************************
+Includes   <System Includes> , "Project Includes"
+******************************************************************************/
+
+#include "ddusbh.h"
+#include "r_devlink_wrapper.h"
+
 /******************************************************************************
 Macro definitions
 ******************************************************************************/
 
 #define USB_SPK_MAX_CHANNELS            3
 
+/* The number of discrete sample rates kept for each streaming interface */
+#define USB_AC_MAX_SAMPLE_RATES         8
+
 /* Audio streaming input terminal */
 #define USB_AUDIO_AS_IN_TERM        0x0101
 /* A generic speaker output terminal */
@@ -57,51 +68,70 @@ Macro definitions
 /* Audio type descriptor Type 1 */
 #define USB_AUDIO_FORMAT_TYPE_1     0x01
 
+/* Isochronous endpoint synchronisation types (bmAttributes bits 2 & 3) */
+#define USB_AC_SYNC_NONE            0x00
+#define USB_AC_SYNC_ASYNCHRONOUS    0x01
+#define USB_AC_SYNC_ADAPTIVE        0x02
+#define USB_AC_SYNC_SYNCHRONOUS     0x03
+
 /******************************************************************************
 Typedef definitions
 ******************************************************************************/
 
+/* One direction of audio streaming, chosen from the alternate settings of an
+   audio streaming interface */
+typedef struct _ACSTREAM
+{
+    /* Set by the driver from the endpoint list of the device */
+    PUSBEI     pDataEndpoint;
+    PUSBEI     pSyncEndpoint;
+    /* The discrete sample rates, or the range when byNumRates is 0 */
+    uint32_t   pdwSampleRate[USB_AC_MAX_SAMPLE_RATES];
+    uint32_t   dwMinRate;
+    uint32_t   dwMaxRate;
+    uint16_t   wMaxPacketSize;
+    uint16_t   wSyncPacketSize;
+    uint8_t    byInterface;
+    uint8_t    byAlternateSetting;
+    uint8_t    bTerminalLink;
+    uint8_t    byEndpointAddress;
+    uint8_t    byInterval;
+    uint8_t    bySyncType;
+    /* Explicit feedback endpoint address, 0 for none */
+    uint8_t    bySyncAddress;
+    /* Feedback period as 2^n frames */
+    uint8_t    bySyncRefresh;
+    uint8_t    byNrChannels;
+    uint8_t    bySubslotSize;
+    uint8_t    byBitResolution;
+    uint8_t    byNumRates;
+    /* Audio Class 2 clock source which sets the sample rate */
+    uint8_t    byClockID;
+    /* The feature unit in the path and the channels (bit 0 is the master
+       channel) which have mute and volume controls */
+    uint8_t    byFeatureUnit;
+    uint8_t    byMuteChannels;
+    uint8_t    byVolumeChannels;
+    /* Audio Class 1 endpoint has a sampling frequency control */
+    _Bool      bfRateControl;
+    _Bool      bfValid;
+
+} ACSTREAM,
+*PACSTREAM;
+
 typedef struct _ASSERVE48
 {
     /* Pointer to the device information */
-    PUSBDI  pDevice;
-    /* The streaming audio interface */
-    struct
-    {
-        uint8_t bTerminalLink;
-        PUSBEI  pIsocOutEndpoint;
-    } Audio;
-    /* The audio control information */
-    struct
-    {
-        uint8_t    byInterface;
-        struct
-        {
-            uint16_t   wTerminalType;
-            uint16_t   wChannelConfig;
-            uint8_t    bTerminalID;
-            uint8_t    bAssocTerminal;
-        } In;
-        struct
-        {
-            uint16_t   wTerminalType;
-            uint8_t    bTerminalID;
-            uint8_t    bSourceID;
-        } Out;
-        struct
-        {
-            uint8_t    bUnitID;
-            uint8_t    bSourceID;
-            uint16_t   pwChannel[USB_SPK_MAX_CHANNELS];
-        } Feature;
-    } Ctl;
-    /* The HID interface */
-    struct
-    {
-        PUSBEI  pIntInEndpoint;
-        uint8_t byInterface;
-    } Hid;
-    /* The supported sample rate */
+    PUSBDI     pDevice;
+    /* The audio class release, 0x0100 or 0x0200 */
+    uint16_t   wADC;
+    /* The audio control interface */
+    uint8_t    byControlInterface;
+    /* Playback to the device on an isochronous OUT endpoint */
+    ACSTREAM   Out;
+    /* Capture from the device on an isochronous IN endpoint */
+    ACSTREAM   In;
+    /* The sample rate in use */
     uint32_t   dwSampleRate;
 
 } ASSERVE48,
@@ -118,7 +148,8 @@ extern "C" {
 /******************************************************************************
 Function Name: acLoadDriver
 Description:   Function to select and start the desired interface.
-Arguments:     IN  pAudioInfo - Pointer to the audio interface information
+Arguments:     IN  pAudioInfo - Pointer to the audio interface information,
+                                NULL when only the class has been checked
                OUT ppDeviceDriver - Pointer to the destination driver
 Return value:  true if the driver will work with the device
 ******************************************************************************/
@@ -84,6 +84,9 @@ typedef enum _FATT
     
 } FATT;
 
+/* Called when a drive letter is mounted (bfMounted true) or dismounted */
+typedef void (*PDSKCB)(int8_t chDriveLetter, _Bool bfMounted);
+
 /******************************************************************************
 Function Prototypes
 ******************************************************************************/
@@ -120,6 +123,18 @@ extern  void dskStopDiskManager(void);
 */
 extern  int dskMountAllDevices(void);
 
+/**
+ * @brief         Function to be told when drives are mounted and dismounted.
+ *                Drives that are already mounted are reported straight away.
+ *                The callback is made with the disk list locked and must not
+ *                block or call the disk manager.
+ * 
+ * @param[in]     pCallback: The function to call, NULL for none
+ * 
+ * @retval        None. 
+*/
+extern  void dskSetMediaCallback(PDSKCB pCallback);
+
 /**
  * @brief         Function to dismount and close all devices
  * 
@@ -153,6 +153,56 @@ extern  int scsiWrite10(int       iMsDev,
                         size_t    stSrcLength,
                         size_t *  pstLengthWritten);
                 
+/******************************************************************************
+Function Name: scsiQueueRead10
+Description:   Function to queue a read from the media, see usbMsQueueCommand
+Arguments:     OUT pMsReq - Pointer to the request, in scope until completed
+               IN  iMsDev - The mass storage device file descriptor
+               IN  iLun - The logical uint number
+               IN  dwLBA - The logical block address
+               IN  wNumBlocks - The number of blocks
+               OUT pbyDest - Pointer to the destination memory
+               IN  stDestLength - The length of the destination memory
+               IN  pfnComplete - Function called by the queue task when done
+               IN  pvParameter - Passed in the request to pfnComplete
+Return value:  0 for success otherwise error code
+******************************************************************************/
+
+extern  int scsiQueueRead10(PMSREQ    pMsReq,
+                            int       iMsDev,
+                            int       iLun,
+                            uint32_t  dwLBA,
+                            uint16_t  wNumBlocks,
+                            uint8_t * pbyDest,
+                            size_t    stDestLength,
+                            PFNMSREQ  pfnComplete,
+                            void      *pvParameter);
+
+/******************************************************************************
+Function Name: scsiQueueWrite10
+Description:   Function to queue a write to the media, see usbMsQueueCommand
+Arguments:     OUT pMsReq - Pointer to the request, in scope until completed
+               IN  iMsDev - The mass storage device file descriptor
+               IN  iLun - The logical uint number
+               IN  dwLBA - The logical block address
+               IN  wNumBlocks - The number of blocks
+               IN  pbySrc - Pointer to the source memory
+               IN  stSrcLength - The length of the source memory
+               IN  pfnComplete - Function called by the queue task when done
+               IN  pvParameter - Passed in the request to pfnComplete
+Return value:  0 for success otherwise error code
+******************************************************************************/
+
+extern  int scsiQueueWrite10(PMSREQ    pMsReq,
+                             int       iMsDev,
+                             int       iLun,
+                             uint32_t  dwLBA,
+                             uint16_t  wNumBlocks,
+                             const uint8_t * pbySrc,
+                             size_t    stSrcLength,
+                             PFNMSREQ  pfnComplete,
+                             void      *pvParameter);
+
 /******************************************************************************
 Function Name: scsiInquire
 Description:   Function to get the Mass Storage device information
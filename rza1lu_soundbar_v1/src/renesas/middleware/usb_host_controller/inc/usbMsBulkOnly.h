@@ -44,6 +44,18 @@
 #ifndef USBMSBULKONLY_H_INCLUDED
 #define USBMSBULKONLY_H_INCLUDED
 
+/******************************************************************************
+Macro definitions
+******************************************************************************/
+
+/* The number of requests usbMsQueueCommand can hold */
+#define USB_MS_QUEUE_DEPTH          (16)
+
+/* The command latency histogram. Bin n counts the commands that took less
+   than 2^(n + USB_MS_LATENCY_FIRST_BIN) uS, the last bin counts the rest */
+#define USB_MS_LATENCY_BINS         (12)
+#define USB_MS_LATENCY_FIRST_BIN    (6)
+
 /******************************************************************************
 Typedef definitions
 ******************************************************************************/
@@ -63,7 +75,8 @@ typedef enum _UMSERR
     USB_MS_ENDPOINT_STALLED,
     USB_MS_TRANSFER_TIME_OUT,
     USB_MS_DEVICE_REMOVED,
-    USB_MS_DRIVER_ERROR
+    USB_MS_DRIVER_ERROR,
+    USB_MS_QUEUE_FULL
 } UMSERR;
 
 /* The structure of a USB MS Command */
@@ -85,6 +98,55 @@ typedef struct _MSCMD
 } MSCMD,
 *PMSCMD;
 
+struct _MSREQ;
+
+/* Called by the queue task when a queued command has completed */
+typedef void (*PFNMSREQ)(struct _MSREQ *pMsReq);
+
+/* The structure of a queued USB MS Command. It must stay in scope until the
+   completion function has been called */
+typedef struct _MSREQ
+{
+    /* Set by the caller */
+    int         iMsDev;
+    int         iLun;
+    MSCMD       msCmd;
+    void        *pvData;
+    PFNMSREQ    pfnComplete;
+    void        *pvParameter;
+
+    /* Set before the completion function is called */
+    UMSERR      iResult;
+    size_t      stLengthTransferred;
+    /* The time from the CBW to the CSW */
+    uint32_t    dwTime_uS;
+
+    /* The Command Block Wrapper, made when the request is queued so it can
+       go out as soon as the status of the command before it is received */
+    uint8_t     pbyCBW[31];
+
+} MSREQ,
+*PMSREQ;
+
+/* The transport counters */
+typedef struct _MSSTATS
+{
+    /* The number of commands, and of those the number that failed */
+    uint32_t    dwCommands;
+    uint32_t    dwErrors;
+    /* The number of commands that went through the queue */
+    uint32_t    dwQueued;
+    /* The number of data bytes transferred */
+    uint64_t    ullBytes;
+    /* The total and longest command times */
+    uint64_t    ullTotal_uS;
+    uint32_t    dwMax_uS;
+    /* The command latency histogram */
+    uint32_t    pdwLatency[USB_MS_LATENCY_BINS];
+
+} MSSTATS,
+*PMSSTATS;
+
 /******************************************************************************
 Function Prototypes
 ******************************************************************************/
@@ -129,6 +191,36 @@ extern  UMSERR usbMsCommand(int    iMsDev,
                          void   *pvData,
                          size_t *pstLenTrans);
 
+/******************************************************************************
+Function Name: usbMsQueueCommand
+Description:   Function to queue a USB MS Bulk Only command. The commands are
+               transported in order by the queue task, which calls the
+               completion function of each. There is no retry on error
+Arguments:     IN  pMsReq - Pointer to the request, the caller sets iMsDev,
+                            iLun, msCmd, pvData and pfnComplete
+Return value:  0 if the request was queued or error code
+******************************************************************************/
+
+extern  UMSERR usbMsQueueCommand(PMSREQ pMsReq);
+
+/******************************************************************************
+Function Name: usbMsGetStats
+Description:   Function to read the transport counters
+Arguments:     OUT pMsStats - Pointer to the destination
+Return value:  none
+******************************************************************************/
+
+extern  void usbMsGetStats(PMSSTATS pMsStats);
+
+/******************************************************************************
+Function Name: usbMsResetStats
+Description:   Function to clear the transport counters
+Arguments:     none
+Return value:  none
+******************************************************************************/
+
+extern  void usbMsResetStats(void);
+
 #ifdef __cplusplus
 }
 #endif
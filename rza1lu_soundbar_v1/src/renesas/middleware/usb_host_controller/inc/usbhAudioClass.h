@@ -39,12 +39,17 @@
 /**************************************************************************//**
  * @ingroup R_SW_PKG_93_POSIX_MIDDLEWARE
  * @defgroup R_SW_PKG_93_USB_HOST_AUDIO USB Audio Class
- * @brief Very basic USB Audio Class descriptor parser
+ * @brief USB Audio Class 1 & 2 descriptor parser and rate matching
  * 
  * @anchor R_SW_PKG_93_USB_HOST_AUDIO_SUMMARY
  * @par Summary
  * 
  * This module contais the interface for a basic USB Audio Class parser.  
+ * The parser chooses a PCM playback and a PCM capture alternate setting,
+ * follows the topology to their feature units and clock sources, and the
+ * rate functions turn the nominal rate or the device feedback into the
+ * number of samples to send in each isochronous packet. None of these
+ * functions touch the hardware.
  * 
  * @see RENESAS_APPLICATION_SOFTWARE_PACKAGE
  *
@@ -71,6 +76,11 @@ Macro definitions
 
 /* Audio Interface Protocol Codes */
 #define USB_AUDIO_UNDEFINED 0x20
+#define USB_AUDIO_IP_VERSION_02_00  0x20
+
+/* The audio class release numbers in the AC header */
+#define USB_AUDIO_ADC_1_0           0x0100
+#define USB_AUDIO_ADC_2_0           0x0200
 
 /* Audio class specific descriptors */
 #define USB_AUDIO_DESCR_UNDEFINED   0x00
@@ -90,6 +100,14 @@ Macro definitions
 #define USB_AUDIO_PROCESSING_UNIT   0x07
 #define USB_AUDIO_EXTENSION_UNIT    0x08
 
+/* Audio Class 2 only AC Interface Descriptor Subtypes */
+#define USB_AUDIO2_EFFECT_UNIT      0x07
+#define USB_AUDIO2_PROCESSING_UNIT  0x08
+#define USB_AUDIO2_EXTENSION_UNIT   0x09
+#define USB_AUDIO2_CLOCK_SOURCE     0x0A
+#define USB_AUDIO2_CLOCK_SELECTOR   0x0B
+#define USB_AUDIO2_CLOCK_MULTIPLIER 0x0C
+
 /* Audio Class-Specific AS Interface Descriptor Subtypes */
 #define USB_AUDIO_GENERAL           0x01
 #define USB_AUDIO_FORMAT_TYPE       0x02
@@ -176,6 +194,19 @@ Macro definitions
 #define USB_AUDIO_SAMP_FREQ_CTRL    0x01
 #define USB_AUDIO_PITCH_CTRL        0x02
 
+/* Audio Class 2 Request Codes and Clock Source Control Selectors */
+#define USB_AUDIO2_REQUEST_CUR      0x01
+#define USB_AUDIO2_REQUEST_RANGE    0x02
+#define USB_AUDIO2_CS_SAM_FREQ_CTRL 0x01
+
+/* Isochronous endpoint usage types (bmAttributes bits 4 & 5) */
+#define USB_AC_USAGE_DATA           0x00
+#define USB_AC_USAGE_FEEDBACK       0x01
+#define USB_AC_USAGE_IMPLICIT       0x02
+
+/* The number of units and terminals followed by the topology parser */
+#define USB_AC_MAX_ENTITIES         32
+
 /* The control bit map flags */
 #define USB_AUDIO_CTL_BM_MUTE       BIT_0
 #define USB_AUDIO_CTL_BM_VOLUME     BIT_1
@@ -330,6 +361,25 @@ typedef struct
 
 #pragma pack()
 
+/** Isochronous packet sizing for one stream */
+typedef struct _ACRATE
+{
+    /** Samples per packet in 16.16 fixed point at the nominal rate */
+    uint32_t dwNominal;
+    /** Samples per packet in 16.16 fixed point in use */
+    uint32_t dwCurrent;
+    /** The part of a sample carried to the next packet, 16.16 */
+    uint32_t dwFraction;
+    /** (Micro)frames between packets, feedback is per (micro)frame */
+    uint32_t dwFramesPerPacket;
+    /** The number of samples that fit in the endpoint packet size */
+    uint32_t dwMaxSamples;
+    /** High speed feedback is 16.16, full speed 10.14 */
+    _Bool    bfHighSpeed;
+
+} ACRATE,
+*PACRATE;
+
 /******************************************************************************
 Function Prototypes
 ******************************************************************************/
@@ -355,6 +405,87 @@ extern  _Bool usbhLoadAudioClass(PUSBDI     pDevice,
                                  PDEVICE    *ppDeviceDriver,
                                  PASSERVE48 pAudioInfo);
 
+/**
+ * Description:   Function to read the sample rates of an Audio Class 2 clock
+ *                from the response to a RANGE request
+ * @param[out]    pStream:   Pointer to the stream to set the rates of
+ * @param[in]     pbyRange:  Pointer to the RANGE response
+ * @param[in]     stLength:  The length of the response
+ * 
+ * @retval        true: if at least one rate was found
+*/
+extern  _Bool usbhAcParseRange(PACSTREAM pStream, const uint8_t *pbyRange, size_t stLength);
+
+/**
+ * Description:   Function to choose a sample rate supported by a stream
+ * @param[in]     pStream:     Pointer to the stream
+ * @param[in]     dwPreferred: The rate wanted
+ * 
+ * @retval        The preferred rate when supported, otherwise 48kHz, 44.1kHz
+ *                or the first rate supported. 0 if there are none
+*/
+extern  uint32_t usbhAcSelectRate(PACSTREAM pStream, uint32_t dwPreferred);
+
+/**
+ * Description:   Function to test whether a stream supports a sample rate
+ * @param[in]     pStream:      Pointer to the stream
+ * @param[in]     dwSampleRate: The rate
+ * 
+ * @retval        true: if the rate is supported
+*/
+extern  _Bool usbhAcRateSupported(PACSTREAM pStream, uint32_t dwSampleRate);
+
+/**
+ * Description:   Function to calculate the time between isochronous packets
+ * @param[in]     bfHighSpeed: true for a high speed device
+ * @param[in]     byInterval:  The endpoint bInterval
+ * 
+ * @retval        The packet interval in uS
+*/
+extern  uint32_t usbhAcPacketInterval_uS(_Bool bfHighSpeed, uint8_t byInterval);
+
+/**
+ * Description:   Function to initialise the packet sizing of a stream
+ * @param[out]    pRate:        Pointer to the rate information
+ * @param[in]     dwSampleRate: The sample rate
+ * @param[in]     bfHighSpeed:  true for a high speed device
+ * @param[in]     byInterval:   The data endpoint bInterval
+ * @param[in]     dwMaxSamples: The number of samples that fit in a packet
+*/
+extern  void usbhAcRateInit(PACRATE  pRate,
+                            uint32_t dwSampleRate,
+                            _Bool    bfHighSpeed,
+                            uint8_t  byInterval,
+                            uint32_t dwMaxSamples);
+
+/**
+ * Description:   Function to apply a value read from a feedback endpoint.
+ *                Values more than 1/8 from the nominal rate are rejected,
+ *                a full speed device sending 16.16 is accepted
+ * @param[in/out] pRate:       Pointer to the rate information
+ * @param[in]     pbyFeedback: Pointer to the feedback packet
+ * @param[in]     stLength:    The length of the feedback packet
+ * 
+ * @retval        true: if the value was used
+*/
+extern  _Bool usbhAcRateFeedback(PACRATE pRate, const uint8_t *pbyFeedback, size_t stLength);
+
+/**
+ * Description:   Function to follow the rate of the capture stream of a
+ *                device that uses implicit feedback
+ * @param[in/out] pRate:     Pointer to the playback rate information
+ * @param[in]     dwSamples: The number of samples in a captured packet
+*/
+extern  void usbhAcRateImplicit(PACRATE pRate, uint32_t dwSamples);
+
+/**
+ * Description:   Function to get the number of samples for the next packet
+ * @param[in/out] pRate:  Pointer to the rate information
+ * 
+ * @retval        The number of samples
+*/
+extern  uint32_t usbhAcRateNextPacket(PACRATE pRate);
+
 #ifdef __cplusplus
 }
 #endif
@@ -56,8 +56,8 @@ private:
     CGUIProgressBar* m_pkProgressBar;
 
     uint8_t m_working_drive = 'A';
+    uint32_t m_library_generation = 0;
     QueueHandle_t m_media_queue;
-	QueueHandle_t m_qAudioTrackInfo;
 
 
 
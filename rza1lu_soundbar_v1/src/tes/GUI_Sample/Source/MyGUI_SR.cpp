@@ -59,7 +59,9 @@ extern "C"
 #include "r_fatfs_abstraction.h"
 #include "ff.h"
 
-#include <r_soundtest1.h>
+#include <renesas/application/soundbar_app/inc/r_soundbar.h>
+#include "dev_drv.h"
+#include "r_media_library.h"
 }
 
 
@@ -75,8 +77,6 @@ extern "C"
 // LAST INCLUDE!!
 #include "GUIMemLeakWatcher.h"
 
-static FIL *m_pFP;
-
 CMyGUI::CMyGUI(
     eC_Value x, eC_Value y,
     eC_Value width, eC_Value height,
@@ -90,12 +90,10 @@ CMyGUI::CMyGUI(
 	m_pStopButton = static_cast<CGUIButton*>(GETGUI.GetObjectByID(AID_BUTTON_2));
 	m_pkProgressBar = static_cast<CGUIProgressBar*>(GETGUI.GetObjectByID(AID_PROGRESSBAR_1));
 
-		m_qAudioTrackInfo = xQueueCreate(10, sizeof(uint32_t));
-
-		// add callback for polling RTC
+		// add callback for polling RTC and the playback position
 		GETTIMER.AddAnimationCallback(25, this);
 
-		R_SOUND_PlaySample_init(m_qAudioTrackInfo);
+		r_soundtst_PlaySample_init();
 		R_OS_CreateMessageQueue ( 4, &m_media_queue);
 
 
@@ -107,12 +105,6 @@ CMyGUI::CMyGUI(
 		CreateFileList ("*.wav");
 		m_pComboBox->AddSelectionObserver(this);
 	}
-	eC_Char buf[80];
-	eC_String fileName = m_pComboBox->GetSelectedItemStr();
-	fileName.ToASCII(buf);
-
-	m_pFP = R_FAT_OpenFile ( buf, FA_READ );
-	R_SOUND_LoadSample(m_pFP);
 
 }
 
@@ -131,7 +123,30 @@ CMyGUI::~CMyGUI()
 void CMyGUI::CreateFileList ( const eC_Char* pattern ) {
 
 	char full_path[] = "A:\\";
+	st_media_library_status_t status;
+	st_media_track_t track;
+	int32_t index;
+
+	r_media_library_get_status((char_t) m_working_drive, &status);
+	m_library_generation = status.generation;
+
+	// The playlist follows the list, the tracks already open play on
+	r_soundtst_PlaylistClear();
+
+	if ( status.ready ) {
+		// List the playable tracks of the whole drive from the index
+		index = r_media_library_find((char_t) m_working_drive, NULL, MEDIA_LIBRARY_FORMAT_WAV, 0);
 
+		while ( ( index >= 0 ) && ( DEVDRV_SUCCESS == r_media_library_get_track((char_t) m_working_drive, (uint32_t) index, &track) ) ) {
+			CGUIListItem * pListItem = new CGUIListItem(NULL, 0, 0, eC_FromInt(80), eC_FromInt(20), track.path );
+			pListItem->GetLabel()->SetAligned(CGUIText::V_CENTERED);
+			pListItem->GetLabel()->SetTextColor(0xff000000, 0xffffffff, 0xff000000, 0xffffffff);
+			m_pComboBox->AddItem(pListItem);
+			r_soundtst_PlaylistAdd(track.path);
+
+			index = r_media_library_find((char_t) m_working_drive, NULL, MEDIA_LIBRARY_FORMAT_WAV, (uint32_t) index + 1);
+		}
+	} else {
 
 	// Get pointer to FSFAT drive
 	void *pDrive = dskGetDrive(m_working_drive);
@@ -144,6 +159,7 @@ void CMyGUI::CreateFileList ( const eC_Char* pattern ) {
 
 		DIR dir;
 
+	// Not indexed yet, list the root directory until the index is published
 	fatResult = R_FAT_FindFirst( &dir, &fatEntry, full_path, pattern);
 
 		while ( FR_OK == fatResult ) {
@@ -154,10 +170,12 @@ void CMyGUI::CreateFileList ( const eC_Char* pattern ) {
 			pListItem->GetLabel()->SetTextColor(0xff000000, 0xffffffff, 0xff000000, 0xffffffff);
 			// Add it to the ComboBox
 			m_pComboBox->AddItem(pListItem);
+			r_soundtst_PlaylistAdd(fatEntry.FileName);
 
 		/* Get the next one */
 		fatResult = R_FAT_FindNext( &dir, &fatEntry);
 	}
+	}
 
 	// Set some visualization parameters. (e.g. Colors and Images)
 	m_pComboBox->SetItemSelectedColor(0xff0000cc);
@@ -184,13 +202,15 @@ void CMyGUI::OnNotification(const CGUIValue& kObservedValue, const CGUIObject* c
     {
     	//if ( pkUpdatedObject->GETID() == AID_COMBOBOX_1 ) {
 
-		eC_Char buf[80];
-		eC_String fileName = m_pComboBox->GetSelectedItemStr();
-		fileName.ToASCII(buf);
+		st_sound_position_t position;
+		eC_Int selection = m_pComboBox->GetSelection();
+
+		// Jump straight to the selected track if one is playing, otherwise Play starts there
+		r_soundtst_GetPosition(&position);
 
-		R_FAT_CloseFile(m_pFP);
-		m_pFP = R_FAT_OpenFile ( buf, FA_READ );
-		R_SOUND_LoadSample(m_pFP);
+		if ( position.playing && ( selection >= 0 ) && ( (uint32_t) selection != position.track ) ) {
+			r_soundtst_PlaylistPlay((uint32_t) selection, 0);
+		}
     	//}
     }
 }
@@ -199,27 +219,53 @@ void CMyGUI::OnNotification(const CGUIValue& kObservedValue, const CGUIObject* c
 eC_Bool CMyGUI::CallApplicationAPI(const eC_String& kAPI, const eC_String& kParam)
 {
 	if ( "media_play" == kAPI ) {
-		char buf[80];
+		eC_Int selection = m_pComboBox->GetSelection();
 
-		R_SOUND_PlaySample();
+		r_soundtst_PlaylistPlay((selection >= 0) ? (uint32_t) selection : 0, 0);
 
 	} else if ( "media_stop" == kAPI ) {
-		R_SOUND_StopSample();
+		r_soundtst_PlaylistStop();
 	}
     return true;
 }
 
 void CMyGUI::DoAnimate( const eC_Value &vTimers) {
-	uint32_t track;
+	st_sound_position_t position;
+	st_media_library_status_t status;
+
+	// Rebuild the list when the media library publishes a new index
+	r_media_library_get_status((char_t) m_working_drive, &status);
+
+	if ( status.generation != m_library_generation ) {
+		eC_String selected = m_pComboBox->GetSelectedItemStr();
+		eC_Int index;
+
+		// Keep the loaded track, the selection is only restored
+		m_pComboBox->RemoveSelectionObserver(this);
+		m_pComboBox->Reset();
+		CreateFileList("*.wav");
 
-	if ( pdPASS == xQueueReceive ( m_qAudioTrackInfo, &track, 0 )) {
+		index = m_pComboBox->FindItem(selected);
+		m_pComboBox->SetSelection((index >= 0) ? index : 0);
+		m_pComboBox->AddSelectionObserver(this);
+	}
+
+	// Set every 250ms of playback and on a track change, rather than per DMA block
+	if ( r_soundtst_PositionChanged(&position) ) {
 		/* Set the Progress range from 0 -100 */
 		if ( NULL != m_pkProgressBar ) {
 
-			m_pkProgressBar->SetValue(track);
+			m_pkProgressBar->SetValue( ( 0 != position.duration_ms ) ? (uint32_t) ( ( (uint64_t) position.position_ms * 100 ) / position.duration_ms ) : 0 );
 			m_pkProgressBar->InvalidateArea();
 
 		}
+
+		// Follow the playlist onto the next track without jumping to it again
+		if ( position.playing && ( (eC_Int) position.track != m_pComboBox->GetSelection() ) ) {
+			m_pComboBox->RemoveSelectionObserver(this);
+			m_pComboBox->SetSelection((eC_Int) position.track);
+			m_pComboBox->AddSelectionObserver(this);
+		}
 	}
 
 }
@@ -0,0 +1,264 @@
+"""Heap profiler for the R_OS_AllocMem allocation trace.
+
+Reads one or more captures of the trace ring, either the text printed by the
+console command "memtrace dump" or the JSON served as sri_memtrace.json, and
+merges them by sequence number. Overlapping captures taken during a test
+therefore give one unbroken event stream as long as each is read before the
+ring wraps.
+
+From the stream it rebuilds the live heap and reports per task peak usage,
+blocks still allocated at the end grouped by the code that allocated them
+(leak candidates), failed allocations and optionally the growth inside a
+window of ticks, e.g. around a USB hot-plug. --timeline writes the live bytes
+per task after every event as CSV for plotting.
+
+Addresses are printed in hex, look the callers up in the map file or with
+arm-none-eabi-addr2line -f -e <elf> <address>.
+
+    python memtrace.py capture1.txt capture2.txt --since 52000 --until 58000
+    python memtrace.py --url http://192.168.0.3/sri_memtrace.json --timeline heap.csv
+"""
+
+import argparse
+import csv
+import json
+import sys
+import urllib.request
+from collections import defaultdict
+
+EVENT_TYPES = {"a": "alloc", "f": "free", "x": "fail", "t": "task"}
+REGION_HEAP = 0x80
+REGION_NAMES = {0: "large", 1: "uncached"}
+
+
+class Event:
+    def __init__(self, seq, tick, task, kind, region=0, size=0, address=0, caller=0, name=None):
+        self.seq = seq
+        self.tick = tick
+        self.task = task
+        self.kind = kind
+        self.region = region
+        self.size = size
+        self.address = address
+        self.caller = caller
+        self.name = name
+
+
+def parse_text(text, events, tasks):
+    """Console capture, see cmd_mem_trace in command.c"""
+    for line in text.splitlines():
+        fields = line.split()
+        if not fields:
+            continue
+        if fields[0] == "task" and len(fields) >= 3:
+            tasks.setdefault(int(fields[1]), " ".join(fields[2:]))
+            continue
+        if len(fields) < 5 or not fields[0].isdigit() or fields[3] not in EVENT_TYPES:
+            continue
+        seq, tick, task, kind = int(fields[0]), int(fields[1]), int(fields[2]), fields[3]
+        if kind == "t":
+            events[seq] = Event(seq, tick, task, kind, name=" ".join(fields[4:]))
+        elif len(fields) >= 8:
+            events[seq] = Event(seq, tick, task, kind, int(fields[4], 16), int(fields[5]),
+                                int(fields[6], 16), int(fields[7], 16))
+
+
+def parse_json(text, events, tasks):
+    """sri_memtrace.json, see liveGetMemTrace in liveFile.c"""
+    data = json.loads(text)
+    for number, name in data.get("tasks", []):
+        tasks.setdefault(number, name)
+    for entry in data.get("events", []):
+        seq, tick, task, kind = entry[0], entry[1], entry[2], entry[3]
+        if kind == "t":
+            events[seq] = Event(seq, tick, task, kind, name=entry[4])
+        else:
+            events[seq] = Event(seq, tick, task, kind, *entry[4:8])
+
+
+def load(sources, urls):
+    events = {}
+    tasks = {}
+    texts = []
+    for path in sources:
+        with open(path, "r", errors="replace") as f:
+            texts.append(f.read())
+    for url in urls:
+        with urllib.request.urlopen(url) as f:
+            texts.append(f.read().decode("utf-8", "replace"))
+    for text in texts:
+        if text.lstrip().startswith("{"):
+            parse_json(text, events, tasks)
+        else:
+            parse_text(text, events, tasks)
+    ordered = [events[seq] for seq in sorted(events)]
+
+    # Names from the trace itself cover tasks that have since been deleted
+    for event in ordered:
+        if event.kind == "t":
+            tasks[event.task] = event.name
+    return ordered, tasks
+
+
+def task_name(tasks, number):
+    if number == 0:
+        return "<isr/startup>"
+    return "%s(%d)" % (tasks.get(number, "?"), number)
+
+
+def region_name(region):
+    name = REGION_NAMES.get(region & ~REGION_HEAP, str(region & ~REGION_HEAP))
+    return name + ("/heap" if region & REGION_HEAP else "/pool")
+
+
+class Heap:
+    """Live blocks replayed from the events. A free is charged to the task
+    that made the allocation, frees of blocks allocated before the first
+    event are counted but otherwise ignored."""
+
+    def __init__(self):
+        self.blocks = {}
+        self.live = defaultdict(int)
+        self.peak = defaultdict(int)
+        self.peak_tick = {}
+        self.allocs = defaultdict(int)
+        self.frees = defaultdict(int)
+        self.total = 0
+        self.total_peak = 0
+        self.total_peak_tick = 0
+        self.unmatched_frees = 0
+        self.failures = []
+
+    def apply(self, event):
+        if event.kind == "a":
+            old = self.blocks.pop(event.address, None)
+            if old is not None:
+                # Missed the free, the ring wrapped between captures
+                self._release(old)
+            self.blocks[event.address] = event
+            self.live[event.task] += event.size
+            self.total += event.size
+            self.allocs[event.task] += 1
+            if self.live[event.task] > self.peak[event.task]:
+                self.peak[event.task] = self.live[event.task]
+                self.peak_tick[event.task] = event.tick
+            if self.total > self.total_peak:
+                self.total_peak = self.total
+                self.total_peak_tick = event.tick
+        elif event.kind == "f":
+            self.frees[event.task] += 1
+            block = self.blocks.pop(event.address, None)
+            if block is None:
+                self.unmatched_frees += 1
+            else:
+                self._release(block)
+        elif event.kind == "x":
+            self.failures.append(event)
+
+    def _release(self, block):
+        self.live[block.task] -= block.size
+        self.total -= block.size
+
+    def by_site(self, blocks):
+        sites = defaultdict(lambda: [0, 0, None])
+        for block in blocks:
+            site = sites[(block.task, block.caller)]
+            site[0] += 1
+            site[1] += block.size
+            if site[2] is None or block.tick < site[2]:
+                site[2] = block.tick
+        return sites
+
+
+def report(events, tasks, args, out):
+    if not events:
+        out.write("No events\n")
+        return
+
+    gaps = sum(b.seq - a.seq - 1 for a, b in zip(events, events[1:]) if b.seq != a.seq + 1)
+    out.write("Events %d, sequence %d..%d, ticks %d..%d, %d lost between captures\n"
+              % (len(events), events[0].seq, events[-1].seq, events[0].tick, events[-1].tick, gaps))
+
+    heap = Heap()
+    window_start = None
+    window_end = None
+    timeline = None
+    if args.timeline:
+        timeline_file = open(args.timeline, "w", newline="")
+        timeline = csv.writer(timeline_file)
+        numbers = sorted({e.task for e in events if e.kind != "t"})
+        timeline.writerow(["seq", "tick", "total"] + [task_name(tasks, n) for n in numbers])
+
+    for event in events:
+        if args.since is not None and window_start is None and event.tick >= args.since:
+            window_start = (dict(heap.live), dict(heap.blocks))
+        if args.until is not None and window_start is not None and window_end is None and event.tick > args.until:
+            window_end = (dict(heap.live), dict(heap.blocks))
+        heap.apply(event)
+        if timeline and event.kind in ("a", "f"):
+            timeline.writerow([event.seq, event.tick, heap.total] + [heap.live[n] for n in numbers])
+
+    if timeline:
+        timeline_file.close()
+        out.write("Timeline written to %s\n" % args.timeline)
+
+    end_tick = events[-1].tick
+    out.write("\nLive heap now %d bytes in %d blocks, peak %d bytes at tick %d, %d frees of earlier blocks\n"
+              % (heap.total, len(heap.blocks), heap.total_peak, heap.total_peak_tick, heap.unmatched_frees))
+
+    out.write("\n%-28s %8s %8s %10s %10s %10s\n" % ("task", "allocs", "frees", "live", "peak", "peak tick"))
+    for number in sorted(heap.peak, key=lambda n: -heap.peak[n]):
+        out.write("%-28s %8d %8d %10d %10d %10d\n"
+                  % (task_name(tasks, number), heap.allocs[number], heap.frees[number],
+                     heap.live[number], heap.peak[number], heap.peak_tick.get(number, 0)))
+
+    leaks = [b for b in heap.blocks.values() if end_tick - b.tick >= args.min_age]
+    sites = heap.by_site(leaks)
+    out.write("\nLeak candidates, live for at least %d ms\n" % args.min_age)
+    out.write("%-28s %10s %8s %10s %10s\n" % ("task", "caller", "blocks", "bytes", "oldest"))
+    for (number, caller), (count, size, oldest) in sorted(sites.items(), key=lambda s: -s[1][1])[:args.top]:
+        out.write("%-28s 0x%08X %8d %10d %10d\n" % (task_name(tasks, number), caller, count, size, oldest))
+
+    if window_start is not None:
+        start_live, start_blocks = window_start
+        end_live, end_blocks = window_end if window_end is not None else (dict(heap.live), dict(heap.blocks))
+        out.write("\nGrowth from tick %s to %s\n" % (args.since, args.until if args.until is not None else end_tick))
+        for number in sorted(set(start_live) | set(end_live),
+                             key=lambda n: start_live.get(n, 0) - end_live.get(n, 0)):
+            delta = end_live.get(number, 0) - start_live.get(number, 0)
+            if delta:
+                out.write("%-28s %+10d\n" % (task_name(tasks, number), delta))
+        new_blocks = [b for a, b in end_blocks.items() if start_blocks.get(a) is not b]
+        out.write("Blocks allocated in the window and still live at its end\n")
+        for (number, caller), (count, size, oldest) in sorted(heap.by_site(new_blocks).items(),
+                                                              key=lambda s: -s[1][1])[:args.top]:
+            out.write("%-28s 0x%08X %8d %10d\n" % (task_name(tasks, number), caller, count, size))
+
+    if heap.failures:
+        out.write("\nFailed allocations\n")
+        for event in heap.failures[:args.top]:
+            out.write("tick %10d %-28s %8d bytes %-14s caller 0x%08X\n"
+                      % (event.tick, task_name(tasks, event.task), event.size,
+                         region_name(event.region), event.caller))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("captures", nargs="*", help="console dumps or saved sri_memtrace.json files")
+    parser.add_argument("--url", action="append", default=[], help="read sri_memtrace.json from the board")
+    parser.add_argument("--since", type=int, help="start of the window, system tick in ms")
+    parser.add_argument("--until", type=int, help="end of the window, system tick in ms")
+    parser.add_argument("--min-age", type=int, default=1000, help="leak candidates are live at least this long, ms")
+    parser.add_argument("--top", type=int, default=20, help="rows per table")
+    parser.add_argument("--timeline", help="write live bytes per task after every event to this CSV file")
+    args = parser.parse_args()
+
+    if not args.captures and not args.url:
+        parser.error("give at least one capture or --url")
+
+    events, tasks = load(args.captures, args.url)
+    report(events, tasks, args, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()